@@ -0,0 +1,13 @@
+#!/bin/bash
+# Builds the host code and runs the benchmark sweep, extra arguments are
+# passed to compression-bench (e.g. --file_count 1 2 --p2p 1).
+
+source /opt/xilinx/xrt/setup.sh
+source /tools/Xilinx/Vitis/2021.2/settings64.sh
+BENCH_DIR=$(cd "$(dirname "$0")" && pwd)
+mkdir -p ${BENCH_DIR}/../build
+pushd ${BENCH_DIR}/../build
+cmake ..
+make compression-bench
+./bench/compression-bench --xclbin=../compression.xclbin --dir=/mnt/smartssd/bench --baseline=${BENCH_DIR}/baseline.csv "$@"
+popd
@@ -0,0 +1,513 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/**
+ * @file bench.cpp
+ * @brief End-to-end benchmark of the SmartSSD LZ4 pipelines.
+ *
+ * Generates synthetic corpora, sweeps file count, file size, block size,
+ * P2P and decompress compute units, runs every point with warm-up and
+ * repeats, compares against single threaded liblz4 and against a stored
+ * baseline, and writes the results as CSV and JSON.
+ */
+#include <defns.h>
+
+#include <algorithm>
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <SmartSSD.hpp>
+#include <lz4_p2p_comp.hpp>
+#include <lz4_p2p_dec.hpp>
+#include <lz4frame.h>
+#include <map>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include "corpus.hpp"
+
+using namespace std;
+
+struct Options {
+    string xclbin;
+    string dir;
+    vector<string> corpora;
+    vector<uint64_t> fileSizes;
+    vector<uint32_t> fileCounts;
+    vector<uint32_t> blockSizes;
+    vector<uint32_t> p2pModes;
+    vector<uint32_t> decompressCus;
+    bool compress;
+    bool decompress;
+    uint32_t warmup;
+    uint32_t repeats;
+    string csv;
+    string json;
+    string baseline;
+    double tolerance;
+    bool updateBaseline;
+} g_options{};
+
+// One measured point of the sweep
+struct Result {
+    string op;
+    string corpus;
+    uint64_t fileSize;
+    uint32_t fileCount;
+    uint32_t blockKb;
+    uint32_t p2p;
+    uint32_t cu;
+    uint64_t bytes;      // uncompressed bytes over all files
+    double ratio;        // uncompressed / compressed size on disk
+    double wallMsMedian; // open of the first input to close of the last output
+    double wallMsMin;
+    double mbps;       // bytes / median wall time
+    double kernelMbps; // bytes / kernel time of the median run
+    double cpuMbps;    // single thread liblz4 on the same data, in memory
+    bool verified;
+    double baselineMbps;
+    bool regression;
+};
+
+struct Run {
+    double wallNs;
+    double kernelNs;
+};
+
+static string key(const string& op, const string& corpus, uint64_t size, uint32_t count, uint32_t block, uint32_t p2p,
+                  uint32_t cu)
+{
+    return op + "," + corpus + "," + to_string(size) + "," + to_string(count) + "," + to_string(block) + "," +
+           to_string(p2p) + "," + to_string(cu);
+}
+
+static uint64_t fileSize(const string& path)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return 0;
+    return st.st_size;
+}
+
+static double median(vector<double> values)
+{
+    sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+static string corpusPath(const string& kind, uint64_t size, uint32_t idx)
+{
+    return g_options.dir + "/" + kind + "_" + formatSize(size) + "_" + to_string(idx) + ".dat";
+}
+
+static uint64_t corpusSeed(const string& kind, uint32_t idx)
+{
+    uint64_t seed = 0;
+    for (char c : kind) seed = seed * 31 + c;
+    return seed * 1000 + idx;
+}
+
+static bool readWhole(const string& path, vector<uint8_t>& data, uint64_t size)
+{
+    ifstream in(path.c_str(), ifstream::binary);
+    if (!in) return false;
+    data.resize(size);
+    in.read((char*)data.data(), size);
+    return (uint64_t)in.gcount() == size;
+}
+
+static Run runCompress(const vector<string>& files, bool p2p, uint32_t block_kb)
+{
+    // The host opens outputs without truncating, stale tails would be kept
+    for (const string& file : files) unlink((file + ".lz4").c_str());
+
+    Compress module(g_options.xclbin, 0, p2p, block_kb);
+    module.SetInputFileList(files);
+    module.MakeOutputFileList(files);
+    auto start = chrono::high_resolution_clock::now();
+    module.OpenInputFiles();
+    module.OpenOutputFiles();
+    module.SetOutputFileSize();
+    module.initBuffer();
+    module.readFile();
+    module.preProcess();
+    module.run();
+    module.postProcess();
+    module.writeFile();
+    module.CloseInputFiles();
+    module.CloseOutputFiles();
+    auto end = chrono::high_resolution_clock::now();
+
+    Run run;
+    run.wallNs = chrono::duration<double, nano>(end - start).count();
+    run.kernelNs = module.metrics().histogram(STAGE_KERNEL).sum();
+    return run;
+}
+
+static Run runDecompress(const vector<string>& files, bool p2p, uint32_t cu)
+{
+    vector<string> inputs;
+    for (const string& file : files) {
+        inputs.push_back(file + ".lz4");
+        unlink((file + ".lz4.org").c_str());
+    }
+
+    Decompress module(g_options.xclbin, 0, p2p, cu);
+    module.SetInputFileList(inputs);
+    module.MakeOutputFileList(inputs);
+    auto start = chrono::high_resolution_clock::now();
+    module.OpenInputFiles();
+    module.OpenOutputFiles();
+    module.initBuffer();
+    module.readFile();
+    module.preProcess();
+    module.run();
+    module.postProcess();
+    module.writeFile();
+    module.CloseInputFiles();
+    module.CloseOutputFiles();
+    auto end = chrono::high_resolution_clock::now();
+
+    Run run;
+    run.wallNs = chrono::duration<double, nano>(end - start).count();
+    run.kernelNs = module.metrics().histogram(STAGE_KERNEL).sum();
+    return run;
+}
+
+// Decompressed outputs are padded to 4K, only the original length is compared
+static bool verifyFiles(const vector<string>& files, uint64_t size)
+{
+    vector<uint8_t> original, restored;
+    for (const string& file : files) {
+        if (!readWhole(file, original, size) || !readWhole(file + ".lz4.org", restored, size)) return false;
+        if (original != restored) return false;
+    }
+    return true;
+}
+
+template <typename F>
+static void measure(F body, vector<Run>& runs)
+{
+    for (uint32_t i = 0; i < g_options.warmup; i++) body();
+    for (uint32_t i = 0; i < g_options.repeats; i++) runs.push_back(body());
+}
+
+static LZ4F_blockSizeID_t lz4BlockId(uint32_t block_kb)
+{
+    switch (block_kb) {
+        case 256:
+            return LZ4F_max256KB;
+        case 1024:
+            return LZ4F_max1MB;
+        case 4096:
+            return LZ4F_max4MB;
+        default:
+            return LZ4F_max64KB;
+    }
+}
+
+// Same frame layout as the kernels: independent blocks, content size, no checksum
+static void cpuBaseline(const vector<uint8_t>& data, uint32_t block_kb, double& comp_mbps, double& dec_mbps)
+{
+    LZ4F_preferences_t prefs;
+    memset(&prefs, 0, sizeof(prefs));
+    prefs.frameInfo.blockSizeID = lz4BlockId(block_kb);
+    prefs.frameInfo.blockMode = LZ4F_blockIndependent;
+    prefs.frameInfo.contentSize = data.size();
+
+    vector<uint8_t> frame(LZ4F_compressFrameBound(data.size(), &prefs));
+    vector<uint8_t> restored(data.size());
+    vector<double> comp_ns, dec_ns;
+    size_t frame_size = 0;
+    for (uint32_t i = 0; i < g_options.warmup + g_options.repeats; i++) {
+        auto start = chrono::high_resolution_clock::now();
+        frame_size = LZ4F_compressFrame(frame.data(), frame.size(), data.data(), data.size(), &prefs);
+        auto mid = chrono::high_resolution_clock::now();
+        if (LZ4F_isError(frame_size)) {
+            cout << "LZ4F_compressFrame failed: " << LZ4F_getErrorName(frame_size) << endl;
+            exit(EXIT_FAILURE);
+        }
+
+        LZ4F_dctx* dctx;
+        LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION);
+        size_t dst_size = restored.size();
+        size_t src_size = frame_size;
+        LZ4F_decompress(dctx, restored.data(), &dst_size, frame.data(), &src_size, NULL);
+        LZ4F_freeDecompressionContext(dctx);
+        auto end = chrono::high_resolution_clock::now();
+
+        if (i < g_options.warmup) continue;
+        comp_ns.push_back(chrono::duration<double, nano>(mid - start).count());
+        dec_ns.push_back(chrono::duration<double, nano>(end - mid).count());
+    }
+    comp_mbps = data.size() * 1000.0 / median(comp_ns);
+    dec_mbps = data.size() * 1000.0 / median(dec_ns);
+}
+
+static Result summarize(const string& op, const string& corpus, uint64_t size, uint32_t count, uint32_t block_kb,
+                        uint32_t p2p, uint32_t cu, const vector<Run>& runs)
+{
+    Result result{};
+    result.op = op;
+    result.corpus = corpus;
+    result.fileSize = size;
+    result.fileCount = count;
+    result.blockKb = block_kb;
+    result.p2p = p2p;
+    result.cu = cu;
+    result.bytes = size * count;
+
+    vector<double> walls;
+    for (const Run& run : runs) walls.push_back(run.wallNs);
+    double wall = median(walls);
+    result.wallMsMedian = wall / 1e6;
+    result.wallMsMin = *min_element(walls.begin(), walls.end()) / 1e6;
+    result.mbps = result.bytes * 1000.0 / wall;
+    for (const Run& run : runs) {
+        if (run.wallNs == wall && run.kernelNs > 0) result.kernelMbps = result.bytes * 1000.0 / run.kernelNs;
+    }
+    result.verified = true;
+    return result;
+}
+
+static map<string, double> loadBaseline(const string& path)
+{
+    map<string, double> baseline;
+    ifstream in(path.c_str());
+    if (!in) return baseline;
+
+    string line;
+    getline(in, line); // header
+    while (getline(in, line)) {
+        vector<string> fields;
+        size_t pos = 0, next;
+        while ((next = line.find(',', pos)) != string::npos) {
+            fields.push_back(line.substr(pos, next - pos));
+            pos = next + 1;
+        }
+        fields.push_back(line.substr(pos));
+        if (fields.size() < 12) continue;
+        // op, corpus, file_size, file_count, block_kb, p2p, cu, ..., mbps
+        baseline[key(fields[0], fields[1], stoull(fields[2]), stoul(fields[3]), stoul(fields[4]), stoul(fields[5]),
+                     stoul(fields[6]))] = stod(fields[11]);
+    }
+    return baseline;
+}
+
+static bool writeCsv(const string& path, const vector<Result>& results)
+{
+    ofstream out(path.c_str(), ofstream::trunc);
+    if (!out) {
+        cout << "Unable to open " << path << endl;
+        return false;
+    }
+    out << fixed << setprecision(3);
+    out << "op,corpus,file_size,file_count,block_kb,p2p,cu,bytes,ratio,wall_ms_median,wall_ms_min,mbps,kernel_mbps,"
+           "cpu_mbps,verified,baseline_mbps,regression\n";
+    for (const Result& r : results) {
+        out << r.op << "," << r.corpus << "," << r.fileSize << "," << r.fileCount << "," << r.blockKb << "," << r.p2p
+            << "," << r.cu << "," << r.bytes << "," << r.ratio << "," << r.wallMsMedian << "," << r.wallMsMin << ","
+            << r.mbps << "," << r.kernelMbps << "," << r.cpuMbps << "," << r.verified << "," << r.baselineMbps << ","
+            << r.regression << "\n";
+    }
+    return true;
+}
+
+static bool writeJson(const string& path, const vector<Result>& results)
+{
+    ofstream out(path.c_str(), ofstream::trunc);
+    if (!out) {
+        cout << "Unable to open " << path << endl;
+        return false;
+    }
+    out << fixed << setprecision(3);
+    out << "{\"warmup\":" << g_options.warmup << ",\"repeats\":" << g_options.repeats
+        << ",\"tolerance\":" << g_options.tolerance << ",\"points\":[";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        out << (i ? ",\n" : "\n") << "{\"op\":\"" << r.op << "\",\"corpus\":\"" << r.corpus
+            << "\",\"file_size\":" << r.fileSize << ",\"file_count\":" << r.fileCount << ",\"block_kb\":" << r.blockKb
+            << ",\"p2p\":" << (r.p2p ? "true" : "false") << ",\"cu\":" << r.cu << ",\"bytes\":" << r.bytes
+            << ",\"ratio\":" << r.ratio << ",\"wall_ms_median\":" << r.wallMsMedian
+            << ",\"wall_ms_min\":" << r.wallMsMin << ",\"mbps\":" << r.mbps << ",\"kernel_mbps\":" << r.kernelMbps
+            << ",\"cpu_mbps\":" << r.cpuMbps << ",\"verified\":" << (r.verified ? "true" : "false")
+            << ",\"baseline_mbps\":" << r.baselineMbps << ",\"regression\":" << (r.regression ? "true" : "false")
+            << "}";
+    }
+    out << "\n]}\n";
+    return true;
+}
+
+static void printResult(const Result& r)
+{
+    cout << "\x1B[32m[Bench]\033[0m " << setw(10) << r.op << " " << setw(14) << r.corpus << " "
+         << setw(5) << formatSize(r.fileSize) << " x" << r.fileCount << " block " << r.blockKb << "KB p2p " << r.p2p
+         << " cu " << r.cu << " : " << fixed << setprecision(2) << r.mbps << " MB/s (kernel " << r.kernelMbps
+         << ", cpu " << r.cpuMbps << ") ratio " << r.ratio;
+    if (!r.verified) cout << " \x1B[31mMISMATCH\033[0m";
+    if (r.regression) cout << " \x1B[31mREGRESSION\033[0m (baseline " << r.baselineMbps << ")";
+    cout << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    namespace po = boost::program_options;
+
+    po::options_description desc("Options");
+    desc.add_options()("help,h", "Show help")
+        ("xclbin", po::value<string>()->required(), "Kernel compression bin xclbin file")
+        ("dir", po::value<string>()->default_value("/mnt/smartssd/bench"), "Directory for corpus and output files")
+        ("corpus", po::value<vector<string>>()->multitoken()->default_value(corpusKinds(), "text logs binary incompressible zero"), "Corpus kinds")
+        ("file_size", po::value<vector<string>>()->multitoken()->default_value(vector<string>{"1M", "16M", "64M"}, "1M 16M 64M"), "File sizes (K/M/G suffix)")
+        ("file_count", po::value<vector<uint32_t>>()->multitoken()->default_value(vector<uint32_t>{1, 2, 4, 8}, "1 2 4 8"), "Number of files per run")
+        ("block_size", po::value<vector<uint32_t>>()->multitoken()->default_value(vector<uint32_t>{BLOCK_SIZE_IN_KB}, "64"), "Compress block sizes (KB)")
+        ("p2p", po::value<vector<uint32_t>>()->multitoken()->default_value(vector<uint32_t>{1, 0}, "1 0"), "P2P modes (1 on, 0 off)")
+        ("decompress_cu", po::value<vector<uint32_t>>()->multitoken()->default_value(vector<uint32_t>{DECOMPRESS_CU}, to_string(DECOMPRESS_CU)), "Numbers of decompress compute units")
+        ("compress", po::value<bool>()->default_value(true), "Benchmark compression")
+        ("decompress", po::value<bool>()->default_value(true), "Benchmark decompression")
+        ("warmup", po::value<uint32_t>()->default_value(1), "Unrecorded runs per point")
+        ("repeats", po::value<uint32_t>()->default_value(3), "Recorded runs per point, the median is reported")
+        ("csv", po::value<string>()->default_value("bench_results.csv"), "CSV result file")
+        ("json", po::value<string>()->default_value("bench_results.json"), "JSON result file")
+        ("baseline", po::value<string>()->default_value(""), "Baseline CSV from an earlier run")
+        ("tolerance", po::value<double>()->default_value(10), "Throughput drop (%) below the baseline reported as a regression")
+        ("update_baseline", po::value<bool>()->default_value(false), "Write the results to the baseline file");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+
+    if (vm.count("help") > 0 || vm.count("xclbin") == 0) {
+        cout << desc;
+        return -1;
+    }
+    notify(vm);
+
+    g_options.xclbin = vm["xclbin"].as<string>();
+    g_options.dir = vm["dir"].as<string>();
+    g_options.corpora = vm["corpus"].as<vector<string>>();
+    for (const string& size : vm["file_size"].as<vector<string>>()) g_options.fileSizes.push_back(parseSize(size));
+    g_options.fileCounts = vm["file_count"].as<vector<uint32_t>>();
+    g_options.blockSizes = vm["block_size"].as<vector<uint32_t>>();
+    g_options.p2pModes = vm["p2p"].as<vector<uint32_t>>();
+    g_options.decompressCus = vm["decompress_cu"].as<vector<uint32_t>>();
+    g_options.compress = vm["compress"].as<bool>();
+    g_options.decompress = vm["decompress"].as<bool>();
+    g_options.warmup = vm["warmup"].as<uint32_t>();
+    g_options.repeats = max(1u, vm["repeats"].as<uint32_t>());
+    g_options.csv = vm["csv"].as<string>();
+    g_options.json = vm["json"].as<string>();
+    g_options.baseline = vm["baseline"].as<string>();
+    g_options.tolerance = vm["tolerance"].as<double>();
+    g_options.updateBaseline = vm["update_baseline"].as<bool>();
+
+    for (const string& kind : g_options.corpora) {
+        if (!isCorpusKind(kind)) {
+            cout << "Unknown corpus " << kind << endl;
+            return -1;
+        }
+    }
+    for (uint32_t block_kb : g_options.blockSizes) {
+        if (block_kb != 64 && block_kb != 256 && block_kb != 1024 && block_kb != 4096) {
+            cout << "Block size should be 64, 256, 1024 or 4096 KB, got " << block_kb << endl;
+            return -1;
+        }
+    }
+    for (uint32_t cu : g_options.decompressCus) {
+        if (cu < 1 || cu > DECOMPRESS_CU) {
+            cout << "Decompress CU should be within 1 ~ " << DECOMPRESS_CU << ", got " << cu << endl;
+            return -1;
+        }
+    }
+    // Decompression needs the compressed files of the same point
+    if (g_options.decompress && !g_options.compress) {
+        cout << "--decompress requires --compress" << endl;
+        return -1;
+    }
+
+    mkdir(g_options.dir.c_str(), 0777);
+    map<string, double> baseline;
+    if (!g_options.baseline.empty() && !g_options.updateBaseline) baseline = loadBaseline(g_options.baseline);
+
+    uint32_t max_count = *max_element(g_options.fileCounts.begin(), g_options.fileCounts.end());
+    vector<Result> results;
+    for (const string& kind : g_options.corpora) {
+        for (uint64_t size : g_options.fileSizes) {
+            vector<string> all_files;
+            for (uint32_t idx = 0; idx < max_count; idx++) {
+                string path = corpusPath(kind, size, idx);
+                if (!writeCorpusFile(path, kind, corpusSeed(kind, idx), size)) return -1;
+                all_files.push_back(path);
+            }
+            vector<uint8_t> sample;
+            readWhole(all_files[0], sample, size);
+
+            for (uint32_t block_kb : g_options.blockSizes) {
+                double cpu_comp_mbps, cpu_dec_mbps;
+                cpuBaseline(sample, block_kb, cpu_comp_mbps, cpu_dec_mbps);
+
+                for (uint32_t count : g_options.fileCounts) {
+                    vector<string> files(all_files.begin(), all_files.begin() + count);
+                    for (uint32_t p2p : g_options.p2pModes) {
+                        vector<Run> runs;
+                        measure([&]() { return runCompress(files, p2p, block_kb); }, runs);
+                        Result comp = summarize("compress", kind, size, count, block_kb, p2p, 1, runs);
+                        uint64_t compressed = 0;
+                        for (const string& file : files) compressed += fileSize(file + ".lz4");
+                        comp.ratio = compressed ? (double)comp.bytes / compressed : 0;
+                        comp.cpuMbps = cpu_comp_mbps;
+                        results.push_back(comp);
+
+                        if (!g_options.decompress) continue;
+                        for (uint32_t cu : g_options.decompressCus) {
+                            runs.clear();
+                            measure([&]() { return runDecompress(files, p2p, cu); }, runs);
+                            Result dec = summarize("decompress", kind, size, count, block_kb, p2p, cu, runs);
+                            dec.ratio = comp.ratio;
+                            dec.cpuMbps = cpu_dec_mbps;
+                            dec.verified = verifyFiles(files, size);
+                            results.push_back(dec);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    uint32_t regressions = 0;
+    uint32_t mismatches = 0;
+    for (Result& r : results) {
+        auto it = baseline.find(key(r.op, r.corpus, r.fileSize, r.fileCount, r.blockKb, r.p2p, r.cu));
+        if (it != baseline.end()) {
+            r.baselineMbps = it->second;
+            r.regression = r.mbps < it->second * (1 - g_options.tolerance / 100);
+        }
+        if (r.regression) regressions++;
+        if (!r.verified) mismatches++;
+    }
+
+    cout << "########################### Benchmark ###########################################" << endl;
+    for (const Result& r : results) printResult(r);
+
+    writeCsv(g_options.csv, results);
+    writeJson(g_options.json, results);
+    if (g_options.updateBaseline && !g_options.baseline.empty()) writeCsv(g_options.baseline, results);
+
+    if (!baseline.empty()) {
+        cout << regressions << " of " << results.size() << " points regressed more than " << g_options.tolerance
+             << "% against " << g_options.baseline << endl;
+    }
+    if (mismatches) cout << mismatches << " decompress points did not match the input" << endl;
+    return (regressions || mismatches) ? 1 : 0;
+}
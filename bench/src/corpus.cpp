@@ -0,0 +1,219 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "corpus.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// xorshift64*, good enough for test data and identical on every host
+class Rng {
+    public:
+    explicit Rng(uint64_t seed) : m_state(seed * 0x9E3779B97F4A7C15ULL + 1) {}
+    uint64_t next()
+    {
+        m_state ^= m_state >> 12;
+        m_state ^= m_state << 25;
+        m_state ^= m_state >> 27;
+        return m_state * 0x2545F4914F6CDD1DULL;
+    }
+    uint32_t below(uint32_t n) { return next() % n; }
+
+    private:
+    uint64_t m_state;
+};
+
+static const char* c_words[] = {
+    "the",     "of",      "and",    "to",      "in",      "is",       "that",    "for",      "it",     "as",
+    "with",    "was",     "on",     "be",      "by",      "at",       "this",    "from",     "or",     "which",
+    "storage", "device",  "kernel", "block",   "stream",  "compress", "memory",  "transfer", "host",   "engine",
+    "data",    "file",    "system", "between", "through", "without",  "however", "several",  "number", "during",
+    "value",   "between", "large",  "small",   "every",   "other",    "first",   "last",     "while",  "because",
+    "format",  "offset",  "length", "literal", "match",   "buffer",   "queue",   "event",    "result", "throughput"};
+static const uint32_t c_numWords = sizeof(c_words) / sizeof(c_words[0]);
+
+static const char* c_levels[] = {"INFO", "INFO", "INFO", "INFO", "DEBUG", "WARN", "ERROR"};
+static const char* c_paths[] = {"/api/v1/objects", "/api/v1/objects/meta", "/api/v1/health", "/api/v2/upload",
+                                "/api/v2/download", "/metrics"};
+static const uint32_t c_status[] = {200, 200, 200, 200, 201, 204, 304, 404, 500};
+
+static const std::vector<std::string> c_kinds = {"text", "logs", "binary", "incompressible", "zero"};
+
+const std::vector<std::string>& corpusKinds()
+{
+    return c_kinds;
+}
+
+bool isCorpusKind(const std::string& kind)
+{
+    return std::find(c_kinds.begin(), c_kinds.end(), kind) != c_kinds.end();
+}
+
+static void append(std::vector<uint8_t>& out, const char* str, size_t len)
+{
+    out.insert(out.end(), str, str + len);
+}
+
+static void generateText(Rng& rng, std::vector<uint8_t>& out, uint64_t size)
+{
+    uint32_t line = 0;
+    bool sentence_start = true;
+    while (out.size() < size) {
+        const char* word = c_words[rng.below(c_numWords)];
+        size_t len = strlen(word);
+        if (sentence_start) {
+            out.push_back(toupper(word[0]));
+            append(out, word + 1, len - 1);
+        } else {
+            append(out, word, len);
+        }
+        line += len + 1;
+        sentence_start = (rng.below(12) == 0);
+        if (sentence_start) out.push_back(rng.below(4) ? '.' : ',');
+        if (line > 72) {
+            out.push_back('\n');
+            line = 0;
+        } else {
+            out.push_back(' ');
+        }
+    }
+}
+
+static void generateLogs(Rng& rng, std::vector<uint8_t>& out, uint64_t size)
+{
+    uint64_t ms = 1577836800000ULL;
+    uint64_t request = 100000;
+    char line[256];
+    while (out.size() < size) {
+        ms += rng.below(50);
+        uint64_t sec = ms / 1000;
+        int len = snprintf(line, sizeof(line),
+                           "2020-01-%02u %02u:%02u:%02u.%03u %-5s [worker-%u] request=%llu path=%s status=%u "
+                           "bytes=%u latency_ms=%u\n",
+                           (unsigned)(1 + (sec / 86400) % 28), (unsigned)((sec / 3600) % 24),
+                           (unsigned)((sec / 60) % 60), (unsigned)(sec % 60), (unsigned)(ms % 1000),
+                           c_levels[rng.below(7)], rng.below(16), (unsigned long long)request++,
+                           c_paths[rng.below(6)], c_status[rng.below(9)], rng.below(1 << 20), rng.below(200));
+        append(out, line, len);
+    }
+}
+
+static void generateBinary(Rng& rng, std::vector<uint8_t>& out, uint64_t size)
+{
+    uint32_t id = 0;
+    uint64_t timestamp = 1577836800000000ULL;
+    float value = 0;
+    while (out.size() < size) {
+        uint8_t record[24];
+        timestamp += rng.below(1000);
+        value += (float)((int)rng.below(200) - 100) / 16;
+        uint16_t type = rng.below(8);
+        uint16_t flags = rng.below(16) ? 0 : rng.below(0x10000);
+        uint32_t count = rng.below(4) ? 1 : rng.below(1000);
+        memcpy(record, &id, 4);
+        memcpy(record + 4, &type, 2);
+        memcpy(record + 6, &flags, 2);
+        memcpy(record + 8, &timestamp, 8);
+        memcpy(record + 16, &value, 4);
+        memcpy(record + 20, &count, 4);
+        append(out, (const char*)record, sizeof(record));
+        id++;
+    }
+}
+
+static void generateRandom(Rng& rng, std::vector<uint8_t>& out, uint64_t size)
+{
+    while (out.size() < size) {
+        uint64_t word = rng.next();
+        append(out, (const char*)&word, sizeof(word));
+    }
+}
+
+void generateCorpus(const std::string& kind, uint64_t seed, std::vector<uint8_t>& out, uint64_t size)
+{
+    Rng rng(seed);
+    out.clear();
+    out.reserve(size + 256);
+    if (kind == "text") {
+        generateText(rng, out, size);
+    } else if (kind == "logs") {
+        generateLogs(rng, out, size);
+    } else if (kind == "binary") {
+        generateBinary(rng, out, size);
+    } else if (kind == "incompressible") {
+        generateRandom(rng, out, size);
+    } else if (kind == "zero") {
+        out.assign(size, 0);
+    } else {
+        std::cout << "Unknown corpus kind " << kind << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    out.resize(size);
+}
+
+bool writeCorpusFile(const std::string& path, const std::string& kind, uint64_t seed, uint64_t size)
+{
+    std::ifstream existing(path.c_str(), std::ifstream::binary | std::ifstream::ate);
+    if (existing && (uint64_t)existing.tellg() == size) return true;
+    existing.close();
+
+    std::vector<uint8_t> data;
+    generateCorpus(kind, seed, data, size);
+    std::ofstream out(path.c_str(), std::ofstream::binary | std::ofstream::trunc);
+    if (!out) {
+        std::cout << "Unable to create corpus file " << path << std::endl;
+        return false;
+    }
+    out.write((const char*)data.data(), data.size());
+    return (bool)out;
+}
+
+uint64_t parseSize(const std::string& size)
+{
+    char* end = NULL;
+    uint64_t value = strtoull(size.c_str(), &end, 10);
+    switch (*end) {
+        case 'g':
+        case 'G':
+            value <<= 10;
+        // fall through
+        case 'm':
+        case 'M':
+            value <<= 10;
+        // fall through
+        case 'k':
+        case 'K':
+            value <<= 10;
+        // fall through
+        case '\0':
+            break;
+        default:
+            std::cout << "Invalid size " << size << std::endl;
+            exit(EXIT_FAILURE);
+    }
+    return value;
+}
+
+std::string formatSize(uint64_t size)
+{
+    if (size && size % (1 << 30) == 0) return std::to_string(size >> 30) + "G";
+    if (size && size % (1 << 20) == 0) return std::to_string(size >> 20) + "M";
+    if (size && size % (1 << 10) == 0) return std::to_string(size >> 10) + "K";
+    return std::to_string(size);
+}
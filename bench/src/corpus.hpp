@@ -0,0 +1,46 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_BENCH_CORPUS_HPP_
+#define _XFCOMPRESSION_BENCH_CORPUS_HPP_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * Synthetic benchmark inputs. Every generator is deterministic for a given
+ * seed so a stored baseline always refers to the same bytes.
+ *
+ * text           : English-like words, sentences and line breaks
+ * logs           : timestamped service log lines with repeating fields
+ * binary         : fixed-size little endian records (ids, enums, floats)
+ * incompressible : xorshift random bytes
+ * zero           : zero-filled
+ */
+bool isCorpusKind(const std::string& kind);
+const std::vector<std::string>& corpusKinds();
+
+void generateCorpus(const std::string& kind, uint64_t seed, std::vector<uint8_t>& out, uint64_t size);
+
+// Generates the file unless it already exists with the requested size
+bool writeCorpusFile(const std::string& path, const std::string& kind, uint64_t seed, uint64_t size);
+
+// Parses "4096", "64K", "16M" or "1G"
+uint64_t parseSize(const std::string& size);
+std::string formatSize(uint64_t size);
+
+#endif // _XFCOMPRESSION_BENCH_CORPUS_HPP_
@@ -0,0 +1,168 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/**
+ * @file hash_bench.cpp
+ * @brief Microbenchmark of the host checksums.
+ *
+ * usage: hash-bench [--size <bytes>] [--block_kb <kb>] [--repeats <n>]
+ *
+ * Hashes one random buffer cut into LZ4 blocks with XXH32 / XXH64 of
+ * xxhash.c, xxh32Blocks() and XXH3 on every instruction set of the machine,
+ * and reports the best of the repeats in MB/s. Exits non-zero if
+ * xxh32Blocks() disagrees with XXH32() or xxh3_64() / xxh3_128() with the
+ * xxHash 0.8.2 test vectors on any instruction set.
+ */
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <xxhash.h>
+#include <xxhash_simd.hpp>
+#include "corpus.hpp"
+
+static uint64_t g_sink;
+
+// XXH3_64bits() and XXH3_128bits() of xxHash 0.8.2 over the first len bytes of the buffer of xsum_sanity_check.c,
+// lengths picked to go through every path of XXH3
+static const struct {
+    size_t len;
+    uint64_t hash64;
+    uint64_t low64;
+    uint64_t high64;
+} c_xxh3Vectors[] = {
+    {0, 0x2D06800538D394C2ULL, 0x6001C324468D497FULL, 0x99AA06D3014798D8ULL},
+    {1, 0xC44BDFF4074EECDBULL, 0xC44BDFF4074EECDBULL, 0xA6CD5E9392000F6AULL},
+    {6, 0x27B56A84CD2D7325ULL, 0x3E7039BDDA43CFC6ULL, 0x082AFE0B8162D12AULL},
+    {12, 0xA713DAF0DFBB77E7ULL, 0x061A192713F69AD9ULL, 0x6E3EFD8FC7802B18ULL},
+    {24, 0xA3FE70BF9D3510EBULL, 0x1E7044D28B1B901DULL, 0x0CE966E4678D3761ULL},
+    {48, 0x397DA259ECBA1F11ULL, 0xF942219AED80F67BULL, 0xA002AC4E5478227EULL},
+    {80, 0xBCDEFBBB2C47C90AULL, 0x454AE6BF7A8A532DULL, 0xFDF2CEFDE9EAAC8AULL},
+    {195, 0xCD94217EE362EC3AULL, 0x3FB593C086A66075ULL, 0x7729543A26B207EEULL},
+    {403, 0xCDEB804D65C6DEA4ULL, 0xCDEB804D65C6DEA4ULL, 0x1B6DE21E332DD73DULL},
+    {512, 0x617E49599013CB6BULL, 0x617E49599013CB6BULL, 0x18D2D110DCC9BCA1ULL},
+    {2048, 0xDD59E2C3A5F038E0ULL, 0xDD59E2C3A5F038E0ULL, 0xF736557FD47073A5ULL},
+    {2240, 0x6E73A90539CF2948ULL, 0x6E73A90539CF2948ULL, 0xCCB134FBFA7CE49DULL},
+    {2367, 0xCB37AEB9E5D361EDULL, 0xCB37AEB9E5D361EDULL, 0xE89C0F6FF369B427ULL},
+};
+
+// Checks xxh3_64() and xxh3_128() with the active instruction set against c_xxh3Vectors
+static bool checkXxh3() {
+    std::vector<uint8_t> buffer(2367);
+    uint64_t gen = 2654435761U;
+    for (uint8_t& byte : buffer) {
+        byte = (uint8_t)(gen >> 56);
+        gen *= 11400714785074694797ULL;
+    }
+    for (const auto& v : c_xxh3Vectors) {
+        hash128 h = xxh3_128(buffer.data(), v.len);
+        if (xxh3_64(buffer.data(), v.len) != v.hash64 || h.low64 != v.low64 || h.high64 != v.high64) return false;
+    }
+    return true;
+}
+
+// Best MB/s of repeats runs of fn over bytes
+static double measure(uint64_t bytes, uint32_t repeats, const std::function<void()>& fn) {
+    double best = 0;
+    for (uint32_t r = 0; r < repeats; r++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        fn();
+        auto end = std::chrono::high_resolution_clock::now();
+        double mbps = bytes / std::chrono::duration<double, std::micro>(end - start).count();
+        if (mbps > best) best = mbps;
+    }
+    return best;
+}
+
+static void printResult(const std::string& name, const std::string& isa, double mbps) {
+    std::cout << std::left << std::setw(24) << name << std::setw(10) << isa << std::right << std::fixed
+              << std::setprecision(0) << std::setw(12) << mbps << std::endl;
+}
+
+int main(int argc, char** argv) {
+    uint64_t size = 64 << 20;
+    uint32_t block_kb = 64;
+    uint32_t repeats = 5;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (arg == "--size" && has_value) {
+            size = parseSize(argv[++i]);
+        } else if (arg == "--block_kb" && has_value) {
+            block_kb = atoi(argv[++i]);
+        } else if (arg == "--repeats" && has_value) {
+            repeats = atoi(argv[++i]);
+        } else {
+            std::cout << "usage: " << argv[0] << " [--size <bytes>] [--block_kb <kb>] [--repeats <n>]" << std::endl;
+            return -1;
+        }
+    }
+    if (size == 0 || block_kb == 0 || repeats == 0) {
+        std::cout << "Size, block size and repeats should be non-zero" << std::endl;
+        return -1;
+    }
+
+    std::vector<uint8_t> data;
+    generateCorpus("incompressible", 1, data, size);
+    uint64_t block_size = (uint64_t)block_kb * 1024;
+    std::vector<const uint8_t*> blocks;
+    std::vector<size_t> sizes;
+    for (uint64_t offset = 0; offset < size; offset += block_size) {
+        blocks.push_back(data.data() + offset);
+        sizes.push_back(std::min(block_size, size - offset));
+    }
+    std::vector<uint32_t> expected(blocks.size()), hashes(blocks.size());
+    for (size_t i = 0; i < blocks.size(); i++) expected[i] = XXH32(blocks[i], sizes[i], 0);
+
+    std::cout << formatSize(size) << " in " << blocks.size() << " blocks of " << block_kb << " KB, best of "
+              << repeats << std::endl;
+    std::cout << std::left << std::setw(24) << "hash" << std::setw(10) << "isa" << std::right << std::setw(12)
+              << "MB/s" << std::endl;
+    printResult("XXH32 per block", "xxhash.c", measure(size, repeats, [&]() {
+                    for (size_t i = 0; i < blocks.size(); i++) g_sink += XXH32(blocks[i], sizes[i], 0);
+                }));
+    printResult("XXH64 per block", "xxhash.c", measure(size, repeats, [&]() {
+                    for (size_t i = 0; i < blocks.size(); i++) g_sink += XXH64(blocks[i], sizes[i], 0);
+                }));
+
+    uint32_t mismatches = 0;
+    for (int isa = HASH_ISA_SCALAR; isa <= hashDetectIsa(); isa++) {
+        const char* name = hashIsaName(hashSelectIsa((hashIsa)isa));
+        printResult("xxh32Blocks x" + std::to_string(hashLanes()), name, measure(size, repeats, [&]() {
+                        xxh32Blocks(blocks.data(), sizes.data(), blocks.size(), 0, hashes.data());
+                    }));
+        if (hashes != expected) {
+            std::cout << "\x1B[31mxxh32Blocks differs from XXH32 with " << name << "\033[0m" << std::endl;
+            mismatches++;
+        }
+        if (!checkXxh3()) {
+            std::cout << "\x1B[31mxxh3_64 / xxh3_128 differ from the xxHash 0.8.2 test vectors with " << name
+                      << "\033[0m" << std::endl;
+            mismatches++;
+        }
+        printResult("XXH3-64 per block", name, measure(size, repeats, [&]() {
+                        for (size_t i = 0; i < blocks.size(); i++) g_sink += xxh3_64(blocks[i], sizes[i]);
+                    }));
+        printResult("XXH3-128 per block", name, measure(size, repeats, [&]() {
+                        for (size_t i = 0; i < blocks.size(); i++) g_sink += xxh3_128(blocks[i], sizes[i]).low64;
+                    }));
+    }
+    return mismatches ? 1 : 0;
+}
@@ -4,6 +4,12 @@
 #include <SmartSSD.hpp>
 #include <lz4_p2p_comp.hpp>
 #include <lz4_p2p_dec.hpp>
+#include <lz4_cpu.hpp>
+#include <lz4_dict.hpp>
+#include <zone_map.hpp>
+#include <hybrid.hpp>
+#include <fstream>
+#include <thread>
 #include <vector>
 
 #define MEMORY_SIZE 2U << 31
@@ -15,9 +21,244 @@ struct Options {
   std::vector<std::string> inputFileList;
   bool compress;
   bool enable_p2p;
+  uint32_t block_size;
+  bool checksum;
+  bool block_index;
+  bool batch;
+  uint64_t range_offset;
+  uint64_t range_length;
+  uint32_t decompress_cu;
+  string metrics_json;
+  string metrics_prom;
+  string trace;
+  string backend;
+  uint32_t threads;
+  string hybrid_profile;
+  string dict;
+  string train_dict;
+  uint32_t dict_size;
+  string codec;
+  std::vector<std::string> filter;
+  string filter_delimiter;
+  string filter_output;
+  std::vector<uint32_t> columns;
+  string field_delimiter;
+  bool zone_query;
+  int64_t zone_min;
+  int64_t zone_max;
   bool multiple;
 } g_options{};
 
+// Preset dictionary of --dict, empty without one
+static std::vector<uint8_t> g_dict;
+// Format of --codec
+static compressCodec g_codec = CODEC_LZ4;
+// Field of --zone_column or --zone_offset, every frame gets its zone map with g_zoneMap
+static dt_zoneConfig g_zoneConfig = {};
+static bool g_zoneMap = false;
+
+// Delimiter of --filter_delimiter and --field_delimiter: one character, or \\n, \\t, \\r or \\0
+static bool parseDelimiter(const std::string& text, uint8_t& delimiter) {
+    if (text.size() == 1) {
+        delimiter = text[0];
+        return true;
+    }
+    if (text.size() != 2 || text[0] != '\\') return false;
+    switch (text[1]) {
+        case 'n': delimiter = '\n'; return true;
+        case 't': delimiter = '\t'; return true;
+        case 'r': delimiter = '\r'; return true;
+        case '0': delimiter = 0; return true;
+    }
+    return false;
+}
+
+static void exportMetrics(const Metrics& metrics) {
+    if (!g_options.metrics_json.empty()) metrics.writeJsonLines(g_options.metrics_json);
+    if (!g_options.metrics_prom.empty()) metrics.writePrometheus(g_options.metrics_prom);
+}
+
+// Runs the whole pipeline on files, returns its wall time (s)
+template <typename T>
+static double compressFiles(T& compressModule, const std::vector<std::string>& files, const std::string& trace) {
+    auto start = std::chrono::high_resolution_clock::now();
+    compressModule.tracer().enable(trace);
+    compressModule.setDictionary(g_dict);
+    if (g_zoneMap) compressModule.setZoneMap(g_zoneConfig);
+    compressModule.SetInputFileList(files);
+    compressModule.MakeOutputFileList(files);
+    compressModule.OpenInputFiles();
+    compressModule.OpenOutputFiles();
+    compressModule.SetOutputFileSize();
+
+    compressModule.initBuffer();
+    compressModule.readFile();
+    compressModule.preProcess();
+    compressModule.run();
+    compressModule.postProcess();
+    compressModule.writeFile();
+    compressModule.CloseInputFiles();
+    compressModule.CloseOutputFiles();
+    auto end = std::chrono::high_resolution_clock::now();
+    compressModule.tracer().write();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+template <typename T>
+static double decompressFiles(T& decompressModule, const std::vector<std::string>& files, const std::string& trace) {
+    auto start = std::chrono::high_resolution_clock::now();
+    decompressModule.tracer().enable(trace);
+    decompressModule.setDictionary(g_dict);
+    decompressModule.SetInputFileList(files);
+    decompressModule.MakeOutputFileList(files);
+    decompressModule.OpenInputFiles();
+    decompressModule.OpenOutputFiles();
+
+    decompressModule.initBuffer();
+    decompressModule.readFile();
+    decompressModule.preProcess();
+    decompressModule.run();
+    decompressModule.postProcess();
+    decompressModule.writeFile();
+    decompressModule.CloseInputFiles();
+    decompressModule.CloseOutputFiles();
+    auto end = std::chrono::high_resolution_clock::now();
+    decompressModule.tracer().write();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// Decompresses [range_offset, range_offset + range_length) of every file into {file}.range
+template <typename T>
+static void readRanges(T& decompressModule, const std::vector<std::string>& files, const std::string& trace) {
+    decompressModule.tracer().enable(trace);
+    decompressModule.setDictionary(g_dict);
+    for (const std::string& file : files) {
+        std::vector<uint8_t> data;
+        if (!decompressModule.readRange(file, g_options.range_offset, g_options.range_length, data)) {
+            std::cout << "Unable to read " << g_options.range_length << " B at " << g_options.range_offset << " from " << file << std::endl;
+            exit(1);
+        }
+        std::ofstream out((file + ".range").c_str(), std::ofstream::binary);
+        out.write((const char*)data.data(), data.size());
+    }
+    decompressModule.tracer().write();
+}
+
+// Decompresses the records of every file whose zone map field is in [zone_min, zone_max] into {file}.match,
+// reading only the blocks the zone map does not rule out
+template <typename T>
+static void readZones(T& decompressModule, const std::vector<std::string>& files, const std::string& trace) {
+    decompressModule.tracer().enable(trace);
+    decompressModule.setDictionary(g_dict);
+    for (const std::string& file : files) {
+        std::vector<uint8_t> data;
+        zoneMapQueryStats stats;
+        auto read = [&](uint64_t offset, uint64_t length, std::vector<uint8_t>& out) {
+            return decompressModule.readRange(file, offset, length, out);
+        };
+        if (!zoneMapQuery(file, g_options.zone_min, g_options.zone_max, read, data, stats)) {
+            std::cout << "Unable to read the zone map of " << file << ", compress it with --zone_column or --zone_offset" << std::endl;
+            exit(1);
+        }
+        std::ofstream out((file + ".match").c_str(), std::ofstream::binary);
+        out.write((const char*)data.data(), data.size());
+        std::cout << "\x1B[32m[Zone Map]\033[0m " << file << " : " << stats.blocksRead << " of " << stats.blocks
+                  << " blocks read, " << stats.records << " records" << std::endl;
+    }
+    decompressModule.tracer().write();
+}
+
+// Trains a dictionary on the files, one sample per file, and writes it to --train_dict
+static void trainDictionary(const std::vector<std::string>& files) {
+    std::vector<std::vector<uint8_t> > samples;
+    for (const std::string& file : files) {
+        std::ifstream in(file.c_str(), std::ifstream::binary);
+        if (!in) {
+            std::cout << "Unable to open " << file << std::endl;
+            exit(1);
+        }
+        samples.push_back(std::vector<uint8_t>((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>()));
+    }
+    std::vector<uint8_t> dict = lz4TrainDictionary(samples, g_options.dict_size);
+    lz4SaveDictionary(g_options.train_dict, dict);
+    std::cout << "Dictionary " << g_options.train_dict << " : " << dict.size() << " B from " << files.size()
+              << " samples, ID " << std::hex << lz4DictionaryId(dict) << std::dec << std::endl;
+}
+
+// Runs one path of a hybrid batch, leaves its metrics and wall time in metrics / seconds
+static void runPath(HybridPath path, const std::vector<std::string>& files, const std::string& trace,
+                    uint32_t cpu_threads, Metrics& metrics, double& seconds) {
+    if (files.empty()) return;
+    if (g_options.compress) {
+        if (path == PATH_FPGA) {
+            Compress compressModule(g_options.xclbin, 0, g_options.enable_p2p, g_options.block_size, g_options.checksum, g_options.block_index, g_options.batch, g_codec);
+            seconds = compressFiles(compressModule, files, trace);
+            metrics = compressModule.metrics();
+        } else {
+            CpuCompress compressModule(false, g_options.block_size, cpu_threads, g_options.checksum, g_options.block_index);
+            seconds = compressFiles(compressModule, files, trace);
+            metrics = compressModule.metrics();
+        }
+    } else {
+        if (path == PATH_FPGA) {
+            Decompress decompressModule(g_options.xclbin, 0, g_options.enable_p2p, g_options.decompress_cu, g_codec);
+            seconds = decompressFiles(decompressModule, files, trace);
+            metrics = decompressModule.metrics();
+        } else {
+            CpuDecompress decompressModule(false, cpu_threads);
+            seconds = decompressFiles(decompressModule, files, trace);
+            metrics = decompressModule.metrics();
+        }
+    }
+}
+
+// Splits the files between the FPGA and the CPU and runs both paths at the same time
+static void runHybrid() {
+    std::string operation = g_options.compress ? "compress" : "decompress";
+    bool fpga_available = !g_options.xclbin.empty() && SmartSSD::fpgaAvailable(g_options.xclbin, 0);
+
+    // One hardware thread is left to drive the FPGA path
+    uint32_t hw_threads = std::thread::hardware_concurrency();
+    uint32_t cpu_threads = g_options.threads;
+    if (cpu_threads == 0) cpu_threads = (fpga_available && hw_threads > 1) ? hw_threads - 1 : std::max(hw_threads, 1u);
+
+    HybridScheduler scheduler(operation, cpu_threads);
+    if (!g_options.hybrid_profile.empty()) scheduler.load(g_options.hybrid_profile);
+    HybridPlan plan = scheduler.plan(g_options.inputFileList, fpga_available);
+    for (uint32_t p = 0; p < PATH_COUNT; p++) {
+        std::cout << "\x1B[34m[Hybrid]\033[0m " << HybridScheduler::pathName((HybridPath)p) << " : "
+                  << plan.files[p].size() << " files, " << plan.bytes[p] << " B, " << std::fixed << std::setprecision(2)
+                  << scheduler.throughput((HybridPath)p) << " MB/s estimate, " << plan.seconds[p] << " s expected" << std::endl;
+    }
+
+    // Each path writes its own trace, the CPU one next to the FPGA one
+    std::string cpu_trace = g_options.trace;
+    if (!cpu_trace.empty() && !plan.files[PATH_FPGA].empty()) cpu_trace += ".cpu.json";
+
+    Metrics metrics[PATH_COUNT];
+    double seconds[PATH_COUNT] = {0, 0};
+    std::thread fpga_thread(runPath, PATH_FPGA, std::cref(plan.files[PATH_FPGA]), g_options.trace, cpu_threads,
+                            std::ref(metrics[PATH_FPGA]), std::ref(seconds[PATH_FPGA]));
+    runPath(PATH_CPU, plan.files[PATH_CPU], cpu_trace, cpu_threads, metrics[PATH_CPU], seconds[PATH_CPU]);
+    fpga_thread.join();
+
+    Metrics merged;
+    merged.setOperation(operation);
+    for (uint32_t p = 0; p < PATH_COUNT; p++) {
+        std::cout << "\x1B[34m[Hybrid]\033[0m " << HybridScheduler::pathName((HybridPath)p) << " took " << std::fixed
+                  << std::setprecision(3) << seconds[p] << " s" << std::endl;
+        scheduler.update((HybridPath)p, plan.bytes[p], seconds[p]);
+        merged.merge(metrics[p]);
+    }
+    double batch_seconds = std::max(seconds[PATH_FPGA], seconds[PATH_CPU]);
+    if (batch_seconds > 0) {
+        std::cout << "\x1B[34m[Hybrid]\033[0m Batch Throughput : " << std::fixed << std::setprecision(2)
+                  << (plan.bytes[PATH_FPGA] + plan.bytes[PATH_CPU]) / 1e6 / batch_seconds << " MB/s" << std::endl;
+    }
+    if (!g_options.hybrid_profile.empty()) scheduler.save(g_options.hybrid_profile);
+    exportMetrics(merged);
+}
+
 int main(int argc, char *argv[]) {
     namespace po = boost::program_options;
 
@@ -25,10 +266,37 @@ int main(int argc, char *argv[]) {
     po::positional_options_description g_pos; /* no positional options */
 
     desc.add_options()("help,h", "Show help")
-        ("xclbin", po::value<std::string>()->required(), "Kernel compression bin xclbin file")
+        ("xclbin", po::value<std::string>()->default_value(""), "Kernel compression bin xclbin file, not needed by the CPU backend")
         ("inputFileList", po::value<vector<string>>()->multitoken(), "input")
         ("compress", po::value<bool>()->default_value(true), "Number of memory to compress")
-        ("enable_p2p", po::value<bool>()->default_value(false), "Compress block size (KB)");
+        ("enable_p2p", po::value<bool>()->default_value(false), "Compress block size (KB)")
+        ("block_size", po::value<uint32_t>()->default_value(BLOCK_SIZE_IN_KB), "Compress block size (KB): 64, 256, 1024 or 4096, decompress reads it from the frame")
+        ("checksum", po::value<bool>()->default_value(true), "Compress with XXH32 block and content checksums, decompress verifies the ones a frame has")
+        ("block_index", po::value<bool>()->default_value(false), "Compress with a skippable frame holding the offset of every block, for random access")
+        ("batch", po::value<bool>()->default_value(false), "FPGA compress: one kernel invocation for all the files, which share one input and one output buffer, for many small files")
+        ("range_offset", po::value<uint64_t>()->default_value(0), "Decompress only from this byte of the content, with --range_length")
+        ("range_length", po::value<uint64_t>()->default_value(0), "Decompress only this many bytes into {file}.range, reading just the blocks that hold them (0: whole files)")
+        ("decompress_cu", po::value<uint32_t>()->default_value(DECOMPRESS_CU), "Number of decompress compute units")
+        ("metrics_json", po::value<std::string>()->default_value(""), "Append per-file and per-stage metrics as JSON lines to this file")
+        ("metrics_prom", po::value<std::string>()->default_value(""), "Write per-stage metrics in Prometheus text format to this file")
+        ("trace", po::value<std::string>()->default_value(""), "Write a Chrome trace (chrome://tracing) of host and device activity to this file")
+        ("backend", po::value<std::string>()->default_value("auto"), "fpga, cpu, hybrid (files split between both), or auto: the FPGA when the card is present and free, the CPU otherwise")
+        ("threads", po::value<uint32_t>()->default_value(CPU_THREADS), "CPU backend threads, 0 uses every hardware thread")
+        ("hybrid_profile", po::value<std::string>()->default_value(""), "File the hybrid backend loads its throughput estimates from and saves the measured ones to")
+        ("dict", po::value<std::string>()->default_value(""), "Preset dictionary: compress every block against it, decompress frames written with it")
+        ("train_dict", po::value<std::string>()->default_value(""), "Train a dictionary on the input files (one sample per file), write it to this file and exit")
+        ("dict_size", po::value<uint32_t>()->default_value(LZ4_DICT_DEFAULT_SIZE), "Size of the dictionary --train_dict builds (bytes, at most 64K)")
+        ("codec", po::value<std::string>()->default_value("lz4"), "Format: lz4 frames, or gzip ({file}.gz) / zlib ({file}.zz) members and snappy framing format streams ({file}.sz, 64 KB blocks) with the FPGA backend, for --compress=1 and 0")
+        ("filter", po::value<vector<string>>()->multitoken(), "Decompress only the records holding one of these literal patterns into {file}.match, filtered on the card (fpga backend, lz4 or snappy)")
+        ("filter_delimiter", po::value<std::string>()->default_value("\\n"), "Record delimiter of --filter and the zone map: one character, or \\n, \\t, \\r, \\0")
+        ("filter_output", po::value<std::string>()->default_value("records"), "What --filter writes: the matching records, the content offset of each as a uint64 LE (offsets), their --columns as int64 LE (columns) or a CSV of the count, sum, min and max of those (aggregate)")
+        ("columns", po::value<vector<uint32_t>>()->multitoken(), "Field indices (from 0) --filter_output=columns and aggregate read as integers, of the records --filter matches or of all records without --filter")
+        ("field_delimiter", po::value<std::string>()->default_value(","), "Field delimiter of --columns and --zone_column: one character, or \\n, \\t, \\r, \\0")
+        ("zone_column", po::value<uint32_t>(), "Compress with a zone map frame holding the record count and the min and max of this field (from 0) of the records of every block, read as an integer")
+        ("zone_offset", po::value<uint32_t>(), "Same as --zone_column for a fixed width field at this byte of the record, with --zone_width")
+        ("zone_width", po::value<uint32_t>(), "Bytes of the --zone_offset field")
+        ("zone_min", po::value<int64_t>(), "Decompress only the records whose zone map field is at least this into {file}.match, reading just the blocks whose zone map allows it")
+        ("zone_max", po::value<int64_t>(), "Same as --zone_min for at most this");
 
     po::variables_map vm;
     po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -53,42 +321,204 @@ int main(int argc, char *argv[]) {
     g_options.xclbin = vm["xclbin"].as<string>();
     g_options.compress = vm["compress"].as<bool>();
     g_options.enable_p2p = vm["enable_p2p"].as<bool>();
-    
+    g_options.block_size = vm["block_size"].as<uint32_t>();
+    g_options.checksum = vm["checksum"].as<bool>();
+    g_options.block_index = vm["block_index"].as<bool>();
+    g_options.batch = vm["batch"].as<bool>();
+    g_options.range_offset = vm["range_offset"].as<uint64_t>();
+    g_options.range_length = vm["range_length"].as<uint64_t>();
+    g_options.decompress_cu = vm["decompress_cu"].as<uint32_t>();
+    g_options.metrics_json = vm["metrics_json"].as<string>();
+    g_options.metrics_prom = vm["metrics_prom"].as<string>();
+    g_options.trace = vm["trace"].as<string>();
+    g_options.backend = vm["backend"].as<string>();
+    g_options.threads = vm["threads"].as<uint32_t>();
+    g_options.hybrid_profile = vm["hybrid_profile"].as<string>();
+    g_options.dict = vm["dict"].as<string>();
+    g_options.train_dict = vm["train_dict"].as<string>();
+    g_options.dict_size = vm["dict_size"].as<uint32_t>();
+    g_options.codec = vm["codec"].as<string>();
+    if (vm.count("filter")) g_options.filter = vm["filter"].as<vector<string> >();
+    g_options.filter_delimiter = vm["filter_delimiter"].as<string>();
+    g_options.filter_output = vm["filter_output"].as<string>();
+    if (vm.count("columns")) g_options.columns = vm["columns"].as<vector<uint32_t> >();
+    g_options.field_delimiter = vm["field_delimiter"].as<string>();
+    g_options.zone_query = vm.count("zone_min") || vm.count("zone_max");
+    g_options.zone_min = vm.count("zone_min") ? vm["zone_min"].as<int64_t>() : INT64_MIN;
+    g_options.zone_max = vm.count("zone_max") ? vm["zone_max"].as<int64_t>() : INT64_MAX;
+
+    if (g_options.block_size != 64 && g_options.block_size != 256 && g_options.block_size != 1024 && g_options.block_size != 4096) {
+        std::cout << "Block size should be 64, 256, 1024 or 4096 KB, got " << g_options.block_size << std::endl;
+        return -1;
+    }
+
+    if (!g_options.train_dict.empty()) {
+        if (g_options.dict_size == 0 || g_options.dict_size > LZ4_DICT_MAX_SIZE) {
+            std::cout << "Dictionary size should be 1 ~ " << LZ4_DICT_MAX_SIZE << " B, got " << g_options.dict_size << std::endl;
+            return -1;
+        }
+        trainDictionary(g_options.inputFileList);
+        return 0;
+    }
+    if (!g_options.dict.empty()) lz4LoadDictionary(g_options.dict, g_dict);
+
+    if (g_options.codec == "gzip") {
+        g_codec = CODEC_GZIP;
+    } else if (g_options.codec == "zlib") {
+        g_codec = CODEC_ZLIB;
+    } else if (g_options.codec == "snappy") {
+        g_codec = CODEC_SNAPPY;
+    } else if (g_options.codec != "lz4") {
+        std::cout << "Unknown codec " << g_options.codec << ", expected lz4, gzip, zlib or snappy" << std::endl;
+        return -1;
+    }
+    // The GZIP kernels and Snappy streams carry no block index or dictionary, and are decompressed from their start
+    if (g_codec != CODEC_LZ4 &&
+        (g_options.backend != "fpga" || g_options.block_index || !g_dict.empty() || g_options.range_length)) {
+        std::cout << "--codec=" << g_options.codec << " needs the fpga backend and no --block_index, --dict or --range_length" << std::endl;
+        return -1;
+    }
+    // Snappy data chunks hold 64 KB at most
+    if (g_codec == CODEC_SNAPPY && g_options.block_size != BLOCK_SIZE_IN_KB) {
+        std::cout << "--codec=snappy takes 64 KB blocks, got --block_size=" << g_options.block_size << std::endl;
+        return -1;
+    }
+
+    if (g_options.range_length && (g_options.compress || g_options.backend == "hybrid")) {
+        std::cout << "--range_length needs --compress=0 and the fpga, cpu or auto backend" << std::endl;
+        return -1;
+    }
+
+    uint8_t filter_delimiter = '\n';
+    uint8_t field_delimiter = ',';
+    if (!parseDelimiter(g_options.filter_delimiter, filter_delimiter)) {
+        std::cout << "Unknown --filter_delimiter " << g_options.filter_delimiter << ", expected one character or \\n, \\t, \\r, \\0" << std::endl;
+        return -1;
+    }
+    if (!parseDelimiter(g_options.field_delimiter, field_delimiter)) {
+        std::cout << "Unknown --field_delimiter " << g_options.field_delimiter << ", expected one character or \\n, \\t, \\r, \\0" << std::endl;
+        return -1;
+    }
+
+    // The zone maps are computed by xilLz4Compress as it compresses, the records are read back through readRange()
+    if (vm.count("zone_column") || vm.count("zone_offset") || vm.count("zone_width")) {
+        if (vm.count("zone_column") == vm.count("zone_offset") || vm.count("zone_offset") != vm.count("zone_width") ||
+            (vm.count("zone_width") && vm["zone_width"].as<uint32_t>() == 0)) {
+            std::cout << "The zone map takes --zone_column, or --zone_offset with a non-zero --zone_width" << std::endl;
+            return -1;
+        }
+        if (!g_options.compress || g_codec != CODEC_LZ4) {
+            std::cout << "--zone_column and --zone_offset need --compress=1 and --codec=lz4" << std::endl;
+            return -1;
+        }
+        g_zoneMap = true;
+        g_zoneConfig.delimiter = filter_delimiter;
+        g_zoneConfig.fieldDelimiter = field_delimiter;
+        if (vm.count("zone_column")) {
+            g_zoneConfig.layout = ZONE_FIELD_DELIMITED;
+            g_zoneConfig.column = vm["zone_column"].as<uint32_t>();
+        } else {
+            g_zoneConfig.layout = ZONE_FIELD_FIXED;
+            g_zoneConfig.offset = vm["zone_offset"].as<uint32_t>();
+            g_zoneConfig.width = vm["zone_width"].as<uint32_t>();
+        }
+    }
+    if (g_options.zone_query) {
+        if (g_options.compress || g_options.backend == "hybrid" || g_codec != CODEC_LZ4 || g_options.range_length ||
+            !g_options.filter.empty() || !g_options.columns.empty()) {
+            std::cout << "--zone_min and --zone_max need --compress=0, the fpga, cpu or auto backend, --codec=lz4 and no --range_length, --filter or --columns" << std::endl;
+            return -1;
+        }
+        if (g_options.zone_min > g_options.zone_max) {
+            std::cout << "--zone_min should not be above --zone_max" << std::endl;
+            return -1;
+        }
+    }
+
+    // The records are filtered by xilLz4P2PDecompress as it decompresses
+    uint32_t filter_mode = FILTER_NONE;
+    if (!g_options.filter.empty() || !g_options.columns.empty()) {
+        if (g_options.compress || g_options.backend != "fpga" || g_options.range_length ||
+            (g_codec != CODEC_LZ4 && g_codec != CODEC_SNAPPY)) {
+            std::cout << "--filter and --columns need --compress=0, the fpga backend, --codec=lz4 or snappy and no --range_length" << std::endl;
+            return -1;
+        }
+        if (g_options.filter_output == "records") {
+            filter_mode = FILTER_RECORDS;
+        } else if (g_options.filter_output == "offsets") {
+            filter_mode = FILTER_OFFSETS;
+        } else if (g_options.filter_output == "columns") {
+            filter_mode = FILTER_COLUMNS;
+        } else if (g_options.filter_output == "aggregate") {
+            filter_mode = FILTER_AGGREGATE;
+        } else {
+            std::cout << "Unknown --filter_output " << g_options.filter_output << ", expected records, offsets, columns or aggregate" << std::endl;
+            return -1;
+        }
+        bool project = (filter_mode == FILTER_COLUMNS || filter_mode == FILTER_AGGREGATE);
+        if (project != !g_options.columns.empty()) {
+            std::cout << "--columns goes with --filter_output=columns or aggregate, and they need it" << std::endl;
+            return -1;
+        }
+    }
+
+    if (g_options.backend == "hybrid") {
+        runHybrid();
+        return 0;
+    }
+
+    bool use_fpga = false;
+    if (g_options.backend == "fpga") {
+        use_fpga = true;
+    } else if (g_options.backend == "auto") {
+        use_fpga = SmartSSD::fpgaAvailable(g_options.xclbin, 0);
+        if (use_fpga == false) std::cout << "FPGA not available, using the CPU backend" << std::endl;
+    } else if (g_options.backend != "cpu") {
+        std::cout << "Unknown backend " << g_options.backend << ", expected fpga, cpu, hybrid or auto" << std::endl;
+        return -1;
+    }
+
+    if (use_fpga && g_options.xclbin.empty()) {
+        std::cout << "The FPGA backend needs --xclbin" << std::endl;
+        return -1;
+    }
+
     if (g_options.compress == true)
     {
-        Compress compressModule(g_options.xclbin, 0, g_options.enable_p2p, BLOCK_SIZE_IN_KB);
-        compressModule.SetInputFileList(g_options.inputFileList);
-        compressModule.MakeOutputFileList(g_options.inputFileList);
-        compressModule.OpenInputFiles();
-        compressModule.OpenOutputFiles();
-        compressModule.SetOutputFileSize();
-
-        compressModule.initBuffer();
-        compressModule.readFile();
-        compressModule.preProcess();
-        compressModule.run();
-        compressModule.postProcess();
-        compressModule.writeFile();
-        compressModule.CloseInputFiles();
-        compressModule.CloseOutputFiles();
+        if (use_fpga) {
+            Compress compressModule(g_options.xclbin, 0, g_options.enable_p2p, g_options.block_size, g_options.checksum, g_options.block_index, g_options.batch, g_codec);
+            compressFiles(compressModule, g_options.inputFileList, g_options.trace);
+            exportMetrics(compressModule.metrics());
+        } else {
+            CpuCompress compressModule(g_options.enable_p2p, g_options.block_size, g_options.threads, g_options.checksum, g_options.block_index);
+            compressFiles(compressModule, g_options.inputFileList, g_options.trace);
+            exportMetrics(compressModule.metrics());
+        }
     }
     else
     {
-        Decompress decompressModule(g_options.xclbin, 0, g_options.enable_p2p);
-        decompressModule.SetInputFileList(g_options.inputFileList);
-        decompressModule.MakeOutputFileList(g_options.inputFileList);
-        decompressModule.OpenInputFiles();
-        decompressModule.OpenOutputFiles();
-
-        decompressModule.initBuffer();
-        decompressModule.readFile();
-        decompressModule.preProcess();
-        decompressModule.run();
-        decompressModule.postProcess();
-        decompressModule.writeFile();
-        decompressModule.CloseInputFiles();
-        decompressModule.CloseOutputFiles();
-        //xil_decompress_file(g_options.inputFileList, g_options.xclbin, g_options.enable_p2p, 58);
+        if (use_fpga) {
+            Decompress decompressModule(g_options.xclbin, 0, g_options.enable_p2p, g_options.decompress_cu, g_codec);
+            if (filter_mode != FILTER_NONE) decompressModule.setFilter(g_options.filter, filter_delimiter, filter_mode, g_options.columns, field_delimiter);
+            if (g_options.zone_query) {
+                readZones(decompressModule, g_options.inputFileList, g_options.trace);
+            } else if (g_options.range_length) {
+                readRanges(decompressModule, g_options.inputFileList, g_options.trace);
+            } else {
+                decompressFiles(decompressModule, g_options.inputFileList, g_options.trace);
+            }
+            exportMetrics(decompressModule.metrics());
+        } else {
+            CpuDecompress decompressModule(g_options.enable_p2p, g_options.threads);
+            if (g_options.zone_query) {
+                readZones(decompressModule, g_options.inputFileList, g_options.trace);
+            } else if (g_options.range_length) {
+                readRanges(decompressModule, g_options.inputFileList, g_options.trace);
+            } else {
+                decompressFiles(decompressModule, g_options.inputFileList, g_options.trace);
+            }
+            exportMetrics(decompressModule.metrics());
+        }
     }
     return 0;
 }
@@ -1,11 +1,33 @@
+#ifndef _XFCOMPRESSION_SMARTSSD_HPP_
+#define _XFCOMPRESSION_SMARTSSD_HPP_
 
 #include <defns.h>
+#include "metrics.hpp"
+#include "tracer.hpp"
+#ifdef KERNEL_STATS
+#include "../../kernel/include/lz4_p2p.hpp"
+#endif
 #define _DEBUG  (0)
+
+// Formats of the FPGA backend: LZ4 frames and Snappy framing format streams
+// (xilLz4Compress + xilLz4Packer, xilLz4Unpacker + xilLz4P2PDecompress), or
+// gzip members / zlib streams (xilGzipCompress + xilGzipPacker, xilGzipDecompress)
+enum compressCodec { CODEC_LZ4, CODEC_GZIP, CODEC_ZLIB, CODEC_SNAPPY };
+
+// The codec runs on the Deflate kernels
+inline bool deflateCodec(compressCodec codec)
+{
+    return codec == CODEC_GZIP || codec == CODEC_ZLIB;
+}
+
 class SmartSSD {
     public:
         SmartSSD(const std::string& binaryFile, uint8_t device_id, bool p2p_enable);
         ~SmartSSD();
 
+        // True when device_id exists and the xclbin loads on it, false for a missing or busy card
+        static bool fpgaAvailable(const std::string& binaryFile, uint8_t device_id);
+
         void SetInputFileList (const std::vector<std::string>& inputFile);
         void SetOutputFileList (const std::vector<std::string>& outputFile);
         void OpenInputFiles();
@@ -20,7 +42,17 @@ class SmartSSD {
         virtual void preProcess();
         virtual void run();
         virtual void postProcess();
+
+        // Per-file and per-stage timings of this run
+        Metrics& metrics() { return m_metrics; }
+        // Chrome trace of this run, enable it before opening the files
+        Tracer& tracer() { return m_tracer; }
+        // Preset dictionary of every block (lz4_dict.hpp), set before preProcess(); empty for none
+        void setDictionary(const std::vector<uint8_t>& dict);
     protected:
+        // Host-only backends: no OpenCL context, initBuffer() allocates plain host buffers
+        SmartSSD(bool p2p_enable);
+
         uint32_t get_file_size(std::string filename) {
             std::ifstream file(filename.c_str(), std::ifstream::binary);
             if (!file) {
@@ -34,6 +66,14 @@ class SmartSSD {
             return file_size;
         }
 
+#ifdef KERNEL_STATS
+        // Prints the stats record a kernel wrote for one invocation
+        void printKernelStats(const std::string& kernel_name, const std::string& file_name, const dt_kernelStats* stats);
+#endif
+
+        // Device copy of m_dict for the kernels' dictionary argument, one 64 byte word when there is none
+        cl::Buffer* dictBuffer();
+
         cl::Program* m_program;
         cl::Context* m_context;
         cl::CommandQueue* m_q;
@@ -47,14 +87,37 @@ class SmartSSD {
         std::vector<std::string> m_OutputFileNameVec;
         std::vector<int> m_OutputFileDescVec;
         std::vector<uint32_t> outputFileSizeVec;
+        // Length writeFile() cuts each output file to when its content ends inside the last page written,
+        // files without an entry (or UINT64_MAX) keep whole pages
+        std::vector<uint64_t> m_OutputLengthVec;
         
         std::vector<cl::Buffer*> m_InputCLBufVec;
         std::vector<cl::Buffer*> m_OutputCLBufVec;
         
         std::vector<uint8_t*> m_InputHostMappedBufVec;
         std::vector<uint8_t*> m_OutputHostMappedBufVec;
+
+        // Set before initBuffer() to place every file in one input and one output buffer:
+        // m_InputCLBufVec / m_OutputCLBufVec then hold that single buffer, the host
+        // mapped pointers point into it and the offsets locate each file (4K aligned)
+        bool m_sharedBuffers;
+        std::vector<uint64_t> m_InputOffsetVec;
+        std::vector<uint64_t> m_OutputOffsetVec;
+
+        // Preset dictionary and its ID in the frame header, 0 without one
+        std::vector<uint8_t> m_dict;
+        uint32_t m_dictId;
+
+        Metrics m_metrics;
+        Tracer m_tracer;
         
     private:
+        // Allocates an input and an output buffer and appends them to the buffer vectors
+        void allocBuffers(size_t input_size, size_t output_size);
+
+        uint8_t* m_dictHostBuf;
+        cl::Buffer* m_dictCLBuf;
+
         std::chrono::duration<double, std::nano> m_input_file_open_time;
         std::chrono::duration<double, std::nano> m_output_file_open_time;
         std::chrono::duration<double, std::nano> m_ssd_read_time;
@@ -62,4 +125,6 @@ class SmartSSD {
         
         uint32_t m_input_file_size;
         uint32_t m_output_file_size;
-};
\ No newline at end of file
+};
+
+#endif // _XFCOMPRESSION_SMARTSSD_HPP_
@@ -0,0 +1,88 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_HYBRID_HPP_
+#define _XFCOMPRESSION_HYBRID_HPP_
+
+/**
+ * @file hybrid.hpp
+ * @brief Splits one batch of files between the FPGA and the CPU backend.
+ *
+ * Files below HYBRID_SMALL_FILE_KB go to the CPU, they would mostly pay the
+ * kernel launch and the 4K padding. The others are taken largest first and
+ * each goes to the path that finishes it earliest, given the bytes already
+ * queued on that path, its throughput estimate and, for the FPGA, the launch
+ * cost per file. Both paths then run at the same time, so the batch gets
+ * the sum of both throughputs. The estimates start from the defaults below
+ * and follow the measured runs (update(), load() / save()).
+ */
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Throughput estimates (MB/s) used until a run was measured
+#ifndef HYBRID_FPGA_MBPS
+#define HYBRID_FPGA_MBPS 2000
+#endif
+#ifndef HYBRID_CPU_MBPS_PER_THREAD
+#define HYBRID_CPU_MBPS_PER_THREAD 400
+#endif
+// Kernel launch and 4K padding cost of one file on the FPGA (us)
+#ifndef HYBRID_FPGA_LAUNCH_US
+#define HYBRID_FPGA_LAUNCH_US 500
+#endif
+// Files below this size always go to the CPU
+#ifndef HYBRID_SMALL_FILE_KB
+#define HYBRID_SMALL_FILE_KB 256
+#endif
+
+enum HybridPath {
+    PATH_FPGA = 0,
+    PATH_CPU,
+    PATH_COUNT
+};
+
+struct HybridPlan {
+    std::vector<std::string> files[PATH_COUNT];
+    uint64_t bytes[PATH_COUNT];
+    // Expected time of each path (s), the batch takes the larger one
+    double seconds[PATH_COUNT];
+};
+
+class HybridScheduler {
+    public:
+    // operation keys the estimates in the profile file ("compress", "decompress")
+    HybridScheduler(const std::string& operation, uint32_t cpu_threads);
+
+    // Routes every file, all of them to the CPU when the FPGA is not available
+    HybridPlan plan(const std::vector<std::string>& files, bool fpga_available) const;
+    // Moves the estimate of a path halfway to the throughput of a measured run
+    void update(HybridPath path, uint64_t bytes, double seconds);
+    double throughput(HybridPath path) const { return m_mbps[path]; }
+
+    // Profile lines are "<operation> <fpga|cpu> <MB/s>", lines of other operations are kept on save
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+
+    static const char* pathName(HybridPath path);
+
+    private:
+    std::string m_operation;
+    double m_mbps[PATH_COUNT];
+};
+
+#endif // _XFCOMPRESSION_HYBRID_HPP_
@@ -0,0 +1,51 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_LZ4_BLOCK_HPP_
+#define _XFCOMPRESSION_LZ4_BLOCK_HPP_
+
+#include <stdint.h>
+
+/**
+ * LZ4 block codec of the CPU backend, the same block format the kernels
+ * write (LZ4 block spec, 4 byte min match, 64K window).
+ *
+ * The compressor is a single hash-table greedy matcher. Match extension and
+ * the literal / match copies compare and move 16 bytes at a time with SSE2
+ * (32 with AVX2) and fall back to 8 byte words elsewhere.
+ */
+
+// Worst case compressed size of a block of size bytes
+#define LZ4_BLOCK_BOUND(size) ((size) + (size) / 255 + 16)
+
+// Compresses one block into dst, returns the compressed size or 0 when it does not fit in capacity.
+// The prefix bytes before src are history matches can reach into.
+uint32_t lz4CompressBlock(const uint8_t* src, uint32_t size, uint8_t* dst, uint32_t capacity, uint32_t prefix = 0);
+
+// Entropy estimate of a block in bits per byte (8.8 fixed point), sampled as xilLz4Compress does
+uint32_t lz4BlockEntropy(const uint8_t* src, uint32_t size);
+
+// Decompresses one block into dst, returns the decompressed size or -1 on a malformed block.
+// Matches may reach the prefix bytes before dst.
+int32_t lz4DecompressBlock(const uint8_t* src, uint32_t size, uint8_t* dst, uint32_t capacity, uint32_t prefix = 0);
+
+// The same with a preset dictionary (lz4_dict.hpp) as the history of the block, dict_size at most 64 KB
+uint32_t lz4CompressBlockDict(const uint8_t* dict, uint32_t dict_size, const uint8_t* src, uint32_t size, uint8_t* dst,
+                              uint32_t capacity);
+int32_t lz4DecompressBlockDict(const uint8_t* dict, uint32_t dict_size, const uint8_t* src, uint32_t size, uint8_t* dst,
+                               uint32_t capacity);
+
+#endif // _XFCOMPRESSION_LZ4_BLOCK_HPP_
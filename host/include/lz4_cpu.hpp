@@ -0,0 +1,129 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_LZ4_CPU_HPP_
+#define _XFCOMPRESSION_LZ4_CPU_HPP_
+
+/**
+ * @file lz4_cpu.hpp
+ * @brief LZ4 CPU backend.
+ *
+ * CpuCompress and CpuDecompress run the same file pipeline as Compress and
+ * Decompress (initBuffer, readFile, preProcess, run, postProcess,
+ * writeFile) without a card. Blocks of all files are spread over a pool of
+ * threads and the frames are identical in layout to the kernel output: the
+ * header of lz4FrameHeader(), independent blocks, stored blocks with bit 31
+ * of the size set, the XXH32 block and content checksums when enabled, the
+ * end mark, the block index and zone map frames when enabled and zero
+ * padding up to 4K.
+ * With setDictionary() every block is compressed against the dictionary and
+ * the header carries its ID.
+ */
+
+#include "SmartSSD.hpp"
+#include "lz4_frame.hpp"
+#include "lz4_p2p_comp.hpp"
+#include "zone_map.hpp"
+
+// Worker threads of the CPU backend, 0 uses every hardware thread
+#ifndef CPU_THREADS
+#define CPU_THREADS 0
+#endif
+
+// One block of one file, with its start and end time for the per-file spans
+struct cpuBlock {
+    uint32_t fid;
+    uint64_t srcOffset;
+    uint32_t srcSize;
+    uint64_t dstOffset;
+    uint32_t dstSize;
+    bool stored;
+    std::chrono::high_resolution_clock::time_point start;
+    std::chrono::high_resolution_clock::time_point end;
+};
+
+class CpuCompress : public SmartSSD {
+    public:
+    CpuCompress(bool p2p_enable, uint32_t block_kb, uint32_t num_threads = CPU_THREADS, bool checksum = true,
+                bool block_index = false);
+    ~CpuCompress();
+
+    // Same as Compress::setZoneMap(), the zone maps are computed on the thread pool
+    void setZoneMap(const dt_zoneConfig& config);
+
+    void MakeOutputFileList(const std::vector<std::string>& inputFile);
+    // Sizes the output buffers for the worst case, every block stored
+    void SetOutputFileSize();
+
+    virtual void preProcess();
+    virtual void run();
+    virtual void postProcess();
+private:
+    uint32_t m_BlockSizeInKb;
+    uint32_t m_numThreads;
+    bool m_checksum;
+    bool m_blockIndex;
+    bool m_zoneMap;
+    dt_zoneConfig m_zoneConfig;
+
+    std::vector<uint32_t> headerSizeVec;
+    std::vector<uint32_t> compressedSizeVec;
+    std::vector<uint32_t> contentChecksumVec;
+    std::vector<std::vector<lz4BlockIndexEntry> > blockIndexVec;
+    std::vector<std::vector<lz4ZoneEntry> > zoneMapVec;
+    std::vector<uint32_t> firstBlockVec;
+    std::vector<cpuBlock> m_blocks;
+    // Zone map of every block as the kernel computes it, with m_zoneMap
+    std::vector<dt_zoneMap> m_zones;
+    // Compressed blocks before they are packed into the frames
+    uint8_t* m_scratch;
+
+    std::chrono::duration<double, std::nano> m_compression_time;
+};
+
+class CpuDecompress : public SmartSSD {
+    public:
+    CpuDecompress(bool p2p_enable, uint32_t num_threads = CPU_THREADS);
+    ~CpuDecompress();
+
+    // Takes the original size from the content size field of every frame header
+    void MakeOutputFileList(const std::vector<std::string>& inputFile);
+
+    virtual void preProcess();
+    virtual void run();
+    virtual void postProcess();
+
+    // Same as Decompress::readRange(): reads and decompresses only the blocks covering
+    // [offset, offset + length) of the content of file, on the thread pool
+    bool readRange(const std::string& file, uint64_t offset, uint64_t length, std::vector<uint8_t>& out);
+private:
+    uint32_t m_numThreads;
+
+    std::vector<uint32_t> headerSizeVec;
+    std::vector<uint32_t> blockSizeVec;
+    std::vector<uint64_t> contentSizeVec;
+    std::vector<bool> blockChecksumVec;
+    std::vector<bool> contentChecksumVec;
+    // Frames written with the preset dictionary (FLG_DICT_ID)
+    std::vector<bool> dictVec;
+    // Where the content checksum of every frame is, after its end mark
+    std::vector<uint64_t> contentChecksumOffsetVec;
+    std::vector<cpuBlock> m_blocks;
+
+    std::chrono::duration<double, std::nano> m_decompression_time;
+};
+
+#endif // _XFCOMPRESSION_LZ4_CPU_HPP_
@@ -0,0 +1,67 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_LZ4_DICT_HPP_
+#define _XFCOMPRESSION_LZ4_DICT_HPP_
+
+/**
+ * @file lz4_dict.hpp
+ * @brief Preset dictionaries for LZ4 frames of small records.
+ *
+ * Every block of a frame written with a dictionary starts with the
+ * dictionary as its history, so matches of the first bytes can reach into
+ * it. The frame header carries the dictionary ID (FLG_DICT_ID), here the
+ * XXH32 of the dictionary, and decompressing needs the same dictionary:
+ * `lz4 -d -D {dict}` reads these frames. Only the last 64 KB of a
+ * dictionary are in reach of a match, longer files are cut as `lz4 -D` does.
+ *
+ * lz4TrainDictionary() builds a dictionary from sample records with a
+ * simplified COVER selection: the 8 byte strings (dmers) of the samples are
+ * counted once per sample, the corpus is cut into one epoch per segment of
+ * the dictionary and each epoch gives the 256 byte segment whose dmers are
+ * common across the samples and not yet covered. Later segments land in
+ * front of earlier ones, so the most useful ones get the shortest offsets.
+ */
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "lz4_frame.hpp"
+
+// Bytes of a dictionary matches can reach (LZ4 window)
+#define LZ4_DICT_MAX_SIZE (64 * 1024)
+// Size lz4TrainDictionary() aims for when not told otherwise
+#define LZ4_DICT_DEFAULT_SIZE (16 * 1024)
+
+// Dictionary of at most dict_size bytes for records like samples; smaller
+// when the samples hold less, the whole corpus when it fits.
+std::vector<uint8_t> lz4TrainDictionary(const std::vector<std::vector<uint8_t> >& samples, uint32_t dict_size);
+
+// Dictionary ID written in the frame header, XXH32 of the dictionary
+uint32_t lz4DictionaryId(const std::vector<uint8_t>& dict);
+
+// Reads the dictionary in file, its last LZ4_DICT_MAX_SIZE bytes. Prints the
+// reason and exits when file cannot be read or is empty.
+void lz4LoadDictionary(const std::string& file, std::vector<uint8_t>& dict);
+void lz4SaveDictionary(const std::string& file, const std::vector<uint8_t>& dict);
+
+// Checks that dict is the dictionary the frame in file was written with.
+// Prints the reason and exits when the frame names a dictionary and dict is
+// empty or has another ID. Frames without FLG_DICT_ID pass with any dict,
+// they are decompressed without it.
+void lz4CheckDictionary(const std::string& file, const lz4FrameInfo& info, const std::vector<uint8_t>& dict);
+
+#endif // _XFCOMPRESSION_LZ4_DICT_HPP_
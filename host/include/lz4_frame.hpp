@@ -0,0 +1,129 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_LZ4_FRAME_HPP_
+#define _XFCOMPRESSION_LZ4_FRAME_HPP_
+
+/**
+ * @file lz4_frame.hpp
+ * @brief LZ4 frame header parsing shared by the decompressors.
+ *
+ * The block size of a frame comes from its BD byte, so frames written with
+ * any of the 64 KB / 256 KB / 1 MB / 4 MB block sizes decompress without
+ * being told which one was used. lz4FindBlockRange() maps a byte range of
+ * the content to the compressed blocks that hold it, for range reads.
+ * The block index and zone map frames follow the LZ4 frame, in that order,
+ * before the zero padding of the file.
+ */
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "../../kernel/include/lz4_p2p.hpp"
+
+#define LZ4_MAGIC 0x184D2204
+// Magic, FLG, BD, content size, dictionary ID and header checksum
+#define MAX_HEADER_SIZE 19
+// XXH32 after a block (FLG_BLOCK_CHECKSUM) or after the end mark (FLG_CONTENT_CHECKSUM)
+#define CHECKSUM_SIZE 4
+
+// FLG bits of the frame descriptor
+#define FLG_VERSION_MASK 0xC0
+#define FLG_VERSION 0x40
+#define FLG_BLOCK_INDEPENDENT 0x20
+#define FLG_BLOCK_CHECKSUM 0x10
+#define FLG_CONTENT_SIZE 0x08
+#define FLG_CONTENT_CHECKSUM 0x04
+#define FLG_DICT_ID 0x01
+
+// Skippable frame after the LZ4 frame with the offsets of every block, the
+// same layout xilLz4Packer writes (kernel/include/lz4_packer.hpp): magic,
+// frame size, one entry per block, block count and BLOCK_INDEX_MAGIC, LE32.
+#define BLOCK_INDEX_FRAME_MAGIC 0x184D2A5E
+#define BLOCK_INDEX_MAGIC 0x8F92EAB1
+#define BLOCK_INDEX_SIZE(num_blocks) (16 + 8 * (uint64_t)(num_blocks))
+
+struct lz4BlockIndexEntry {
+    uint32_t compressedOffset; // block size field of the block, from the start of the frame
+    uint32_t contentOffset;    // first byte of the block in the uncompressed content
+};
+
+// Skippable frame after the block index (after the LZ4 frame without one)
+// with the zone map of every block (zone_map.hpp): magic, frame size, the
+// layout, delimiter, field delimiter, column, offset and width of the
+// dt_zoneConfig, one entry per block, block count and ZONE_MAP_MAGIC, LE.
+#define ZONE_MAP_FRAME_MAGIC 0x184D2A5D
+#define ZONE_MAP_MAGIC 0x8F92EAB2
+#define ZONE_MAP_SIZE(num_blocks) (40 + 28 * (uint64_t)(num_blocks))
+
+struct lz4ZoneEntry {
+    int64_t min;      // of the values of the records that start in the block, only set with values
+    int64_t max;
+    uint32_t records; // records that start in the block
+    uint32_t values;  // of them, the ones the field has a value in
+    uint32_t first;   // offset of the first of them in the block, the block size without one
+};
+
+// Run of blocks of a frame that covers a byte range of its content, see lz4FindBlockRange()
+struct lz4BlockRange {
+    uint32_t firstBlock;       // number of the first block of the run
+    uint32_t numBlocks;
+    uint64_t compressedOffset; // block size field of the first block, from the start of the file
+    uint64_t compressedSize;   // up to the end of the last block and its checksum
+    uint64_t contentOffset;    // first byte of the first block in the content
+    uint64_t contentSize;      // bytes the run decompresses to
+};
+
+struct lz4FrameInfo {
+    uint8_t flags;        // FLG byte
+    uint32_t headerSize;  // magic up to and including the header checksum
+    uint32_t blockSize;   // maximum block size in bytes
+    uint64_t contentSize; // 0 without FLG_CONTENT_SIZE
+    uint32_t dictId;      // 0 without FLG_DICT_ID
+};
+
+// Reads and checks the header of the frame in file: magic, version, block
+// size code and header checksum. Prints the reason and exits when file is
+// not an LZ4 frame.
+void lz4ReadFrameHeader(const std::string& file, lz4FrameInfo& info);
+
+// Reads the block index frame of file, the last frame before the zero
+// padding or the one before the zone map frame. Returns false when file has
+// none.
+bool lz4ReadBlockIndex(const std::string& file, std::vector<lz4BlockIndexEntry>& index);
+
+// Finds the blocks of the frame in file that cover [offset, offset + length)
+// of its content, clamped to the content size. The block index frame gives
+// where they are when file has one, otherwise the block size fields are
+// walked from the header. The frame needs independent blocks and the
+// content size. Returns false when the range is empty or past the content.
+bool lz4FindBlockRange(const std::string& file,
+                       const lz4FrameInfo& info,
+                       uint64_t offset,
+                       uint64_t length,
+                       lz4BlockRange& range);
+
+// Writes the block index frame of index to out and returns its size, BLOCK_INDEX_SIZE(index.size())
+size_t lz4WriteBlockIndex(uint8_t* out, const std::vector<lz4BlockIndexEntry>& index);
+
+// Reads the zone map frame that ends file, before the zero padding after
+// it. Returns false when file has none.
+bool lz4ReadZoneMap(const std::string& file, dt_zoneConfig& config, std::vector<lz4ZoneEntry>& zones);
+
+// Writes the zone map frame of config and zones to out and returns its size, ZONE_MAP_SIZE(zones.size())
+size_t lz4WriteZoneMap(uint8_t* out, const dt_zoneConfig& config, const std::vector<lz4ZoneEntry>& zones);
+
+#endif // _XFCOMPRESSION_LZ4_FRAME_HPP_
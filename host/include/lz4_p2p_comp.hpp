@@ -19,6 +19,9 @@
 
 #pragma once
 #include "defns.h"
+#include "../../kernel/include/lz_entropy.hpp"
+#include "../../kernel/include/lz4_p2p.hpp"
+#include "zone_map.hpp"
 
 // Maximum compute units supported
 #define MAX_COMPUTE_UNITS 2
@@ -67,34 +70,97 @@
 #define BSIZE_NCOMP_1024 16
 #define BSIZE_NCOMP_4096 64
 
+// Header bytes xilGzipPacker starts a gzip member / zlib stream with
+#define GZIP_HEADER_SIZE 10
+#define ZLIB_HEADER_SIZE 2
+
 int validate(std::string& inFile_name, std::string& outFile_name);
 
+// Writes the LZ4 frame header every backend emits (FLG_BYTE, block size code,
+// content size, header checksum) and returns its size. With checksum the FLG
+// byte announces an XXH32 after every block and after the end mark. A
+// non-zero dict_id is recorded as the dictionary ID (FLG_DICT_ID), 4 more bytes.
+size_t lz4FrameHeader(uint8_t* h_header, uint32_t block_kb, uint32_t inSize, bool checksum, uint32_t dict_id = 0);
+
 class Compress : public SmartSSD {
     public:
-    Compress(const std::string& binaryFile, uint8_t device_id, bool p2p_enable, uint32_t block_kb);
+    // checksum: xilLz4Packer writes block checksums and xilLz4Compress the content checksum
+    // block_index: xilLz4Packer appends the block index frame (lz4ReadBlockIndex())
+    // batch: one xilLz4Compress + xilLz4Packer invocation for all the files, which share one input and one
+    // output buffer, instead of one per file
+    // codec: CODEC_GZIP / CODEC_ZLIB write {file}.gz / {file}.zz with the GZIP kernels, which always carry their
+    // CRC32 / Adler32 and take no block index or dictionary. CODEC_SNAPPY writes {file}.sz, a Snappy framing
+    // format stream, with the LZ4 kernels: 64 KB blocks with a CRC32C each, no block index or dictionary
+    Compress(const std::string& binaryFile, uint8_t device_id, bool p2p_enable, uint32_t block_kb, bool checksum = true,
+             bool block_index = false, bool batch = false, compressCodec codec = CODEC_LZ4);
     ~Compress();
 
+    // Appends a zone map frame of config's field to every frame (zone_map.hpp), the LZ4 codec only. Call
+    // before SetOutputFileSize().
+    void setZoneMap(const dt_zoneConfig& config);
+
     void MakeOutputFileList(const std::vector<std::string>& inputFile);
     void SetOutputFileSize();
     
     virtual void preProcess();
     virtual void run();
     virtual void postProcess();
+
+    // Entropy estimate of a file in bits per byte, the size weighted mean of
+    // the block estimates xilLz4Compress reported (see lz_entropy.hpp). Files
+    // close to 8 do not compress and are better written as they are.
+    double fileEntropy(uint32_t fid) const;
+    // Blocks of a file the kernel stored for their entropy
+    uint32_t highEntropyBlocks(uint32_t fid) const;
 private:
     size_t create_header(uint8_t* h_header, uint32_t inSize);
+    // Entropy estimates of the blocks of a file
+    const uint32_t* blockEntropy(uint32_t fid) const;
+    // Files of a kernel invocation, for the stats
+    std::string launchName(uint32_t launch) const;
     
     // Block Size
     uint32_t m_BlockSizeInKb;
+    // FLG byte of the frames, FRAME_BLOCK_INDEX and FRAME_ZONE_MAP, passed to both kernels; FRAME_ZLIB or 0
+    // for the GZIP kernels, FRAME_SNAPPY for Snappy streams
+    uint32_t m_FrameFlags;
+    compressCodec m_Codec;
+    // Field of the zone maps with FRAME_ZONE_MAP, one 64 byte word for the kernel's argument
+    dt_zoneConfig* h_zoneConfig;
+    cl::Buffer* bufZoneConfig;
+
+    // Files go to the invocations in order: invocation, position in it (fileId
+    // of its blocks) and first block of every file
+    std::vector<uint32_t> m_fileLaunchVec;
+    std::vector<uint32_t> m_fileSlotVec;
+    std::vector<uint32_t> m_fileFirstBlockVec;
+    std::vector<uint32_t> m_launchFirstFileVec;
 
+    // Per invocation: one header word and one entry of the size and content
+    // checksum tables per file, one entropy estimate and descriptor per block
     std::vector<uint32_t> headerSizeVec;
     std::vector<uint8_t*> h_headerVec;
-    std::vector<uint32_t*> h_blkSizeVec;
+    std::vector<dt_blockDesc*> h_blockDescVec;
     std::vector<uint32_t*> h_lz4OutSizeVec;
+    std::vector<uint32_t*> h_entropyVec;
+    std::vector<uint32_t*> h_contentChecksumVec;
+    std::vector<dt_zoneMap*> h_zoneMapVec;
+#ifdef KERNEL_STATS
+    std::vector<dt_kernelStats*> h_compStatsVec;
+    std::vector<dt_kernelStats*> h_packStatsVec;
+    std::vector<cl::Buffer*> bufCompStatsVec;
+    std::vector<cl::Buffer*> bufPackStatsVec;
+#endif
 
     std::vector<cl::Buffer*> bufTmpOutputVec;
     std::vector<cl::Buffer*> buflz4OutSizeVec;
     std::vector<cl::Buffer*> bufCompSizeVec;
-    std::vector<cl::Buffer*> bufblockSizeVec;
+    std::vector<cl::Buffer*> bufBlockDescVec;
+    std::vector<cl::Buffer*> bufEntropyVec;
+    std::vector<cl::Buffer*> bufContentChecksumVec;
+    std::vector<cl::Buffer*> bufZoneMapVec;
+    std::vector<cl::Buffer*> bufBlockIndexVec;
+    std::vector<cl::Buffer*> bufSymbolVec;
     std::vector<cl::Buffer*> bufheadVec;
     
     std::vector<cl::Kernel*> packerKernelVec;
@@ -21,10 +21,12 @@
 #include "xcl2.hpp"
 #include <fcntl.h>
 #include <unistd.h>
+#include "snappy_frame.hpp"
+#include "record_filter.hpp"
 
 // Maximum host buffer used to operate
-// per kernel invocation
-#define HOST_BUFFER_SIZE (2 * 1024 * 1024)
+// per kernel invocation (HOST_BUFFER_SIZE is the compress one)
+#define DEC_HOST_BUFFER_SIZE (2 * 1024 * 1024)
 
 // Default block size
 #define BLOCK_SIZE_IN_KB 64
@@ -35,37 +37,106 @@
 #define MAX_IN_BUFFER_SIZE (1024 * 1024 * 1024)
 
 // Max Input Buffer Partitions
-#define MAX_IN_BUFFER_PARTITION MAX_IN_BUFFER_SIZE / HOST_BUFFER_SIZE
+#define MAX_IN_BUFFER_PARTITION MAX_IN_BUFFER_SIZE / DEC_HOST_BUFFER_SIZE
 
 // Maximum number of blocks based on host buffer size
-#define MAX_NUMBER_BLOCKS (HOST_BUFFER_SIZE / (BLOCK_SIZE_IN_KB * 1024))
+#define DEC_MAX_NUMBER_BLOCKS (DEC_HOST_BUFFER_SIZE / (BLOCK_SIZE_IN_KB * 1024))
+
+// Default number of xilLz4P2PDecompress compute units in the xclbin
+#ifndef DECOMPRESS_CU
+#define DECOMPRESS_CU 2
+#endif
+
+// Output buffer of a gzip member / zlib stream whose content size is not known
+// up front, in times the compressed size. xilGzipDecompress reports the size
+// when it does not fit and the file is run again with the exact size.
+#ifndef INFLATE_SIZE_RATIO
+#define INFLATE_SIZE_RATIO 4
+#endif
 
 
 class Decompress : public SmartSSD {
     public:
-    Decompress(const std::string& binaryFile, uint8_t device_id, bool p2p_enable);
+    // codec: CODEC_GZIP / CODEC_ZLIB read gzip members / zlib streams with xilGzipDecompress, one kernel per
+    // file (num_cu does not apply) and no readRange(). CODEC_SNAPPY reads Snappy framing format streams of
+    // 64 KB chunks with the LZ4 kernels, no readRange() either.
+    Decompress(const std::string& binaryFile, uint8_t device_id, bool p2p_enable, uint32_t num_cu = DECOMPRESS_CU,
+               compressCodec codec = CODEC_LZ4);
     ~Decompress();
 
+    // Writes only the records holding one of patterns to {file}.match instead of the content to {file}.org,
+    // or their content offsets (FILTER_OFFSETS, uint64 LE). Records end with delimiter. FILTER_COLUMNS
+    // writes the columns of the matching records (all records without patterns) as int64 LE, fields split
+    // on field_delimiter; FILTER_AGGREGATE a CSV of their count, sum, min and max. The kernels filter the
+    // records as they decompress, and only the filtered bytes are read back without P2P. Call it before
+    // MakeOutputFileList(); for LZ4 frames and Snappy streams, and not with readRange().
+    void setFilter(const std::vector<std::string>& patterns,
+                   uint8_t delimiter,
+                   uint32_t mode,
+                   const std::vector<uint32_t>& columns = std::vector<uint32_t>(),
+                   uint8_t field_delimiter = ',');
     void MakeOutputFileList(const std::vector<std::string>& inputFile);
     
 
     virtual void preProcess();
     virtual void run();
     virtual void postProcess();
+
+    // Decompresses [offset, offset + length) of the content of file into out, apart from the file list.
+    // Only the blocks covering the range are read (into the card over P2P when enabled) and run through
+    // the unpacker and the decompress compute units. Returns false when the range is past the content
+    // or a block fails its checksum.
+    bool readRange(const std::string& file, uint64_t offset, uint64_t length, std::vector<uint8_t>& out);
 private:
+    // Runs xilGzipDecompress on every file, again with a larger output buffer for the files that did not fit
+    void runInflate();
+    // Replaces the output buffer of file fid with one of size bytes
+    void resizeOutput(uint32_t fid, uint64_t size);
+    // Device copy of the record filter for the kernels' filter argument, one 64 byte word without a filter
+    cl::Buffer* filterBuffer();
+    // Joins the filtered blocks of file fid into its output buffer
+    void joinFiltered(uint32_t fid);
+
     std::vector<uint32_t> oriFileSizeVec;
 
     std::vector<std::string> outFileList;
-    std::vector<std::string> orgFileList;
+    // Block size of every frame, from its header
+    std::vector<uint32_t> blockSizeKbVec;
+    // FLG byte of every frame, FRAME_SNAPPY for Snappy streams
+    std::vector<uint32_t> frameFlagsVec;
+    // Content size and data chunks of every Snappy stream, which has no header to take them from
+    std::vector<snappyFrameInfo> snappyInfoVec;
 
     std::vector<cl::Buffer*> bufChunkInfoVec;
     std::vector<cl::Buffer*> bufBlockInfoVec;
+    // Block table of every file as xilLz4P2PDecompress left it, read back with a record filter
+    std::vector<std::vector<dt_blockInfo>> blockInfoVec;
+    // Column aggregates of every block of every file, read back with FILTER_AGGREGATE
+    std::vector<cl::Buffer*> bufColumnStatsVec;
+    std::vector<std::vector<dt_columnStats>> columnStatsVec;
+
+    recordFilter m_filter;
+    cl::Buffer* m_filterCLBuf;
+    uint8_t* m_filterHostBuf;
+    // xilGzipDecompress result of every file: content size and INFLATE_* status
+    std::vector<uint32_t*> h_resultVec;
+    std::vector<cl::Buffer*> bufResultVec;
+#ifdef KERNEL_STATS
+    // Stats records of every file: unpacker first, then one per compute unit
+    std::vector<std::vector<dt_kernelStats*>> h_statsVec;
+    std::vector<std::vector<cl::Buffer*>> bufStatsVec;
+#endif
 
     std::vector<cl::Kernel*> unpackerKernelVec;
-    std::vector<cl::Kernel*> decompressKernelVec;
+    // One decompress kernel per compute unit for every file
+    std::vector<std::vector<cl::Kernel*>> decompressKernelVec;
+
+    uint32_t m_numCU;
+    compressCodec m_Codec;
     // Kernel names
     std::vector<std::string> unpacker_kernel_names = {"xilLz4Unpacker"};
     std::vector<std::string> decompress_kernel_names = {"xilLz4P2PDecompress"};
+    std::vector<std::string> inflate_kernel_names = {"xilGzipDecompress"};
     
     std::chrono::duration<double, std::nano> m_compression_time;
 };
@@ -0,0 +1,118 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_METRICS_HPP_
+#define _XFCOMPRESSION_METRICS_HPP_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "xcl2.hpp"
+
+// Host pipeline stages timed per file
+enum MetricsStage {
+    STAGE_OPEN = 0,
+    STAGE_READ,
+    STAGE_MIGRATE,
+    STAGE_KERNEL,
+    STAGE_READBACK,
+    STAGE_PAD,
+    STAGE_WRITE,
+    STAGE_CLOSE,
+    STAGE_COUNT
+};
+
+/**
+ * Latency histogram in the HDR style: values below 2^SUB_BUCKET_BITS are
+ * counted exactly, larger values keep SUB_BUCKET_BITS - 1 significant bits,
+ * i.e. a relative error below 1/64 over the whole uint64_t range.
+ */
+class LatencyHistogram {
+    public:
+    static const uint32_t SUB_BUCKET_BITS = 7;
+    static const uint32_t SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    static const uint32_t SUB_BUCKET_HALF = SUB_BUCKET_COUNT / 2;
+    static const uint32_t BUCKET_COUNT = SUB_BUCKET_COUNT + (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_HALF;
+
+    LatencyHistogram();
+
+    void record(uint64_t value);
+    void merge(const LatencyHistogram& other);
+
+    uint64_t count() const { return m_count; }
+    uint64_t sum() const { return m_sum; }
+    uint64_t min() const { return m_count ? m_min : 0; }
+    uint64_t max() const { return m_max; }
+    double mean() const { return m_count ? (double)m_sum / m_count : 0; }
+    // Value at the given percentile (0 ~ 100), clamped to the recorded min/max
+    uint64_t percentile(double p) const;
+
+    private:
+    static uint32_t index(uint64_t value);
+    static uint64_t lowest(uint32_t idx);
+    static uint64_t highest(uint32_t idx);
+
+    std::vector<uint64_t> m_buckets;
+    uint64_t m_count;
+    uint64_t m_sum;
+    uint64_t m_min;
+    uint64_t m_max;
+};
+
+/**
+ * Per-file and per-stage counters of one SmartSSD run. Each stage duration
+ * is kept per file and folded into a per-stage latency histogram (ns).
+ */
+class Metrics {
+    public:
+    Metrics();
+
+    void setOperation(const std::string& op) { m_operation = op; }
+    // Registers a file, returns its index for the record calls
+    uint32_t addFile(const std::string& name);
+
+    void record(MetricsStage stage, uint32_t fid, uint64_t ns);
+    // Records end - start of one profiled CL event
+    void recordEvent(MetricsStage stage, uint32_t fid, const cl::Event& event);
+    // Records the span from the first start to the last end of a set of events
+    void recordEvents(MetricsStage stage, uint32_t fid, const std::vector<cl::Event>& events);
+    void addBytes(uint32_t fid, uint64_t bytes_in, uint64_t bytes_out);
+    // Appends the files and folds in the stage histograms of another run, e.g. the other engine of a hybrid run
+    void merge(const Metrics& other);
+
+    const LatencyHistogram& histogram(MetricsStage stage) const { return m_stageHist[stage]; }
+
+    // One JSON object per line: a "file" line per file, then a "stage" line per stage
+    bool writeJsonLines(const std::string& path) const;
+    // Prometheus text exposition format, written atomically for the textfile collector
+    bool writePrometheus(const std::string& path) const;
+
+    static const char* stageName(MetricsStage stage);
+
+    private:
+    struct FileMetrics {
+        std::string name;
+        uint64_t bytesIn;
+        uint64_t bytesOut;
+        uint64_t stageNs[STAGE_COUNT];
+    };
+
+    std::string m_operation;
+    std::vector<FileMetrics> m_files;
+    LatencyHistogram m_stageHist[STAGE_COUNT];
+};
+
+#endif // _XFCOMPRESSION_METRICS_HPP_
@@ -0,0 +1,119 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_HOST_RECORD_FILTER_HPP_
+#define _XFCOMPRESSION_HOST_RECORD_FILTER_HPP_
+
+/**
+ * @file record_filter.hpp
+ * @brief Host side of the record filter of xilLz4P2PDecompress.
+ *
+ * The literal patterns are turned into an Aho-Corasick automaton over byte
+ * classes, in the layout of the kernel's filter argument (dt_filterConfig,
+ * kernel/include/lz4_p2p.hpp). The kernel filters the whole records of
+ * every block; recordFilterJoin completes the records that span blocks from
+ * the head and tail it leaves of every block, and checks them and the
+ * records too long for an engine to hold back.
+ *
+ * FILTER_COLUMNS and FILTER_AGGREGATE project up to FILTER_MAX_COLUMNS
+ * fields of the matching records (of all records without patterns), split
+ * on a field delimiter and read as decimal integers, into packed int64 or
+ * count / sum / min / max per column.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include "../../kernel/include/lz4_p2p.hpp"
+
+struct recordFilter {
+    uint32_t mode;     // FILTER_*
+    uint8_t delimiter; // record delimiter
+    std::vector<std::string> patterns;
+    uint8_t fieldDelimiter;        // FILTER_COLUMNS / FILTER_AGGREGATE
+    std::vector<uint32_t> columns; // field index of every projected column, from 0
+    std::vector<uint8_t> config; // filter argument of xilLz4P2PDecompress, FILTER_CONFIG_SIZE bytes
+};
+
+// Builds the automaton of patterns into filter. Prints the reason and exits
+// when a pattern is empty or holds the delimiter, or when the patterns need
+// more than FILTER_MAX_STATES states or FILTER_MAX_CLASSES - 1 distinct bytes.
+// FILTER_COLUMNS and FILTER_AGGREGATE take 1 to FILTER_MAX_COLUMNS columns
+// and no patterns for every record, the other modes no columns.
+void recordFilterBuild(const std::vector<std::string>& patterns,
+                       uint8_t delimiter,
+                       uint32_t mode,
+                       recordFilter& filter,
+                       const std::vector<uint32_t>& columns = std::vector<uint32_t>(),
+                       uint8_t field_delimiter = ',');
+
+// True when one of the patterns occurs in the size bytes of record, given without its delimiter, or there are none
+bool recordFilterMatch(const recordFilter& filter, const uint8_t* record, size_t size);
+
+// The projected columns of record, given without its delimiter, as recordFilter() reads them: FILTER_NULL for a
+// missing field or one that is not an optional sign and digits
+void recordFilterProject(const recordFilter& filter, const uint8_t* record, size_t size, int64_t* values);
+
+// Turns what xilLz4P2PDecompress wrote for the blocks of one content, in
+// order, into the matching records with their delimiter (FILTER_RECORDS),
+// the content offset of every matching record as a uint64 LE
+// (FILTER_OFFSETS) or their projected columns as int64 LE (FILTER_COLUMNS),
+// appended to out. FILTER_AGGREGATE appends a CSV of the columns' count,
+// sum, min and max when finished.
+class recordFilterJoin {
+    public:
+    recordFilterJoin(const recordFilter& filter, std::vector<uint8_t>& out);
+
+    // Adds the next block: the info.filteredSize bytes written for it, described by info, and with
+    // FILTER_AGGREGATE its FILTER_MAX_COLUMNS column_stats
+    void addBlock(const uint8_t* data, const dt_blockInfo& info, const dt_columnStats* column_stats = NULL);
+    // Checks the last record, the one the content ends in without a delimiter, unless it is all zeros: the
+    // padding of the content to whole pages
+    void finish();
+
+    uint64_t matches() const { return m_matches; }
+    // FILTER_AGGREGATE: one entry per column, min and max are only set with a count
+    const std::vector<dt_columnStats>& stats() const { return m_stats; }
+
+    private:
+    // Checks a whole record, with its delimiter unless it ends the content
+    void addRecord(const uint8_t* record, size_t size);
+    // FILTER_COLUMNS / FILTER_AGGREGATE: addBlock() on the parse of the records the block only holds part of
+    void addParsedBlock(const uint8_t* data, const dt_blockInfo& info, const dt_columnStats* column_stats);
+    // Projects the record parsed so far, which ends here
+    void endParse();
+    void addOffset(uint64_t offset);
+    void addStats(const dt_columnStats& stats, uint32_t column);
+
+    const recordFilter& m_filter;
+    std::vector<uint8_t>& m_out;
+    // FILTER_RECORDS: start of the record the next blocks go on with
+    std::vector<uint8_t> m_carry;
+    // FILTER_OFFSETS: content offset and automaton state of that record
+    uint64_t m_carryOffset;
+    uint32_t m_carryState;
+    // FILTER_COLUMNS / FILTER_AGGREGATE: parse of that record, its bytes so far and whether they are all zero
+    dt_filterParseState m_parse;
+    uint64_t m_carryBytes;
+    bool m_carryZero;
+    // Content offset of the next block
+    uint64_t m_blockOffset;
+    uint64_t m_matches;
+    std::vector<dt_columnStats> m_stats;
+};
+
+#endif // _XFCOMPRESSION_HOST_RECORD_FILTER_HPP_
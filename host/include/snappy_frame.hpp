@@ -0,0 +1,52 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_SNAPPY_FRAME_HPP_
+#define _XFCOMPRESSION_SNAPPY_FRAME_HPP_
+
+/**
+ * @file snappy_frame.hpp
+ * @brief Snappy framing format helpers of the Snappy codec.
+ *
+ * The LZ4 kernels write and read Snappy streams as one data chunk per 64 KB
+ * block (FRAME_SNAPPY, kernel/include/lz4_p2p.hpp). A stream has no header
+ * with the content size, so the decompressor walks the chunk headers first.
+ * Consumers of raw Snappy blocks (Parquet pages, Kafka batches) take the
+ * payload of the data chunks.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+// Stream identifier chunk: type, 24 bit length and "sNaPpY"
+#define SNAPPY_STREAM_ID_SIZE 10
+
+struct snappyFrameInfo {
+    uint64_t contentSize; // uncompressed bytes of all data chunks
+    uint32_t numChunks;   // data chunks, compressed or not
+};
+
+// Writes the stream identifier chunk to out and returns its size, SNAPPY_STREAM_ID_SIZE
+size_t snappyStreamIdentifier(uint8_t* out);
+
+// Walks the chunks of the stream in file and sums up the content size of
+// its data chunks. Prints the reason and exits when file is not a Snappy
+// framing format stream, or when a data chunk other than the last does not
+// hold SNAPPY_BLOCK_SIZE bytes: the kernels take one chunk per block.
+void snappyReadFrameInfo(const std::string& file, snappyFrameInfo& info);
+
+#endif // _XFCOMPRESSION_SNAPPY_FRAME_HPP_
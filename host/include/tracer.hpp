@@ -0,0 +1,81 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_TRACER_HPP_
+#define _XFCOMPRESSION_TRACER_HPP_
+
+#include <chrono>
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "xcl2.hpp"
+
+/**
+ * Collects host spans and profiled OpenCL events of one run and writes them
+ * as a Chrome trace (chrome://tracing, Perfetto). Host spans go to the
+ * "host" process with one lane per file, device commands to the "device"
+ * process with one lane per kernel / compute unit or transfer. The time each
+ * command sat in the queue is added as an async slice.
+ *
+ * Device timestamps come from the CL profiling counters and are moved onto
+ * the host clock with anchor(), taken right after the first enqueue.
+ * Nothing is recorded until enable() is called.
+ */
+class Tracer {
+    public:
+    typedef std::chrono::high_resolution_clock::time_point TimePoint;
+
+    Tracer();
+
+    void enable(const std::string& path) { m_path = path; }
+    bool enabled() const { return !m_path.empty(); }
+
+    void hostSpan(const std::string& name, uint32_t fid, TimePoint start, TimePoint end);
+    // Event timestamps are read when the trace is written, the event must be complete by then
+    void deviceEvent(const std::string& name, const std::string& lane, uint32_t fid, const cl::Event& event);
+    // Aligns the device clock: the event was queued just before host_time
+    void anchor(const cl::Event& event, TimePoint host_time);
+
+    bool write() const;
+
+    private:
+    struct HostSpan {
+        std::string name;
+        uint32_t fid;
+        TimePoint start;
+        TimePoint end;
+    };
+    struct DeviceEvent {
+        std::string name;
+        std::string lane;
+        uint32_t fid;
+        cl::Event event;
+    };
+
+    uint32_t laneId(const std::string& lane) const;
+
+    std::string m_path;
+    TimePoint m_origin;
+    std::vector<HostSpan> m_hostSpans;
+    std::vector<DeviceEvent> m_deviceEvents;
+    std::vector<std::string> m_lanes;
+    bool m_anchored;
+    cl::Event m_anchorEvent;
+    TimePoint m_anchorHostTime;
+};
+
+#endif // _XFCOMPRESSION_TRACER_HPP_
@@ -0,0 +1,68 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_XXHASH_SIMD_HPP_
+#define _XFCOMPRESSION_XXHASH_SIMD_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Vectorized xxHash of the host, SSE2 / AVX2 / AVX-512 picked at run time.
+ *
+ * XXH32 is one serial chain per buffer and does not vectorize inside a
+ * buffer, so xxh32Blocks() hashes several buffers at once, one per SIMD
+ * lane. It gives the same values as XXH32() of xxhash.h and is what the
+ * block checksums of LZ4 frames use. The content checksum of a frame is a
+ * single XXH32 over the whole file and stays on XXH32().
+ *
+ * xxh3_64() and xxh3_128() are XXH3 (xxHash 0.8) with the default secret and
+ * seed 0, for checksums the host keeps for itself. They vectorize inside one
+ * buffer and run several times faster than XXH32.
+ *
+ * The instruction set is the best one the CPU and the OS support, the
+ * SMARTSSD_HASH_ISA environment variable (scalar, sse2, avx2, avx512) or
+ * hashSelectIsa() can lower it.
+ */
+
+// Widest group of buffers xxh32Blocks() runs side by side (AVX-512)
+#define HASH_MAX_LANES 16
+
+enum hashIsa { HASH_ISA_SCALAR, HASH_ISA_SSE2, HASH_ISA_AVX2, HASH_ISA_AVX512 };
+
+struct hash128 {
+    uint64_t low64;
+    uint64_t high64;
+};
+
+// Best instruction set of this machine
+hashIsa hashDetectIsa();
+// Instruction set in use
+hashIsa hashActiveIsa();
+// Uses isa from now on, clamped to hashDetectIsa(), returns the one in use
+hashIsa hashSelectIsa(hashIsa isa);
+const char* hashIsaName(hashIsa isa);
+// Buffers xxh32Blocks() hashes side by side with the active instruction set
+uint32_t hashLanes();
+
+// hashes[i] = XXH32(data[i], sizes[i], seed) for i < count
+void xxh32Blocks(const uint8_t* const* data, const size_t* sizes, size_t count, uint32_t seed, uint32_t* hashes);
+
+// XXH3_64bits() / XXH3_128bits() of xxHash 0.8
+uint64_t xxh3_64(const void* data, size_t len);
+hash128 xxh3_128(const void* data, size_t len);
+
+#endif // _XFCOMPRESSION_XXHASH_SIMD_HPP_
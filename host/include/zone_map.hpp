@@ -0,0 +1,75 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_HOST_ZONE_MAP_HPP_
+#define _XFCOMPRESSION_HOST_ZONE_MAP_HPP_
+
+/**
+ * @file zone_map.hpp
+ * @brief Host side of the block zone maps of xilLz4Compress.
+ *
+ * xilLz4Compress parses the records every block holds whole as it
+ * compresses it (dt_zoneMap, kernel/include/zone_map.hpp); zoneMapJoin adds
+ * the records that span blocks, read from the content, and gives each record
+ * to the block it starts in. The entries go to the zone map frame after the
+ * LZ4 frame (lz4WriteZoneMap()), where zoneMapQuery() finds the blocks that
+ * may hold a value range and decompresses only those.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <string>
+#include <vector>
+#include "lz4_frame.hpp"
+#include "../../kernel/include/zone_map.hpp"
+
+// Value of the field of record, given without its delimiter, false when it has none
+bool zoneMapValue(const dt_zoneConfig& config, const uint8_t* record, size_t size, int64_t& value);
+
+// Zone map of the size bytes of one block, as xilLz4Compress writes it
+void zoneMapBlock(const dt_zoneConfig& config, const uint8_t* data, uint32_t size, dt_zoneMap& zone);
+
+// Turns the zone maps of the blocks of content, block_size bytes each but
+// the last, into one zone map frame entry per block
+void zoneMapJoin(const dt_zoneConfig& config,
+                 const uint8_t* content,
+                 uint64_t size,
+                 uint32_t block_size,
+                 const dt_zoneMap* zones,
+                 std::vector<lz4ZoneEntry>& entries);
+
+struct zoneMapQueryStats {
+    uint32_t blocks;     // of the frame
+    uint32_t blocksRead; // decompressed for the runs of blocks the range does not rule out
+    uint64_t records;    // matching
+};
+
+// Reads [offset, offset + length) of the content of a file into data
+typedef std::function<bool(uint64_t offset, uint64_t length, std::vector<uint8_t>& data)> zoneMapReader;
+
+// Appends the records of the LZ4 frame in file whose field is in [min, max]
+// to out, with their delimiter. Only the runs of blocks whose zone map
+// overlaps the range are decompressed, through read. Returns false when
+// file has no zone map or content size, or read fails.
+bool zoneMapQuery(const std::string& file,
+                  int64_t min,
+                  int64_t max,
+                  const zoneMapReader& read,
+                  std::vector<uint8_t>& out,
+                  zoneMapQueryStats& stats);
+
+#endif // _XFCOMPRESSION_HOST_ZONE_MAP_HPP_
@@ -1,4 +1,5 @@
 #include "SmartSSD.hpp"
+#include "lz4_dict.hpp"
 
 SmartSSD::SmartSSD(const std::string& binaryFileName, uint8_t device_id, bool p2p_enable)
 {
@@ -41,6 +42,10 @@ SmartSSD::SmartSSD(const std::string& binaryFileName, uint8_t device_id, bool p2
 
     m_program = new cl::Program(*m_context, devices, bins);
     m_p2pEnable = p2p_enable;
+    m_sharedBuffers = false;
+    m_dictId = 0;
+    m_dictHostBuf = NULL;
+    m_dictCLBuf = NULL;
 #if (_DEBUG == 1)
     std::cout << "\x1B[32m[OpenCL Setup]\033[0m OpenCL/Host/Device Buffer Setup Done ..." << std::endl;
 #endif
@@ -54,16 +59,104 @@ SmartSSD::SmartSSD(const std::string& binaryFileName, uint8_t device_id, bool p2
     m_output_file_size = 0;
 }
 
+SmartSSD::SmartSSD(bool p2p_enable)
+{
+    m_program = NULL;
+    m_context = NULL;
+    m_q = NULL;
+    // P2P buffers live in the card's DDR
+    if (p2p_enable) {
+        std::cout << "P2P needs the FPGA, reading through host memory instead" << std::endl;
+    }
+    m_p2pEnable = false;
+    m_sharedBuffers = false;
+    m_dictId = 0;
+    m_dictHostBuf = NULL;
+    m_dictCLBuf = NULL;
+
+    m_input_file_open_time = std::chrono::milliseconds::zero();
+    m_output_file_open_time = std::chrono::milliseconds::zero();
+    m_ssd_read_time = std::chrono::milliseconds::zero();
+    m_ssd_write_time = std::chrono::milliseconds::zero();
+
+    m_input_file_size = 0;
+    m_output_file_size = 0;
+}
+
+bool SmartSSD::fpgaAvailable(const std::string& binaryFileName, uint8_t device_id)
+{
+    std::vector<cl::Device> devices = xcl::get_xil_devices();
+    if (devices.size() <= device_id || access(binaryFileName.c_str(), R_OK) != 0) {
+        return false;
+    }
+    std::vector<cl::Device> device = {devices.at(device_id)};
+
+    // A card held by another process fails to create the context or to load the xclbin
+    cl_int err;
+    cl::Context context(device[0], NULL, NULL, NULL, &err);
+    if (err != CL_SUCCESS) {
+        std::cout << "Device " << unsigned(device_id) << " is busy, error code is: " << err << std::endl;
+        return false;
+    }
+    auto fileBuf = xcl::read_binary_file(binaryFileName.c_str());
+    cl::Program::Binaries bins{{fileBuf.data(), fileBuf.size()}};
+    cl::Program program(context, device, bins, NULL, &err);
+    if (err != CL_SUCCESS) {
+        std::cout << "Unable to load " << binaryFileName << " on device " << unsigned(device_id)
+                  << ", error code is: " << err << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#ifdef KERNEL_STATS
+void SmartSSD::printKernelStats(const std::string& kernel_name, const std::string& file_name, const dt_kernelStats* stats)
+{
+    std::cout << "\x1B[32m[FPGA Operation]\033[0m " << kernel_name << " (" << file_name << ") : "
+              << stats->moverBeats << " mover beats, " << stats->bytesIn << " B in, " << stats->bytesOut << " B out, "
+              << stats->bursts << " bursts, " << stats->rawBlocks << " raw blocks";
+    if (stats->lowOffsetCycles) std::cout << ", " << stats->lowOffsetCycles << " low offset cycles (all engines)";
+    std::cout << std::endl;
+    for (uint32_t e = 0; e < stats->numEngines && e < MAX_STATS_ENGINES; e++) {
+        std::cout << "\x1B[32m[FPGA Operation]\033[0m     engine " << e << " stall cycles (in/out) : "
+                  << stats->inStallCycles[e] << " / " << stats->outStallCycles[e] << std::endl;
+    }
+}
+#endif
+
+void SmartSSD::setDictionary(const std::vector<uint8_t>& dict)
+{
+    m_dict = dict;
+    m_dictId = dict.empty() ? 0 : lz4DictionaryId(dict);
+}
+
+cl::Buffer* SmartSSD::dictBuffer()
+{
+    if (m_dictCLBuf == NULL) {
+        // The kernels read the dictionary in 64 byte words
+        size_t size = ((std::max<size_t>(m_dict.size(), 1) - 1) / 64 + 1) * 64;
+        m_dictHostBuf = (uint8_t*)aligned_alloc(4096, ((size - 1) / 4096 + 1) * 4096);
+        memset(m_dictHostBuf, 0, size);
+        if (!m_dict.empty()) memcpy(m_dictHostBuf, m_dict.data(), m_dict.size());
+        m_dictCLBuf = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, size, m_dictHostBuf);
+        m_q->enqueueMigrateMemObjects({*m_dictCLBuf}, 0 /* 0 means from host*/);
+    }
+    return m_dictCLBuf;
+}
 
 SmartSSD::~SmartSSD() 
 {
+    delete (m_dictCLBuf);
+    free(m_dictHostBuf);
     delete (m_program);
     delete (m_q);
     delete (m_context);
 
     if (m_p2pEnable == false)
     {
-        for (uint32_t i = 0; i < m_InputFileDescVec.size(); i++) 
+        // Shared buffers start with the first file
+        uint32_t num_bufs = m_sharedBuffers ? std::min<size_t>(m_InputHostMappedBufVec.size(), 1) : m_InputFileDescVec.size();
+        for (uint32_t i = 0; i < num_bufs; i++) 
         {
             delete (m_InputHostMappedBufVec[i]);
             delete (m_OutputHostMappedBufVec[i]);
@@ -120,6 +213,10 @@ void SmartSSD::OpenInputFiles()
         auto file_open_time_end = std::chrono::high_resolution_clock::now();
         m_input_file_open_time = m_input_file_open_time + std::chrono::duration<double, std::nano>(file_open_time_end - file_open_time_start);
         m_InputFileDescVec.push_back(fd_p2p_c_in);
+
+        uint32_t mid = m_metrics.addFile(inFile_name);
+        m_metrics.record(STAGE_OPEN, mid, std::chrono::duration_cast<std::chrono::nanoseconds>(file_open_time_end - file_open_time_start).count());
+        m_tracer.hostSpan("open input", mid, file_open_time_start, file_open_time_end);
     }
 #if (_DEBUG == 1)
     std::cout << "\x1B[31m[Disk Operation]\033[0m Reading Input Files Done ..." << std::endl;
@@ -135,7 +232,7 @@ void SmartSSD::OpenOutputFiles()
     for (uint32_t fid = 0; fid < m_OutputFileNameVec.size(); fid++) {
         std::string outFile_name = m_OutputFileNameVec[fid];
         auto file_open_time_start = std::chrono::high_resolution_clock::now();
-        int fd_p2p_c_out = open(outFile_name.c_str(), O_CREAT | O_WRONLY | O_DIRECT, 0777);
+        int fd_p2p_c_out = open(outFile_name.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_DIRECT, 0777);
         if (fd_p2p_c_out <= 0) {
             std::cout << "P2P: Unable to open input file, fd: " << fd_p2p_c_out << std::endl;
             exit(1);
@@ -143,6 +240,8 @@ void SmartSSD::OpenOutputFiles()
         auto file_open_time_end = std::chrono::high_resolution_clock::now();
         m_output_file_open_time = m_output_file_open_time + std::chrono::duration<double, std::nano>(file_open_time_end - file_open_time_start);
         m_OutputFileDescVec.push_back(fd_p2p_c_out);
+        m_metrics.record(STAGE_OPEN, fid, std::chrono::duration_cast<std::chrono::nanoseconds>(file_open_time_end - file_open_time_start).count());
+        m_tracer.hostSpan("open output", fid, file_open_time_start, file_open_time_end);
     }
 #if (_DEBUG == 1)
     std::cout << "\x1B[31m[Disk Operation]\033[0m Reading Output Files Done ..." << std::endl;
@@ -158,6 +257,8 @@ void SmartSSD::CloseInputFiles()
         close(m_InputFileDescVec[fid]);
         auto file_open_time_end = std::chrono::high_resolution_clock::now();
         file_open_time_ns = file_open_time_ns + std::chrono::duration<double, std::nano>(file_open_time_end - file_open_time_start);
+        m_metrics.record(STAGE_CLOSE, fid, std::chrono::duration_cast<std::chrono::nanoseconds>(file_open_time_end - file_open_time_start).count());
+        m_tracer.hostSpan("close input", fid, file_open_time_start, file_open_time_end);
     }
 #if (_DEBUG == 1)
     std::cout << "\x1B[31m[Disk Operation]\033[0m Close input Files Done ..." << std::endl;
@@ -173,6 +274,8 @@ void SmartSSD::CloseOutputFiles()
         close(m_OutputFileDescVec[fid]);
         auto file_open_time_end = std::chrono::high_resolution_clock::now();
         file_open_time_ns = file_open_time_ns + std::chrono::duration<double, std::nano>(file_open_time_end - file_open_time_start);
+        m_metrics.record(STAGE_CLOSE, fid, std::chrono::duration_cast<std::chrono::nanoseconds>(file_open_time_end - file_open_time_start).count());
+        m_tracer.hostSpan("close output", fid, file_open_time_start, file_open_time_end);
     }
 #if (_DEBUG == 1)
     std::cout << "\x1B[31m[Disk Operation]\033[0m Close output Files Done ..." << std::endl;
@@ -181,50 +284,83 @@ void SmartSSD::CloseOutputFiles()
         
 void SmartSSD::initBuffer()
 {
-    for (uint32_t i = 0; i < m_InputFileDescVec.size(); i++) {
-        // Device buffer allocation
-        // K1 Input:- This buffer contains input chunk data
-        if (m_p2pEnable == true)
-        {
-            // DDR buffer extensions
-            cl_mem_ext_ptr_t lz4Ext;
-            lz4Ext.flags = XCL_MEM_DDR_BANK0 | XCL_MEM_EXT_P2P_BUFFER;
-            lz4Ext.param = NULL;
-            lz4Ext.obj = nullptr;
-            cl::Buffer* buffer_input =new cl::Buffer(*m_context, CL_MEM_EXT_PTR_XILINX | CL_MEM_READ_WRITE, m_InputFileSizeVec[i], &(lz4Ext));
-            m_InputCLBufVec.push_back(buffer_input);
-
-            uint8_t* h_buf_in_p2p = (uint8_t*)m_q->enqueueMapBuffer(*(buffer_input), CL_TRUE, CL_MAP_READ, 0, m_InputFileSizeVec[i]);
-            m_InputHostMappedBufVec.push_back(h_buf_in_p2p);
+    if (m_sharedBuffers) {
+        uint64_t input_size = 0;
+        uint64_t output_size = 0;
+        for (uint32_t i = 0; i < m_InputFileDescVec.size(); i++) {
+            m_InputOffsetVec.push_back(input_size);
+            m_OutputOffsetVec.push_back(output_size);
+            input_size += m_InputFileSizeVec[i];
+            output_size += outputFileSizeVec[i];
         }
-        else
-        {
-            uint8_t* hostBuf = (uint8_t*) aligned_alloc(4096, m_InputFileSizeVec[i]); //new uint8_t[inSizeVec[i]];
-            m_InputHostMappedBufVec.push_back(hostBuf);
+        allocBuffers(input_size, output_size);
+        uint8_t* input_base = m_InputHostMappedBufVec[0];
+        uint8_t* output_base = m_OutputHostMappedBufVec[0];
+        for (uint32_t i = 1; i < m_InputFileDescVec.size(); i++) {
+            m_InputHostMappedBufVec.push_back(input_base + m_InputOffsetVec[i]);
+            m_OutputHostMappedBufVec.push_back(output_base + m_OutputOffsetVec[i]);
+        }
+        return;
+    }
+
+    for (uint32_t i = 0; i < m_InputFileDescVec.size(); i++) {
+        m_InputOffsetVec.push_back(0);
+        m_OutputOffsetVec.push_back(0);
+        allocBuffers(m_InputFileSizeVec[i], outputFileSizeVec[i]);
+    }
+}
 
-            cl::Buffer* buffer_input =new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_READ_WRITE, m_InputFileSizeVec[i], hostBuf);
+void SmartSSD::allocBuffers(size_t input_size, size_t output_size)
+{
+    // Device buffer allocation
+    // K1 Input:- This buffer contains input chunk data
+    if (m_p2pEnable == true)
+    {
+        // DDR buffer extensions
+        cl_mem_ext_ptr_t lz4Ext;
+        lz4Ext.flags = XCL_MEM_DDR_BANK0 | XCL_MEM_EXT_P2P_BUFFER;
+        lz4Ext.param = NULL;
+        lz4Ext.obj = nullptr;
+        cl::Buffer* buffer_input =new cl::Buffer(*m_context, CL_MEM_EXT_PTR_XILINX | CL_MEM_READ_WRITE, input_size, &(lz4Ext));
+        m_InputCLBufVec.push_back(buffer_input);
+
+        uint8_t* h_buf_in_p2p = (uint8_t*)m_q->enqueueMapBuffer(*(buffer_input), CL_TRUE, CL_MAP_READ, 0, input_size);
+        m_InputHostMappedBufVec.push_back(h_buf_in_p2p);
+    }
+    else
+    {
+        uint8_t* hostBuf = (uint8_t*) aligned_alloc(4096, input_size); //new uint8_t[inSizeVec[i]];
+        m_InputHostMappedBufVec.push_back(hostBuf);
+
+        // Host-only backends work on the host buffer directly, the 4K tail past the file reads as zeros
+        if (m_context == NULL) {
+            memset(hostBuf, 0, input_size);
+        } else {
+            cl::Buffer* buffer_input =new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_READ_WRITE, input_size, hostBuf);
             m_InputCLBufVec.push_back(buffer_input);
         }
-        
-        //K2 Output:- This buffer contains compressed data written by device
-        if (m_p2pEnable) 
-        {
-            // DDR buffer extensions
-            cl_mem_ext_ptr_t lz4Ext;
-            lz4Ext.flags = XCL_MEM_DDR_BANK0 | XCL_MEM_EXT_P2P_BUFFER;
-            lz4Ext.param = NULL;
-            lz4Ext.obj = nullptr;
-            cl::Buffer* buffer_output = new cl::Buffer(*m_context, CL_MEM_WRITE_ONLY | CL_MEM_EXT_PTR_XILINX, outputFileSizeVec[i], &(lz4Ext));
-            m_OutputCLBufVec.push_back(buffer_output);
-            uint8_t* h_buf_out_p2p = (uint8_t*)m_q->enqueueMapBuffer(*(buffer_output), CL_TRUE, CL_MAP_READ, 0, outputFileSizeVec[i]);
-            m_OutputHostMappedBufVec.push_back(h_buf_out_p2p);
-        }
-        else
-        {
-            // Creating Host memory to read the compressed data back to host for non-p2p flow case
-            uint8_t* resultData = (uint8_t*)  aligned_alloc(4096, outputFileSizeVec[i]);// new uint8_t[outputSize];
-            m_OutputHostMappedBufVec.push_back(resultData);
-            cl::Buffer* buffer_output = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY, outputFileSizeVec[i], resultData);
+    }
+    
+    //K2 Output:- This buffer contains compressed data written by device
+    if (m_p2pEnable) 
+    {
+        // DDR buffer extensions
+        cl_mem_ext_ptr_t lz4Ext;
+        lz4Ext.flags = XCL_MEM_DDR_BANK0 | XCL_MEM_EXT_P2P_BUFFER;
+        lz4Ext.param = NULL;
+        lz4Ext.obj = nullptr;
+        cl::Buffer* buffer_output = new cl::Buffer(*m_context, CL_MEM_WRITE_ONLY | CL_MEM_EXT_PTR_XILINX, output_size, &(lz4Ext));
+        m_OutputCLBufVec.push_back(buffer_output);
+        uint8_t* h_buf_out_p2p = (uint8_t*)m_q->enqueueMapBuffer(*(buffer_output), CL_TRUE, CL_MAP_READ, 0, output_size);
+        m_OutputHostMappedBufVec.push_back(h_buf_out_p2p);
+    }
+    else
+    {
+        // Creating Host memory to read the compressed data back to host for non-p2p flow case
+        uint8_t* resultData = (uint8_t*)  aligned_alloc(4096, output_size);// new uint8_t[outputSize];
+        m_OutputHostMappedBufVec.push_back(resultData);
+        if (m_context != NULL) {
+            cl::Buffer* buffer_output = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY, output_size, resultData);
             m_OutputCLBufVec.push_back(buffer_output);
         }
     }
@@ -235,12 +371,14 @@ void SmartSSD::readFile(size_t size)
     int ret = 0;
     auto ssd_start = std::chrono::high_resolution_clock::now();
     for (uint32_t i = 0; i < m_InputFileDescVec.size(); i++) {
-        if (size == 0)
+        size_t read_size = size;
+        if (read_size == 0)
         {
-            size = m_InputFileSizeVec[i];
+            read_size = m_InputFileSizeVec[i];
         }
+        auto read_start = std::chrono::high_resolution_clock::now();
         /* Read Data from ssd */
-        ret = read(m_InputFileDescVec[i], m_InputHostMappedBufVec[i], size);
+        ret = read(m_InputFileDescVec[i], m_InputHostMappedBufVec[i], read_size);
         if (ret == -1)
         {
             std::cout << "read() failed with error: " << ret << ", line: " << __LINE__ << std::endl;
@@ -248,6 +386,10 @@ void SmartSSD::readFile(size_t size)
 
             exit(1);
         }
+        auto read_end = std::chrono::high_resolution_clock::now();
+        m_metrics.record(STAGE_READ, i, std::chrono::duration_cast<std::chrono::nanoseconds>(read_end - read_start).count());
+        m_tracer.hostSpan("read", i, read_start, read_end);
+        m_metrics.addBytes(i, ret, 0);
     }
     auto ssd_end = std::chrono::high_resolution_clock::now();
     m_ssd_read_time = std::chrono::duration<double, std::nano>(ssd_end - ssd_start);
@@ -270,12 +412,27 @@ void SmartSSD::writeFile(size_t size)
         }
         m_output_file_size += write_size;
 
+        auto write_start = std::chrono::high_resolution_clock::now();
         ret = write(m_OutputFileDescVec[i], m_OutputHostMappedBufVec[i], write_size);
+        auto write_end = std::chrono::high_resolution_clock::now();
         if (ret == -1)
         {
             std::cout << i << " :: " << write_size << std::endl;
             std::cout << "Write() failed with error: " << ret << ", line: " << __LINE__ << std::endl;
         }
+        else
+        {
+            m_metrics.addBytes(i, 0, ret);
+            // O_DIRECT writes whole pages, the zeros after the content are cut off again
+            if (i < m_OutputLengthVec.size() && m_OutputLengthVec[i] < write_size &&
+                ftruncate(m_OutputFileDescVec[i], m_OutputLengthVec[i]) != 0)
+            {
+                std::cout << "Unable to truncate " << m_OutputFileNameVec[i] << " to " << m_OutputLengthVec[i]
+                          << " B" << std::endl;
+            }
+        }
+        m_metrics.record(STAGE_WRITE, i, std::chrono::duration_cast<std::chrono::nanoseconds>(write_end - write_start).count());
+        m_tracer.hostSpan("write", i, write_start, write_end);
     }
     auto ssd_end = std::chrono::high_resolution_clock::now();
     m_ssd_write_time = std::chrono::duration<double, std::nano>(ssd_end - ssd_start);
@@ -0,0 +1,135 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "hybrid.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/stat.h>
+
+#define KB 1024
+#define MB (1000.0 * 1000.0)
+
+// Weight of a new measurement in the estimate
+#define HYBRID_UPDATE_WEIGHT 0.5
+
+static uint64_t fileSize(const std::string& path)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        std::cout << "Unable to open file " << path << std::endl;
+        exit(1);
+    }
+    return st.st_size;
+}
+
+HybridScheduler::HybridScheduler(const std::string& operation, uint32_t cpu_threads) : m_operation(operation)
+{
+    m_mbps[PATH_FPGA] = HYBRID_FPGA_MBPS;
+    m_mbps[PATH_CPU] = HYBRID_CPU_MBPS_PER_THREAD * (double)(cpu_threads ? cpu_threads : 1);
+}
+
+const char* HybridScheduler::pathName(HybridPath path)
+{
+    static const char* names[PATH_COUNT] = {"fpga", "cpu"};
+    return names[path];
+}
+
+HybridPlan HybridScheduler::plan(const std::vector<std::string>& files, bool fpga_available) const
+{
+    HybridPlan plan;
+    for (uint32_t p = 0; p < PATH_COUNT; p++) {
+        plan.bytes[p] = 0;
+        plan.seconds[p] = 0;
+    }
+
+    std::vector<std::pair<uint64_t, std::string> > large;
+    for (const std::string& file : files) {
+        uint64_t size = fileSize(file);
+        if (fpga_available && size >= (uint64_t)HYBRID_SMALL_FILE_KB * KB) {
+            large.push_back(std::make_pair(size, file));
+        } else {
+            plan.files[PATH_CPU].push_back(file);
+            plan.bytes[PATH_CPU] += size;
+        }
+    }
+    plan.seconds[PATH_CPU] = plan.bytes[PATH_CPU] / (m_mbps[PATH_CPU] * MB);
+
+    // Largest first, each to the path that would finish it earliest
+    std::stable_sort(large.begin(), large.end(),
+                     [](const std::pair<uint64_t, std::string>& a, const std::pair<uint64_t, std::string>& b) {
+                         return a.first > b.first;
+                     });
+    for (const auto& file : large) {
+        double fpga_seconds = (plan.bytes[PATH_FPGA] + file.first) / (m_mbps[PATH_FPGA] * MB) +
+                              (plan.files[PATH_FPGA].size() + 1) * HYBRID_FPGA_LAUNCH_US / 1e6;
+        double cpu_seconds = (plan.bytes[PATH_CPU] + file.first) / (m_mbps[PATH_CPU] * MB);
+        HybridPath path = (fpga_seconds <= cpu_seconds) ? PATH_FPGA : PATH_CPU;
+        plan.files[path].push_back(file.second);
+        plan.bytes[path] += file.first;
+        plan.seconds[path] = (path == PATH_FPGA) ? fpga_seconds : cpu_seconds;
+    }
+    return plan;
+}
+
+void HybridScheduler::update(HybridPath path, uint64_t bytes, double seconds)
+{
+    if (bytes == 0 || seconds <= 0) return;
+    double measured = bytes / MB / seconds;
+    m_mbps[path] = (1 - HYBRID_UPDATE_WEIGHT) * m_mbps[path] + HYBRID_UPDATE_WEIGHT * measured;
+}
+
+bool HybridScheduler::load(const std::string& path)
+{
+    std::ifstream in(path.c_str());
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string operation, name;
+        double mbps;
+        if (!(fields >> operation >> name >> mbps) || operation != m_operation || mbps <= 0) continue;
+        for (uint32_t p = 0; p < PATH_COUNT; p++) {
+            if (name == pathName((HybridPath)p)) m_mbps[p] = mbps;
+        }
+    }
+    return true;
+}
+
+bool HybridScheduler::save(const std::string& path) const
+{
+    std::vector<std::string> kept;
+    std::ifstream in(path.c_str());
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string operation;
+        if (fields >> operation && operation != m_operation) kept.push_back(line);
+    }
+    in.close();
+
+    std::ofstream out(path.c_str(), std::ofstream::trunc);
+    if (!out) {
+        std::cout << "Unable to write hybrid profile " << path << std::endl;
+        return false;
+    }
+    for (const std::string& other : kept) out << other << "\n";
+    for (uint32_t p = 0; p < PATH_COUNT; p++) {
+        out << m_operation << " " << pathName((HybridPath)p) << " " << m_mbps[p] << "\n";
+    }
+    return true;
+}
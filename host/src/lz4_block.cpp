@@ -0,0 +1,313 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "lz4_block.hpp"
+#include "../../kernel/include/lz_entropy.hpp"
+#include <string.h>
+#include <vector>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#define LZ4_MIN_MATCH 4
+// The last match starts at least 12 bytes before the end of the block
+#define LZ4_MF_LIMIT 12
+// and the last 5 bytes are always literals
+#define LZ4_LAST_LITERALS 5
+#define LZ4_MAX_OFFSET 65535
+#define LZ4_HASH_LOG 14
+// Search step grows by one every 2^LZ4_SKIP_TRIGGER misses
+#define LZ4_SKIP_TRIGGER 6
+#define LZ4_COPY_WIDTH 16
+
+static inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t read64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t hash4(uint32_t v) {
+    return (v * 2654435761U) >> (32 - LZ4_HASH_LOG);
+}
+
+static inline void copy16(uint8_t* dst, const uint8_t* src) {
+#if defined(__SSE2__)
+    _mm_storeu_si128((__m128i*)dst, _mm_loadu_si128((const __m128i*)src));
+#else
+    memcpy(dst, src, 16);
+#endif
+}
+
+// Copies len bytes in 16 byte steps, reads and writes up to 15 bytes past the end
+static inline void wildCopy(uint8_t* dst, const uint8_t* src, uint32_t len) {
+    uint8_t* end = dst + len;
+    do {
+        copy16(dst, src);
+        dst += LZ4_COPY_WIDTH;
+        src += LZ4_COPY_WIDTH;
+    } while (dst < end);
+}
+
+// Number of equal bytes at a and b (b < a), a is not read at or past limit
+static inline uint32_t matchLength(const uint8_t* a, const uint8_t* b, const uint8_t* limit) {
+    const uint8_t* start = a;
+#if defined(__AVX2__)
+    while (a + 32 <= limit) {
+        __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)a), _mm256_loadu_si256((const __m256i*)b));
+        uint32_t mask = _mm256_movemask_epi8(eq);
+        if (mask != 0xFFFFFFFF) return (a - start) + __builtin_ctz(~mask);
+        a += 32;
+        b += 32;
+    }
+#endif
+#if defined(__SSE2__)
+    while (a + 16 <= limit) {
+        __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)a), _mm_loadu_si128((const __m128i*)b));
+        uint32_t mask = _mm_movemask_epi8(eq);
+        if (mask != 0xFFFF) return (a - start) + __builtin_ctz(~mask);
+        a += 16;
+        b += 16;
+    }
+#endif
+    while (a + 8 <= limit) {
+        // Little endian: the lowest set bit is the first differing byte
+        uint64_t diff = read64(a) ^ read64(b);
+        if (diff) return (a - start) + (__builtin_ctzll(diff) >> 3);
+        a += 8;
+        b += 8;
+    }
+    while (a < limit && *a == *b) {
+        a++;
+        b++;
+    }
+    return a - start;
+}
+
+static inline uint8_t* writeLength(uint8_t* op, uint32_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = len;
+    return op;
+}
+
+uint32_t lz4CompressBlock(const uint8_t* src, uint32_t size, uint8_t* dst, uint32_t capacity, uint32_t prefix) {
+    // Positions relative to the start of the prefix, cleared per block so the output does not depend on the
+    // previous block, then filled with the prefix
+    static thread_local std::vector<uint32_t> table(1 << LZ4_HASH_LOG);
+    memset(table.data(), 0, table.size() * sizeof(uint32_t));
+    const uint8_t* base = src - prefix;
+    for (uint32_t p = 0; p + LZ4_MIN_MATCH <= prefix; p++) table[hash4(read32(base + p))] = p;
+
+    const uint8_t* ip = src;
+    const uint8_t* anchor = src;
+    const uint8_t* iend = src + size;
+    const uint8_t* mflimit = iend - LZ4_MF_LIMIT;
+    const uint8_t* matchlimit = iend - LZ4_LAST_LITERALS;
+    uint8_t* op = dst;
+    uint8_t* oend = dst + capacity;
+
+    if (size > LZ4_MF_LIMIT) {
+        if (prefix == 0) ip++;
+        while (true) {
+            // Find a match, skipping faster over data that does not compress
+            const uint8_t* ref;
+            const uint8_t* forward = ip;
+            uint32_t search = 1 << LZ4_SKIP_TRIGGER;
+            do {
+                uint32_t h = hash4(read32(forward));
+                ip = forward;
+                forward += search++ >> LZ4_SKIP_TRIGGER;
+                if (forward > mflimit) goto last_literals;
+                ref = base + table[h];
+                table[h] = ip - base;
+            } while (ref >= ip || ref + LZ4_MAX_OFFSET < ip || read32(ref) != read32(ip));
+
+            while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+
+            // Literals
+            uint32_t lit = ip - anchor;
+            uint8_t* token = op++;
+            if (op + lit + lit / 255 + 2 + LZ4_LAST_LITERALS + 1 > oend) return 0;
+            if (lit >= 15) {
+                *token = 15 << 4;
+                op = writeLength(op, lit - 15);
+            } else {
+                *token = lit << 4;
+            }
+            if (anchor + lit + LZ4_COPY_WIDTH <= iend && op + lit + LZ4_COPY_WIDTH <= oend) {
+                wildCopy(op, anchor, lit);
+            } else {
+                memcpy(op, anchor, lit);
+            }
+            op += lit;
+
+            while (true) {
+                // Offset and match length
+                uint32_t offset = ip - ref;
+                *op++ = offset;
+                *op++ = offset >> 8;
+                uint32_t ml = matchLength(ip + LZ4_MIN_MATCH, ref + LZ4_MIN_MATCH, matchlimit);
+                ip += LZ4_MIN_MATCH + ml;
+                if (op + ml / 255 + 1 + LZ4_LAST_LITERALS + 1 > oend) return 0;
+                if (ml >= 15) {
+                    *token += 15;
+                    op = writeLength(op, ml - 15);
+                } else {
+                    *token += ml;
+                }
+                anchor = ip;
+                if (ip > mflimit) goto last_literals;
+
+                table[hash4(read32(ip - 2))] = ip - 2 - base;
+
+                // A match right at ip needs no literals
+                uint32_t h = hash4(read32(ip));
+                ref = base + table[h];
+                table[h] = ip - base;
+                if (ref >= ip || ref + LZ4_MAX_OFFSET < ip || read32(ref) != read32(ip)) break;
+                token = op++;
+                *token = 0;
+            }
+            ip++;
+        }
+    }
+
+last_literals:
+    uint32_t lit = iend - anchor;
+    if (op + 1 + lit / 255 + 1 + lit > oend) return 0;
+    if (lit >= 15) {
+        *op++ = 15 << 4;
+        op = writeLength(op, lit - 15);
+    } else {
+        *op++ = lit << 4;
+    }
+    memcpy(op, anchor, lit);
+    op += lit;
+    return op - dst;
+}
+
+uint32_t lz4BlockEntropy(const uint8_t* src, uint32_t size) {
+    uint32_t histogram[256] = {0};
+    if (size <= ENTROPY_SAMPLE_BYTES) {
+        for (uint32_t i = 0; i < size; i++) histogram[src[i]]++;
+    } else {
+        for (uint32_t c = 0; c < ENTROPY_SAMPLE_CHUNKS; c++) {
+            const uint8_t* chunk = src + entropyChunkOffset(size, c);
+            for (uint32_t i = 0; i < ENTROPY_CHUNK_BYTES; i++) histogram[chunk[i]]++;
+        }
+    }
+    uint64_t sum_sq = 0;
+    for (uint32_t s = 0; s < 256; s++) sum_sq += (uint64_t)histogram[s] * histogram[s];
+    return entropyEstimate(sum_sq, size < ENTROPY_SAMPLE_BYTES ? size : ENTROPY_SAMPLE_BYTES);
+}
+
+int32_t lz4DecompressBlock(const uint8_t* src, uint32_t size, uint8_t* dst, uint32_t capacity, uint32_t prefix) {
+    const uint8_t* ip = src;
+    const uint8_t* iend = src + size;
+    uint8_t* op = dst;
+    uint8_t* oend = dst + capacity;
+
+    while (ip < iend) {
+        uint32_t token = *ip++;
+
+        uint32_t lit = token >> 4;
+        if (lit == 15) {
+            uint32_t b;
+            do {
+                if (ip >= iend) return -1;
+                b = *ip++;
+                lit += b;
+            } while (b == 255);
+        }
+        if (lit > (uint32_t)(iend - ip) || lit > (uint32_t)(oend - op)) return -1;
+        if (ip + lit + LZ4_COPY_WIDTH <= iend && op + lit + LZ4_COPY_WIDTH <= oend) {
+            wildCopy(op, ip, lit);
+        } else {
+            memcpy(op, ip, lit);
+        }
+        ip += lit;
+        op += lit;
+        // The last sequence has no match
+        if (ip == iend) break;
+
+        if (iend - ip < 2) return -1;
+        uint32_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (uint32_t)(op - dst) + prefix) return -1;
+
+        uint32_t ml = token & 15;
+        if (ml == 15) {
+            uint32_t b;
+            do {
+                if (ip >= iend) return -1;
+                b = *ip++;
+                ml += b;
+            } while (b == 255);
+        }
+        ml += LZ4_MIN_MATCH;
+        if (ml > (uint32_t)(oend - op)) return -1;
+
+        const uint8_t* match = op - offset;
+        if (offset >= LZ4_COPY_WIDTH && op + ml + LZ4_COPY_WIDTH <= oend) {
+            // Every 16 byte chunk is read from bytes written before it
+            wildCopy(op, match, ml);
+        } else if (offset == 1) {
+            memset(op, *match, ml);
+        } else if (op + ml + 8 <= oend) {
+            // Short offsets repeat a pattern: write one period of at least 8 bytes, then copy 8 byte words
+            // from that far back, which holds the same bytes
+            uint32_t period = (offset >= 8) ? offset : offset * ((8 + offset - 1) / offset);
+            uint32_t k = 0;
+            for (; k < period && k < ml; k++) op[k] = match[k];
+            for (; k < ml; k += 8) memcpy(op + k, op + k - period, 8);
+        } else {
+            for (uint32_t k = 0; k < ml; k++) op[k] = match[k];
+        }
+        op += ml;
+    }
+    return op - dst;
+}
+
+// The dictionary and the block go into one window, the block codecs then see the dictionary as a prefix
+uint32_t lz4CompressBlockDict(const uint8_t* dict, uint32_t dict_size, const uint8_t* src, uint32_t size, uint8_t* dst,
+                              uint32_t capacity) {
+    static thread_local std::vector<uint8_t> window;
+    window.resize(dict_size + size);
+    memcpy(window.data(), dict, dict_size);
+    memcpy(window.data() + dict_size, src, size);
+    return lz4CompressBlock(window.data() + dict_size, size, dst, capacity, dict_size);
+}
+
+int32_t lz4DecompressBlockDict(const uint8_t* dict, uint32_t dict_size, const uint8_t* src, uint32_t size, uint8_t* dst,
+                               uint32_t capacity) {
+    static thread_local std::vector<uint8_t> window;
+    window.resize(dict_size + capacity);
+    memcpy(window.data(), dict, dict_size);
+    int32_t out_size = lz4DecompressBlock(src, size, window.data() + dict_size, capacity, dict_size);
+    if (out_size > 0) memcpy(dst, window.data() + dict_size, out_size);
+    return out_size;
+}
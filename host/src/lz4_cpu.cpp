@@ -0,0 +1,554 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "lz4_cpu.hpp"
+#include <atomic>
+#include <fcntl.h>
+#include <functional>
+#include <thread>
+#include <unistd.h>
+#include "lz4_block.hpp"
+#include "lz4_dict.hpp"
+#include "lz4_frame.hpp"
+#include "xxhash.h"
+#include "xxhash_simd.hpp"
+#include "../../kernel/include/lz_entropy.hpp"
+
+#define KB 1024
+#define RESIDUE_4K 4096
+#define BLOCK_HEADER_SIZE 4
+#define END_MARK_SIZE 4
+#define STORED_BLOCK_FLAG 0x80000000
+
+static void writeLE32(uint8_t* out, uint32_t value)
+{
+    out[0] = value;
+    out[1] = value >> 8;
+    out[2] = value >> 16;
+    out[3] = value >> 24;
+}
+
+static uint32_t readLE32(const uint8_t* in)
+{
+    return in[0] | (in[1] << 8) | (in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static uint32_t threadCount(uint32_t num_threads)
+{
+    if (num_threads == 0) num_threads = std::thread::hardware_concurrency();
+    return (num_threads == 0) ? 1 : num_threads;
+}
+
+// Runs fn(0) ~ fn(count - 1) on num_threads threads, the caller being one of them
+static void parallelFor(uint32_t count, uint32_t num_threads, const std::function<void(uint32_t)>& fn)
+{
+    std::atomic<uint32_t> next(0);
+    auto worker = [&]() {
+        for (uint32_t idx = next++; idx < count; idx = next++) fn(idx);
+    };
+    std::vector<std::thread> pool;
+    for (uint32_t t = 1; t < num_threads && t < count; t++) pool.emplace_back(worker);
+    worker();
+    for (std::thread& thread : pool) thread.join();
+}
+
+// Per-file span of the blocks, from the first start to the last end
+static void recordBlockSpans(const std::vector<cpuBlock>& blocks, uint32_t num_files, const std::string& name,
+                             Metrics& metrics, Tracer& tracer)
+{
+    for (uint32_t fid = 0; fid < num_files; fid++) {
+        bool found = false;
+        std::chrono::high_resolution_clock::time_point start, end;
+        for (const cpuBlock& block : blocks) {
+            if (block.fid != fid) continue;
+            if (!found || block.start < start) start = block.start;
+            if (!found || block.end > end) end = block.end;
+            found = true;
+        }
+        if (!found) continue;
+        metrics.record(STAGE_KERNEL, fid, std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        tracer.hostSpan(name, fid, start, end);
+    }
+}
+
+static void printReport(const std::string& title, const std::chrono::duration<double, std::nano>& time,
+                        uint64_t bytes, uint32_t num_threads)
+{
+    std::cout << "########################### CPU Operation ############################################" << std::endl;
+    std::cout << "\x1B[32m[CPU Operation]\033[0m " << title << " Time : " << std::fixed << std::setprecision(2) << time.count() << " ns" << std::endl;
+    std::cout << "\x1B[32m[CPU Operation]\033[0m Threads : " << num_threads << std::endl;
+    if (time.count() > 0) {
+        std::cout << "\x1B[32m[CPU Operation]\033[0m Throughput : " << std::fixed << std::setprecision(2)
+                  << (double)bytes * 1000 / time.count() << " MB/s" << std::endl;
+    }
+}
+
+CpuCompress::CpuCompress(bool p2p_enable, uint32_t block_kb, uint32_t num_threads, bool checksum, bool block_index)
+    : SmartSSD(p2p_enable)
+{
+    if (block_kb != 64 && block_kb != 256 && block_kb != 1024 && block_kb != 4096) {
+        std::cout << "Valid block size not given, setting to 64K" << std::endl;
+        block_kb = 64;
+    }
+    m_BlockSizeInKb = block_kb;
+    m_numThreads = threadCount(num_threads);
+    m_checksum = checksum;
+    m_blockIndex = block_index;
+    m_zoneMap = false;
+    m_scratch = NULL;
+    m_metrics.setOperation("compress");
+
+    m_compression_time = std::chrono::milliseconds::zero();
+}
+
+CpuCompress::~CpuCompress()
+{
+    uint64_t bytes = 0;
+    for (uint32_t i = 0; i < m_InputFileSizeVec.size(); i++) bytes += m_InputFileSizeVec[i];
+    printReport("Compression", m_compression_time, bytes, m_numThreads);
+    free(m_scratch);
+}
+
+void CpuCompress::setZoneMap(const dt_zoneConfig& config)
+{
+    m_zoneConfig = config;
+    m_zoneMap = true;
+}
+
+void CpuCompress::MakeOutputFileList(const std::vector<std::string>& inputFile)
+{
+    for (std::string inFile : inputFile)
+    {
+        std::string out_file = inFile + ".lz4";
+        m_OutputFileNameVec.push_back(out_file);
+    }
+}
+
+void CpuCompress::SetOutputFileSize()
+{
+    uint32_t block_size_in_bytes = m_BlockSizeInKb * KB;
+    outputFileSizeVec.clear();
+    for (uint32_t input_size : m_InputFileSizeVec) {
+        uint64_t num_blocks = (input_size - 1) / block_size_in_bytes + 1;
+        uint64_t block_overhead = BLOCK_HEADER_SIZE + (m_checksum ? CHECKSUM_SIZE : 0);
+        uint64_t frame_size = MAX_HEADER_SIZE + num_blocks * block_overhead + input_size + END_MARK_SIZE + CHECKSUM_SIZE;
+        if (m_blockIndex) frame_size += BLOCK_INDEX_SIZE(num_blocks);
+        if (m_zoneMap) frame_size += ZONE_MAP_SIZE(num_blocks);
+        outputFileSizeVec.push_back(((frame_size - 1) / RESIDUE_4K + 1) * RESIDUE_4K);
+    }
+}
+
+void CpuCompress::preProcess()
+{
+    if (m_InputFileSizeVec.size() <= 0)
+    {
+        std::cout << "Set Input File First\n" << std::endl;
+        exit(1);
+    }
+
+    uint32_t block_size_in_bytes = m_BlockSizeInKb * KB;
+    uint64_t scratch_size = 0;
+    for (uint32_t i = 0; i < m_InputFileDescVec.size(); i++) {
+        headerSizeVec.push_back(lz4FrameHeader(m_OutputHostMappedBufVec[i], m_BlockSizeInKb, m_InputFileSizeVec[i], m_checksum, m_dictId));
+        compressedSizeVec.push_back(0);
+        contentChecksumVec.push_back(0);
+        blockIndexVec.push_back(std::vector<lz4BlockIndexEntry>());
+        zoneMapVec.push_back(std::vector<lz4ZoneEntry>());
+        firstBlockVec.push_back(m_blocks.size());
+
+        // Blocks only get a compressed copy when it is smaller than the block
+        for (uint64_t offset = 0; offset < m_InputFileSizeVec[i]; offset += block_size_in_bytes) {
+            cpuBlock block;
+            block.fid = i;
+            block.srcOffset = offset;
+            block.srcSize = std::min<uint64_t>(block_size_in_bytes, m_InputFileSizeVec[i] - offset);
+            block.dstOffset = scratch_size;
+            block.dstSize = 0;
+            block.stored = false;
+            m_blocks.push_back(block);
+            scratch_size += block.srcSize;
+        }
+    }
+    m_scratch = (uint8_t*)malloc(scratch_size);
+    if (m_zoneMap) m_zones.resize(m_blocks.size());
+}
+
+void CpuCompress::run()
+{
+    auto comp_start = std::chrono::high_resolution_clock::now();
+    parallelFor(m_blocks.size(), m_numThreads, [this](uint32_t idx) {
+        cpuBlock& block = m_blocks[idx];
+        block.start = std::chrono::high_resolution_clock::now();
+        const uint8_t* src = m_InputHostMappedBufVec[block.fid] + block.srcOffset;
+        // High entropy blocks are stored without a match search, as xilLz4Compress does
+        block.dstSize = 0;
+        if (lz4BlockEntropy(src, block.srcSize) < ENTROPY_RAW_THRESHOLD) {
+            if (m_dict.empty()) {
+                block.dstSize = lz4CompressBlock(src, block.srcSize, m_scratch + block.dstOffset, block.srcSize - 1);
+            } else {
+                block.dstSize = lz4CompressBlockDict(m_dict.data(), m_dict.size(), src, block.srcSize,
+                                                     m_scratch + block.dstOffset, block.srcSize - 1);
+            }
+        }
+        block.stored = (block.dstSize == 0);
+        if (block.stored) block.dstSize = block.srcSize;
+        if (m_zoneMap) zoneMapBlock(m_zoneConfig, src, block.srcSize, m_zones[idx]);
+        block.end = std::chrono::high_resolution_clock::now();
+    });
+    if (m_checksum) {
+        parallelFor(m_InputFileDescVec.size(), m_numThreads, [this](uint32_t fid) {
+            contentChecksumVec[fid] = XXH32(m_InputHostMappedBufVec[fid], m_InputFileSizeVec[fid], 0);
+        });
+    }
+    if (m_zoneMap) {
+        parallelFor(m_InputFileDescVec.size(), m_numThreads, [this](uint32_t fid) {
+            zoneMapJoin(m_zoneConfig, m_InputHostMappedBufVec[fid], m_InputFileSizeVec[fid], m_BlockSizeInKb * KB,
+                        &m_zones[firstBlockVec[fid]], zoneMapVec[fid]);
+        });
+    }
+
+    // Lay the blocks out behind the header and copy them in parallel
+    uint32_t checksum_size = m_checksum ? CHECKSUM_SIZE : 0;
+    std::vector<uint64_t> frameOffset(m_blocks.size());
+    std::vector<uint64_t> fileOffset(headerSizeVec.begin(), headerSizeVec.end());
+    for (uint32_t idx = 0; idx < m_blocks.size(); idx++) {
+        frameOffset[idx] = fileOffset[m_blocks[idx].fid];
+        fileOffset[m_blocks[idx].fid] += BLOCK_HEADER_SIZE + m_blocks[idx].dstSize + checksum_size;
+        if (m_blockIndex) blockIndexVec[m_blocks[idx].fid].push_back({(uint32_t)frameOffset[idx], (uint32_t)m_blocks[idx].srcOffset});
+    }
+    // A group of hashLanes() blocks is copied, then its block checksums are computed side by side
+    uint32_t lanes = hashLanes();
+    parallelFor((m_blocks.size() + lanes - 1) / lanes, m_numThreads, [&](uint32_t group) {
+        uint32_t first = group * lanes;
+        uint32_t count = std::min<uint32_t>(lanes, m_blocks.size() - first);
+        const uint8_t* data[HASH_MAX_LANES];
+        size_t sizes[HASH_MAX_LANES];
+        uint32_t hashes[HASH_MAX_LANES];
+        for (uint32_t i = 0; i < count; i++) {
+            const cpuBlock& block = m_blocks[first + i];
+            uint8_t* out = m_OutputHostMappedBufVec[block.fid] + frameOffset[first + i];
+            writeLE32(out, block.dstSize | (block.stored ? STORED_BLOCK_FLAG : 0));
+            const uint8_t* src = block.stored ? m_InputHostMappedBufVec[block.fid] + block.srcOffset : m_scratch + block.dstOffset;
+            memcpy(out + BLOCK_HEADER_SIZE, src, block.dstSize);
+            data[i] = out + BLOCK_HEADER_SIZE;
+            sizes[i] = block.dstSize;
+        }
+        if (!m_checksum) return;
+        xxh32Blocks(data, sizes, count, 0, hashes);
+        for (uint32_t i = 0; i < count; i++) writeLE32((uint8_t*)data[i] + sizes[i], hashes[i]);
+    });
+    for (uint32_t i = 0; i < fileOffset.size(); i++) compressedSizeVec[i] = fileOffset[i];
+    auto comp_end = std::chrono::high_resolution_clock::now();
+    m_compression_time = std::chrono::duration<double, std::nano>(comp_end - comp_start);
+
+    recordBlockSpans(m_blocks, m_InputFileDescVec.size(), "compress", m_metrics, m_tracer);
+}
+
+void CpuCompress::postProcess()
+{
+    for (uint32_t i = 0; i < m_InputFileDescVec.size(); i++) {
+        auto pad_start = std::chrono::high_resolution_clock::now();
+        // End mark, content checksum, block index and zone map frames and the zeros up to the next 4K boundary
+        uint32_t compressed_size = compressedSizeVec[i];
+        uint32_t trailer_size = END_MARK_SIZE + (m_checksum ? CHECKSUM_SIZE : 0);
+        uint32_t index_size = m_blockIndex ? BLOCK_INDEX_SIZE(blockIndexVec[i].size()) : 0;
+        uint32_t zone_size = m_zoneMap ? ZONE_MAP_SIZE(zoneMapVec[i].size()) : 0;
+        uint32_t padded_size = ((compressed_size + trailer_size + index_size + zone_size - 1) / RESIDUE_4K + 1) * RESIDUE_4K;
+        memset(m_OutputHostMappedBufVec[i] + compressed_size, 0, padded_size - compressed_size);
+        if (m_checksum) writeLE32(m_OutputHostMappedBufVec[i] + compressed_size + END_MARK_SIZE, contentChecksumVec[i]);
+        if (m_blockIndex) lz4WriteBlockIndex(m_OutputHostMappedBufVec[i] + compressed_size + trailer_size, blockIndexVec[i]);
+        if (m_zoneMap) {
+            lz4WriteZoneMap(m_OutputHostMappedBufVec[i] + compressed_size + trailer_size + index_size, m_zoneConfig,
+                            zoneMapVec[i]);
+        }
+        outputFileSizeVec[i] = padded_size;
+        auto pad_end = std::chrono::high_resolution_clock::now();
+        m_metrics.record(STAGE_PAD, i, std::chrono::duration_cast<std::chrono::nanoseconds>(pad_end - pad_start).count());
+        m_tracer.hostSpan("pad", i, pad_start, pad_end);
+    }
+}
+
+CpuDecompress::CpuDecompress(bool p2p_enable, uint32_t num_threads)
+    : SmartSSD(p2p_enable)
+{
+    m_numThreads = threadCount(num_threads);
+    m_metrics.setOperation("decompress");
+    m_decompression_time = std::chrono::milliseconds::zero();
+}
+
+CpuDecompress::~CpuDecompress()
+{
+    uint64_t bytes = 0;
+    for (uint64_t size : contentSizeVec) bytes += size;
+    printReport("Decompression", m_decompression_time, bytes, m_numThreads);
+}
+
+void CpuDecompress::MakeOutputFileList(const std::vector<std::string>& inputFile)
+{
+    for (std::string inFile : inputFile)
+    {
+        std::string out_file = inFile + ".org";
+        m_OutputFileNameVec.push_back(out_file);
+
+        lz4FrameInfo info;
+        lz4ReadFrameHeader(inFile, info);
+        // Blocks are decoded in parallel into an output sized up front
+        if (!(info.flags & FLG_BLOCK_INDEPENDENT) || !(info.flags & FLG_CONTENT_SIZE)) {
+            std::cout << inFile << ": CPU backend needs independent blocks and the content size" << std::endl;
+            exit(1);
+        }
+        lz4CheckDictionary(inFile, info, m_dict);
+
+        uint64_t content_size = info.contentSize;
+        headerSizeVec.push_back(info.headerSize);
+        blockSizeVec.push_back(info.blockSize);
+        contentSizeVec.push_back(content_size);
+        blockChecksumVec.push_back(info.flags & FLG_BLOCK_CHECKSUM);
+        contentChecksumVec.push_back(info.flags & FLG_CONTENT_CHECKSUM);
+        dictVec.push_back(info.flags & FLG_DICT_ID);
+        outputFileSizeVec.push_back(((content_size - 1) / RESIDUE_4K + 1) * RESIDUE_4K);
+    }
+}
+
+void CpuDecompress::preProcess()
+{
+    for (uint32_t fid = 0; fid < m_InputFileDescVec.size(); fid++) {
+        const uint8_t* in = m_InputHostMappedBufVec[fid];
+        uint64_t in_size = m_InputFileSizeVec[fid];
+        uint64_t offset = headerSizeVec[fid];
+        uint64_t dst_offset = 0;
+        while (true) {
+            if (offset + BLOCK_HEADER_SIZE > in_size) {
+                std::cout << m_InputFileNameVec[fid] << ": truncated frame" << std::endl;
+                exit(1);
+            }
+            uint32_t block_header = readLE32(in + offset);
+            offset += BLOCK_HEADER_SIZE;
+            if (block_header == 0) break;
+
+            cpuBlock block;
+            block.fid = fid;
+            block.srcOffset = offset;
+            block.srcSize = block_header & ~STORED_BLOCK_FLAG;
+            block.stored = (block_header & STORED_BLOCK_FLAG);
+            block.dstOffset = dst_offset;
+            block.dstSize = std::min<uint64_t>(blockSizeVec[fid], contentSizeVec[fid] - std::min(dst_offset, contentSizeVec[fid]));
+            if (block.srcSize > blockSizeVec[fid] || offset + block.srcSize > in_size || block.dstSize == 0) {
+                std::cout << m_InputFileNameVec[fid] << ": corrupt block at " << offset - BLOCK_HEADER_SIZE << std::endl;
+                exit(1);
+            }
+            if (blockChecksumVec[fid] && offset + block.srcSize + CHECKSUM_SIZE > in_size) {
+                std::cout << m_InputFileNameVec[fid] << ": truncated frame" << std::endl;
+                exit(1);
+            }
+            m_blocks.push_back(block);
+            offset += block.srcSize + (blockChecksumVec[fid] ? CHECKSUM_SIZE : 0);
+            dst_offset += block.dstSize;
+        }
+        // The content checksum follows the end mark
+        if (contentChecksumVec[fid] && offset + CHECKSUM_SIZE > in_size) {
+            std::cout << m_InputFileNameVec[fid] << ": truncated frame" << std::endl;
+            exit(1);
+        }
+        contentChecksumOffsetVec.push_back(offset);
+        if (dst_offset != contentSizeVec[fid]) {
+            std::cout << m_InputFileNameVec[fid] << ": frame holds " << dst_offset << " B, header says " << contentSizeVec[fid] << " B" << std::endl;
+            exit(1);
+        }
+    }
+}
+
+void CpuDecompress::run()
+{
+    std::atomic<bool> failed(false);
+    std::atomic<bool> mismatch(false);
+    auto dec_start = std::chrono::high_resolution_clock::now();
+    // Block checksums are verified a group of hashLanes() blocks at a time
+    uint32_t lanes = hashLanes();
+    parallelFor((m_blocks.size() + lanes - 1) / lanes, m_numThreads, [&](uint32_t group) {
+        uint32_t first = group * lanes;
+        uint32_t end = std::min<uint32_t>(first + lanes, m_blocks.size());
+        const uint8_t* data[HASH_MAX_LANES];
+        size_t sizes[HASH_MAX_LANES];
+        uint32_t idx[HASH_MAX_LANES];
+        uint32_t hashes[HASH_MAX_LANES];
+        uint32_t count = 0;
+        for (uint32_t i = first; i < end; i++) {
+            if (!blockChecksumVec[m_blocks[i].fid]) continue;
+            data[count] = m_InputHostMappedBufVec[m_blocks[i].fid] + m_blocks[i].srcOffset;
+            sizes[count] = m_blocks[i].srcSize;
+            idx[count++] = i;
+        }
+        xxh32Blocks(data, sizes, count, 0, hashes);
+        for (uint32_t i = 0; i < count; i++) {
+            if (hashes[i] == readLE32(data[i] + sizes[i])) continue;
+            const cpuBlock& block = m_blocks[idx[i]];
+            std::cout << "Error: " << m_InputFileNameVec[block.fid] << " block " << block.dstOffset / blockSizeVec[block.fid]
+                      << " checksum mismatch" << std::endl;
+            mismatch = true;
+        }
+    });
+    parallelFor(m_blocks.size(), m_numThreads, [&](uint32_t idx) {
+        cpuBlock& block = m_blocks[idx];
+        block.start = std::chrono::high_resolution_clock::now();
+        const uint8_t* src = m_InputHostMappedBufVec[block.fid] + block.srcOffset;
+        uint8_t* dst = m_OutputHostMappedBufVec[block.fid] + block.dstOffset;
+        if (block.stored) {
+            if (block.srcSize != block.dstSize) failed = true;
+            memcpy(dst, src, std::min(block.srcSize, block.dstSize));
+        } else if (dictVec[block.fid]) {
+            if (lz4DecompressBlockDict(m_dict.data(), m_dict.size(), src, block.srcSize, dst, block.dstSize) !=
+                (int32_t)block.dstSize) {
+                failed = true;
+            }
+        } else if (lz4DecompressBlock(src, block.srcSize, dst, block.dstSize) != (int32_t)block.dstSize) {
+            failed = true;
+        }
+        block.end = std::chrono::high_resolution_clock::now();
+    });
+    if (!failed) {
+        parallelFor(m_InputFileDescVec.size(), m_numThreads, [&](uint32_t fid) {
+            if (!contentChecksumVec[fid]) return;
+            const uint8_t* expected = m_InputHostMappedBufVec[fid] + contentChecksumOffsetVec[fid];
+            if (XXH32(m_OutputHostMappedBufVec[fid], contentSizeVec[fid], 0) != readLE32(expected)) {
+                std::cout << "Error: " << m_InputFileNameVec[fid] << " content checksum mismatch" << std::endl;
+                mismatch = true;
+            }
+        });
+    }
+    auto dec_end = std::chrono::high_resolution_clock::now();
+    m_decompression_time = std::chrono::duration<double, std::nano>(dec_end - dec_start);
+
+    if (failed) {
+        std::cout << "Error: corrupt LZ4 block, decompression failed" << std::endl;
+        exit(1);
+    }
+    if (mismatch) exit(1);
+    recordBlockSpans(m_blocks, m_InputFileDescVec.size(), "decompress", m_metrics, m_tracer);
+}
+
+void CpuDecompress::postProcess()
+{
+    for (uint32_t i = 0; i < m_OutputFileDescVec.size(); i++) {
+        // Zeros up to the 4K boundary of the direct write
+        memset(m_OutputHostMappedBufVec[i] + contentSizeVec[i], 0, outputFileSizeVec[i] - contentSizeVec[i]);
+    }
+}
+
+bool CpuDecompress::readRange(const std::string& file, uint64_t offset, uint64_t length, std::vector<uint8_t>& out)
+{
+    lz4FrameInfo info;
+    lz4ReadFrameHeader(file, info);
+    if (!(info.flags & FLG_BLOCK_INDEPENDENT) || !(info.flags & FLG_CONTENT_SIZE)) {
+        std::cout << file << ": CPU backend needs independent blocks and the content size" << std::endl;
+        exit(1);
+    }
+    lz4CheckDictionary(file, info, m_dict);
+    lz4BlockRange range;
+    if (!lz4FindBlockRange(file, info, offset, length, range)) return false;
+    uint32_t mid = m_metrics.addFile(file);
+
+    // Whole 4K pages around the run of blocks, as the FPGA backend reads them
+    uint64_t read_offset = range.compressedOffset & ~(uint64_t)(RESIDUE_4K - 1);
+    uint64_t read_end = range.compressedOffset + range.compressedSize;
+    uint64_t read_size = ((read_end - read_offset - 1) / RESIDUE_4K + 1) * RESIDUE_4K;
+    uint8_t* in = (uint8_t*)aligned_alloc(RESIDUE_4K, read_size);
+    auto read_start = std::chrono::high_resolution_clock::now();
+    int fd = open(file.c_str(), O_RDONLY | O_DIRECT);
+    if (fd <= 0) {
+        std::cout << "Unable to open input file, fd: " << fd << std::endl;
+        exit(1);
+    }
+    ssize_t ret = pread(fd, in, read_size, read_offset);
+    close(fd);
+    if (ret < (ssize_t)(read_end - read_offset)) {
+        std::cout << "pread() failed with error: " << ret << ", line: " << __LINE__ << std::endl;
+        exit(1);
+    }
+    auto read_end_time = std::chrono::high_resolution_clock::now();
+    m_metrics.record(STAGE_READ, mid, std::chrono::duration_cast<std::chrono::nanoseconds>(read_end_time - read_start).count());
+    m_tracer.hostSpan("read range", mid, read_start, read_end_time);
+
+    bool block_checksum = (info.flags & FLG_BLOCK_CHECKSUM);
+    bool dict = (info.flags & FLG_DICT_ID);
+    std::vector<cpuBlock> blocks(range.numBlocks);
+    uint64_t src_offset = range.compressedOffset - read_offset;
+    for (uint32_t b = 0; b < range.numBlocks; b++) {
+        uint32_t block_header = readLE32(in + src_offset);
+        blocks[b].srcOffset = src_offset + BLOCK_HEADER_SIZE;
+        blocks[b].srcSize = block_header & ~STORED_BLOCK_FLAG;
+        blocks[b].stored = (block_header & STORED_BLOCK_FLAG);
+        blocks[b].dstOffset = (uint64_t)b * info.blockSize;
+        blocks[b].dstSize = std::min<uint64_t>(info.blockSize, range.contentSize - blocks[b].dstOffset);
+        src_offset = blocks[b].srcOffset + blocks[b].srcSize + (block_checksum ? CHECKSUM_SIZE : 0);
+    }
+
+    std::atomic<bool> failed(false);
+    std::atomic<bool> mismatch(false);
+    std::vector<uint8_t> content(range.contentSize);
+    auto dec_start = std::chrono::high_resolution_clock::now();
+    uint32_t lanes = hashLanes();
+    if (block_checksum) {
+        parallelFor((blocks.size() + lanes - 1) / lanes, m_numThreads, [&](uint32_t group) {
+            const uint8_t* data[HASH_MAX_LANES];
+            size_t sizes[HASH_MAX_LANES];
+            uint32_t hashes[HASH_MAX_LANES];
+            uint32_t first = group * lanes;
+            uint32_t count = std::min<uint32_t>(lanes, blocks.size() - first);
+            for (uint32_t i = 0; i < count; i++) {
+                data[i] = in + blocks[first + i].srcOffset;
+                sizes[i] = blocks[first + i].srcSize;
+            }
+            xxh32Blocks(data, sizes, count, 0, hashes);
+            for (uint32_t i = 0; i < count; i++) {
+                if (hashes[i] == readLE32(data[i] + sizes[i])) continue;
+                std::cout << "Error: " << file << " block " << range.firstBlock + first + i << " checksum mismatch" << std::endl;
+                mismatch = true;
+            }
+        });
+    }
+    parallelFor(blocks.size(), m_numThreads, [&](uint32_t idx) {
+        const cpuBlock& block = blocks[idx];
+        if (block.stored) {
+            if (block.srcSize != block.dstSize) failed = true;
+            memcpy(content.data() + block.dstOffset, in + block.srcOffset, std::min(block.srcSize, block.dstSize));
+        } else if (dict) {
+            if (lz4DecompressBlockDict(m_dict.data(), m_dict.size(), in + block.srcOffset, block.srcSize,
+                                       content.data() + block.dstOffset, block.dstSize) != (int32_t)block.dstSize) {
+                failed = true;
+            }
+        } else if (lz4DecompressBlock(in + block.srcOffset, block.srcSize, content.data() + block.dstOffset,
+                                      block.dstSize) != (int32_t)block.dstSize) {
+            failed = true;
+        }
+    });
+    auto dec_end = std::chrono::high_resolution_clock::now();
+    m_decompression_time += std::chrono::duration<double, std::nano>(dec_end - dec_start);
+    m_metrics.record(STAGE_KERNEL, mid, std::chrono::duration_cast<std::chrono::nanoseconds>(dec_end - dec_start).count());
+    m_tracer.hostSpan("decompress range", mid, dec_start, dec_end);
+    free(in);
+
+    if (failed) {
+        std::cout << "Error: corrupt LZ4 block, decompression failed" << std::endl;
+        exit(1);
+    }
+    if (mismatch) return false;
+    uint64_t start = offset - range.contentOffset;
+    uint64_t size = std::min(length, info.contentSize - offset);
+    out.assign(content.begin() + start, content.begin() + start + size);
+    m_metrics.addBytes(mid, range.compressedSize, size);
+    return true;
+}
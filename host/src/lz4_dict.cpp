@@ -0,0 +1,153 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "lz4_dict.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string.h>
+#include <stdlib.h>
+#include "xxhash.h"
+
+// dmer length, segment length and dmer table size of the training
+#define DICT_DMER 8
+#define DICT_SEGMENT 256
+#define DICT_HASH_LOG 20
+
+static inline uint32_t dmerHash(const uint8_t* in)
+{
+    uint64_t v;
+    memcpy(&v, in, sizeof(v));
+    return (v * 0x9E3779B97F4A7C15ULL) >> (64 - DICT_HASH_LOG);
+}
+
+std::vector<uint8_t> lz4TrainDictionary(const std::vector<std::vector<uint8_t> >& samples, uint32_t dict_size)
+{
+    dict_size = std::min<uint32_t>(dict_size, LZ4_DICT_MAX_SIZE);
+    std::vector<uint8_t> corpus;
+    std::vector<uint64_t> sampleEnd;
+    for (const std::vector<uint8_t>& sample : samples) {
+        corpus.insert(corpus.end(), sample.begin(), sample.end());
+        sampleEnd.push_back(corpus.size());
+    }
+    if (corpus.size() <= dict_size) return corpus;
+
+    // Number of samples each dmer occurs in; dmers do not cross sample boundaries
+    std::vector<uint32_t> freq(1 << DICT_HASH_LOG, 0);
+    std::vector<uint32_t> lastSample(1 << DICT_HASH_LOG, UINT32_MAX);
+    std::vector<uint32_t> dmer(corpus.size(), 0);
+    std::vector<bool> valid(corpus.size(), false);
+    uint64_t start = 0;
+    for (uint32_t s = 0; s < sampleEnd.size(); s++) {
+        for (uint64_t p = start; p + DICT_DMER <= sampleEnd[s]; p++) {
+            uint32_t h = dmerHash(&corpus[p]);
+            dmer[p] = h;
+            valid[p] = true;
+            if (lastSample[h] != s) {
+                lastSample[h] = s;
+                freq[h]++;
+            }
+        }
+        start = sampleEnd[s];
+    }
+
+    // One segment per epoch, the dictionary is filled from its end
+    uint32_t num_epochs = std::max<uint32_t>(dict_size / DICT_SEGMENT, 1);
+    uint64_t epoch_size = corpus.size() / num_epochs;
+    std::vector<uint8_t> dict(dict_size);
+    uint32_t tail = dict_size;
+    for (uint32_t e = 0; e < num_epochs && tail > 0; e++) {
+        uint64_t begin = e * epoch_size;
+        uint64_t end = (e + 1 == num_epochs) ? corpus.size() : begin + epoch_size;
+        uint32_t segment = std::min<uint64_t>(std::min<uint32_t>(DICT_SEGMENT, tail), end - begin);
+        if (segment < DICT_DMER) continue;
+
+        // Sliding sum of the dmer counts starting in [p, p + segment - DICT_DMER]
+        uint32_t span = segment - DICT_DMER + 1;
+        uint64_t score = 0;
+        for (uint64_t p = begin; p < begin + span; p++) {
+            if (valid[p]) score += freq[dmer[p]];
+        }
+        uint64_t best_score = score;
+        uint64_t best = begin;
+        for (uint64_t p = begin + 1; p + segment <= end; p++) {
+            if (valid[p - 1]) score -= freq[dmer[p - 1]];
+            if (valid[p + span - 1]) score += freq[dmer[p + span - 1]];
+            if (score > best_score) {
+                best_score = score;
+                best = p;
+            }
+        }
+        if (best_score == 0) continue;
+
+        // Covered dmers add nothing to later segments
+        for (uint64_t p = best; p < best + span; p++) {
+            if (valid[p]) freq[dmer[p]] = 0;
+        }
+        tail -= segment;
+        memcpy(&dict[tail], &corpus[best], segment);
+    }
+    dict.erase(dict.begin(), dict.begin() + tail);
+    return dict;
+}
+
+uint32_t lz4DictionaryId(const std::vector<uint8_t>& dict)
+{
+    return XXH32(dict.data(), dict.size(), 0);
+}
+
+void lz4LoadDictionary(const std::string& file, std::vector<uint8_t>& dict)
+{
+    std::ifstream in(file.c_str(), std::ifstream::binary | std::ifstream::ate);
+    if (!in) {
+        std::cout << "Unable to open dictionary " << file << std::endl;
+        exit(1);
+    }
+    uint64_t file_size = in.tellg();
+    if (file_size == 0) {
+        std::cout << "Dictionary " << file << " is empty" << std::endl;
+        exit(1);
+    }
+    uint64_t size = std::min<uint64_t>(file_size, LZ4_DICT_MAX_SIZE);
+    dict.resize(size);
+    in.seekg(file_size - size);
+    in.read((char*)dict.data(), size);
+}
+
+void lz4SaveDictionary(const std::string& file, const std::vector<uint8_t>& dict)
+{
+    std::ofstream out(file.c_str(), std::ofstream::binary);
+    out.write((const char*)dict.data(), dict.size());
+    if (!out) {
+        std::cout << "Unable to write dictionary " << file << std::endl;
+        exit(1);
+    }
+}
+
+void lz4CheckDictionary(const std::string& file, const lz4FrameInfo& info, const std::vector<uint8_t>& dict)
+{
+    if (!(info.flags & FLG_DICT_ID)) return;
+    if (dict.empty()) {
+        std::cout << file << " was compressed with dictionary " << std::hex << info.dictId << std::dec
+                  << ", give it with --dict" << std::endl;
+        exit(1);
+    }
+    if (lz4DictionaryId(dict) != info.dictId) {
+        std::cout << file << " was compressed with dictionary " << std::hex << info.dictId << ", not with "
+                  << lz4DictionaryId(dict) << std::dec << std::endl;
+        exit(1);
+    }
+}
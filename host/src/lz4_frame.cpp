@@ -0,0 +1,259 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "lz4_frame.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdlib.h>
+#include "xxhash.h"
+
+#define KB 1024
+// The trailing frames end at most one 4K page of zero padding before the end of the file
+#define TRAILER_TAIL_SEARCH 4096
+
+static uint32_t readLE32(const uint8_t* in)
+{
+    return in[0] | (in[1] << 8) | (in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static uint64_t readLE64(const uint8_t* in)
+{
+    return readLE32(in) | ((uint64_t)readLE32(in + 4) << 32);
+}
+
+static void writeLE32(uint8_t* out, uint32_t value)
+{
+    out[0] = value;
+    out[1] = value >> 8;
+    out[2] = value >> 16;
+    out[3] = value >> 24;
+}
+
+static void writeLE64(uint8_t* out, uint64_t value)
+{
+    writeLE32(out, value);
+    writeLE32(out + 4, value >> 32);
+}
+
+void lz4ReadFrameHeader(const std::string& file, lz4FrameInfo& info)
+{
+    uint8_t header[MAX_HEADER_SIZE] = {0};
+    std::ifstream in(file.c_str(), std::ifstream::binary);
+    in.read((char*)header, sizeof(header));
+    uint32_t magic = readLE32(header);
+    uint8_t flg = header[4];
+    // A frame is at least the header and the end mark, shorter reads fail below
+    if (in.gcount() < 11 || magic != LZ4_MAGIC || (flg & FLG_VERSION_MASK) != FLG_VERSION) {
+        std::cout << file << " is not an LZ4 frame" << std::endl;
+        exit(1);
+    }
+
+    uint32_t desc_size = 2 + ((flg & FLG_CONTENT_SIZE) ? 8 : 0) + ((flg & FLG_DICT_ID) ? 4 : 0);
+    uint8_t checksum = (XXH32(header + 4, desc_size, 0) >> 8) & 0xFF;
+    if (checksum != header[4 + desc_size]) {
+        std::cout << file << ": frame header checksum mismatch" << std::endl;
+        exit(1);
+    }
+
+    uint32_t block_size_code = (header[5] >> 4) & 0x7;
+    if (block_size_code < 4) {
+        std::cout << file << ": invalid block size code " << block_size_code << std::endl;
+        exit(1);
+    }
+
+    info.flags = flg;
+    info.headerSize = 4 + desc_size + 1;
+    info.blockSize = 64 * KB << (2 * (block_size_code - 4));
+    info.contentSize = 0;
+    if (flg & FLG_CONTENT_SIZE) {
+        for (uint32_t b = 0; b < 8; b++) info.contentSize |= (uint64_t)header[6 + b] << (8 * b);
+    }
+    info.dictId = 0;
+    if (flg & FLG_DICT_ID) {
+        info.dictId = readLE32(header + 6 + ((flg & FLG_CONTENT_SIZE) ? 8 : 0));
+    }
+}
+
+// Size of the trailing frame footer_magic ends with count entries, 0 for an unknown footer
+static uint64_t trailerSize(uint32_t footer_magic, uint32_t count)
+{
+    if (footer_magic == BLOCK_INDEX_MAGIC) return BLOCK_INDEX_SIZE(count);
+    if (footer_magic == ZONE_MAP_MAGIC) return ZONE_MAP_SIZE(count);
+    return 0;
+}
+
+// Reads the trailing frame of file that ends in footer_magic, walking back
+// from the zero padding over the trailing frames after it
+static bool readTrailer(const std::string& file,
+                        uint32_t frame_magic,
+                        uint32_t footer_magic,
+                        std::vector<uint8_t>& frame,
+                        uint32_t& count)
+{
+    std::ifstream in(file.c_str(), std::ifstream::binary | std::ifstream::ate);
+    if (!in) return false;
+    uint64_t file_size = in.tellg();
+
+    // Last non-zero byte, the top byte of a footer magic when there is a trailing frame
+    uint64_t tail_size = std::min<uint64_t>(file_size, TRAILER_TAIL_SEARCH + 8);
+    std::vector<uint8_t> tail(tail_size);
+    in.seekg(file_size - tail_size);
+    in.read((char*)tail.data(), tail_size);
+    uint64_t end = tail_size;
+    while (end > 0 && tail[end - 1] == 0) end--;
+    end += file_size - tail_size;
+
+    while (end >= 8) {
+        uint8_t footer[8];
+        in.seekg(end - 8);
+        in.read((char*)footer, sizeof(footer));
+        if (!in) return false;
+        count = readLE32(footer);
+        uint32_t magic = readLE32(footer + 4);
+        uint64_t size = trailerSize(magic, count);
+        if (size == 0 || size > end) return false;
+        if (magic == footer_magic) {
+            frame.resize(size);
+            in.seekg(end - size);
+            in.read((char*)frame.data(), size);
+            return in && readLE32(&frame[0]) == frame_magic && readLE32(&frame[4]) == size - 8;
+        }
+        end -= size;
+    }
+    return false;
+}
+
+bool lz4ReadBlockIndex(const std::string& file, std::vector<lz4BlockIndexEntry>& index)
+{
+    std::vector<uint8_t> frame;
+    uint32_t num_blocks;
+    if (!readTrailer(file, BLOCK_INDEX_FRAME_MAGIC, BLOCK_INDEX_MAGIC, frame, num_blocks)) return false;
+
+    index.resize(num_blocks);
+    for (uint32_t i = 0; i < num_blocks; i++) {
+        index[i].compressedOffset = readLE32(&frame[8 + 8 * i]);
+        index[i].contentOffset = readLE32(&frame[12 + 8 * i]);
+    }
+    return true;
+}
+
+bool lz4ReadZoneMap(const std::string& file, dt_zoneConfig& config, std::vector<lz4ZoneEntry>& zones)
+{
+    std::vector<uint8_t> frame;
+    uint32_t num_blocks;
+    if (!readTrailer(file, ZONE_MAP_FRAME_MAGIC, ZONE_MAP_MAGIC, frame, num_blocks)) return false;
+
+    config = dt_zoneConfig();
+    config.layout = readLE32(&frame[8]);
+    config.delimiter = readLE32(&frame[12]);
+    config.fieldDelimiter = readLE32(&frame[16]);
+    config.column = readLE32(&frame[20]);
+    config.offset = readLE32(&frame[24]);
+    config.width = readLE32(&frame[28]);
+    zones.resize(num_blocks);
+    for (uint32_t i = 0; i < num_blocks; i++) {
+        const uint8_t* entry = &frame[32 + 28 * i];
+        zones[i].min = (int64_t)readLE64(entry);
+        zones[i].max = (int64_t)readLE64(entry + 8);
+        zones[i].records = readLE32(entry + 16);
+        zones[i].values = readLE32(entry + 20);
+        zones[i].first = readLE32(entry + 24);
+    }
+    return true;
+}
+
+bool lz4FindBlockRange(const std::string& file,
+                       const lz4FrameInfo& info,
+                       uint64_t offset,
+                       uint64_t length,
+                       lz4BlockRange& range)
+{
+    if (length == 0 || offset >= info.contentSize) return false;
+    uint64_t end = offset + std::min(length, info.contentSize - offset);
+    uint32_t total_blocks = (info.contentSize - 1) / info.blockSize + 1;
+    uint32_t first = offset / info.blockSize;
+    uint32_t last = (end - 1) / info.blockSize;
+    range.firstBlock = first;
+    range.numBlocks = last - first + 1;
+    range.contentOffset = (uint64_t)first * info.blockSize;
+    range.contentSize = std::min<uint64_t>(info.contentSize, (uint64_t)(last + 1) * info.blockSize) - range.contentOffset;
+
+    // With an index only the size field of the last block is read, to find where the run ends
+    uint32_t block = 0;
+    uint64_t pos = info.headerSize;
+    std::vector<lz4BlockIndexEntry> index;
+    if (lz4ReadBlockIndex(file, index) && index.size() == total_blocks) {
+        range.compressedOffset = index[first].compressedOffset;
+        block = last;
+        pos = index[last].compressedOffset;
+    }
+
+    std::ifstream in(file.c_str(), std::ifstream::binary);
+    uint32_t checksum_size = (info.flags & FLG_BLOCK_CHECKSUM) ? CHECKSUM_SIZE : 0;
+    for (; block <= last; block++) {
+        if (block == first) range.compressedOffset = pos;
+        uint8_t field[4];
+        in.seekg(pos);
+        in.read((char*)field, sizeof(field));
+        uint32_t size = readLE32(field) & 0x7FFFFFFF;
+        if (!in || size == 0 || size > info.blockSize) {
+            std::cout << file << ": corrupt block at " << pos << std::endl;
+            exit(1);
+        }
+        pos += sizeof(field) + size + checksum_size;
+    }
+    range.compressedSize = pos - range.compressedOffset;
+    return true;
+}
+
+size_t lz4WriteBlockIndex(uint8_t* out, const std::vector<lz4BlockIndexEntry>& index)
+{
+    size_t index_size = BLOCK_INDEX_SIZE(index.size());
+    writeLE32(out, BLOCK_INDEX_FRAME_MAGIC);
+    writeLE32(out + 4, index_size - 8);
+    for (size_t i = 0; i < index.size(); i++) {
+        writeLE32(out + 8 + 8 * i, index[i].compressedOffset);
+        writeLE32(out + 12 + 8 * i, index[i].contentOffset);
+    }
+    writeLE32(out + index_size - 8, index.size());
+    writeLE32(out + index_size - 4, BLOCK_INDEX_MAGIC);
+    return index_size;
+}
+
+size_t lz4WriteZoneMap(uint8_t* out, const dt_zoneConfig& config, const std::vector<lz4ZoneEntry>& zones)
+{
+    size_t map_size = ZONE_MAP_SIZE(zones.size());
+    writeLE32(out, ZONE_MAP_FRAME_MAGIC);
+    writeLE32(out + 4, map_size - 8);
+    writeLE32(out + 8, config.layout);
+    writeLE32(out + 12, config.delimiter);
+    writeLE32(out + 16, config.fieldDelimiter);
+    writeLE32(out + 20, config.column);
+    writeLE32(out + 24, config.offset);
+    writeLE32(out + 28, config.width);
+    for (size_t i = 0; i < zones.size(); i++) {
+        uint8_t* entry = out + 32 + 28 * i;
+        writeLE64(entry, zones[i].min);
+        writeLE64(entry + 8, zones[i].max);
+        writeLE32(entry + 16, zones[i].records);
+        writeLE32(entry + 20, zones[i].values);
+        writeLE32(entry + 24, zones[i].first);
+    }
+    writeLE32(out + map_size - 8, zones.size());
+    writeLE32(out + map_size - 4, ZONE_MAP_MAGIC);
+    return map_size;
+}
@@ -16,6 +16,10 @@
  */
 #include "SmartSSD.hpp"
 #include "lz4_p2p_comp.hpp"
+#include "../../kernel/include/lz4_p2p.hpp"
+#include "lz4_frame.hpp"
+#include "snappy_frame.hpp"
+#include "zone_map.hpp"
 #include "xxhash.h"
 #define BLOCK_SIZE 64
 #define KB 1024
@@ -28,10 +32,41 @@
 
 #define RESIDUE_4K 4096
 
-Compress::Compress(const std::string& binaryFile, uint8_t device_id, bool p2p_enable, uint32_t block_kb)
+Compress::Compress(const std::string& binaryFile, uint8_t device_id, bool p2p_enable, uint32_t block_kb, bool checksum,
+                   bool block_index, bool batch, compressCodec codec)
     : SmartSSD(binaryFile, device_id, p2p_enable)
 {
+    if (block_kb != 64 && block_kb != 256 && block_kb != 1024 && block_kb != 4096) {
+        std::cout << "Valid block size not given, setting to 64K" << std::endl;
+        block_kb = 64;
+    }
     m_BlockSizeInKb = block_kb;
+    m_FrameFlags = checksum ? (FLG_BYTE | FLG_BLOCK_CHECKSUM | FLG_CONTENT_CHECKSUM) : FLG_BYTE;
+    if (block_index) m_FrameFlags |= FRAME_BLOCK_INDEX;
+    m_Codec = codec;
+    if (codec == CODEC_SNAPPY) {
+        if (block_index) {
+            std::cout << "The block index needs the LZ4 codec" << std::endl;
+            exit(1);
+        }
+        // One Snappy data chunk per block, the format caps them at 64 KB
+        m_BlockSizeInKb = SNAPPY_BLOCK_SIZE / KB;
+        m_FrameFlags = FRAME_SNAPPY;
+    }
+    if (deflateCodec(codec)) {
+        if (block_index) {
+            std::cout << "The block index needs the LZ4 codec" << std::endl;
+            exit(1);
+        }
+        m_FrameFlags = (codec == CODEC_ZLIB) ? FRAME_ZLIB : 0;
+        compress_kernel_names = {"xilGzipCompress"};
+        packer_kernel_names = {"xilGzipPacker"};
+    }
+    m_sharedBuffers = batch;
+    h_zoneConfig = (dt_zoneConfig*)aligned_alloc(4096, 4096);
+    memset(h_zoneConfig, 0, sizeof(dt_zoneConfig));
+    bufZoneConfig = NULL;
+    m_metrics.setOperation("compress");
     
     m_compression_time = std::chrono::milliseconds::zero();
 }
@@ -40,34 +75,100 @@ Compress::~Compress()
 {
     std::cout << "########################### FPGA Operation ###########################################" << std::endl;
     std::cout << "\x1B[32m[FPGA Operation]\033[0m Compression Time : " << std::fixed << std::setprecision(2) << m_compression_time.count() << " ns" << std::endl;
-    for (uint32_t i = 0; i < m_InputFileDescVec.size(); i++) {
-        delete (h_headerVec[i]);
-        delete (h_blkSizeVec[i]);
-        delete (h_lz4OutSizeVec[i]);
-
-        delete (bufTmpOutputVec[i]);
-        delete (buflz4OutSizeVec[i]);
-        delete (bufCompSizeVec[i]);
-        delete (bufblockSizeVec[i]);
-        delete (bufheadVec[i]);
+    for (uint32_t i = 0; !deflateCodec(m_Codec) && i < m_fileLaunchVec.size(); i++) {
+        std::cout << "\x1B[32m[FPGA Operation]\033[0m Entropy (" << m_InputFileNameVec[i] << ") : " << std::fixed
+                  << std::setprecision(2) << fileEntropy(i) << " bits/byte, " << highEntropyBlocks(i)
+                  << " blocks stored" << std::endl;
+    }
+    for (uint32_t l = 0; l < compressKernelVec.size(); l++) {
+#ifdef KERNEL_STATS
+        printKernelStats(compress_kernel_names[0], launchName(l), h_compStatsVec[l]);
+        printKernelStats(packer_kernel_names[0], launchName(l), h_packStatsVec[l]);
+        free(h_compStatsVec[l]);
+        free(h_packStatsVec[l]);
+        delete (bufCompStatsVec[l]);
+        delete (bufPackStatsVec[l]);
+#endif
+        free(h_headerVec[l]);
+        free(h_blockDescVec[l]);
+        free(h_lz4OutSizeVec[l]);
+        free(h_entropyVec[l]);
+        free(h_contentChecksumVec[l]);
+        free(h_zoneMapVec[l]);
+
+        delete (bufTmpOutputVec[l]);
+        delete (buflz4OutSizeVec[l]);
+        delete (bufCompSizeVec[l]);
+        delete (bufBlockDescVec[l]);
+        delete (bufEntropyVec[l]);
+        delete (bufContentChecksumVec[l]);
+        delete (bufZoneMapVec[l]);
+        delete (bufBlockIndexVec[l]);
+        delete (bufSymbolVec[l]);
+        delete (bufheadVec[l]);
         
-        delete (packerKernelVec[i]);
-        delete (compressKernelVec[i]);
+        delete (packerKernelVec[l]);
+        delete (compressKernelVec[l]);
     }
+    delete (bufZoneConfig);
+    free(h_zoneConfig);
+}
+
+void Compress::setZoneMap(const dt_zoneConfig& config)
+{
+    if (m_Codec != CODEC_LZ4) {
+        std::cout << "The zone map needs the LZ4 codec" << std::endl;
+        exit(1);
+    }
+    *h_zoneConfig = config;
+    m_FrameFlags |= FRAME_ZONE_MAP;
 }
 
 void Compress::MakeOutputFileList(const std::vector<std::string>& inputFile)
 {
     for (std::string inFile : inputFile)
     {
-        std::string out_file = inFile + ".lz4";
+        std::string out_file = inFile + ((m_Codec == CODEC_GZIP)     ? ".gz"
+                                         : (m_Codec == CODEC_ZLIB)   ? ".zz"
+                                         : (m_Codec == CODEC_SNAPPY) ? ".sz"
+                                                                     : ".lz4");
         m_OutputFileNameVec.push_back(out_file);
     }
 }
 
+// Room for every block stored with its checksum, the block index and zone map frames, and for the zero padding
+// postProcess() appends after them
 void Compress::SetOutputFileSize()
 {
-    outputFileSizeVec = m_InputFileSizeVec;
+    uint32_t block_size_in_bytes = m_BlockSizeInKb * KB;
+    uint32_t checksum_size = (m_FrameFlags & FLG_BLOCK_CHECKSUM) ? CHECKSUM_SIZE : 0;
+    uint64_t batch_input = 0;
+    uint64_t batch_output = 0;
+    outputFileSizeVec.clear();
+    for (uint32_t input_size : m_InputFileSizeVec) {
+        uint64_t num_blocks = (input_size - 1) / block_size_in_bytes + 1;
+        uint64_t frame_size = MAX_HEADER_SIZE + num_blocks * (4 + checksum_size) + input_size + 4 + CHECKSUM_SIZE;
+        if (m_FrameFlags & FRAME_BLOCK_INDEX) frame_size += BLOCK_INDEX_SIZE(num_blocks);
+        if (m_FrameFlags & FRAME_ZONE_MAP) frame_size += ZONE_MAP_SIZE(num_blocks);
+        if (m_Codec == CODEC_SNAPPY) {
+            // Every block in a chunk of its own, and the header of the padding chunk postProcess() ends with
+            frame_size = SNAPPY_STREAM_ID_SIZE + num_blocks * (SNAPPY_CHUNK_HEADER_SIZE + SNAPPY_CHUNK_CRC_SIZE) +
+                         input_size + SNAPPY_CHUNK_HEADER_SIZE;
+        }
+        if (deflateCodec(m_Codec)) {
+            // Every block stored in GZIP_STORED_CHUNK blocks, the final block and the trailer
+            uint64_t chunks = num_blocks * ((block_size_in_bytes - 1) / GZIP_STORED_CHUNK + 1);
+            frame_size = GZIP_HEADER_SIZE + chunks * 5 + input_size + 2 + 8;
+        }
+        outputFileSizeVec.push_back((frame_size / RESIDUE_4K + 1) * RESIDUE_4K);
+        batch_input += input_size;
+        batch_output += outputFileSizeVec.back();
+    }
+    // The block descriptors address the shared buffers with 32 bit offsets
+    if (m_sharedBuffers && (batch_input > UINT32_MAX || batch_output > UINT32_MAX)) {
+        std::cout << "A batch should stay below 4 GB, compress these files in smaller batches" << std::endl;
+        exit(1);
+    }
 }
 
 void Compress::preProcess()
@@ -77,17 +178,61 @@ void Compress::preProcess()
         std::cout << "Set Input File First\n" << std::endl;
         exit(1);
     }
+    if (m_dictId && m_Codec != CODEC_LZ4) {
+        std::cout << "A preset dictionary needs the LZ4 codec" << std::endl;
+        exit(1);
+    }
+    if (m_dictId) m_FrameFlags |= FLG_DICT_ID;
+    if (!deflateCodec(m_Codec)) {
+        bufZoneConfig = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, sizeof(dt_zoneConfig), h_zoneConfig);
+        m_q->enqueueMigrateMemObjects({*bufZoneConfig}, 0 /* 0 means from host*/);
+    }
 
-    for (uint32_t i = 0; i < m_InputFileDescVec.size(); i++) {
-        uint8_t* h_header = (uint8_t*)aligned_alloc(4096, 4096);
-        uint32_t* h_blksize = (uint32_t*)aligned_alloc(4096, 4096);
-        uint32_t* h_lz4outSize = (uint32_t*)aligned_alloc(4096, 4096);
-        uint32_t block_size_in_bytes = m_BlockSizeInKb * 1024;
-        uint32_t head_size = create_header(h_header, m_InputFileSizeVec[i]);
+    // One invocation per file, or one for the whole batch
+    uint32_t block_size_in_bytes = m_BlockSizeInKb * 1024;
+    uint32_t num_files = m_InputFileDescVec.size();
+    std::vector<uint32_t> launchBlocks;
+    for (uint32_t i = 0; i < num_files; i++) {
+        uint32_t num_blocks = (m_InputFileSizeVec[i] - 1) / block_size_in_bytes + 1;
+        if (m_sharedBuffers == false || i == 0) {
+            m_launchFirstFileVec.push_back(i);
+            launchBlocks.push_back(0);
+        }
+        m_fileLaunchVec.push_back(launchBlocks.size() - 1);
+        m_fileSlotVec.push_back(i - m_launchFirstFileVec.back());
+        m_fileFirstBlockVec.push_back(launchBlocks.back());
+        launchBlocks.back() += num_blocks;
+    }
+
+    for (uint32_t l = 0; l < launchBlocks.size(); l++) {
+        uint32_t first_file = m_launchFirstFileVec[l];
+        uint32_t launch_files = ((l + 1 < launchBlocks.size()) ? m_launchFirstFileVec[l + 1] : num_files) - first_file;
+        uint32_t num_blocks = launchBlocks[l];
+        // One header word and one entry of the size and content checksum tables per file, a 4K page only
+        // holds 1024 of the table entries. Snappy streams take a CRC per block in the content checksum table.
+        uint32_t file_table_size = ((launch_files * sizeof(uint32_t) - 1) / 4096 + 1) * 4096;
+        uint32_t checksum_entries = (m_Codec == CODEC_SNAPPY) ? num_blocks : launch_files;
+        uint32_t checksum_table_size = ((checksum_entries * sizeof(uint32_t) - 1) / 4096 + 1) * 4096;
+        uint32_t header_size = ((launch_files * 64 - 1) / 4096 + 1) * 4096;
+        uint8_t* h_header = (uint8_t*)aligned_alloc(4096, header_size);
+        dt_blockDesc* h_block_desc = (dt_blockDesc*)aligned_alloc(4096, ((num_blocks * sizeof(dt_blockDesc) - 1) / 4096 + 1) * 4096);
+        uint32_t* h_lz4outSize = (uint32_t*)aligned_alloc(4096, file_table_size);
+        uint32_t* h_entropy = (uint32_t*)aligned_alloc(4096, ((num_blocks * sizeof(uint32_t) - 1) / 4096 + 1) * 4096);
+        memset(h_entropy, 0, num_blocks * sizeof(uint32_t));
+        uint32_t* h_content_checksum = (uint32_t*)aligned_alloc(4096, checksum_table_size);
+        memset(h_content_checksum, 0, checksum_entries * sizeof(uint32_t));
+        dt_zoneMap* h_zone_map = (dt_zoneMap*)aligned_alloc(4096, ((num_blocks * sizeof(dt_zoneMap) - 1) / 4096 + 1) * 4096);
+        uint32_t head_size = 0;
+        for (uint32_t f = 0; f < launch_files; f++) {
+            head_size = create_header(h_header + f * 64, m_InputFileSizeVec[first_file + f]);
+        }
         headerSizeVec.push_back(head_size);
         h_headerVec.push_back(h_header);
-        h_blkSizeVec.push_back(h_blksize);
+        h_blockDescVec.push_back(h_block_desc);
         h_lz4OutSizeVec.push_back(h_lz4outSize);
+        h_entropyVec.push_back(h_entropy);
+        h_contentChecksumVec.push_back(h_content_checksum);
+        h_zoneMapVec.push_back(h_zone_map);
         
         std::string comp_kname = compress_kernel_names[0];
         std::string pack_kname = packer_kernel_names[0];
@@ -99,25 +244,23 @@ void Compress::preProcess()
         // This count is used to overlap the execution between chunks and file
         // operations
 
-        uint32_t num_blocks = (m_InputFileSizeVec[i] - 1) / block_size_in_bytes + 1;
-
         int cu_num = 0; //i % 2;
 
         if (cu_num == 0) {
-            comp_kname += ":{xilLz4Compress_1}";
-            pack_kname += ":{xilLz4Packer_1}";
+            comp_kname += ":{" + compress_kernel_names[0] + "_1}";
+            pack_kname += ":{" + packer_kernel_names[0] + "_1}";
         } else {
-            comp_kname += ":{xilLz4Compress_2}";
-            pack_kname += ":{xilLz4Packer_2}";
+            comp_kname += ":{" + compress_kernel_names[0] + "_2}";
+            pack_kname += ":{" + packer_kernel_names[0] + "_2}";
         }
         
-        // K1 Output:- This buffer contains compressed data written by device
+        // K1 Output:- This buffer contains compressed data written by device, one block size stride per block
         // K2 Input:- This is a input to data packer kernel
-        cl::Buffer* buffer_output = new cl::Buffer(*m_context, CL_MEM_WRITE_ONLY, m_InputFileSizeVec[i]);
+        cl::Buffer* buffer_output = new cl::Buffer(*m_context, CL_MEM_WRITE_ONLY, (uint64_t)num_blocks * block_size_in_bytes);
         bufTmpOutputVec.push_back(buffer_output);
 
-        // K2 input:- This buffer contains compressed data written by device
-        cl::Buffer* buffer_lz4OutSize = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY, 10 * sizeof(uint32_t), h_lz4OutSizeVec[i]);
+        // K2 Output:- Frame size of every file
+        cl::Buffer* buffer_lz4OutSize = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY, launch_files * sizeof(uint32_t), h_lz4OutSizeVec[l]);
         buflz4OutSizeVec.push_back(buffer_lz4OutSize);
 
         // K1 Ouput:- This buffer contains compressed block sizes
@@ -125,57 +268,129 @@ void Compress::preProcess()
         cl::Buffer* buffer_compressed_size = new cl::Buffer(*m_context, CL_MEM_WRITE_ONLY, num_blocks * sizeof(uint32_t));
         bufCompSizeVec.push_back(buffer_compressed_size);
 
-        // Input:- This buffer contains original input block sizes
-        cl::Buffer* buffer_block_size = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, num_blocks * sizeof(uint32_t), h_blkSizeVec[i]);
-        bufblockSizeVec.push_back(buffer_block_size);
+        // Input:- This buffer contains the offset, size and file of every input block
+        cl::Buffer* buffer_block_desc = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, num_blocks * sizeof(dt_blockDesc), h_blockDescVec[l]);
+        bufBlockDescVec.push_back(buffer_block_desc);
+
+        // K1 Output:- This buffer contains the entropy estimate of each block
+        cl::Buffer* buffer_entropy = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY, num_blocks * sizeof(uint32_t), h_entropyVec[l]);
+        bufEntropyVec.push_back(buffer_entropy);
+
+        // K1 Output:- XXH32 of every input file, or CRC32C of every block for Snappy
+        // K2 Input:- Written after the end mark, or in the chunk headers
+        cl::Buffer* buffer_content_checksum = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_READ_WRITE, checksum_entries * sizeof(uint32_t), h_contentChecksumVec[l]);
+        bufContentChecksumVec.push_back(buffer_content_checksum);
+
+        // K1 Output:- Zone map of every block with FRAME_ZONE_MAP
+        cl::Buffer* buffer_zone_map = NULL;
+        if (!deflateCodec(m_Codec)) {
+            buffer_zone_map = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY, num_blocks * sizeof(dt_zoneMap), h_zoneMapVec[l]);
+        }
+        bufZoneMapVec.push_back(buffer_zone_map);
+
+        // K2 Scratch:- Offsets of every block, appended after the frame with FRAME_BLOCK_INDEX
+        cl::Buffer* buffer_block_index = new cl::Buffer(*m_context, CL_MEM_READ_WRITE, num_blocks * 2 * sizeof(uint32_t));
+        bufBlockIndexVec.push_back(buffer_block_index);
+
+        // K1 Scratch:- LZ77 symbols of a batch of blocks, GZIP_SYMBOL_BYTES per input byte and engine
+        cl::Buffer* buffer_symbol = NULL;
+        if (deflateCodec(m_Codec)) {
+            uint64_t engines = std::min(num_blocks, (uint32_t)GZIP_MAX_ENGINES);
+            buffer_symbol = new cl::Buffer(*m_context, CL_MEM_READ_WRITE, engines * GZIP_SYMBOL_BYTES * block_size_in_bytes);
+        }
+        bufSymbolVec.push_back(buffer_symbol);
 
         // Input:- Header buffer only used once
-        cl::Buffer* buffer_header = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, head_size * sizeof(uint8_t), h_headerVec[i]);
+        cl::Buffer* buffer_header = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, launch_files * 64, h_headerVec[l]);
         bufheadVec.push_back(buffer_header);
 
-        // Main loop of overlap execution
-        // Loop below runs over total bricks i.e., host buffer size chunks
-        // Figure out block sizes per brick
+#ifdef KERNEL_STATS
+        // Output:- Stats records written by the compress and packer kernels
+        dt_kernelStats* h_compStats = (dt_kernelStats*)aligned_alloc(4096, 4096);
+        dt_kernelStats* h_packStats = (dt_kernelStats*)aligned_alloc(4096, 4096);
+        memset(h_compStats, 0, sizeof(dt_kernelStats));
+        memset(h_packStats, 0, sizeof(dt_kernelStats));
+        h_compStatsVec.push_back(h_compStats);
+        h_packStatsVec.push_back(h_packStats);
+        bufCompStatsVec.push_back(new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY, sizeof(dt_kernelStats), h_compStats));
+        bufPackStatsVec.push_back(new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY, sizeof(dt_kernelStats), h_packStats));
+#endif
+
+        // Blocks of every file in order, each frame goes to the output slot of its file
         uint32_t bIdx = 0;
-        for (uint32_t j = 0; j < m_InputFileSizeVec[i]; j += block_size_in_bytes) {
-            uint32_t block_size = block_size_in_bytes;
-            if (j + block_size > m_InputFileSizeVec[i]) {
-                block_size = m_InputFileSizeVec[i] - j;
+        for (uint32_t f = 0; f < launch_files; f++) {
+            uint32_t fid = first_file + f;
+            for (uint32_t j = 0; j < m_InputFileSizeVec[fid]; j += block_size_in_bytes) {
+                uint32_t block_size = block_size_in_bytes;
+                if (j + block_size > m_InputFileSizeVec[fid]) {
+                    block_size = m_InputFileSizeVec[fid] - j;
+                }
+                h_block_desc[bIdx].srcOffset = m_InputOffsetVec[fid] + j;
+                h_block_desc[bIdx].size = block_size;
+                h_block_desc[bIdx].fileId = f;
+                h_block_desc[bIdx].frameOffset = m_OutputOffsetVec[fid];
+                bIdx++;
             }
-            h_blksize[bIdx++] = block_size;
         }
 
         // Set kernel arguments
         cl::Kernel* compress_kernel_lz4 = new cl::Kernel(*m_program, comp_kname.c_str());
         int narg = 0;
-        compress_kernel_lz4->setArg(narg++, *(m_InputCLBufVec[i]));
-        compress_kernel_lz4->setArg(narg++, *(bufTmpOutputVec[i]));
-        compress_kernel_lz4->setArg(narg++, *(bufCompSizeVec[i]));
-        compress_kernel_lz4->setArg(narg++, *(bufblockSizeVec[i]));
+        compress_kernel_lz4->setArg(narg++, *(m_InputCLBufVec[l]));
+        compress_kernel_lz4->setArg(narg++, *(bufTmpOutputVec[l]));
+        compress_kernel_lz4->setArg(narg++, *(bufCompSizeVec[l]));
+        compress_kernel_lz4->setArg(narg++, *(bufBlockDescVec[l]));
+        if (!deflateCodec(m_Codec)) {
+            compress_kernel_lz4->setArg(narg++, *(bufEntropyVec[l]));
+        } else {
+            compress_kernel_lz4->setArg(narg++, *(bufSymbolVec[l]));
+        }
+        compress_kernel_lz4->setArg(narg++, *(bufContentChecksumVec[l]));
         compress_kernel_lz4->setArg(narg++, m_BlockSizeInKb);
-        compress_kernel_lz4->setArg(narg++, m_InputFileSizeVec[i]);
+        compress_kernel_lz4->setArg(narg++, num_blocks);
+        compress_kernel_lz4->setArg(narg++, m_FrameFlags);
+        if (!deflateCodec(m_Codec)) {
+            compress_kernel_lz4->setArg(narg++, *dictBuffer());
+            compress_kernel_lz4->setArg(narg++, (uint32_t)m_dict.size());
+            compress_kernel_lz4->setArg(narg++, *bufZoneConfig);
+            compress_kernel_lz4->setArg(narg++, *(bufZoneMapVec[l]));
+        }
+#ifdef KERNEL_STATS
+        compress_kernel_lz4->setArg(narg++, *(bufCompStatsVec[l]));
+#endif
         compressKernelVec.push_back(compress_kernel_lz4);
 
         uint32_t offset = 0;
         uint32_t tail_bytes = 0;
         tail_bytes = 1;
-        uint32_t no_blocks_calc = (m_InputFileSizeVec[i] - 1) / (m_BlockSizeInKb * 1024) + 1;
 
         // K2 Set Kernel arguments
         cl::Kernel* packer_kernel_lz4 = new cl::Kernel(*m_program, pack_kname.c_str());
         narg = 0;
-        packer_kernel_lz4->setArg(narg++, *(bufTmpOutputVec[i]));
-        packer_kernel_lz4->setArg(narg++, *(m_OutputCLBufVec[i]));
-        packer_kernel_lz4->setArg(narg++, *(bufheadVec[i]));
-        packer_kernel_lz4->setArg(narg++, *(bufCompSizeVec[i]));
-        packer_kernel_lz4->setArg(narg++, *(bufblockSizeVec[i]));
-        packer_kernel_lz4->setArg(narg++, *(buflz4OutSizeVec[i]));
-        packer_kernel_lz4->setArg(narg++, *(m_InputCLBufVec[i]));
-        packer_kernel_lz4->setArg(narg++, headerSizeVec[i]);
-        packer_kernel_lz4->setArg(narg++, offset);
-        packer_kernel_lz4->setArg(narg++, m_BlockSizeInKb);
-        packer_kernel_lz4->setArg(narg++, no_blocks_calc);
-        packer_kernel_lz4->setArg(narg++, tail_bytes);
+        packer_kernel_lz4->setArg(narg++, *(bufTmpOutputVec[l]));
+        packer_kernel_lz4->setArg(narg++, *(m_OutputCLBufVec[l]));
+        packer_kernel_lz4->setArg(narg++, *(bufheadVec[l]));
+        packer_kernel_lz4->setArg(narg++, *(bufCompSizeVec[l]));
+        packer_kernel_lz4->setArg(narg++, *(bufBlockDescVec[l]));
+        packer_kernel_lz4->setArg(narg++, *(buflz4OutSizeVec[l]));
+        packer_kernel_lz4->setArg(narg++, *(m_InputCLBufVec[l]));
+        packer_kernel_lz4->setArg(narg++, *(bufContentChecksumVec[l]));
+        if (!deflateCodec(m_Codec)) {
+            packer_kernel_lz4->setArg(narg++, *(bufBlockIndexVec[l]));
+            packer_kernel_lz4->setArg(narg++, headerSizeVec[l]);
+            packer_kernel_lz4->setArg(narg++, offset);
+            packer_kernel_lz4->setArg(narg++, m_BlockSizeInKb);
+            packer_kernel_lz4->setArg(narg++, num_blocks);
+            packer_kernel_lz4->setArg(narg++, tail_bytes);
+        } else {
+            packer_kernel_lz4->setArg(narg++, headerSizeVec[l]);
+            packer_kernel_lz4->setArg(narg++, m_BlockSizeInKb);
+            packer_kernel_lz4->setArg(narg++, num_blocks);
+        }
+        packer_kernel_lz4->setArg(narg++, m_FrameFlags);
+#ifdef KERNEL_STATS
+        packer_kernel_lz4->setArg(narg++, *(bufPackStatsVec[l]));
+#endif
         packerKernelVec.push_back(packer_kernel_lz4);
     }
     m_q->finish();
@@ -187,9 +402,10 @@ void Compress::run()
     std::vector<cl::Event> packWait;
     std::vector<cl::Event> writeWait;
     std::vector<cl::Event> opFinishEvent;
+    std::vector<cl::Event> readEvent;
     
     auto comp_start = std::chrono::high_resolution_clock::now();
-    for (uint32_t i = 0; i < m_InputFileDescVec.size(); i++) {
+    for (uint32_t l = 0; l < compressKernelVec.size(); l++) {
         /* Transfer data from host to device
         * In p2p case, no need to transfer buffer input to device from host.
         */
@@ -201,38 +417,73 @@ void Compress::run()
         // Migrate memory - Map host to device buffers
         if (m_p2pEnable == false)
         {
-            m_q->enqueueMigrateMemObjects({*(m_InputCLBufVec[i]), *(bufblockSizeVec[i]), *(bufheadVec[i])}, 0 /* 0 means from host*/, NULL, &write_event);
+            m_q->enqueueMigrateMemObjects({*(m_InputCLBufVec[l]), *(bufBlockDescVec[l]), *(bufheadVec[l])}, 0 /* 0 means from host*/, NULL, &write_event);
         }
         else
         {
-            m_q->enqueueMigrateMemObjects({*(bufblockSizeVec[i]), *(bufheadVec[i])}, 0 /* 0 means from host*/, NULL, &write_event);
+            m_q->enqueueMigrateMemObjects({*(bufBlockDescVec[l]), *(bufheadVec[l])}, 0 /* 0 means from host*/, NULL, &write_event);
         }
         writeWait.push_back(write_event);
+        m_tracer.anchor(write_event, std::chrono::high_resolution_clock::now());
 
         // Fire compress kernel
-        m_q->enqueueTask(*compressKernelVec[i], &writeWait, &comp_event);
+        m_q->enqueueTask(*compressKernelVec[l], &writeWait, &comp_event);
         compWait.push_back(comp_event);
 
         // Fire packer kernel
-        m_q->enqueueTask(*packerKernelVec[i], &compWait, &pack_event);
+        m_q->enqueueTask(*packerKernelVec[l], &compWait, &pack_event);
         packWait.push_back(pack_event);
         // Read back data
         
-        m_q->enqueueMigrateMemObjects({*(buflz4OutSizeVec[i])}, CL_MIGRATE_MEM_OBJECT_HOST, &packWait, &opFinish_event);
+        std::vector<cl::Memory> readback = {*(buflz4OutSizeVec[l]), *(bufEntropyVec[l])};
+        if (m_FrameFlags & FRAME_ZONE_MAP) readback.push_back(*(bufZoneMapVec[l]));
+#ifdef KERNEL_STATS
+        readback.push_back(*(bufCompStatsVec[l]));
+        readback.push_back(*(bufPackStatsVec[l]));
+#endif
+        m_q->enqueueMigrateMemObjects(readback, CL_MIGRATE_MEM_OBJECT_HOST, &packWait, &opFinish_event);
         opFinishEvent.push_back(opFinish_event);
     }
 
     for (uint32_t i = 0; i < m_InputFileDescVec.size(); i++) {
-        opFinishEvent[i].wait();
+        uint32_t l = m_fileLaunchVec[i];
+        opFinishEvent[l].wait();
 
-        uint32_t compressed_size = *(h_lz4OutSizeVec[i]);
+        uint32_t compressed_size = h_lz4OutSizeVec[l][m_fileSlotVec[i]];
         if (m_p2pEnable == false) {
-            m_q->enqueueReadBuffer(*(m_OutputCLBufVec[i]), 0, 0, compressed_size, m_OutputHostMappedBufVec[i]);
+            cl::Event read_event;
+            m_q->enqueueReadBuffer(*(m_OutputCLBufVec[l]), 0, m_OutputOffsetVec[i], compressed_size, m_OutputHostMappedBufVec[i], NULL, &read_event);
+            readEvent.push_back(read_event);
         }
     }
     m_q->finish();
     auto comp_end = std::chrono::high_resolution_clock::now();
     m_compression_time = std::chrono::duration<double, std::nano>(comp_end - comp_start);
+
+    for (uint32_t l = 0; l < compressKernelVec.size(); l++) {
+        uint32_t fid = m_launchFirstFileVec[l];
+        std::string file = " " + std::to_string(fid);
+        m_tracer.deviceEvent("migrate" + file, "host to device " + std::to_string(l), fid, writeWait[l]);
+        m_tracer.deviceEvent("compress" + file, compress_kernel_names[0] + "_1", fid, compWait[l]);
+        m_tracer.deviceEvent("pack" + file, packer_kernel_names[0] + "_1", fid, packWait[l]);
+        m_tracer.deviceEvent("readback" + file, "device to host " + std::to_string(l), fid, opFinishEvent[l]);
+    }
+
+    // Files of a batch all wait for the batch
+    for (uint32_t i = 0; i < m_InputFileDescVec.size(); i++) {
+        uint32_t l = m_fileLaunchVec[i];
+        if (m_p2pEnable == false) {
+            m_tracer.deviceEvent("readback " + std::to_string(i), "device to host " + std::to_string(l), i, readEvent[i]);
+        }
+
+        m_metrics.recordEvent(STAGE_MIGRATE, i, writeWait[l]);
+        m_metrics.recordEvents(STAGE_KERNEL, i, {compWait[l], packWait[l]});
+        if (m_p2pEnable == false) {
+            m_metrics.recordEvents(STAGE_READBACK, i, {opFinishEvent[l], readEvent[i]});
+        } else {
+            m_metrics.recordEvent(STAGE_READBACK, i, opFinishEvent[l]);
+        }
+    }
 }
 
 void Compress::postProcess()
@@ -240,14 +491,37 @@ void Compress::postProcess()
 
     uint8_t empty_buffer[4096] = {0};
     for (uint32_t i = 0; i < m_InputFileDescVec.size(); i++) {
-        uint32_t compressed_size = *(h_lz4OutSizeVec[i]);
+        uint32_t compressed_size = h_lz4OutSizeVec[m_fileLaunchVec[i]][m_fileSlotVec[i]];
+        if (m_FrameFlags & FRAME_ZONE_MAP) {
+            // After the block index the packer appended, SetOutputFileSize() left room for it
+            auto zone_start = std::chrono::high_resolution_clock::now();
+            std::vector<lz4ZoneEntry> zones;
+            zoneMapJoin(*h_zoneConfig, m_InputHostMappedBufVec[i], m_InputFileSizeVec[i], m_BlockSizeInKb * KB,
+                        h_zoneMapVec[m_fileLaunchVec[i]] + m_fileFirstBlockVec[i], zones);
+            compressed_size += lz4WriteZoneMap(m_OutputHostMappedBufVec[i] + compressed_size, *h_zoneConfig, zones);
+            auto zone_end = std::chrono::high_resolution_clock::now();
+            m_tracer.hostSpan("zone map", i, zone_start, zone_end);
+        }
         uint32_t align_4k = compressed_size / RESIDUE_4K;
         uint32_t outIdx_align = RESIDUE_4K * align_4k;
         uint32_t residue_size = compressed_size - outIdx_align;
         // Counter which helps in tracking
         // Output buffer index
         
-        if (m_p2pEnable) {
+        auto pad_start = std::chrono::high_resolution_clock::now();
+        if (m_Codec == CODEC_SNAPPY) {
+            // Decoders read every byte of a Snappy stream as chunks, the padding is a padding chunk. Its
+            // header takes 4 bytes, SetOutputFileSize() left room for one more 4K page.
+            uint8_t* temp = m_OutputHostMappedBufVec[i] + compressed_size;
+            if (RESIDUE_4K - residue_size < SNAPPY_CHUNK_HEADER_SIZE) outIdx_align += RESIDUE_4K;
+            uint32_t pad_size = outIdx_align + RESIDUE_4K - compressed_size - SNAPPY_CHUNK_HEADER_SIZE;
+            temp[0] = SNAPPY_CHUNK_PADDING;
+            temp[1] = pad_size;
+            temp[2] = pad_size >> 8;
+            temp[3] = pad_size >> 16;
+            memset(temp + SNAPPY_CHUNK_HEADER_SIZE, 0, pad_size);
+        } else if (m_p2pEnable || (m_FrameFlags & FRAME_ZONE_MAP)) {
+            // Readers find the zone map behind the zero padding
             uint8_t* temp;
             temp = (uint8_t*) m_OutputHostMappedBufVec[i];
 
@@ -257,12 +531,71 @@ void Compress::postProcess()
         }
         compressed_size = outIdx_align + RESIDUE_4K;
         outputFileSizeVec[i] = compressed_size;
+        auto pad_end = std::chrono::high_resolution_clock::now();
+        m_metrics.record(STAGE_PAD, i, std::chrono::duration_cast<std::chrono::nanoseconds>(pad_end - pad_start).count());
+        m_tracer.hostSpan("pad", i, pad_start, pad_end);
+    }
+}
+
+const uint32_t* Compress::blockEntropy(uint32_t fid) const
+{
+    return h_entropyVec[m_fileLaunchVec[fid]] + m_fileFirstBlockVec[fid];
+}
+
+std::string Compress::launchName(uint32_t launch) const
+{
+    uint32_t first = m_launchFirstFileVec[launch];
+    uint32_t last = (launch + 1 < m_launchFirstFileVec.size()) ? m_launchFirstFileVec[launch + 1] : m_fileLaunchVec.size();
+    if (last - first == 1) return m_InputFileNameVec[first];
+    return m_InputFileNameVec[first] + " + " + std::to_string(last - first - 1) + " files";
+}
+
+double Compress::fileEntropy(uint32_t fid) const
+{
+    uint32_t block_size_in_bytes = m_BlockSizeInKb * KB;
+    uint32_t num_blocks = (m_InputFileSizeVec[fid] - 1) / block_size_in_bytes + 1;
+    const uint32_t* entropy = blockEntropy(fid);
+    double sum = 0;
+    for (uint32_t b = 0; b < num_blocks; b++) {
+        uint32_t block_size = std::min(block_size_in_bytes, m_InputFileSizeVec[fid] - b * block_size_in_bytes);
+        sum += (double)entropy[b] * block_size;
     }
+    return sum / ENTROPY_ONE_BIT / m_InputFileSizeVec[fid];
+}
+
+uint32_t Compress::highEntropyBlocks(uint32_t fid) const
+{
+    uint32_t num_blocks = (m_InputFileSizeVec[fid] - 1) / (m_BlockSizeInKb * KB) + 1;
+    const uint32_t* entropy = blockEntropy(fid);
+    uint32_t count = 0;
+    for (uint32_t b = 0; b < num_blocks; b++) {
+        if (entropy[b] >= ENTROPY_RAW_THRESHOLD) count++;
+    }
+    return count;
 }
 
 size_t Compress::create_header(uint8_t* h_header, uint32_t inSize) {
+    if (m_Codec == CODEC_SNAPPY) {
+        return snappyStreamIdentifier(h_header);
+    }
+    if (m_Codec == CODEC_ZLIB) {
+        // CM 8 with a 32K window, FLEVEL 0, no dictionary
+        h_header[0] = 0x78;
+        h_header[1] = 0x01;
+        return ZLIB_HEADER_SIZE;
+    }
+    if (m_Codec == CODEC_GZIP) {
+        // Deflate, no flags, no MTIME, XFL 0, OS Unix
+        const uint8_t gzip_header[GZIP_HEADER_SIZE] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 3};
+        memcpy(h_header, gzip_header, GZIP_HEADER_SIZE);
+        return GZIP_HEADER_SIZE;
+    }
+    return lz4FrameHeader(h_header, m_BlockSizeInKb, inSize, m_FrameFlags & FLG_CONTENT_CHECKSUM, m_dictId);
+}
+
+size_t lz4FrameHeader(uint8_t* h_header, uint32_t block_kb, uint32_t inSize, bool checksum, uint32_t dict_id) {
     uint8_t block_size_header = 0;
-    switch (m_BlockSizeInKb) {
+    switch (block_kb) {
         case 64:
             block_size_header = BSIZE_STD_64KB;
             break;
@@ -281,10 +614,14 @@ size_t Compress::create_header(uint8_t* h_header, uint32_t inSize) {
             break;
     }
 
-    uint8_t temp_buff[10] = {FLG_BYTE, block_size_header, inSize, inSize >> 8, inSize >> 16, inSize >> 24, 0, 0, 0, 0};
+    uint8_t flg = checksum ? (FLG_BYTE | FLG_BLOCK_CHECKSUM | FLG_CONTENT_CHECKSUM) : FLG_BYTE;
+    if (dict_id) flg |= FLG_DICT_ID;
+    uint8_t temp_buff[14] = {flg, block_size_header, (uint8_t)inSize, (uint8_t)(inSize >> 8), (uint8_t)(inSize >> 16),
+                             (uint8_t)(inSize >> 24), 0, 0, 0, 0, (uint8_t)dict_id, (uint8_t)(dict_id >> 8),
+                             (uint8_t)(dict_id >> 16), (uint8_t)(dict_id >> 24)};
 
     // xxhash is used to calculate hash value
-    uint32_t xxh = XXH32(temp_buff, 10, 0);
+    uint32_t xxh = XXH32(temp_buff, dict_id ? 14 : 10, 0);
     // This value is sent to Kernel 2
     uint32_t xxhash_val = (xxh >> 8);
 
@@ -296,23 +633,10 @@ size_t Compress::create_header(uint8_t* h_header, uint32_t inSize) {
     h_header[head_size++] = MAGIC_BYTE_3;
     h_header[head_size++] = MAGIC_BYTE_4;
 
-    h_header[head_size++] = FLG_BYTE;
+    h_header[head_size++] = flg;
 
     // Value
-    switch (m_BlockSizeInKb) {
-        case 64:
-            h_header[head_size++] = BSIZE_STD_64KB;
-            break;
-        case 256:
-            h_header[head_size++] = BSIZE_STD_256KB;
-            break;
-        case 1024:
-            h_header[head_size++] = BSIZE_STD_1024KB;
-            break;
-        case 4096:
-            h_header[head_size++] = BSIZE_STD_4096KB;
-            break;
-    }
+    h_header[head_size++] = block_size_header;
 
     // Input size
     h_header[head_size++] = inSize;
@@ -324,7 +648,15 @@ size_t Compress::create_header(uint8_t* h_header, uint32_t inSize) {
     h_header[head_size++] = 0;
     h_header[head_size++] = 0;
 
+    // Dictionary ID
+    if (dict_id) {
+        h_header[head_size++] = dict_id;
+        h_header[head_size++] = dict_id >> 8;
+        h_header[head_size++] = dict_id >> 16;
+        h_header[head_size++] = dict_id >> 24;
+    }
+
     // XXHASH value
     h_header[head_size++] = xxhash_val;
     return head_size;
-}
\ No newline at end of file
+}
@@ -19,6 +19,8 @@
 #include <vector>
 #include "../../kernel/include/lz4_p2p.hpp"
 #include "lz4_p2p_dec.hpp"
+#include "lz4_frame.hpp"
+#include "lz4_dict.hpp"
 #include <cstdio>
 #include <fstream>
 #include <iosfwd>
@@ -31,10 +33,32 @@ int fd_p2p_c_out = 0;
 int fd_p2p_c_in = 0;
 
 
-Decompress::Decompress(const std::string& binaryFile, uint8_t device_id, bool p2p_enable)
+// ISIZE of a gzip member, the last 4 bytes of the file. A file padded to whole
+// pages (as Compress writes them) ends with zeros instead.
+static uint64_t gzipTrailerSize(const std::string& file, uint64_t file_size)
+{
+    uint8_t isize[4] = {0};
+    std::ifstream in(file.c_str(), std::ifstream::binary);
+    if (file_size < 4 || !in.seekg(file_size - 4) || !in.read((char*)isize, 4)) return 0;
+    return isize[0] | (isize[1] << 8) | (isize[2] << 16) | ((uint64_t)isize[3] << 24);
+}
+
+Decompress::Decompress(const std::string& binaryFile, uint8_t device_id, bool p2p_enable, uint32_t num_cu,
+                       compressCodec codec)
     : SmartSSD(binaryFile, device_id, p2p_enable)
 {
+    if (num_cu == 0 || num_cu > MAX_DECOMPRESS_CU) {
+        std::cout << "Error: number of decompress compute units should be within 1 ~ " << MAX_DECOMPRESS_CU << std::endl;
+        exit(1);
+    }
+    m_numCU = num_cu;
+    m_Codec = codec;
+    m_metrics.setOperation("decompress");
     m_compression_time = std::chrono::milliseconds::zero();
+    m_filter.mode = FILTER_NONE;
+    m_filter.delimiter = '\n';
+    m_filterCLBuf = NULL;
+    m_filterHostBuf = NULL;
 }
 
 Decompress::~Decompress()
@@ -42,26 +66,111 @@ Decompress::~Decompress()
     std::cout << "########################### FPGA Operation ###########################################" << std::endl;
     std::cout << "\x1B[32m[FPGA Operation]\033[0m Compression Time : " << std::fixed << std::setprecision(2) << m_compression_time.count() << " ns" << std::endl;
     for (uint32_t i = 0; i < m_InputFileDescVec.size(); i++) {
+#ifdef KERNEL_STATS
+        if (deflateCodec(m_Codec)) {
+            printKernelStats(inflate_kernel_names[0], m_InputFileNameVec[i], h_statsVec[i][0]);
+        } else {
+            printKernelStats(unpacker_kernel_names[0], m_InputFileNameVec[i], h_statsVec[i][0]);
+            for (uint32_t cu = 1; cu < h_statsVec[i].size(); cu++) {
+                printKernelStats(decompress_kernel_names[0] + "_" + std::to_string(cu), m_InputFileNameVec[i], h_statsVec[i][cu]);
+            }
+        }
+        for (uint32_t k = 0; k < h_statsVec[i].size(); k++) {
+            delete (bufStatsVec[i][k]);
+            free(h_statsVec[i][k]);
+        }
+#endif
+        if (deflateCodec(m_Codec)) {
+            delete (bufResultVec[i]);
+            free(h_resultVec[i]);
+        }
         delete (bufChunkInfoVec[i]);
         delete (bufBlockInfoVec[i]);
+        delete (bufColumnStatsVec[i]);
 
         delete (unpackerKernelVec[i]);
-        delete (decompressKernelVec[i]);
+        for (cl::Kernel* kernel : decompressKernelVec[i]) {
+            delete (kernel);
+        }
+    }
+    if (m_filterCLBuf) {
+        delete (m_filterCLBuf);
+        free(m_filterHostBuf);
+    }
+}
+
+void Decompress::setFilter(const std::vector<std::string>& patterns,
+                           uint8_t delimiter,
+                           uint32_t mode,
+                           const std::vector<uint32_t>& columns,
+                           uint8_t field_delimiter)
+{
+    if (deflateCodec(m_Codec)) {
+        std::cout << "Error: the record filter runs in xilLz4P2PDecompress, for LZ4 frames and Snappy streams" << std::endl;
+        exit(1);
+    }
+    recordFilterBuild(patterns, delimiter, mode, m_filter, columns, field_delimiter);
+}
+
+cl::Buffer* Decompress::filterBuffer()
+{
+    if (m_filterCLBuf == NULL) {
+        // Without a filter the kernels only read the dt_filterConfig word, FILTER_NONE
+        size_t size = (m_filter.mode == FILTER_NONE) ? sizeof(dt_filterConfig) : m_filter.config.size();
+        m_filterHostBuf = (uint8_t*)aligned_alloc(4096, ((size - 1) / 4096 + 1) * 4096);
+        memset(m_filterHostBuf, 0, size);
+        if (m_filter.mode != FILTER_NONE) memcpy(m_filterHostBuf, m_filter.config.data(), size);
+        m_filterCLBuf = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_READ_ONLY, size, m_filterHostBuf);
+        m_q->enqueueMigrateMemObjects({*m_filterCLBuf}, 0 /* 0 means from host*/);
     }
+    return m_filterCLBuf;
 }
 
 void Decompress::MakeOutputFileList(const std::vector<std::string>& inputFile)
 {
     for (std::string inFile : inputFile)
     {
-        std::string out_file = inFile + ".org";
-        std::string delimiter = ".lz4";
-        std::string token = inFile.substr(0, inFile.find(delimiter));
-        orgFileList.push_back(token);
+        std::string out_file = inFile + ((m_filter.mode == FILTER_NONE) ? ".org" : ".match");
         m_OutputFileNameVec.push_back(out_file);
 
-        uint32_t input_size = get_file_size(token.c_str());
-        uint64_t input_size_4k_multiple = ((input_size - 1) / (4096) + 1) * 4096;
+        if (m_Codec == CODEC_SNAPPY) {
+            // Snappy streams carry no content size, the chunk headers give it
+            snappyFrameInfo info;
+            snappyReadFrameInfo(inFile, info);
+            snappyInfoVec.push_back(info);
+            blockSizeKbVec.push_back(SNAPPY_BLOCK_SIZE / KB);
+            frameFlagsVec.push_back(FRAME_SNAPPY);
+            oriFileSizeVec.push_back(((info.contentSize - 1) / 4096 + 1) * 4096);
+            continue;
+        }
+        snappyInfoVec.push_back({0, 0});
+        if (deflateCodec(m_Codec)) {
+            // Only a gzip member records its content size (modulo 4 GB), anything above the largest Deflate
+            // ratio (1032:1) is not an ISIZE
+            uint64_t compressed_size = get_file_size(inFile);
+            uint64_t size = compressed_size * INFLATE_SIZE_RATIO;
+            if (m_Codec == CODEC_GZIP) {
+                uint64_t isize = gzipTrailerSize(inFile, compressed_size);
+                if (isize > size && isize <= compressed_size * 1032) size = isize;
+            }
+            blockSizeKbVec.push_back(0);
+            frameFlagsVec.push_back(0);
+            oriFileSizeVec.push_back(((std::max<uint64_t>(size, 1) - 1) / 4096 + 1) * 4096);
+            continue;
+        }
+
+        // Block and content size come from the frame, xilLz4Unpacker expects the header of create_header()
+        lz4FrameInfo info;
+        lz4ReadFrameHeader(inFile, info);
+        if (!(info.flags & FLG_BLOCK_INDEPENDENT) || !(info.flags & FLG_CONTENT_SIZE) || info.contentSize == 0) {
+            std::cout << inFile << ": FPGA backend needs independent blocks and the content size" << std::endl;
+            exit(1);
+        }
+        lz4CheckDictionary(inFile, info, m_dict);
+        blockSizeKbVec.push_back(info.blockSize / KB);
+        frameFlagsVec.push_back(info.flags);
+
+        uint64_t input_size_4k_multiple = ((info.contentSize - 1) / (4096) + 1) * 4096;
         oriFileSizeVec.push_back(input_size_4k_multiple);
     }
 
@@ -71,34 +180,96 @@ void Decompress::MakeOutputFileList(const std::vector<std::string>& inputFile)
 void Decompress::preProcess()
 {
     cl_mem_ext_ptr_t hostBoExt = {0};
+    blockInfoVec.resize(m_InputFileDescVec.size());
+    columnStatsVec.resize(m_InputFileDescVec.size());
     for (uint32_t fid = 0; fid < m_InputFileDescVec.size(); fid++) {
         uint64_t original_size = 0;
-        uint32_t block_size_in_bytes = BLOCK_SIZE_IN_KB * 1024;
-        uint32_t m_BlockSizeInKb = BLOCK_SIZE_IN_KB;
+        uint32_t m_BlockSizeInKb = blockSizeKbVec[fid];
+        uint32_t block_size_in_bytes = m_BlockSizeInKb * 1024;
         original_size = oriFileSizeVec[fid];
 
-        uint32_t num_blocks = (original_size - 1) / block_size_in_bytes + 1;
-        uint8_t total_no_cu = 1;
-        uint8_t first_chunk = 1;
-        std::string up_kname = unpacker_kernel_names[0];
-        std::string dec_kname = decompress_kernel_names[0];
+        if (deflateCodec(m_Codec)) {
+            bufChunkInfoVec.push_back(NULL);
+            bufBlockInfoVec.push_back(NULL);
+            bufColumnStatsVec.push_back(NULL);
+            unpackerKernelVec.push_back(NULL);
 
-        int cu_num = 0; //i % 2;
+            // Output:- Content size and status
+            uint32_t* h_result = (uint32_t*)aligned_alloc(4096, 4096);
+            memset(h_result, 0, 2 * sizeof(uint32_t));
+            h_resultVec.push_back(h_result);
+            bufResultVec.push_back(new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY, 2 * sizeof(uint32_t), h_result));
+#ifdef KERNEL_STATS
+            dt_kernelStats* h_record = (dt_kernelStats*)aligned_alloc(4096, 4096);
+            memset(h_record, 0, sizeof(dt_kernelStats));
+            h_statsVec.push_back({h_record});
+            bufStatsVec.push_back({new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY, sizeof(dt_kernelStats), h_record)});
+#endif
 
-        if (cu_num == 0) {
-            up_kname += ":{xilLz4Unpacker_1}";
-            dec_kname += ":{xilLz4P2PDecompress_1}";
-        } else {
-            up_kname += ":{xilLz4Unpacker_2}";
-            dec_kname += ":{xilLz4P2PDecompress_2}";
+            std::string inflate_kname = inflate_kernel_names[0] + ":{xilGzipDecompress_1}";
+            cl::Kernel* inflate_kernel = new cl::Kernel(*m_program, inflate_kname.c_str());
+            uint32_t narg = 0;
+            inflate_kernel->setArg(narg++, *(m_InputCLBufVec[fid]));
+            inflate_kernel->setArg(narg++, *(m_OutputCLBufVec[fid]));
+            inflate_kernel->setArg(narg++, *(bufResultVec[fid]));
+            inflate_kernel->setArg(narg++, (uint32_t)m_InputFileSizeVec[fid]);
+            inflate_kernel->setArg(narg++, (uint32_t)oriFileSizeVec[fid]);
+            inflate_kernel->setArg(narg++, (uint32_t)((m_Codec == CODEC_ZLIB) ? FRAME_ZLIB : 0));
+#ifdef KERNEL_STATS
+            inflate_kernel->setArg(narg++, *(bufStatsVec[fid][0]));
+#endif
+            decompressKernelVec.push_back({inflate_kernel});
+            continue;
         }
 
+        // One block per data chunk of a Snappy stream
+        uint32_t total_blocks = (m_Codec == CODEC_SNAPPY) ? snappyInfoVec[fid].numChunks
+                                                          : (original_size - 1) / block_size_in_bytes + 1;
+        // Do not start more compute units than there are blocks
+        uint8_t total_no_cu = (total_blocks < m_numCU) ? total_blocks : m_numCU;
+        // Blocks per compute unit, the unpacker splits the block table in runs of this size
+        uint32_t num_blocks = (total_blocks - 1) / total_no_cu + 1;
+        uint8_t first_chunk = 1;
+        std::string up_kname = unpacker_kernel_names[0] + ":{xilLz4Unpacker_1}";
+
         assert(sizeof(dt_blockInfo) == (GMEM_DATAWIDTH / 8));
-        cl::Buffer* buffer_chunk_info = new cl::Buffer(*m_context, CL_MEM_EXT_PTR_XILINX | CL_MEM_WRITE_ONLY, sizeof(dt_chunkInfo), &hostBoExt);
-        cl::Buffer* buffer_block_info = new cl::Buffer(*m_context, CL_MEM_EXT_PTR_XILINX | CL_MEM_WRITE_ONLY, sizeof(dt_blockInfo) * num_blocks, &hostBoExt);
+        cl::Buffer* buffer_chunk_info;
+        if (m_Codec == CODEC_SNAPPY) {
+            // The unpacker starts from a chunk info with the size and the chunk count MakeOutputFileList() found,
+            // at the stream identifier
+            first_chunk = 0;
+            dt_chunkInfo chunk_info;
+            memset(&chunk_info, 0, sizeof(chunk_info));
+            chunk_info.inStartIdx = 0;
+            chunk_info.originalSize = snappyInfoVec[fid].contentSize;
+            chunk_info.numBlocks = total_blocks;
+            chunk_info.flags = FRAME_SNAPPY;
+            buffer_chunk_info = new cl::Buffer(*m_context, CL_MEM_COPY_HOST_PTR | CL_MEM_READ_WRITE, sizeof(dt_chunkInfo), &chunk_info);
+        } else {
+            buffer_chunk_info = new cl::Buffer(*m_context, CL_MEM_EXT_PTR_XILINX | CL_MEM_WRITE_ONLY, sizeof(dt_chunkInfo), &hostBoExt);
+        }
+        cl::Buffer* buffer_block_info = new cl::Buffer(*m_context, CL_MEM_EXT_PTR_XILINX | CL_MEM_WRITE_ONLY, sizeof(dt_blockInfo) * total_blocks, &hostBoExt);
 
         bufChunkInfoVec.push_back(buffer_chunk_info);
         bufBlockInfoVec.push_back(buffer_block_info);
+        // Column aggregates of every block with FILTER_AGGREGATE, one block's worth otherwise
+        uint32_t stats_blocks = (m_filter.mode == FILTER_AGGREGATE) ? total_blocks : 1;
+        bufColumnStatsVec.push_back(new cl::Buffer(*m_context, CL_MEM_EXT_PTR_XILINX | CL_MEM_WRITE_ONLY,
+                                                   sizeof(dt_columnStats) * FILTER_MAX_COLUMNS * stats_blocks, &hostBoExt));
+
+#ifdef KERNEL_STATS
+        // Output:- Stats records, unpacker first and then one per compute unit
+        std::vector<dt_kernelStats*> h_stats;
+        std::vector<cl::Buffer*> stats_buffers;
+        for (uint32_t k = 0; k <= total_no_cu; k++) {
+            dt_kernelStats* h_record = (dt_kernelStats*)aligned_alloc(4096, 4096);
+            memset(h_record, 0, sizeof(dt_kernelStats));
+            h_stats.push_back(h_record);
+            stats_buffers.push_back(new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY, sizeof(dt_kernelStats), h_record));
+        }
+        h_statsVec.push_back(h_stats);
+        bufStatsVec.push_back(stats_buffers);
+#endif
 
         cl::Kernel* unpacker_kernel_lz4 = new cl::Kernel(*m_program, up_kname.c_str());
         uint32_t narg = 0;
@@ -109,61 +280,520 @@ void Decompress::preProcess()
         unpacker_kernel_lz4->setArg(narg++, first_chunk);
         unpacker_kernel_lz4->setArg(narg++, total_no_cu);
         unpacker_kernel_lz4->setArg(narg++, num_blocks);
+#ifdef KERNEL_STATS
+        unpacker_kernel_lz4->setArg(narg++, *(bufStatsVec[fid][0]));
+#endif
         unpackerKernelVec.push_back(unpacker_kernel_lz4);
 
-        narg = 0;
-        uint32_t tmp = 0;
-
-        cl::Kernel* decompress_kernel_lz4 = new cl::Kernel(*m_program, dec_kname.c_str());
-        decompress_kernel_lz4->setArg(narg++, *(m_InputCLBufVec[fid]));
-        decompress_kernel_lz4->setArg(narg++, *(m_OutputCLBufVec[fid]));
-        decompress_kernel_lz4->setArg(narg++, *(bufBlockInfoVec[fid]));
-        decompress_kernel_lz4->setArg(narg++, *(bufChunkInfoVec[fid]));
-        decompress_kernel_lz4->setArg(narg++, m_BlockSizeInKb);
-        decompress_kernel_lz4->setArg(narg++, tmp);
-        decompress_kernel_lz4->setArg(narg++, total_no_cu);
-        decompress_kernel_lz4->setArg(narg++, num_blocks);
-        decompressKernelVec.push_back(decompress_kernel_lz4);
+        std::vector<cl::Kernel*> decompress_kernels;
+        for (uint32_t cu = 0; cu < total_no_cu; cu++) {
+            std::string dec_kname = decompress_kernel_names[0] + ":{xilLz4P2PDecompress_" + std::to_string(cu + 1) + "}";
+
+            narg = 0;
+            cl::Kernel* decompress_kernel_lz4 = new cl::Kernel(*m_program, dec_kname.c_str());
+            decompress_kernel_lz4->setArg(narg++, *(m_InputCLBufVec[fid]));
+            decompress_kernel_lz4->setArg(narg++, *(m_OutputCLBufVec[fid]));
+            decompress_kernel_lz4->setArg(narg++, *(bufBlockInfoVec[fid]));
+            decompress_kernel_lz4->setArg(narg++, *(bufChunkInfoVec[fid]));
+            decompress_kernel_lz4->setArg(narg++, m_BlockSizeInKb);
+            decompress_kernel_lz4->setArg(narg++, cu);
+            decompress_kernel_lz4->setArg(narg++, total_no_cu);
+            decompress_kernel_lz4->setArg(narg++, num_blocks);
+            decompress_kernel_lz4->setArg(narg++, *dictBuffer());
+            decompress_kernel_lz4->setArg(narg++, (uint32_t)m_dict.size());
+            decompress_kernel_lz4->setArg(narg++, *filterBuffer());
+            decompress_kernel_lz4->setArg(narg++, *(bufColumnStatsVec[fid]));
+#ifdef KERNEL_STATS
+            decompress_kernel_lz4->setArg(narg++, *(bufStatsVec[fid][cu + 1]));
+#endif
+            decompress_kernels.push_back(decompress_kernel_lz4);
+        }
+        decompressKernelVec.push_back(decompress_kernels);
     }
     m_q->finish();
 }
 void Decompress::run()
 {
-    std::vector<cl::Event> writeWait;
-    std::vector<cl::Event> unpackWait;
-    std::vector<cl::Event> opFinishEvent;
+    if (deflateCodec(m_Codec)) {
+        runInflate();
+        return;
+    }
+
+    std::vector<std::vector<cl::Event>> opFinishEvent;
+    std::vector<cl::Event> writeEvent;
+    // One read of the whole output per file, or one per block that kept any bytes with a record filter
+    std::vector<std::vector<cl::Event>> readEvent;
     
     auto kernel_start = std::chrono::high_resolution_clock::now();
     for (uint32_t fid = 0; fid < m_InputFileDescVec.size(); fid++) {
         cl::Event write_event;
         cl::Event unpack_event;
-        cl::Event opFinish_event;
+        std::vector<cl::Event> unpackWait;
+        std::vector<cl::Event> cuFinishEvent;
         if (m_p2pEnable == false)
         {
             m_q->enqueueMigrateMemObjects({*(m_InputCLBufVec[fid])}, 0 /* 0 means from host*/, NULL, &write_event);
             write_event.wait();
+            writeEvent.push_back(write_event);
         }
 
         m_q->enqueueTask(*unpackerKernelVec[fid], NULL, &unpack_event);
+        m_tracer.anchor(unpack_event, std::chrono::high_resolution_clock::now());
         unpackWait.push_back(unpack_event);
-        
-        m_q->enqueueTask(*decompressKernelVec[fid], &unpackWait, &opFinish_event);
-        opFinishEvent.push_back(opFinish_event);
+        cuFinishEvent.push_back(unpack_event);
+
+        // All compute units wait on the same block table and run concurrently
+        for (cl::Kernel* kernel : decompressKernelVec[fid]) {
+            cl::Event opFinish_event;
+            m_q->enqueueTask(*kernel, &unpackWait, &opFinish_event);
+            cuFinishEvent.push_back(opFinish_event);
+        }
+        opFinishEvent.push_back(cuFinishEvent);
     }
 
     for (uint32_t i = 0; i < m_InputFileDescVec.size(); i++) {
-        opFinishEvent[i].wait();
+        cl::WaitForEvents(opFinishEvent[i]);
+
+        std::vector<cl::Event> read_events;
+        if (m_filter.mode != FILTER_NONE) {
+            // The block table says how much the filter left of every block, at the start of its output range
+            uint32_t total_blocks = (m_Codec == CODEC_SNAPPY) ? snappyInfoVec[i].numChunks
+                                                              : (oriFileSizeVec[i] - 1) / (blockSizeKbVec[i] * KB) + 1;
+            blockInfoVec[i].resize(total_blocks);
+            m_q->enqueueReadBuffer(*(bufBlockInfoVec[i]), CL_TRUE, 0, sizeof(dt_blockInfo) * total_blocks, blockInfoVec[i].data());
+            if (m_filter.mode == FILTER_AGGREGATE) {
+                columnStatsVec[i].resize(total_blocks * FILTER_MAX_COLUMNS);
+                cl::Event read_event;
+                m_q->enqueueReadBuffer(*(bufColumnStatsVec[i]), 0, 0, sizeof(dt_columnStats) * columnStatsVec[i].size(),
+                                       columnStatsVec[i].data(), NULL, &read_event);
+                read_events.push_back(read_event);
+            }
+            for (uint32_t b = 0; b < total_blocks && m_p2pEnable == false; b++) {
+                if (blockInfoVec[i][b].filteredSize == 0) continue;
+                uint64_t block_offset = (uint64_t)b * blockSizeKbVec[i] * KB;
+                cl::Event read_event;
+                m_q->enqueueReadBuffer(*(m_OutputCLBufVec[i]), 0, block_offset, blockInfoVec[i][b].filteredSize,
+                                       m_OutputHostMappedBufVec[i] + block_offset, NULL, &read_event);
+                read_events.push_back(read_event);
+            }
+        } else if (m_p2pEnable == false) {
+            cl::Event read_event;
+            m_q->enqueueReadBuffer(*(m_OutputCLBufVec[i]), 0, 0, oriFileSizeVec[i], m_OutputHostMappedBufVec[i], NULL, &read_event);
+            read_events.push_back(read_event);
+        }
+        readEvent.push_back(read_events);
+#ifdef KERNEL_STATS
+        std::vector<cl::Memory> stats_buffers;
+        for (cl::Buffer* buffer : bufStatsVec[i]) {
+            stats_buffers.push_back(*buffer);
+        }
+        m_q->enqueueMigrateMemObjects(stats_buffers, CL_MIGRATE_MEM_OBJECT_HOST);
+#endif
+    }
+
+    m_q->finish();
+    auto comp_end = std::chrono::high_resolution_clock::now();
+    m_compression_time = std::chrono::duration<double, std::nano>(comp_end - kernel_start);
+
+    for (uint32_t i = 0; i < m_InputFileDescVec.size(); i++) {
+        std::string file = " " + std::to_string(i);
+        // opFinishEvent holds the unpacker first, then one event per compute unit
+        m_tracer.deviceEvent("unpack" + file, "xilLz4Unpacker_1", i, opFinishEvent[i][0]);
+        for (uint32_t cu = 1; cu < opFinishEvent[i].size(); cu++) {
+            m_tracer.deviceEvent("decompress" + file, "xilLz4P2PDecompress_" + std::to_string(cu), i, opFinishEvent[i][cu]);
+        }
+        if (m_p2pEnable == false) {
+            m_tracer.deviceEvent("migrate" + file, "host to device " + std::to_string(i), i, writeEvent[i]);
+            for (cl::Event& read_event : readEvent[i]) {
+                m_tracer.deviceEvent("readback" + file, "device to host " + std::to_string(i), i, read_event);
+            }
+        }
 
+        // Unpacker start to the end of the last compute unit
+        m_metrics.recordEvents(STAGE_KERNEL, i, opFinishEvent[i]);
         if (m_p2pEnable == false) {
-            m_q->enqueueReadBuffer(*(m_OutputCLBufVec[i]), 0, 0, oriFileSizeVec[i], m_OutputHostMappedBufVec[i]);
+            m_metrics.recordEvent(STAGE_MIGRATE, i, writeEvent[i]);
+            m_metrics.recordEvents(STAGE_READBACK, i, readEvent[i]);
         }
     }
+}
+
+void Decompress::resizeOutput(uint32_t fid, uint64_t size)
+{
+    if (m_p2pEnable) {
+        m_q->enqueueUnmapMemObject(*(m_OutputCLBufVec[fid]), m_OutputHostMappedBufVec[fid]);
+        m_q->finish();
+        delete (m_OutputCLBufVec[fid]);
+
+        cl_mem_ext_ptr_t lz4Ext;
+        lz4Ext.flags = XCL_MEM_DDR_BANK0 | XCL_MEM_EXT_P2P_BUFFER;
+        lz4Ext.param = NULL;
+        lz4Ext.obj = nullptr;
+        m_OutputCLBufVec[fid] = new cl::Buffer(*m_context, CL_MEM_WRITE_ONLY | CL_MEM_EXT_PTR_XILINX, size, &lz4Ext);
+        m_OutputHostMappedBufVec[fid] = (uint8_t*)m_q->enqueueMapBuffer(*(m_OutputCLBufVec[fid]), CL_TRUE, CL_MAP_READ, 0, size);
+    } else {
+        delete (m_OutputCLBufVec[fid]);
+        free(m_OutputHostMappedBufVec[fid]);
+        m_OutputHostMappedBufVec[fid] = (uint8_t*)aligned_alloc(4096, size);
+        m_OutputCLBufVec[fid] = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY, size, m_OutputHostMappedBufVec[fid]);
+    }
+    oriFileSizeVec[fid] = size;
+    outputFileSizeVec[fid] = size;
+}
+
+void Decompress::runInflate()
+{
+    std::vector<cl::Event> writeEvent;
+    std::vector<cl::Event> kernelEvent;
+    std::vector<cl::Event> readEvent;
+
+    auto kernel_start = std::chrono::high_resolution_clock::now();
+    for (uint32_t fid = 0; fid < m_InputFileDescVec.size(); fid++) {
+        std::vector<cl::Event> kernelWait;
+        if (m_p2pEnable == false) {
+            cl::Event write_event;
+            m_q->enqueueMigrateMemObjects({*(m_InputCLBufVec[fid])}, 0 /* 0 means from host*/, NULL, &write_event);
+            writeEvent.push_back(write_event);
+            kernelWait.push_back(write_event);
+        }
+        cl::Event kernel_event;
+        m_q->enqueueTask(*decompressKernelVec[fid][0], &kernelWait, &kernel_event);
+        m_tracer.anchor(kernel_event, std::chrono::high_resolution_clock::now());
+        kernelEvent.push_back(kernel_event);
+    }
+
+    for (uint32_t fid = 0; fid < m_InputFileDescVec.size(); fid++) {
+        kernelEvent[fid].wait();
+        m_q->enqueueReadBuffer(*(bufResultVec[fid]), CL_TRUE, 0, 2 * sizeof(uint32_t), h_resultVec[fid]);
+
+        // The content did not fit: run the file again with an output buffer of its size
+        uint64_t content_size = h_resultVec[fid][0];
+        if (h_resultVec[fid][1] == INFLATE_OK && content_size > oriFileSizeVec[fid]) {
+            resizeOutput(fid, ((content_size - 1) / 4096 + 1) * 4096);
+            cl::Kernel* kernel = decompressKernelVec[fid][0];
+            kernel->setArg(1, *(m_OutputCLBufVec[fid]));
+            kernel->setArg(4, (uint32_t)oriFileSizeVec[fid]);
+            m_q->enqueueTask(*kernel, NULL, &kernelEvent[fid]);
+            kernelEvent[fid].wait();
+            m_q->enqueueReadBuffer(*(bufResultVec[fid]), CL_TRUE, 0, 2 * sizeof(uint32_t), h_resultVec[fid]);
+        }
+
+        if (m_p2pEnable == false) {
+            cl::Event read_event;
+            uint64_t read_size = std::min<uint64_t>(std::max<uint64_t>(h_resultVec[fid][0], 1), oriFileSizeVec[fid]);
+            m_q->enqueueReadBuffer(*(m_OutputCLBufVec[fid]), 0, 0, read_size, m_OutputHostMappedBufVec[fid], NULL, &read_event);
+            readEvent.push_back(read_event);
+        }
+#ifdef KERNEL_STATS
+        m_q->enqueueMigrateMemObjects({*(bufStatsVec[fid][0])}, CL_MIGRATE_MEM_OBJECT_HOST);
+#endif
+    }
 
     m_q->finish();
     auto comp_end = std::chrono::high_resolution_clock::now();
     m_compression_time = std::chrono::duration<double, std::nano>(comp_end - kernel_start);
+
+    for (uint32_t i = 0; i < m_InputFileDescVec.size(); i++) {
+        std::string file = " " + std::to_string(i);
+        m_tracer.deviceEvent("decompress" + file, "xilGzipDecompress_1", i, kernelEvent[i]);
+        m_metrics.recordEvent(STAGE_KERNEL, i, kernelEvent[i]);
+        if (m_p2pEnable == false) {
+            m_tracer.deviceEvent("migrate" + file, "host to device " + std::to_string(i), i, writeEvent[i]);
+            m_tracer.deviceEvent("readback" + file, "device to host " + std::to_string(i), i, readEvent[i]);
+            m_metrics.recordEvent(STAGE_MIGRATE, i, writeEvent[i]);
+            m_metrics.recordEvent(STAGE_READBACK, i, readEvent[i]);
+        }
+    }
+}
+
+void Decompress::joinFiltered(uint32_t fid)
+{
+    const std::vector<dt_blockInfo>& block_info = blockInfoVec[fid];
+    uint64_t block_size = blockSizeKbVec[fid] * KB;
+    for (uint32_t b = 0; b < block_info.size(); b++) {
+        if (block_info[b].filterStatus == FILTER_OVERFLOW) {
+            std::cout << "Error: " << m_InputFileNameVec[fid] << " block " << b
+                      << " has matching records too short for their offsets or columns, or a record longer than "
+                      << FILTER_MAX_RECORD << " B across its end, filter records instead" << std::endl;
+            exit(1);
+        }
+    }
+
+    std::vector<uint8_t> result;
+    recordFilterJoin join(m_filter, result);
+    uint64_t content_size = 0;
+    for (uint32_t b = 0; b < block_info.size(); b++) {
+        const dt_columnStats* column_stats =
+            columnStatsVec[fid].empty() ? NULL : columnStatsVec[fid].data() + b * FILTER_MAX_COLUMNS;
+        join.addBlock(m_OutputHostMappedBufVec[fid] + b * block_size, block_info[b], column_stats);
+        content_size += block_info[b].blockSize;
+    }
+    join.finish();
+
+    // Whole pages are written as for the content, the result followed by zeros
+    uint64_t size_4k = result.empty() ? 0 : ((result.size() - 1) / 4096 + 1) * 4096;
+    if (size_4k > oriFileSizeVec[fid]) resizeOutput(fid, size_4k);
+    if (!result.empty()) memcpy(m_OutputHostMappedBufVec[fid], result.data(), result.size());
+    memset(m_OutputHostMappedBufVec[fid] + result.size(), 0, size_4k - result.size());
+    outputFileSizeVec[fid] = size_4k;
+    // The offsets, columns and CSV end where the result does, zeros past it would read as data
+    m_OutputLengthVec.resize(m_OutputFileDescVec.size(), UINT64_MAX);
+    m_OutputLengthVec[fid] = result.size();
+    std::cout << "\x1B[32m[Record Filter]\033[0m " << m_InputFileNameVec[fid] << " : " << join.matches()
+              << " matching records, " << result.size() << " B of " << content_size << " B content" << std::endl;
+    for (uint32_t c = 0; c < join.stats().size() && m_filter.mode == FILTER_AGGREGATE; c++) {
+        const dt_columnStats& stats = join.stats()[c];
+        std::cout << "\x1B[32m[Record Filter]\033[0m column " << m_filter.columns[c] << " : count " << stats.count
+                  << " sum " << stats.sum;
+        if (stats.count) std::cout << " min " << stats.min << " max " << stats.max;
+        std::cout << std::endl;
+    }
 }
 
+// xilLz4P2PDecompress checks the block checksums as it decompresses and leaves
+// the result in the block table, the CRC32C of every chunk of a Snappy stream
+// as well. The content checksum is not verified here.
 void Decompress::postProcess()
 {
-}
\ No newline at end of file
+    if (deflateCodec(m_Codec)) {
+        // xilGzipDecompress checks the CRC32 (and ISIZE) or Adler32 of the trailer
+        for (uint32_t fid = 0; fid < m_InputFileDescVec.size(); fid++) {
+            uint32_t status = h_resultVec[fid][1];
+            if (status == INFLATE_BAD_STREAM) {
+                std::cout << "Error: " << m_InputFileNameVec[fid] << " is not a valid "
+                          << ((m_Codec == CODEC_ZLIB) ? "zlib stream" : "gzip member") << std::endl;
+                exit(1);
+            }
+            if (status == INFLATE_TRAILER_MISMATCH) {
+                std::cout << "Error: " << m_InputFileNameVec[fid] << " content does not match its "
+                          << ((m_Codec == CODEC_ZLIB) ? "Adler32" : "CRC32 or size") << std::endl;
+                exit(1);
+            }
+            // Whole pages are written as for LZ4 frames, the content followed by zeros
+            uint64_t content_size = h_resultVec[fid][0];
+            uint64_t size_4k = content_size ? ((content_size - 1) / 4096 + 1) * 4096 : 0;
+            memset(m_OutputHostMappedBufVec[fid] + content_size, 0, size_4k - content_size);
+            outputFileSizeVec[fid] = size_4k;
+        }
+        return;
+    }
+
+    for (uint32_t fid = 0; fid < m_InputFileDescVec.size(); fid++) {
+        bool snappy = (frameFlagsVec[fid] & FRAME_SNAPPY);
+        if (!(frameFlagsVec[fid] & FLG_BLOCK_CHECKSUM) && !snappy && m_filter.mode == FILTER_NONE) continue;
+
+        // run() has read the block table already with a record filter
+        uint32_t total_blocks = snappy ? snappyInfoVec[fid].numChunks
+                                       : (oriFileSizeVec[fid] - 1) / (blockSizeKbVec[fid] * KB) + 1;
+        std::vector<dt_blockInfo>& block_info = blockInfoVec[fid];
+        if (block_info.empty()) {
+            block_info.resize(total_blocks);
+            m_q->enqueueReadBuffer(*(bufBlockInfoVec[fid]), CL_TRUE, 0, sizeof(dt_blockInfo) * total_blocks, block_info.data());
+        }
+
+        uint32_t mismatches = 0;
+        for (uint32_t b = 0; b < total_blocks; b++) {
+            if (block_info[b].checksumStatus == BLOCK_CHECKSUM_MISMATCH) {
+                std::cout << "Error: " << m_InputFileNameVec[fid] << " block " << b << " checksum mismatch" << std::endl;
+                mismatches++;
+            }
+        }
+        if (mismatches) exit(1);
+        if (m_filter.mode != FILTER_NONE) joinFiltered(fid);
+    }
+}
+
+bool Decompress::readRange(const std::string& file, uint64_t offset, uint64_t length, std::vector<uint8_t>& out)
+{
+    if (m_Codec != CODEC_LZ4 || m_filter.mode != FILTER_NONE) {
+        std::cout << file << ": ranges need LZ4 frames and no record filter, a Deflate or Snappy stream is decompressed"
+                  << " from its start" << std::endl;
+        exit(1);
+    }
+    lz4FrameInfo info;
+    lz4ReadFrameHeader(file, info);
+    if (!(info.flags & FLG_BLOCK_INDEPENDENT) || !(info.flags & FLG_CONTENT_SIZE)) {
+        std::cout << file << ": FPGA backend needs independent blocks and the content size" << std::endl;
+        exit(1);
+    }
+    lz4CheckDictionary(file, info, m_dict);
+    lz4BlockRange range;
+    if (!lz4FindBlockRange(file, info, offset, length, range)) return false;
+    uint32_t mid = m_metrics.addFile(file);
+
+    // Direct reads cover the run of blocks with whole 4K pages, the unpacker starts inside the first one
+    uint64_t read_offset = range.compressedOffset & ~(uint64_t)4095;
+    uint64_t read_end = range.compressedOffset + range.compressedSize;
+    uint64_t read_size = ((read_end - read_offset - 1) / 4096 + 1) * 4096;
+    uint64_t output_size = ((range.contentSize - 1) / 4096 + 1) * 4096;
+
+    cl::Buffer* buffer_input;
+    uint8_t* h_input;
+    if (m_p2pEnable) {
+        cl_mem_ext_ptr_t lz4Ext;
+        lz4Ext.flags = XCL_MEM_DDR_BANK0 | XCL_MEM_EXT_P2P_BUFFER;
+        lz4Ext.param = NULL;
+        lz4Ext.obj = nullptr;
+        buffer_input = new cl::Buffer(*m_context, CL_MEM_EXT_PTR_XILINX | CL_MEM_READ_WRITE, read_size, &lz4Ext);
+        h_input = (uint8_t*)m_q->enqueueMapBuffer(*buffer_input, CL_TRUE, CL_MAP_READ, 0, read_size);
+    } else {
+        h_input = (uint8_t*)aligned_alloc(4096, read_size);
+        buffer_input = new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_READ_WRITE, read_size, h_input);
+    }
+    uint8_t* h_output = (uint8_t*)aligned_alloc(4096, output_size);
+    cl::Buffer buffer_output(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY, output_size, h_output);
+
+    auto read_start = std::chrono::high_resolution_clock::now();
+    int fd = open(file.c_str(), O_RDONLY | O_DIRECT);
+    if (fd <= 0) {
+        std::cout << "P2P: Unable to open input file, fd: " << fd << std::endl;
+        exit(1);
+    }
+    ssize_t ret = pread(fd, h_input, read_size, read_offset);
+    close(fd);
+    if (ret < (ssize_t)(read_end - read_offset)) {
+        std::cout << "pread() failed with error: " << ret << ", line: " << __LINE__ << std::endl;
+        exit(1);
+    }
+    auto read_end_time = std::chrono::high_resolution_clock::now();
+    m_metrics.record(STAGE_READ, mid, std::chrono::duration_cast<std::chrono::nanoseconds>(read_end_time - read_start).count());
+    m_tracer.hostSpan("read range", mid, read_start, read_end_time);
+
+    // The unpacker takes the run as a frame of its own, starting from this chunk info instead of a header
+    dt_chunkInfo chunk_info;
+    memset(&chunk_info, 0, sizeof(chunk_info));
+    chunk_info.inStartIdx = range.compressedOffset - read_offset;
+    chunk_info.originalSize = range.contentSize;
+    chunk_info.numBlocks = range.numBlocks;
+    chunk_info.flags = info.flags;
+    cl::Buffer buffer_chunk_info(*m_context, CL_MEM_COPY_HOST_PTR | CL_MEM_READ_WRITE, sizeof(dt_chunkInfo), &chunk_info);
+    cl_mem_ext_ptr_t hostBoExt = {0};
+    cl::Buffer buffer_block_info(*m_context, CL_MEM_EXT_PTR_XILINX | CL_MEM_READ_WRITE, sizeof(dt_blockInfo) * range.numBlocks, &hostBoExt);
+    cl::Buffer buffer_column_stats(*m_context, CL_MEM_EXT_PTR_XILINX | CL_MEM_WRITE_ONLY, sizeof(dt_columnStats) * FILTER_MAX_COLUMNS, &hostBoExt);
+
+    uint32_t block_size_in_kb = info.blockSize / KB;
+    uint8_t total_no_cu = (range.numBlocks < m_numCU) ? range.numBlocks : m_numCU;
+    uint32_t num_blocks = (range.numBlocks - 1) / total_no_cu + 1;
+    uint8_t first_chunk = 0;
+#ifdef KERNEL_STATS
+    std::vector<dt_kernelStats*> h_stats;
+    std::vector<cl::Buffer*> stats_buffers;
+    for (uint32_t k = 0; k <= total_no_cu; k++) {
+        dt_kernelStats* h_record = (dt_kernelStats*)aligned_alloc(4096, 4096);
+        memset(h_record, 0, sizeof(dt_kernelStats));
+        h_stats.push_back(h_record);
+        stats_buffers.push_back(new cl::Buffer(*m_context, CL_MEM_USE_HOST_PTR | CL_MEM_WRITE_ONLY, sizeof(dt_kernelStats), h_record));
+    }
+#endif
+
+    std::string up_kname = unpacker_kernel_names[0] + ":{xilLz4Unpacker_1}";
+    cl::Kernel unpacker_kernel_lz4(*m_program, up_kname.c_str());
+    uint32_t narg = 0;
+    unpacker_kernel_lz4.setArg(narg++, *buffer_input);
+    unpacker_kernel_lz4.setArg(narg++, buffer_block_info);
+    unpacker_kernel_lz4.setArg(narg++, buffer_chunk_info);
+    unpacker_kernel_lz4.setArg(narg++, block_size_in_kb);
+    unpacker_kernel_lz4.setArg(narg++, first_chunk);
+    unpacker_kernel_lz4.setArg(narg++, total_no_cu);
+    unpacker_kernel_lz4.setArg(narg++, num_blocks);
+#ifdef KERNEL_STATS
+    unpacker_kernel_lz4.setArg(narg++, *(stats_buffers[0]));
+#endif
+
+    std::vector<cl::Kernel> decompress_kernels;
+    for (uint32_t cu = 0; cu < total_no_cu; cu++) {
+        std::string dec_kname = decompress_kernel_names[0] + ":{xilLz4P2PDecompress_" + std::to_string(cu + 1) + "}";
+        cl::Kernel decompress_kernel_lz4(*m_program, dec_kname.c_str());
+        narg = 0;
+        decompress_kernel_lz4.setArg(narg++, *buffer_input);
+        decompress_kernel_lz4.setArg(narg++, buffer_output);
+        decompress_kernel_lz4.setArg(narg++, buffer_block_info);
+        decompress_kernel_lz4.setArg(narg++, buffer_chunk_info);
+        decompress_kernel_lz4.setArg(narg++, block_size_in_kb);
+        decompress_kernel_lz4.setArg(narg++, cu);
+        decompress_kernel_lz4.setArg(narg++, total_no_cu);
+        decompress_kernel_lz4.setArg(narg++, num_blocks);
+        decompress_kernel_lz4.setArg(narg++, *dictBuffer());
+        decompress_kernel_lz4.setArg(narg++, (uint32_t)m_dict.size());
+        decompress_kernel_lz4.setArg(narg++, *filterBuffer());
+        decompress_kernel_lz4.setArg(narg++, buffer_column_stats);
+#ifdef KERNEL_STATS
+        decompress_kernel_lz4.setArg(narg++, *(stats_buffers[cu + 1]));
+#endif
+        decompress_kernels.push_back(decompress_kernel_lz4);
+    }
+
+    std::vector<cl::Event> writeWait;
+    if (m_p2pEnable == false) {
+        cl::Event write_event;
+        m_q->enqueueMigrateMemObjects({*buffer_input, buffer_chunk_info}, 0 /* 0 means from host*/, NULL, &write_event);
+        writeWait.push_back(write_event);
+    } else {
+        cl::Event write_event;
+        m_q->enqueueMigrateMemObjects({buffer_chunk_info}, 0 /* 0 means from host*/, NULL, &write_event);
+        writeWait.push_back(write_event);
+    }
+    cl::Event unpack_event;
+    m_q->enqueueTask(unpacker_kernel_lz4, &writeWait, &unpack_event);
+    std::vector<cl::Event> unpackWait = {unpack_event};
+    std::vector<cl::Event> cuFinishEvent = {unpack_event};
+    for (cl::Kernel& kernel : decompress_kernels) {
+        cl::Event opFinish_event;
+        m_q->enqueueTask(kernel, &unpackWait, &opFinish_event);
+        cuFinishEvent.push_back(opFinish_event);
+    }
+    cl::Event read_event;
+    m_q->enqueueReadBuffer(buffer_output, 0, 0, range.contentSize, h_output, &cuFinishEvent, &read_event);
+    std::vector<dt_blockInfo> block_info(range.numBlocks);
+    m_q->enqueueReadBuffer(buffer_block_info, 0, 0, sizeof(dt_blockInfo) * range.numBlocks, block_info.data(), &cuFinishEvent);
+#ifdef KERNEL_STATS
+    std::vector<cl::Memory> stats_objects;
+    for (cl::Buffer* buffer : stats_buffers) stats_objects.push_back(*buffer);
+    m_q->enqueueMigrateMemObjects(stats_objects, CL_MIGRATE_MEM_OBJECT_HOST, &cuFinishEvent);
+#endif
+    m_q->finish();
+
+    m_tracer.deviceEvent("unpack range", "xilLz4Unpacker_1", mid, unpack_event);
+    for (uint32_t cu = 1; cu < cuFinishEvent.size(); cu++) {
+        m_tracer.deviceEvent("decompress range", "xilLz4P2PDecompress_" + std::to_string(cu), mid, cuFinishEvent[cu]);
+    }
+    m_metrics.recordEvent(STAGE_MIGRATE, mid, writeWait[0]);
+    m_metrics.recordEvents(STAGE_KERNEL, mid, cuFinishEvent);
+    m_metrics.recordEvent(STAGE_READBACK, mid, read_event);
+#ifdef KERNEL_STATS
+    printKernelStats(unpacker_kernel_names[0], file + " range", h_stats[0]);
+    for (uint32_t cu = 1; cu < h_stats.size(); cu++) {
+        printKernelStats(decompress_kernel_names[0] + "_" + std::to_string(cu), file + " range", h_stats[cu]);
+    }
+    for (uint32_t k = 0; k < h_stats.size(); k++) {
+        delete (stats_buffers[k]);
+        free(h_stats[k]);
+    }
+#endif
+
+    bool match = true;
+    if (info.flags & FLG_BLOCK_CHECKSUM) {
+        for (uint32_t b = 0; b < range.numBlocks; b++) {
+            if (block_info[b].checksumStatus == BLOCK_CHECKSUM_MISMATCH) {
+                std::cout << "Error: " << file << " block " << range.firstBlock + b << " checksum mismatch" << std::endl;
+                match = false;
+            }
+        }
+    }
+    if (match) {
+        uint64_t start = offset - range.contentOffset;
+        uint64_t size = std::min(length, info.contentSize - offset);
+        out.assign(h_output + start, h_output + start + size);
+        m_metrics.addBytes(mid, range.compressedSize, size);
+    }
+
+    if (m_p2pEnable) {
+        m_q->enqueueUnmapMemObject(*buffer_input, h_input);
+        m_q->finish();
+    } else {
+        free(h_input);
+    }
+    delete (buffer_input);
+    free(h_output);
+    return match;
+}
@@ -0,0 +1,271 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "metrics.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// Percentiles exported for every stage
+static const double c_percentiles[] = {50, 90, 99, 99.9};
+
+static std::string jsonEscape(const std::string& in)
+{
+    std::string out;
+    for (char c : in) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if ((unsigned char)c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+// Label value of the Prometheus text format: only backslash, double quote and line feed are escaped
+static std::string labelEscape(const std::string& in)
+{
+    std::string out;
+    for (char c : in) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+LatencyHistogram::LatencyHistogram()
+    : m_buckets(BUCKET_COUNT, 0), m_count(0), m_sum(0), m_min(UINT64_MAX), m_max(0)
+{
+}
+
+uint32_t LatencyHistogram::index(uint64_t value)
+{
+    if (value < SUB_BUCKET_COUNT) return value;
+    uint32_t msb = 63 - __builtin_clzll(value);
+    uint32_t shift = msb - (SUB_BUCKET_BITS - 1);
+    uint32_t sub = value >> shift;
+    return SUB_BUCKET_COUNT + (shift - 1) * SUB_BUCKET_HALF + (sub - SUB_BUCKET_HALF);
+}
+
+uint64_t LatencyHistogram::lowest(uint32_t idx)
+{
+    if (idx < SUB_BUCKET_COUNT) return idx;
+    uint32_t shift = (idx - SUB_BUCKET_COUNT) / SUB_BUCKET_HALF + 1;
+    uint64_t sub = (idx - SUB_BUCKET_COUNT) % SUB_BUCKET_HALF + SUB_BUCKET_HALF;
+    return sub << shift;
+}
+
+uint64_t LatencyHistogram::highest(uint32_t idx)
+{
+    if (idx < SUB_BUCKET_COUNT) return idx;
+    uint32_t shift = (idx - SUB_BUCKET_COUNT) / SUB_BUCKET_HALF + 1;
+    return lowest(idx) + (((uint64_t)1 << shift) - 1);
+}
+
+void LatencyHistogram::record(uint64_t value)
+{
+    m_buckets[index(value)]++;
+    m_count++;
+    m_sum += value;
+    if (value < m_min) m_min = value;
+    if (value > m_max) m_max = value;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+    for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+        m_buckets[i] += other.m_buckets[i];
+    }
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+    if (other.m_min < m_min) m_min = other.m_min;
+    if (other.m_max > m_max) m_max = other.m_max;
+}
+
+uint64_t LatencyHistogram::percentile(double p) const
+{
+    if (m_count == 0) return 0;
+    if (p < 0) p = 0;
+    if (p > 100) p = 100;
+    uint64_t rank = (uint64_t)(p / 100 * m_count + 0.5);
+    if (rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+        seen += m_buckets[i];
+        if (seen >= rank) {
+            uint64_t value = highest(i);
+            if (value > m_max) value = m_max;
+            if (value < m_min) value = m_min;
+            return value;
+        }
+    }
+    return m_max;
+}
+
+Metrics::Metrics() : m_operation("unknown")
+{
+}
+
+const char* Metrics::stageName(MetricsStage stage)
+{
+    static const char* names[STAGE_COUNT] = {"open", "read", "migrate", "kernel", "readback", "pad", "write", "close"};
+    return names[stage];
+}
+
+uint32_t Metrics::addFile(const std::string& name)
+{
+    FileMetrics file;
+    file.name = name;
+    file.bytesIn = 0;
+    file.bytesOut = 0;
+    for (uint32_t s = 0; s < STAGE_COUNT; s++) {
+        file.stageNs[s] = 0;
+    }
+    m_files.push_back(file);
+    return m_files.size() - 1;
+}
+
+void Metrics::record(MetricsStage stage, uint32_t fid, uint64_t ns)
+{
+    if (fid < m_files.size()) m_files[fid].stageNs[stage] += ns;
+    m_stageHist[stage].record(ns);
+}
+
+void Metrics::recordEvent(MetricsStage stage, uint32_t fid, const cl::Event& event)
+{
+    cl_ulong start = event.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+    cl_ulong end = event.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+    record(stage, fid, (end > start) ? end - start : 0);
+}
+
+void Metrics::recordEvents(MetricsStage stage, uint32_t fid, const std::vector<cl::Event>& events)
+{
+    if (events.empty()) return;
+    cl_ulong first_start = UINT64_MAX;
+    cl_ulong last_end = 0;
+    for (const cl::Event& event : events) {
+        cl_ulong start = event.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+        cl_ulong end = event.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+        if (start < first_start) first_start = start;
+        if (end > last_end) last_end = end;
+    }
+    record(stage, fid, (last_end > first_start) ? last_end - first_start : 0);
+}
+
+void Metrics::addBytes(uint32_t fid, uint64_t bytes_in, uint64_t bytes_out)
+{
+    if (fid >= m_files.size()) return;
+    m_files[fid].bytesIn += bytes_in;
+    m_files[fid].bytesOut += bytes_out;
+}
+
+void Metrics::merge(const Metrics& other)
+{
+    m_files.insert(m_files.end(), other.m_files.begin(), other.m_files.end());
+    for (uint32_t s = 0; s < STAGE_COUNT; s++) {
+        m_stageHist[s].merge(other.m_stageHist[s]);
+    }
+}
+
+bool Metrics::writeJsonLines(const std::string& path) const
+{
+    std::ofstream out(path.c_str(), std::ofstream::app);
+    if (!out) {
+        std::cout << "Unable to open metrics file " << path << std::endl;
+        return false;
+    }
+
+    for (const FileMetrics& file : m_files) {
+        out << "{\"type\":\"file\",\"op\":\"" << jsonEscape(m_operation) << "\",\"file\":\""
+            << jsonEscape(file.name) << "\",\"bytes_in\":" << file.bytesIn << ",\"bytes_out\":" << file.bytesOut
+            << ",\"stages_ns\":{";
+        for (uint32_t s = 0; s < STAGE_COUNT; s++) {
+            out << (s ? "," : "") << "\"" << stageName((MetricsStage)s) << "\":" << file.stageNs[s];
+        }
+        out << "}}\n";
+    }
+
+    for (uint32_t s = 0; s < STAGE_COUNT; s++) {
+        const LatencyHistogram& hist = m_stageHist[s];
+        out << "{\"type\":\"stage\",\"op\":\"" << jsonEscape(m_operation) << "\",\"stage\":\""
+            << stageName((MetricsStage)s) << "\",\"count\":" << hist.count() << ",\"sum_ns\":" << hist.sum()
+            << ",\"min_ns\":" << hist.min() << ",\"mean_ns\":" << (uint64_t)hist.mean()
+            << ",\"p50_ns\":" << hist.percentile(50) << ",\"p90_ns\":" << hist.percentile(90)
+            << ",\"p99_ns\":" << hist.percentile(99) << ",\"p999_ns\":" << hist.percentile(99.9)
+            << ",\"max_ns\":" << hist.max() << "}\n";
+    }
+    return true;
+}
+
+bool Metrics::writePrometheus(const std::string& path) const
+{
+    std::ostringstream out;
+    std::string op = labelEscape(m_operation);
+    out << "# HELP smartssd_stage_latency_seconds Per file latency of each host pipeline stage.\n";
+    out << "# TYPE smartssd_stage_latency_seconds summary\n";
+    for (uint32_t s = 0; s < STAGE_COUNT; s++) {
+        const LatencyHistogram& hist = m_stageHist[s];
+        std::string labels = "op=\"" + op + "\",stage=\"" + labelEscape(stageName((MetricsStage)s)) + "\"";
+        for (double p : c_percentiles) {
+            out << "smartssd_stage_latency_seconds{" << labels << ",quantile=\"" << p / 100 << "\"} "
+                << hist.percentile(p) / 1e9 << "\n";
+        }
+        out << "smartssd_stage_latency_seconds_sum{" << labels << "} " << hist.sum() / 1e9 << "\n";
+        out << "smartssd_stage_latency_seconds_count{" << labels << "} " << hist.count() << "\n";
+    }
+
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+    for (const FileMetrics& file : m_files) {
+        bytes_in += file.bytesIn;
+        bytes_out += file.bytesOut;
+    }
+    out << "# HELP smartssd_bytes_total Bytes consumed and produced.\n";
+    out << "# TYPE smartssd_bytes_total counter\n";
+    out << "smartssd_bytes_total{op=\"" << op << "\",direction=\"in\"} " << bytes_in << "\n";
+    out << "smartssd_bytes_total{op=\"" << op << "\",direction=\"out\"} " << bytes_out << "\n";
+    out << "# HELP smartssd_files_total Files processed.\n";
+    out << "# TYPE smartssd_files_total counter\n";
+    out << "smartssd_files_total{op=\"" << op << "\"} " << m_files.size() << "\n";
+
+    // Write next to the target and rename so a scraper never sees a partial file
+    std::string tmp_path = path + ".tmp";
+    std::ofstream file(tmp_path.c_str(), std::ofstream::trunc);
+    if (!file) {
+        std::cout << "Unable to open metrics file " << tmp_path << std::endl;
+        return false;
+    }
+    file << out.str();
+    file.close();
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::cout << "Unable to rename " << tmp_path << " to " << path << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,405 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "../include/record_filter.hpp"
+#include <deque>
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+
+static const size_t c_classOffset = sizeof(dt_filterConfig);
+static const size_t c_tableOffset = c_classOffset + FILTER_CLASS_WORDS * (GMEM_DATAWIDTH / 8);
+
+// True when the size bytes of data are all zero, as the page padding after the last record
+static bool allZero(const uint8_t* data, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        if (data[i]) return false;
+    }
+    return true;
+}
+
+static uint16_t tableEntry(const std::vector<uint8_t>& config, uint32_t state, uint8_t byte_class)
+{
+    size_t pos = c_tableOffset + 2 * ((size_t)state * FILTER_MAX_CLASSES + byte_class);
+    return config[pos] | (config[pos + 1] << 8);
+}
+
+void recordFilterBuild(const std::vector<std::string>& patterns,
+                       uint8_t delimiter,
+                       uint32_t mode,
+                       recordFilter& filter,
+                       const std::vector<uint32_t>& columns,
+                       uint8_t field_delimiter)
+{
+    bool project = (mode == FILTER_COLUMNS) || (mode == FILTER_AGGREGATE);
+    if (patterns.empty() && !project) {
+        std::cout << "Error: the record filter needs at least one pattern" << std::endl;
+        exit(1);
+    }
+    if (project && (columns.empty() || columns.size() > FILTER_MAX_COLUMNS || field_delimiter == delimiter)) {
+        std::cout << "Error: the record filter projects 1 to " << FILTER_MAX_COLUMNS
+                  << " columns, split on a field delimiter other than the record delimiter" << std::endl;
+        exit(1);
+    }
+
+    // Every byte of a pattern gets a class of its own, all other bytes share class 0
+    uint8_t byte_class[256] = {0};
+    uint32_t num_classes = 1;
+    for (const std::string& pattern : patterns) {
+        if (pattern.empty() || pattern.find((char)delimiter) != std::string::npos) {
+            std::cout << "Error: filter pattern \"" << pattern << "\" is empty or holds the record delimiter" << std::endl;
+            exit(1);
+        }
+        for (unsigned char c : pattern) {
+            if (byte_class[c] == 0) byte_class[c] = num_classes++;
+        }
+    }
+    if (num_classes > FILTER_MAX_CLASSES) {
+        std::cout << "Error: filter patterns use " << num_classes - 1 << " distinct bytes, at most "
+                  << FILTER_MAX_CLASSES - 1 << std::endl;
+        exit(1);
+    }
+
+    // Trie of the patterns, then the failure links in breadth first order. Without patterns there is no
+    // automaton, every record matches.
+    std::vector<std::vector<int32_t> > next;
+    std::vector<bool> accept;
+    if (!patterns.empty()) {
+        next.push_back(std::vector<int32_t>(FILTER_MAX_CLASSES, -1));
+        accept.push_back(false);
+    }
+    for (const std::string& pattern : patterns) {
+        uint32_t state = 0;
+        for (unsigned char c : pattern) {
+            if (next[state][byte_class[c]] < 0) {
+                next[state][byte_class[c]] = next.size();
+                next.push_back(std::vector<int32_t>(FILTER_MAX_CLASSES, -1));
+                accept.push_back(false);
+            }
+            state = next[state][byte_class[c]];
+        }
+        accept[state] = true;
+    }
+    if (next.size() > FILTER_MAX_STATES) {
+        std::cout << "Error: filter patterns need " << next.size() << " automaton states, at most "
+                  << FILTER_MAX_STATES << std::endl;
+        exit(1);
+    }
+
+    std::vector<uint32_t> fail(next.size(), 0);
+    std::deque<uint32_t> queue;
+    for (uint32_t c = 0; c < num_classes && !next.empty(); c++) {
+        if (next[0][c] < 0) {
+            next[0][c] = 0;
+        } else {
+            queue.push_back(next[0][c]);
+        }
+    }
+    while (!queue.empty()) {
+        uint32_t state = queue.front();
+        queue.pop_front();
+        if (accept[fail[state]]) accept[state] = true;
+        for (uint32_t c = 0; c < num_classes; c++) {
+            if (next[state][c] < 0) {
+                next[state][c] = next[fail[state]][c];
+            } else {
+                fail[next[state][c]] = next[fail[state]][c];
+                queue.push_back(next[state][c]);
+            }
+        }
+    }
+
+    filter.mode = mode;
+    filter.delimiter = delimiter;
+    filter.patterns = patterns;
+    filter.fieldDelimiter = field_delimiter;
+    filter.columns = project ? columns : std::vector<uint32_t>();
+    filter.config.assign(FILTER_CONFIG_SIZE, 0);
+    dt_filterConfig header;
+    memset(&header, 0, sizeof(header));
+    header.mode = mode;
+    header.delimiter = delimiter;
+    header.numStates = next.size();
+    header.numClasses = num_classes;
+    header.fieldDelimiter = field_delimiter;
+    header.numColumns = filter.columns.size();
+    for (uint32_t c = 0; c < filter.columns.size(); c++) header.columns[c] = filter.columns[c];
+    memcpy(filter.config.data(), &header, sizeof(header));
+    memcpy(filter.config.data() + c_classOffset, byte_class, sizeof(byte_class));
+    for (uint32_t state = 0; state < next.size(); state++) {
+        for (uint32_t c = 0; c < num_classes; c++) {
+            uint32_t to = next[state][c];
+            uint16_t entry = to | (accept[to] ? FILTER_ACCEPT : 0);
+            size_t pos = c_tableOffset + 2 * ((size_t)state * FILTER_MAX_CLASSES + c);
+            filter.config[pos] = entry & 0xff;
+            filter.config[pos + 1] = entry >> 8;
+        }
+    }
+}
+
+// Runs the automaton over size bytes from state, FILTER_ACCEPT is kept once a pattern occurred
+static uint32_t filterRun(const recordFilter& filter, uint32_t state, const uint8_t* data, size_t size)
+{
+    if (filter.patterns.empty()) return FILTER_ACCEPT;
+    const uint8_t* byte_class = filter.config.data() + c_classOffset;
+    uint32_t accept = state & FILTER_ACCEPT;
+    state &= FILTER_ACCEPT - 1;
+    for (size_t i = 0; i < size; i++) {
+        uint16_t entry = tableEntry(filter.config, state, byte_class[data[i]]);
+        accept |= entry & FILTER_ACCEPT;
+        state = entry & (FILTER_ACCEPT - 1);
+    }
+    return state | accept;
+}
+
+bool recordFilterMatch(const recordFilter& filter, const uint8_t* record, size_t size)
+{
+    return filterRun(filter, 0, record, size) & FILTER_ACCEPT;
+}
+
+static void parseReset(dt_filterParseState& parse)
+{
+    memset(&parse, 0, sizeof(parse));
+    for (uint32_t c = 0; c < FILTER_MAX_COLUMNS; c++) parse.columns[c] = FILTER_NULL;
+    parse.flags = FILTER_PARSE_NUMERIC;
+}
+
+// Value of the field being parsed: an optional sign and at least one digit, wrapping as in the kernel
+static int64_t parseField(const dt_filterParseState& parse)
+{
+    if ((parse.flags & (FILTER_PARSE_NUMERIC | FILTER_PARSE_DIGITS)) != (FILTER_PARSE_NUMERIC | FILTER_PARSE_DIGITS)) {
+        return FILTER_NULL;
+    }
+    return (int64_t)((parse.flags & FILTER_PARSE_NEGATIVE) ? 0 - parse.value : parse.value);
+}
+
+// Goes on with the fields and the automaton over size bytes of a record, as recordFilter() does
+static void parseFeed(const recordFilter& filter, dt_filterParseState& parse, const uint8_t* data, size_t size)
+{
+    parse.state = filterRun(filter, parse.state, data, size);
+    for (size_t i = 0; i < size; i++) {
+        uint8_t byte = data[i];
+        if (byte == filter.fieldDelimiter) {
+            int64_t value = parseField(parse);
+            for (uint32_t c = 0; c < filter.columns.size(); c++) {
+                if (filter.columns[c] == parse.field) parse.columns[c] = value;
+            }
+            parse.field++;
+            parse.fieldLen = 0;
+            parse.value = 0;
+            parse.flags = FILTER_PARSE_NUMERIC;
+        } else {
+            if (byte >= '0' && byte <= '9') {
+                parse.value = parse.value * 10 + (byte - '0');
+                parse.flags |= FILTER_PARSE_DIGITS;
+            } else if (parse.fieldLen == 0 && (byte == '-' || byte == '+')) {
+                if (byte == '-') parse.flags |= FILTER_PARSE_NEGATIVE;
+            } else {
+                parse.flags &= ~FILTER_PARSE_NUMERIC;
+            }
+            parse.fieldLen++;
+        }
+    }
+}
+
+// Columns of the record once its last field ends
+static void parseEnd(const recordFilter& filter, const dt_filterParseState& parse, int64_t* values)
+{
+    for (uint32_t c = 0; c < filter.columns.size(); c++) {
+        values[c] = (filter.columns[c] == parse.field) ? parseField(parse) : parse.columns[c];
+    }
+}
+
+void recordFilterProject(const recordFilter& filter, const uint8_t* record, size_t size, int64_t* values)
+{
+    dt_filterParseState parse;
+    parseReset(parse);
+    parseFeed(filter, parse, record, size);
+    parseEnd(filter, parse, values);
+}
+
+recordFilterJoin::recordFilterJoin(const recordFilter& filter, std::vector<uint8_t>& out)
+    : m_filter(filter),
+      m_out(out),
+      m_carryOffset(0),
+      m_carryState(0),
+      m_carryBytes(0),
+      m_carryZero(true),
+      m_blockOffset(0),
+      m_matches(0)
+{
+    parseReset(m_parse);
+    m_stats.resize(filter.columns.size());
+    for (dt_columnStats& stats : m_stats) {
+        memset(&stats, 0, sizeof(stats));
+        stats.min = 0x7fffffffffffffffLL;
+        stats.max = FILTER_NULL;
+    }
+}
+
+void recordFilterJoin::addOffset(uint64_t offset)
+{
+    for (int b = 0; b < 8; b++) m_out.push_back(offset >> (8 * b));
+}
+
+void recordFilterJoin::addStats(const dt_columnStats& stats, uint32_t column)
+{
+    if (stats.count == 0) return;
+    dt_columnStats& total = m_stats[column];
+    total.count += stats.count;
+    total.sum = (int64_t)((uint64_t)total.sum + (uint64_t)stats.sum);
+    if (stats.min < total.min) total.min = stats.min;
+    if (stats.max > total.max) total.max = stats.max;
+}
+
+void recordFilterJoin::addRecord(const uint8_t* record, size_t size)
+{
+    bool delimited = size && (record[size - 1] == m_filter.delimiter);
+    if (!recordFilterMatch(m_filter, record, size - delimited)) return;
+    m_matches++;
+    m_out.insert(m_out.end(), record, record + size);
+}
+
+void recordFilterJoin::endParse()
+{
+    bool matched = m_filter.patterns.empty() || (m_parse.state & FILTER_ACCEPT);
+    int64_t values[FILTER_MAX_COLUMNS];
+    parseEnd(m_filter, m_parse, values);
+    parseReset(m_parse);
+    m_carryBytes = 0;
+    m_carryZero = true;
+    if (!matched) return;
+    m_matches++;
+    for (uint32_t c = 0; c < m_filter.columns.size(); c++) {
+        if (m_filter.mode == FILTER_COLUMNS) {
+            for (int b = 0; b < 8; b++) m_out.push_back((uint64_t)values[c] >> (8 * b));
+        } else if (values[c] != FILTER_NULL) {
+            dt_columnStats stats = {values[c], values[c], values[c], 1, 0};
+            addStats(stats, c);
+        }
+    }
+}
+
+void recordFilterJoin::addBlock(const uint8_t* data, const dt_blockInfo& info, const dt_columnStats* column_stats)
+{
+    // The head completes the record of the previous blocks, unless the block has no delimiter at all
+    bool delimited = info.filterHead && (data[info.filterHead - 1] == m_filter.delimiter);
+    const uint8_t* middle = data + info.filterHead;
+    if (m_filter.mode == FILTER_OFFSETS) {
+        // Only the automaton state of the tail comes back, the head goes on from it
+        m_carryState = filterRun(m_filter, m_carryState, data, info.filterHead - delimited);
+        if (delimited) {
+            if (m_carryState & FILTER_ACCEPT) {
+                m_matches++;
+                addOffset(m_carryOffset);
+            }
+            m_carryState = info.filterTailState & (FILTER_ACCEPT | (FILTER_ACCEPT - 1));
+            m_carryOffset = m_blockOffset + info.blockSize - info.filterTail;
+        }
+        for (uint32_t i = 0; i + 4 <= info.filteredSize - info.filterHead; i += 4) {
+            uint32_t offset = middle[i] | (middle[i + 1] << 8) | (middle[i + 2] << 16) | ((uint32_t)middle[i + 3] << 24);
+            m_matches++;
+            addOffset(m_blockOffset + offset);
+        }
+        m_blockOffset += info.blockSize;
+        return;
+    }
+    if (m_filter.mode != FILTER_RECORDS) {
+        addParsedBlock(data, info, column_stats);
+        m_blockOffset += info.blockSize;
+        return;
+    }
+
+    m_carry.insert(m_carry.end(), data, data + info.filterHead);
+    if (delimited) {
+        addRecord(m_carry.data(), m_carry.size());
+        m_carry.clear();
+    }
+
+    // Whole records the kernel let through, only the ones it could not hold back are checked again
+    uint32_t middle_size = info.filteredSize - info.filterHead - info.filterTail;
+    uint32_t start = 0;
+    for (uint32_t i = 0; i < middle_size; i++) {
+        if (middle[i] != m_filter.delimiter) continue;
+        uint32_t size = i + 1 - start;
+        if (size > FILTER_MAX_RECORD) {
+            addRecord(middle + start, size);
+        } else {
+            m_matches++;
+            m_out.insert(m_out.end(), middle + start, middle + i + 1);
+        }
+        start = i + 1;
+    }
+
+    if (info.filterTail) m_carry.assign(data + info.filteredSize - info.filterTail, data + info.filteredSize);
+    m_blockOffset += info.blockSize;
+}
+
+void recordFilterJoin::addParsedBlock(const uint8_t* data, const dt_blockInfo& info, const dt_columnStats* column_stats)
+{
+    bool delimited = info.filterHead && (data[info.filterHead - 1] == m_filter.delimiter);
+    parseFeed(m_filter, m_parse, data, info.filterHead - delimited);
+    m_carryBytes += info.filterHead - delimited;
+    m_carryZero = m_carryZero && allZero(data, info.filterHead - delimited);
+    if (delimited) endParse();
+
+    // The columns of the whole records are packed already, or only in column_stats
+    bool parsed = (info.filterTailState & FILTER_TAIL_PARSED);
+    uint32_t tail_size = parsed ? sizeof(dt_filterParseState) : info.filterTail;
+    const uint8_t* middle = data + info.filterHead;
+    const uint8_t* tail = data + info.filteredSize - tail_size;
+    m_matches += info.filterMatches;
+    if (m_filter.mode == FILTER_COLUMNS) m_out.insert(m_out.end(), middle, tail);
+    for (uint32_t c = 0; c < m_stats.size() && column_stats; c++) addStats(column_stats[c], c);
+
+    // The next blocks go on from the tail, or from how far the kernel parsed it
+    if (parsed) {
+        memcpy(&m_parse, tail, sizeof(dt_filterParseState));
+    } else {
+        parseFeed(m_filter, m_parse, tail, tail_size);
+    }
+    m_carryBytes += info.filterTail;
+    if (info.filterTail && !(info.filterTailState & FILTER_TAIL_ZERO)) m_carryZero = false;
+}
+
+void recordFilterJoin::finish()
+{
+    if (m_filter.mode == FILTER_OFFSETS && (m_carryState & FILTER_ACCEPT)) {
+        m_matches++;
+        addOffset(m_carryOffset);
+    }
+    // Zeros after the last delimiter are the padding of the content to whole pages, not a record
+    if (!allZero(m_carry.data(), m_carry.size())) addRecord(m_carry.data(), m_carry.size());
+    if (m_carryBytes && !m_carryZero) endParse();
+    parseReset(m_parse);
+    m_carryBytes = 0;
+    m_carryZero = true;
+    m_carry.clear();
+    m_carryState = 0;
+
+    if (m_filter.mode != FILTER_AGGREGATE) return;
+    std::string csv = "column,count,sum,min,max\n";
+    for (uint32_t c = 0; c < m_stats.size(); c++) {
+        const dt_columnStats& stats = m_stats[c];
+        csv += std::to_string(m_filter.columns[c]) + "," + std::to_string(stats.count) + "," +
+               std::to_string(stats.sum) + ",";
+        if (stats.count) csv += std::to_string(stats.min) + "," + std::to_string(stats.max);
+        else csv += ",";
+        csv += "\n";
+    }
+    m_out.insert(m_out.end(), csv.begin(), csv.end());
+}
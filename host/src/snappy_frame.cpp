@@ -0,0 +1,102 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "snappy_frame.hpp"
+#include "../../kernel/include/lz4_p2p.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+
+static const uint8_t c_streamId[SNAPPY_STREAM_ID_SIZE] = {SNAPPY_CHUNK_STREAM_ID, 6, 0, 0, 's', 'N', 'a', 'P', 'p', 'Y'};
+
+size_t snappyStreamIdentifier(uint8_t* out)
+{
+    memcpy(out, c_streamId, SNAPPY_STREAM_ID_SIZE);
+    return SNAPPY_STREAM_ID_SIZE;
+}
+
+void snappyReadFrameInfo(const std::string& file, snappyFrameInfo& info)
+{
+    std::ifstream in(file.c_str(), std::ifstream::binary | std::ifstream::ate);
+    uint64_t file_size = in.tellg();
+    in.seekg(0);
+    uint8_t id[SNAPPY_STREAM_ID_SIZE] = {0};
+    in.read((char*)id, sizeof(id));
+    if (in.gcount() < SNAPPY_STREAM_ID_SIZE || memcmp(id, c_streamId, SNAPPY_STREAM_ID_SIZE) != 0) {
+        std::cout << file << " is not a Snappy framing format stream" << std::endl;
+        exit(1);
+    }
+
+    info.contentSize = 0;
+    info.numChunks = 0;
+    uint64_t pos = SNAPPY_STREAM_ID_SIZE;
+    uint32_t last_chunk = SNAPPY_BLOCK_SIZE;
+    uint8_t header[SNAPPY_CHUNK_HEADER_SIZE];
+    while (in.read((char*)header, sizeof(header))) {
+        uint8_t type = header[0];
+        uint32_t length = header[1] | (header[2] << 8) | (header[3] << 16);
+        if (pos + sizeof(header) + length > file_size) {
+            std::cout << file << ": truncated chunk at " << pos << std::endl;
+            exit(1);
+        }
+        // Streams may be concatenated, every one starts with the identifier
+        if (type == SNAPPY_CHUNK_STREAM_ID) {
+            memcpy(id, header, sizeof(header));
+            if (length == SNAPPY_STREAM_ID_SIZE - sizeof(header)) in.read((char*)id + sizeof(header), length);
+            if (memcmp(id, c_streamId, SNAPPY_STREAM_ID_SIZE) != 0) {
+                std::cout << file << ": corrupt stream identifier at " << pos << std::endl;
+                exit(1);
+            }
+        }
+        if (type > SNAPPY_CHUNK_UNCOMPRESSED && type < 0x80) {
+            std::cout << file << ": unskippable chunk type " << (uint32_t)type << " at " << pos << std::endl;
+            exit(1);
+        }
+        if (type <= SNAPPY_CHUNK_UNCOMPRESSED) {
+            if (length < SNAPPY_CHUNK_CRC_SIZE) {
+                std::cout << file << ": corrupt chunk at " << pos << std::endl;
+                exit(1);
+            }
+            // Uncompressed chunks hold the content after the CRC, compressed ones start with it as a varint
+            uint64_t content = length - SNAPPY_CHUNK_CRC_SIZE;
+            if (type == SNAPPY_CHUNK_COMPRESSED) {
+                uint8_t preamble[SNAPPY_CHUNK_CRC_SIZE + 5] = {0};
+                in.read((char*)preamble, std::min<uint32_t>(length, sizeof(preamble)));
+                content = 0;
+                for (uint32_t b = 0; b < 5; b++) {
+                    content |= (uint64_t)(preamble[SNAPPY_CHUNK_CRC_SIZE + b] & 0x7F) << (7 * b);
+                    if (!(preamble[SNAPPY_CHUNK_CRC_SIZE + b] & 0x80)) break;
+                }
+            }
+            if (last_chunk != SNAPPY_BLOCK_SIZE || content == 0 || content > SNAPPY_BLOCK_SIZE) {
+                std::cout << file << ": FPGA backend needs data chunks of " << SNAPPY_BLOCK_SIZE
+                          << " bytes but the last, not the one at " << pos << " or the one before" << std::endl;
+                exit(1);
+            }
+            last_chunk = content;
+            info.contentSize += content;
+            info.numChunks++;
+        }
+        pos += sizeof(header) + length;
+        in.seekg(pos);
+    }
+    if (info.numChunks == 0) {
+        std::cout << file << ": Snappy stream without data chunks" << std::endl;
+        exit(1);
+    }
+}
@@ -0,0 +1,150 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "tracer.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#define TRACE_PID_HOST 0
+#define TRACE_PID_DEVICE 1
+
+static void writeComplete(std::ofstream& out, bool& first, const std::string& name, const char* cat, int pid,
+                          uint32_t tid, double ts_us, double dur_us, uint32_t fid, const std::string& extra_args)
+{
+    out << (first ? "\n" : ",\n");
+    first = false;
+    out << "{\"name\":\"" << name << "\",\"cat\":\"" << cat << "\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << tid
+        << ",\"ts\":" << ts_us << ",\"dur\":" << dur_us << ",\"args\":{\"file\":" << fid << extra_args << "}}";
+}
+
+// Async begin/end pair, these may overlap freely and are drawn on their own rows
+static void writeAsync(std::ofstream& out, bool& first, const std::string& name, int pid, uint32_t id, double ts_us,
+                       double end_us, uint32_t fid)
+{
+    out << (first ? "\n" : ",\n");
+    first = false;
+    out << "{\"name\":\"" << name << "\",\"cat\":\"queue\",\"ph\":\"b\",\"pid\":" << pid << ",\"id\":" << id
+        << ",\"ts\":" << ts_us << ",\"args\":{\"file\":" << fid << "}},\n";
+    out << "{\"name\":\"" << name << "\",\"cat\":\"queue\",\"ph\":\"e\",\"pid\":" << pid << ",\"id\":" << id
+        << ",\"ts\":" << end_us << "}";
+}
+
+static void writeName(std::ofstream& out, bool& first, const char* kind, int pid, uint32_t tid, const std::string& name)
+{
+    out << (first ? "\n" : ",\n");
+    first = false;
+    out << "{\"name\":\"" << kind << "\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << tid
+        << ",\"args\":{\"name\":\"" << name << "\"}}";
+}
+
+Tracer::Tracer() : m_origin(std::chrono::high_resolution_clock::now()), m_anchored(false)
+{
+}
+
+uint32_t Tracer::laneId(const std::string& lane) const
+{
+    return std::find(m_lanes.begin(), m_lanes.end(), lane) - m_lanes.begin();
+}
+
+void Tracer::hostSpan(const std::string& name, uint32_t fid, TimePoint start, TimePoint end)
+{
+    if (!enabled()) return;
+    m_hostSpans.push_back({name, fid, start, end});
+}
+
+void Tracer::deviceEvent(const std::string& name, const std::string& lane, uint32_t fid, const cl::Event& event)
+{
+    if (!enabled()) return;
+    if (std::find(m_lanes.begin(), m_lanes.end(), lane) == m_lanes.end()) m_lanes.push_back(lane);
+    m_deviceEvents.push_back({name, lane, fid, event});
+}
+
+void Tracer::anchor(const cl::Event& event, TimePoint host_time)
+{
+    if (!enabled() || m_anchored) return;
+    m_anchored = true;
+    m_anchorEvent = event;
+    m_anchorHostTime = host_time;
+}
+
+bool Tracer::write() const
+{
+    if (!enabled()) return true;
+
+    std::ofstream out(m_path.c_str(), std::ofstream::trunc);
+    if (!out) {
+        std::cout << "Unable to open trace file " << m_path << std::endl;
+        return false;
+    }
+    out << std::fixed << std::setprecision(3);
+
+    // Device time (ns) of the host trace origin
+    double device_origin_ns = 0;
+    if (m_anchored) {
+        double queued = m_anchorEvent.getProfilingInfo<CL_PROFILING_COMMAND_QUEUED>();
+        double host_ns = std::chrono::duration<double, std::nano>(m_anchorHostTime - m_origin).count();
+        device_origin_ns = queued - host_ns;
+    } else if (!m_deviceEvents.empty()) {
+        device_origin_ns = m_deviceEvents[0].event.getProfilingInfo<CL_PROFILING_COMMAND_QUEUED>();
+    }
+
+    bool first = true;
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    writeName(out, first, "process_name", TRACE_PID_HOST, 0, "host");
+    writeName(out, first, "process_name", TRACE_PID_DEVICE, 0, "device");
+
+    uint32_t num_files = 0;
+    for (const HostSpan& span : m_hostSpans) {
+        num_files = std::max(num_files, span.fid + 1);
+    }
+    for (uint32_t fid = 0; fid < num_files; fid++) {
+        writeName(out, first, "thread_name", TRACE_PID_HOST, fid, "file " + std::to_string(fid));
+    }
+    for (const std::string& lane : m_lanes) {
+        writeName(out, first, "thread_name", TRACE_PID_DEVICE, laneId(lane), lane);
+    }
+
+    for (const HostSpan& span : m_hostSpans) {
+        double ts = std::chrono::duration<double, std::micro>(span.start - m_origin).count();
+        double dur = std::chrono::duration<double, std::micro>(span.end - span.start).count();
+        writeComplete(out, first, span.name, "host", TRACE_PID_HOST, span.fid, ts, dur, span.fid, "");
+    }
+
+    uint32_t async_id = 0;
+    for (const DeviceEvent& dev : m_deviceEvents) {
+        double queued = dev.event.getProfilingInfo<CL_PROFILING_COMMAND_QUEUED>();
+        double submit = dev.event.getProfilingInfo<CL_PROFILING_COMMAND_SUBMIT>();
+        double start = dev.event.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+        double end = dev.event.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+        uint32_t tid = laneId(dev.lane);
+
+        std::ostringstream args;
+        args << std::fixed << std::setprecision(3) << ",\"queued_us\":" << (queued - device_origin_ns) / 1000
+             << ",\"submit_us\":" << (submit - device_origin_ns) / 1000;
+        // Time between enqueue and start, commands queued behind a running one overlap it
+        if (start > queued) {
+            writeAsync(out, first, dev.name + " queued", TRACE_PID_DEVICE, async_id++, (queued - device_origin_ns) / 1000,
+                       (start - device_origin_ns) / 1000, dev.fid);
+        }
+        writeComplete(out, first, dev.name, "device", TRACE_PID_DEVICE, tid, (start - device_origin_ns) / 1000,
+                      (end - start) / 1000, dev.fid, args.str());
+    }
+    out << "\n]}\n";
+    return true;
+}
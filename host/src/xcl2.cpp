@@ -21,16 +21,22 @@
 #include <unistd.h>
 
 namespace xcl {
+// Returns no devices, instead of exiting, when there is no platform or card so callers can fall back
 std::vector<cl::Device> get_devices(const std::string& vendor_name) {
     size_t i;
     cl_int err;
+    std::vector<cl::Device> devices;
     std::vector<cl::Platform> platforms;
-    OCL_CHECK(err, err = cl::Platform::get(&platforms));
+    err = cl::Platform::get(&platforms);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error: No OpenCL platform, error code is: " << err << std::endl;
+        return devices;
+    }
     cl::Platform platform;
     for (i = 0; i < platforms.size(); i++) {
         platform = platforms[i];
-        OCL_CHECK(err, std::string platformName = platform.getInfo<CL_PLATFORM_NAME>(&err));
-        if (platformName == vendor_name) {
+        std::string platformName = platform.getInfo<CL_PLATFORM_NAME>(&err);
+        if (err == CL_SUCCESS && platformName == vendor_name) {
 #ifdef VERBOSE
             std::cout << "Found Platform" << std::endl;
             std::cout << "Platform Name: " << platformName.c_str() << std::endl;
@@ -40,11 +46,14 @@ std::vector<cl::Device> get_devices(const std::string& vendor_name) {
     }
     if (i == platforms.size()) {
         std::cout << "Error: Failed to find Xilinx platform" << std::endl;
-        exit(EXIT_FAILURE);
+        return devices;
     }
     // Getting ACCELERATOR Devices and selecting 1st such device
-    std::vector<cl::Device> devices;
-    OCL_CHECK(err, err = platform.getDevices(CL_DEVICE_TYPE_ACCELERATOR, &devices));
+    err = platform.getDevices(CL_DEVICE_TYPE_ACCELERATOR, &devices);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error: No " << vendor_name << " device, error code is: " << err << std::endl;
+        devices.clear();
+    }
     return devices;
 }
 
@@ -0,0 +1,697 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "xxhash_simd.hpp"
+#include <algorithm>
+#include <atomic>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HASH_X86 1
+#define HASH_TARGET_AVX2 __attribute__((target("avx2")))
+#define HASH_TARGET_AVX512 __attribute__((target("avx512f")))
+// GCC's AVX-512 intrinsics pass an undefined vector as the unused merge source
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#define PRIME32_1 0x9E3779B1U
+#define PRIME32_2 0x85EBCA77U
+#define PRIME32_3 0xC2B2AE3DU
+#define PRIME32_4 0x27D4EB2FU
+#define PRIME32_5 0x165667B1U
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+#define PRIME_MX1 0x165667919E3779F9ULL
+#define PRIME_MX2 0x9FB21C651E98DF25ULL
+
+// XXH32 consumes 16 byte stripes, four 32-bit lanes
+#define XXH32_STRIPE 16
+// XXH3 consumes 64 byte stripes into eight 64-bit accumulators
+#define XXH3_STRIPE 64
+#define XXH3_SECRET_SIZE 192
+#define XXH3_SECRET_MIN 136
+#define XXH3_MIDSIZE_MAX 240
+#define XXH3_STRIPES_PER_BLOCK ((XXH3_SECRET_SIZE - XXH3_STRIPE) / 8)
+
+// Default secret of XXH3
+alignas(64) static const uint8_t kSecret[XXH3_SECRET_SIZE] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+static inline uint32_t readLE32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t readLE64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t rotl32(uint32_t x, int r) {
+    return (x << r) | (x >> (32 - r));
+}
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint32_t swap32(uint32_t x) {
+    return __builtin_bswap32(x);
+}
+
+static inline uint64_t swap64(uint64_t x) {
+    return __builtin_bswap64(x);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Instruction set
+//////////////////////////////////////////////////////////////////////////////
+
+hashIsa hashDetectIsa() {
+#ifdef HASH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return HASH_ISA_AVX512;
+    if (__builtin_cpu_supports("avx2")) return HASH_ISA_AVX2;
+    if (__builtin_cpu_supports("sse2")) return HASH_ISA_SSE2;
+#endif
+    return HASH_ISA_SCALAR;
+}
+
+static hashIsa initialIsa() {
+    hashIsa isa = hashDetectIsa();
+    const char* env = getenv("SMARTSSD_HASH_ISA");
+    if (env == NULL) return isa;
+    for (int i = HASH_ISA_SCALAR; i <= HASH_ISA_AVX512; i++) {
+        if (std::string(env) == hashIsaName((hashIsa)i)) return std::min(isa, (hashIsa)i);
+    }
+    return isa;
+}
+
+static std::atomic<int> g_isa(-1);
+
+hashIsa hashActiveIsa() {
+    int isa = g_isa.load(std::memory_order_relaxed);
+    if (isa < 0) {
+        isa = initialIsa();
+        g_isa.store(isa, std::memory_order_relaxed);
+    }
+    return (hashIsa)isa;
+}
+
+hashIsa hashSelectIsa(hashIsa isa) {
+    isa = std::min(isa, hashDetectIsa());
+    g_isa.store(isa, std::memory_order_relaxed);
+    return isa;
+}
+
+const char* hashIsaName(hashIsa isa) {
+    switch (isa) {
+        case HASH_ISA_SSE2:
+            return "sse2";
+        case HASH_ISA_AVX2:
+            return "avx2";
+        case HASH_ISA_AVX512:
+            return "avx512";
+        default:
+            return "scalar";
+    }
+}
+
+uint32_t hashLanes() {
+    switch (hashActiveIsa()) {
+        case HASH_ISA_SSE2:
+            return 4;
+        case HASH_ISA_AVX2:
+            return 8;
+        case HASH_ISA_AVX512:
+            return 16;
+        default:
+            return 1;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// XXH32, several buffers side by side
+//////////////////////////////////////////////////////////////////////////////
+
+static inline uint32_t xxh32Round(uint32_t acc, uint32_t input) {
+    acc += input * PRIME32_2;
+    acc = rotl32(acc, 13);
+    return acc * PRIME32_1;
+}
+
+static inline void xxh32Init(uint32_t v[4], uint32_t seed) {
+    v[0] = seed + PRIME32_1 + PRIME32_2;
+    v[1] = seed + PRIME32_2;
+    v[2] = seed;
+    v[3] = seed - PRIME32_1;
+}
+
+static void xxh32Stripes(uint32_t v[4], const uint8_t* p, size_t stripes) {
+    for (size_t s = 0; s < stripes; s++, p += XXH32_STRIPE) {
+        v[0] = xxh32Round(v[0], readLE32(p));
+        v[1] = xxh32Round(v[1], readLE32(p + 4));
+        v[2] = xxh32Round(v[2], readLE32(p + 8));
+        v[3] = xxh32Round(v[3], readLE32(p + 12));
+    }
+}
+
+// Lanes v after every whole stripe of data, then the tail and the avalanche
+static uint32_t xxh32Finish(const uint32_t v[4], const uint8_t* data, size_t size, uint32_t seed) {
+    uint32_t h;
+    size_t idx = (size / XXH32_STRIPE) * XXH32_STRIPE;
+    if (size >= XXH32_STRIPE) {
+        h = rotl32(v[0], 1) + rotl32(v[1], 7) + rotl32(v[2], 12) + rotl32(v[3], 18);
+    } else {
+        h = seed + PRIME32_5;
+    }
+    h += (uint32_t)size;
+    for (; idx + 4 <= size; idx += 4) {
+        h += readLE32(data + idx) * PRIME32_3;
+        h = rotl32(h, 17) * PRIME32_4;
+    }
+    for (; idx < size; idx++) {
+        h += data[idx] * PRIME32_5;
+        h = rotl32(h, 11) * PRIME32_1;
+    }
+    h ^= h >> 15;
+    h *= PRIME32_2;
+    h ^= h >> 13;
+    h *= PRIME32_3;
+    h ^= h >> 16;
+    return h;
+}
+
+// Runs stripes [0, stripes) of n buffers, lane j of the vectors holding buffer j
+typedef void (*xxh32LanesFn)(const uint8_t* const* data, size_t stripes, uint32_t seed, uint32_t v[][4]);
+
+#ifdef HASH_X86
+static inline __m128i mullo32Sse2(__m128i a, __m128i b) {
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static inline __m128i roundSse2(__m128i acc, __m128i input) {
+    acc = _mm_add_epi32(acc, mullo32Sse2(input, _mm_set1_epi32(PRIME32_2)));
+    acc = _mm_or_si128(_mm_slli_epi32(acc, 13), _mm_srli_epi32(acc, 19));
+    return mullo32Sse2(acc, _mm_set1_epi32(PRIME32_1));
+}
+
+static void xxh32LanesSse2(const uint8_t* const* data, size_t stripes, uint32_t seed, uint32_t v[][4]) {
+    __m128i acc[4];
+    for (int k = 0; k < 4; k++) {
+        uint32_t init[4];
+        xxh32Init(init, seed);
+        acc[k] = _mm_set1_epi32(init[k]);
+    }
+    for (size_t s = 0; s < stripes; s++) {
+        size_t off = s * XXH32_STRIPE;
+        // Row j is stripe s of buffer j, transposed so that word k of every buffer shares a vector
+        __m128i r0 = _mm_loadu_si128((const __m128i*)(data[0] + off));
+        __m128i r1 = _mm_loadu_si128((const __m128i*)(data[1] + off));
+        __m128i r2 = _mm_loadu_si128((const __m128i*)(data[2] + off));
+        __m128i r3 = _mm_loadu_si128((const __m128i*)(data[3] + off));
+        __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+        __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+        __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+        __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+        acc[0] = roundSse2(acc[0], _mm_unpacklo_epi64(t0, t1));
+        acc[1] = roundSse2(acc[1], _mm_unpackhi_epi64(t0, t1));
+        acc[2] = roundSse2(acc[2], _mm_unpacklo_epi64(t2, t3));
+        acc[3] = roundSse2(acc[3], _mm_unpackhi_epi64(t2, t3));
+    }
+    for (int k = 0; k < 4; k++) {
+        uint32_t lanes[4];
+        _mm_storeu_si128((__m128i*)lanes, acc[k]);
+        for (int j = 0; j < 4; j++) v[j][k] = lanes[j];
+    }
+}
+
+HASH_TARGET_AVX2 static inline __m256i roundAvx2(__m256i acc, __m256i input) {
+    acc = _mm256_add_epi32(acc, _mm256_mullo_epi32(input, _mm256_set1_epi32(PRIME32_2)));
+    acc = _mm256_or_si256(_mm256_slli_epi32(acc, 13), _mm256_srli_epi32(acc, 19));
+    return _mm256_mullo_epi32(acc, _mm256_set1_epi32(PRIME32_1));
+}
+
+HASH_TARGET_AVX2 static void xxh32LanesAvx2(const uint8_t* const* data, size_t stripes, uint32_t seed,
+                                            uint32_t v[][4]) {
+    __m256i acc[4];
+    uint32_t init[4];
+    xxh32Init(init, seed);
+    for (int k = 0; k < 4; k++) acc[k] = _mm256_set1_epi32(init[k]);
+    for (size_t s = 0; s < stripes; s++) {
+        size_t off = s * XXH32_STRIPE;
+        // 128-bit half h of row j holds buffer j + 4h, the 4x4 transpose runs in each half
+        __m256i r[4];
+        for (int j = 0; j < 4; j++) {
+            r[j] = _mm256_inserti128_si256(_mm256_zextsi128_si256(_mm_loadu_si128((const __m128i*)(data[j] + off))),
+                                           _mm_loadu_si128((const __m128i*)(data[j + 4] + off)), 1);
+        }
+        __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+        __m256i t1 = _mm256_unpacklo_epi32(r[2], r[3]);
+        __m256i t2 = _mm256_unpackhi_epi32(r[0], r[1]);
+        __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+        acc[0] = roundAvx2(acc[0], _mm256_unpacklo_epi64(t0, t1));
+        acc[1] = roundAvx2(acc[1], _mm256_unpackhi_epi64(t0, t1));
+        acc[2] = roundAvx2(acc[2], _mm256_unpacklo_epi64(t2, t3));
+        acc[3] = roundAvx2(acc[3], _mm256_unpackhi_epi64(t2, t3));
+    }
+    for (int k = 0; k < 4; k++) {
+        uint32_t lanes[8];
+        _mm256_storeu_si256((__m256i*)lanes, acc[k]);
+        for (int j = 0; j < 8; j++) v[j][k] = lanes[j];
+    }
+}
+
+HASH_TARGET_AVX512 static inline __m512i roundAvx512(__m512i acc, __m512i input) {
+    acc = _mm512_add_epi32(acc, _mm512_mullo_epi32(input, _mm512_set1_epi32(PRIME32_2)));
+    acc = _mm512_rol_epi32(acc, 13);
+    return _mm512_mullo_epi32(acc, _mm512_set1_epi32(PRIME32_1));
+}
+
+HASH_TARGET_AVX512 static void xxh32LanesAvx512(const uint8_t* const* data, size_t stripes, uint32_t seed,
+                                                uint32_t v[][4]) {
+    __m512i acc[4];
+    uint32_t init[4];
+    xxh32Init(init, seed);
+    for (int k = 0; k < 4; k++) acc[k] = _mm512_set1_epi32(init[k]);
+    for (size_t s = 0; s < stripes; s++) {
+        size_t off = s * XXH32_STRIPE;
+        // 128-bit quarter q of row j holds buffer j + 4q
+        __m512i r[4];
+        for (int j = 0; j < 4; j++) {
+            __m512i row = _mm512_zextsi128_si512(_mm_loadu_si128((const __m128i*)(data[j] + off)));
+            row = _mm512_inserti32x4(row, _mm_loadu_si128((const __m128i*)(data[j + 4] + off)), 1);
+            row = _mm512_inserti32x4(row, _mm_loadu_si128((const __m128i*)(data[j + 8] + off)), 2);
+            r[j] = _mm512_inserti32x4(row, _mm_loadu_si128((const __m128i*)(data[j + 12] + off)), 3);
+        }
+        __m512i t0 = _mm512_unpacklo_epi32(r[0], r[1]);
+        __m512i t1 = _mm512_unpacklo_epi32(r[2], r[3]);
+        __m512i t2 = _mm512_unpackhi_epi32(r[0], r[1]);
+        __m512i t3 = _mm512_unpackhi_epi32(r[2], r[3]);
+        acc[0] = roundAvx512(acc[0], _mm512_unpacklo_epi64(t0, t1));
+        acc[1] = roundAvx512(acc[1], _mm512_unpackhi_epi64(t0, t1));
+        acc[2] = roundAvx512(acc[2], _mm512_unpacklo_epi64(t2, t3));
+        acc[3] = roundAvx512(acc[3], _mm512_unpackhi_epi64(t2, t3));
+    }
+    for (int k = 0; k < 4; k++) {
+        uint32_t lanes[16];
+        _mm512_storeu_si512((void*)lanes, acc[k]);
+        for (int j = 0; j < 16; j++) v[j][k] = lanes[j];
+    }
+}
+#endif
+
+void xxh32Blocks(const uint8_t* const* data, const size_t* sizes, size_t count, uint32_t seed, uint32_t* hashes) {
+    xxh32LanesFn lanesFn = NULL;
+    size_t width = hashLanes();
+#ifdef HASH_X86
+    switch (hashActiveIsa()) {
+        case HASH_ISA_SSE2:
+            lanesFn = xxh32LanesSse2;
+            break;
+        case HASH_ISA_AVX2:
+            lanesFn = xxh32LanesAvx2;
+            break;
+        case HASH_ISA_AVX512:
+            lanesFn = xxh32LanesAvx512;
+            break;
+        default:
+            break;
+    }
+#endif
+
+    // Buffers of similar size go side by side, the lanes only run the stripes all of them have
+    std::vector<size_t> order(count);
+    for (size_t i = 0; i < count; i++) order[i] = i;
+    if (lanesFn) std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sizes[a] < sizes[b]; });
+
+    size_t idx = 0;
+    if (lanesFn) {
+        const uint8_t* group[HASH_MAX_LANES];
+        uint32_t v[HASH_MAX_LANES][4];
+        for (; idx + width <= count; idx += width) {
+            // The shortest buffer of the group bounds the stripes run side by side
+            size_t stripes = sizes[order[idx]] / XXH32_STRIPE;
+            for (size_t j = 0; j < width; j++) {
+                group[j] = data[order[idx + j]];
+                xxh32Init(v[j], seed);
+            }
+            if (stripes) lanesFn(group, stripes, seed, v);
+            for (size_t j = 0; j < width; j++) {
+                size_t b = order[idx + j];
+                xxh32Stripes(v[j], data[b] + stripes * XXH32_STRIPE, sizes[b] / XXH32_STRIPE - stripes);
+                hashes[b] = xxh32Finish(v[j], data[b], sizes[b], seed);
+            }
+        }
+    }
+    for (; idx < count; idx++) {
+        size_t b = order[idx];
+        uint32_t lanes[4];
+        xxh32Init(lanes, seed);
+        xxh32Stripes(lanes, data[b], sizes[b] / XXH32_STRIPE);
+        hashes[b] = xxh32Finish(lanes, data[b], sizes[b], seed);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// XXH3
+//////////////////////////////////////////////////////////////////////////////
+
+static inline hash128 mult64to128(uint64_t lhs, uint64_t rhs) {
+    unsigned __int128 product = (unsigned __int128)lhs * rhs;
+    hash128 r = {(uint64_t)product, (uint64_t)(product >> 64)};
+    return r;
+}
+
+static inline uint64_t mul128Fold64(uint64_t lhs, uint64_t rhs) {
+    hash128 product = mult64to128(lhs, rhs);
+    return product.low64 ^ product.high64;
+}
+
+static inline uint64_t xxh64Avalanche(uint64_t h) {
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+static inline uint64_t xxh3Avalanche(uint64_t h) {
+    h ^= h >> 37;
+    h *= PRIME_MX1;
+    h ^= h >> 32;
+    return h;
+}
+
+static inline uint64_t xxh3Rrmxmx(uint64_t h, uint64_t len) {
+    h ^= rotl64(h, 49) ^ rotl64(h, 24);
+    h *= PRIME_MX2;
+    h ^= (h >> 35) + len;
+    h *= PRIME_MX2;
+    return h ^ (h >> 28);
+}
+
+static inline uint64_t xxh3Mix16B(const uint8_t* p, const uint8_t* secret) {
+    return mul128Fold64(readLE64(p) ^ readLE64(secret), readLE64(p + 8) ^ readLE64(secret + 8));
+}
+
+static inline void xxh3Mix32B(hash128& acc, const uint8_t* p1, const uint8_t* p2, const uint8_t* secret) {
+    acc.low64 += xxh3Mix16B(p1, secret);
+    acc.low64 ^= readLE64(p2) + readLE64(p2 + 8);
+    acc.high64 += xxh3Mix16B(p2, secret + 16);
+    acc.high64 ^= readLE64(p1) + readLE64(p1 + 8);
+}
+
+// Eight 64-bit accumulators over nbStripes stripes, then the scramble of one block
+typedef void (*xxh3AccumulateFn)(uint64_t* acc, const uint8_t* p, const uint8_t* secret, size_t stripes);
+typedef void (*xxh3ScrambleFn)(uint64_t* acc, const uint8_t* secret);
+
+static void xxh3AccumulateScalar(uint64_t* acc, const uint8_t* p, const uint8_t* secret, size_t stripes) {
+    for (size_t s = 0; s < stripes; s++, p += XXH3_STRIPE, secret += 8) {
+        for (int i = 0; i < 8; i++) {
+            uint64_t data = readLE64(p + i * 8);
+            uint64_t key = data ^ readLE64(secret + i * 8);
+            acc[i ^ 1] += data;
+            acc[i] += (key & 0xFFFFFFFF) * (key >> 32);
+        }
+    }
+}
+
+static void xxh3ScrambleScalar(uint64_t* acc, const uint8_t* secret) {
+    for (int i = 0; i < 8; i++) {
+        uint64_t a = acc[i];
+        a ^= a >> 47;
+        a ^= readLE64(secret + i * 8);
+        acc[i] = a * PRIME32_1;
+    }
+}
+
+#ifdef HASH_X86
+static void xxh3AccumulateSse2(uint64_t* acc, const uint8_t* p, const uint8_t* secret, size_t stripes) {
+    __m128i* xacc = (__m128i*)acc;
+    for (size_t s = 0; s < stripes; s++, p += XXH3_STRIPE, secret += 8) {
+        for (int i = 0; i < 4; i++) {
+            __m128i data = _mm_loadu_si128((const __m128i*)p + i);
+            __m128i key = _mm_xor_si128(data, _mm_loadu_si128((const __m128i*)secret + i));
+            __m128i product = _mm_mul_epu32(key, _mm_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1)));
+            __m128i swap = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+            xacc[i] = _mm_add_epi64(product, _mm_add_epi64(xacc[i], swap));
+        }
+    }
+}
+
+static void xxh3ScrambleSse2(uint64_t* acc, const uint8_t* secret) {
+    __m128i* xacc = (__m128i*)acc;
+    const __m128i prime = _mm_set1_epi32(PRIME32_1);
+    for (int i = 0; i < 4; i++) {
+        __m128i a = _mm_xor_si128(xacc[i], _mm_srli_epi64(xacc[i], 47));
+        a = _mm_xor_si128(a, _mm_loadu_si128((const __m128i*)secret + i));
+        __m128i lo = _mm_mul_epu32(a, prime);
+        __m128i hi = _mm_mul_epu32(_mm_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+        xacc[i] = _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+    }
+}
+
+HASH_TARGET_AVX2 static void xxh3AccumulateAvx2(uint64_t* acc, const uint8_t* p, const uint8_t* secret,
+                                                size_t stripes) {
+    __m256i* xacc = (__m256i*)acc;
+    __m256i a0 = xacc[0], a1 = xacc[1];
+    for (size_t s = 0; s < stripes; s++, p += XXH3_STRIPE, secret += 8) {
+        __m256i data0 = _mm256_loadu_si256((const __m256i*)p);
+        __m256i data1 = _mm256_loadu_si256((const __m256i*)p + 1);
+        __m256i key0 = _mm256_xor_si256(data0, _mm256_loadu_si256((const __m256i*)secret));
+        __m256i key1 = _mm256_xor_si256(data1, _mm256_loadu_si256((const __m256i*)secret + 1));
+        a0 = _mm256_add_epi64(a0, _mm256_shuffle_epi32(data0, _MM_SHUFFLE(1, 0, 3, 2)));
+        a1 = _mm256_add_epi64(a1, _mm256_shuffle_epi32(data1, _MM_SHUFFLE(1, 0, 3, 2)));
+        a0 = _mm256_add_epi64(a0, _mm256_mul_epu32(key0, _mm256_shuffle_epi32(key0, _MM_SHUFFLE(0, 3, 0, 1))));
+        a1 = _mm256_add_epi64(a1, _mm256_mul_epu32(key1, _mm256_shuffle_epi32(key1, _MM_SHUFFLE(0, 3, 0, 1))));
+    }
+    xacc[0] = a0;
+    xacc[1] = a1;
+}
+
+HASH_TARGET_AVX2 static void xxh3ScrambleAvx2(uint64_t* acc, const uint8_t* secret) {
+    __m256i* xacc = (__m256i*)acc;
+    const __m256i prime = _mm256_set1_epi32(PRIME32_1);
+    for (int i = 0; i < 2; i++) {
+        __m256i a = _mm256_xor_si256(xacc[i], _mm256_srli_epi64(xacc[i], 47));
+        a = _mm256_xor_si256(a, _mm256_loadu_si256((const __m256i*)secret + i));
+        __m256i lo = _mm256_mul_epu32(a, prime);
+        __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), prime);
+        xacc[i] = _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+    }
+}
+
+HASH_TARGET_AVX512 static void xxh3AccumulateAvx512(uint64_t* acc, const uint8_t* p, const uint8_t* secret,
+                                                    size_t stripes) {
+    __m512i a = _mm512_load_si512((const void*)acc);
+    for (size_t s = 0; s < stripes; s++, p += XXH3_STRIPE, secret += 8) {
+        __m512i data = _mm512_loadu_si512((const void*)p);
+        __m512i key = _mm512_xor_si512(data, _mm512_loadu_si512((const void*)secret));
+        a = _mm512_add_epi64(a, _mm512_shuffle_epi32(data, (_MM_PERM_ENUM)_MM_SHUFFLE(1, 0, 3, 2)));
+        a = _mm512_add_epi64(a, _mm512_mul_epu32(key, _mm512_srli_epi64(key, 32)));
+    }
+    _mm512_store_si512((void*)acc, a);
+}
+
+HASH_TARGET_AVX512 static void xxh3ScrambleAvx512(uint64_t* acc, const uint8_t* secret) {
+    __m512i a = _mm512_load_si512((const void*)acc);
+    const __m512i prime = _mm512_set1_epi32(PRIME32_1);
+    a = _mm512_xor_si512(a, _mm512_srli_epi64(a, 47));
+    a = _mm512_xor_si512(a, _mm512_loadu_si512((const void*)secret));
+    __m512i lo = _mm512_mul_epu32(a, prime);
+    __m512i hi = _mm512_mul_epu32(_mm512_srli_epi64(a, 32), prime);
+    _mm512_store_si512((void*)acc, _mm512_add_epi64(lo, _mm512_slli_epi64(hi, 32)));
+}
+#endif
+
+static uint64_t xxh3MergeAccs(const uint64_t* acc, const uint8_t* secret, uint64_t start) {
+    uint64_t result = start;
+    for (int i = 0; i < 4; i++) {
+        result += mul128Fold64(acc[2 * i] ^ readLE64(secret + 16 * i), acc[2 * i + 1] ^ readLE64(secret + 16 * i + 8));
+    }
+    return xxh3Avalanche(result);
+}
+
+// Inputs over XXH3_MIDSIZE_MAX bytes, blocks of 16 stripes scrambled in between
+static void xxh3HashLong(uint64_t* acc, const uint8_t* p, size_t len) {
+    xxh3AccumulateFn accumulate = xxh3AccumulateScalar;
+    xxh3ScrambleFn scramble = xxh3ScrambleScalar;
+#ifdef HASH_X86
+    switch (hashActiveIsa()) {
+        case HASH_ISA_SSE2:
+            accumulate = xxh3AccumulateSse2;
+            scramble = xxh3ScrambleSse2;
+            break;
+        case HASH_ISA_AVX2:
+            accumulate = xxh3AccumulateAvx2;
+            scramble = xxh3ScrambleAvx2;
+            break;
+        case HASH_ISA_AVX512:
+            accumulate = xxh3AccumulateAvx512;
+            scramble = xxh3ScrambleAvx512;
+            break;
+        default:
+            break;
+    }
+#endif
+    const uint64_t init[8] = {PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3, PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1};
+    memcpy(acc, init, sizeof(init));
+
+    size_t block_len = XXH3_STRIPE * XXH3_STRIPES_PER_BLOCK;
+    size_t blocks = (len - 1) / block_len;
+    for (size_t n = 0; n < blocks; n++) {
+        accumulate(acc, p + n * block_len, kSecret, XXH3_STRIPES_PER_BLOCK);
+        scramble(acc, kSecret + XXH3_SECRET_SIZE - XXH3_STRIPE);
+    }
+    size_t stripes = ((len - 1) - block_len * blocks) / XXH3_STRIPE;
+    accumulate(acc, p + blocks * block_len, kSecret, stripes);
+    // The last stripe ends on the last byte, with a secret offset apart from the blocks
+    accumulate(acc, p + len - XXH3_STRIPE, kSecret + XXH3_SECRET_SIZE - XXH3_STRIPE - 7, 1);
+}
+
+uint64_t xxh3_64(const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    if (len == 0) return xxh64Avalanche(readLE64(kSecret + 56) ^ readLE64(kSecret + 64));
+    if (len <= 3) {
+        uint32_t combined = ((uint32_t)p[0] << 16) | ((uint32_t)p[len >> 1] << 24) | p[len - 1] | ((uint32_t)len << 8);
+        return xxh64Avalanche(combined ^ (uint64_t)(readLE32(kSecret) ^ readLE32(kSecret + 4)));
+    }
+    if (len <= 8) {
+        uint64_t input = readLE32(p + len - 4) + ((uint64_t)readLE32(p) << 32);
+        return xxh3Rrmxmx(input ^ (readLE64(kSecret + 8) ^ readLE64(kSecret + 16)), len);
+    }
+    if (len <= 16) {
+        uint64_t lo = readLE64(p) ^ (readLE64(kSecret + 24) ^ readLE64(kSecret + 32));
+        uint64_t hi = readLE64(p + len - 8) ^ (readLE64(kSecret + 40) ^ readLE64(kSecret + 48));
+        return xxh3Avalanche(len + swap64(lo) + hi + mul128Fold64(lo, hi));
+    }
+    if (len <= 128) {
+        uint64_t acc = len * PRIME64_1;
+        for (size_t i = 0; i <= (len - 1) / 32; i++) {
+            acc += xxh3Mix16B(p + 16 * i, kSecret + 32 * i);
+            acc += xxh3Mix16B(p + len - 16 * (i + 1), kSecret + 32 * i + 16);
+        }
+        return xxh3Avalanche(acc);
+    }
+    if (len <= XXH3_MIDSIZE_MAX) {
+        uint64_t acc = len * PRIME64_1;
+        for (size_t i = 0; i < 8; i++) acc += xxh3Mix16B(p + 16 * i, kSecret + 16 * i);
+        uint64_t acc_end = xxh3Mix16B(p + len - 16, kSecret + XXH3_SECRET_MIN - 17);
+        acc = xxh3Avalanche(acc);
+        for (size_t i = 8; i < len / 16; i++) acc_end += xxh3Mix16B(p + 16 * i, kSecret + 16 * (i - 8) + 3);
+        return xxh3Avalanche(acc + acc_end);
+    }
+    alignas(64) uint64_t acc[8];
+    xxh3HashLong(acc, p, len);
+    return xxh3MergeAccs(acc, kSecret + 11, len * PRIME64_1);
+}
+
+// Mixes the two halves of the 17 to 240 byte paths
+static hash128 xxh3Finish128(const hash128& acc, size_t len) {
+    hash128 h;
+    h.low64 = xxh3Avalanche(acc.low64 + acc.high64);
+    h.high64 = 0 - xxh3Avalanche(acc.low64 * PRIME64_1 + acc.high64 * PRIME64_4 + len * PRIME64_2);
+    return h;
+}
+
+hash128 xxh3_128(const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    hash128 h;
+    if (len == 0) {
+        h.low64 = xxh64Avalanche(readLE64(kSecret + 64) ^ readLE64(kSecret + 72));
+        h.high64 = xxh64Avalanche(readLE64(kSecret + 80) ^ readLE64(kSecret + 88));
+        return h;
+    }
+    if (len <= 3) {
+        uint32_t combinedl = ((uint32_t)p[0] << 16) | ((uint32_t)p[len >> 1] << 24) | p[len - 1] | ((uint32_t)len << 8);
+        uint32_t combinedh = rotl32(swap32(combinedl), 13);
+        h.low64 = xxh64Avalanche(combinedl ^ (uint64_t)(readLE32(kSecret) ^ readLE32(kSecret + 4)));
+        h.high64 = xxh64Avalanche(combinedh ^ (uint64_t)(readLE32(kSecret + 8) ^ readLE32(kSecret + 12)));
+        return h;
+    }
+    if (len <= 8) {
+        uint64_t input = readLE32(p) + ((uint64_t)readLE32(p + len - 4) << 32);
+        hash128 m = mult64to128(input ^ (readLE64(kSecret + 16) ^ readLE64(kSecret + 24)), PRIME64_1 + (len << 2));
+        m.high64 += m.low64 << 1;
+        m.low64 ^= m.high64 >> 3;
+        m.low64 ^= m.low64 >> 35;
+        m.low64 *= PRIME_MX2;
+        m.low64 ^= m.low64 >> 28;
+        m.high64 = xxh3Avalanche(m.high64);
+        return m;
+    }
+    if (len <= 16) {
+        uint64_t lo = readLE64(p);
+        uint64_t hi = readLE64(p + len - 8);
+        hash128 m = mult64to128(lo ^ hi ^ (readLE64(kSecret + 32) ^ readLE64(kSecret + 40)), PRIME64_1);
+        m.low64 += (uint64_t)(len - 1) << 54;
+        hi ^= readLE64(kSecret + 48) ^ readLE64(kSecret + 56);
+        m.high64 += hi + (uint64_t)(uint32_t)hi * (PRIME32_2 - 1);
+        m.low64 ^= swap64(m.high64);
+        h = mult64to128(m.low64, PRIME64_2);
+        h.high64 += m.high64 * PRIME64_2;
+        h.low64 = xxh3Avalanche(h.low64);
+        h.high64 = xxh3Avalanche(h.high64);
+        return h;
+    }
+    if (len <= 128) {
+        hash128 acc = {len * PRIME64_1, 0};
+        for (size_t i = (len - 1) / 32 + 1; i-- > 0;) {
+            xxh3Mix32B(acc, p + 16 * i, p + len - 16 * (i + 1), kSecret + 32 * i);
+        }
+        return xxh3Finish128(acc, len);
+    }
+    if (len <= XXH3_MIDSIZE_MAX) {
+        hash128 acc = {len * PRIME64_1, 0};
+        for (size_t i = 32; i < 160; i += 32) xxh3Mix32B(acc, p + i - 32, p + i - 16, kSecret + i - 32);
+        acc.low64 = xxh3Avalanche(acc.low64);
+        acc.high64 = xxh3Avalanche(acc.high64);
+        for (size_t i = 160; i <= len; i += 32) xxh3Mix32B(acc, p + i - 32, p + i - 16, kSecret + 3 + i - 160);
+        xxh3Mix32B(acc, p + len - 16, p + len - 32, kSecret + XXH3_SECRET_MIN - 17 - 16);
+        return xxh3Finish128(acc, len);
+    }
+    alignas(64) uint64_t acc[8];
+    xxh3HashLong(acc, p, len);
+    h.low64 = xxh3MergeAccs(acc, kSecret + 11, len * PRIME64_1);
+    h.high64 = xxh3MergeAccs(acc, kSecret + XXH3_SECRET_SIZE - sizeof(acc) - 11, ~(len * PRIME64_2));
+    return h;
+}
@@ -0,0 +1,150 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "../include/zone_map.hpp"
+#include <algorithm>
+#include <string.h>
+
+bool zoneMapValue(const dt_zoneConfig& config, const uint8_t* record, size_t size, int64_t& value)
+{
+    zoneParse parse;
+    zoneParseReset(parse);
+    for (size_t i = 0; i < size; i++) zoneParseByte(config, parse, record[i]);
+    return zoneParseValue(parse, value);
+}
+
+void zoneMapBlock(const dt_zoneConfig& config, const uint8_t* data, uint32_t size, dt_zoneMap& zone)
+{
+    zoneParse parse;
+    zoneParseReset(parse);
+    zoneMapReset(zone, size);
+    bool delimited = false;
+    uint32_t last = 0;
+    for (uint32_t i = 0; i < size; i++) {
+        if (data[i] != config.delimiter) {
+            zoneParseByte(config, parse, data[i]);
+            continue;
+        }
+        if (delimited) {
+            zoneMapAdd(zone, parse);
+        } else {
+            zone.head = i + 1;
+        }
+        delimited = true;
+        last = i + 1;
+        zoneParseReset(parse);
+    }
+    zone.tail = delimited ? size - last : 0;
+}
+
+// Counts the record that starts at content[start] in entry
+static void addRecord(const dt_zoneConfig& config, const uint8_t* content, uint64_t size, uint64_t start, lz4ZoneEntry& entry)
+{
+    const uint8_t* end = (const uint8_t*)memchr(content + start, config.delimiter, size - start);
+    uint64_t length = (end ? end - content : size) - start;
+    int64_t value;
+    entry.records++;
+    if (!zoneMapValue(config, content + start, length, value)) return;
+    if (entry.values == 0 || value < entry.min) entry.min = value;
+    if (entry.values == 0 || value > entry.max) entry.max = value;
+    entry.values++;
+}
+
+void zoneMapJoin(const dt_zoneConfig& config,
+                 const uint8_t* content,
+                 uint64_t size,
+                 uint32_t block_size,
+                 const dt_zoneMap* zones,
+                 std::vector<lz4ZoneEntry>& entries)
+{
+    uint32_t num_blocks = size ? (size - 1) / block_size + 1 : 0;
+    entries.resize(num_blocks);
+    for (uint32_t b = 0; b < num_blocks; b++) {
+        uint64_t start = (uint64_t)b * block_size;
+        uint32_t bsize = std::min<uint64_t>(block_size, size - start);
+        const dt_zoneMap& zone = zones[b];
+        lz4ZoneEntry& entry = entries[b];
+        entry.min = zone.min;
+        entry.max = zone.max;
+        entry.records = zone.records;
+        entry.values = zone.values;
+
+        // The record before the first delimiter starts here when the previous block ends one, the one after the
+        // last delimiter always does
+        bool head_starts = (b == 0) || (content[start - 1] == config.delimiter);
+        entry.first = head_starts ? 0 : zone.head;
+        if (head_starts) addRecord(config, content, size, start, entry);
+        if (zone.tail) addRecord(config, content, size, start + bsize - zone.tail, entry);
+    }
+}
+
+bool zoneMapQuery(const std::string& file,
+                  int64_t min,
+                  int64_t max,
+                  const zoneMapReader& read,
+                  std::vector<uint8_t>& out,
+                  zoneMapQueryStats& stats)
+{
+    lz4FrameInfo info;
+    lz4ReadFrameHeader(file, info);
+    dt_zoneConfig config;
+    std::vector<lz4ZoneEntry> zones;
+    if (!(info.flags & FLG_CONTENT_SIZE) || !lz4ReadZoneMap(file, config, zones)) return false;
+    uint64_t block_size = info.blockSize;
+    uint32_t num_blocks = info.contentSize ? (info.contentSize - 1) / block_size + 1 : 0;
+    if (zones.size() != num_blocks) return false;
+
+    stats.blocks = num_blocks;
+    stats.blocksRead = 0;
+    stats.records = 0;
+    auto overlaps = [&](const lz4ZoneEntry& zone) { return zone.values && zone.min <= max && zone.max >= min; };
+    // First block no run has read yet
+    uint32_t unread = 0;
+    for (uint32_t b = 0; b < num_blocks; b++) {
+        if (!overlaps(zones[b])) continue;
+        uint32_t last = b;
+        while (last + 1 < num_blocks && overlaps(zones[last + 1])) last++;
+
+        // From the first record of the run up to the first record after it, which may be blocks later
+        uint64_t begin = b * block_size + zones[b].first;
+        uint64_t end = info.contentSize;
+        for (uint32_t k = last + 1; k < num_blocks; k++) {
+            if (zones[k].first < std::min(block_size, info.contentSize - k * block_size)) {
+                end = k * block_size + zones[k].first;
+                break;
+            }
+        }
+        std::vector<uint8_t> data;
+        if (!read(begin, end - begin, data) || data.size() != end - begin) return false;
+        uint32_t end_block = (end - 1) / block_size;
+        stats.blocksRead += end_block + 1 - std::max<uint32_t>(b, unread);
+        unread = end_block + 1;
+
+        for (size_t pos = 0; pos < data.size();) {
+            const uint8_t* delim = (const uint8_t*)memchr(&data[pos], config.delimiter, data.size() - pos);
+            size_t length = (delim ? delim - &data[pos] : data.size() - pos);
+            int64_t value;
+            if (zoneMapValue(config, &data[pos], length, value) && value >= min && value <= max) {
+                size_t record_end = pos + length + (delim ? 1 : 0);
+                out.insert(out.end(), data.begin() + pos, data.begin() + record_end);
+                stats.records++;
+            }
+            pos += length + 1;
+        }
+        b = last;
+    }
+    return true;
+}
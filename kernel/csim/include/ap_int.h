@@ -0,0 +1,340 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_CSIM_AP_INT_H_
+#define _XFCOMPRESSION_CSIM_AP_INT_H_
+
+/**
+ * @file ap_int.h
+ * @brief Host-only stand-in for the Vitis HLS arbitrary precision unsigned type.
+ *
+ * Only the subset of ap_uint used by the kernels in this tree is provided:
+ * construction from integers, bit/range select (as lvalue and rvalue, with
+ * run-time bounds), range concatenation, shifts, bitwise operators and
+ * comparison. Arithmetic falls back to the 64-bit host integer through the
+ * implicit conversion, which matches HLS behaviour for the widths used here.
+ * This header is only picked up when Vitis is not installed.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+namespace csim {
+
+const int c_maxDynWidth = 2048;
+
+// Word level helpers shared by ap_uint and the range/concat proxies
+inline uint64_t getBits(const uint64_t* w, int hi, int lo) {
+    uint64_t val = 0;
+    int width = hi - lo + 1;
+    for (int b = 0; b < width && b < 64; b++) {
+        int pos = lo + b;
+        if ((w[pos >> 6] >> (pos & 63)) & 1) val |= (1ULL << b);
+    }
+    return val;
+}
+
+inline void setBit(uint64_t* w, int pos, bool v) {
+    if (v)
+        w[pos >> 6] |= (1ULL << (pos & 63));
+    else
+        w[pos >> 6] &= ~(1ULL << (pos & 63));
+}
+
+inline bool getBit(const uint64_t* w, int pos) {
+    return (w[pos >> 6] >> (pos & 63)) & 1;
+}
+
+// Run-time sized bit vector, result of a range concatenation
+struct dynBits {
+    uint64_t w[c_maxDynWidth / 64];
+    int width;
+    dynBits() : width(0) { memset(w, 0, sizeof(w)); }
+    operator uint64_t() const { return w[0]; }
+};
+
+} // namespace csim
+
+template <int W>
+class ap_uint;
+
+/**
+ * @brief Proxy returned by ap_uint::range() and ap_uint::operator[].
+ */
+class ap_range_ref {
+   public:
+    ap_range_ref(uint64_t* words, int totalWidth, int hi, int lo)
+        : m_words(words), m_total(totalWidth), m_hi(hi), m_lo(lo) {}
+
+    int length() const { return m_hi - m_lo + 1; }
+    bool bit(int i) const { return csim::getBit(m_words, m_lo + i); }
+
+    operator uint64_t() const { return csim::getBits(m_words, m_hi, m_lo); }
+
+    ap_range_ref& operator=(uint64_t v) {
+        for (int b = 0; b < length(); b++) csim::setBit(m_words, m_lo + b, (b < 64) ? ((v >> b) & 1) : 0);
+        return *this;
+    }
+    ap_range_ref& operator=(int v) { return assignSigned(v); }
+    ap_range_ref& operator=(long v) { return assignSigned(v); }
+    ap_range_ref& operator=(long long v) { return assignSigned(v); }
+    ap_range_ref& operator=(unsigned int v) { return *this = (uint64_t)v; }
+    ap_range_ref& operator=(unsigned short v) { return *this = (uint64_t)v; }
+    ap_range_ref& operator=(unsigned char v) { return *this = (uint64_t)v; }
+    ap_range_ref& operator=(bool v) { return *this = (uint64_t)v; }
+    ap_range_ref& operator=(const ap_range_ref& other) {
+        // copy through a temporary as source and destination may overlap
+        csim::dynBits tmp;
+        for (int b = 0; b < other.length(); b++) csim::setBit(tmp.w, b, other.bit(b));
+        for (int b = 0; b < length(); b++) csim::setBit(m_words, m_lo + b, (b < other.length()) ? csim::getBit(tmp.w, b) : 0);
+        return *this;
+    }
+    ap_range_ref& operator=(const csim::dynBits& other) {
+        for (int b = 0; b < length(); b++)
+            csim::setBit(m_words, m_lo + b, (b < other.width) ? csim::getBit(other.w, b) : 0);
+        return *this;
+    }
+    template <int W2>
+    ap_range_ref& operator=(const ap_uint<W2>& other);
+
+   private:
+    template <class T>
+    ap_range_ref& assignSigned(T v) {
+        for (int b = 0; b < length(); b++) csim::setBit(m_words, m_lo + b, (b < 64) ? ((v >> b) & 1) : (v < 0));
+        return *this;
+    }
+
+    uint64_t* m_words;
+    int m_total;
+    int m_hi;
+    int m_lo;
+};
+
+inline csim::dynBits operator,(const ap_range_ref& hi, const ap_range_ref& lo) {
+    csim::dynBits res;
+    res.width = hi.length() + lo.length();
+    for (int b = 0; b < lo.length(); b++) csim::setBit(res.w, b, lo.bit(b));
+    for (int b = 0; b < hi.length(); b++) csim::setBit(res.w, lo.length() + b, hi.bit(b));
+    return res;
+}
+
+/**
+ * @brief Arbitrary width unsigned integer.
+ *
+ * @tparam W width in bits
+ */
+template <int W>
+class ap_uint {
+   public:
+    static const int c_words = (W + 63) / 64;
+
+    ap_uint() { clear(); }
+    ap_uint(const ap_uint& other) { memcpy(m_words, other.m_words, sizeof(m_words)); }
+    template <int W2>
+    ap_uint(const ap_uint<W2>& other) {
+        clear();
+        for (int b = 0; b < W && b < W2; b++) csim::setBit(m_words, b, other.bit(b));
+    }
+    ap_uint(const ap_range_ref& ref) {
+        clear();
+        for (int b = 0; b < W && b < ref.length(); b++) csim::setBit(m_words, b, ref.bit(b));
+    }
+    ap_uint(const csim::dynBits& bits) {
+        clear();
+        for (int b = 0; b < W && b < bits.width; b++) csim::setBit(m_words, b, csim::getBit(bits.w, b));
+    }
+    template <typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+    ap_uint(T v) {
+        fromInt(v);
+    }
+
+    ap_uint& operator=(const ap_uint& other) {
+        memcpy(m_words, other.m_words, sizeof(m_words));
+        return *this;
+    }
+
+    // Conversion to the widest host integer, truncating wider values
+    operator uint64_t() const { return m_words[0]; }
+
+    uint64_t to_uint64() const { return m_words[0]; }
+    uint32_t to_uint() const { return (uint32_t)m_words[0]; }
+    int to_int() const { return (int)m_words[0]; }
+    int length() const { return W; }
+    bool bit(int i) const { return csim::getBit(m_words, i); }
+    bool and_reduce() const {
+        for (int b = 0; b < W; b++)
+            if (!bit(b)) return false;
+        return true;
+    }
+    bool or_reduce() const {
+        for (int b = 0; b < W; b++)
+            if (bit(b)) return true;
+        return false;
+    }
+    bool xor_reduce() const {
+        bool r = false;
+        for (int b = 0; b < W; b++) r ^= bit(b);
+        return r;
+    }
+
+    ap_range_ref range(int hi, int lo) { return ap_range_ref(m_words, W, hi, lo); }
+    const ap_range_ref range(int hi, int lo) const {
+        return ap_range_ref(const_cast<uint64_t*>(m_words), W, hi, lo);
+    }
+    ap_range_ref range() { return range(W - 1, 0); }
+    ap_range_ref operator[](int i) { return range(i, i); }
+    bool operator[](int i) const { return bit(i); }
+    bool test(int i) const { return bit(i); }
+
+    // Shifts are exact for any width
+    ap_uint operator<<(int s) const {
+        ap_uint res;
+        for (int b = W - 1; b >= s && b >= 0; b--) csim::setBit(res.m_words, b, bit(b - s));
+        return res;
+    }
+    ap_uint operator>>(int s) const {
+        ap_uint res;
+        for (int b = 0; b + s < W; b++) csim::setBit(res.m_words, b, bit(b + s));
+        return res;
+    }
+    ap_uint& operator<<=(int s) { return *this = *this << s; }
+    ap_uint& operator>>=(int s) { return *this = *this >> s; }
+
+    // Bitwise operators are exact for any width
+    template <int W2>
+    ap_uint operator&(const ap_uint<W2>& o) const {
+        return bitwise(ap_uint(o), 0);
+    }
+    template <int W2>
+    ap_uint operator|(const ap_uint<W2>& o) const {
+        return bitwise(ap_uint(o), 1);
+    }
+    template <int W2>
+    ap_uint operator^(const ap_uint<W2>& o) const {
+        return bitwise(ap_uint(o), 2);
+    }
+    template <typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+    ap_uint operator&(T o) const {
+        return bitwise(ap_uint(o), 0);
+    }
+    template <typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+    ap_uint operator|(T o) const {
+        return bitwise(ap_uint(o), 1);
+    }
+    template <typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+    ap_uint operator^(T o) const {
+        return bitwise(ap_uint(o), 2);
+    }
+    ap_uint operator~() const {
+        ap_uint res;
+        for (int i = 0; i < c_words; i++) res.m_words[i] = ~m_words[i];
+        res.mask();
+        return res;
+    }
+    ap_uint& operator&=(const ap_uint& o) { return *this = *this & o; }
+    ap_uint& operator|=(const ap_uint& o) { return *this = *this | o; }
+    ap_uint& operator^=(const ap_uint& o) { return *this = *this ^ o; }
+
+    // Exact comparison between ap_uint values of any width
+    template <int W2>
+    bool operator==(const ap_uint<W2>& o) const {
+        const int c_max = (W > W2) ? W : W2;
+        for (int b = 0; b < c_max; b++) {
+            bool l = (b < W) ? bit(b) : 0;
+            bool r = (b < W2) ? o.bit(b) : 0;
+            if (l != r) return false;
+        }
+        return true;
+    }
+    template <int W2>
+    bool operator!=(const ap_uint<W2>& o) const {
+        return !(*this == o);
+    }
+
+    // Arithmetic compound assignment (modulo 2^W)
+    ap_uint& operator+=(uint64_t v) { return addWord(v, false); }
+    ap_uint& operator-=(uint64_t v) { return addWord(v, true); }
+    ap_uint& operator*=(uint64_t v) { return *this = (uint64_t)(*this) * v; }
+    ap_uint& operator++() { return addWord(1, false); }
+    ap_uint& operator--() { return addWord(1, true); }
+    ap_uint operator++(int) {
+        ap_uint tmp(*this);
+        addWord(1, false);
+        return tmp;
+    }
+    ap_uint operator--(int) {
+        ap_uint tmp(*this);
+        addWord(1, true);
+        return tmp;
+    }
+
+   private:
+    template <int W2>
+    friend class ap_uint;
+    friend class ap_range_ref;
+
+    void clear() { memset(m_words, 0, sizeof(m_words)); }
+    void mask() {
+        if (W % 64) m_words[c_words - 1] &= (~0ULL >> (64 - (W % 64)));
+    }
+    template <typename T>
+    void fromInt(T v) {
+        clear();
+        m_words[0] = (uint64_t)v;
+        // sign extend negative values over the full width, as HLS does
+        if (std::is_signed<T>::value && v < 0)
+            for (int i = 1; i < c_words; i++) m_words[i] = ~0ULL;
+        mask();
+    }
+    ap_uint bitwise(const ap_uint& o, int op) const {
+        ap_uint res;
+        for (int i = 0; i < c_words; i++) {
+            if (op == 0)
+                res.m_words[i] = m_words[i] & o.m_words[i];
+            else if (op == 1)
+                res.m_words[i] = m_words[i] | o.m_words[i];
+            else
+                res.m_words[i] = m_words[i] ^ o.m_words[i];
+        }
+        return res;
+    }
+    ap_uint& addWord(uint64_t v, bool sub) {
+        uint64_t carry = v;
+        for (int i = 0; i < c_words && carry; i++) {
+            uint64_t prev = m_words[i];
+            if (sub) {
+                m_words[i] = prev - carry;
+                carry = (prev < carry) ? 1 : 0;
+            } else {
+                m_words[i] = prev + carry;
+                carry = (m_words[i] < prev) ? 1 : 0;
+            }
+        }
+        mask();
+        return *this;
+    }
+
+    uint64_t m_words[c_words];
+};
+
+template <int W2>
+ap_range_ref& ap_range_ref::operator=(const ap_uint<W2>& other) {
+    for (int b = 0; b < length(); b++) csim::setBit(m_words, m_lo + b, (b < W2) ? other.bit(b) : 0);
+    return *this;
+}
+
+#endif // _XFCOMPRESSION_CSIM_AP_INT_H_
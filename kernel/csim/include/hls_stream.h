@@ -0,0 +1,154 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_CSIM_HLS_STREAM_H_
+#define _XFCOMPRESSION_CSIM_HLS_STREAM_H_
+
+/**
+ * @file hls_stream.h
+ * @brief Host-only stand-in for the Vitis HLS stream.
+ *
+ * Streams are unbounded queues, as in Vitis C simulation, so dataflow
+ * regions execute their processes one after the other. Each stream counts
+ * the transactions it carried; the csim testbench uses those counts to
+ * estimate the initiation-interval bound of a dataflow region. The m_axi
+ * ports are plain pointers here, so the data movers report the beats they
+ * moved themselves, and their writer ends the dataflow call: a kernel that
+ * loops over batches of blocks takes the sum of its calls.
+ * This header is only picked up when Vitis is not installed.
+ */
+
+// Tells the testbench that csim::streamStats is available
+#define CSIM_STREAM_STATS 1
+
+#include <deque>
+#include <string>
+#include <stdio.h>
+#include <stdint.h>
+
+namespace csim {
+
+/**
+ * @brief Global transaction bookkeeping shared by every stream.
+ */
+struct streamStats {
+    uint64_t maxWrites;     // largest per-stream write count in the current dataflow call
+    uint64_t moverCycles;   // largest data mover cycle count in the current dataflow call
+    uint64_t doneCycles;    // cycles of the dataflow calls that have ended since last reset
+    uint64_t call;          // dataflow calls ended so far, streams restart their count on a new one
+    uint64_t emptyReads;    // reads issued on an empty stream (always a kernel bug)
+    static streamStats& get() {
+        static streamStats s = {0, 0, 0, 0, 0};
+        return s;
+    }
+    static void reset() {
+        get().maxWrites = 0;
+        get().moverCycles = 0;
+        get().doneCycles = 0;
+        get().call++;
+        get().emptyReads = 0;
+    }
+    // A data mover of the current dataflow call took cycles, burst beats included
+    static void mover(uint64_t cycles) {
+        if (cycles > get().moverCycles) get().moverCycles = cycles;
+    }
+    // The writer of the current dataflow call is done, the next call starts after it
+    static void endCall() {
+        streamStats& s = get();
+        s.doneCycles += (s.maxWrites > s.moverCycles) ? s.maxWrites : s.moverCycles;
+        s.maxWrites = 0;
+        s.moverCycles = 0;
+        s.call++;
+    }
+    // Cycles since last reset, but no fewer than the words the busiest m_axi
+    // port moves, one beat per cycle
+    static uint64_t cycles(uint64_t gmem_words) {
+        const streamStats& s = get();
+        uint64_t current = (s.maxWrites > s.moverCycles) ? s.maxWrites : s.moverCycles;
+        return (s.doneCycles + current > gmem_words) ? s.doneCycles + current : gmem_words;
+    }
+};
+
+} // namespace csim
+
+namespace hls {
+
+template <typename T>
+class stream {
+   public:
+    stream() : m_name("stream"), m_writes(0), m_callWrites(0), m_call(0) {}
+    explicit stream(const char* name) : m_name(name), m_writes(0), m_callWrites(0), m_call(0) {}
+
+    bool empty() const { return m_data.empty(); }
+    // Unbounded in C simulation, like Vitis csim
+    bool full() const { return false; }
+    size_t size() const { return m_data.size(); }
+
+    void write(const T& v) {
+        m_data.push_back(v);
+        m_writes++;
+        csim::streamStats& s = csim::streamStats::get();
+        if (m_call != s.call) {
+            m_call = s.call;
+            m_callWrites = 0;
+        }
+        m_callWrites++;
+        if (m_callWrites > s.maxWrites) s.maxWrites = m_callWrites;
+    }
+    T read() {
+        if (m_data.empty()) {
+            csim::streamStats::get().emptyReads++;
+            if (csim::streamStats::get().emptyReads == 1)
+                fprintf(stderr, "WARNING: hls::stream '%s' is read while empty\n", m_name.c_str());
+            return T();
+        }
+        T v = m_data.front();
+        m_data.pop_front();
+        return v;
+    }
+    void read(T& v) { v = read(); }
+    bool read_nb(T& v) {
+        if (m_data.empty()) return false;
+        v = read();
+        return true;
+    }
+    bool write_nb(const T& v) {
+        write(v);
+        return true;
+    }
+
+    stream& operator<<(const T& v) {
+        write(v);
+        return *this;
+    }
+    stream& operator>>(T& v) {
+        v = read();
+        return *this;
+    }
+
+    uint64_t writes() const { return m_writes; }
+
+   private:
+    std::string m_name;
+    std::deque<T> m_data;
+    uint64_t m_writes;
+    uint64_t m_callWrites; // in dataflow call m_call
+    uint64_t m_call;
+};
+
+} // namespace hls
+
+#endif // _XFCOMPRESSION_CSIM_HLS_STREAM_H_
@@ -0,0 +1,219 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/**
+ * @file csim_tb.cpp
+ * @brief C-simulation testbench driver.
+ *
+ * usage: csim_tb [--size <bytes>] [--block_kb <kb>] [--cu <n>] [--mhz <f>] [--corpus <kind>]... [file]...
+ *
+ * Runs every built-in corpus (or the ones given with --corpus) and every
+ * file through the kernels and the templates, and exits non-zero if any
+ * round trip is not bit-exact.
+ */
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <lz4frame.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include "corpus.hpp"
+#include "csim_tb.hpp"
+#include "lz4_p2p.hpp"
+
+#ifndef CSIM_KERNEL_MHZ
+#define CSIM_KERNEL_MHZ 250
+#endif
+
+struct csimOptions {
+    uint64_t size;
+    uint32_t blockKb;
+    uint32_t numCu;
+    uint32_t mhz;
+    std::vector<std::string> corpora;
+    std::vector<std::string> files;
+};
+
+static void usage(const char* prog) {
+    std::cout << "usage: " << prog
+              << " [--size <bytes>] [--block_kb <kb>] [--cu <n>] [--mhz <f>] [--corpus <kind>]... [file]..." << std::endl;
+    std::cout << "corpus kinds:";
+    for (const std::string& kind : corpusKinds()) std::cout << " " << kind;
+    std::cout << std::endl;
+}
+
+static bool readFile(const std::string& path, std::vector<uint8_t>& data) {
+    std::ifstream in(path.c_str(), std::ifstream::binary | std::ifstream::ate);
+    if (!in) return false;
+    data.resize(in.tellg());
+    in.seekg(0);
+    in.read((char*)data.data(), data.size());
+    return (bool)in;
+}
+
+// Frame as liblz4 writes it with the options of Compress::create_header()
+static std::vector<uint8_t> referenceFrame(const std::vector<uint8_t>& data, uint32_t block_kb) {
+    LZ4F_preferences_t prefs;
+    memset(&prefs, 0, sizeof(prefs));
+    prefs.frameInfo.blockSizeID = (block_kb == 4096) ? LZ4F_max4MB : (block_kb == 1024) ? LZ4F_max1MB
+                                                                   : (block_kb == 256) ? LZ4F_max256KB : LZ4F_max64KB;
+    prefs.frameInfo.blockMode = LZ4F_blockIndependent;
+    prefs.frameInfo.contentSize = data.size();
+    prefs.frameInfo.blockChecksumFlag = LZ4F_blockChecksumEnabled;
+    prefs.frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+    std::vector<uint8_t> frame(LZ4F_compressFrameBound(data.size(), &prefs));
+    frame.resize(LZ4F_compressFrame(frame.data(), frame.size(), data.data(), data.size(), &prefs));
+    return frame;
+}
+
+// gzip member (with a file name, as gzip writes it) or zlib stream as zlib writes it
+static std::vector<uint8_t> referenceDeflate(const std::vector<uint8_t>& data, int level, int strategy, bool zlib) {
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    deflateInit2(&strm, level, Z_DEFLATED, zlib ? MAX_WBITS : MAX_WBITS + 16, 8, strategy);
+    gz_header header;
+    memset(&header, 0, sizeof(header));
+    header.name = (Bytef*)"corpus";
+    if (!zlib) deflateSetHeader(&strm, &header);
+    std::vector<uint8_t> stream(deflateBound(&strm, data.size()) + 64);
+    strm.next_in = (Bytef*)data.data();
+    strm.avail_in = data.size();
+    strm.next_out = stream.data();
+    strm.avail_out = stream.size();
+    deflate(&strm, Z_FINISH);
+    stream.resize(strm.total_out);
+    deflateEnd(&strm);
+    return stream;
+}
+
+static void printResult(const std::string& corpus, const csimResult& r, uint32_t mhz) {
+    std::cout << std::left << std::setw(16) << corpus << std::setw(40) << r.name << std::right << std::setw(10)
+              << r.bytes << std::setw(10) << r.output;
+    if (r.cycles) {
+        double cpb = (double)r.cycles / r.bytes;
+        std::cout << std::fixed << std::setprecision(3) << std::setw(12) << cpb << std::setprecision(0)
+                  << std::setw(12) << mhz / cpb;
+    } else {
+        std::cout << std::setw(12) << "n/a" << std::setw(12) << "n/a";
+    }
+    std::cout << "  " << (r.match ? "MATCH" : "\x1B[31mMISMATCH\033[0m") << std::endl;
+}
+
+int main(int argc, char** argv) {
+    csimOptions options = {1 << 20, 64, 2, CSIM_KERNEL_MHZ, {}, {}};
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = (i + 1 < argc);
+        if (arg == "--size" && has_value) {
+            options.size = parseSize(argv[++i]);
+        } else if (arg == "--block_kb" && has_value) {
+            options.blockKb = atoi(argv[++i]);
+        } else if (arg == "--cu" && has_value) {
+            options.numCu = atoi(argv[++i]);
+        } else if (arg == "--mhz" && has_value) {
+            options.mhz = atoi(argv[++i]);
+        } else if (arg == "--corpus" && has_value) {
+            options.corpora.push_back(argv[++i]);
+        } else if (arg[0] == '-') {
+            usage(argv[0]);
+            return -1;
+        } else {
+            options.files.push_back(arg);
+        }
+    }
+    if (options.corpora.empty() && options.files.empty()) options.corpora = corpusKinds();
+    if (options.blockKb != 64 && options.blockKb != 256 && options.blockKb != 1024 && options.blockKb != 4096) {
+        std::cout << "Block size should be 64, 256, 1024 or 4096 KB, got " << options.blockKb << std::endl;
+        return -1;
+    }
+    if (options.numCu < 1 || options.numCu > 8) {
+        std::cout << "Compute units should be within 1 ~ 8, got " << options.numCu << std::endl;
+        return -1;
+    }
+
+    std::vector<std::pair<std::string, std::vector<uint8_t> > > inputs;
+    for (const std::string& kind : options.corpora) {
+        if (!isCorpusKind(kind)) {
+            usage(argv[0]);
+            return -1;
+        }
+        std::vector<uint8_t> data;
+        generateCorpus(kind, 1, data, options.size);
+        inputs.push_back(std::make_pair(kind, data));
+    }
+    for (const std::string& file : options.files) {
+        std::vector<uint8_t> data;
+        if (!readFile(file, data) || data.empty()) {
+            std::cout << "Unable to read " << file << std::endl;
+            return -1;
+        }
+        inputs.push_back(std::make_pair(file.substr(file.find_last_of('/') + 1), data));
+    }
+
+    std::cout << std::left << std::setw(16) << "corpus" << std::setw(40) << "unit" << std::right << std::setw(10)
+              << "bytes" << std::setw(10) << "output" << std::setw(12) << "cycles/B" << std::setw(12) << "est MB/s"
+              << std::endl;
+    uint32_t mismatches = 0;
+    for (auto& input : inputs) {
+        // The host hands the kernels whole 4K pages
+        std::vector<uint8_t>& data = input.second;
+        data.resize(((data.size() - 1) / 4096 + 1) * 4096, 0);
+
+        std::vector<csimResult> results;
+        std::vector<uint8_t> frame;
+        csimKernelCompress(data, options.blockKb, frame, results);
+        csimKernelZoneMap(data, options.blockKb, ZONE_FIELD_DELIMITED, results);
+        csimKernelZoneMap(data, options.blockKb, ZONE_FIELD_FIXED, results);
+        csimKernelBatch(data, options.blockKb, results);
+        csimKernelDict(data, options.blockKb, results);
+        std::vector<uint8_t> gzip, zlib;
+        csimKernelGzip(data, options.blockKb, false, gzip, results);
+        csimKernelGzip(data, options.blockKb, true, zlib, results);
+        csimKernelGzipDecompress("kernel gzip", gzip, data, false, results);
+        csimKernelGzipDecompress("kernel zlib", zlib, data, true, results);
+        csimKernelGzipDecompress("zlib -6 gzip", referenceDeflate(data, 6, Z_DEFAULT_STRATEGY, false), data, false,
+                                 results);
+        csimKernelGzipDecompress("zlib -9 zlib", referenceDeflate(data, 9, Z_DEFAULT_STRATEGY, true), data, true,
+                                 results);
+        csimKernelGzipDecompress("zlib fixed gzip", referenceDeflate(data, 1, Z_FIXED, false), data, false, results);
+        csimKernelGzipDecompress("zlib stored gzip", referenceDeflate(data, 0, Z_DEFAULT_STRATEGY, false), data, false,
+                                 results);
+        std::vector<uint8_t> snappy;
+        csimKernelSnappy(data, snappy, results);
+        csimKernelSnappyDecompress("kernel snappy", snappy, data, options.numCu, results);
+        csimKernelDecompress("kernel frame", frame, data, options.blockKb, options.numCu, results);
+        csimKernelDecompress("liblz4 frame", referenceFrame(data, options.blockKb), data, options.blockKb,
+                             options.numCu, results);
+        for (uint32_t mode = FILTER_RECORDS; mode <= FILTER_AGGREGATE; mode++) {
+            csimKernelFilter("kernel frame", frame, data, options.blockKb, options.numCu, mode, results);
+        }
+        // Every record, to count them past the zeros after the last one
+        csimKernelFilter("kernel frame", frame, data, options.blockKb, options.numCu, FILTER_AGGREGATE, results, true);
+        // The templates work on one history window
+        csimTemplateCompress(data, 64 * 1024, results);
+        csimTemplateDecompress(data, 64 * 1024, results);
+
+        for (const csimResult& r : results) {
+            printResult(input.first, r, options.mhz);
+            if (!r.match) mismatches++;
+        }
+    }
+
+    if (mismatches) std::cout << mismatches << " round trips did not match" << std::endl;
+    return mismatches ? 1 : 0;
+}
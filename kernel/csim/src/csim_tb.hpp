@@ -0,0 +1,121 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_CSIM_TB_HPP_
+#define _XFCOMPRESSION_CSIM_TB_HPP_
+
+/**
+ * @file csim_tb.hpp
+ * @brief C-simulation testbench of the LZ4 and GZIP kernels and templates.
+ *
+ * Every check is a bit-exact round trip against liblz4 (zlib for the GZIP
+ * kernels, a Snappy decoder of the testbench for FRAME_SNAPPY) and reports an
+ * estimated cycle count. The estimate is the largest number of transactions
+ * any single stream carried during the call: with every dataflow process at
+ * II = 1 that stream is the bottleneck of the region. The template
+ * decompress check adds the cycles lzDecompress stalls on low offsets. No
+ * estimate is reported for kernels without streams (xilLz4Unpacker) or with
+ * the Vitis headers, which do not count transactions. The xilLz4Compress
+ * estimate leaves out its entropy pass, which has no streams either: about
+ * 64 x (PARALLEL_BLOCK + 65) + 512 cycles per batch of blocks, its
+ * content checksum, which runs next to the engines at 8 bytes per cycle,
+ * and its zone map pass, next to them as well at about
+ * (64 + PARALLEL_BLOCK) / 64 cycles per byte of a block.
+ * The xilGzipCompress estimate likewise leaves out deflateTreegen between
+ * its LZ77 and Huffman passes.
+ */
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct csimResult {
+    std::string name;
+    uint64_t bytes;  // uncompressed bytes
+    uint64_t output; // bytes produced by the unit under test
+    uint64_t cycles; // 0 when no estimate is available
+    bool match;
+};
+
+// Stream transaction bookkeeping of the stand-in headers; bytes is what the
+// busiest GMEM port of the unit moved, which bounds the cycles from below
+void csimResetCycles();
+uint64_t csimCycles(uint64_t bytes);
+
+// xilLz4Compress + xilLz4Packer, checked with LZ4F_decompress
+void csimKernelCompress(const std::vector<uint8_t>& data, uint32_t block_kb, std::vector<uint8_t>& frame,
+                        std::vector<csimResult>& results);
+// xilLz4Compress with FRAME_ZONE_MAP on the lines of the data, the field split on '=' (ZONE_FIELD_DELIMITED) or
+// at a fixed offset (ZONE_FIELD_FIXED); the zone map of every block is checked against zoneMapBlock and the
+// zoneMapJoin entries against every line parsed on its own
+void csimKernelZoneMap(const std::vector<uint8_t>& data, uint32_t block_kb, uint32_t layout,
+                       std::vector<csimResult>& results);
+// The same kernels on the data cut into files of growing size, one invocation and one frame per file
+void csimKernelBatch(const std::vector<uint8_t>& data, uint32_t block_kb, std::vector<csimResult>& results);
+// The same kernels on 4K files compressed against a preset dictionary taken from the head of the data
+void csimKernelDict(const std::vector<uint8_t>& data, uint32_t block_kb, std::vector<csimResult>& results);
+// xilGzipCompress + xilGzipPacker on the data as one file and cut into files of growing size, one gzip member
+// (or zlib stream) per file checked with inflate; stream is the member (or zlib stream) of the whole input
+void csimKernelGzip(const std::vector<uint8_t>& data,
+                    uint32_t block_kb,
+                    bool zlib,
+                    std::vector<uint8_t>& stream,
+                    std::vector<csimResult>& results);
+// xilGzipDecompress on one gzip member or zlib stream, checked against the original data, then with half the
+// output buffer (the size must still be reported) and with a corrupted byte (must be reported as bad)
+void csimKernelGzipDecompress(const std::string& name,
+                              const std::vector<uint8_t>& stream,
+                              const std::vector<uint8_t>& data,
+                              bool zlib,
+                              std::vector<csimResult>& results);
+// xilLz4Compress + xilLz4Packer with FRAME_SNAPPY on the data as one file and cut into files of growing size, one
+// Snappy framing format stream per file checked with the decoder of the testbench (CRC32C of every chunk included);
+// stream is the one of the whole input
+void csimKernelSnappy(const std::vector<uint8_t>& data, std::vector<uint8_t>& stream, std::vector<csimResult>& results);
+// xilLz4Unpacker + xilLz4P2PDecompress on one Snappy stream, checked against the original data, then with the CRC
+// of its first chunk corrupted (must be reported as a block checksum mismatch)
+void csimKernelSnappyDecompress(const std::string& name,
+                                const std::vector<uint8_t>& stream,
+                                const std::vector<uint8_t>& data,
+                                uint32_t num_cu,
+                                std::vector<csimResult>& results);
+// xilLz4Unpacker + xilLz4P2PDecompress over num_cu compute units, checked against the original data, with the
+// preset dictionary of the frame if it has one
+void csimKernelDecompress(const std::string& name,
+                          const std::vector<uint8_t>& frame,
+                          const std::vector<uint8_t>& data,
+                          uint32_t block_kb,
+                          uint32_t num_cu,
+                          std::vector<csimResult>& results,
+                          const std::vector<uint8_t>& dict = std::vector<uint8_t>());
+// xilLz4Unpacker + xilLz4P2PDecompress with a record filter on the lines of the data in mode (FILTER_*), writing
+// the matching lines, their offsets, their columns or the column aggregates; the blocks are joined with
+// recordFilterJoin and checked against every line matched and projected on its own
+void csimKernelFilter(const std::string& name,
+                      const std::vector<uint8_t>& frame,
+                      const std::vector<uint8_t>& data,
+                      uint32_t block_kb,
+                      uint32_t num_cu,
+                      uint32_t mode,
+                      std::vector<csimResult>& results,
+                      bool match_all = false);
+
+// One block through lzCompress, lzBestMatchFilter, lzBooster and lz4Compress, checked with LZ4_decompress_safe
+void csimTemplateCompress(const std::vector<uint8_t>& data, uint32_t block_size, std::vector<csimResult>& results);
+// LZ4_compress_default blocks through lz4Decompress and lzDecompress
+void csimTemplateDecompress(const std::vector<uint8_t>& data, uint32_t block_size, std::vector<csimResult>& results);
+
+#endif // _XFCOMPRESSION_CSIM_TB_HPP_
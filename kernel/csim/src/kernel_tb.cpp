@@ -0,0 +1,946 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "csim_tb.hpp"
+#include "hls_stream.h"
+#include <ap_int.h>
+#include <lz4.h>
+#include <lz4frame.h>
+#include <string.h>
+#include <algorithm>
+#include "lz4_p2p.hpp"
+#include "lz4_packer.hpp"
+#include "xxhash.h"
+#include "../../../host/include/record_filter.hpp"
+#include "../../../host/include/zone_map.hpp"
+#include <zlib.h>
+
+typedef ap_uint<GMEM_DATAWIDTH> uintMemWidth_t;
+
+#define GMEM_BYTES (GMEM_DATAWIDTH / 8)
+#define FRAME_HEADER_SIZE 15
+// With the dictionary ID
+#define FRAME_HEADER_SIZE_DICT 19
+// FLG of Compress::create_header() with both checksums
+#define FRAME_FLAGS (104 | FRAME_BLOCK_CHECKSUM | FRAME_CONTENT_CHECKSUM)
+// Zone map argument of xilLz4Compress without FRAME_ZONE_MAP
+static const dt_zoneConfig c_noZoneConfig = {};
+
+// Kernel tops, built from kernel/src with the same PARALLEL_BLOCK / GMEM_BURST_SIZE as the xclbin
+extern "C" {
+void xilLz4Compress(const uintMemWidth_t* in,
+                    uintMemWidth_t* out,
+                    uint32_t* compressd_size,
+                    dt_blockDesc* block_desc,
+                    uint32_t* block_entropy,
+                    uint32_t* content_checksum,
+                    uint32_t block_size_in_kb,
+                    uint32_t no_blocks,
+                    uint32_t frame_flags,
+                    const uintMemWidth_t* dict,
+                    uint32_t dict_size,
+                    const dt_zoneConfig* zone_config,
+                    dt_zoneMap* zone_map);
+void xilLz4Packer(const uintMemWidth_t* in,
+                  uintMemWidth_t* out,
+                  uintMemWidth_t* head_prev_blk,
+                  uint32_t* compressd_size,
+                  dt_blockDesc* block_desc,
+                  uint32_t* encoded_size,
+                  uintMemWidth_t* orig_input_data,
+                  uint32_t* content_checksum,
+                  uint32_t* block_index,
+                  uint32_t head_res_size,
+                  uint32_t offset,
+                  uint32_t block_size_in_kb,
+                  uint32_t no_blocks,
+                  uint32_t tail_bytes,
+                  uint32_t frame_flags);
+void xilLz4Unpacker(const uintMemWidth_t* in,
+                    dt_blockInfo* bObj,
+                    dt_chunkInfo* cObj,
+                    uint32_t block_size_in_kb,
+                    uint8_t first_chunk,
+                    uint8_t total_no_cu,
+                    uint32_t num_blocks);
+void xilLz4P2PDecompress(const uintMemWidth_t* in,
+                         uintMemWidth_t* out,
+                         dt_blockInfo* bObj,
+                         dt_chunkInfo* cObj,
+                         uint32_t block_size_in_kb,
+                         uint32_t compute_unit,
+                         uint8_t total_no_cu,
+                         uint32_t num_blocks,
+                         const uintMemWidth_t* dict,
+                         uint32_t dict_size,
+                         const uintMemWidth_t* filter,
+                         dt_columnStats* column_stats);
+void xilGzipCompress(const uintMemWidth_t* in,
+                     uintMemWidth_t* out,
+                     uint32_t* compressd_size,
+                     dt_blockDesc* block_desc,
+                     uintMemWidth_t* lz77_out,
+                     uint32_t* content_checksum,
+                     uint32_t block_size_in_kb,
+                     uint32_t no_blocks,
+                     uint32_t frame_flags);
+void xilGzipPacker(const uintMemWidth_t* in,
+                   uintMemWidth_t* out,
+                   uintMemWidth_t* head_prev_blk,
+                   uint32_t* compressd_size,
+                   dt_blockDesc* block_desc,
+                   uint32_t* encoded_size,
+                   uintMemWidth_t* orig_input_data,
+                   uint32_t* content_checksum,
+                   uint32_t head_res_size,
+                   uint32_t block_size_in_kb,
+                   uint32_t no_blocks,
+                   uint32_t frame_flags);
+void xilGzipDecompress(const uintMemWidth_t* in,
+                       uintMemWidth_t* out,
+                       uint32_t* result,
+                       uint32_t input_size,
+                       uint32_t output_size,
+                       uint32_t frame_flags);
+}
+
+void csimResetCycles() {
+#ifdef CSIM_STREAM_STATS
+    csim::streamStats::reset();
+#endif
+}
+
+uint64_t csimCycles(uint64_t bytes) {
+#ifdef CSIM_STREAM_STATS
+    return csim::streamStats::cycles((bytes + GMEM_BYTES - 1) / GMEM_BYTES);
+#else
+    return 0;
+#endif
+}
+
+// Packs bytes into GMEM words, with spare zero words for kernels that read ahead
+static std::vector<uintMemWidth_t> toWords(const std::vector<uint8_t>& bytes, size_t words) {
+    std::vector<uintMemWidth_t> out(words);
+    for (size_t i = 0; i < bytes.size(); i++) out[i / GMEM_BYTES].range((i % GMEM_BYTES) * 8 + 7, (i % GMEM_BYTES) * 8) = bytes[i];
+    return out;
+}
+
+static std::vector<uint8_t> toBytes(const std::vector<uintMemWidth_t>& words, size_t size) {
+    std::vector<uint8_t> out(size);
+    for (size_t i = 0; i < size; i++) out[i] = (uint64_t)words[i / GMEM_BYTES].range((i % GMEM_BYTES) * 8 + 7, (i % GMEM_BYTES) * 8);
+    return out;
+}
+
+static uint32_t readLE32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// The block index frame follows the LZ4 frame of frame_size bytes and every entry points at a block size field
+static bool checkBlockIndex(const std::vector<uint8_t>& frame, size_t frame_size, uint32_t num_blocks,
+                            uint32_t block_size, uint32_t header_size = FRAME_HEADER_SIZE) {
+    size_t index_size = 8 * num_blocks + 8;
+    if (frame.size() != frame_size + 8 + index_size) return false;
+    const uint8_t* index = frame.data() + frame_size;
+    if (readLE32(index) != BLOCK_INDEX_FRAME_MAGIC || readLE32(index + 4) != index_size) return false;
+    if (readLE32(index + 8 + 8 * num_blocks) != num_blocks) return false;
+    if (readLE32(index + 12 + 8 * num_blocks) != BLOCK_INDEX_MAGIC) return false;
+    uint32_t offset = header_size;
+    for (uint32_t i = 0; i < num_blocks; i++) {
+        if (readLE32(index + 8 + 8 * i) != offset || readLE32(index + 12 + 8 * i) != i * block_size) return false;
+        offset += 4 + (readLE32(frame.data() + offset) & 0x7FFFFFFF) + 4;
+    }
+    return true;
+}
+
+static uint8_t blockSizeCode(uint32_t block_kb) {
+    switch (block_kb) {
+        case 256:
+            return 80;
+        case 1024:
+            return 96;
+        case 4096:
+            return 112;
+        default:
+            return 64;
+    }
+}
+
+// Same header as Compress::create_header(), with a dictionary ID when dict_id is not 0
+static std::vector<uint8_t> frameHeader(uint32_t block_kb, uint32_t input_size, uint32_t dict_id = 0) {
+    uint8_t flags = dict_id ? (FRAME_FLAGS | FRAME_DICT_ID) : FRAME_FLAGS;
+    uint8_t desc[14] = {flags, blockSizeCode(block_kb), (uint8_t)input_size, (uint8_t)(input_size >> 8),
+                        (uint8_t)(input_size >> 16), (uint8_t)(input_size >> 24), 0, 0, 0, 0,
+                        (uint8_t)dict_id, (uint8_t)(dict_id >> 8), (uint8_t)(dict_id >> 16), (uint8_t)(dict_id >> 24)};
+    uint32_t desc_size = dict_id ? 14 : 10;
+    std::vector<uint8_t> header = {4, 34, 77, 24};
+    header.insert(header.end(), desc, desc + desc_size);
+    header.push_back(XXH32(desc, desc_size, 0) >> 8);
+    return header;
+}
+
+// Descriptors of the blocks of a file at src_offset of the input whose frame goes to frame_offset of the output
+static void addBlocks(std::vector<dt_blockDesc>& desc, uint32_t src_offset, uint32_t size, uint32_t block_size,
+                      uint32_t file_id, uint32_t frame_offset) {
+    for (uint32_t offset = 0; offset < size; offset += block_size) {
+        uint32_t block = (size - offset < block_size) ? size - offset : block_size;
+        desc.push_back({src_offset + offset, block, file_id, frame_offset});
+    }
+}
+
+// Checks one frame of the packer output with LZ4F_decompress, which checks both checksums and stops at the end of
+// the LZ4 frame, and its block index frame
+static bool checkFrame(const std::vector<uint8_t>& frame, const uint8_t* data, uint32_t input_size, uint32_t block_size) {
+    LZ4F_dctx* dctx;
+    LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION);
+    std::vector<uint8_t> restored(input_size + block_size);
+    size_t dst_size = restored.size();
+    size_t src_size = frame.size();
+    size_t ret = LZ4F_decompress(dctx, restored.data(), &dst_size, frame.data(), &src_size, NULL);
+    LZ4F_freeDecompressionContext(dctx);
+    bool match = !LZ4F_isError(ret) && ret == 0 && dst_size == input_size && !memcmp(restored.data(), data, input_size);
+    return match && checkBlockIndex(frame, src_size, (input_size - 1) / block_size + 1, block_size);
+}
+
+// Checks one frame compressed against dict block by block with LZ4_decompress_safe_usingDict (liblz4 has no
+// dictionary frame decoder in its public API), the block and content checksums, and its block index frame
+static bool checkDictFrame(const std::vector<uint8_t>& frame, const uint8_t* data, uint32_t input_size,
+                           uint32_t block_size, const std::vector<uint8_t>& dict) {
+    std::vector<uint8_t> restored(input_size + block_size);
+    uint32_t pos = FRAME_HEADER_SIZE_DICT;
+    uint32_t out = 0;
+    if (frame.size() < pos + 4 || frame[4] != (FRAME_FLAGS | FRAME_DICT_ID)) return false;
+    if (readLE32(frame.data() + 14) != XXH32(dict.data(), dict.size(), 0)) return false;
+    uint32_t num_blocks = 0;
+    while (true) {
+        if (pos + 4 > frame.size()) return false;
+        uint32_t word = readLE32(frame.data() + pos);
+        pos += 4;
+        if (word == 0) break;
+        uint32_t size = word & 0x7FFFFFFF;
+        if (pos + size + 4 > frame.size() || out + block_size > restored.size()) return false;
+        const uint8_t* block = frame.data() + pos;
+        if (readLE32(block + size) != XXH32(block, size, 0)) return false;
+        if (word & 0x80000000) {
+            memcpy(restored.data() + out, block, size);
+            out += size;
+        } else {
+            int ret = LZ4_decompress_safe_usingDict((const char*)block, (char*)restored.data() + out, size, block_size,
+                                                    (const char*)dict.data(), dict.size());
+            if (ret < 0) return false;
+            out += ret;
+        }
+        pos += size + 4;
+        num_blocks++;
+    }
+    if (out != input_size || memcmp(restored.data(), data, input_size)) return false;
+    if (readLE32(frame.data() + pos) != XXH32(data, input_size, 0)) return false;
+    return checkBlockIndex(frame, pos + 4, num_blocks, block_size, FRAME_HEADER_SIZE_DICT);
+}
+
+void csimKernelCompress(const std::vector<uint8_t>& data, uint32_t block_kb, std::vector<uint8_t>& frame,
+                        std::vector<csimResult>& results) {
+    uint32_t input_size = data.size();
+    uint32_t block_size = block_kb * 1024;
+    uint32_t num_blocks = (input_size - 1) / block_size + 1;
+    size_t words = input_size / GMEM_BYTES + 64;
+
+    std::vector<uintMemWidth_t> in = toWords(data, words);
+    std::vector<uintMemWidth_t> tmp(num_blocks * block_size / GMEM_BYTES), out(words);
+    std::vector<uint32_t> compressd_size(num_blocks), block_entropy(num_blocks);
+    std::vector<uint32_t> block_index(2 * num_blocks);
+    std::vector<dt_blockDesc> block_desc;
+    uint32_t content_checksum = 0;
+    std::vector<uintMemWidth_t> no_dict(1);
+    addBlocks(block_desc, 0, input_size, block_size, 0, 0);
+
+    csimResetCycles();
+    xilLz4Compress(in.data(), tmp.data(), compressd_size.data(), block_desc.data(), block_entropy.data(),
+                   &content_checksum, block_kb, num_blocks, FRAME_FLAGS, no_dict.data(), 0,
+                   &c_noZoneConfig, NULL);
+    uint64_t comp_cycles = csimCycles(input_size);
+
+    std::vector<uintMemWidth_t> head = toWords(frameHeader(block_kb, input_size), 1);
+    uint32_t encoded_size[16] = {0};
+    uint64_t block_bytes = 0;
+    for (uint32_t i = 0; i < num_blocks; i++) block_bytes += compressd_size[i];
+    csimResetCycles();
+    xilLz4Packer(tmp.data(), out.data(), head.data(), compressd_size.data(), block_desc.data(), encoded_size,
+                 in.data(), &content_checksum, block_index.data(), FRAME_HEADER_SIZE, 0, block_kb, num_blocks, 1,
+                 FRAME_FLAGS | FRAME_BLOCK_INDEX);
+    uint64_t pack_cycles = csimCycles(block_bytes);
+
+    // The end mark, the content checksum and the block index frame are counted in encoded_size
+    frame = toBytes(out, encoded_size[0]);
+    bool match = checkFrame(frame, data.data(), input_size, block_size);
+
+    results.push_back({"xilLz4Compress", input_size, block_bytes, comp_cycles, match});
+    results.push_back({"xilLz4Packer", input_size, encoded_size[0], pack_cycles, match});
+}
+
+void csimKernelZoneMap(const std::vector<uint8_t>& data, uint32_t block_kb, uint32_t layout,
+                       std::vector<csimResult>& results) {
+    static const char* c_layoutNames[] = {"delimited", "fixed"};
+    uint32_t input_size = data.size();
+    uint32_t block_size = block_kb * 1024;
+    uint32_t num_blocks = (input_size - 1) / block_size + 1;
+
+    // The logs corpus ends its lines in latency_ms=<n>, the 6th field split on '=', and starts them with the date
+    dt_zoneConfig config = {};
+    config.layout = layout;
+    config.delimiter = '\n';
+    config.fieldDelimiter = '=';
+    config.column = 5;
+    config.offset = 8;
+    config.width = 2;
+
+    std::vector<uintMemWidth_t> in = toWords(data, input_size / GMEM_BYTES + 64);
+    std::vector<uintMemWidth_t> tmp(num_blocks * block_size / GMEM_BYTES), no_dict(1);
+    std::vector<uint32_t> compressd_size(num_blocks), block_entropy(num_blocks);
+    std::vector<dt_zoneMap> zones(num_blocks);
+    std::vector<dt_blockDesc> block_desc;
+    uint32_t content_checksum = 0;
+    addBlocks(block_desc, 0, input_size, block_size, 0, 0);
+
+    csimResetCycles();
+    xilLz4Compress(in.data(), tmp.data(), compressd_size.data(), block_desc.data(), block_entropy.data(),
+                   &content_checksum, block_kb, num_blocks, FRAME_FLAGS | FRAME_ZONE_MAP, no_dict.data(), 0, &config,
+                   zones.data());
+    uint64_t comp_cycles = csimCycles(input_size);
+
+    // Every block against the parse of the host, then the joined entries against every record given to the block
+    // it starts in
+    bool match = true;
+    for (uint32_t b = 0; b < num_blocks; b++) {
+        uint32_t size = std::min(block_size, input_size - b * block_size);
+        dt_zoneMap expected;
+        zoneMapBlock(config, data.data() + (size_t)b * block_size, size, expected);
+        match = match && (memcmp(&expected, &zones[b], sizeof(dt_zoneMap)) == 0);
+    }
+
+    std::vector<lz4ZoneEntry> entries, expected(num_blocks);
+    zoneMapJoin(config, data.data(), input_size, block_size, zones.data(), entries);
+    for (uint32_t b = 0; b < num_blocks; b++) {
+        expected[b] = {0, 0, 0, 0, std::min(block_size, input_size - b * block_size)};
+    }
+    uint64_t start = 0;
+    for (uint64_t i = 0; i < input_size; i++) {
+        if (data[i] != config.delimiter && i + 1 < input_size) continue;
+        uint64_t end = (data[i] == config.delimiter) ? i : i + 1;
+        lz4ZoneEntry& entry = expected[start / block_size];
+        if (entry.records == 0) entry.first = start % block_size;
+        entry.records++;
+        int64_t value;
+        if (zoneMapValue(config, data.data() + start, end - start, value)) {
+            if (entry.values == 0 || value < entry.min) entry.min = value;
+            if (entry.values == 0 || value > entry.max) entry.max = value;
+            entry.values++;
+        }
+        start = i + 1;
+    }
+    for (uint32_t b = 0; b < num_blocks; b++) {
+        const lz4ZoneEntry &got = entries[b], &want = expected[b];
+        match = match && (got.min == want.min) && (got.max == want.max) && (got.records == want.records) &&
+                (got.values == want.values) && (got.first == want.first);
+    }
+    results.push_back({std::string("xilLz4Compress zone map ") + c_layoutNames[layout], input_size,
+                       num_blocks * sizeof(dt_zoneMap), comp_cycles, match});
+}
+
+void csimKernelBatch(const std::vector<uint8_t>& data, uint32_t block_kb, std::vector<csimResult>& results) {
+    uint32_t input_size = data.size();
+    uint32_t block_size = block_kb * 1024;
+
+    // Files of 1, 2, 3, ... pages and a last one with the rest, each frame in its own 4K aligned slot
+    std::vector<uint32_t> file_offset, file_size, frame_offset;
+    std::vector<dt_blockDesc> block_desc;
+    uint32_t out_size = 0;
+    for (uint32_t offset = 0, pages = 1; offset < input_size; offset += file_size.back(), pages++) {
+        uint32_t size = (input_size - offset < pages * 4096) ? input_size - offset : pages * 4096;
+        addBlocks(block_desc, offset, size, block_size, file_size.size(), out_size);
+        file_offset.push_back(offset);
+        file_size.push_back(size);
+        frame_offset.push_back(out_size);
+        out_size += ((size + size / 64 + 1024) / 4096 + 1) * 4096;
+    }
+    uint32_t num_files = file_size.size();
+    uint32_t num_blocks = block_desc.size();
+
+    std::vector<uintMemWidth_t> in = toWords(data, input_size / GMEM_BYTES + 64);
+    std::vector<uintMemWidth_t> tmp(num_blocks * block_size / GMEM_BYTES), out(out_size / GMEM_BYTES + 64);
+    std::vector<uintMemWidth_t> head(num_files), no_dict(1);
+    std::vector<uint32_t> compressd_size(num_blocks), block_entropy(num_blocks), block_index(2 * num_blocks);
+    std::vector<uint32_t> content_checksum(num_files), encoded_size(num_files);
+    for (uint32_t f = 0; f < num_files; f++) head[f] = toWords(frameHeader(block_kb, file_size[f]), 1)[0];
+
+    csimResetCycles();
+    xilLz4Compress(in.data(), tmp.data(), compressd_size.data(), block_desc.data(), block_entropy.data(),
+                   content_checksum.data(), block_kb, num_blocks, FRAME_FLAGS, no_dict.data(), 0,
+                   &c_noZoneConfig, NULL);
+    uint64_t comp_cycles = csimCycles(input_size);
+    uint64_t block_bytes = 0;
+    for (uint32_t i = 0; i < num_blocks; i++) block_bytes += compressd_size[i];
+    csimResetCycles();
+    xilLz4Packer(tmp.data(), out.data(), head.data(), compressd_size.data(), block_desc.data(), encoded_size.data(),
+                 in.data(), content_checksum.data(), block_index.data(), FRAME_HEADER_SIZE, 0, block_kb, num_blocks,
+                 1, FRAME_FLAGS | FRAME_BLOCK_INDEX);
+    uint64_t pack_cycles = csimCycles(block_bytes);
+
+    std::vector<uint8_t> output = toBytes(out, out_size);
+    bool match = true;
+    uint64_t frame_bytes = 0;
+    for (uint32_t f = 0; f < num_files; f++) {
+        std::vector<uint8_t> frame(output.begin() + frame_offset[f], output.begin() + frame_offset[f] + encoded_size[f]);
+        match = match && checkFrame(frame, data.data() + file_offset[f], file_size[f], block_size);
+        frame_bytes += encoded_size[f];
+    }
+    std::string name = " x" + std::to_string(num_files) + " files";
+    results.push_back({"xilLz4Compress" + name, input_size, block_bytes, comp_cycles, match});
+    results.push_back({"xilLz4Packer" + name, input_size, frame_bytes, pack_cycles, match});
+}
+
+void csimKernelDecompress(const std::string& name,
+                          const std::vector<uint8_t>& frame,
+                          const std::vector<uint8_t>& data,
+                          uint32_t block_kb,
+                          uint32_t num_cu,
+                          std::vector<csimResult>& results,
+                          const std::vector<uint8_t>& dict) {
+    uint32_t original_size = data.size();
+    uint32_t total_blocks = (original_size - 1) / (block_kb * 1024) + 1;
+    uint8_t total_no_cu = (total_blocks < num_cu) ? total_blocks : num_cu;
+    uint32_t num_blocks = (total_blocks - 1) / total_no_cu + 1;
+
+    // The host reads whole 4K pages of the compressed file
+    std::vector<uint8_t> padded = frame;
+    padded.resize(((padded.size() - 1) / 4096 + 1) * 4096, 0);
+    std::vector<uintMemWidth_t> in = toWords(padded, padded.size() / GMEM_BYTES + 64);
+    std::vector<uintMemWidth_t> out(original_size / GMEM_BYTES + 64);
+    std::vector<dt_blockInfo> block_info(total_blocks + 16);
+    std::vector<uintMemWidth_t> dict_words = toWords(dict, dict.size() / GMEM_BYTES + 1), no_filter(1);
+    std::vector<dt_columnStats> no_stats(FILTER_MAX_COLUMNS);
+    dt_chunkInfo chunk_info;
+    memset(&chunk_info, 0, sizeof(chunk_info));
+
+    csimResetCycles();
+    xilLz4Unpacker(in.data(), block_info.data(), &chunk_info, block_kb, 1, total_no_cu, num_blocks);
+    // Reads the block headers only
+    uint64_t unpack_cycles = csimCycles(0);
+
+    // Compute units run concurrently on hardware, the slowest one bounds the call
+    uint64_t dec_cycles = 0;
+    uint64_t cu_bytes = std::min<uint64_t>((uint64_t)num_blocks * block_kb * 1024, original_size);
+    for (uint32_t cu = 0; cu < total_no_cu; cu++) {
+        csimResetCycles();
+        xilLz4P2PDecompress(in.data(), out.data(), block_info.data(), &chunk_info, block_kb, cu, total_no_cu, num_blocks,
+                            dict_words.data(), dict.size(), no_filter.data(), no_stats.data());
+        dec_cycles = std::max(dec_cycles, csimCycles(cu_bytes));
+    }
+
+    bool match = (toBytes(out, original_size) == data);
+    for (uint32_t i = 0; i < total_blocks; i++) {
+        if (block_info[i].checksumStatus == BLOCK_CHECKSUM_MISMATCH) match = false;
+    }
+    results.push_back({name + " xilLz4Unpacker", original_size, frame.size(), unpack_cycles, match});
+    results.push_back({name + " xilLz4P2PDecompress x" + std::to_string(total_no_cu), original_size, original_size,
+                       dec_cycles, match});
+}
+
+void csimKernelDict(const std::vector<uint8_t>& data, uint32_t block_kb, std::vector<csimResult>& results) {
+    uint32_t block_size = block_kb * 1024;
+    const uint32_t file_bytes = 4096;
+    // The head of the data is the dictionary, the rest is cut into 4K files compressed against it
+    uint32_t dict_size = (data.size() / 4 < 32 * 1024) ? data.size() / 4 : 32 * 1024;
+    if (dict_size < 64 || data.size() - dict_size < file_bytes) return;
+    std::vector<uint8_t> dict(data.begin(), data.begin() + dict_size);
+    std::vector<uint8_t> rest(data.begin() + dict_size, data.end());
+    uint32_t input_size = rest.size();
+    uint32_t dict_id = XXH32(dict.data(), dict.size(), 0);
+
+    std::vector<uint32_t> file_offset, file_size, frame_offset;
+    std::vector<dt_blockDesc> block_desc;
+    uint32_t out_size = 0;
+    for (uint32_t offset = 0; offset < input_size; offset += file_size.back()) {
+        uint32_t size = (input_size - offset < file_bytes) ? input_size - offset : file_bytes;
+        addBlocks(block_desc, offset, size, block_size, file_size.size(), out_size);
+        file_offset.push_back(offset);
+        file_size.push_back(size);
+        frame_offset.push_back(out_size);
+        out_size += 2 * 4096;
+    }
+    uint32_t num_files = file_size.size();
+    uint32_t num_blocks = block_desc.size();
+
+    std::vector<uintMemWidth_t> in = toWords(rest, input_size / GMEM_BYTES + 64);
+    std::vector<uintMemWidth_t> dict_words = toWords(dict, dict_size / GMEM_BYTES + 1);
+    std::vector<uintMemWidth_t> tmp(num_blocks * block_size / GMEM_BYTES), out(out_size / GMEM_BYTES + 64);
+    std::vector<uintMemWidth_t> head(num_files);
+    std::vector<uint32_t> compressd_size(num_blocks), block_entropy(num_blocks), block_index(2 * num_blocks);
+    std::vector<uint32_t> content_checksum(num_files), encoded_size(num_files);
+    for (uint32_t f = 0; f < num_files; f++) head[f] = toWords(frameHeader(block_kb, file_size[f], dict_id), 1)[0];
+
+    csimResetCycles();
+    xilLz4Compress(in.data(), tmp.data(), compressd_size.data(), block_desc.data(), block_entropy.data(),
+                   content_checksum.data(), block_kb, num_blocks, FRAME_FLAGS | FRAME_DICT_ID, dict_words.data(),
+                   dict_size, &c_noZoneConfig, NULL);
+    uint64_t comp_cycles = csimCycles(input_size);
+    uint64_t block_bytes = 0;
+    for (uint32_t i = 0; i < num_blocks; i++) block_bytes += compressd_size[i];
+    csimResetCycles();
+    xilLz4Packer(tmp.data(), out.data(), head.data(), compressd_size.data(), block_desc.data(), encoded_size.data(),
+                 in.data(), content_checksum.data(), block_index.data(), FRAME_HEADER_SIZE_DICT, 0, block_kb,
+                 num_blocks, 1, FRAME_FLAGS | FRAME_DICT_ID | FRAME_BLOCK_INDEX);
+    uint64_t pack_cycles = csimCycles(block_bytes);
+
+    std::vector<uint8_t> output = toBytes(out, out_size);
+    bool match = true;
+    uint64_t frame_bytes = 0;
+    for (uint32_t f = 0; f < num_files; f++) {
+        std::vector<uint8_t> frame(output.begin() + frame_offset[f], output.begin() + frame_offset[f] + encoded_size[f]);
+        match = match && checkDictFrame(frame, rest.data() + file_offset[f], file_size[f], block_size, dict);
+        frame_bytes += encoded_size[f];
+    }
+    std::string name = " dict " + std::to_string(dict_size / 1024) + "K x" + std::to_string(num_files) + " files";
+    results.push_back({"xilLz4Compress" + name, input_size, block_bytes, comp_cycles, match});
+    results.push_back({"xilLz4Packer" + name, input_size, frame_bytes, pack_cycles, match});
+
+    // The first file back through the decompress kernels
+    std::vector<uint8_t> frame(output.begin(), output.begin() + encoded_size[0]);
+    std::vector<uint8_t> first(rest.begin(), rest.begin() + file_size[0]);
+    csimKernelDecompress("dict frame", frame, first, block_kb, 1, results, dict);
+}
+
+// Checks one gzip member or zlib stream with inflate, which checks the trailer and must end with the stream
+static bool checkDeflate(const std::vector<uint8_t>& stream, const uint8_t* data, uint32_t input_size, bool zlib) {
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    if (inflateInit2(&strm, zlib ? MAX_WBITS : MAX_WBITS + 16) != Z_OK) return false;
+    std::vector<uint8_t> restored(input_size + 1);
+    strm.next_in = (Bytef*)stream.data();
+    strm.avail_in = stream.size();
+    strm.next_out = restored.data();
+    strm.avail_out = restored.size();
+    int ret = inflate(&strm, Z_FINISH);
+    bool match = (ret == Z_STREAM_END) && strm.avail_in == 0 && strm.total_out == input_size &&
+                 !memcmp(restored.data(), data, input_size);
+    inflateEnd(&strm);
+    return match;
+}
+
+void csimKernelGzip(const std::vector<uint8_t>& data,
+                    uint32_t block_kb,
+                    bool zlib,
+                    std::vector<uint8_t>& stream,
+                    std::vector<csimResult>& results) {
+    uint32_t input_size = data.size();
+    uint32_t block_size = block_kb * 1024;
+    uint32_t frame_flags = zlib ? FRAME_ZLIB : 0;
+    // Header of Compress::create_header() for the codec
+    std::vector<uint8_t> header = zlib ? std::vector<uint8_t>{0x78, 0x01}
+                                       : std::vector<uint8_t>{0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 3};
+
+    // The whole input as one file, then files of 1, 2, 3, ... pages and a last one with the rest, each in its own
+    // 4K aligned slot
+    std::vector<uint32_t> file_offset, file_size, frame_offset;
+    std::vector<dt_blockDesc> block_desc;
+    uint32_t out_size = 0;
+    for (uint32_t offset = 0, pages = 0; offset < 2 * input_size; offset += file_size.back(), pages++) {
+        uint32_t src = offset % input_size;
+        uint32_t rest = input_size - src;
+        uint32_t size = (pages == 0 || rest < pages * 4096) ? rest : pages * 4096;
+        addBlocks(block_desc, src, size, block_size, file_size.size(), out_size);
+        file_offset.push_back(src);
+        file_size.push_back(size);
+        frame_offset.push_back(out_size);
+        out_size += ((size + 5 * (size / GZIP_STORED_CHUNK + 1) * 2 + 1024) / 4096 + 1) * 4096;
+    }
+    uint32_t num_files = file_size.size();
+    uint32_t num_blocks = block_desc.size();
+    uint32_t engines = (num_blocks < GZIP_MAX_ENGINES) ? num_blocks : GZIP_MAX_ENGINES;
+
+    std::vector<uintMemWidth_t> in = toWords(data, input_size / GMEM_BYTES + 64);
+    std::vector<uintMemWidth_t> tmp(num_blocks * block_size / GMEM_BYTES), out(out_size / GMEM_BYTES + 64);
+    std::vector<uintMemWidth_t> lz77(engines * GZIP_SYMBOL_BYTES * block_size / GMEM_BYTES);
+    std::vector<uintMemWidth_t> head(num_files, toWords(header, 1)[0]);
+    std::vector<uint32_t> compressd_size(num_blocks), content_checksum(num_files), encoded_size(num_files);
+
+    csimResetCycles();
+    xilGzipCompress(in.data(), tmp.data(), compressd_size.data(), block_desc.data(), lz77.data(),
+                    content_checksum.data(), block_kb, num_blocks, frame_flags);
+    uint64_t comp_cycles = csimCycles(2 * (uint64_t)input_size);
+    uint64_t block_bytes = 0;
+    for (uint32_t i = 0; i < num_blocks; i++) block_bytes += compressd_size[i];
+    csimResetCycles();
+    xilGzipPacker(tmp.data(), out.data(), head.data(), compressd_size.data(), block_desc.data(), encoded_size.data(),
+                  in.data(), content_checksum.data(), header.size(), block_kb, num_blocks, frame_flags);
+    uint64_t pack_cycles = csimCycles(block_bytes);
+
+    std::vector<uint8_t> output = toBytes(out, out_size);
+    bool match = true;
+    uint64_t frame_bytes = 0;
+    for (uint32_t f = 0; f < num_files; f++) {
+        std::vector<uint8_t> frame(output.begin() + frame_offset[f], output.begin() + frame_offset[f] + encoded_size[f]);
+        match = match && checkDeflate(frame, data.data() + file_offset[f], file_size[f], zlib);
+        frame_bytes += encoded_size[f];
+        if (f == 0) stream = frame;
+    }
+    std::string name = std::string(zlib ? " zlib" : " gzip") + " x" + std::to_string(num_files) + " files";
+    results.push_back({"xilGzipCompress" + name, 2 * (uint64_t)input_size, block_bytes, comp_cycles, match});
+    results.push_back({"xilGzipPacker" + name, 2 * (uint64_t)input_size, frame_bytes, pack_cycles, match});
+}
+
+void csimKernelGzipDecompress(const std::string& name,
+                              const std::vector<uint8_t>& stream,
+                              const std::vector<uint8_t>& data,
+                              bool zlib,
+                              std::vector<csimResult>& results) {
+    uint32_t original_size = data.size();
+    uint32_t frame_flags = zlib ? FRAME_ZLIB : 0;
+
+    // The host reads whole 4K pages of the compressed file
+    std::vector<uint8_t> padded = stream;
+    padded.resize(((padded.size() - 1) / 4096 + 1) * 4096, 0);
+    std::vector<uintMemWidth_t> in = toWords(padded, padded.size() / GMEM_BYTES + 64);
+    std::vector<uintMemWidth_t> out(original_size / GMEM_BYTES + 64);
+    uint32_t result[2];
+
+    csimResetCycles();
+    xilGzipDecompress(in.data(), out.data(), result, padded.size(), out.size() * GMEM_BYTES, frame_flags);
+    uint64_t cycles = csimCycles(original_size);
+    bool match = (result[1] == INFLATE_OK) && (result[0] == original_size) && (toBytes(out, original_size) == data);
+
+    // Half the output buffer: the content is still counted and checked, only the first half is written
+    uint32_t half = (original_size / 2) & ~(GMEM_BYTES - 1);
+    std::vector<uintMemWidth_t> small(half / GMEM_BYTES + 1);
+    xilGzipDecompress(in.data(), small.data(), result, padded.size(), half, frame_flags);
+    match = match && (result[1] == INFLATE_OK) && (result[0] == original_size) &&
+            !memcmp(toBytes(small, half).data(), data.data(), half) && (small.back() == 0);
+
+    // A corrupted CRC32 (gzip) or Adler32 (zlib) must not pass; a flip inside the deflate data may still
+    // inflate to the same content, as zlib would let it
+    padded[stream.size() - (zlib ? 4 : 8)] ^= 0x5A;
+    std::vector<uintMemWidth_t> bad = toWords(padded, padded.size() / GMEM_BYTES + 64);
+    xilGzipDecompress(bad.data(), out.data(), result, padded.size(), out.size() * GMEM_BYTES, frame_flags);
+    match = match && (result[1] == INFLATE_TRAILER_MISMATCH);
+
+    results.push_back({name + " xilGzipDecompress", original_size, stream.size(), cycles, match});
+}
+
+// Stream identifier chunk of Compress::create_header() for Snappy streams
+static const std::vector<uint8_t> c_snappyStreamId = {0xff, 6, 0, 0, 's', 'N', 'a', 'P', 'p', 'Y'};
+
+// Masked CRC32C of the Snappy framing format, bit by bit (no libsnappy in the testbench)
+static uint32_t snappyMaskedCrc(const uint8_t* data, uint32_t size) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (uint32_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78 : 0);
+    }
+    crc = ~crc;
+    return ((crc >> 15) | (crc << 17)) + 0xA282EAD8;
+}
+
+// Raw Snappy block as the format description reads it: varint content size, literal and copy elements
+static bool snappyRawDecode(const uint8_t* src, uint32_t size, std::vector<uint8_t>& out) {
+    uint32_t pos = 0, content = 0;
+    for (int shift = 0; pos < size; shift += 7) {
+        content |= (src[pos] & 0x7F) << shift;
+        if (!(src[pos++] & 0x80)) break;
+    }
+    size_t start = out.size();
+    while (pos < size) {
+        uint8_t tag = src[pos++];
+        uint32_t len, offset;
+        if ((tag & 3) == 0) {
+            len = tag >> 2;
+            if (len >= 60) {
+                uint32_t bytes = len - 59;
+                len = 0;
+                for (uint32_t b = 0; b < bytes; b++) len |= src[pos++] << (8 * b);
+            }
+            len++;
+            if (pos + len > size) return false;
+            out.insert(out.end(), src + pos, src + pos + len);
+            pos += len;
+            continue;
+        }
+        if ((tag & 3) == 1) {
+            len = ((tag >> 2) & 7) + 4;
+            offset = ((tag >> 5) << 8) | src[pos++];
+        } else {
+            uint32_t bytes = ((tag & 3) == 2) ? 2 : 4;
+            len = (tag >> 2) + 1;
+            offset = 0;
+            for (uint32_t b = 0; b < bytes; b++) offset |= src[pos++] << (8 * b);
+        }
+        if (offset == 0 || offset > out.size() - start) return false;
+        for (uint32_t i = 0; i < len; i++) out.push_back(out[out.size() - offset]);
+    }
+    return pos == size && out.size() - start == content;
+}
+
+// Checks one Snappy framing format stream: the stream identifier, then data chunks of at most 64 KB with their
+// CRC32C up to the end of the stream
+static bool checkSnappy(const std::vector<uint8_t>& stream, const uint8_t* data, uint32_t input_size) {
+    if (stream.size() < c_snappyStreamId.size() ||
+        memcmp(stream.data(), c_snappyStreamId.data(), c_snappyStreamId.size())) {
+        return false;
+    }
+    std::vector<uint8_t> restored;
+    size_t pos = c_snappyStreamId.size();
+    while (pos < stream.size()) {
+        if (pos + 8 > stream.size()) return false;
+        uint8_t type = stream[pos];
+        uint32_t len = readLE32(stream.data() + pos) >> 8;
+        if (type > SNAPPY_CHUNK_UNCOMPRESSED || len < 4 || pos + 4 + len > stream.size()) return false;
+        const uint8_t* chunk = stream.data() + pos + 8;
+        size_t start = restored.size();
+        if (type == SNAPPY_CHUNK_UNCOMPRESSED) {
+            restored.insert(restored.end(), chunk, chunk + len - 4);
+        } else if (!snappyRawDecode(chunk, len - 4, restored)) {
+            return false;
+        }
+        uint32_t content = restored.size() - start;
+        if (content > SNAPPY_BLOCK_SIZE || content == 0) return false;
+        if (readLE32(stream.data() + pos + 4) != snappyMaskedCrc(restored.data() + start, content)) return false;
+        pos += 4 + len;
+    }
+    return restored.size() == input_size && !memcmp(restored.data(), data, input_size);
+}
+
+void csimKernelSnappy(const std::vector<uint8_t>& data, std::vector<uint8_t>& stream, std::vector<csimResult>& results) {
+    uint32_t input_size = data.size();
+    const uint32_t block_kb = SNAPPY_BLOCK_SIZE / 1024;
+    const std::vector<uint8_t>& header = c_snappyStreamId;
+
+    // The whole input as one file, then files of 1, 2, 3, ... pages and a last one with the rest, each in its own
+    // 4K aligned slot
+    std::vector<uint32_t> file_offset, file_size, frame_offset;
+    std::vector<dt_blockDesc> block_desc;
+    uint32_t out_size = 0;
+    for (uint32_t offset = 0, pages = 0; offset < 2 * input_size; offset += file_size.back(), pages++) {
+        uint32_t src = offset % input_size;
+        uint32_t rest = input_size - src;
+        uint32_t size = (pages == 0 || rest < pages * 4096) ? rest : pages * 4096;
+        addBlocks(block_desc, src, size, SNAPPY_BLOCK_SIZE, file_size.size(), out_size);
+        file_offset.push_back(src);
+        file_size.push_back(size);
+        frame_offset.push_back(out_size);
+        out_size += ((header.size() + size + 8 * (size / SNAPPY_BLOCK_SIZE + 1)) / 4096 + 1) * 4096;
+    }
+    uint32_t num_files = file_size.size();
+    uint32_t num_blocks = block_desc.size();
+
+    std::vector<uintMemWidth_t> in = toWords(data, input_size / GMEM_BYTES + 64);
+    std::vector<uintMemWidth_t> tmp(num_blocks * SNAPPY_BLOCK_SIZE / GMEM_BYTES), out(out_size / GMEM_BYTES + 64);
+    std::vector<uintMemWidth_t> head(num_files, toWords(header, 1)[0]), no_dict(1);
+    std::vector<uint32_t> compressd_size(num_blocks), block_entropy(num_blocks), block_index(2 * num_blocks);
+    // One CRC32C per block rather than one checksum per file
+    std::vector<uint32_t> block_crc(num_blocks), encoded_size(num_files);
+
+    csimResetCycles();
+    xilLz4Compress(in.data(), tmp.data(), compressd_size.data(), block_desc.data(), block_entropy.data(),
+                   block_crc.data(), block_kb, num_blocks, FRAME_SNAPPY, no_dict.data(), 0,
+                   &c_noZoneConfig, NULL);
+    uint64_t comp_cycles = csimCycles(2 * (uint64_t)input_size);
+    uint64_t block_bytes = 0;
+    for (uint32_t i = 0; i < num_blocks; i++) block_bytes += compressd_size[i];
+    csimResetCycles();
+    xilLz4Packer(tmp.data(), out.data(), head.data(), compressd_size.data(), block_desc.data(), encoded_size.data(),
+                 in.data(), block_crc.data(), block_index.data(), header.size(), 0, block_kb, num_blocks, 1,
+                 FRAME_SNAPPY);
+    uint64_t pack_cycles = csimCycles(block_bytes);
+
+    std::vector<uint8_t> output = toBytes(out, out_size);
+    bool match = true;
+    uint64_t frame_bytes = 0;
+    for (uint32_t f = 0; f < num_files; f++) {
+        std::vector<uint8_t> frame(output.begin() + frame_offset[f], output.begin() + frame_offset[f] + encoded_size[f]);
+        match = match && checkSnappy(frame, data.data() + file_offset[f], file_size[f]);
+        frame_bytes += encoded_size[f];
+        if (f == 0) stream = frame;
+    }
+    std::string name = " snappy x" + std::to_string(num_files) + " files";
+    results.push_back({"xilLz4Compress" + name, 2 * (uint64_t)input_size, block_bytes, comp_cycles, match});
+    results.push_back({"xilLz4Packer" + name, 2 * (uint64_t)input_size, frame_bytes, pack_cycles, match});
+}
+
+void csimKernelSnappyDecompress(const std::string& name,
+                                const std::vector<uint8_t>& stream,
+                                const std::vector<uint8_t>& data,
+                                uint32_t num_cu,
+                                std::vector<csimResult>& results) {
+    uint32_t original_size = data.size();
+    const uint32_t block_kb = SNAPPY_BLOCK_SIZE / 1024;
+    uint32_t total_blocks = (original_size - 1) / SNAPPY_BLOCK_SIZE + 1;
+    uint8_t total_no_cu = (total_blocks < num_cu) ? total_blocks : num_cu;
+    uint32_t num_blocks = (total_blocks - 1) / total_no_cu + 1;
+
+    // The host reads whole 4K pages of the compressed file, and ends the stream with a padding chunk
+    std::vector<uint8_t> padded = stream;
+    uint32_t pad = ((stream.size() + 4) / 4096 + 1) * 4096 - stream.size() - 4;
+    padded.push_back(SNAPPY_CHUNK_PADDING);
+    for (int b = 0; b < 3; b++) padded.push_back(pad >> (8 * b));
+    padded.resize(padded.size() + pad, 0);
+    uint64_t cycles[2] = {0, 0};
+    uint64_t cu_bytes = std::min<uint64_t>((uint64_t)num_blocks * SNAPPY_BLOCK_SIZE, original_size);
+    bool match = true;
+
+    // Clean, then with the CRC of the first data chunk corrupted, which must be reported
+    for (int corrupt = 0; corrupt < 2; corrupt++) {
+        if (corrupt) padded[c_snappyStreamId.size() + SNAPPY_CHUNK_HEADER_SIZE] ^= 0x5A;
+        std::vector<uintMemWidth_t> in = toWords(padded, padded.size() / GMEM_BYTES + 64);
+        std::vector<uintMemWidth_t> out(original_size / GMEM_BYTES + 64), no_dict(1);
+        std::vector<dt_blockInfo> block_info(total_blocks + 16);
+        std::vector<dt_columnStats> no_stats(FILTER_MAX_COLUMNS);
+        // Decompress::preProcess() hands the unpacker the size and the chunk count of the stream
+        dt_chunkInfo chunk_info;
+        memset(&chunk_info, 0, sizeof(chunk_info));
+        chunk_info.originalSize = original_size;
+        chunk_info.numBlocks = total_blocks;
+        chunk_info.flags = FRAME_SNAPPY;
+
+        csimResetCycles();
+        xilLz4Unpacker(in.data(), block_info.data(), &chunk_info, block_kb, 0, total_no_cu, num_blocks);
+        if (!corrupt) cycles[0] = csimCycles(0);
+        for (uint32_t cu = 0; cu < total_no_cu; cu++) {
+            csimResetCycles();
+            xilLz4P2PDecompress(in.data(), out.data(), block_info.data(), &chunk_info, block_kb, cu, total_no_cu,
+                                num_blocks, no_dict.data(), 0, no_dict.data(), no_stats.data());
+            if (!corrupt) cycles[1] = std::max(cycles[1], csimCycles(cu_bytes));
+        }
+
+        uint32_t mismatches = 0;
+        for (uint32_t i = 0; i < total_blocks; i++) {
+            if (block_info[i].checksumStatus == BLOCK_CHECKSUM_MISMATCH) mismatches++;
+        }
+        if (corrupt) {
+            match = match && (mismatches == 1) && (block_info[0].checksumStatus == BLOCK_CHECKSUM_MISMATCH);
+        } else {
+            match = match && (mismatches == 0) && (toBytes(out, original_size) == data);
+        }
+    }
+    results.push_back({name + " xilLz4Unpacker", original_size, stream.size(), cycles[0], match});
+    results.push_back({name + " xilLz4P2PDecompress x" + std::to_string(total_no_cu), original_size, original_size,
+                       cycles[1], match});
+}
+
+void csimKernelFilter(const std::string& name,
+                      const std::vector<uint8_t>& frame,
+                      const std::vector<uint8_t>& data,
+                      uint32_t block_kb,
+                      uint32_t num_cu,
+                      uint32_t mode,
+                      std::vector<csimResult>& results,
+                      bool match_all) {
+    static const char* c_modeNames[] = {"", "records", "offsets", "columns", "aggregate"};
+    const uint8_t delimiter = '\n';
+    uint32_t original_size = data.size();
+    uint32_t block_size = block_kb * 1024;
+    uint32_t total_blocks = (original_size - 1) / block_size + 1;
+    uint8_t total_no_cu = (total_blocks < num_cu) ? total_blocks : num_cu;
+    uint32_t num_blocks = (total_blocks - 1) / total_no_cu + 1;
+
+    recordFilter filter;
+    // The logs corpus ends its lines in latency_ms=<n>, the 6th field split on '='; the other fields read as NULL
+    std::vector<uint32_t> columns;
+    if (mode == FILTER_COLUMNS) columns = {5, 1};
+    if (mode == FILTER_AGGREGATE) columns = {5, 3, 0};
+    std::vector<std::string> patterns = {"ERROR", "status=5", "storage device"};
+    if (match_all) patterns.clear();
+    recordFilterBuild(patterns, delimiter, mode, filter, columns, '=');
+
+    std::vector<uint8_t> padded = frame;
+    padded.resize(((padded.size() - 1) / 4096 + 1) * 4096, 0);
+    std::vector<uintMemWidth_t> in = toWords(padded, padded.size() / GMEM_BYTES + 64);
+    std::vector<uintMemWidth_t> out(original_size / GMEM_BYTES + 64), no_dict(1);
+    std::vector<uintMemWidth_t> filter_words = toWords(filter.config, filter.config.size() / GMEM_BYTES);
+    std::vector<dt_blockInfo> block_info(total_blocks + 16);
+    std::vector<dt_columnStats> column_stats((total_blocks + 16) * FILTER_MAX_COLUMNS);
+    dt_chunkInfo chunk_info;
+    memset(&chunk_info, 0, sizeof(chunk_info));
+
+    xilLz4Unpacker(in.data(), block_info.data(), &chunk_info, block_kb, 1, total_no_cu, num_blocks);
+    uint64_t dec_cycles = 0;
+    uint64_t cu_bytes = std::min<uint64_t>((uint64_t)num_blocks * block_size, original_size);
+    for (uint32_t cu = 0; cu < total_no_cu; cu++) {
+        csimResetCycles();
+        xilLz4P2PDecompress(in.data(), out.data(), block_info.data(), &chunk_info, block_kb, cu, total_no_cu, num_blocks,
+                            no_dict.data(), 0, filter_words.data(), column_stats.data());
+        dec_cycles = std::max(dec_cycles, csimCycles(cu_bytes));
+    }
+
+    // Every block writes its filtered bytes where its content would go, Decompress::joinFiltered() joins them
+    std::vector<uint8_t> bytes = toBytes(out, original_size), result;
+    recordFilterJoin join(filter, result);
+    bool match = true;
+    uint32_t filtered_size = 0;
+    for (uint32_t b = 0; b < total_blocks; b++) {
+        if (block_info[b].filterStatus != FILTER_OK) match = false;
+        filtered_size += block_info[b].filteredSize;
+        join.addBlock(bytes.data() + (size_t)b * block_size, block_info[b],
+                      column_stats.data() + (size_t)b * FILTER_MAX_COLUMNS);
+    }
+    join.finish();
+
+    // Every record of the content checked on its own, but the zeros that pad it to whole pages
+    std::vector<uint8_t> expected;
+    uint64_t expected_matches = 0;
+    std::vector<dt_columnStats> expected_stats(columns.size());
+    for (dt_columnStats& stats : expected_stats) memset(&stats, 0, sizeof(stats));
+    int64_t values[FILTER_MAX_COLUMNS];
+    uint64_t start = 0;
+    for (uint64_t i = 0; i < original_size; i++) {
+        if (data[i] != delimiter && i + 1 < original_size) continue;
+        uint64_t end = (data[i] == delimiter) ? i : i + 1;
+        bool padding = (end == original_size) &&
+                       std::all_of(data.begin() + start, data.end(), [](uint8_t byte) { return byte == 0; });
+        if (!padding && recordFilterMatch(filter, data.data() + start, end - start)) {
+            expected_matches++;
+            recordFilterProject(filter, data.data() + start, end - start, values);
+            if (mode == FILTER_RECORDS) {
+                expected.insert(expected.end(), data.begin() + start, data.begin() + i + 1);
+            } else if (mode == FILTER_OFFSETS) {
+                for (int b = 0; b < 8; b++) expected.push_back(start >> (8 * b));
+            } else if (mode == FILTER_COLUMNS) {
+                for (uint32_t c = 0; c < columns.size(); c++) {
+                    for (int b = 0; b < 8; b++) expected.push_back((uint64_t)values[c] >> (8 * b));
+                }
+            } else {
+                for (uint32_t c = 0; c < columns.size(); c++) {
+                    dt_columnStats& stats = expected_stats[c];
+                    if (values[c] == FILTER_NULL) continue;
+                    if (!stats.count || values[c] < stats.min) stats.min = values[c];
+                    if (!stats.count || values[c] > stats.max) stats.max = values[c];
+                    stats.sum += values[c];
+                    stats.count++;
+                }
+            }
+        }
+        start = i + 1;
+    }
+    match = match && (join.matches() == expected_matches);
+    if (mode == FILTER_AGGREGATE) {
+        for (uint32_t c = 0; c < columns.size(); c++) {
+            const dt_columnStats &got = join.stats()[c], &want = expected_stats[c];
+            match = match && (got.count == want.count) && (got.sum == want.sum) &&
+                    (!want.count || (got.min == want.min && got.max == want.max));
+        }
+    } else {
+        match = match && (result == expected);
+    }
+    results.push_back({name + " xilLz4P2PDecompress x" + std::to_string(total_no_cu) + " " + c_modeNames[mode] + (match_all ? " all" : ""),
+                       original_size, filtered_size, dec_cycles, match});
+}
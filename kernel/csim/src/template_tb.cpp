@@ -0,0 +1,115 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "csim_tb.hpp"
+#include <lz4.h>
+#include <string.h>
+#include "lz4_compress_mm.hpp"
+#include "lz4_decompress.hpp"
+
+// Same history as lz4CoreDec
+#define HISTORY_SIZE LZ_MAX_OFFSET_LIMIT
+
+// Single engine version of lz4Core without the GMEM width converters
+static void templateCompressBlock(const uint8_t* src, uint32_t size, std::vector<uint8_t>& block, bool& raw,
+                                  uint64_t& cycles) {
+    hls::stream<ap_uint<8> > inStream("inStream");
+    hls::stream<xf::compression::compressd_dt> compressdStream("compressdStream");
+    hls::stream<xf::compression::compressd_dt> bestMatchStream("bestMatchStream");
+    hls::stream<xf::compression::compressd_dt> boosterStream("boosterStream");
+    hls::stream<ap_uint<8> > lz4Out("lz4Out");
+    hls::stream<bool> lz4Out_eos("lz4Out_eos");
+    hls::stream<uint32_t> compressedSize("compressedSize");
+    uint32_t max_lit_limit[1] = {0};
+
+    for (uint32_t i = 0; i < size; i++) inStream << src[i];
+
+    csimResetCycles();
+    xf::compression::lzCompress<MATCH_LEN, MIN_MATCH, LZ_MAX_OFFSET_LIMIT>(inStream, compressdStream, size);
+    xf::compression::lzBestMatchFilter<MATCH_LEN, OFFSET_WINDOW>(compressdStream, bestMatchStream, size);
+    xf::compression::lzBooster<MAX_MATCH_LEN>(bestMatchStream, boosterStream, size);
+    xf::compression::lz4Compress<MAX_LIT_COUNT, 1>(boosterStream, lz4Out, max_lit_limit, size, lz4Out_eos,
+                                                   compressedSize, 0);
+    cycles = csimCycles(0);
+
+    block.clear();
+    for (bool eos = lz4Out_eos.read(); !eos; eos = lz4Out_eos.read()) block.push_back(lz4Out.read());
+    lz4Out.read();
+    compressedSize.read();
+    // Too many literals for the FIFO, the output is incomplete and the kernel stores the block instead
+    raw = max_lit_limit[0];
+}
+
+// lz4Decompress followed by lzDecompress, as in lz4CoreDec
+static void templateDecompressBlock(const uint8_t* src, uint32_t size, uint32_t original_size,
+                                    std::vector<uint8_t>& out, uint64_t& cycles) {
+    hls::stream<ap_uint<8> > inStream("inStream");
+    hls::stream<xf::compression::compressd_dt> decompressdStream("decompressdStream");
+    hls::stream<ap_uint<8> > outStream("outStream");
+    uint32_t low_offset_cycles = 0;
+
+    for (uint32_t i = 0; i < size; i++) inStream << src[i];
+
+    csimResetCycles();
+    xf::compression::lz4Decompress(inStream, decompressdStream, size);
+    xf::compression::lzDecompress<HISTORY_SIZE>(decompressdStream, outStream, original_size, low_offset_cycles);
+    cycles = csimCycles(0) ? csimCycles(0) + low_offset_cycles : 0;
+
+    out.clear();
+    while (!outStream.empty()) out.push_back(outStream.read());
+}
+
+void csimTemplateCompress(const std::vector<uint8_t>& data, uint32_t block_size, std::vector<csimResult>& results) {
+    csimResult result = {"lz4 templates compress", 0, 0, 0, true};
+    uint32_t raw_blocks = 0;
+    std::vector<uint8_t> block, restored(block_size);
+    for (uint32_t idx = 0; idx < data.size(); idx += block_size) {
+        uint32_t size = std::min<uint32_t>(block_size, data.size() - idx);
+        bool raw;
+        uint64_t cycles;
+        templateCompressBlock(data.data() + idx, size, block, raw, cycles);
+
+        result.bytes += size;
+        result.cycles += cycles;
+        if (raw) {
+            raw_blocks++;
+            result.output += size;
+            continue;
+        }
+        int ret = LZ4_decompress_safe((const char*)block.data(), (char*)restored.data(), block.size(), size);
+        if (ret != (int)size || memcmp(restored.data(), data.data() + idx, size)) result.match = false;
+        result.output += block.size();
+    }
+    if (raw_blocks) result.name += " (" + std::to_string(raw_blocks) + " raw)";
+    results.push_back(result);
+}
+
+void csimTemplateDecompress(const std::vector<uint8_t>& data, uint32_t block_size, std::vector<csimResult>& results) {
+    csimResult result = {"lz4 templates decompress", 0, 0, 0, true};
+    std::vector<uint8_t> block(LZ4_compressBound(block_size)), restored;
+    for (uint32_t idx = 0; idx < data.size(); idx += block_size) {
+        uint32_t size = std::min<uint32_t>(block_size, data.size() - idx);
+        int comp_size = LZ4_compress_default((const char*)data.data() + idx, (char*)block.data(), size, block.size());
+        uint64_t cycles;
+        templateDecompressBlock(block.data(), comp_size, size, restored, cycles);
+
+        if (restored.size() != size || memcmp(restored.data(), data.data() + idx, size)) result.match = false;
+        result.bytes += size;
+        result.output += restored.size();
+        result.cycles += cycles;
+    }
+    results.push_back(result);
+}
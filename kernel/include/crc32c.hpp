@@ -0,0 +1,72 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_CRC32C_HPP_
+#define _XFCOMPRESSION_CRC32C_HPP_
+
+/**
+ * @file crc32c.hpp
+ * @brief Streaming CRC32C (Castagnoli) and the masked form the Snappy
+ * framing format stores after every chunk header.
+ *
+ * Takes up to 8 bytes per update, bit by bit like the CRC32 of
+ * gzip_checksum.hpp, which unrolls into an XOR network of the input bits.
+ *
+ * This file is part of Vitis Data Compression Library.
+ */
+#include <ap_int.h>
+#include <stdint.h>
+
+namespace xf {
+namespace compression {
+namespace details {
+
+const uint32_t c_crc32cPoly = 0x82F63B78;
+const uint32_t c_crc32cMaskDelta = 0xA282EAD8;
+
+inline uint32_t crc32cReset() {
+    return 0xFFFFFFFF;
+}
+
+/**
+ * @brief Appends the low bytes (1 ~ 8) of word to the running CRC.
+ */
+inline uint32_t crc32cUpdate(uint32_t crc, ap_uint<64> word, uint32_t bytes) {
+#pragma HLS INLINE
+    for (int i = 0; i < 8; i++) {
+#pragma HLS UNROLL
+        if (i < bytes) {
+            crc ^= (uint8_t)word.range(i * 8 + 7, i * 8);
+            for (int k = 0; k < 8; k++) {
+#pragma HLS UNROLL
+                crc = (crc & 1) ? (crc >> 1) ^ c_crc32cPoly : (crc >> 1);
+            }
+        }
+    }
+    return crc;
+}
+
+// CRC32C of the bytes, rotated and offset as in a Snappy chunk header
+inline uint32_t crc32cMaskedDigest(uint32_t crc) {
+    uint32_t digest = ~crc;
+    return ((digest >> 15) | (digest << 17)) + c_crc32cMaskDelta;
+}
+
+} // namespace details
+} // namespace compression
+} // namespace xf
+
+#endif // _XFCOMPRESSION_CRC32C_HPP_
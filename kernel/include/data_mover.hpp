@@ -0,0 +1,508 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_DATA_MOVER_HPP_
+#define _XFCOMPRESSION_DATA_MOVER_HPP_
+
+/**
+ * @file data_mover.hpp
+ * @brief Parameterized multi-block data movers between AXI memory and streams.
+ *
+ * All movers share the same knobs:
+ *  - BURST_SIZE  : AXI burst length in DATAWIDTH words
+ *  - OUTSTANDING : bursts buffered per block, i.e. how many bursts a block
+ *                  may have requested ahead of its stream (1 = one burst at a time)
+ *  - INTERLEAVE  : bursts issued back to back for one block before moving on to
+ *                  the next block (1 = round robin per burst)
+ *
+ * OUTSTANDING = 1 and INTERLEAVE = 1 give the behaviour of the original
+ * mm2sNb / s2mmNb / s2mmEosNb modules.
+ *
+ * This file is part of Vitis Data Compression Library.
+ */
+#include "hls_stream.h"
+
+#include <ap_int.h>
+#include <stdint.h>
+
+namespace xf {
+namespace compression {
+namespace details {
+
+/**
+ * @brief Bandwidth counters accumulated by a data mover over one call.
+ *
+ * blockStallCycles is counted per block from the mover side of the block's
+ * stream: the reader counts cycles in which it held data for the block but
+ * the block's stream was full, the writer counts cycles in which the block
+ * was not finished but its stream was empty.
+ */
+template <int NUM_BLOCKS>
+struct moverCounters {
+    uint64_t bytes;                        // bytes moved over the AXI interface
+    uint32_t bursts;                       // AXI bursts issued
+    uint32_t cycles;                       // streaming cycles plus burst beats
+    uint32_t stallCycles;                  // streaming cycles in which no block could move a word
+    uint32_t blockStallCycles[NUM_BLOCKS]; // streaming cycles a block was held by its stream
+};
+
+template <int DATAWIDTH,
+          int BURST_SIZE,
+          int NUM_BLOCKS,
+          int OUTSTANDING = 1,
+          int INTERLEAVE = 1,
+          bool ROUND_OFF = false>
+void mm2sMover(const ap_uint<DATAWIDTH>* in,
+               const uint32_t _input_idx[NUM_BLOCKS],
+               hls::stream<ap_uint<DATAWIDTH> > outStream[NUM_BLOCKS],
+               const uint32_t _input_size[NUM_BLOCKS],
+               moverCounters<NUM_BLOCKS>& counters) {
+    /**
+     * @brief Reads NUM_BLOCKS independent regions from memory in bursts and
+     * streams each of them out on its own stream. Writing to the streams is
+     * non-blocking, a block whose stream is full does not hold the others.
+     *
+     * @tparam DATAWIDTH width of data bus
+     * @tparam BURST_SIZE burst size of the data transfers
+     * @tparam NUM_BLOCKS number of blocks
+     * @tparam OUTSTANDING bursts buffered per block
+     * @tparam INTERLEAVE bursts issued per block in one round
+     * @tparam ROUND_OFF start index is not word aligned, read from the word
+     * containing it (P2P decompression)
+     *
+     * @param in input memory address
+     * @param _input_idx byte index of each block
+     * @param outStream output streams
+     * @param _input_size byte size of each block
+     * @param counters bandwidth counters
+     */
+    const int c_byteSize = 8;
+    const int c_wordSize = DATAWIDTH / c_byteSize;
+    const int c_depth = OUTSTANDING * BURST_SIZE;
+
+    ap_uint<DATAWIDTH> local_buffer[NUM_BLOCKS][c_depth];
+#pragma HLS ARRAY_PARTITION variable = local_buffer dim = 1 complete
+#pragma HLS RESOURCE variable = local_buffer core = RAM_2P_LUTRAM
+    uint32_t read_idx[NUM_BLOCKS];
+    uint32_t write_idx[NUM_BLOCKS];
+    uint32_t fill[NUM_BLOCKS];
+    uint32_t read_size[NUM_BLOCKS];
+    uint32_t input_idx[NUM_BLOCKS];
+    uint32_t input_size[NUM_BLOCKS];
+#pragma HLS ARRAY_PARTITION variable = read_idx dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = write_idx dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = fill dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = read_size dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = input_idx dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = input_size dim = 0 complete
+
+    uint64_t bytes = 0;
+    uint32_t bursts = 0;
+    uint32_t cycles = 0;
+    uint32_t stall_cycles = 0;
+    uint32_t block_stall_cycles[NUM_BLOCKS];
+#pragma HLS ARRAY_PARTITION variable = block_stall_cycles dim = 0 complete
+
+    for (uint32_t bIdx = 0; bIdx < NUM_BLOCKS; bIdx++) {
+#pragma HLS UNROLL
+        read_idx[bIdx] = 0;
+        write_idx[bIdx] = 0;
+        fill[bIdx] = 0;
+        read_size[bIdx] = 0;
+        block_stall_cycles[bIdx] = 0;
+        input_idx[bIdx] = _input_idx[bIdx];
+        input_size[bIdx] = _input_size[bIdx];
+        if (ROUND_OFF) input_size[bIdx] += (input_idx[bIdx] % c_wordSize);
+    }
+
+    bool active = true;
+    while (active) {
+        // Fill free buffer space, up to INTERLEAVE bursts per block
+        for (uint32_t bIdx = 0; bIdx < NUM_BLOCKS; bIdx++) {
+            for (uint32_t n = 0; n < INTERLEAVE; n++) {
+                uint32_t pending_bytes = (input_size[bIdx] > read_size[bIdx]) ? (input_size[bIdx] - read_size[bIdx]) : 0;
+                if ((pending_bytes == 0) || ((c_depth - fill[bIdx]) < BURST_SIZE)) break;
+                uint32_t pending_words = (pending_bytes - 1) / c_wordSize + 1;
+                uint32_t burst_size = (pending_words > BURST_SIZE) ? BURST_SIZE : pending_words;
+                uint32_t mem_read_byte_idx = read_size[bIdx] + input_idx[bIdx];
+                uint32_t mem_read_word_idx;
+                if (ROUND_OFF)
+                    mem_read_word_idx = mem_read_byte_idx / c_wordSize;
+                else
+                    mem_read_word_idx = (mem_read_byte_idx) ? ((mem_read_byte_idx - 1) / c_wordSize + 1) : 0;
+            gmem_rd:
+                for (uint32_t i = 0; i < burst_size; i++) {
+#pragma HLS PIPELINE II = 1
+                    local_buffer[bIdx][write_idx[bIdx]] = in[mem_read_word_idx + i];
+                    write_idx[bIdx] = (write_idx[bIdx] == c_depth - 1) ? 0 : write_idx[bIdx] + 1;
+                }
+                fill[bIdx] += burst_size;
+                read_size[bIdx] += burst_size * c_wordSize;
+                bytes += burst_size * c_wordSize;
+                bursts++;
+                cycles += burst_size;
+            }
+        }
+
+        // Stream out until some block has room for another burst or all are drained
+        bool refill = false;
+        bool busy = true;
+    mm2s:
+        while ((refill == false) && busy) {
+#pragma HLS PIPELINE II = 1
+            bool moved = false;
+            for (uint8_t pb = 0; pb < NUM_BLOCKS; pb++) {
+#pragma HLS UNROLL
+                if (fill[pb] && !outStream[pb].full()) {
+                    outStream[pb] << local_buffer[pb][read_idx[pb]];
+                    read_idx[pb] = (read_idx[pb] == c_depth - 1) ? 0 : read_idx[pb] + 1;
+                    fill[pb] -= 1;
+                    moved = true;
+                } else if (fill[pb]) {
+                    block_stall_cycles[pb]++;
+                }
+            }
+            cycles++;
+            if (!moved) stall_cycles++;
+            busy = false;
+            for (uint8_t pb = 0; pb < NUM_BLOCKS; pb++) {
+#pragma HLS UNROLL
+                if (fill[pb]) busy = true;
+                if ((read_size[pb] < input_size[pb]) && ((c_depth - fill[pb]) >= BURST_SIZE)) refill = true;
+            }
+        }
+
+        active = false;
+        for (uint8_t pb = 0; pb < NUM_BLOCKS; pb++) {
+#pragma HLS UNROLL
+            if (fill[pb] || (read_size[pb] < input_size[pb])) active = true;
+        }
+    }
+
+    counters.bytes = bytes;
+    counters.bursts = bursts;
+    counters.cycles = cycles;
+    counters.stallCycles = stall_cycles;
+    for (uint8_t i = 0; i < NUM_BLOCKS; i++) {
+#pragma HLS UNROLL
+        counters.blockStallCycles[i] = block_stall_cycles[i];
+    }
+#ifdef CSIM_STREAM_STATS
+    // The stand-in streams do not see the m_axi beats
+    csim::streamStats::mover(cycles);
+#endif
+}
+
+template <int DATAWIDTH, int BURST_SIZE, int NUM_BLOCKS, int OUTSTANDING = 1, int INTERLEAVE = 1>
+void s2mmMover(ap_uint<DATAWIDTH>* out,
+               const uint32_t output_idx[NUM_BLOCKS],
+               hls::stream<ap_uint<DATAWIDTH> > inStream[NUM_BLOCKS],
+               const uint32_t input_size[NUM_BLOCKS],
+               moverCounters<NUM_BLOCKS>& counters) {
+    /**
+     * @brief Collects a known number of bytes from each of NUM_BLOCKS streams
+     * and writes them to memory in bursts. Reading from the streams is
+     * non-blocking, an empty stream does not hold the others.
+     *
+     * @tparam DATAWIDTH width of data bus
+     * @tparam BURST_SIZE burst size of the data transfers
+     * @tparam NUM_BLOCKS number of blocks
+     * @tparam OUTSTANDING bursts buffered per block
+     * @tparam INTERLEAVE bursts written per block in one round
+     *
+     * @param out output memory address
+     * @param output_idx byte index of each block, word aligned
+     * @param inStream input streams
+     * @param input_size byte size of each block
+     * @param counters bandwidth counters
+     */
+    const int c_byteSize = 8;
+    const int c_wordSize = DATAWIDTH / c_byteSize;
+    const int c_depth = OUTSTANDING * BURST_SIZE;
+
+    ap_uint<DATAWIDTH> local_buffer[NUM_BLOCKS][c_depth];
+#pragma HLS ARRAY_PARTITION variable = local_buffer dim = 1 complete
+#pragma HLS RESOURCE variable = local_buffer core = RAM_2P_LUTRAM
+    uint32_t total_words[NUM_BLOCKS];
+    uint32_t read_words[NUM_BLOCKS];
+    uint32_t write_words[NUM_BLOCKS];
+    uint32_t fill[NUM_BLOCKS];
+    uint32_t read_idx[NUM_BLOCKS];
+    uint32_t write_idx[NUM_BLOCKS];
+#pragma HLS ARRAY_PARTITION variable = total_words dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = read_words dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = write_words dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = fill dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = read_idx dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = write_idx dim = 0 complete
+
+    uint64_t bytes = 0;
+    uint32_t bursts = 0;
+    uint32_t cycles = 0;
+    uint32_t stall_cycles = 0;
+    uint32_t block_stall_cycles[NUM_BLOCKS];
+#pragma HLS ARRAY_PARTITION variable = block_stall_cycles dim = 0 complete
+
+    bool active = false;
+    for (uint8_t i = 0; i < NUM_BLOCKS; i++) {
+#pragma HLS UNROLL
+        total_words[i] = (input_size[i]) ? ((input_size[i] - 1) / c_wordSize + 1) : 0;
+        read_words[i] = 0;
+        write_words[i] = 0;
+        fill[i] = 0;
+        read_idx[i] = 0;
+        write_idx[i] = 0;
+        block_stall_cycles[i] = 0;
+        if (total_words[i]) active = true;
+    }
+
+    while (active) {
+        // Collect words until a block has a full buffer or all its remaining data
+        bool ready = false;
+    s2mm:
+        while (ready == false) {
+#pragma HLS PIPELINE II = 1
+            bool moved = false;
+            for (uint8_t pb = 0; pb < NUM_BLOCKS; pb++) {
+#pragma HLS UNROLL
+                if ((read_words[pb] < total_words[pb]) && (fill[pb] < c_depth)) {
+                    if (!inStream[pb].empty()) {
+                        local_buffer[pb][write_idx[pb]] = inStream[pb].read();
+                        write_idx[pb] = (write_idx[pb] == c_depth - 1) ? 0 : write_idx[pb] + 1;
+                        read_words[pb] += 1;
+                        fill[pb] += 1;
+                        moved = true;
+                    } else {
+                        block_stall_cycles[pb]++;
+                    }
+                }
+            }
+            cycles++;
+            if (!moved) stall_cycles++;
+            for (uint8_t pb = 0; pb < NUM_BLOCKS; pb++) {
+#pragma HLS UNROLL
+                uint32_t remaining = total_words[pb] - write_words[pb];
+                uint32_t target = (remaining > c_depth) ? c_depth : remaining;
+                if (remaining && (fill[pb] >= target)) ready = true;
+            }
+        }
+
+        // Write whole bursts, up to INTERLEAVE per block
+        for (uint32_t i = 0; i < NUM_BLOCKS; i++) {
+            for (uint32_t n = 0; n < INTERLEAVE; n++) {
+                uint32_t remaining = total_words[i] - write_words[i];
+                uint32_t burst_size = (remaining > BURST_SIZE) ? BURST_SIZE : remaining;
+                if ((burst_size == 0) || (fill[i] < burst_size)) break;
+                uint32_t base_idx = output_idx[i] / c_wordSize + write_words[i];
+            gmem_wr:
+                for (uint32_t j = 0; j < burst_size; j++) {
+#pragma HLS PIPELINE II = 1
+                    out[base_idx + j] = local_buffer[i][read_idx[i]];
+                    read_idx[i] = (read_idx[i] == c_depth - 1) ? 0 : read_idx[i] + 1;
+                }
+                fill[i] -= burst_size;
+                write_words[i] += burst_size;
+                bytes += burst_size * c_wordSize;
+                bursts++;
+                cycles += burst_size;
+            }
+        }
+
+        active = false;
+        for (uint8_t i = 0; i < NUM_BLOCKS; i++) {
+#pragma HLS UNROLL
+            if (write_words[i] < total_words[i]) active = true;
+        }
+    }
+
+    counters.bytes = bytes;
+    counters.bursts = bursts;
+    counters.cycles = cycles;
+    counters.stallCycles = stall_cycles;
+    for (uint8_t i = 0; i < NUM_BLOCKS; i++) {
+#pragma HLS UNROLL
+        counters.blockStallCycles[i] = block_stall_cycles[i];
+    }
+#ifdef CSIM_STREAM_STATS
+    // The writer is the last process of a dataflow call in C simulation
+    csim::streamStats::mover(cycles);
+    csim::streamStats::endCall();
+#endif
+}
+
+template <int DATAWIDTH, int BURST_SIZE, int NUM_BLOCKS, int OUTSTANDING = 1, int INTERLEAVE = 1>
+void s2mmEosMover(ap_uint<DATAWIDTH>* out,
+                  const uint32_t output_idx[NUM_BLOCKS],
+                  hls::stream<ap_uint<DATAWIDTH> > inStream[NUM_BLOCKS],
+                  hls::stream<bool> endOfStream[NUM_BLOCKS],
+                  moverCounters<NUM_BLOCKS>& counters) {
+    /**
+     * @brief Same as s2mmMover but the amount of data per block is not known
+     * up front, each block ends when its end of stream flag is read. The data
+     * word that comes with the end of stream flag is discarded.
+     *
+     * @tparam DATAWIDTH width of data bus
+     * @tparam BURST_SIZE burst size of the data transfers
+     * @tparam NUM_BLOCKS number of blocks
+     * @tparam OUTSTANDING bursts buffered per block
+     * @tparam INTERLEAVE bursts written per block in one round
+     *
+     * @param out output memory address
+     * @param output_idx byte index of each block, word aligned
+     * @param inStream input streams
+     * @param endOfStream end flag for each stream
+     * @param counters bandwidth counters
+     */
+    const int c_byteSize = 8;
+    const int c_wordSize = DATAWIDTH / c_byteSize;
+    const int c_depth = OUTSTANDING * BURST_SIZE;
+
+    ap_uint<DATAWIDTH> local_buffer[NUM_BLOCKS][c_depth];
+#pragma HLS ARRAY_PARTITION variable = local_buffer dim = 1 complete
+#pragma HLS RESOURCE variable = local_buffer core = RAM_2P_LUTRAM
+    uint32_t write_words[NUM_BLOCKS];
+    uint32_t fill[NUM_BLOCKS];
+    uint32_t read_idx[NUM_BLOCKS];
+    uint32_t write_idx[NUM_BLOCKS];
+#pragma HLS ARRAY_PARTITION variable = write_words dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = fill dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = read_idx dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = write_idx dim = 0 complete
+    ap_uint<NUM_BLOCKS> end_of_stream = 0;
+
+    uint64_t bytes = 0;
+    uint32_t bursts = 0;
+    uint32_t cycles = 0;
+    uint32_t stall_cycles = 0;
+    uint32_t block_stall_cycles[NUM_BLOCKS];
+#pragma HLS ARRAY_PARTITION variable = block_stall_cycles dim = 0 complete
+
+    for (uint8_t i = 0; i < NUM_BLOCKS; i++) {
+#pragma HLS UNROLL
+        write_words[i] = 0;
+        fill[i] = 0;
+        read_idx[i] = 0;
+        write_idx[i] = 0;
+        block_stall_cycles[i] = 0;
+    }
+
+    bool active = true;
+    while (active) {
+        // Collect words until a block has a full buffer or has ended with data left
+        bool ready = false;
+    s2mm_eos:
+        while (ready == false) {
+#pragma HLS PIPELINE II = 1
+            bool moved = false;
+            for (uint8_t pb = 0; pb < NUM_BLOCKS; pb++) {
+#pragma HLS UNROLL
+                if (!end_of_stream.range(pb, pb) && (fill[pb] < c_depth)) {
+                    if (!endOfStream[pb].empty()) {
+                        bool eos_flag = endOfStream[pb].read();
+                        ap_uint<DATAWIDTH> word = inStream[pb].read();
+                        if (eos_flag) {
+                            end_of_stream.range(pb, pb) = 1;
+                        } else {
+                            local_buffer[pb][write_idx[pb]] = word;
+                            write_idx[pb] = (write_idx[pb] == c_depth - 1) ? 0 : write_idx[pb] + 1;
+                            fill[pb] += 1;
+                        }
+                        moved = true;
+                    } else {
+                        block_stall_cycles[pb]++;
+                    }
+                }
+            }
+            cycles++;
+            if (!moved) stall_cycles++;
+            if (end_of_stream.and_reduce()) ready = true;
+            for (uint8_t pb = 0; pb < NUM_BLOCKS; pb++) {
+#pragma HLS UNROLL
+                if ((fill[pb] >= c_depth) || (end_of_stream.range(pb, pb) && fill[pb])) ready = true;
+            }
+        }
+
+        // Write whole bursts, or the tail of an ended block, up to INTERLEAVE per block
+        for (uint32_t i = 0; i < NUM_BLOCKS; i++) {
+            for (uint32_t n = 0; n < INTERLEAVE; n++) {
+                uint32_t burst_size = (fill[i] > BURST_SIZE) ? BURST_SIZE : fill[i];
+                if ((burst_size == 0) || ((burst_size < BURST_SIZE) && !end_of_stream.range(i, i))) break;
+                uint32_t base_idx = output_idx[i] / c_wordSize + write_words[i];
+            gmem_wr:
+                for (uint32_t j = 0; j < burst_size; j++) {
+#pragma HLS PIPELINE II = 1
+                    out[base_idx + j] = local_buffer[i][read_idx[i]];
+                    read_idx[i] = (read_idx[i] == c_depth - 1) ? 0 : read_idx[i] + 1;
+                }
+                fill[i] -= burst_size;
+                write_words[i] += burst_size;
+                bytes += burst_size * c_wordSize;
+                bursts++;
+                cycles += burst_size;
+            }
+        }
+
+        active = false;
+        for (uint8_t i = 0; i < NUM_BLOCKS; i++) {
+#pragma HLS UNROLL
+            if (!end_of_stream.range(i, i) || fill[i]) active = true;
+        }
+    }
+
+    counters.bytes = bytes;
+    counters.bursts = bursts;
+    counters.cycles = cycles;
+    counters.stallCycles = stall_cycles;
+    for (uint8_t i = 0; i < NUM_BLOCKS; i++) {
+#pragma HLS UNROLL
+        counters.blockStallCycles[i] = block_stall_cycles[i];
+    }
+#ifdef CSIM_STREAM_STATS
+    // The writer is the last process of a dataflow call in C simulation
+    csim::streamStats::mover(cycles);
+    csim::streamStats::endCall();
+#endif
+}
+
+template <int DATAWIDTH, int BURST_SIZE, int NUM_BLOCKS, int OUTSTANDING = 1, int INTERLEAVE = 1>
+void s2mmEosMover(ap_uint<DATAWIDTH>* out,
+                  const uint32_t output_idx[NUM_BLOCKS],
+                  hls::stream<ap_uint<DATAWIDTH> > inStream[NUM_BLOCKS],
+                  hls::stream<bool> endOfStream[NUM_BLOCKS],
+                  hls::stream<uint32_t> sizeStream[NUM_BLOCKS],
+                  uint32_t output_size[NUM_BLOCKS],
+                  moverCounters<NUM_BLOCKS>& counters) {
+    /**
+     * @brief s2mmEosMover that also returns the byte size of each block,
+     * which the producer sends on sizeStream once the block has ended.
+     *
+     * @param sizeStream byte size of each block
+     * @param output_size byte size of each block
+     */
+    s2mmEosMover<DATAWIDTH, BURST_SIZE, NUM_BLOCKS, OUTSTANDING, INTERLEAVE>(out, output_idx, inStream, endOfStream,
+                                                                            counters);
+
+    for (uint8_t i = 0; i < NUM_BLOCKS; i++) {
+#pragma HLS PIPELINE II = 1
+        output_size[i] = sizeStream[i].read();
+    }
+}
+
+} // namespace details
+} // namespace compression
+} // namespace xf
+
+#endif // _XFCOMPRESSION_DATA_MOVER_HPP_
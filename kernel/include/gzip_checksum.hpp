@@ -0,0 +1,92 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_GZIP_CHECKSUM_HPP_
+#define _XFCOMPRESSION_GZIP_CHECKSUM_HPP_
+
+/**
+ * @file gzip_checksum.hpp
+ * @brief Streaming CRC32 (gzip trailer) and Adler32 (zlib trailer).
+ *
+ * Both take up to 8 bytes per update. The CRC runs bit by bit over the
+ * bytes, which unrolls into an XOR network of the 64 input bits, Adler32
+ * reduces its sums modulo 65521 after every update.
+ *
+ * This file is part of Vitis Data Compression Library.
+ */
+#include <ap_int.h>
+#include <stdint.h>
+
+namespace xf {
+namespace compression {
+namespace details {
+
+const uint32_t c_crc32Poly = 0xEDB88320;
+const uint32_t c_adler32Mod = 65521;
+
+// Running checksum of a gzip member (CRC32) or zlib stream (Adler32)
+struct gzipChecksumState {
+    uint32_t crc;
+    uint32_t adlerA;
+    uint32_t adlerB;
+};
+
+inline void gzipChecksumReset(gzipChecksumState& state) {
+    state.crc = 0xFFFFFFFF;
+    state.adlerA = 1;
+    state.adlerB = 0;
+}
+
+/**
+ * @brief Appends the low bytes (1 ~ 8) of word to the checksum.
+ *
+ * @param adler update Adler32 instead of CRC32
+ */
+inline void gzipChecksumUpdate(gzipChecksumState& state, ap_uint<64> word, uint32_t bytes, bool adler) {
+#pragma HLS INLINE
+    uint32_t crc = state.crc;
+    uint32_t a = state.adlerA;
+    uint32_t b = state.adlerB;
+    for (int i = 0; i < 8; i++) {
+#pragma HLS UNROLL
+        if (i < bytes) {
+            uint8_t byte = word.range(i * 8 + 7, i * 8);
+            crc ^= byte;
+            for (int k = 0; k < 8; k++) {
+#pragma HLS UNROLL
+                crc = (crc & 1) ? (crc >> 1) ^ c_crc32Poly : (crc >> 1);
+            }
+            a += byte;
+            b += a;
+        }
+    }
+    if (adler) {
+        state.adlerA = a % c_adler32Mod;
+        state.adlerB = b % c_adler32Mod;
+    } else {
+        state.crc = crc;
+    }
+}
+
+inline uint32_t gzipChecksumDigest(const gzipChecksumState& state, bool adler) {
+    return adler ? ((state.adlerB << 16) | state.adlerA) : ~state.crc;
+}
+
+} // namespace details
+} // namespace compression
+} // namespace xf
+
+#endif // _XFCOMPRESSION_GZIP_CHECKSUM_HPP_
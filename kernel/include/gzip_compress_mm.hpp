@@ -0,0 +1,118 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_GZIP_COMPRESS_MM_HPP_
+#define _XFCOMPRESSION_GZIP_COMPRESS_MM_HPP_
+
+/**
+ * @file gzip_compress_mm.hpp
+ * @brief Header for Deflate (GZIP/zlib) compression kernel.
+ *
+ * This file is part of Vitis Data Compression Library.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <assert.h>
+#include "hls_stream.h"
+#include <ap_int.h>
+
+#include "lz_compress.hpp"
+#include "lz_optional.hpp"
+#include "mm2s.hpp"
+#include "s2mm.hpp"
+#include "stream_downsizer.hpp"
+#include "stream_upsizer.hpp"
+
+#include "huffman_treegen.hpp"
+#include "huffman_encoder.hpp"
+#include "gzip_checksum.hpp"
+#include "lz4_p2p.hpp"
+#include "kernel_stats.hpp"
+
+#define MIN_BLOCK_SIZE 128
+#define GMEM_DWIDTH 512
+#ifndef GMEM_BURST_SIZE
+#define GMEM_BURST_SIZE 16
+#endif
+// Bursts buffered per block and bursts issued per block in one round by the data movers
+#ifndef GMEM_OUTSTANDING
+#define GMEM_OUTSTANDING 1
+#endif
+#ifndef GMEM_INTERLEAVE
+#define GMEM_INTERLEAVE 1
+#endif
+// Outstanding bursts of the in / out m_axi ports, as many as the data movers buffer
+#ifndef GMEM_AXI_OUTSTANDING
+#define GMEM_AXI_OUTSTANDING (GMEM_OUTSTANDING * PARALLEL_BLOCK)
+#endif
+// Deflate window and match lengths; the symbols carry 8 bit lengths, so
+// matches stop at 255 instead of 258
+#define LZ_MAX_OFFSET_LIMIT 32768
+#define MIN_MATCH 3
+#define MAX_MATCH_LEN 255
+#define OFFSET_WINDOW (32 * 1024)
+#define MATCH_LEN 6
+
+#if (PARALLEL_BLOCK > GZIP_MAX_ENGINES)
+#error "PARALLEL_BLOCK does not fit in the symbol buffer sized for GZIP_MAX_ENGINES"
+#endif
+#if defined(KERNEL_STATS) && (PARALLEL_BLOCK > MAX_STATS_ENGINES)
+#error "PARALLEL_BLOCK does not fit in dt_kernelStats"
+#endif
+
+// Kernel top functions
+extern "C" {
+/**
+ * @brief Deflate compression kernel takes the raw data as input and
+ * compresses every block into Deflate blocks, which xilGzipPacker puts in a
+ * gzip member or zlib stream. Each block is compressed on its own (no
+ * matches across blocks) and its Deflate blocks end on a byte boundary.
+ *
+ * The engines of a batch run the LZ77 front end of xilLz4Compress with the
+ * Deflate window and lz77Divide, which counts the symbol frequencies; the
+ * symbols go to lz77_out. The Huffman trees of every block are then built
+ * from the frequencies (deflateTreegen) and the symbols are read back and
+ * encoded (deflateHuffman).
+ *
+ * @param in input raw data
+ * @param out output compressed data, one block_size_in_kb stride per block
+ * @param compressd_size compressed output size of each block, the block size for blocks
+ * the packer stores (MIN_BLOCK_SIZE or not smaller with Huffman coding)
+ * @param block_desc input blocks, the blocks of a file consecutive and in order
+ * @param lz77_out LZ77 symbols of a batch, GZIP_SYMBOL_BYTES x block size per engine
+ * @param content_checksum CRC32, or Adler32 with FRAME_ZLIB, of every file, indexed by file id
+ * @param block_size_in_kb input block size in KB
+ * @param no_blocks number of entries in block_desc
+ * @param frame_flags FRAME_ZLIB or 0
+ * @param stats statistics record of this invocation (KERNEL_STATS builds only)
+ */
+void xilGzipCompress(const xf::compression::uintMemWidth_t* in,
+                     xf::compression::uintMemWidth_t* out,
+                     uint32_t* compressd_size,
+                     dt_blockDesc* block_desc,
+                     xf::compression::uintMemWidth_t* lz77_out,
+                     uint32_t* content_checksum,
+                     uint32_t block_size_in_kb,
+                     uint32_t no_blocks,
+                     uint32_t frame_flags
+#ifdef KERNEL_STATS
+                     ,
+                     dt_kernelStats* stats
+#endif
+                     );
+}
+#endif // _XFCOMPRESSION_GZIP_COMPRESS_MM_HPP_
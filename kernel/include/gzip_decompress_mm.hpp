@@ -0,0 +1,84 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_GZIP_DECOMPRESS_MM_HPP_
+#define _XFCOMPRESSION_GZIP_DECOMPRESS_MM_HPP_
+
+/**
+ * @file gzip_decompress_mm.hpp
+ * @brief Header for Deflate (GZIP/zlib) decompression kernel.
+ *
+ * This file is part of Vitis Data Compression Library.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <assert.h>
+#include "hls_stream.h"
+#include <ap_int.h>
+
+#include "lz_decompress.hpp"
+#include "mm2s.hpp"
+#include "s2mm.hpp"
+#include "stream_downsizer.hpp"
+#include "stream_upsizer.hpp"
+
+#include "huffman_decoder.hpp"
+#include "gzip_checksum.hpp"
+#include "lz4_p2p.hpp"
+#include "kernel_stats.hpp"
+
+#define GMEM_DWIDTH 512
+#ifndef GMEM_BURST_SIZE
+#define GMEM_BURST_SIZE 16
+#endif
+// Deflate window
+#define INFLATE_HISTORY_SIZE 32768
+
+// Kernel top functions
+extern "C" {
+/**
+ * @brief Deflate decompression kernel takes one gzip member or zlib stream
+ * and writes its content. A Deflate stream has no block boundaries to split
+ * it on, so there is one engine: the Huffman decoder (inflateHuffman) feeds
+ * lzDecompressZlibEos, which writes a byte per cycle, and the content is
+ * checked against the trailer on its way to memory.
+ *
+ * Content past output_size is decoded and counted but not written: the
+ * host sizes the output from the gzip ISIZE or an estimate and runs the
+ * file again with a larger buffer when result[0] is above it.
+ *
+ * @param in input gzip member or zlib stream
+ * @param out output content
+ * @param result content size, then the INFLATE_* status
+ * @param input_size bytes of the input
+ * @param output_size bytes of the output buffer
+ * @param frame_flags FRAME_ZLIB or 0
+ * @param stats statistics record of this invocation (KERNEL_STATS builds only)
+ */
+void xilGzipDecompress(const xf::compression::uintMemWidth_t* in,
+                       xf::compression::uintMemWidth_t* out,
+                       uint32_t* result,
+                       uint32_t input_size,
+                       uint32_t output_size,
+                       uint32_t frame_flags
+#ifdef KERNEL_STATS
+                       ,
+                       dt_kernelStats* stats
+#endif
+                       );
+}
+#endif // _XFCOMPRESSION_GZIP_DECOMPRESS_MM_HPP_
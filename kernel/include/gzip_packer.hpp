@@ -0,0 +1,155 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_GZIP_PACKER_HPP_
+#define _XFCOMPRESSION_GZIP_PACKER_HPP_
+
+/**
+ * @file gzip_packer.hpp
+ * @brief Header for module used in GZIP packer kernel.
+ *
+ * This file is part of Vitis Data Compression Library.
+ */
+
+#include "hls_stream.h"
+
+#include <ap_int.h>
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+
+namespace xf {
+namespace compression {
+
+/**
+ * @brief Packs the Deflate blocks of one file into a gzip member or zlib
+ * stream. The header comes first on the input stream, as made by the host,
+ * then the blocks from xilGzipCompress, which end on byte boundaries and
+ * are copied as they are. Stored input blocks (bit 31 of their size) are
+ * written as stored Deflate blocks of up to GZIP_STORED_CHUNK bytes
+ * (lz4_p2p.hpp). The stream ends with an empty final static block and the
+ * trailer: CRC32 and size (LE) for gzip, Adler32 (BE) for zlib.
+ *
+ * @tparam PACK_WIDTH packed data width
+ * @tparam PARLLEL_BYTE parallel byte count
+ *
+ * @param inStream input data, header first
+ * @param outStream output data
+ * @param inStreamSize size of the data in input stream
+ * @param outStreamSize output words of every part
+ * @param no_blocks number of input blocks
+ * @param zlib write the zlib trailer instead of the gzip one
+ * @param checksum CRC32 (gzip) or Adler32 (zlib) of the content
+ * @param isize content size
+ * @return bytes of the gzip member or zlib stream
+ */
+template <int PACK_WIDTH, int PARLLEL_BYTE>
+uint32_t gzipPacker(hls::stream<ap_uint<PACK_WIDTH> >& inStream,
+                    hls::stream<ap_uint<PACK_WIDTH> >& outStream,
+                    hls::stream<uint32_t>& inStreamSize,
+                    hls::stream<uint32_t>& outStreamSize,
+                    uint32_t no_blocks,
+                    bool zlib,
+                    uint32_t checksum,
+                    uint32_t isize) {
+    const uint32_t c_storedHeader = 5;
+    ap_uint<2 * PACK_WIDTH> lcl_buffer = 0;
+    uint32_t lbuf_idx = 0;
+    uint32_t endSizeCnt = 0;
+
+packer:
+    for (uint32_t blkIdx = 0; blkIdx < no_blocks + 1; blkIdx++) {
+        uint32_t block_header = inStreamSize.read();
+        uint32_t size = block_header & 0x7FFFFFFF;
+        bool stored = (blkIdx != 0) && (block_header & 0x80000000);
+        uint32_t chunk = stored ? GZIP_STORED_CHUNK : size;
+        uint32_t headers = stored ? c_storedHeader * ((size - 1) / GZIP_STORED_CHUNK + 1) : 0;
+
+        uint32_t sizeOutput = (lbuf_idx + headers + size) / 8;
+        if (sizeOutput) outStreamSize << sizeOutput;
+        endSizeCnt += headers + size;
+
+    chunks:
+        for (uint32_t c = 0; c < size; c += chunk) {
+            uint32_t len = (c + chunk > size) ? size - c : chunk;
+            if (stored) {
+                // BFINAL 0, BTYPE 00, aligned, then LEN and NLEN
+                uint16_t nlen = ~len;
+                ap_uint<40> head = nlen;
+                head = (head << 16) | len;
+                head <<= 8;
+                lcl_buffer.range((lbuf_idx * 8) + 39, lbuf_idx * 8) = head;
+                lbuf_idx += c_storedHeader;
+                if (lbuf_idx >= 8) {
+                    outStream << lcl_buffer.range(63, 0);
+                    lcl_buffer >>= PACK_WIDTH;
+                    lbuf_idx -= 8;
+                }
+            }
+        pack_post:
+            for (uint32_t i = 0; i < len; i += PARLLEL_BYTE) {
+#pragma HLS PIPELINE II = 1
+                uint32_t chunk_size = (i + PARLLEL_BYTE > len) ? len - i : PARLLEL_BYTE;
+                lcl_buffer.range((lbuf_idx * 8) + PACK_WIDTH - 1, lbuf_idx * 8) = inStream.read();
+                lbuf_idx += chunk_size;
+                if (lbuf_idx >= 8) {
+                    outStream << lcl_buffer.range(63, 0);
+                    lcl_buffer >>= PACK_WIDTH;
+                    lbuf_idx -= 8;
+                }
+            }
+        }
+    }
+
+    // Final empty static block (BFINAL 1, BTYPE 01, end of block), then the trailer
+    uint8_t tail[10];
+    uint32_t tail_bytes = 0;
+    tail[tail_bytes++] = 0x03;
+    tail[tail_bytes++] = 0x00;
+    for (int b = 0; b < 4; b++) {
+#pragma HLS UNROLL
+        tail[tail_bytes++] = zlib ? (uint8_t)(checksum >> (24 - b * 8)) : (uint8_t)(checksum >> (b * 8));
+    }
+    if (!zlib) {
+        for (int b = 0; b < 4; b++) {
+#pragma HLS UNROLL
+            tail[tail_bytes++] = isize >> (b * 8);
+        }
+    }
+    endSizeCnt += tail_bytes;
+
+    outStreamSize << (lbuf_idx + tail_bytes + 7) / 8;
+pack_tail:
+    for (uint32_t b = 0; b < tail_bytes; b++) {
+#pragma HLS PIPELINE II = 1
+        lcl_buffer.range((lbuf_idx * 8) + 7, lbuf_idx * 8) = tail[b];
+        lbuf_idx++;
+        if (lbuf_idx == 8) {
+            outStream << lcl_buffer.range(63, 0);
+            lcl_buffer >>= PACK_WIDTH;
+            lbuf_idx = 0;
+        }
+    }
+    if (lbuf_idx) outStream << lcl_buffer.range(63, 0);
+
+    // Termination condition of next block
+    outStreamSize << 0;
+    return endSizeCnt;
+}
+
+} // namespace compression
+} // namespace xf
+#endif // _XFCOMPRESSION_GZIP_PACKER_HPP_
@@ -0,0 +1,89 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_GZIP_PACKER_MM_HPP_
+#define _XFCOMPRESSION_GZIP_PACKER_MM_HPP_
+
+/**
+ * @file gzip_packer_mm.hpp
+ * @brief Header for GZIP packer kernel.
+ *
+ * This file is part of Vitis Data Compression Library.
+ */
+
+#include "hls_stream.h"
+#include <ap_int.h>
+
+#include "mm2s.hpp"
+#include "s2mm.hpp"
+#include "stream_downsizer.hpp"
+#include "stream_upsizer.hpp"
+#include "lz4_p2p.hpp"
+#include "gzip_packer.hpp"
+#include "kernel_stats.hpp"
+
+#define GMEM_DWIDTH 512
+#ifndef GMEM_BURST_SIZE
+#define GMEM_BURST_SIZE 16
+#endif
+#define PACK_WIDTH 64  // packer width
+#define PARLLEL_BYTE 8 // byte length
+
+const int c_gmem_burst_size = (2 * GMEM_BURST_SIZE);
+
+typedef ap_uint<GMEM_DWIDTH> uint512_t;
+typedef ap_uint<PACK_WIDTH> uintV_t; // 64bit input stream
+
+// Kernel top functions
+extern "C" {
+/**
+ * @brief GZIP packer kernel takes the Deflate blocks of xilGzipCompress and
+ * writes a gzip member, or a zlib stream with FRAME_ZLIB, per file at the
+ * frameOffset of its blocks, and its size in encoded_size[fileId].
+ *
+ * @param in Deflate blocks of xilGzipCompress
+ * @param out output compressed data
+ * @param head_prev_blk gzip or zlib header of every file, one 64 byte word per file id
+ * @param compressd_size compressed output size of each block
+ * @param block_desc input blocks, the blocks of a file consecutive and in order
+ * @param encoded_size member size of each file, indexed by file id
+ * @param orig_input_data raw input data, for the stored blocks
+ * @param content_checksum CRC32 or Adler32 of every file from xilGzipCompress
+ * @param head_res_size size of the header
+ * @param block_size_in_kb input block size in KB
+ * @param no_blocks number of entries in block_desc
+ * @param frame_flags FRAME_ZLIB or 0
+ * @param stats statistics record of this invocation (KERNEL_STATS builds only)
+ */
+void xilGzipPacker(const uint512_t* in,
+                   uint512_t* out,
+                   uint512_t* head_prev_blk,
+                   uint32_t* compressd_size,
+                   dt_blockDesc* block_desc,
+                   uint32_t* encoded_size,
+                   uint512_t* orig_input_data,
+                   uint32_t* content_checksum,
+                   uint32_t head_res_size,
+                   uint32_t block_size_in_kb,
+                   uint32_t no_blocks,
+                   uint32_t frame_flags
+#ifdef KERNEL_STATS
+                   ,
+                   dt_kernelStats* stats
+#endif
+                   );
+}
+#endif // _XFCOMPRESSION_GZIP_PACKER_MM_HPP_
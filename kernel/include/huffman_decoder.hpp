@@ -0,0 +1,464 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_HUFFMAN_DECODER_HPP_
+#define _XFCOMPRESSION_HUFFMAN_DECODER_HPP_
+
+/**
+ * @file huffman_decoder.hpp
+ * @brief Deflate front end of the inflater: gzip/zlib header, stored, static
+ * and dynamic blocks into the literal/match stream of lzDecompressZlibEos.
+ *
+ * Codes are decoded canonically: the codes of one length are consecutive,
+ * so the next DEFLATE_MAX_BITS bits of the stream (bit reversed, Deflate
+ * sends Huffman codes MSB first) are compared against the first code and the
+ * code count of every length at once and the shortest length that holds
+ * them picks the symbol. No lookup table of 2^15 entries is needed, the
+ * tables of a block are filled while its header is read.
+ *
+ * This file is part of Vitis Data Compression Library.
+ */
+#include "hls_stream.h"
+#include <ap_int.h>
+#include <stdint.h>
+#include "huffman_treegen.hpp"
+#include "lz_decompress.hpp"
+
+// Literal/length and distance symbols a stream may code, 286/287 and 30/31
+// have static codes but never occur
+#define INFLATE_LITERAL_SYMBOLS 288
+#define INFLATE_DISTANCE_SYMBOLS 32
+
+namespace xf {
+namespace compression {
+
+/**
+ * Canonical Huffman code of one alphabet: the count[l] codes of length l
+ * start at first[l] and code first[l] + k is symbols[offset[l] + k].
+ */
+template <int MAX_SYMBOLS>
+struct inflateTable {
+    uint16_t count[DEFLATE_MAX_BITS + 1];
+    uint16_t first[DEFLATE_MAX_BITS + 1];
+    uint16_t offset[DEFLATE_MAX_BITS + 1];
+    uint16_t symbols[MAX_SYMBOLS];
+};
+
+/**
+ * Bit reader over the 64 bit input words, LSB first. The words of the stream
+ * are counted so that a truncated or corrupt stream reads zeros past its end
+ * (and sets overrun) instead of waiting on the input.
+ */
+struct inflateBits {
+    ap_uint<128> buffer;
+    uint32_t bits;      // valid bits in buffer
+    uint32_t wordsLeft; // words still on the input stream
+    bool overrun;       // bits were taken past the end of the stream
+};
+
+inline void inflateRefill(hls::stream<ap_uint<64> >& inStream, inflateBits& br) {
+#pragma HLS INLINE
+    if (br.bits <= 64 && br.wordsLeft) {
+        br.buffer.range(br.bits + 63, br.bits) = inStream.read();
+        br.bits += 64;
+        br.wordsLeft--;
+    }
+}
+
+inline void inflateDrop(inflateBits& br, uint32_t n) {
+#pragma HLS INLINE
+    if (n > br.bits) {
+        br.overrun = true;
+        br.bits = 0;
+    } else {
+        br.bits -= n;
+    }
+    br.buffer >>= n;
+}
+
+// Takes the next n (0 ~ 32) bits, refill first when more than 64 may be needed
+inline uint32_t inflateGet(inflateBits& br, uint32_t n) {
+#pragma HLS INLINE
+    uint64_t mask = ((uint64_t)1 << n) - 1;
+    uint32_t value = (uint64_t)br.buffer.range(63, 0) & mask;
+    inflateDrop(br, n);
+    return value;
+}
+
+/**
+ * @brief Fills the decode table of an alphabet from its code lengths.
+ *
+ * @return false for an over-subscribed set of lengths
+ */
+template <int MAX_SYMBOLS>
+bool inflateBuildTable(const uint8_t* length, uint32_t num_symbols, inflateTable<MAX_SYMBOLS>& table) {
+    uint16_t next[DEFLATE_MAX_BITS + 1];
+    for (int l = 0; l <= DEFLATE_MAX_BITS; l++) {
+#pragma HLS UNROLL
+        table.count[l] = 0;
+    }
+count_lengths:
+    for (uint32_t s = 0; s < num_symbols; s++) {
+#pragma HLS PIPELINE II = 1
+        table.count[length[s]]++;
+    }
+    table.count[0] = 0;
+
+    int32_t left = 1;
+    uint16_t code = 0;
+    uint16_t offset = 0;
+    for (int l = 1; l <= DEFLATE_MAX_BITS; l++) {
+#pragma HLS UNROLL
+        left = (left << 1) - table.count[l];
+        if (left < 0) return false;
+        code = (code + table.count[l - 1]) << 1;
+        table.first[l] = code;
+        table.offset[l] = offset;
+        next[l] = offset;
+        offset += table.count[l];
+    }
+
+sort_symbols:
+    for (uint32_t s = 0; s < num_symbols; s++) {
+#pragma HLS PIPELINE II = 1
+        if (length[s]) table.symbols[next[length[s]]++] = s;
+    }
+    return true;
+}
+
+/**
+ * @brief Decodes the next symbol of an alphabet.
+ *
+ * @param error set when no code of the table starts the stream
+ */
+template <int MAX_SYMBOLS>
+uint16_t inflateDecode(inflateBits& br, const inflateTable<MAX_SYMBOLS>& table, bool& error) {
+#pragma HLS INLINE
+    ap_uint<DEFLATE_MAX_BITS> window = br.buffer.range(DEFLATE_MAX_BITS - 1, 0);
+    ap_uint<DEFLATE_MAX_BITS> reversed;
+    for (int i = 0; i < DEFLATE_MAX_BITS; i++) {
+#pragma HLS UNROLL
+        reversed[i] = window[DEFLATE_MAX_BITS - 1 - i];
+    }
+
+    uint32_t len = 0;
+    uint16_t index = 0;
+    for (int l = DEFLATE_MAX_BITS; l >= 1; l--) {
+#pragma HLS UNROLL
+        uint16_t code = reversed >> (DEFLATE_MAX_BITS - l);
+        uint16_t k = code - table.first[l];
+        if (k < table.count[l]) {
+            len = l;
+            index = table.offset[l] + k;
+        }
+    }
+    if (len == 0) {
+        error = true;
+        return 0;
+    }
+    inflateDrop(br, len);
+    return table.symbols[index];
+}
+
+/**
+ * @brief Static Huffman codes of RFC 1951 3.2.6.
+ */
+inline void inflateStaticTables(inflateTable<INFLATE_LITERAL_SYMBOLS>& lit,
+                                inflateTable<INFLATE_DISTANCE_SYMBOLS>& dist) {
+    uint8_t length[INFLATE_LITERAL_SYMBOLS];
+    for (uint32_t s = 0; s < INFLATE_LITERAL_SYMBOLS; s++) {
+#pragma HLS PIPELINE II = 1
+        length[s] = (s < 144) ? 8 : (s < 256) ? 9 : (s < 280) ? 7 : 8;
+    }
+    inflateBuildTable<INFLATE_LITERAL_SYMBOLS>(length, INFLATE_LITERAL_SYMBOLS, lit);
+    for (uint32_t s = 0; s < INFLATE_DISTANCE_SYMBOLS; s++) {
+#pragma HLS UNROLL
+        length[s] = 5;
+    }
+    inflateBuildTable<INFLATE_DISTANCE_SYMBOLS>(length, INFLATE_DISTANCE_SYMBOLS, dist);
+}
+
+/**
+ * @brief Reads the header of a dynamic block (HLIT, HDIST, HCLEN, the code
+ * length code and the run length coded code lengths) and fills its tables.
+ *
+ * @return false for a malformed header
+ */
+inline bool inflateDynamicTables(hls::stream<ap_uint<64> >& inStream,
+                                 inflateBits& br,
+                                 inflateTable<INFLATE_LITERAL_SYMBOLS>& lit,
+                                 inflateTable<INFLATE_DISTANCE_SYMBOLS>& dist) {
+    inflateTable<DEFLATE_BL_CODES> blTable;
+    uint8_t blLength[DEFLATE_BL_CODES];
+    uint8_t length[DEFLATE_LITERAL_CODES + DEFLATE_DISTANCE_CODES];
+
+    inflateRefill(inStream, br);
+    uint32_t hlit = inflateGet(br, 5) + 257;
+    uint32_t hdist = inflateGet(br, 5) + 1;
+    uint32_t hclen = inflateGet(br, 4) + 4;
+    if (hlit > DEFLATE_LITERAL_CODES || hdist > DEFLATE_DISTANCE_CODES) return false;
+
+bl_lengths:
+    for (uint32_t i = 0; i < DEFLATE_BL_CODES; i++) {
+#pragma HLS PIPELINE II = 1
+        inflateRefill(inStream, br);
+        blLength[bl_order[i]] = (i < hclen) ? inflateGet(br, 3) : 0;
+    }
+    if (!inflateBuildTable<DEFLATE_BL_CODES>(blLength, DEFLATE_BL_CODES, blTable)) return false;
+
+    // Code lengths of both alphabets, 16 repeats the previous length, 17 and 18 are runs of zeros
+    bool error = false;
+    uint32_t total = hlit + hdist;
+code_lengths:
+    for (uint32_t i = 0; i < total && !error && !br.overrun;) {
+#pragma HLS PIPELINE II = 1
+        inflateRefill(inStream, br);
+        uint16_t symbol = inflateDecode<DEFLATE_BL_CODES>(br, blTable, error);
+        if (error) break;
+        if (symbol < 16) {
+            length[i++] = symbol;
+            continue;
+        }
+        uint8_t value = 0;
+        uint32_t repeat;
+        if (symbol == 16) {
+            if (i == 0) {
+                error = true;
+                break;
+            }
+            value = length[i - 1];
+            repeat = 3 + inflateGet(br, 2);
+        } else if (symbol == 17) {
+            repeat = 3 + inflateGet(br, 3);
+        } else {
+            repeat = 11 + inflateGet(br, 7);
+        }
+        if (i + repeat > total) {
+            error = true;
+            break;
+        }
+        for (uint32_t r = 0; r < repeat; r++) length[i++] = value;
+    }
+    if (error || br.overrun || length[DEFLATE_END_BLOCK] == 0) return false;
+
+    return inflateBuildTable<INFLATE_LITERAL_SYMBOLS>(length, hlit, lit) &&
+           inflateBuildTable<INFLATE_DISTANCE_SYMBOLS>(length + hlit, hdist, dist);
+}
+
+/**
+ * @brief Skips the gzip member header (RFC 1952) or checks the zlib header
+ * (RFC 1950, no preset dictionary).
+ *
+ * @return false for a header of another format or method
+ */
+inline bool inflateHeader(hls::stream<ap_uint<64> >& inStream, inflateBits& br, bool zlib) {
+    inflateRefill(inStream, br);
+    if (zlib) {
+        uint32_t cmf = inflateGet(br, 8);
+        uint32_t flg = inflateGet(br, 8);
+        return ((cmf & 0xF) == 8) && ((cmf >> 4) <= 7) && (((cmf << 8) | flg) % 31 == 0) && !(flg & 0x20);
+    }
+
+    uint32_t id = inflateGet(br, 16);
+    uint32_t cm = inflateGet(br, 8);
+    uint32_t flg = inflateGet(br, 8);
+    if (id != 0x8B1F || cm != 8) return false;
+    // MTIME, XFL and OS
+    inflateRefill(inStream, br);
+    inflateGet(br, 32);
+    inflateGet(br, 16);
+
+    uint32_t skip = 0;
+    if (flg & 0x04) {
+        inflateRefill(inStream, br);
+        skip = inflateGet(br, 16);
+    }
+    // FEXTRA, then the zero terminated FNAME and FCOMMENT
+skip_extra:
+    for (uint32_t i = 0; i < skip && !br.overrun; i++) {
+#pragma HLS PIPELINE II = 1
+        inflateRefill(inStream, br);
+        inflateGet(br, 8);
+    }
+    for (uint32_t field = 0x08; field <= 0x10; field <<= 1) {
+        if (!(flg & field)) continue;
+    skip_string:
+        for (bool end = false; !end && !br.overrun;) {
+#pragma HLS PIPELINE II = 1
+            inflateRefill(inStream, br);
+            end = (inflateGet(br, 8) == 0);
+        }
+    }
+    // FHCRC
+    if (flg & 0x02) {
+        inflateRefill(inStream, br);
+        inflateGet(br, 16);
+    }
+    return !br.overrun;
+}
+
+/**
+ * @brief Decodes one gzip member or zlib stream into the literal/match
+ * symbols of lzDecompressZlibEos: a literal has length 0 and its byte in
+ * bits 7:0, a match has its distance in 15:0 and its length in 31:16. One
+ * literal or match is decoded per iteration, a match takes at most 48 bits
+ * and the bit buffer is refilled by a 64 bit word per iteration.
+ *
+ * Stored blocks are passed on as literals. Decoding stops at the first
+ * error (a code that is not in the tables, a distance past the output,
+ * reserved block type, truncated stream) and the symbols so far are ended
+ * with the end of stream flag; data after the trailer is skipped.
+ *
+ * @param inStream compressed words, input_size bytes
+ * @param outStream literal/match symbols
+ * @param outStreamEos end of stream flag of outStream
+ * @param trailerStream checksum and then content size (ISIZE) of the trailer,
+ * 0 for the size of a zlib stream
+ * @param statusStream true for a stream decoded without error
+ * @param input_size bytes of the input
+ * @param zlib decode a zlib stream instead of a gzip member
+ */
+inline void inflateHuffman(hls::stream<ap_uint<64> >& inStream,
+                           hls::stream<compressd_dt>& outStream,
+                           hls::stream<bool>& outStreamEos,
+                           hls::stream<uint32_t>& trailerStream,
+                           hls::stream<bool>& statusStream,
+                           uint32_t input_size,
+                           bool zlib) {
+    inflateTable<INFLATE_LITERAL_SYMBOLS> litTable;
+    inflateTable<INFLATE_DISTANCE_SYMBOLS> distTable;
+    inflateBits br;
+    br.buffer = 0;
+    br.bits = 0;
+    br.wordsLeft = (input_size + 7) / 8;
+    br.overrun = false;
+
+    bool error = !inflateHeader(inStream, br, zlib);
+    uint32_t outSize = 0;
+
+blocks:
+    for (bool last = false; !last && !error;) {
+        inflateRefill(inStream, br);
+        last = inflateGet(br, 1);
+        uint32_t type = inflateGet(br, 2);
+
+        if (type == 0) {
+            inflateDrop(br, br.bits % 8);
+            inflateRefill(inStream, br);
+            uint32_t len = inflateGet(br, 16);
+            uint32_t nlen = inflateGet(br, 16);
+            if (len != (~nlen & 0xFFFF)) {
+                error = true;
+                break;
+            }
+        stored:
+            for (uint32_t i = 0; i < len && !br.overrun; i++) {
+#pragma HLS PIPELINE II = 1
+                inflateRefill(inStream, br);
+                compressd_dt literal = inflateGet(br, 8);
+                outStream << literal;
+                outStreamEos << 0;
+            }
+            outSize += len;
+        } else if (type == 1) {
+            inflateStaticTables(litTable, distTable);
+        } else if (type == 2) {
+            error = !inflateDynamicTables(inStream, br, litTable, distTable);
+        } else {
+            error = true;
+        }
+        if (type == 0 || error) {
+            error |= br.overrun;
+            continue;
+        }
+
+    huffman_decode:
+        for (bool endOfBlock = false; !endOfBlock && !error;) {
+#pragma HLS PIPELINE II = 1
+            inflateRefill(inStream, br);
+            uint16_t symbol = inflateDecode<INFLATE_LITERAL_SYMBOLS>(br, litTable, error);
+            compressd_dt value = 0;
+            if (error) break;
+            if (symbol < DEFLATE_END_BLOCK) {
+                value.range(7, 0) = symbol;
+                outSize++;
+            } else if (symbol == DEFLATE_END_BLOCK) {
+                endOfBlock = true;
+            } else {
+                uint32_t lc = symbol - DEFLATE_END_BLOCK - 1;
+                if (lc >= c_length_codes) {
+                    error = true;
+                    break;
+                }
+                uint32_t length = (lc == c_length_codes - 1) ? c_max_match
+                                                             : base_length[lc] + c_min_match + inflateGet(br, extra_lbits[lc]);
+                uint16_t dc = inflateDecode<INFLATE_DISTANCE_SYMBOLS>(br, distTable, error);
+                if (error || dc >= c_distance_codes) {
+                    error = true;
+                    break;
+                }
+                uint32_t distance = base_dist[dc] + 1 + inflateGet(br, extra_dbits[dc]);
+                if (distance > outSize) {
+                    error = true;
+                    break;
+                }
+                value.range(15, 0) = distance;
+                value.range(31, 16) = length;
+                outSize += length;
+            }
+            if (br.overrun) {
+                error = true;
+                break;
+            }
+            if (!endOfBlock) {
+                outStream << value;
+                outStreamEos << 0;
+            }
+        }
+    }
+
+    // Trailer: Adler32 (BE) for zlib, CRC32 and ISIZE (LE) for gzip
+    uint32_t checksum = 0;
+    uint32_t isize = 0;
+    if (!error) {
+        inflateDrop(br, br.bits % 8);
+        inflateRefill(inStream, br);
+        if (zlib) {
+            for (int b = 0; b < 4; b++) checksum = (checksum << 8) | inflateGet(br, 8);
+        } else {
+            checksum = inflateGet(br, 32);
+            inflateRefill(inStream, br);
+            isize = inflateGet(br, 32);
+        }
+        error = br.overrun;
+    }
+
+inflate_drain:
+    for (; br.wordsLeft; br.wordsLeft--) {
+#pragma HLS PIPELINE II = 1
+        inStream.read();
+    }
+    outStream << 0;
+    outStreamEos << 1;
+    trailerStream << checksum;
+    trailerStream << isize;
+    statusStream << !error;
+}
+
+} // namespace compression
+} // namespace xf
+
+#endif // _XFCOMPRESSION_HUFFMAN_DECODER_HPP_
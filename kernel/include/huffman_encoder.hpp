@@ -0,0 +1,150 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_HUFFMAN_ENCODER_HPP_
+#define _XFCOMPRESSION_HUFFMAN_ENCODER_HPP_
+
+/**
+ * @file huffman_encoder.hpp
+ * @brief Deflate bit packer for the lz77Divide symbols of one block.
+ *
+ * This file is part of Vitis Data Compression Library.
+ */
+#include "hls_stream.h"
+#include <ap_int.h>
+#include <stdint.h>
+#include "huffman_treegen.hpp"
+#include "lz_optional.hpp"
+
+namespace xf {
+namespace compression {
+
+/**
+ * @brief Encodes one block with the codes of deflateTreegen and writes it
+ * as 64 bit words, LSB first. One symbol is taken per cycle, a match with
+ * its length and distance codes and extra bits is at most 48 bits, so one
+ * word leaves the 128 bit buffer per cycle at most.
+ *
+ * The block is not final and ends with the end of block symbol and a sync
+ * flush (an empty stored block), so it ends on a byte boundary and blocks
+ * encoded independently can be concatenated into one stream. Literals are
+ * the symbols with offset 0: lzCompress finds no matches at distance 1
+ * (MIN_OFFSET) and a match of 3 bytes has length 0 after lz77Divide.
+ *
+ * @param inStream lz77Divide symbols
+ * @param outStream encoded block
+ * @param outStreamEos end of stream flag of outStream
+ * @param compressedSize encoded bytes, 0 for no block
+ * @param tree codes and header of the block
+ * @param num_symbols symbols of the block, 0 for no block
+ */
+inline void deflateHuffman(hls::stream<ap_uint<32> >& inStream,
+                           hls::stream<ap_uint<64> >& outStream,
+                           hls::stream<bool>& outStreamEos,
+                           hls::stream<uint32_t>& compressedSize,
+                           const deflateTree& tree,
+                           uint32_t num_symbols) {
+    if (num_symbols == 0) {
+        compressedSize << 0;
+        outStream << 0;
+        outStreamEos << 1;
+        return;
+    }
+
+    ap_uint<128> buffer = 0;
+    uint32_t bufferBits = 0;
+    uint32_t totalBits = 0;
+
+huffman_header:
+    for (uint32_t e = 0; e < tree.headerEntries; e++) {
+#pragma HLS PIPELINE II = 1
+        uint32_t entry = tree.header[e];
+        uint32_t bits = entry >> 16;
+        buffer.range(bufferBits + 15, bufferBits) = entry & 0xFFFF;
+        bufferBits += bits;
+        totalBits += bits;
+        if (bufferBits >= 64) {
+            outStream << buffer.range(63, 0);
+            outStreamEos << 0;
+            buffer >>= 64;
+            bufferBits -= 64;
+        }
+    }
+
+huffman_encode:
+    for (uint32_t i = 0; i < num_symbols; i++) {
+#pragma HLS PIPELINE II = 1
+        ap_uint<32> symbol = inStream.read();
+        uint8_t tCh = symbol.range(7, 0);
+        uint8_t tLen = symbol.range(15, 8);
+        uint16_t tOffset = symbol.range(31, 16);
+        uint64_t value = 0;
+        uint32_t bits = 0;
+        if (tOffset == 0) {
+            value = tree.litCode[tCh];
+            bits = tree.litLen[tCh];
+        } else {
+            uint8_t lc = length_code[tLen];
+            uint16_t ls = lc + DEFLATE_END_BLOCK + 1;
+            uint8_t dc = d_code(tOffset, dist_code);
+            value = tree.litCode[ls];
+            bits = tree.litLen[ls];
+            value |= (uint64_t)(tLen - base_length[lc]) << bits;
+            bits += extra_lbits[lc];
+            value |= (uint64_t)(tree.distCode[dc]) << bits;
+            bits += tree.distLen[dc];
+            value |= (uint64_t)(tOffset - base_dist[dc]) << bits;
+            bits += extra_dbits[dc];
+        }
+        buffer.range(bufferBits + 63, bufferBits) = value;
+        bufferBits += bits;
+        totalBits += bits;
+        if (bufferBits >= 64) {
+            outStream << buffer.range(63, 0);
+            outStreamEos << 0;
+            buffer >>= 64;
+            bufferBits -= 64;
+        }
+    }
+
+    // End of block, then the sync flush: 3 bits of stored block header, the
+    // alignment and LEN = 0, NLEN = 0xFFFF
+    buffer.range(bufferBits + 15, bufferBits) = tree.litCode[DEFLATE_END_BLOCK];
+    bufferBits += tree.litLen[DEFLATE_END_BLOCK] + 3;
+    totalBits += tree.litLen[DEFLATE_END_BLOCK] + 3;
+    uint32_t pad = (8 - (bufferBits % 8)) % 8;
+    bufferBits += pad;
+    totalBits += pad;
+    buffer.range(bufferBits + 31, bufferBits) = 0xFFFF0000;
+    bufferBits += 32;
+    totalBits += 32;
+
+huffman_flush:
+    while (bufferBits > 0) {
+        outStream << buffer.range(63, 0);
+        outStreamEos << 0;
+        buffer >>= 64;
+        bufferBits = (bufferBits > 64) ? bufferBits - 64 : 0;
+    }
+    compressedSize << totalBits / 8;
+    outStream << 0;
+    outStreamEos << 1;
+}
+
+} // namespace compression
+} // namespace xf
+
+#endif // _XFCOMPRESSION_HUFFMAN_ENCODER_HPP_
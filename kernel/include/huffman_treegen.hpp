@@ -0,0 +1,444 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_HUFFMAN_TREEGEN_HPP_
+#define _XFCOMPRESSION_HUFFMAN_TREEGEN_HPP_
+
+/**
+ * @file huffman_treegen.hpp
+ * @brief Deflate Huffman trees of one block from its lz77Divide frequencies.
+ *
+ * Code lengths come from a Huffman tree built over the symbols sorted by
+ * frequency (radix sort, then the two queue method, which needs no heap).
+ * Lengths above the limit are cut as zlib does: the leaves below the limit
+ * are clamped to it and the code space they overflow is taken back from the
+ * longest codes left. Codes are canonical and bit reversed, Deflate sends
+ * Huffman codes starting from their most significant bit into an LSB first
+ * bit stream.
+ *
+ * deflateTreegen() builds the dynamic trees of a block and its header,
+ * compares the exact size of the block with them and with the static trees
+ * and keeps the smaller one.
+ *
+ * This file is part of Vitis Data Compression Library.
+ */
+#include <ap_int.h>
+#include <stdint.h>
+#include "zlib_tables.hpp"
+
+// Literal/length codes used by the encoder (286 and 287 never occur)
+#define DEFLATE_LITERAL_CODES 286
+#define DEFLATE_DISTANCE_CODES 30
+#define DEFLATE_BL_CODES 19
+#define DEFLATE_END_BLOCK 256
+#define DEFLATE_MAX_BITS 15
+#define DEFLATE_MAX_BL_BITS 7
+// Block header, HLIT/HDIST/HCLEN, code length code lengths, code lengths
+#define DEFLATE_HEADER_ENTRIES (2 + DEFLATE_BL_CODES + DEFLATE_LITERAL_CODES + DEFLATE_DISTANCE_CODES)
+
+// BFINAL = 0 and BTYPE of the block header, LSB first
+#define DEFLATE_STATIC_BLOCK 2
+#define DEFLATE_DYNAMIC_BLOCK 4
+
+namespace xf {
+namespace compression {
+
+/**
+ * Codes of one Deflate block. header holds the bits sent before the first
+ * symbol, one entry per field: value in [15:0], bit count in [20:16].
+ */
+struct deflateTree {
+    uint16_t litCode[DEFLATE_LITERAL_CODES];
+    uint8_t litLen[DEFLATE_LITERAL_CODES];
+    uint16_t distCode[DEFLATE_DISTANCE_CODES];
+    uint8_t distLen[DEFLATE_DISTANCE_CODES];
+    uint32_t header[DEFLATE_HEADER_ENTRIES];
+    uint32_t headerEntries;
+};
+
+namespace details {
+
+inline uint32_t deflateHeaderEntry(uint32_t value, uint32_t bits) {
+    return (bits << 16) | value;
+}
+
+/**
+ * @brief Sorts the symbols with a non zero frequency by frequency, lowest
+ * first, equal frequencies in symbol order. Radix sort, 8 bits per pass,
+ * frequencies below 2^24.
+ *
+ * @return number of sorted symbols
+ */
+template <int MAX_SYMBOLS>
+uint32_t huffmanSortSymbols(const uint32_t freq[MAX_SYMBOLS],
+                            uint32_t num_symbols,
+                            uint16_t sorted[MAX_SYMBOLS],
+                            uint32_t sortedFreq[MAX_SYMBOLS]) {
+    uint16_t tmp[MAX_SYMBOLS];
+    uint32_t tmpFreq[MAX_SYMBOLS];
+    uint32_t count = 0;
+collect:
+    for (uint32_t s = 0; s < num_symbols; s++) {
+#pragma HLS PIPELINE II = 1
+        if (freq[s]) {
+            sorted[count] = s;
+            sortedFreq[count] = freq[s];
+            count++;
+        }
+    }
+
+    uint32_t digitCount[256];
+radix_pass:
+    for (uint32_t shift = 0; shift < 24; shift += 8) {
+    radix_clear:
+        for (uint32_t d = 0; d < 256; d++) {
+#pragma HLS PIPELINE II = 1
+            digitCount[d] = 0;
+        }
+    radix_count:
+        for (uint32_t i = 0; i < count; i++) {
+#pragma HLS PIPELINE II = 1
+            digitCount[(sortedFreq[i] >> shift) & 0xFF]++;
+        }
+        uint32_t start = 0;
+    radix_prefix:
+        for (uint32_t d = 0; d < 256; d++) {
+#pragma HLS PIPELINE II = 1
+            uint32_t n = digitCount[d];
+            digitCount[d] = start;
+            start += n;
+        }
+    radix_scatter:
+        for (uint32_t i = 0; i < count; i++) {
+#pragma HLS PIPELINE II = 1
+            uint32_t pos = digitCount[(sortedFreq[i] >> shift) & 0xFF]++;
+            tmp[pos] = sorted[i];
+            tmpFreq[pos] = sortedFreq[i];
+        }
+    radix_copy:
+        for (uint32_t i = 0; i < count; i++) {
+#pragma HLS PIPELINE II = 1
+            sorted[i] = tmp[i];
+            sortedFreq[i] = tmpFreq[i];
+        }
+    }
+    return count;
+}
+
+} // namespace details
+
+/**
+ * @brief Length limited Huffman code lengths. Symbols with frequency 0 get
+ * length 0. With fewer than two used symbols, symbols 0 and 1 are given a
+ * code as well, so every tree has at least two codes (as zlib does).
+ *
+ * @tparam MAX_SYMBOLS size of the alphabet
+ * @tparam MAX_BITS code length limit
+ *
+ * @param freq frequency of each symbol, below 2^24
+ * @param num_symbols symbols in use
+ * @param length code length of each symbol
+ */
+template <int MAX_SYMBOLS, int MAX_BITS>
+void huffmanCodeLengths(const uint32_t freq[MAX_SYMBOLS], uint32_t num_symbols, uint8_t length[MAX_SYMBOLS]) {
+    uint16_t leaf[MAX_SYMBOLS];
+    uint32_t leafFreq[MAX_SYMBOLS];
+    uint16_t leafParent[MAX_SYMBOLS];
+    uint32_t nodeFreq[MAX_SYMBOLS];
+    uint16_t nodeParent[MAX_SYMBOLS];
+    uint8_t nodeDepth[MAX_SYMBOLS];
+    uint32_t blCount[MAX_BITS + 1];
+
+clear_length:
+    for (uint32_t s = 0; s < MAX_SYMBOLS; s++) {
+#pragma HLS PIPELINE II = 1
+        length[s] = 0;
+    }
+    for (uint32_t b = 0; b <= MAX_BITS; b++) blCount[b] = 0;
+
+    uint32_t n = details::huffmanSortSymbols<MAX_SYMBOLS>(freq, num_symbols, leaf, leafFreq);
+    // Unused symbols go in front with frequency 0, the sort order stays
+    if (n < 2) {
+        uint16_t used = n ? leaf[0] : MAX_SYMBOLS;
+        uint32_t usedFreq = n ? leafFreq[0] : 0;
+        uint32_t k = 0;
+        for (uint16_t s = 0; k + n < 2; s++) {
+            if (s != used) {
+                leaf[k] = s;
+                leafFreq[k] = 0;
+                k++;
+            }
+        }
+        if (n) {
+            leaf[k] = used;
+            leafFreq[k] = usedFreq;
+        }
+        n = 2;
+    }
+
+    // Two queues: the sorted leaves and the internal nodes, which are made in
+    // order of frequency
+    uint32_t li = 0;
+    uint32_t ni = 0;
+build_tree:
+    for (uint32_t k = 0; k < n - 1; k++) {
+        uint32_t sum = 0;
+        for (int c = 0; c < 2; c++) {
+            bool takeLeaf = (li < n) && (ni >= k || leafFreq[li] <= nodeFreq[ni]);
+            if (takeLeaf) {
+                sum += leafFreq[li];
+                leafParent[li++] = k;
+            } else {
+                sum += nodeFreq[ni];
+                nodeParent[ni++] = k;
+            }
+        }
+        nodeFreq[k] = sum;
+    }
+
+    // Depths from the root (the last node) down, internal nodes clamped to
+    // MAX_BITS; every leaf pushed past the limit is an overflow
+    uint32_t overflow = 0;
+    nodeDepth[n - 2] = 0;
+node_depth:
+    for (int k = n - 3; k >= 0; k--) {
+        uint32_t d = nodeDepth[nodeParent[k]] + 1;
+        nodeDepth[k] = (d > MAX_BITS) ? MAX_BITS : d;
+    }
+leaf_depth:
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t d = nodeDepth[leafParent[i]] + 1;
+        if (d > MAX_BITS) {
+            d = MAX_BITS;
+            overflow++;
+        }
+        blCount[d]++;
+    }
+
+    // Each step moves a leaf down from the longest lengths below the limit,
+    // which frees code space for two leaves at the limit
+limit_lengths:
+    while (overflow > 0) {
+        uint32_t bits = MAX_BITS - 1;
+        while (blCount[bits] == 0) bits--;
+        blCount[bits]--;
+        blCount[bits + 1] += 2;
+        blCount[MAX_BITS]--;
+        overflow = (overflow > 2) ? overflow - 2 : 0;
+    }
+
+    // The least frequent symbols take the longest codes
+    uint32_t idx = 0;
+assign_length:
+    for (uint32_t bits = MAX_BITS; bits > 0; bits--) {
+        for (uint32_t c = 0; c < blCount[bits]; c++) {
+#pragma HLS PIPELINE II = 1
+            length[leaf[idx++]] = bits;
+        }
+    }
+}
+
+/**
+ * @brief Canonical Huffman codes of the code lengths, bit reversed for an
+ * LSB first bit stream.
+ */
+template <int MAX_SYMBOLS, int MAX_BITS>
+void huffmanCanonicalCodes(const uint8_t length[MAX_SYMBOLS], uint32_t num_symbols, uint16_t code[MAX_SYMBOLS]) {
+    uint16_t blCount[MAX_BITS + 1];
+    uint16_t nextCode[MAX_BITS + 1];
+    for (uint32_t b = 0; b <= MAX_BITS; b++) blCount[b] = 0;
+count_lengths:
+    for (uint32_t s = 0; s < num_symbols; s++) {
+#pragma HLS PIPELINE II = 1
+        blCount[length[s]]++;
+    }
+    uint16_t c = 0;
+    blCount[0] = 0;
+    for (uint32_t b = 1; b <= MAX_BITS; b++) {
+        c = (c + blCount[b - 1]) << 1;
+        nextCode[b] = c;
+    }
+assign_codes:
+    for (uint32_t s = 0; s < num_symbols; s++) {
+#pragma HLS PIPELINE II = 1
+        uint32_t len = length[s];
+        uint16_t rev = 0;
+        if (len) {
+            uint16_t v = nextCode[len]++;
+            for (uint32_t b = 0; b < MAX_BITS; b++) {
+#pragma HLS UNROLL
+                if (b < len) rev |= ((v >> (len - 1 - b)) & 1) << b;
+            }
+        }
+        code[s] = rev;
+    }
+}
+
+/**
+ * @brief The fixed trees of a static block (BTYPE 01).
+ */
+inline void deflateStaticTree(deflateTree& tree) {
+static_lit:
+    for (uint32_t s = 0; s < DEFLATE_LITERAL_CODES; s++) {
+#pragma HLS PIPELINE II = 1
+        tree.litLen[s] = (s < 144) ? 8 : (s < 256) ? 9 : (s < 280) ? 7 : 8;
+    }
+static_dist:
+    for (uint32_t d = 0; d < DEFLATE_DISTANCE_CODES; d++) {
+#pragma HLS PIPELINE II = 1
+        tree.distLen[d] = 5;
+    }
+    huffmanCanonicalCodes<DEFLATE_LITERAL_CODES, DEFLATE_MAX_BITS>(tree.litLen, DEFLATE_LITERAL_CODES, tree.litCode);
+    huffmanCanonicalCodes<DEFLATE_DISTANCE_CODES, DEFLATE_MAX_BITS>(tree.distLen, DEFLATE_DISTANCE_CODES,
+                                                                     tree.distCode);
+    tree.header[0] = details::deflateHeaderEntry(DEFLATE_STATIC_BLOCK, 3);
+    tree.headerEntries = 1;
+}
+
+/**
+ * @brief Bits of the block data with the trees: symbols, extra bits and
+ * the end of block symbol, whose frequency is expected in litFreq.
+ */
+inline uint32_t deflateDataBits(const uint32_t litFreq[DEFLATE_LITERAL_CODES],
+                                const uint32_t distFreq[DEFLATE_DISTANCE_CODES],
+                                const uint8_t litLen[DEFLATE_LITERAL_CODES],
+                                const uint8_t distLen[DEFLATE_DISTANCE_CODES]) {
+    uint32_t bits = 0;
+lit_bits:
+    for (uint32_t s = 0; s < DEFLATE_LITERAL_CODES; s++) {
+#pragma HLS PIPELINE II = 1
+        uint32_t extra = (s > DEFLATE_END_BLOCK) ? extra_lbits[s - DEFLATE_END_BLOCK - 1] : 0;
+        bits += litFreq[s] * (litLen[s] + extra);
+    }
+dist_bits:
+    for (uint32_t d = 0; d < DEFLATE_DISTANCE_CODES; d++) {
+#pragma HLS PIPELINE II = 1
+        bits += distFreq[d] * (distLen[d] + extra_dbits[d]);
+    }
+    return bits;
+}
+
+/**
+ * @brief Builds the trees of one block and returns its size in bytes once
+ * encoded by deflateHuffman: block header, data, end of block and the sync
+ * flush after it.
+ *
+ * @param litFreq literal/length frequencies from lz77Divide, without the end of block
+ * @param distFreq distance frequencies from lz77Divide
+ * @param tree codes and header of the smaller of the dynamic and static block
+ */
+inline uint32_t deflateTreegen(const uint32_t litFreq[DEFLATE_LITERAL_CODES],
+                               const uint32_t distFreq[DEFLATE_DISTANCE_CODES],
+                               deflateTree& tree) {
+    uint32_t lFreq[DEFLATE_LITERAL_CODES];
+    for (uint32_t s = 0; s < DEFLATE_LITERAL_CODES; s++) lFreq[s] = litFreq[s];
+    lFreq[DEFLATE_END_BLOCK] = 1;
+
+    // Dynamic trees
+    huffmanCodeLengths<DEFLATE_LITERAL_CODES, DEFLATE_MAX_BITS>(lFreq, DEFLATE_LITERAL_CODES, tree.litLen);
+    huffmanCodeLengths<DEFLATE_DISTANCE_CODES, DEFLATE_MAX_BITS>(distFreq, DEFLATE_DISTANCE_CODES, tree.distLen);
+
+    uint32_t hlit = DEFLATE_LITERAL_CODES;
+    while (tree.litLen[hlit - 1] == 0) hlit--;
+    uint32_t hdist = DEFLATE_DISTANCE_CODES;
+    while (tree.distLen[hdist - 1] == 0) hdist--;
+
+    // Run length coding of the code lengths, both trees as one sequence
+    uint8_t lens[DEFLATE_LITERAL_CODES + DEFLATE_DISTANCE_CODES];
+    uint8_t rleSym[DEFLATE_LITERAL_CODES + DEFLATE_DISTANCE_CODES];
+    uint8_t rleExtra[DEFLATE_LITERAL_CODES + DEFLATE_DISTANCE_CODES];
+    uint32_t blFreq[DEFLATE_BL_CODES];
+    uint8_t blLen[DEFLATE_BL_CODES];
+    uint16_t blCode[DEFLATE_BL_CODES];
+    uint32_t total = hlit + hdist;
+    for (uint32_t i = 0; i < hlit; i++) lens[i] = tree.litLen[i];
+    for (uint32_t i = 0; i < hdist; i++) lens[hlit + i] = tree.distLen[i];
+    for (uint32_t c = 0; c < DEFLATE_BL_CODES; c++) blFreq[c] = 0;
+
+    uint32_t entries = 0;
+rle:
+    for (uint32_t i = 0; i < total;) {
+        uint8_t cur = lens[i];
+        uint32_t run = 1;
+        while (i + run < total && lens[i + run] == cur && run < 138) run++;
+        uint8_t sym = cur;
+        uint8_t extra = 0;
+        uint32_t used = 1;
+        if (cur == 0 && run >= 11) {
+            sym = 18;
+            extra = run - 11;
+            used = run;
+        } else if (cur == 0 && run >= 3) {
+            used = (run > 10) ? 10 : run;
+            sym = 17;
+            extra = used - 3;
+        } else if (cur != 0 && i > 0 && lens[i - 1] == cur && run >= 3) {
+            used = (run > 6) ? 6 : run;
+            sym = 16;
+            extra = used - 3;
+        }
+        rleSym[entries] = sym;
+        rleExtra[entries] = extra;
+        blFreq[sym]++;
+        entries++;
+        i += used;
+    }
+
+    huffmanCodeLengths<DEFLATE_BL_CODES, DEFLATE_MAX_BL_BITS>(blFreq, DEFLATE_BL_CODES, blLen);
+    huffmanCanonicalCodes<DEFLATE_BL_CODES, DEFLATE_MAX_BL_BITS>(blLen, DEFLATE_BL_CODES, blCode);
+    uint32_t hclen = DEFLATE_BL_CODES;
+    while (hclen > 4 && blLen[bl_order[hclen - 1]] == 0) hclen--;
+
+    // Header of the dynamic block
+    uint32_t h = 0;
+    uint32_t headerBits = 3 + 14 + 3 * hclen;
+    tree.header[h++] = details::deflateHeaderEntry(DEFLATE_DYNAMIC_BLOCK, 3);
+    tree.header[h++] = details::deflateHeaderEntry((hlit - 257) | ((hdist - 1) << 5) | ((hclen - 4) << 10), 14);
+    for (uint32_t k = 0; k < hclen; k++) tree.header[h++] = details::deflateHeaderEntry(blLen[bl_order[k]], 3);
+header_lengths:
+    for (uint32_t e = 0; e < entries; e++) {
+#pragma HLS PIPELINE II = 1
+        uint8_t sym = rleSym[e];
+        uint32_t bits = blLen[sym] + extra_blbits[sym];
+        tree.header[h++] = details::deflateHeaderEntry(blCode[sym] | (rleExtra[e] << blLen[sym]), bits);
+        headerBits += bits;
+    }
+    tree.headerEntries = h;
+
+    uint32_t dynamicBits = headerBits + deflateDataBits(lFreq, distFreq, tree.litLen, tree.distLen);
+
+    deflateTree fixed;
+    deflateStaticTree(fixed);
+    uint32_t staticBits = 3 + deflateDataBits(lFreq, distFreq, fixed.litLen, fixed.distLen);
+
+    uint32_t blockBits = dynamicBits;
+    if (staticBits <= dynamicBits) {
+        tree = fixed;
+        blockBits = staticBits;
+    } else {
+        huffmanCanonicalCodes<DEFLATE_LITERAL_CODES, DEFLATE_MAX_BITS>(tree.litLen, DEFLATE_LITERAL_CODES,
+                                                                        tree.litCode);
+        huffmanCanonicalCodes<DEFLATE_DISTANCE_CODES, DEFLATE_MAX_BITS>(tree.distLen, DEFLATE_DISTANCE_CODES,
+                                                                         tree.distCode);
+    }
+    // Sync flush: an empty stored block, byte aligned, LEN 0 and NLEN 0xFFFF
+    return (blockBits + 3 + 7) / 8 + 4;
+}
+
+} // namespace compression
+} // namespace xf
+
+#endif // _XFCOMPRESSION_HUFFMAN_TREEGEN_HPP_
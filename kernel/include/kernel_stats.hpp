@@ -0,0 +1,81 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_KERNEL_STATS_HPP_
+#define _XFCOMPRESSION_KERNEL_STATS_HPP_
+
+/**
+ * @file kernel_stats.hpp
+ * @brief Helpers filling the dt_kernelStats record of a kernel built with
+ * KERNEL_STATS.
+ *
+ * This file is part of Vitis Data Compression Library.
+ */
+#include "data_mover.hpp"
+#include "lz4_p2p.hpp"
+
+#include <stdint.h>
+
+namespace xf {
+namespace compression {
+namespace details {
+
+inline void statsReset(dt_kernelStats& stats, uint32_t num_engines) {
+    stats.moverBeats = 0;
+    stats.bytesIn = 0;
+    stats.bytesOut = 0;
+    stats.bursts = 0;
+    stats.numEngines = num_engines;
+    stats.rawBlocks = 0;
+    stats.lowOffsetCycles = 0;
+    for (uint32_t i = 0; i < MAX_STATS_ENGINES; i++) {
+#pragma HLS UNROLL
+        stats.inStallCycles[i] = 0;
+        stats.outStallCycles[i] = 0;
+    }
+    for (uint32_t i = 0; i < sizeof(stats.padding) / sizeof(stats.padding[0]); i++) {
+#pragma HLS UNROLL
+        stats.padding[i] = 0;
+    }
+}
+
+/**
+ * @brief Adds the counters of one dataflow call (reader, engines, writer)
+ * to the stats record. The reader and writer run concurrently, the longer
+ * of the two is taken as the mover beats of the call.
+ *
+ * @param stats stats record
+ * @param rd reader counters
+ * @param wr writer counters
+ */
+template <int NUM_BLOCKS>
+void statsAddMovers(dt_kernelStats& stats, const moverCounters<NUM_BLOCKS>& rd, const moverCounters<NUM_BLOCKS>& wr) {
+    stats.moverBeats += (rd.cycles > wr.cycles) ? rd.cycles : wr.cycles;
+    stats.bytesIn += rd.bytes;
+    stats.bytesOut += wr.bytes;
+    stats.bursts += rd.bursts + wr.bursts;
+    for (uint32_t i = 0; i < NUM_BLOCKS && i < MAX_STATS_ENGINES; i++) {
+#pragma HLS UNROLL
+        stats.inStallCycles[i] += rd.blockStallCycles[i];
+        stats.outStallCycles[i] += wr.blockStallCycles[i];
+    }
+}
+
+} // namespace details
+} // namespace compression
+} // namespace xf
+
+#endif // _XFCOMPRESSION_KERNEL_STATS_HPP_
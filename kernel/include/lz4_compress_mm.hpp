@@ -38,10 +38,30 @@
 #include "stream_upsizer.hpp"
 
 #include "lz4_compress.hpp"
+#include "snappy_compress.hpp"
+#include "lz_entropy.hpp"
+#include "xxhash32.hpp"
+#include "crc32c.hpp"
+#include "lz4_p2p.hpp"
+#include "zone_map.hpp"
+#include "kernel_stats.hpp"
 
 #define MIN_BLOCK_SIZE 128
 #define GMEM_DWIDTH 512
+#ifndef GMEM_BURST_SIZE
 #define GMEM_BURST_SIZE 16
+#endif
+// Bursts buffered per block and bursts issued per block in one round by the data movers
+#ifndef GMEM_OUTSTANDING
+#define GMEM_OUTSTANDING 1
+#endif
+#ifndef GMEM_INTERLEAVE
+#define GMEM_INTERLEAVE 1
+#endif
+// Outstanding bursts of the in / out m_axi ports, as many as the data movers buffer
+#ifndef GMEM_AXI_OUTSTANDING
+#define GMEM_AXI_OUTSTANDING (GMEM_OUTSTANDING * PARALLEL_BLOCK)
+#endif
 #define LZ_MAX_OFFSET_LIMIT 65536
 #define MIN_MATCH 4
 #define MAX_MATCH_LEN 255
@@ -49,6 +69,10 @@
 #define MATCH_LEN 6
 #define MAX_LIT_COUNT 4096
 
+#if defined(KERNEL_STATS) && (PARALLEL_BLOCK > MAX_STATS_ENGINES)
+#error "PARALLEL_BLOCK does not fit in dt_kernelStats"
+#endif
+
 // Kernel top functions
 extern "C" {
 /**
@@ -58,15 +82,37 @@ extern "C" {
  * @param in input raw data
  * @param out output compressed data
  * @param compressd_size compressed output size of each block
- * @param in_block_size input block size of each block
+ * @param block_desc input blocks, the blocks of a file consecutive and in order
+ * @param block_entropy entropy estimate of each block (bits per byte, 8.8 fixed point),
+ * blocks at or above ENTROPY_RAW_THRESHOLD are stored
+ * @param content_checksum XXH32 of every file, indexed by file id, written with FRAME_CONTENT_CHECKSUM;
+ * with FRAME_SNAPPY the masked CRC32C of every block, indexed by block
  * @param block_size_in_kb input block size in bytes
- * @param input_size input data size
+ * @param no_blocks number of entries in block_desc
+ * @param frame_flags FLG byte of the frame header, FRAME_SNAPPY for Snappy blocks, FRAME_ZONE_MAP for zone maps
+ * @param dict preset dictionary, every block is compressed against it and can refer back into it
+ * @param dict_size dictionary size in bytes, 0 for none (a dictionary buffer is still passed)
+ * @param zone_config record delimiter and field of the zone maps, read with FRAME_ZONE_MAP (a word is still passed)
+ * @param zone_map zone map of every block, indexed by block, written with FRAME_ZONE_MAP
+ * @param stats statistics record of this invocation (KERNEL_STATS builds only)
  */
 void xilLz4Compress(const xf::compression::uintMemWidth_t* in,
                     xf::compression::uintMemWidth_t* out,
                     uint32_t* compressd_size,
-                    uint32_t* in_block_size,
+                    dt_blockDesc* block_desc,
+                    uint32_t* block_entropy,
+                    uint32_t* content_checksum,
                     uint32_t block_size_in_kb,
-                    uint32_t input_size);
+                    uint32_t no_blocks,
+                    uint32_t frame_flags,
+                    const xf::compression::uintMemWidth_t* dict,
+                    uint32_t dict_size,
+                    const dt_zoneConfig* zone_config,
+                    dt_zoneMap* zone_map
+#ifdef KERNEL_STATS
+                    ,
+                    dt_kernelStats* stats
+#endif
+                    );
 }
 #endif // _XFCOMPRESSION_LZ4_COMPRESS_MM_HPP_
@@ -42,13 +42,186 @@
 #include <stdint.h>
 #define GMEM_DATAWIDTH 512
 
+// Upper bound on decompress compute units sharing one unpacker block table.
+// The actual count is a runtime argument (total_no_cu) and must not exceed it.
+#ifndef MAX_DECOMPRESS_CU
+#define MAX_DECOMPRESS_CU 8
+#endif
+
+#if (MAX_DECOMPRESS_CU >= (GMEM_DATAWIDTH / 32) - 4)
+#error "MAX_DECOMPRESS_CU does not fit in dt_chunkInfo"
+#endif
+
+// FLG bits of the LZ4 frame descriptor the kernels act on
+#define FRAME_BLOCK_CHECKSUM 0x10
+#define FRAME_CONTENT_CHECKSUM 0x04
+#define FRAME_DICT_ID 0x01
+// Not an FLG bit: xilLz4Packer appends the block index frame (see lz4_packer.hpp)
+#define FRAME_BLOCK_INDEX 0x100
+// Not an FLG bit: xilGzipCompress / xilGzipPacker write a zlib stream (Adler32)
+// instead of a gzip member (CRC32)
+#define FRAME_ZLIB 0x200
+// Not an FLG bit: the LZ4 kernels encode, pack, unpack and decode Snappy
+// framing format chunks (64KB blocks, masked CRC32C per chunk) instead of an LZ4 frame
+#define FRAME_SNAPPY 0x400
+// Not an FLG bit: xilLz4Compress writes the zone map of every block (zone_map.hpp)
+#define FRAME_ZONE_MAP 0x800
+
+// Snappy framing format: chunk types, the chunk header (type and 24 bit
+// length, LE) and the masked CRC32C that starts a data chunk. Data chunks
+// hold up to SNAPPY_BLOCK_SIZE bytes of content, the block size of the codec.
+#define SNAPPY_CHUNK_COMPRESSED 0x00
+#define SNAPPY_CHUNK_UNCOMPRESSED 0x01
+#define SNAPPY_CHUNK_PADDING 0xfe
+#define SNAPPY_CHUNK_STREAM_ID 0xff
+#define SNAPPY_CHUNK_HEADER_SIZE 4
+#define SNAPPY_CHUNK_CRC_SIZE 4
+#define SNAPPY_BLOCK_SIZE 65536
+
+// dt_blockInfo::checksumStatus, written by xilLz4P2PDecompress
+#define BLOCK_CHECKSUM_NONE 0     // frame without block checksums
+#define BLOCK_CHECKSUM_OK 1
+#define BLOCK_CHECKSUM_MISMATCH 2
+
+// Record filter of xilLz4P2PDecompress (record_filter.hpp): the content of
+// every block is split in records on a delimiter byte and run through the
+// Aho-Corasick automaton of a set of literal patterns. Without patterns
+// every record matches.
+#define FILTER_NONE 0      // every content byte is written out
+#define FILTER_RECORDS 1   // only the records holding a pattern
+#define FILTER_OFFSETS 2   // the block offset of those records, uint32 LE
+#define FILTER_COLUMNS 3   // the projected columns of those records, an int64 LE each
+#define FILTER_AGGREGATE 4 // count, sum, min and max of the projected columns (dt_columnStats)
+// Automaton limits: states, byte classes (bytes the patterns do not tell
+// apart share one) and the longest record an engine holds back
+#ifndef FILTER_MAX_STATES
+#define FILTER_MAX_STATES 256
+#endif
+#ifndef FILTER_MAX_CLASSES
+#define FILTER_MAX_CLASSES 32
+#endif
+#ifndef FILTER_MAX_RECORD
+#define FILTER_MAX_RECORD 4096
+#endif
+// Columns FILTER_COLUMNS / FILTER_AGGREGATE project
+#ifndef FILTER_MAX_COLUMNS
+#define FILTER_MAX_COLUMNS 4
+#endif
+// Projected column that is missing or not a decimal integer
+#define FILTER_NULL ((int64_t)0x8000000000000000ULL)
+// Transition table entry: next state, FILTER_ACCEPT when a pattern ends in it
+#define FILTER_ACCEPT 0x8000
+// dt_blockInfo::filterTailState: the tail is written as a dt_filterParseState
+#define FILTER_TAIL_PARSED 0x10000
+// dt_blockInfo::filterTailState: every byte of the tail is zero, the page
+// padding of the content when no later block goes on with it
+#define FILTER_TAIL_ZERO 0x20000
+// dt_blockInfo::filterStatus
+#define FILTER_OK 0
+#define FILTER_OVERFLOW 1 // records too short for their offsets or columns
+
+// First 64 byte word of the filter argument. The class of every byte value
+// follows in FILTER_CLASS_WORDS words, then the transition table in
+// FILTER_TABLE_WORDS words: a uint16 per state and class, entry
+// state * FILTER_MAX_CLASSES + class.
+typedef struct recordFilterConfig {
+    uint32_t mode; // FILTER_*
+    uint32_t delimiter;
+    uint32_t numStates; // 0 without patterns
+    uint32_t numClasses;
+    uint32_t fieldDelimiter;               // FILTER_COLUMNS / FILTER_AGGREGATE
+    uint32_t numColumns;                   // projected columns, at most FILTER_MAX_COLUMNS
+    uint32_t columns[FILTER_MAX_COLUMNS];  // field index of every projected column, from 0
+    uint32_t padding[(GMEM_DATAWIDTH / 32) - 6 - FILTER_MAX_COLUMNS];
+} dt_filterConfig;
+
+// With FILTER_COLUMNS / FILTER_AGGREGATE a tail longer than FILTER_MAX_RECORD
+// is written as how far the engine parsed it, for the host to go on from:
+// the columns of its fields so far and the field being parsed.
+#define FILTER_PARSE_NEGATIVE 1
+#define FILTER_PARSE_DIGITS 2
+#define FILTER_PARSE_NUMERIC 4
+typedef struct filterParseState {
+    int64_t columns[FILTER_MAX_COLUMNS]; // FILTER_NULL until their field ends
+    uint64_t value;                      // digits of the field so far
+    uint32_t field;                      // index of the field
+    uint32_t fieldLen;                   // bytes of the field so far
+    uint32_t flags;                      // FILTER_PARSE_*
+    uint32_t state;                      // automaton state, FILTER_ACCEPT when a pattern occurred
+} dt_filterParseState;
+
+// Projected column of the whole records of one block that match, written by
+// xilLz4P2PDecompress with FILTER_AGGREGATE at FILTER_MAX_COLUMNS entries
+// per block. Only the values that are decimal integers count, sum wraps.
+typedef struct columnStats {
+    int64_t sum;
+    int64_t min;
+    int64_t max;
+    uint32_t count;
+    uint32_t padding;
+} dt_columnStats;
+
+#define FILTER_CLASS_WORDS (256 / (GMEM_DATAWIDTH / 8))
+#define FILTER_TABLE_WORDS ((FILTER_MAX_STATES * FILTER_MAX_CLASSES * 2 - 1) / (GMEM_DATAWIDTH / 8) + 1)
+// Bytes of the filter argument
+#define FILTER_CONFIG_SIZE ((1 + FILTER_CLASS_WORDS + FILTER_TABLE_WORDS) * (GMEM_DATAWIDTH / 8))
+
+#if (FILTER_MAX_STATES > FILTER_ACCEPT) || (FILTER_MAX_CLASSES > 256) || (FILTER_MAX_COLUMNS > (GMEM_DATAWIDTH / 32) - 6)
+#error "Unsupported record filter limits"
+#endif
+
+// Zone map of xilLz4Compress (zone_map.hpp): the content of every block is
+// split in records on a delimiter byte and one numeric field of each is read
+// as a decimal integer, the column-th one split on a field delimiter or
+// width bytes at a fixed offset in the record.
+#define ZONE_FIELD_DELIMITED 0
+#define ZONE_FIELD_FIXED 1
+
+// structure size explicitly made equal to 64Bytes so that it will match
+// to Kernel Global Memory datawidth (512bit).
+typedef struct zoneMapConfig {
+    uint32_t layout; // ZONE_FIELD_*
+    uint32_t delimiter;
+    uint32_t fieldDelimiter; // ZONE_FIELD_DELIMITED
+    uint32_t column;         // ZONE_FIELD_DELIMITED: field index, from 0
+    uint32_t offset;         // ZONE_FIELD_FIXED: first byte of the field in the record
+    uint32_t width;          // ZONE_FIELD_FIXED: bytes of the field
+    uint32_t padding[(GMEM_DATAWIDTH / 32) - 6];
+} dt_zoneConfig;
+
+// Zone map of one block as xilLz4Compress writes it, over the records that
+// start after its first delimiter and end in it. The host adds the record
+// the block starts with, when it starts there, and the one after the last
+// delimiter, which it reads from the content.
+typedef struct zoneMap {
+    int64_t min;      // of the values, 0 without one
+    int64_t max;
+    uint32_t records;
+    uint32_t values;  // records whose field is a decimal integer
+    uint32_t head;    // bytes up to and with the first delimiter, the whole block without one
+    uint32_t tail;    // bytes after the last delimiter, 0 without one
+} dt_zoneMap;
+
 // structure size explicitly made equal to 64Bytes so that it will match
 // to Kernel Global Memory datawidth (512bit).
 typedef struct unpackerBlockInfo {
     uint32_t compressedSize;
     uint32_t blockSize;
     uint32_t blockStartIdx;
-    uint32_t padding[(GMEM_DATAWIDTH / 32) - 3];
+    uint32_t checksum;       // XXH32 of the block data stored in the frame
+    uint32_t checksumStatus; // BLOCK_CHECKSUM_*
+    // Written by xilLz4P2PDecompress with a record filter: bytes written for
+    // the block, of which the first filterHead are the content up to and with
+    // the first delimiter and the last filterTail the content after the last
+    // one (not written with FILTER_OFFSETS), the records the block only holds
+    // part of
+    uint32_t filteredSize;
+    uint32_t filterHead;
+    uint32_t filterTail;
+    uint32_t filterTailState; // automaton state after the tail, FILTER_ACCEPT when it holds a pattern, FILTER_TAIL_PARSED, FILTER_TAIL_ZERO
+    uint32_t filterMatches;   // whole records of the block holding a pattern
+    uint32_t filterStatus;    // FILTER_OK or FILTER_OVERFLOW
+    uint32_t padding[(GMEM_DATAWIDTH / 32) - 11];
 } dt_blockInfo;
 
 // structure size explicitly made equal to 64Bytes so that it will match
@@ -57,8 +230,66 @@ typedef struct unpackerChunkInfo {
     uint32_t inStartIdx;
     uint32_t originalSize;
     uint32_t numBlocks;
-    uint32_t numBlocksPerCU[2];
-    uint32_t padding[(GMEM_DATAWIDTH / 32) - 5];
+    uint32_t flags; // FLG byte of the frame
+    uint32_t numBlocksPerCU[MAX_DECOMPRESS_CU];
+    uint32_t padding[(GMEM_DATAWIDTH / 32) - 4 - MAX_DECOMPRESS_CU];
 } dt_chunkInfo;
 
+// One input block of xilLz4Compress / xilLz4Packer and of the gzip kernels.
+// The blocks of a file are consecutive entries in content order, so one
+// invocation can carry many files: the packer writes one frame per file at
+// frameOffset and its size at encoded_size[fileId]. Offsets are in bytes and
+// multiples of 64.
+typedef struct blockDesc {
+    uint32_t srcOffset;   // first byte of the block in the input buffer
+    uint32_t size;        // bytes in the block
+    uint32_t fileId;      // frame the block belongs to
+    uint32_t frameOffset; // first byte of the file's frame in the output buffer
+} dt_blockDesc;
+
+// Upper bound on xilGzipCompress engines (PARALLEL_BLOCK). The LZ77 symbols of
+// a batch go through a device buffer the host sizes for this many blocks,
+// GZIP_SYMBOL_BYTES per input byte.
+#define GZIP_MAX_ENGINES 16
+#define GZIP_SYMBOL_BYTES 4
+// Bytes per stored Deflate block xilGzipPacker writes for a stored input
+// block. A multiple of the packer width, so every stored block starts on a
+// word of its input stream.
+#define GZIP_STORED_CHUNK 32768
+
+// Status word of xilGzipDecompress (second word of its result)
+#define INFLATE_OK 0
+#define INFLATE_BAD_STREAM 1       // header, block or code the decoder does not accept
+#define INFLATE_TRAILER_MISMATCH 2 // content does not match the trailer checksum or size
+
+// Upper bound on engines (PARALLEL_BLOCK) reported in dt_kernelStats
+#ifndef MAX_STATS_ENGINES
+#define MAX_STATS_ENGINES 16
+#endif
+
+// Per-invocation statistics record written by a kernel built with
+// KERNEL_STATS. moverBeats counts loop iterations of the kernel's GMEM data
+// movers (II = 1), the longer of reader and writer per dataflow call, summed
+// over the batches of one invocation. The kernels without data movers
+// (packers, unpacker, xilGzipDecompress, numEngines = 0) count the 512-bit
+// words of their busiest GMEM port instead. It is not a measure of the
+// kernel's cycles: the engines between the movers may take longer.
+// Per engine stalls are seen from the data movers: inStallCycles counts
+// cycles the reader held data for the engine but its input FIFO was full,
+// outStallCycles counts cycles the writer waited on the engine's empty
+// output FIFO.
+// structure size explicitly made a multiple of 64Bytes.
+typedef struct kernelStats {
+    uint64_t moverBeats;
+    uint64_t bytesIn;
+    uint64_t bytesOut;
+    uint32_t bursts;
+    uint32_t numEngines;
+    uint32_t rawBlocks;       // blocks stored uncompressed (max_lit_limit hit, block too small or high entropy)
+    uint32_t lowOffsetCycles; // cycles spent copying matches with offset below LOW_OFFSET, summed over engines
+    uint32_t inStallCycles[MAX_STATS_ENGINES];
+    uint32_t outStallCycles[MAX_STATS_ENGINES];
+    uint32_t padding[((2 * MAX_STATS_ENGINES + 10 + 15) / 16) * 16 - (2 * MAX_STATS_ENGINES + 10)];
+} dt_kernelStats;
+
 #endif // _XFCOMPRESSION_LZ4_P2P_HPP_
@@ -36,9 +36,31 @@
 #include "stream_downsizer.hpp"
 #include "stream_upsizer.hpp"
 #include "lz4_decompress.hpp"
+#include "snappy_decompress.hpp"
 #include "lz4_p2p.hpp"
+#include "xxhash32.hpp"
+#include "crc32c.hpp"
+#include "record_filter.hpp"
+#include "kernel_stats.hpp"
 #define GMEM_DWIDTH 512
+#ifndef GMEM_BURST_SIZE
 #define GMEM_BURST_SIZE 16
+#endif
+// Bursts buffered per block and bursts issued per block in one round by the data movers
+#ifndef GMEM_OUTSTANDING
+#define GMEM_OUTSTANDING 1
+#endif
+#ifndef GMEM_INTERLEAVE
+#define GMEM_INTERLEAVE 1
+#endif
+// Outstanding bursts of the in / out m_axi ports, as many as the data movers buffer
+#ifndef GMEM_AXI_OUTSTANDING
+#define GMEM_AXI_OUTSTANDING (GMEM_OUTSTANDING * PARALLEL_BLOCK)
+#endif
+
+#if defined(KERNEL_STATS) && (PARALLEL_BLOCK > MAX_STATS_ENGINES)
+#error "PARALLEL_BLOCK does not fit in dt_kernelStats"
+#endif
 
 // Kernel top functions
 extern "C" {
@@ -47,6 +69,12 @@ extern "C" {
  * @brief LZ4 P2P decompression kernel is responsible for decompressing data
  * which is in LZ4 encoded form.
  *
+ * With a frame that has block checksums (FRAME_BLOCK_CHECKSUM in cObj->flags)
+ * every block is hashed as it is decoded and its bObj entry gets a
+ * BLOCK_CHECKSUM_OK or BLOCK_CHECKSUM_MISMATCH checksumStatus.
+ * With FRAME_SNAPPY the blocks are Snappy chunks: they are parsed as Snappy
+ * elements and the CRC32C of the content is checked against the chunk's.
+ *
  * @param in input stream width
  * @param out output stream width
  * @param in_block_size input size
@@ -54,9 +82,23 @@ extern "C" {
  * @param block_start_idx start index of block
  * @param no_blocks number of blocks for each compute unit
  * @param block_size_in_kb block input size
- * @param compute_unit particular compute unit
+ * @param compute_unit index of this compute unit, selects its run of the block table
+ * and the matching output range
  * @param total_no_cu number of compute units
- * @param num_blocks number of blocks base don host buffersize
+ * @param num_blocks number of blocks handed to each compute unit
+ * @param dict preset dictionary the frame was compressed against, used when
+ * the frame has a dictionary ID (FRAME_DICT_ID in cObj->flags)
+ * @param dict_size dictionary size in bytes, 0 for none (a dictionary buffer is still passed)
+ * @param filter record filter, a dt_filterConfig word followed by the byte
+ * classes and the transition table of the patterns' automaton. With a mode
+ * other than FILTER_NONE only the head, the tail and the matching records
+ * (or their offsets or projected columns) of every block are written to its
+ * output range, and its bObj entry gets the filteredSize, filterHead,
+ * filterTail, filterTailState, filterMatches and filterStatus of the block.
+ * FILTER_NONE takes one word.
+ * @param column_stats FILTER_AGGREGATE: FILTER_MAX_COLUMNS dt_columnStats per
+ * block of the frame, from the first one. Not written with other modes.
+ * @param stats statistics record of this invocation (KERNEL_STATS builds only)
  */
 void xilLz4P2PDecompress(const xf::compression::uintMemWidth_t* in,
                          xf::compression::uintMemWidth_t* out,
@@ -65,7 +107,16 @@ void xilLz4P2PDecompress(const xf::compression::uintMemWidth_t* in,
                          uint32_t block_size_in_kb,
                          uint32_t compute_unit,
                          uint8_t total_no_cu,
-                         uint32_t num_blocks);
+                         uint32_t num_blocks,
+                         const xf::compression::uintMemWidth_t* dict,
+                         uint32_t dict_size,
+                         const xf::compression::uintMemWidth_t* filter,
+                         dt_columnStats* column_stats
+#ifdef KERNEL_STATS
+                         ,
+                         dt_kernelStats* stats
+#endif
+                         );
 }
 
 #endif // _XFCOMPRESSION_LZ4_P2P_DECOMPRESS_KERNEL_HPP_
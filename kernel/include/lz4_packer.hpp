@@ -30,10 +30,63 @@
 #include <assert.h>
 #include <stdint.h>
 #include <stdio.h>
+#include "xxhash32.hpp"
+
+// Skippable frame lz4Packer appends after the LZ4 frame with the block index:
+// magic, frame size, then per block the offset of its block size field from
+// the start of the frame and the offset of its data in the content, all LE32,
+// then the block count and BLOCK_INDEX_MAGIC. The footer ends the file before
+// the zero padding, so readers find it from the end.
+#define BLOCK_INDEX_FRAME_MAGIC 0x184D2A5E
+#define BLOCK_INDEX_MAGIC 0x8F92EAB1
 
 namespace xf {
 namespace compression {
 
+/**
+ * @brief Hashes the data of every block on its way to lz4Packer, for the
+ * block checksums of the frame. Sizes and data are passed on unchanged.
+ *
+ * @tparam PACK_WIDTH packed data width
+ *
+ * @param inStream input data
+ * @param outStream the same data
+ * @param inStreamSize size of the data in input stream, header first
+ * @param outStreamSize the same sizes
+ * @param checksumStream XXH32 of every block, when enabled
+ * @param no_blocks number of input blocks
+ * @param enable hash the blocks
+ */
+template <int PACK_WIDTH>
+void lz4PackerChecksum(hls::stream<ap_uint<PACK_WIDTH> >& inStream,
+                       hls::stream<ap_uint<PACK_WIDTH> >& outStream,
+                       hls::stream<uint32_t>& inStreamSize,
+                       hls::stream<uint32_t>& outStreamSize,
+                       hls::stream<uint32_t>& checksumStream,
+                       uint32_t no_blocks,
+                       bool enable) {
+    const int c_parallelByte = PACK_WIDTH / 8;
+    for (uint32_t blkIdx = 0; blkIdx < no_blocks + 1; blkIdx++) {
+        uint32_t block_header = inStreamSize.read();
+        uint32_t size = block_header & 0x7FFFFFFF;
+        outStreamSize << block_header;
+
+        // The header goes first and is not part of any block
+        bool hash = enable && (blkIdx != 0);
+        details::xxh32State state;
+        details::xxh32Reset(state, 0);
+    hash_block:
+        for (uint32_t i = 0; i < size; i += c_parallelByte) {
+#pragma HLS PIPELINE II = 1
+            ap_uint<PACK_WIDTH> word = inStream.read();
+            uint32_t bytes = (i + c_parallelByte > size) ? size - i : c_parallelByte;
+            if (hash) details::xxh32Update(state, word, bytes);
+            outStream << word;
+        }
+        if (hash) checksumStream << details::xxh32Digest(state, 0);
+    }
+}
+
 /**
  * @brief Lz4 packer module packs the compressed data.
  *
@@ -48,6 +101,12 @@ namespace compression {
  * @param no_blocks number of input blocks
  * @param head_res_size header size
  * @param tail_bytes enabled for last block to handle final data
+ * @param checksumStream XXH32 of every block from lz4PackerChecksum
+ * @param block_checksum append the checksum of every block after its data
+ * @param content_checksum_enable append content_checksum after the end mark
+ * @param content_checksum XXH32 of the original content
+ * @param block_index_enable append the block index frame after the end of the frame
+ * @param block_index two words per block, written while packing and read back for the index frame
  */
 template <int PACK_WIDTH, int PARLLEL_BYTE>
 uint32_t lz4Packer(hls::stream<ap_uint<PACK_WIDTH> >& inStream,
@@ -57,12 +116,19 @@ uint32_t lz4Packer(hls::stream<ap_uint<PACK_WIDTH> >& inStream,
                    uint32_t block_size_in_kb,
                    uint32_t no_blocks,
                    uint32_t head_res_size,
-                   uint32_t tail_bytes) {
+                   uint32_t tail_bytes,
+                   hls::stream<uint32_t>& checksumStream,
+                   bool block_checksum,
+                   bool content_checksum_enable,
+                   uint32_t content_checksum,
+                   bool block_index_enable,
+                   uint32_t* block_index) {
     // 16 bytes can be held in on shot
     ap_uint<2 * PACK_WIDTH> lcl_buffer;
     uint32_t lbuf_idx = 0;
 
     uint32_t cBlen = 4;
+    uint32_t checksumLen = block_checksum ? 4 : 0;
 
     uint32_t endSizeCnt = 0;
     uint32_t sizeOutput = 0;
@@ -73,7 +139,9 @@ uint32_t lz4Packer(hls::stream<ap_uint<PACK_WIDTH> >& inStream,
 // Core packer logic
 packer:
     for (int blkIdx = 0; blkIdx < no_blocks + 1; blkIdx++) {
-        uint32_t size = inStreamSize.read();
+        // Bit 31 is set for stored blocks and goes into the block size as the LZ4 uncompressed flag
+        uint32_t block_header = inStreamSize.read();
+        uint32_t size = block_header & 0x7FFFFFFF;
         // printf("lbuf %d \n", lbuf_idx);
         // Find out the compressed size header
         // This value is sent by mm2s module
@@ -88,9 +156,13 @@ packer:
             sizeOutput = word_head;
             endSizeCnt += head_res_size;
         } else {
+            if (block_index_enable) {
+                block_index[2 * (blkIdx - 1)] = endSizeCnt;
+                block_index[2 * (blkIdx - 1) + 1] = (blkIdx - 1) * block_size_in_kb * 1024;
+            }
             // Size is nothing but 8bytes * 8 gives original input
-            over_size = lbuf_idx + cBlen + size;
-            endSizeCnt += cBlen + size;
+            over_size = lbuf_idx + cBlen + size + checksumLen;
+            endSizeCnt += cBlen + size + checksumLen;
             // 64bit size value including headers etc
             sizeOutput = over_size / 8;
         }
@@ -101,13 +173,13 @@ packer:
 
         if (blkIdx != 0) {
             // Update local buffer with compress size of current block - 4Bytes
-            lcl_buffer.range((lbuf_idx * 8) + 8 - 1, lbuf_idx * 8) = size;
+            lcl_buffer.range((lbuf_idx * 8) + 8 - 1, lbuf_idx * 8) = block_header;
             lbuf_idx++;
-            lcl_buffer.range((lbuf_idx * 8) + 8 - 1, lbuf_idx * 8) = size >> 8;
+            lcl_buffer.range((lbuf_idx * 8) + 8 - 1, lbuf_idx * 8) = block_header >> 8;
             lbuf_idx++;
-            lcl_buffer.range((lbuf_idx * 8) + 8 - 1, lbuf_idx * 8) = size >> 16;
+            lcl_buffer.range((lbuf_idx * 8) + 8 - 1, lbuf_idx * 8) = block_header >> 16;
             lbuf_idx++;
-            lcl_buffer.range((lbuf_idx * 8) + 8 - 1, lbuf_idx * 8) = size >> 24;
+            lcl_buffer.range((lbuf_idx * 8) + 8 - 1, lbuf_idx * 8) = block_header >> 24;
             lbuf_idx++;
         }
 
@@ -142,6 +214,20 @@ packer:
                 lbuf_idx -= 8;
             }
         } // End of main packer loop
+
+        if (blkIdx != 0 && block_checksum) {
+            uint32_t checksum = checksumStream.read();
+            for (int b = 0; b < 4; b++) {
+#pragma HLS UNROLL
+                lcl_buffer.range((lbuf_idx * 8) + 8 - 1, lbuf_idx * 8) = checksum >> (b * 8);
+                lbuf_idx++;
+            }
+            if (lbuf_idx >= 8) {
+                outStream << lcl_buffer.range(63, 0);
+                lcl_buffer >>= PACK_WIDTH;
+                lbuf_idx -= 8;
+            }
+        }
     }
 
     // printf("End of packer \n");
@@ -155,6 +241,47 @@ packer:
         lbuf_idx++;
         lcl_buffer.range((lbuf_idx * 8) + 8 - 1, lbuf_idx * 8) = 0;
         lbuf_idx++;
+        if (content_checksum_enable) {
+            // The end mark is no longer the last thing in the frame, count it with the checksum
+            for (int b = 0; b < 4; b++) {
+#pragma HLS UNROLL
+                lcl_buffer.range((lbuf_idx * 8) + 8 - 1, lbuf_idx * 8) = content_checksum >> (b * 8);
+                lbuf_idx++;
+            }
+            endSizeCnt += 8;
+        }
+
+        if (block_index_enable) {
+            uint32_t index_size = 8 * no_blocks + 8;
+            outStreamSize << (lbuf_idx + 8 + index_size) / 8;
+            if (lbuf_idx >= 8) {
+                outStream << lcl_buffer.range(63, 0);
+                lcl_buffer >>= PACK_WIDTH;
+                lbuf_idx -= 8;
+            }
+            ap_uint<64> frame_head = index_size;
+            frame_head = (frame_head << 32) | BLOCK_INDEX_FRAME_MAGIC;
+            lcl_buffer.range((lbuf_idx * 8) + 63, lbuf_idx * 8) = frame_head;
+            outStream << lcl_buffer.range(63, 0);
+            lcl_buffer >>= PACK_WIDTH;
+        // One entry per cycle, read back from where the block loop left it
+        pack_index:
+            for (uint32_t i = 0; i < no_blocks; i++) {
+#pragma HLS PIPELINE II = 1
+                ap_uint<64> entry = block_index[2 * i + 1];
+                entry = (entry << 32) | block_index[2 * i];
+                lcl_buffer.range((lbuf_idx * 8) + 63, lbuf_idx * 8) = entry;
+                outStream << lcl_buffer.range(63, 0);
+                lcl_buffer >>= PACK_WIDTH;
+            }
+            ap_uint<64> footer = BLOCK_INDEX_MAGIC;
+            footer = (footer << 32) | no_blocks;
+            lcl_buffer.range((lbuf_idx * 8) + 63, lbuf_idx * 8) = footer;
+            outStream << lcl_buffer.range(63, 0);
+            lcl_buffer >>= PACK_WIDTH;
+            // Count the end mark here too when there is no content checksum to carry it
+            endSizeCnt += (content_checksum_enable ? 0 : 4) + 8 + index_size;
+        }
     }
     // printf("flag %d lbuf_idx %d\n", flag, lbuf_idx);
 
@@ -32,9 +32,14 @@
 #include "s2mm.hpp"
 #include "stream_downsizer.hpp"
 #include "stream_upsizer.hpp"
+#include "lz4_p2p.hpp"
+#include "snappy_packer.hpp"
+#include "kernel_stats.hpp"
 
 #define GMEM_DWIDTH 512
+#ifndef GMEM_BURST_SIZE
 #define GMEM_BURST_SIZE 16
+#endif
 #define BLOCK_PARITION 1024
 #define MARKER 255
 #define MAX_LIT_COUNT 4096
@@ -67,29 +72,47 @@ extern "C" {
  * @brief LZ4 packer kernel takes the raw data as input and compresses the data
  * in block based fashion and writes the output to global memory.
  *
+ * The blocks of block_desc may belong to several files. Every file gets its
+ * own frame, written at the frameOffset of its blocks, and its size in
+ * encoded_size[fileId], so one invocation packs a batch of small files.
+ *
  * @param in input raw data
  * @param out output compressed data
  * @param compressd_size compressed output size of each block
- * @param in_block_size input block size of each block
- * @param encoded_size encoded size of each block
+ * @param block_desc input blocks, the blocks of a file consecutive and in order
+ * @param encoded_size frame size of each file, indexed by file id
  * @param orig_input_data raw input data
+ * @param content_checksum XXH32 of every file from xilLz4Compress, read with FRAME_CONTENT_CHECKSUM;
+ * with FRAME_SNAPPY the masked CRC32C of every block, indexed by block
+ * @param block_index two words per block, the offsets of the block index frame written with FRAME_BLOCK_INDEX
  * @param head_res_size size of the header
- * @param offset offset
+ * @param offset byte offset of the headers in head_prev_blk, one 64 byte word per file id
  * @param block_size_in_kb input block size in bytes
- * @param no_blocks number of input blocks
+ * @param no_blocks number of entries in block_desc
  * @param tail_bytes remaining bytes for the last block
+ * @param frame_flags FLG byte of the frame header, selects the block and content checksums, and FRAME_BLOCK_INDEX;
+ * FRAME_SNAPPY writes Snappy framing format chunks instead of an LZ4 frame
+ * @param stats statistics record of this invocation (KERNEL_STATS builds only)
  */
 void xilLz4Packer(const uint512_t* in,
                   uint512_t* out,
                   uint512_t* head_prev_blk,
                   uint32_t* compressd_size,
-                  uint32_t* in_block_size,
+                  dt_blockDesc* block_desc,
                   uint32_t* encoded_size,
                   uint512_t* orig_input_data,
+                  uint32_t* content_checksum,
+                  uint32_t* block_index,
                   uint32_t head_res_size,
                   uint32_t offset,
                   uint32_t block_size_in_kb,
                   uint32_t no_blocks,
-                  uint32_t tail_bytes);
+                  uint32_t tail_bytes,
+                  uint32_t frame_flags
+#ifdef KERNEL_STATS
+                  ,
+                  dt_kernelStats* stats
+#endif
+                  );
 }
 #endif // _XFCOMPRESSION_LZ4_PACKER_MM_HPP_
@@ -35,6 +35,7 @@
 #include "stream_downsizer.hpp"
 #include "stream_upsizer.hpp"
 #include "lz4_p2p.hpp"
+#include "kernel_stats.hpp"
 #define GMEM_DWIDTH 512
 
 // Kernel top functions
@@ -53,9 +54,12 @@ extern "C" {
  * @param in_start_index input start index
  * @param no_blocks number of blocks
  * @param block_size_in_kb size of each block
- * @param first_chunk first chunk to determine header
- * @param total_no_cu number of decompress compute units
- * @param num_blocks number of blocks based on host buffersize
+ * @param first_chunk first chunk to determine header, otherwise the flags, size, block count and start index are
+ * taken from cObj. With FRAME_SNAPPY in its flags the data chunks of a Snappy framing format stream are listed,
+ * other chunks skipped, and the chunk CRC goes into the checksum of every block
+ * @param total_no_cu number of decompress compute units (up to MAX_DECOMPRESS_CU)
+ * @param num_blocks number of blocks handed to each decompress compute unit
+ * @param stats statistics record of this invocation (KERNEL_STATS builds only)
  */
 void xilLz4Unpacker(const xf::compression::uintMemWidth_t* in,
                     dt_blockInfo* bObj,
@@ -63,7 +67,12 @@ void xilLz4Unpacker(const xf::compression::uintMemWidth_t* in,
                     uint32_t block_size_in_kb,
                     uint8_t first_chunk,
                     uint8_t total_no_cu,
-                    uint32_t num_blocks);
+                    uint32_t num_blocks
+#ifdef KERNEL_STATS
+                    ,
+                    dt_kernelStats* stats
+#endif
+                    );
 }
 
 #endif // _XFCOMPRESSION_LZ4_UNPACKER_KERNEL_HPP_
@@ -39,6 +39,13 @@ typedef ap_uint<32> compressd_dt;
  * @brief This module reads input literals from stream and updates
  * match length and offset of each literal.
  *
+ * A preset dictionary of dict_size bytes can be given on dictStream. It is
+ * read before the block and fills the hash table as positions 0 to
+ * dict_size - 1, so the block can refer back into it; no output is written
+ * for it. Each dictionary byte is passed on to historyStream for lzBooster.
+ * The dictionary costs dict_size cycles per block and only its last
+ * LZ_MAX_OFFSET_LIMIT bytes can be matched.
+ *
  * @tparam MATCH_LEN match length
  * @tparam MIN_MATCH minimum match
  * @tparam LZ_MAX_OFFSET_LIMIT maximum offset limit
@@ -47,8 +54,11 @@ typedef ap_uint<32> compressd_dt;
  * @tparam LZ_DICT_SIZE dictionary size
  *
  * @param inStream input stream
+ * @param dictStream preset dictionary
  * @param outStream output stream
+ * @param historyStream preset dictionary, passed on
  * @param input_size input size
+ * @param dict_size preset dictionary size, 0 for none
  * @param left_bytes left bytes in block
  */
 template <int MATCH_LEN,
@@ -58,7 +68,12 @@ template <int MATCH_LEN,
           int MIN_OFFSET = 1,
           int LZ_DICT_SIZE = 1 << 12,
           int LEFT_BYTES = 64>
-void lzCompress(hls::stream<ap_uint<8> >& inStream, hls::stream<compressd_dt>& outStream, uint32_t input_size) {
+void lzCompress(hls::stream<ap_uint<8> >& inStream,
+                hls::stream<ap_uint<8> >& dictStream,
+                hls::stream<compressd_dt>& outStream,
+                hls::stream<ap_uint<8> >& historyStream,
+                uint32_t input_size,
+                uint32_t dict_size) {
     const int c_dictEleWidth = (MATCH_LEN * 8 + 24);
     typedef ap_uint<MATCH_LEVEL * c_dictEleWidth> uintDictV_t;
     typedef ap_uint<c_dictEleWidth> uintDict_t;
@@ -81,13 +96,19 @@ dict_flush:
         dict[i] = resetValue;
     }
 
+    // The dictionary and the block are one stream of positions, the dictionary first
     uint8_t present_window[MATCH_LEN];
 #pragma HLS ARRAY_PARTITION variable = present_window complete
     for (uint8_t i = 1; i < MATCH_LEN; i++) {
-        present_window[i] = inStream.read();
+        if ((uint32_t)(i - 1) < dict_size) {
+            present_window[i] = dictStream.read();
+            historyStream << present_window[i];
+        } else {
+            present_window[i] = inStream.read();
+        }
     }
 lz_compress:
-    for (uint32_t i = MATCH_LEN - 1; i < input_size - LEFT_BYTES; i++) {
+    for (uint32_t i = MATCH_LEN - 1; i < dict_size + input_size - LEFT_BYTES; i++) {
 #pragma HLS PIPELINE II = 1
 #pragma HLS dependence variable = dict inter false
         uint32_t currIdx = i - MATCH_LEN + 1;
@@ -96,7 +117,12 @@ lz_compress:
 #pragma HLS UNROLL
             present_window[m] = present_window[m + 1];
         }
-        present_window[MATCH_LEN - 1] = inStream.read();
+        if (i < dict_size) {
+            present_window[MATCH_LEN - 1] = dictStream.read();
+            historyStream << present_window[MATCH_LEN - 1];
+        } else {
+            present_window[MATCH_LEN - 1] = inStream.read();
+        }
 
         // Calculate Hash Value
         uint32_t hash =
@@ -144,7 +170,7 @@ lz_compress:
         outValue.range(7, 0) = present_window[0];
         outValue.range(15, 8) = match_length;
         outValue.range(31, 16) = match_offset;
-        outStream << outValue;
+        if (currIdx >= dict_size) outStream << outValue;
     }
 lz_compress_leftover:
     for (int m = 1; m < MATCH_LEN; m++) {
@@ -162,6 +188,27 @@ lz_left_bytes:
     }
 }
 
+/**
+ * @brief lzCompress without a preset dictionary.
+ *
+ * @param inStream input stream
+ * @param outStream output stream
+ * @param input_size input size
+ */
+template <int MATCH_LEN,
+          int MIN_MATCH,
+          int LZ_MAX_OFFSET_LIMIT,
+          int MATCH_LEVEL = 6,
+          int MIN_OFFSET = 1,
+          int LZ_DICT_SIZE = 1 << 12,
+          int LEFT_BYTES = 64>
+void lzCompress(hls::stream<ap_uint<8> >& inStream, hls::stream<compressd_dt>& outStream, uint32_t input_size) {
+    hls::stream<ap_uint<8> > dictStream("dictStream");
+    hls::stream<ap_uint<8> > historyStream("historyStream");
+    lzCompress<MATCH_LEN, MIN_MATCH, LZ_MAX_OFFSET_LIMIT, MATCH_LEVEL, MIN_OFFSET, LZ_DICT_SIZE, LEFT_BYTES>(
+        inStream, dictStream, outStream, historyStream, input_size, 0);
+}
+
 } // namespace compression
 } // namespace xf
 #endif // _XFCOMPRESSION_LZ_COMPRESS_HPP_
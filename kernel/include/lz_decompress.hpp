@@ -44,12 +44,24 @@ typedef ap_uint<32> compressd_dt;
  * @tparam LOW_OFFSET low offset
  * @tparam HISTORY_SIZE history size
  *
+ * The history starts with the preset dictionary the block was compressed
+ * against, dict_size bytes read from dictStream before the block (the last
+ * HISTORY_SIZE of them are kept). It costs dict_size cycles per block.
+ *
  * @param inStream input stream
+ * @param dictStream preset dictionary
  * @param outStream output stream
  * @param original_size original size
+ * @param dict_size preset dictionary size, 0 for none
+ * @param low_offset_cycles cycles spent copying matches with offset below LOW_OFFSET
  */
 template <int HISTORY_SIZE, int LOW_OFFSET = 8>
-void lzDecompress(hls::stream<compressd_dt>& inStream, hls::stream<ap_uint<8> >& outStream, uint32_t original_size) {
+void lzDecompress(hls::stream<compressd_dt>& inStream,
+                  hls::stream<ap_uint<8> >& dictStream,
+                  hls::stream<ap_uint<8> >& outStream,
+                  uint32_t original_size,
+                  uint32_t dict_size,
+                  uint32_t& low_offset_cycles) {
     enum lzDecompressStates { READ_STATE, MATCH_STATE, LOW_OFFSET_STATE };
 
     uint8_t local_buf[HISTORY_SIZE];
@@ -65,8 +77,20 @@ void lzDecompress(hls::stream<compressd_dt>& inStream, hls::stream<ap_uint<8> >&
     ap_uint<8> outValue = 0;
     ap_uint<8> prevValue[LOW_OFFSET];
 #pragma HLS ARRAY_PARTITION variable = prevValue dim = 0 complete
+    uint32_t low_offset_cnt = 0;
+lz_decompress_dict:
+    for (uint32_t i = 0; i < dict_size; i++) {
+#pragma HLS PIPELINE II = 1
+        outValue = dictStream.read();
+        local_buf[i % HISTORY_SIZE] = outValue;
+        for (uint32_t pIdx = LOW_OFFSET - 1; pIdx > 0; pIdx--) {
+#pragma HLS UNROLL
+            prevValue[pIdx] = prevValue[pIdx - 1];
+        }
+        prevValue[0] = outValue;
+    }
 lz_decompress:
-    for (uint32_t i = 0; i < original_size; i++) {
+    for (uint32_t i = dict_size; i < dict_size + original_size; i++) {
 #pragma HLS PIPELINE II = 1
         if (next_states == READ_STATE) {
             nextValue = inStream.read();
@@ -91,6 +115,7 @@ lz_decompress:
             }
         } else if (next_states == LOW_OFFSET_STATE) {
             outValue = prevValue[offset];
+            low_offset_cnt++;
             match_loc++;
             out_len++;
             if (out_len == match_len) next_states = READ_STATE;
@@ -109,6 +134,22 @@ lz_decompress:
         }
         prevValue[0] = outValue;
     }
+    low_offset_cycles = low_offset_cnt;
+}
+
+template <int HISTORY_SIZE, int LOW_OFFSET = 8>
+void lzDecompress(hls::stream<compressd_dt>& inStream,
+                  hls::stream<ap_uint<8> >& outStream,
+                  uint32_t original_size,
+                  uint32_t& low_offset_cycles) {
+    hls::stream<ap_uint<8> > dictStream("dictStream");
+    lzDecompress<HISTORY_SIZE, LOW_OFFSET>(inStream, dictStream, outStream, original_size, 0, low_offset_cycles);
+}
+
+template <int HISTORY_SIZE, int LOW_OFFSET = 8>
+void lzDecompress(hls::stream<compressd_dt>& inStream, hls::stream<ap_uint<8> >& outStream, uint32_t original_size) {
+    uint32_t low_offset_cycles;
+    lzDecompress<HISTORY_SIZE, LOW_OFFSET>(inStream, outStream, original_size, low_offset_cycles);
 }
 
 template <int PARALLEL_BYTES, int HISTORY_SIZE, class SIZE_DT = uint8_t>
@@ -0,0 +1,78 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_LZ_ENTROPY_HPP_
+#define _XFCOMPRESSION_LZ_ENTROPY_HPP_
+
+/**
+ * @file lz_entropy.hpp
+ * @brief Block entropy estimate shared by xilLz4Compress and the host.
+ *
+ * The estimate is the order 2 (collision) entropy of the byte histogram of a
+ * sample of the block, -log2(sum(p^2)), in bits per byte as 8.8 fixed point.
+ * It never exceeds the Shannon entropy and only needs the sum of the squared
+ * histogram counts. The sample is ENTROPY_SAMPLE_CHUNKS runs of
+ * ENTROPY_CHUNK_BYTES spread evenly over the block, or the whole block when
+ * it is not larger than the sample.
+ */
+
+#include <stdint.h>
+
+#define ENTROPY_SAMPLE_CHUNKS 4
+#define ENTROPY_CHUNK_BYTES 1024
+#define ENTROPY_SAMPLE_BYTES (ENTROPY_SAMPLE_CHUNKS * ENTROPY_CHUNK_BYTES)
+
+// 1.0 bit per byte in the 8.8 fixed point of the estimate, 8 bits per byte is the largest value
+#define ENTROPY_ONE_BIT 256
+#define ENTROPY_MAX (8 * ENTROPY_ONE_BIT)
+
+// Blocks estimated at or above this are stored without going through an
+// engine (7.75 bits per byte). Uniformly random bytes estimate at ~7.9 bits
+// on a 4K sample, text at 4 ~ 6. Above ENTROPY_MAX no block is bypassed.
+#ifndef ENTROPY_RAW_THRESHOLD
+#define ENTROPY_RAW_THRESHOLD 1984
+#endif
+
+// Byte offset of a sample chunk in a block of block_size bytes, on a 64 byte (GMEM word) boundary
+inline uint32_t entropyChunkOffset(uint32_t block_size, uint32_t chunk) {
+    return (chunk * (block_size / ENTROPY_SAMPLE_CHUNKS)) & ~63u;
+}
+
+// log2(x) in 8.8 fixed point, x > 0. The fraction uses log2(1 + f) ~ f + 0.346 f (1 - f),
+// within 0.01 bit of the exact value. The host estimator includes this header too, so the
+// pragma is only seen by synthesis.
+inline uint32_t entropyLog2(uint64_t x) {
+    uint32_t msb = 0;
+    for (uint32_t b = 1; b < 64; b++) {
+#ifdef __SYNTHESIS__
+#pragma HLS UNROLL
+#endif
+        if (x >> b) msb = b;
+    }
+    uint32_t frac = (msb >= 8) ? (uint32_t)(x >> (msb - 8)) & 0xFF : (uint32_t)(x << (8 - msb)) & 0xFF;
+    return msb * ENTROPY_ONE_BIT + frac + ((frac * (256 - frac) * 89) >> 16);
+}
+
+// Estimate of a sample of sample_size bytes whose histogram counts square-sum to sum_sq
+inline uint32_t entropyEstimate(uint64_t sum_sq, uint32_t sample_size) {
+    if (sample_size == 0 || sum_sq == 0) return 0;
+    uint32_t n2 = entropyLog2((uint64_t)sample_size * sample_size);
+    uint32_t s = entropyLog2(sum_sq);
+    if (s >= n2) return 0;
+    return (n2 - s > ENTROPY_MAX) ? ENTROPY_MAX : n2 - s;
+}
+
+#endif // _XFCOMPRESSION_LZ_ENTROPY_HPP_
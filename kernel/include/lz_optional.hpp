@@ -183,19 +183,34 @@ lz_bestMatchFilter_left_over:
  * Higher the booster value can give better compression ratio but
  * will consume more BRAM resources.
  *
+ * The history window starts with the last BOOSTER_OFFSET_WINDOW bytes of
+ * the preset dictionary lzCompress passes on (historyStream), so matches
+ * into the dictionary are extended as well.
+ *
  * @tparam MAX_MATCH_LEN maximum length allowed for character match
  * @tparam BOOSTER_OFFSET_WINDOW offset window to store/match the character
  *
  * @param inStream input stream 32bit per read
+ * @param historyStream preset dictionary
  * @param outStream output stream 32bit per write
  * @param input_size input size
+ * @param dict_size preset dictionary size, 0 for none
  * @param left_bytes last 64 left over bytes
  *
 */
 template <int MAX_MATCH_LEN, int BOOSTER_OFFSET_WINDOW = 16 * 1024, int LEFT_BYTES = 64>
-void lzBooster(hls::stream<compressd_dt>& inStream, hls::stream<compressd_dt>& outStream, uint32_t input_size) {
+void lzBooster(hls::stream<compressd_dt>& inStream,
+               hls::stream<ap_uint<8> >& historyStream,
+               hls::stream<compressd_dt>& outStream,
+               uint32_t input_size,
+               uint32_t dict_size) {
     if (input_size == 0) return;
     uint8_t local_mem[BOOSTER_OFFSET_WINDOW];
+lz_booster_history:
+    for (uint32_t i = 0; i < dict_size; i++) {
+#pragma HLS PIPELINE II = 1
+        local_mem[i % BOOSTER_OFFSET_WINDOW] = historyStream.read();
+    }
     uint32_t match_loc = 0;
     uint32_t match_len = 0;
     compressd_dt outValue;
@@ -208,6 +223,8 @@ lz_booster:
     for (uint32_t i = 0; i < (input_size - LEFT_BYTES); i++) {
 #pragma HLS PIPELINE II = 1
 #pragma HLS dependence variable = local_mem inter false
+        // Position after the dictionary
+        uint32_t pos = dict_size + i;
         compressd_dt inValue = inStream.read();
         uint8_t tCh = inValue.range(7, 0);
         uint8_t tLen = inValue.range(15, 8);
@@ -218,7 +235,7 @@ lz_booster:
             boostFlag = false;
         }
         uint8_t match_ch = local_mem[match_loc % BOOSTER_OFFSET_WINDOW];
-        local_mem[i % BOOSTER_OFFSET_WINDOW] = tCh;
+        local_mem[pos % BOOSTER_OFFSET_WINDOW] = tCh;
         outFlag = false;
 
         if (skip_len) {
@@ -229,7 +246,7 @@ lz_booster:
             outValue.range(15, 8) = match_len;
         } else {
             match_len = 1;
-            match_loc = i - tOffset;
+            match_loc = pos - tOffset;
             if (i) outFlag = true;
             outStreamValue = outValue;
             outValue = inValue;
@@ -254,6 +271,22 @@ lz_booster_left_bytes:
     }
 }
 
+/**
+ * @brief lzBooster without a preset dictionary.
+ *
+ * @tparam MAX_MATCH_LEN maximum length allowed for character match
+ * @tparam BOOSTER_OFFSET_WINDOW offset window to store/match the character
+ *
+ * @param inStream input stream 32bit per read
+ * @param outStream output stream 32bit per write
+ * @param input_size input size
+ */
+template <int MAX_MATCH_LEN, int BOOSTER_OFFSET_WINDOW = 16 * 1024, int LEFT_BYTES = 64>
+void lzBooster(hls::stream<compressd_dt>& inStream, hls::stream<compressd_dt>& outStream, uint32_t input_size) {
+    hls::stream<ap_uint<8> > historyStream("historyStream");
+    lzBooster<MAX_MATCH_LEN, BOOSTER_OFFSET_WINDOW, LEFT_BYTES>(inStream, historyStream, outStream, input_size, 0);
+}
+
 /**
  * @brief This module checks if match length exists, and if
  * match length exists it filters the match length -1 characters
@@ -0,0 +1,420 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_RECORD_FILTER_HPP_
+#define _XFCOMPRESSION_RECORD_FILTER_HPP_
+
+/**
+ * @file record_filter.hpp
+ * @brief Header for the record filter of the LZ decompression engines. The
+ * decompressed content of a block is split in records on a delimiter byte
+ * and only the records holding one of a set of literal patterns are written
+ * out, or their offsets, so a search over compressed data sends a fraction
+ * of the content to the host.
+ *
+ * The patterns come as the Aho-Corasick automaton the host builds
+ * (host/include/record_filter.hpp) in the layout of dt_filterConfig.
+ *
+ * This file is part of Vitis Data Compression Library.
+ */
+
+#include "hls_stream.h"
+#include "lz4_p2p.hpp"
+
+#include <ap_int.h>
+#include <stdint.h>
+
+namespace xf {
+namespace compression {
+
+/**
+ * @brief Settings of the record filter, from the dt_filterConfig word.
+ *
+ * @tparam MAX_COLUMNS projected columns
+ */
+template <int MAX_COLUMNS>
+struct recordFilterParams {
+    uint8_t mode; // FILTER_*
+    ap_uint<8> delimiter;
+    bool matchAll; // no patterns, every record matches
+    ap_uint<8> fieldDelimiter;
+    uint8_t numColumns;
+    uint32_t columns[MAX_COLUMNS];
+};
+
+/**
+ * @brief Reads the filter argument and loads the class map and the
+ * transition table into the tables of every engine.
+ *
+ * @tparam DATAWIDTH width of data bus
+ * @tparam NUM_BLOCKS number of engines
+ * @tparam MAX_STATES states of the transition table
+ * @tparam MAX_CLASSES byte classes of the transition table
+ * @tparam MAX_COLUMNS projected columns
+ *
+ * @param filter dt_filterConfig word, class map and transition table
+ * @param params settings of the filter
+ * @param byte_class class of every byte value, per engine
+ * @param next_state transition table, per engine
+ */
+template <int DATAWIDTH, int NUM_BLOCKS, int MAX_STATES, int MAX_CLASSES, int MAX_COLUMNS>
+void recordFilterLoad(const ap_uint<DATAWIDTH>* filter,
+                      recordFilterParams<MAX_COLUMNS>& params,
+                      ap_uint<8> byte_class[NUM_BLOCKS][256],
+                      ap_uint<16> next_state[NUM_BLOCKS][MAX_STATES * MAX_CLASSES]) {
+    const int c_classPerWord = DATAWIDTH / 8;
+    const int c_entryPerWord = DATAWIDTH / 16;
+    const uint32_t c_entries = MAX_STATES * MAX_CLASSES;
+
+    ap_uint<DATAWIDTH> config = filter[0];
+    params.mode = config.range(31, 0);
+    params.delimiter = config.range(39, 32);
+    uint32_t num_states = config.range(95, 64);
+    params.matchAll = (num_states == 0);
+    params.fieldDelimiter = config.range(135, 128);
+    uint32_t num_columns = config.range(191, 160);
+    params.numColumns = (num_columns > MAX_COLUMNS) ? MAX_COLUMNS : num_columns;
+    for (int c = 0; c < MAX_COLUMNS; c++) {
+#pragma HLS UNROLL
+        params.columns[c] = config.range(223 + c * 32, 192 + c * 32);
+    }
+    if (params.mode == FILTER_NONE || params.matchAll) return;
+    if (num_states > MAX_STATES) num_states = MAX_STATES;
+
+class_load:
+    for (uint32_t w = 0; w < 256 / c_classPerWord; w++) {
+#pragma HLS PIPELINE II = 1
+        ap_uint<DATAWIDTH> word = filter[1 + w];
+        for (int k = 0; k < c_classPerWord; k++) {
+#pragma HLS UNROLL
+            for (int j = 0; j < NUM_BLOCKS; j++) {
+#pragma HLS UNROLL
+                byte_class[j][w * c_classPerWord + k] = word.range(k * 8 + 7, k * 8);
+            }
+        }
+    }
+
+    // Only the rows of the states in use
+    uint32_t words = (num_states * MAX_CLASSES * 2 + (DATAWIDTH / 8) - 1) / (DATAWIDTH / 8);
+table_load:
+    for (uint32_t w = 0; w < words; w++) {
+        ap_uint<DATAWIDTH> word = filter[1 + 256 / c_classPerWord + w];
+        for (int k = 0; k < c_entryPerWord; k++) {
+#pragma HLS PIPELINE II = 1
+            uint32_t idx = w * c_entryPerWord + k;
+            for (int j = 0; j < NUM_BLOCKS; j++) {
+#pragma HLS UNROLL
+                if (idx < c_entries) next_state[j][idx] = word.range(k * 16 + 15, k * 16);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Record filter of one engine. The content up to and with the first
+ * delimiter (the head) and after the last one (the tail) belong to records
+ * that start or end in another block, they are written out as they are for
+ * the host to join with the neighbouring blocks. Every whole record in
+ * between is run through the automaton, starting from state 0 and without
+ * its delimiter, and written out with its delimiter when a pattern ended in
+ * it; with FILTER_OFFSETS its block offset is written instead, a uint32 LE,
+ * and the tail is not written, the host goes on from its automaton state.
+ *
+ * With FILTER_COLUMNS and FILTER_AGGREGATE the records are split in fields
+ * on the field delimiter as they are read, and the fields of the projected
+ * columns parsed as decimal integers (an optional sign and digits, anything
+ * else is FILTER_NULL). A matching record is written as one int64 LE per
+ * column, or added to col_stats. Records are not held back then, only the
+ * tail; a tail longer than MAX_RECORD is written as a dt_filterParseState
+ * and FILTER_TAIL_PARSED set in tail_state.
+ *
+ * With FILTER_RECORDS records are held back in a MAX_RECORD buffer until
+ * their delimiter, a longer one is written out whole, matching or not, and
+ * left to the host. More offset or column bytes than content bytes set
+ * FILTER_OVERFLOW. A cycle reads a content byte or writes a held back one,
+ * with FILTER_NONE every content byte goes straight out.
+ *
+ * @tparam MAX_RECORD record buffer size
+ * @tparam MAX_STATES states of the transition table
+ * @tparam MAX_CLASSES byte classes of the transition table
+ * @tparam MAX_COLUMNS projected columns
+ *
+ * @param inStream content bytes
+ * @param outStream filtered bytes
+ * @param outStreamEos end of stream flag of outStream
+ * @param outSizeStream bytes written to outStream
+ * @param input_size content bytes of the block
+ * @param params settings of the filter
+ * @param byte_class class of every byte value
+ * @param next_state transition table, FILTER_ACCEPT set on the states a pattern ends in
+ * @param head_size bytes of the head
+ * @param tail_size bytes of the tail
+ * @param tail_state automaton state after the tail, FILTER_ACCEPT set when a pattern occurred in it, and
+ * FILTER_TAIL_PARSED and FILTER_TAIL_ZERO
+ * @param matches whole records holding a pattern
+ * @param status FILTER_OK or FILTER_OVERFLOW
+ * @param col_stats FILTER_AGGREGATE: count, sum, min and max of every column over the matching whole records
+ */
+template <int MAX_RECORD, int MAX_STATES, int MAX_CLASSES, int MAX_COLUMNS>
+void recordFilter(hls::stream<ap_uint<8> >& inStream,
+                  hls::stream<ap_uint<8> >& outStream,
+                  hls::stream<bool>& outStreamEos,
+                  hls::stream<uint32_t>& outSizeStream,
+                  uint32_t input_size,
+                  const recordFilterParams<MAX_COLUMNS>& params,
+                  const ap_uint<8> byte_class[256],
+                  const ap_uint<16> next_state[MAX_STATES * MAX_CLASSES],
+                  uint32_t& head_size,
+                  uint32_t& tail_size,
+                  uint32_t& tail_state,
+                  uint32_t& matches,
+                  uint32_t& status,
+                  dt_columnStats col_stats[MAX_COLUMNS]) {
+    const uint8_t mode = params.mode;
+    const ap_uint<8> delimiter = params.delimiter;
+    ap_uint<8> record[MAX_RECORD];
+    bool pass = (mode == FILTER_NONE);
+    bool project = (mode == FILTER_COLUMNS) || (mode == FILTER_AGGREGATE);
+    // The tail is held back and written at the end
+    bool hold = (mode == FILTER_RECORDS) || project;
+    bool in_head = true;
+    bool tail_done = false;
+    bool long_rec = false;
+    bool matched = false;
+    bool emit_packed = false;
+    bool tail_parsed = false;
+    ap_uint<16> state = 0;
+    // Offset, columns or dt_filterParseState being written
+    ap_uint<64 * MAX_COLUMNS + 192> packed_word = 0;
+    uint32_t in_count = 0;
+    uint32_t out_count = 0;
+    uint32_t head = 0;
+    uint32_t rec_start = 0; // block offset of the record being read
+    uint32_t rec_len = 0;   // bytes of it held back
+    uint32_t rec_total = 0; // bytes of it read
+    bool rec_zero = true;   // and all of them zero
+    uint32_t emit_idx = 0;
+    uint32_t emit_left = 0;
+    uint32_t match_count = 0;
+    uint32_t stat = FILTER_OK;
+
+    // Field being parsed and the projected columns of the record so far
+    uint32_t field = 0;
+    uint32_t field_len = 0;
+    uint64_t value = 0;
+    bool negative = false;
+    bool digits = false;
+    bool numeric = true;
+    int64_t col_val[MAX_COLUMNS];
+    uint64_t col_sum[MAX_COLUMNS];
+    int64_t col_min[MAX_COLUMNS];
+    int64_t col_max[MAX_COLUMNS];
+    uint32_t col_count[MAX_COLUMNS];
+#pragma HLS ARRAY_PARTITION variable = col_val dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = col_sum dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = col_min dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = col_max dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = col_count dim = 0 complete
+    for (int c = 0; c < MAX_COLUMNS; c++) {
+#pragma HLS UNROLL
+        col_val[c] = FILTER_NULL;
+        col_sum[c] = 0;
+        col_min[c] = 0x7fffffffffffffffLL;
+        col_max[c] = FILTER_NULL;
+        col_count[c] = 0;
+    }
+
+record_filter:
+    while ((in_count < input_size) || (emit_left > 0) || !tail_done) {
+#pragma HLS PIPELINE II = 1
+        if (emit_left > 0) {
+            ap_uint<8> byte = emit_packed ? (ap_uint<8>)packed_word.range(7, 0) : record[emit_idx];
+            packed_word >>= 8;
+            emit_idx++;
+            emit_left--;
+            outStream << byte;
+            outStreamEos << 0;
+            out_count++;
+        } else if (in_count == input_size) {
+            // The tail goes out as it is unless FILTER_OFFSETS, the next block holds the rest of its record
+            tail_done = true;
+            if (project && !in_head && (rec_total > MAX_RECORD)) {
+                // Only its start is held back, the host goes on from the parse instead
+                for (int c = 0; c < MAX_COLUMNS; c++) {
+#pragma HLS UNROLL
+                    packed_word.range(c * 64 + 63, c * 64) = (uint64_t)col_val[c];
+                }
+                ap_uint<32> flags = (negative ? FILTER_PARSE_NEGATIVE : 0) | (digits ? FILTER_PARSE_DIGITS : 0) |
+                                    (numeric ? FILTER_PARSE_NUMERIC : 0);
+                packed_word.range(64 * MAX_COLUMNS + 63, 64 * MAX_COLUMNS) = value;
+                packed_word.range(64 * MAX_COLUMNS + 95, 64 * MAX_COLUMNS + 64) = field;
+                packed_word.range(64 * MAX_COLUMNS + 127, 64 * MAX_COLUMNS + 96) = field_len;
+                packed_word.range(64 * MAX_COLUMNS + 159, 64 * MAX_COLUMNS + 128) = flags;
+                packed_word.range(64 * MAX_COLUMNS + 191, 64 * MAX_COLUMNS + 160) =
+                    (uint32_t)state | ((matched || params.matchAll) ? FILTER_ACCEPT : 0);
+                tail_parsed = true;
+                emit_left = 8 * MAX_COLUMNS + 24;
+                emit_packed = true;
+            } else if (hold && !in_head && !long_rec) {
+                emit_idx = 0;
+                emit_left = rec_len;
+                emit_packed = false;
+            }
+        } else if ((mode == FILTER_RECORDS) && !in_head && !long_rec && (rec_len == MAX_RECORD)) {
+            // Too long to hold back, written out whole for the host to check
+            long_rec = true;
+            emit_idx = 0;
+            emit_left = rec_len;
+            emit_packed = false;
+        } else {
+            ap_uint<8> byte = inStream.read();
+            in_count++;
+            if (pass || in_head) {
+                outStream << byte;
+                outStreamEos << 0;
+                out_count++;
+                head++;
+                if (!pass && (byte == delimiter)) {
+                    in_head = false;
+                    rec_start = in_count;
+                }
+            } else {
+                rec_total++;
+                if (byte != 0) rec_zero = false;
+                if (long_rec) {
+                    outStream << byte;
+                    outStreamEos << 0;
+                    out_count++;
+                } else if (hold && (rec_len < MAX_RECORD)) {
+                    record[rec_len++] = byte;
+                }
+
+                // Value of the field the byte ends, if it ends one
+                int64_t field_val = FILTER_NULL;
+                if (numeric && digits) {
+                    field_val = negative ? (int64_t)(0 - value) : (int64_t)value;
+                }
+                int64_t rec_val[MAX_COLUMNS];
+#pragma HLS ARRAY_PARTITION variable = rec_val dim = 0 complete
+                for (int c = 0; c < MAX_COLUMNS; c++) {
+#pragma HLS UNROLL
+                    rec_val[c] = (params.columns[c] == field) ? field_val : col_val[c];
+                }
+
+                if (byte == delimiter) {
+                    if ((matched || params.matchAll) && !long_rec) {
+                        match_count++;
+                        if (mode == FILTER_RECORDS) {
+                            emit_idx = 0;
+                            emit_left = rec_len;
+                            emit_packed = false;
+                        } else if (mode == FILTER_AGGREGATE) {
+                            for (int c = 0; c < MAX_COLUMNS; c++) {
+#pragma HLS UNROLL
+                                if ((c < params.numColumns) && (rec_val[c] != FILTER_NULL)) {
+                                    col_count[c]++;
+                                    col_sum[c] += (uint64_t)rec_val[c];
+                                    if (rec_val[c] < col_min[c]) col_min[c] = rec_val[c];
+                                    if (rec_val[c] > col_max[c]) col_max[c] = rec_val[c];
+                                }
+                            }
+                        } else {
+                            uint32_t bytes = (mode == FILTER_OFFSETS) ? 4 : 8 * params.numColumns;
+                            if (out_count + bytes <= in_count) {
+                                if (mode == FILTER_OFFSETS) {
+                                    packed_word = rec_start;
+                                } else {
+                                    for (int c = 0; c < MAX_COLUMNS; c++) {
+#pragma HLS UNROLL
+                                        packed_word.range(c * 64 + 63, c * 64) = (uint64_t)rec_val[c];
+                                    }
+                                }
+                                emit_left = bytes;
+                                emit_packed = true;
+                            } else {
+                                stat = FILTER_OVERFLOW;
+                            }
+                        }
+                    }
+                    rec_start = in_count;
+                    rec_len = 0;
+                    rec_total = 0;
+                    rec_zero = true;
+                    long_rec = false;
+                    matched = false;
+                    state = 0;
+                    field = 0;
+                    for (int c = 0; c < MAX_COLUMNS; c++) {
+#pragma HLS UNROLL
+                        col_val[c] = FILTER_NULL;
+                    }
+                } else if (!params.matchAll) {
+                    ap_uint<16> entry = next_state[state * MAX_CLASSES + byte_class[byte]];
+                    state = entry & (FILTER_ACCEPT - 1);
+                    if (entry & FILTER_ACCEPT) matched = true;
+                }
+
+                if ((byte == delimiter) || (byte == params.fieldDelimiter)) {
+                    if (byte != delimiter) {
+                        for (int c = 0; c < MAX_COLUMNS; c++) {
+#pragma HLS UNROLL
+                            col_val[c] = rec_val[c];
+                        }
+                        field++;
+                    }
+                    field_len = 0;
+                    value = 0;
+                    negative = false;
+                    digits = false;
+                    numeric = true;
+                } else {
+                    if ((byte >= '0') && (byte <= '9')) {
+                        value = value * 10 + (byte - '0');
+                        digits = true;
+                    } else if ((field_len == 0) && ((byte == '-') || (byte == '+'))) {
+                        negative = (byte == '-');
+                    } else {
+                        numeric = false;
+                    }
+                    field_len++;
+                }
+            }
+        }
+    }
+    outStream << 0;
+    outStreamEos << 1;
+    outSizeStream << out_count;
+
+    head_size = head;
+    tail_size = in_head ? 0 : rec_total;
+    tail_state = (uint32_t)state | ((matched || params.matchAll) ? FILTER_ACCEPT : 0) |
+                 (tail_parsed ? FILTER_TAIL_PARSED : 0) | ((tail_size && rec_zero) ? FILTER_TAIL_ZERO : 0);
+    matches = match_count;
+    status = stat;
+    for (int c = 0; c < MAX_COLUMNS; c++) {
+#pragma HLS UNROLL
+        col_stats[c].sum = (int64_t)col_sum[c];
+        col_stats[c].min = col_min[c];
+        col_stats[c].max = col_max[c];
+        col_stats[c].count = col_count[c];
+        col_stats[c].padding = 0;
+    }
+}
+
+} // namespace compression
+} // namespace xf
+
+#endif // _XFCOMPRESSION_RECORD_FILTER_HPP_
@@ -29,6 +29,7 @@
 #include <assert.h>
 #include <stdint.h>
 #include <stdio.h>
+#include "data_mover.hpp"
 
 #define GET_DIFF_IF_BIG(x, y) (x > y) ? (x - y) : 0
 
@@ -184,247 +185,13 @@ void s2mmEosNb(ap_uint<DATAWIDTH>* out,
      * @param compressedSize size of compressed stream
      * @param output_size output size
      */
-
-    const int c_byteSize = 8;
-    const int c_wordSize = DATAWIDTH / c_byteSize;
-    const int c_maxBurstSize = BURST_SIZE;
-
-    ap_uint<NUM_BLOCKS> is_pending = 1;
-    ap_uint<DATAWIDTH> local_buffer[NUM_BLOCKS][BURST_SIZE];
-#pragma HLS ARRAY_PARTITION variable = local_buffer dim = 1 complete
-#pragma HLS RESOURCE variable = local_buffer core = RAM_2P_LUTRAM
-
-    ap_uint<NUM_BLOCKS> end_of_stream = 0;
-    uint32_t read_size[NUM_BLOCKS];
-    uint32_t write_size[NUM_BLOCKS];
-    uint32_t write_idx[NUM_BLOCKS];
-    uint32_t burst_size[NUM_BLOCKS];
-#pragma HLS ARRAY_PARTITION variable = read_size dim = 0 complete
-#pragma HLS ARRAY_PARTITION variable = write_size dim = 0 complete
-#pragma HLS ARRAY_PARTITION variable = write_idx dim = 0 complete
-#pragma HLS ARRAY_PARTITION variable = burst_size dim = 0 complete
-
-    for (int i = 0; i < NUM_BLOCKS; i++) {
-#pragma HLS UNROLL
-        read_size[i] = 0;
-        write_size[i] = 0;
-        write_idx[i] = 0;
-    }
-
-    bool done = false;
-    uint32_t loc = 0;
-    uint32_t remaining_data = 0;
-
-    while (is_pending != 0) {
-        done = false;
-        for (; done == false;) {
-#pragma HLS PIPELINE II = 1
-            for (uint8_t pb = 0; pb < NUM_BLOCKS; pb++) {
-#pragma HLS UNROLL
-                if (!endOfStream[pb].empty()) {
-                    bool eos_flag = endOfStream[pb].read();
-                    local_buffer[pb][write_idx[pb]] = inStream[pb].read();
-                    if (eos_flag) {
-                        end_of_stream.range(pb, pb) = 1;
-                        done = true;
-                    } else {
-                        read_size[pb] += 1;
-                        write_idx[pb] += 1;
-                    }
-                    if (read_size[pb] >= BURST_SIZE) {
-                        done = true;
-                    }
-                    burst_size[pb] = c_maxBurstSize;
-                    if (end_of_stream.range(pb, pb) && (read_size[pb] - write_size[pb]) < burst_size[pb]) {
-                        burst_size[pb] = (read_size[pb] > write_size[pb]) ? (read_size[pb] - write_size[pb]) : 0;
-                    }
-                }
-            }
-        }
-
-        for (int i = 0; i < NUM_BLOCKS; i++) {
-            // Write the data to global memory
-            if ((read_size[i] > write_size[i]) && (read_size[i] - write_size[i]) >= burst_size[i]) {
-                uint32_t base_addr = output_idx[i] / c_wordSize;
-                uint32_t base_idx = base_addr + write_size[i];
-                uint32_t burst_size_in_words = (burst_size[i]) ? burst_size[i] : 0;
-
-                if (burst_size_in_words > 0) {
-                    for (int j = 0; j < burst_size_in_words; j++) {
-#pragma HLS PIPELINE II = 1
-                        out[base_idx + j] = local_buffer[i][j];
-                    }
-                }
-
-                write_size[i] += burst_size[i];
-                write_idx[i] = 0;
-            }
-        }
-
-        for (int i = 0; i < NUM_BLOCKS; i++) {
-#pragma HLS UNROLL
-            if (end_of_stream.range(i, i)) {
-                is_pending.range(i, i) = 0;
-            } else {
-                is_pending.range(i, i) = 1;
-            }
-        }
-    }
-
+    uint32_t size[NUM_BLOCKS];
+    moverCounters<NUM_BLOCKS> counters;
+    s2mmEosMover<DATAWIDTH, BURST_SIZE, NUM_BLOCKS>(out, output_idx, inStream, endOfStream, compressedSize, size,
+                                                    counters);
     for (uint8_t i = 0; i < NUM_BLOCKS; i++) {
-#pragma HLS PIPELINE II = 1
-        output_size[i] = compressedSize[i].read();
-    }
-}
-
-template <class STREAM_SIZE_DT, int BURST_SIZE, int DATAWIDTH, int NUM_BLOCKS>
-void s2mmEosNbFreq(ap_uint<DATAWIDTH>* out,
-                   const uint32_t output_idx[NUM_BLOCKS],
-                   hls::stream<ap_uint<DATAWIDTH> > inStream[NUM_BLOCKS],
-                   hls::stream<bool> endOfStream[NUM_BLOCKS],
-                   hls::stream<uint32_t> inStreamTree[NUM_BLOCKS],
-                   hls::stream<uint32_t> compressedSize[NUM_BLOCKS],
-                   STREAM_SIZE_DT output_size[NUM_BLOCKS],
-                   const STREAM_SIZE_DT input_size[NUM_BLOCKS],
-                   STREAM_SIZE_DT* dyn_ltree_freq,
-                   STREAM_SIZE_DT* dyn_dtree_freq) {
-    /**
-     * @brief This module reads DATAWIDTH data from stream until end of
-     * stream happens and writes the data to DDR. Reading data from multiple
-     * data streams is non-blocking which is done using empty() API. It also
-     * collects the huffman codes and bit length data and copies to DDR.
-     *
-     * @tparam STREAM_SIZE_DT Stream size class instance
-     * @tparam BURST_SIZE burst size of the data transfers
-     * @tparam DATAWIDTH width of data bus
-     * @tparam NUM_BLOCKS number of blocks
-     *
-     * @param out output global memory address
-     * @param output_idx output index
-     * @param inStream input stream contains final output data
-     * @param endOfStream input stream indicates end of the input stream
-     * @param inStreamTree input stream contains huffman codes and bitlength data
-     * @param compressedSize output stream contains compressed size of each block
-     * @param output_size output global memory address that holds compress sizes
-     * @param input_size input global memory address indicates block size
-     * @param dyn_ltree_freq output literal frequency data
-     * @param dyn_dtree_freq output distance frequency data
-     *
-     */
-    const int c_byteSize = 8;
-    const int c_wordSize = DATAWIDTH / c_byteSize;
-    const int c_maxBurstSize = BURST_SIZE;
-
-    const int c_lTreeSize = 1024;
-    const int c_dTreeSize = 64;
-    const int c_bLTreeSize = 64;
-    const int c_maxCodeSize = 16;
-
-    ap_uint<NUM_BLOCKS> is_pending = 1;
-    ap_uint<DATAWIDTH> local_buffer[NUM_BLOCKS][BURST_SIZE];
-#pragma HLS ARRAY_PARTITION variable = local_buffer dim = 1 complete
-#pragma HLS RESOURCE variable = local_buffer core = RAM_2P_LUTRAM
-
-    ap_uint<NUM_BLOCKS> end_of_stream = 0;
-    uint32_t read_size[NUM_BLOCKS];
-    uint32_t write_size[NUM_BLOCKS];
-    uint32_t write_idx[NUM_BLOCKS];
-    uint32_t burst_size[NUM_BLOCKS];
-#pragma HLS ARRAY_PARTITION variable = read_size dim = 0 complete
-#pragma HLS ARRAY_PARTITION variable = write_size dim = 0 complete
-#pragma HLS ARRAY_PARTITION variable = write_idx dim = 0 complete
-#pragma HLS ARRAY_PARTITION variable = burst_size dim = 0 complete
-
-    for (int i = 0; i < NUM_BLOCKS; i++) {
 #pragma HLS UNROLL
-        read_size[i] = 0;
-        write_size[i] = 0;
-        write_idx[i] = 0;
-    }
-
-    bool done = false;
-    uint32_t loc = 0;
-    uint32_t remaining_data = 0;
-
-    while (is_pending != 0) {
-        done = false;
-        for (; done == false;) {
-#pragma HLS PIPELINE II = 1
-            for (uint8_t pb = 0; pb < NUM_BLOCKS; pb++) {
-#pragma HLS UNROLL
-                if (!endOfStream[pb].empty()) {
-                    bool eos_flag = endOfStream[pb].read();
-                    local_buffer[pb][write_idx[pb]] = inStream[pb].read();
-                    if (eos_flag) {
-                        end_of_stream.range(pb, pb) = 1;
-                        done = true;
-                    } else {
-                        read_size[pb] += 1;
-                        write_idx[pb] += 1;
-                    }
-                    if (read_size[pb] >= BURST_SIZE) {
-                        done = true;
-                    }
-                    burst_size[pb] = c_maxBurstSize;
-                    if (end_of_stream.range(pb, pb) && (read_size[pb] - write_size[pb]) < burst_size[pb]) {
-                        burst_size[pb] = (read_size[pb] > write_size[pb]) ? (read_size[pb] - write_size[pb]) : 0;
-                    }
-                }
-            }
-        }
-
-        for (int i = 0; i < NUM_BLOCKS; i++) {
-            // Write the data to global memory
-            if ((read_size[i] > write_size[i]) && (read_size[i] - write_size[i]) >= burst_size[i]) {
-                uint32_t base_addr = output_idx[i] / c_wordSize;
-                uint32_t base_idx = base_addr + write_size[i];
-                uint32_t burst_size_in_words = (burst_size[i]) ? burst_size[i] : 0;
-
-                if (burst_size_in_words > 0) {
-                    for (int j = 0; j < burst_size_in_words; j++) {
-#pragma HLS PIPELINE II = 1
-                        out[base_idx + j] = local_buffer[i][j];
-                    }
-                }
-                write_size[i] += burst_size[i];
-                write_idx[i] = 0;
-            }
-        }
-
-        for (int i = 0; i < NUM_BLOCKS; i++) {
-#pragma HLS UNROLL
-            if (end_of_stream.range(i, i)) {
-                is_pending.range(i, i) = 0;
-            } else {
-                is_pending.range(i, i) = 1;
-            }
-        }
-    }
-
-    for (uint8_t i = 0; i < NUM_BLOCKS; i++) {
-#pragma HLS PIPELINE II = 1
-        output_size[i] = compressedSize[i].read();
-    }
-
-    uint32_t val = 0;
-    for (uint32_t bIdx = 0; bIdx < NUM_BLOCKS; bIdx++) {
-        bool dist_read = true;
-    s2mm_ltree_freq:
-        for (uint32_t i = 0; i < c_lTreeSize; i++) {
-            val = inStreamTree[bIdx].read();
-            if (val == 9999) {
-                i = c_lTreeSize;
-                dist_read = false;
-            } else {
-                dyn_ltree_freq[bIdx * c_lTreeSize + i] = val;
-            }
-        }
-
-    s2mm_dtree_freq:
-        for (uint32_t j = 0; ((j < c_dTreeSize) && dist_read); j++) {
-            val = inStreamTree[bIdx].read();
-            dyn_dtree_freq[bIdx * c_dTreeSize + j] = val;
-        }
+        output_size[i] = size[i];
     }
 }
 
@@ -574,88 +341,14 @@ void s2mmNb(ap_uint<DATAWIDTH>* out,
      * @param inStream input stream
      * @param input_size input size
      */
-
-    const int c_byteSize = 8;
-    const int c_wordSize = DATAWIDTH / c_byteSize;
-    const int c_maxBurstSize = c_wordSize * BURST_SIZE;
-    uint32_t read_size[NUM_BLOCKS];
-    uint32_t write_size[NUM_BLOCKS];
-    uint32_t burst_size[NUM_BLOCKS];
-    uint32_t write_idx[NUM_BLOCKS];
-#pragma HLS ARRAY_PARTITION variable = input_size dim = 0 complete
-#pragma HLS ARRAY_PARTITION variable = read_size dim = 0 complete
-#pragma HLS ARRAY_PARTITION variable = write_size dim = 0 complete
-#pragma HLS ARRAY_PARTITION variable = write_idx dim = 0 complete
-#pragma HLS ARRAY_PARTITION variable = burst_size dim = 0 complete
-    ap_uint<NUM_BLOCKS> end_of_stream = 0;
-    ap_uint<NUM_BLOCKS> is_pending = 1;
-    ap_uint<DATAWIDTH> local_buffer[NUM_BLOCKS][BURST_SIZE];
-#pragma HLS ARRAY_PARTITION variable = local_buffer dim = 1 complete
-#pragma HLS RESOURCE variable = local_buffer core = RAM_2P_LUTRAM
-
-    // printme("%s:Started\n", __FUNCTION__);
+    uint32_t size[NUM_BLOCKS];
+#pragma HLS ARRAY_PARTITION variable = size dim = 0 complete
     for (int i = 0; i < NUM_BLOCKS; i++) {
 #pragma HLS UNROLL
-        read_size[i] = 0;
-        write_size[i] = 0;
-        write_idx[i] = 0;
-        // printme("%s:Indx=%d out_idx=%d\n",__FUNCTION__,i , output_idx[i]);
-    }
-    bool done = false;
-    uint32_t loc = 0;
-    uint32_t remaining_data = 0;
-    while (is_pending != 0) {
-        done = false;
-        for (int i = 0; (is_pending != 0) && (done == 0); i++) {
-#pragma HLS PIPELINE II = 1
-            for (uint8_t pb = 0; pb < NUM_BLOCKS; pb++) {
-#pragma HLS UNROLL
-                burst_size[pb] = c_maxBurstSize;
-                if (((input_size[pb] - write_size[pb]) < burst_size[pb])) {
-                    burst_size[pb] = (input_size[pb] > write_size[pb]) ? (input_size[pb] - write_size[pb]) : 0;
-                }
-                if (((read_size[pb] - write_size[pb]) < burst_size[pb]) && (input_size[pb] > read_size[pb])) {
-                    bool is_empty = inStream[pb].empty();
-                    if (!is_empty) {
-                        local_buffer[pb][write_idx[pb]] = inStream[pb].read();
-                        write_idx[pb] += 1;
-                        read_size[pb] += c_wordSize;
-                        is_pending.range(pb, pb) = true;
-                    } else {
-                        is_pending.range(pb, pb) = false;
-                    }
-                } else {
-                    if (burst_size[pb]) done = true;
-                }
-            }
-        }
-
-        for (int i = 0; i < NUM_BLOCKS; i++) {
-            // Write the data to global memory
-            if ((read_size[i] > write_size[i]) && (read_size[i] - write_size[i]) >= burst_size[i]) {
-                uint32_t base_addr = output_idx[i] + write_size[i];
-                uint32_t base_idx = base_addr / c_wordSize;
-                uint32_t burst_size_in_words = (burst_size[i]) ? ((burst_size[i] - 1) / c_wordSize + 1) : 0;
-
-                if (burst_size_in_words > 0) {
-                    for (int j = 0; j < burst_size_in_words; j++) {
-#pragma HLS PIPELINE II = 1
-                        out[base_idx + j] = local_buffer[i][j];
-                    }
-                }
-                write_size[i] += burst_size[i];
-                write_idx[i] = 0;
-            }
-        }
-        for (int i = 0; i < NUM_BLOCKS; i++) {
-#pragma HLS UNROLL
-            if (done == true && (write_size[i] >= input_size[i])) {
-                is_pending.range(i, i) = 0;
-            } else {
-                is_pending.range(i, i) = 1;
-            }
-        }
+        size[i] = input_size[i];
     }
+    moverCounters<NUM_BLOCKS> counters;
+    s2mmMover<DATAWIDTH, BURST_SIZE, NUM_BLOCKS>(out, output_idx, inStream, size, counters);
 }
 
 template <int BURST_SIZE, int DATAWIDTH, int NUM_BLOCKS>
@@ -0,0 +1,248 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_SNAPPY_COMPRESS_HPP_
+#define _XFCOMPRESSION_SNAPPY_COMPRESS_HPP_
+
+/**
+ * @file snappy_compress.hpp
+ * @brief Header for the Snappy encoder stage of the LZ compression engines.
+ *
+ * The match pipeline (lzCompress, lzBestMatchFilter, lzBooster) and the
+ * literal / match split of lz4CompressPart1 are the ones of LZ4, only the
+ * element encoding differs.
+ *
+ * This file is part of Vitis Data Compression Library.
+ */
+
+#include "hls_stream.h"
+
+#include <ap_int.h>
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "lz4_compress.hpp"
+
+namespace xf {
+namespace compression {
+namespace details {
+
+/**
+ * @brief Tag byte of the next copy element of a match, as the reference
+ * encoder splits it: 64 byte copies while 68 or more bytes are left, a 60
+ * byte one to keep the last copy at 4 bytes or more, then 1 byte offset
+ * copies for 4 ~ 11 bytes below offset 2048 and 2 byte offset copies
+ * otherwise.
+ *
+ * @param match_length bytes of the match still to encode
+ * @param match_offset match offset, 1 ~ 65535
+ * @param copy_length bytes this element covers
+ * @param one_byte_offset the element is a copy with a 1 byte offset
+ */
+inline ap_uint<8> snappyCopyTag(uint16_t match_length,
+                                uint16_t match_offset,
+                                uint16_t& copy_length,
+                                bool& one_byte_offset) {
+#pragma HLS INLINE
+    if (match_length >= 68) {
+        copy_length = 64;
+    } else if (match_length > 64) {
+        copy_length = 60;
+    } else {
+        copy_length = match_length;
+    }
+    one_byte_offset = (copy_length < 12) && (match_offset < 2048);
+    ap_uint<8> tag;
+    if (one_byte_offset) {
+        tag = 0x01 | ((copy_length - 4) << 2) | ((match_offset >> 8) << 5);
+    } else {
+        tag = 0x02 | ((copy_length - 1) << 2);
+    }
+    return tag;
+}
+
+/**
+ * @brief Writes the literal runs and matches of lz4CompressPart1 as a raw
+ * Snappy block: the content size as a varint, then literal and copy
+ * elements. Like lz4CompressPart2 the output stops at input_size bytes, the
+ * host stores such blocks.
+ *
+ * @param in_lit_inStream literals
+ * @param in_lenOffset_Stream literal count, match length - 4 and offset - 1
+ * @param outStream output data
+ * @param endOfStream end of stream flag of outStream
+ * @param compressdSizeStream size of the Snappy block
+ * @param input_size bytes of the input block
+ */
+static void snappyCompressPart2(hls::stream<uint8_t>& in_lit_inStream,
+                                hls::stream<lz4_compressd_dt>& in_lenOffset_Stream,
+                                hls::stream<ap_uint<8> >& outStream,
+                                hls::stream<bool>& endOfStream,
+                                hls::stream<uint32_t>& compressdSizeStream,
+                                uint32_t input_size) {
+    enum snappyCompressStates {
+        WRITE_PREAMBLE,
+        WRITE_TOKEN,
+        WRITE_LIT_LEN,
+        WRITE_LITERAL,
+        WRITE_COPY,
+        WRITE_OFFSET0,
+        WRITE_OFFSET1
+    };
+    uint32_t compressedSize = 0;
+    uint32_t preamble = input_size;
+    // Engines without a block write nothing, not even the preamble
+    enum snappyCompressStates next_state = input_size ? WRITE_PREAMBLE : WRITE_TOKEN;
+    uint16_t lit_length = 0;
+    uint16_t write_lit_length = 0;
+    uint8_t lit_len_bytes = 0;
+    uint16_t lit_len_value = 0;
+    uint16_t match_length = 0;
+    uint16_t match_offset = 0;
+    uint16_t copy_length = 0;
+    bool one_byte_offset = false;
+    bool lit_ending = false;
+
+snappy_compress:
+    for (uint32_t inIdx = 0; (inIdx < input_size) || (next_state != WRITE_TOKEN);) {
+#pragma HLS PIPELINE II = 1
+        ap_uint<8> outValue;
+        bool write = true;
+        if (next_state == WRITE_PREAMBLE) {
+            outValue = (preamble & 0x7F) | ((preamble > 0x7F) ? 0x80 : 0);
+            preamble >>= 7;
+            if (preamble == 0) next_state = WRITE_TOKEN;
+        } else if (next_state == WRITE_TOKEN) {
+            lz4_compressd_dt tmpValue = in_lenOffset_Stream.read();
+            lit_length = tmpValue.range(63, 32);
+            uint16_t token_match = tmpValue.range(15, 0);
+            uint16_t token_offset = tmpValue.range(31, 16);
+            inIdx += token_match + lit_length + 4;
+            lit_ending = false;
+            if (token_match == 777 && token_offset == 777) {
+                inIdx = input_size;
+                lit_ending = true;
+            }
+            // The closing literal run reads past the block, a match of 4 at
+            // offset 1 ends inside it
+            if (token_offset == 0 && token_match == 0 && inIdx > input_size) {
+                lit_ending = true;
+            }
+            match_length = token_match + 4;
+            match_offset = token_offset + 1;
+            write_lit_length = lit_length;
+            if (lit_length) {
+                // Literal tag: length - 1 in the tag up to 59, in 1 or 2 more bytes above
+                uint16_t n = lit_length - 1;
+                if (n < 60) {
+                    outValue = n << 2;
+                    next_state = WRITE_LITERAL;
+                } else {
+                    lit_len_bytes = (n < 256) ? 1 : 2;
+                    lit_len_value = n;
+                    outValue = (59 + lit_len_bytes) << 2;
+                    next_state = WRITE_LIT_LEN;
+                }
+            } else if (lit_ending) {
+                write = false;
+            } else {
+                outValue = snappyCopyTag(match_length, match_offset, copy_length, one_byte_offset);
+                next_state = one_byte_offset ? WRITE_OFFSET1 : WRITE_OFFSET0;
+            }
+        } else if (next_state == WRITE_LIT_LEN) {
+            // Length - 1, low byte first
+            outValue = lit_len_value & 0xFF;
+            lit_len_value >>= 8;
+            lit_len_bytes--;
+            if (lit_len_bytes == 0) next_state = WRITE_LITERAL;
+        } else if (next_state == WRITE_LITERAL) {
+            outValue = in_lit_inStream.read();
+            write_lit_length--;
+            if (write_lit_length == 0) next_state = lit_ending ? WRITE_TOKEN : WRITE_COPY;
+        } else if (next_state == WRITE_COPY) {
+            outValue = snappyCopyTag(match_length, match_offset, copy_length, one_byte_offset);
+            next_state = one_byte_offset ? WRITE_OFFSET1 : WRITE_OFFSET0;
+        } else if (next_state == WRITE_OFFSET0) {
+            outValue = match_offset & 0xFF;
+            next_state = WRITE_OFFSET1;
+        } else if (next_state == WRITE_OFFSET1) {
+            // Low byte of a 1 byte offset, high byte of a 2 byte one
+            outValue = one_byte_offset ? (match_offset & 0xFF) : (match_offset >> 8);
+            match_length -= copy_length;
+            next_state = match_length ? WRITE_COPY : WRITE_TOKEN;
+        }
+        if (write && compressedSize < input_size) {
+            // Limiting compression size not more than input size.
+            // Host code should ignore such blocks
+            outStream << outValue;
+            endOfStream << 0;
+            compressedSize++;
+        }
+    }
+
+    compressdSizeStream << compressedSize;
+    outStream << 0;
+    endOfStream << 1;
+}
+
+} // namespace details
+} // namespace compression
+} // namespace xf
+
+namespace xf {
+namespace compression {
+
+/**
+ * @brief Snappy counterpart of lz4Compress: splits the matches of the LZ
+ * match pipeline into literals and matches, then writes them as a raw
+ * Snappy block (varint content size, literal and copy elements).
+ *
+ * @param inStream Input data stream
+ * @param outStream Output data stream
+ * @param max_lit_limit set when a literal run reached MAX_LIT_COUNT, the block is stored
+ * @param input_size Size of input data
+ * @param endOfStream Stream indicating that all data is processed or not
+ * @param compressdSizeStream Gives the compressed size for each block
+ * @param index engine of max_lit_limit
+ */
+template <int MAX_LIT_COUNT, int PARALLEL_UNITS>
+static void snappyCompress(hls::stream<compressd_dt>& inStream,
+                           hls::stream<ap_uint<8> >& outStream,
+                           uint32_t max_lit_limit[PARALLEL_UNITS],
+                           uint32_t input_size,
+                           hls::stream<bool>& endOfStream,
+                           hls::stream<uint32_t>& compressdSizeStream,
+                           uint32_t index) {
+    hls::stream<uint8_t> lit_outStream("lit_outStream");
+    hls::stream<lz4_compressd_dt> lenOffset_Stream("lenOffset_Stream");
+
+#pragma HLS STREAM variable = lit_outStream depth = MAX_LIT_COUNT
+#pragma HLS STREAM variable = lenOffset_Stream depth = c_gmemBurstSize
+
+#pragma HLS RESOURCE variable = lit_outStream core = FIFO_SRL
+#pragma HLS RESOURCE variable = lenOffset_Stream core = FIFO_SRL
+
+#pragma HLS dataflow
+    details::lz4CompressPart1<MAX_LIT_COUNT, PARALLEL_UNITS>(inStream, lit_outStream, lenOffset_Stream, input_size,
+                                                             max_lit_limit, index);
+    details::snappyCompressPart2(lit_outStream, lenOffset_Stream, outStream, endOfStream, compressdSizeStream,
+                                 input_size);
+}
+
+} // namespace compression
+} // namespace xf
+#endif // _XFCOMPRESSION_SNAPPY_COMPRESS_HPP_
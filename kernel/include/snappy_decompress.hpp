@@ -0,0 +1,130 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_SNAPPY_DECOMPRESS_HPP_
+#define _XFCOMPRESSION_SNAPPY_DECOMPRESS_HPP_
+
+/**
+ * @file snappy_decompress.hpp
+ * @brief Header for the Snappy element parser of the LZ decompression
+ * engines. It turns a raw Snappy block into the literal / match symbols of
+ * lzDecompress, the same as lz4DecompressSimple does for an LZ4 block.
+ *
+ * This file is part of Vitis Data Compression Library.
+ */
+
+#include "hls_stream.h"
+#include "lz_decompress.hpp"
+
+#include <ap_int.h>
+#include <stdint.h>
+
+namespace xf {
+namespace compression {
+
+/**
+ * @brief Parses a raw Snappy block: skips the varint content size, then
+ * writes a symbol per literal byte and per copy element. Copy offsets above
+ * 65535 cannot occur in a framed chunk of 64KB and copies of 1 byte cannot
+ * be told from a literal by lzDecompress, encoders never write them.
+ *
+ * @param inStream Snappy block
+ * @param outStream literal (length field 0) and match (length - 1, offset - 1) symbols
+ * @param input_size bytes of the block
+ * @param uncomp_flag the block is stored, all input bytes are literals
+ */
+inline void snappyDecompressSimple(hls::stream<ap_uint<8> >& inStream,
+                                   hls::stream<compressd_dt>& outStream,
+                                   uint32_t input_size,
+                                   bool uncomp_flag) {
+    enum snappyDecompressStates { READ_PREAMBLE, READ_TAG, READ_LIT_LEN, READ_LITERAL, READ_OFFSET };
+    enum snappyDecompressStates next_state = READ_PREAMBLE;
+    ap_uint<32> lit_len = 0;
+    uint8_t len_bytes = 0;
+    uint8_t len_idx = 0;
+    uint32_t match_len = 0;
+    ap_uint<32> offset = 0;
+    if (uncomp_flag == 1) {
+        next_state = READ_LITERAL;
+        lit_len = input_size;
+    }
+snappy_decompressr:
+    for (uint32_t i = 0; i < input_size; i++) {
+#pragma HLS PIPELINE II = 1
+        ap_uint<8> inValue = inStream.read();
+        if (next_state == READ_PREAMBLE) {
+            if (inValue.range(7, 7) == 0) next_state = READ_TAG;
+        } else if (next_state == READ_TAG) {
+            ap_uint<6> tagValue = inValue.range(7, 2);
+            len_idx = 0;
+            offset = 0;
+            if (inValue.range(1, 0) == 0) {
+                // Literal, length - 1 in the tag or in 1 ~ 4 more bytes
+                if (tagValue < 60) {
+                    lit_len = tagValue + 1;
+                    next_state = READ_LITERAL;
+                } else {
+                    lit_len = 0;
+                    len_bytes = tagValue - 59;
+                    next_state = READ_LIT_LEN;
+                }
+            } else if (inValue.range(1, 0) == 1) {
+                // Copy with 3 bits of length - 4 and 11 bits of offset
+                match_len = inValue.range(4, 2) + 4;
+                offset.range(10, 8) = inValue.range(7, 5);
+                len_bytes = 1;
+                next_state = READ_OFFSET;
+            } else {
+                // Copy with 6 bits of length - 1 and a 2 or 4 byte offset
+                match_len = tagValue + 1;
+                len_bytes = (inValue.range(1, 0) == 2) ? 2 : 4;
+                next_state = READ_OFFSET;
+            }
+        } else if (next_state == READ_LIT_LEN) {
+            lit_len.range(len_idx * 8 + 7, len_idx * 8) = inValue;
+            len_idx++;
+            if (len_idx == len_bytes) {
+                lit_len++;
+                next_state = READ_LITERAL;
+            }
+        } else if (next_state == READ_LITERAL) {
+            compressd_dt outValue = 0;
+            outValue.range(7, 0) = inValue;
+            outStream << outValue;
+            lit_len--;
+            if (lit_len == 0) next_state = READ_TAG;
+        } else if (next_state == READ_OFFSET) {
+            // Low byte first, a 1 byte offset only completes the tag's bits
+            if (len_bytes == 1) {
+                offset.range(7, 0) = inValue;
+            } else {
+                offset.range(len_idx * 8 + 7, len_idx * 8) = inValue;
+            }
+            len_idx++;
+            if (len_idx == len_bytes) {
+                compressd_dt outValue = 0;
+                outValue.range(31, 16) = match_len - 1;
+                outValue.range(15, 0) = offset - 1;
+                outStream << outValue;
+                next_state = READ_TAG;
+            }
+        }
+    }
+}
+
+} // namespace compression
+} // namespace xf
+#endif // _XFCOMPRESSION_SNAPPY_DECOMPRESS_HPP_
@@ -0,0 +1,117 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_SNAPPY_PACKER_HPP_
+#define _XFCOMPRESSION_SNAPPY_PACKER_HPP_
+
+/**
+ * @file snappy_packer.hpp
+ * @brief Header for module used in LZ4 packer kernel to write the Snappy
+ * framing format.
+ *
+ * This file is part of Vitis Data Compression Library.
+ */
+
+#include "hls_stream.h"
+
+#include <ap_int.h>
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+
+namespace xf {
+namespace compression {
+
+/**
+ * @brief Packs the Snappy blocks of one file into a Snappy framing format
+ * stream. The stream identifier chunk comes first on the input stream, as
+ * made by the host, then every block becomes a chunk: a compressed data
+ * chunk, or an uncompressed one for stored blocks (bit 31 of their size),
+ * with the masked CRC32C of the block content xilLz4Compress wrote. The
+ * format has no end mark, the stream ends after the last chunk.
+ *
+ * @tparam PACK_WIDTH packed data width
+ * @tparam PARLLEL_BYTE parallel byte count
+ *
+ * @param inStream input data, stream identifier first
+ * @param outStream output data
+ * @param inStreamSize size of the data in input stream
+ * @param outStreamSize output words of every part
+ * @param no_blocks number of input blocks
+ * @param block_crc masked CRC32C of every block
+ * @return bytes of the stream
+ */
+template <int PACK_WIDTH, int PARLLEL_BYTE>
+uint32_t snappyPacker(hls::stream<ap_uint<PACK_WIDTH> >& inStream,
+                      hls::stream<ap_uint<PACK_WIDTH> >& outStream,
+                      hls::stream<uint32_t>& inStreamSize,
+                      hls::stream<uint32_t>& outStreamSize,
+                      uint32_t no_blocks,
+                      const uint32_t* block_crc) {
+    const uint32_t c_chunkHeader = SNAPPY_CHUNK_HEADER_SIZE + SNAPPY_CHUNK_CRC_SIZE;
+    ap_uint<2 * PACK_WIDTH> lcl_buffer = 0;
+    uint32_t lbuf_idx = 0;
+    uint32_t endSizeCnt = 0;
+
+packer:
+    for (uint32_t blkIdx = 0; blkIdx < no_blocks + 1; blkIdx++) {
+        uint32_t block_header = inStreamSize.read();
+        uint32_t size = block_header & 0x7FFFFFFF;
+        uint32_t header = (blkIdx != 0) ? c_chunkHeader : 0;
+
+        outStreamSize << (lbuf_idx + header + size) / 8;
+        endSizeCnt += header + size;
+
+        if (blkIdx != 0) {
+            ap_uint<64> chunk_header = block_crc[blkIdx - 1];
+            chunk_header <<= 32;
+            chunk_header.range(31, 8) = size + SNAPPY_CHUNK_CRC_SIZE;
+            chunk_header.range(7, 0) =
+                (block_header & 0x80000000) ? SNAPPY_CHUNK_UNCOMPRESSED : SNAPPY_CHUNK_COMPRESSED;
+            lcl_buffer.range((lbuf_idx * 8) + 63, lbuf_idx * 8) = chunk_header;
+            lbuf_idx += c_chunkHeader;
+            outStream << lcl_buffer.range(63, 0);
+            lcl_buffer >>= PACK_WIDTH;
+            lbuf_idx -= 8;
+        }
+
+        uint32_t chunk_size = 0;
+    pack_post:
+        for (uint32_t i = 0; i < size; i += PARLLEL_BYTE) {
+#pragma HLS PIPELINE II = 1
+            chunk_size = (i + PARLLEL_BYTE > size) ? size - i : PARLLEL_BYTE;
+            lcl_buffer.range((lbuf_idx * 8) + PACK_WIDTH - 1, lbuf_idx * 8) = inStream.read();
+            lbuf_idx += chunk_size;
+
+            if (lbuf_idx >= 8) {
+                outStream << lcl_buffer.range(63, 0);
+                lcl_buffer >>= PACK_WIDTH;
+                lbuf_idx -= 8;
+            }
+        }
+    }
+
+    if (lbuf_idx) {
+        outStreamSize << 1;
+        outStream << lcl_buffer.range(63, 0);
+    }
+    outStreamSize << 0;
+    return endSizeCnt;
+}
+
+} // namespace compression
+} // namespace xf
+#endif // _XFCOMPRESSION_SNAPPY_PACKER_HPP_
@@ -118,8 +118,8 @@ void streamDownSizerP2PComp(hls::stream<ap_uint<IN_WIDTH> >& inStream,
     ap_uint<IN_WIDTH> inBuffer = 0;
 
     for (int size = inStreamSize.read(); size != 0; size = inStreamSize.read()) {
-        // input size interms of 512width * 64 bytes after downsizing
-        uint32_t sizeOutputV = (size - 1) / c_out_word + 1;
+        // input size interms of 512width * 64 bytes after downsizing, bit 31 flags a stored block
+        uint32_t sizeOutputV = ((size & 0x7FFFFFFF) - 1) / c_out_word + 1;
 
         // Send ouputSize of the module
         outStreamSize << size;
@@ -0,0 +1,123 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_XXHASH32_HPP_
+#define _XFCOMPRESSION_XXHASH32_HPP_
+
+/**
+ * @file xxhash32.hpp
+ * @brief Streaming XXH32 for the LZ4 frame block and content checksums.
+ *
+ * The state takes up to 8 bytes per update and runs a 16 byte stripe
+ * through the four lanes whenever its buffer fills. The lanes do not
+ * depend on each other, only a lane on its own previous value.
+ *
+ * This file is part of Vitis Data Compression Library.
+ */
+#include <ap_int.h>
+#include <stdint.h>
+
+namespace xf {
+namespace compression {
+namespace details {
+
+const uint32_t c_xxh32Prime1 = 2654435761U;
+const uint32_t c_xxh32Prime2 = 2246822519U;
+const uint32_t c_xxh32Prime3 = 3266489917U;
+const uint32_t c_xxh32Prime4 = 668265263U;
+const uint32_t c_xxh32Prime5 = 374761393U;
+
+struct xxh32State {
+    uint32_t lane[4];
+    uint64_t total;      // bytes hashed so far
+    ap_uint<192> buffer; // bytes not yet part of a stripe, low bytes first
+    uint32_t bufferSize;
+};
+
+inline uint32_t xxh32Rotl(uint32_t x, uint32_t r) {
+    return (x << r) | (x >> (32 - r));
+}
+
+inline uint32_t xxh32Round(uint32_t acc, uint32_t input) {
+    acc += input * c_xxh32Prime2;
+    acc = xxh32Rotl(acc, 13);
+    return acc * c_xxh32Prime1;
+}
+
+inline void xxh32Reset(xxh32State& state, uint32_t seed) {
+    state.lane[0] = seed + c_xxh32Prime1 + c_xxh32Prime2;
+    state.lane[1] = seed + c_xxh32Prime2;
+    state.lane[2] = seed;
+    state.lane[3] = seed - c_xxh32Prime1;
+    state.total = 0;
+    state.buffer = 0;
+    state.bufferSize = 0;
+}
+
+/**
+ * @brief Appends the low bytes (1 ~ 8) of word to the hash.
+ */
+inline void xxh32Update(xxh32State& state, ap_uint<64> word, uint32_t bytes) {
+#pragma HLS INLINE
+    state.buffer.range(state.bufferSize * 8 + 63, state.bufferSize * 8) = word;
+    state.bufferSize += bytes;
+    state.total += bytes;
+    if (state.bufferSize >= 16) {
+        for (int l = 0; l < 4; l++) {
+#pragma HLS UNROLL
+            state.lane[l] = xxh32Round(state.lane[l], state.buffer.range(l * 32 + 31, l * 32));
+        }
+        state.buffer >>= 128;
+        state.bufferSize -= 16;
+    }
+}
+
+inline uint32_t xxh32Digest(const xxh32State& state, uint32_t seed) {
+    uint32_t h32;
+    if (state.total >= 16) {
+        h32 = xxh32Rotl(state.lane[0], 1) + xxh32Rotl(state.lane[1], 7) + xxh32Rotl(state.lane[2], 12) +
+              xxh32Rotl(state.lane[3], 18);
+    } else {
+        h32 = seed + c_xxh32Prime5;
+    }
+    h32 += (uint32_t)state.total;
+
+    // At most 15 bytes left: up to three words, then up to three bytes
+    uint32_t idx = 0;
+    for (; idx + 4 <= state.bufferSize; idx += 4) {
+#pragma HLS LOOP_TRIPCOUNT min = 0 max = 3
+        h32 += (uint32_t)state.buffer.range(idx * 8 + 31, idx * 8) * c_xxh32Prime3;
+        h32 = xxh32Rotl(h32, 17) * c_xxh32Prime4;
+    }
+    for (; idx < state.bufferSize; idx++) {
+#pragma HLS LOOP_TRIPCOUNT min = 0 max = 3
+        h32 += (uint32_t)state.buffer.range(idx * 8 + 7, idx * 8) * c_xxh32Prime5;
+        h32 = xxh32Rotl(h32, 11) * c_xxh32Prime1;
+    }
+
+    h32 ^= h32 >> 15;
+    h32 *= c_xxh32Prime2;
+    h32 ^= h32 >> 13;
+    h32 *= c_xxh32Prime3;
+    h32 ^= h32 >> 16;
+    return h32;
+}
+
+} // namespace details
+} // namespace compression
+} // namespace xf
+
+#endif // _XFCOMPRESSION_XXHASH32_HPP_
@@ -0,0 +1,116 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_ZONE_MAP_HPP_
+#define _XFCOMPRESSION_ZONE_MAP_HPP_
+
+/**
+ * @file zone_map.hpp
+ * @brief Record parse of the block zone maps shared by xilLz4Compress and the host.
+ *
+ * A zone map holds the record count of a block and the min and max of one
+ * numeric field of its records (dt_zoneConfig, dt_zoneMap in lz4_p2p.hpp),
+ * so that readers skip the blocks a value range rules out without
+ * decompressing them. The field is read as an optional sign and decimal
+ * digits, wrapping at 64 bits; spaces around them are ignored, as fixed
+ * width fields are padded with them. A missing field or any other text has
+ * no value.
+ */
+
+#include <stdint.h>
+#include "lz4_p2p.hpp"
+
+// zoneParse::flags
+#define ZONE_PARSE_SIGN 1
+#define ZONE_PARSE_NEGATIVE 2
+#define ZONE_PARSE_DIGITS 4
+#define ZONE_PARSE_END 8 // a space after the sign or digits
+#define ZONE_PARSE_INVALID 16
+
+// Parse of the record being read
+struct zoneParse {
+    uint32_t pos;   // bytes of the record so far
+    uint32_t field; // field delimiters of the record so far
+    uint64_t value; // digits of the field so far
+    uint32_t flags; // ZONE_PARSE_*
+};
+
+inline void zoneParseReset(zoneParse& parse) {
+    parse.pos = 0;
+    parse.field = 0;
+    parse.value = 0;
+    parse.flags = 0;
+}
+
+// Reads the next byte of a record, not its delimiter
+inline void zoneParseByte(const dt_zoneConfig& config, zoneParse& parse, uint8_t byte) {
+    bool in_field;
+    if (config.layout == ZONE_FIELD_FIXED) {
+        in_field = (parse.pos >= config.offset) && (parse.pos - config.offset < config.width);
+    } else if (byte == config.fieldDelimiter) {
+        parse.field++;
+        in_field = false;
+    } else {
+        in_field = (parse.field == config.column);
+    }
+    parse.pos++;
+    if (!in_field) return;
+
+    uint32_t flags = parse.flags;
+    bool started = flags & (ZONE_PARSE_SIGN | ZONE_PARSE_DIGITS);
+    if (byte == ' ') {
+        if (started) flags |= ZONE_PARSE_END;
+    } else if (flags & ZONE_PARSE_END) {
+        flags |= ZONE_PARSE_INVALID;
+    } else if (byte >= '0' && byte <= '9') {
+        parse.value = parse.value * 10 + (byte - '0');
+        flags |= ZONE_PARSE_DIGITS;
+    } else if ((byte == '-' || byte == '+') && !started) {
+        flags |= ZONE_PARSE_SIGN | ((byte == '-') ? ZONE_PARSE_NEGATIVE : 0);
+    } else {
+        flags |= ZONE_PARSE_INVALID;
+    }
+    parse.flags = flags;
+}
+
+// Value of the field of the record the parse went through, false when it has none
+inline bool zoneParseValue(const zoneParse& parse, int64_t& value) {
+    if ((parse.flags & (ZONE_PARSE_DIGITS | ZONE_PARSE_INVALID)) != ZONE_PARSE_DIGITS) return false;
+    value = (int64_t)((parse.flags & ZONE_PARSE_NEGATIVE) ? 0 - parse.value : parse.value);
+    return true;
+}
+
+// Empty zone map of a block of size bytes, no delimiter seen
+inline void zoneMapReset(dt_zoneMap& zone, uint32_t size) {
+    zone.min = 0;
+    zone.max = 0;
+    zone.records = 0;
+    zone.values = 0;
+    zone.head = size;
+    zone.tail = 0;
+}
+
+// Counts the record the parse went through in zone
+inline void zoneMapAdd(dt_zoneMap& zone, const zoneParse& parse) {
+    int64_t value;
+    zone.records++;
+    if (!zoneParseValue(parse, value)) return;
+    if (zone.values == 0 || value < zone.min) zone.min = value;
+    if (zone.values == 0 || value > zone.max) zone.max = value;
+    zone.values++;
+}
+
+#endif // _XFCOMPRESSION_ZONE_MAP_HPP_
@@ -0,0 +1,81 @@
+#!/bin/bash
+#
+# Summarize one PARALLEL_BLOCK build variant.
+#
+# usage: variant_report.sh <report_dir> <engines> <csim_log>
+#
+# Resource use comes from the HLS csynth report of each kernel. Throughput is
+# measured: csim_log is the output of the csim testbench built with the same
+# engine count, which gives the cycles per byte of the kernel on its corpus and
+# the MB/s they make at KERNEL_FREQUENCY.
+
+REPORT_DIR=$1
+ENGINES=$2
+CSIM_LOG=$3
+
+if [ -z "$REPORT_DIR" ] || [ -z "$ENGINES" ] || [ -z "$CSIM_LOG" ]; then
+    echo "usage: $0 <report_dir> <engines> <csim_log>"
+    exit 1
+fi
+
+# Print "BRAM_18K URAM LUT FF" from the Total row of the csynth utilization
+# table. Columns are located by header name since their order differs between
+# Vitis releases.
+utilization() {
+    awk -F'|' '
+        /== Utilization Estimates/ { in_util = 1 }
+        in_util && /Name/ && !hdr {
+            for (i = 1; i <= NF; i++) {
+                gsub(/ /, "", $i)
+                col[$i] = i
+            }
+            hdr = 1
+        }
+        in_util && hdr && $2 ~ /^Total/ {
+            for (i = 1; i <= NF; i++) gsub(/ /, "", $i)
+            printf "%s %s %s %s\n", $col["BRAM_18K"], $col["URAM"], $col["LUT"], $col["FF"]
+            exit
+        }' "$1"
+}
+
+# Print "cycles/B MB/s corpus" of a csim testbench unit. The unit name is the
+# fixed width column after the corpus, the numbers end the line before the
+# MATCH / MISMATCH verdict.
+measured() {
+    awk -v unit="$2" '
+        {
+            name = substr($0, 17, 40)
+            sub(/ +$/, "", name)
+        }
+        name == unit {
+            if ($NF != "MATCH") {
+                printf "MISMATCH MISMATCH %s\n", $1
+            } else {
+                printf "%s %s %s\n", $(NF - 2), $(NF - 1), $1
+            }
+            exit
+        }' "$1"
+}
+
+printf "%-22s %8s %9s %6s %9s %9s %10s %10s  %s\n" "kernel" "engines" "BRAM_18K" "URAM" "LUT" "FF" "cycles/B" "csim MB/s" "corpus"
+for kernel in xilLz4Compress xilLz4P2PDecompress; do
+    rpt=$(find "$REPORT_DIR" -name "${kernel}_csynth.rpt" 2>/dev/null | head -n 1)
+    if [ -z "$rpt" ]; then
+        echo "$kernel: csynth report not found under $REPORT_DIR" >&2
+        bram=n/a uram=n/a lut=n/a ff=n/a
+    else
+        read -r bram uram lut ff <<< "$(utilization "$rpt")"
+    fi
+
+    # One compute unit on the kernel frame, so the engines of the variant bound the decompress side too
+    unit=$kernel
+    if [ "$kernel" = "xilLz4P2PDecompress" ]; then
+        unit="kernel frame xilLz4P2PDecompress x1"
+    fi
+    read -r cycles mbps corpus <<< "$(measured "$CSIM_LOG" "$unit")"
+    if [ -z "$cycles" ]; then
+        echo "$kernel: '$unit' not found in $CSIM_LOG" >&2
+        cycles=n/a mbps=n/a
+    fi
+    printf "%-22s %8s %9s %6s %9s %9s %10s %10s  %s\n" "$kernel" "$ENGINES" "$bram" "$uram" "$lut" "$ff" "$cycles" "$mbps" "$corpus"
+done
@@ -0,0 +1,434 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+/**
+ * @file gzip_compress_mm.cpp
+ * @brief Source for Deflate (GZIP/zlib) compression kernel.
+ *
+ * This file is part of Vitis Data Compression Library.
+ */
+
+#include "gzip_compress_mm.hpp"
+
+const int c_gmemBurstSize = (2 * GMEM_BURST_SIZE);
+// lz77Divide frequency words: literal/length tree, then distance tree
+const int c_ltreeWords = 1024;
+const int c_dtreeWords = 64;
+
+/**
+ * @brief Keeps the frequencies lz77Divide sends after the symbols of a
+ * block, the codes Deflate uses of them.
+ *
+ * @param treeStream lz77Divide frequencies, one word without a block
+ * @param litFreq literal/length frequencies
+ * @param distFreq distance frequencies
+ * @param input_size block size, 0 for no block
+ */
+void gzipFreqCollect(hls::stream<uint32_t>& treeStream,
+                     uint32_t litFreq[DEFLATE_LITERAL_CODES],
+                     uint32_t distFreq[DEFLATE_DISTANCE_CODES],
+                     uint32_t input_size) {
+    if (input_size == 0) {
+        treeStream.read();
+        return;
+    }
+ltree:
+    for (uint32_t i = 0; i < c_ltreeWords; i++) {
+#pragma HLS PIPELINE II = 1
+        uint32_t freq = treeStream.read();
+        if (i < DEFLATE_LITERAL_CODES) litFreq[i] = freq;
+    }
+dtree:
+    for (uint32_t i = 0; i < c_dtreeWords; i++) {
+#pragma HLS PIPELINE II = 1
+        uint32_t freq = treeStream.read();
+        if (i < DEFLATE_DISTANCE_CODES) distFreq[i] = freq;
+    }
+}
+
+void gzipLz77Core(hls::stream<xf::compression::uintMemWidth_t>& inStreamMemWidth,
+                  hls::stream<xf::compression::uintMemWidth_t>& outStreamMemWidth,
+                  hls::stream<bool>& outStreamMemWidthEos,
+                  hls::stream<uint32_t>& symbolSize,
+                  uint32_t litFreq[DEFLATE_LITERAL_CODES],
+                  uint32_t distFreq[DEFLATE_DISTANCE_CODES],
+                  uint32_t input_size) {
+    hls::stream<ap_uint<8> > inStream("inStream");
+    hls::stream<xf::compression::compressd_dt> compressdStream("compressdStream");
+    hls::stream<xf::compression::compressd_dt> bestMatchStream("bestMatchStream");
+    hls::stream<xf::compression::compressd_dt> boosterStream("boosterStream");
+    hls::stream<ap_uint<32> > lz77Out("lz77Out");
+    hls::stream<bool> lz77OutEos("lz77OutEos");
+    hls::stream<uint32_t> treeStream("treeStream");
+#pragma HLS STREAM variable = inStream depth = 8
+#pragma HLS STREAM variable = compressdStream depth = 8
+#pragma HLS STREAM variable = bestMatchStream depth = 8
+#pragma HLS STREAM variable = boosterStream depth = 8
+#pragma HLS STREAM variable = lz77Out depth = 8
+#pragma HLS STREAM variable = lz77OutEos depth = 8
+#pragma HLS STREAM variable = treeStream depth = 8
+
+#pragma HLS RESOURCE variable = inStream core = FIFO_SRL
+#pragma HLS RESOURCE variable = compressdStream core = FIFO_SRL
+#pragma HLS RESOURCE variable = bestMatchStream core = FIFO_SRL
+#pragma HLS RESOURCE variable = boosterStream core = FIFO_SRL
+#pragma HLS RESOURCE variable = lz77Out core = FIFO_SRL
+#pragma HLS RESOURCE variable = lz77OutEos core = FIFO_SRL
+#pragma HLS RESOURCE variable = treeStream core = FIFO_SRL
+
+#pragma HLS dataflow
+    xf::compression::details::streamDownsizer<uint32_t, GMEM_DWIDTH, 8>(inStreamMemWidth, inStream, input_size);
+    xf::compression::lzCompress<MATCH_LEN, MIN_MATCH, LZ_MAX_OFFSET_LIMIT>(inStream, compressdStream, input_size);
+    xf::compression::lzBestMatchFilter<MATCH_LEN, OFFSET_WINDOW>(compressdStream, bestMatchStream, input_size);
+    xf::compression::lzBooster<MAX_MATCH_LEN, OFFSET_WINDOW>(bestMatchStream, boosterStream, input_size);
+    xf::compression::lz77Divide(boosterStream, lz77Out, lz77OutEos, treeStream, symbolSize, input_size);
+    gzipFreqCollect(treeStream, litFreq, distFreq, input_size);
+    xf::compression::details::upsizerEos<32, GMEM_DWIDTH>(lz77Out, lz77OutEos, outStreamMemWidth,
+                                                          outStreamMemWidthEos);
+}
+
+void gzipHuffmanCore(hls::stream<xf::compression::uintMemWidth_t>& inStreamMemWidth,
+                     hls::stream<xf::compression::uintMemWidth_t>& outStreamMemWidth,
+                     hls::stream<bool>& outStreamMemWidthEos,
+                     hls::stream<uint32_t>& compressedSize,
+                     const xf::compression::deflateTree& tree,
+                     uint32_t symbol_bytes) {
+    hls::stream<ap_uint<32> > symbolStream("symbolStream");
+    hls::stream<ap_uint<64> > huffOut("huffOut");
+    hls::stream<bool> huffOutEos("huffOutEos");
+#pragma HLS STREAM variable = symbolStream depth = 8
+#pragma HLS STREAM variable = huffOut depth = 8
+#pragma HLS STREAM variable = huffOutEos depth = 8
+
+#pragma HLS RESOURCE variable = symbolStream core = FIFO_SRL
+#pragma HLS RESOURCE variable = huffOut core = FIFO_SRL
+#pragma HLS RESOURCE variable = huffOutEos core = FIFO_SRL
+
+#pragma HLS dataflow
+    xf::compression::details::streamDownsizer<uint32_t, GMEM_DWIDTH, 32>(inStreamMemWidth, symbolStream,
+                                                                          symbol_bytes);
+    xf::compression::deflateHuffman(symbolStream, huffOut, huffOutEos, compressedSize, tree,
+                                    symbol_bytes / GZIP_SYMBOL_BYTES);
+    xf::compression::details::upsizerEos<64, GMEM_DWIDTH>(huffOut, huffOutEos, outStreamMemWidth,
+                                                          outStreamMemWidthEos);
+}
+
+/**
+ * @brief CRC32 or Adler32 of a batch of blocks in content order, for the
+ * trailers. Runs next to the engines and carries the state over to the next
+ * batch, as lz4ContentChecksum does.
+ *
+ * @param in input raw data
+ * @param content_idx byte offset of each block
+ * @param content_size bytes of each block, 0 for no block
+ * @param content_file file of each block
+ * @param adler Adler32 instead of CRC32
+ * @param state checksum of cur_file
+ * @param cur_file file the state belongs to
+ * @param content_checksum checksum of every file
+ */
+void gzipContentChecksum(const xf::compression::uintMemWidth_t* in,
+                         const uint32_t content_idx[PARALLEL_BLOCK],
+                         const uint32_t content_size[PARALLEL_BLOCK],
+                         const uint32_t content_file[PARALLEL_BLOCK],
+                         bool adler,
+                         xf::compression::details::gzipChecksumState& state,
+                         uint32_t& cur_file,
+                         uint32_t* content_checksum) {
+    const int c_wordBytes = GMEM_DWIDTH / 8;
+    const int c_laneBytes = 8;
+    xf::compression::uintMemWidth_t word;
+blocks:
+    for (uint32_t j = 0; j < PARALLEL_BLOCK; j++) {
+        uint32_t start = content_idx[j];
+        uint32_t size = content_size[j];
+        if (size == 0) continue;
+        if (content_file[j] != cur_file) {
+            content_checksum[cur_file] = xf::compression::details::gzipChecksumDigest(state, adler);
+            xf::compression::details::gzipChecksumReset(state);
+            cur_file = content_file[j];
+        }
+        uint32_t words = (size - 1) / c_wordBytes + 1;
+    content:
+        for (uint32_t i = 0; i < words * (c_wordBytes / c_laneBytes); i++) {
+#pragma HLS PIPELINE II = 1
+            uint32_t pos = i * c_laneBytes;
+            uint32_t part = i % (c_wordBytes / c_laneBytes);
+            if (part == 0) word = in[(start + pos) / c_wordBytes];
+            if (pos < size) {
+                uint32_t bytes = (pos + c_laneBytes > size) ? size - pos : c_laneBytes;
+                xf::compression::details::gzipChecksumUpdate(state, word.range(part * 64 + 63, part * 64), bytes,
+                                                             adler);
+            }
+        }
+    }
+}
+
+/**
+ * @brief LZ77 pass of a batch: the symbols of every block to lz77_out and
+ * its frequencies, the content checksum next to it.
+ */
+void gzipLz77(const xf::compression::uintMemWidth_t* in,
+              xf::compression::uintMemWidth_t* lz77_out,
+              const uint32_t input_idx[PARALLEL_BLOCK],
+              const uint32_t symbol_idx[PARALLEL_BLOCK],
+              const uint32_t input_size[PARALLEL_BLOCK],
+              uint32_t symbol_size[PARALLEL_BLOCK],
+              uint32_t litFreq[PARALLEL_BLOCK][DEFLATE_LITERAL_CODES],
+              uint32_t distFreq[PARALLEL_BLOCK][DEFLATE_DISTANCE_CODES],
+              xf::compression::details::moverCounters<PARALLEL_BLOCK>& rdCounters,
+              xf::compression::details::moverCounters<PARALLEL_BLOCK>& wrCounters,
+              const uint32_t content_idx[PARALLEL_BLOCK],
+              const uint32_t content_size[PARALLEL_BLOCK],
+              const uint32_t content_file[PARALLEL_BLOCK],
+              bool adler,
+              xf::compression::details::gzipChecksumState& content_state,
+              uint32_t& content_cur,
+              uint32_t* content_checksum) {
+    hls::stream<xf::compression::uintMemWidth_t> inStreamMemWidth[PARALLEL_BLOCK];
+    hls::stream<bool> outStreamMemWidthEos[PARALLEL_BLOCK];
+    hls::stream<xf::compression::uintMemWidth_t> outStreamMemWidth[PARALLEL_BLOCK];
+#pragma HLS STREAM variable = outStreamMemWidthEos depth = 2
+#pragma HLS STREAM variable = inStreamMemWidth depth = c_gmemBurstSize
+#pragma HLS STREAM variable = outStreamMemWidth depth = c_gmemBurstSize
+
+#pragma HLS RESOURCE variable = outStreamMemWidthEos core = FIFO_SRL
+#pragma HLS RESOURCE variable = inStreamMemWidth core = FIFO_SRL
+#pragma HLS RESOURCE variable = outStreamMemWidth core = FIFO_SRL
+
+    hls::stream<uint32_t> symbolSize[PARALLEL_BLOCK];
+
+#pragma HLS dataflow
+    xf::compression::details::mm2sMover<GMEM_DWIDTH, GMEM_BURST_SIZE, PARALLEL_BLOCK, GMEM_OUTSTANDING, GMEM_INTERLEAVE>(
+        in, input_idx, inStreamMemWidth, input_size, rdCounters);
+
+    for (uint8_t i = 0; i < PARALLEL_BLOCK; i++) {
+#pragma HLS UNROLL
+        gzipLz77Core(inStreamMemWidth[i], outStreamMemWidth[i], outStreamMemWidthEos[i], symbolSize[i], litFreq[i],
+                     distFreq[i], input_size[i]);
+    }
+
+    xf::compression::details::s2mmEosMover<GMEM_DWIDTH, GMEM_BURST_SIZE, PARALLEL_BLOCK, GMEM_OUTSTANDING,
+                                           GMEM_INTERLEAVE>(lz77_out, symbol_idx, outStreamMemWidth,
+                                                            outStreamMemWidthEos, symbolSize, symbol_size,
+                                                            wrCounters);
+
+    gzipContentChecksum(in, content_idx, content_size, content_file, adler, content_state, content_cur,
+                        content_checksum);
+}
+
+/**
+ * @brief Huffman pass of a batch: the symbols of every block read back from
+ * lz77_out and encoded with its trees into out.
+ */
+void gzipHuffman(const xf::compression::uintMemWidth_t* lz77_out,
+                 xf::compression::uintMemWidth_t* out,
+                 const uint32_t symbol_idx[PARALLEL_BLOCK],
+                 const uint32_t output_idx[PARALLEL_BLOCK],
+                 const uint32_t symbol_size[PARALLEL_BLOCK],
+                 uint32_t output_size[PARALLEL_BLOCK],
+                 const xf::compression::deflateTree tree[PARALLEL_BLOCK],
+                 xf::compression::details::moverCounters<PARALLEL_BLOCK>& rdCounters,
+                 xf::compression::details::moverCounters<PARALLEL_BLOCK>& wrCounters) {
+    hls::stream<xf::compression::uintMemWidth_t> inStreamMemWidth[PARALLEL_BLOCK];
+    hls::stream<bool> outStreamMemWidthEos[PARALLEL_BLOCK];
+    hls::stream<xf::compression::uintMemWidth_t> outStreamMemWidth[PARALLEL_BLOCK];
+#pragma HLS STREAM variable = outStreamMemWidthEos depth = 2
+#pragma HLS STREAM variable = inStreamMemWidth depth = c_gmemBurstSize
+#pragma HLS STREAM variable = outStreamMemWidth depth = c_gmemBurstSize
+
+#pragma HLS RESOURCE variable = outStreamMemWidthEos core = FIFO_SRL
+#pragma HLS RESOURCE variable = inStreamMemWidth core = FIFO_SRL
+#pragma HLS RESOURCE variable = outStreamMemWidth core = FIFO_SRL
+
+    hls::stream<uint32_t> compressedSize[PARALLEL_BLOCK];
+
+#pragma HLS dataflow
+    xf::compression::details::mm2sMover<GMEM_DWIDTH, GMEM_BURST_SIZE, PARALLEL_BLOCK, GMEM_OUTSTANDING, GMEM_INTERLEAVE>(
+        lz77_out, symbol_idx, inStreamMemWidth, symbol_size, rdCounters);
+
+    for (uint8_t i = 0; i < PARALLEL_BLOCK; i++) {
+#pragma HLS UNROLL
+        gzipHuffmanCore(inStreamMemWidth[i], outStreamMemWidth[i], outStreamMemWidthEos[i], compressedSize[i],
+                        tree[i], symbol_size[i]);
+    }
+
+    xf::compression::details::s2mmEosMover<GMEM_DWIDTH, GMEM_BURST_SIZE, PARALLEL_BLOCK, GMEM_OUTSTANDING,
+                                           GMEM_INTERLEAVE>(out, output_idx, outStreamMemWidth, outStreamMemWidthEos,
+                                                            compressedSize, output_size, wrCounters);
+}
+
+extern "C" {
+/**
+ * @brief Deflate compression kernel.
+ *
+ * @param in input raw data
+ * @param out Deflate blocks, one block size stride per block
+ * @param compressd_size output size of each block, the block size for stored blocks
+ * @param block_desc input blocks, of one or more files
+ * @param lz77_out LZ77 symbols of a batch
+ * @param content_checksum CRC32 / Adler32 of every file
+ * @param block_size_in_kb input block size in KB
+ * @param no_blocks number of entries in block_desc
+ * @param frame_flags FRAME_ZLIB or 0
+ * @param stats statistics record (KERNEL_STATS builds only)
+ */
+void xilGzipCompress(const xf::compression::uintMemWidth_t* in,
+                     xf::compression::uintMemWidth_t* out,
+                     uint32_t* compressd_size,
+                     dt_blockDesc* block_desc,
+                     xf::compression::uintMemWidth_t* lz77_out,
+                     uint32_t* content_checksum,
+                     uint32_t block_size_in_kb,
+                     uint32_t no_blocks,
+                     uint32_t frame_flags
+#ifdef KERNEL_STATS
+                     ,
+                     dt_kernelStats* stats
+#endif
+                     ) {
+#pragma HLS INTERFACE m_axi port = in offset = slave bundle = gmem0 max_read_burst_length = GMEM_BURST_SIZE \
+    num_read_outstanding = GMEM_AXI_OUTSTANDING
+#pragma HLS INTERFACE m_axi port = out offset = slave bundle = gmem0 max_write_burst_length = GMEM_BURST_SIZE \
+    num_write_outstanding = GMEM_AXI_OUTSTANDING
+#pragma HLS INTERFACE m_axi port = lz77_out offset = slave bundle = gmem0 max_read_burst_length = \
+    GMEM_BURST_SIZE max_write_burst_length = GMEM_BURST_SIZE
+#pragma HLS INTERFACE m_axi port = compressd_size offset = slave bundle = gmem1
+#pragma HLS INTERFACE m_axi port = block_desc offset = slave bundle = gmem1
+#pragma HLS INTERFACE m_axi port = content_checksum offset = slave bundle = gmem1
+#pragma HLS INTERFACE s_axilite port = in bundle = control
+#pragma HLS INTERFACE s_axilite port = out bundle = control
+#pragma HLS INTERFACE s_axilite port = compressd_size bundle = control
+#pragma HLS INTERFACE s_axilite port = block_desc bundle = control
+#pragma HLS INTERFACE s_axilite port = lz77_out bundle = control
+#pragma HLS INTERFACE s_axilite port = content_checksum bundle = control
+#pragma HLS INTERFACE s_axilite port = block_size_in_kb bundle = control
+#pragma HLS INTERFACE s_axilite port = no_blocks bundle = control
+#pragma HLS INTERFACE s_axilite port = frame_flags bundle = control
+#ifdef KERNEL_STATS
+#pragma HLS INTERFACE m_axi port = stats offset = slave bundle = gmem1
+#pragma HLS INTERFACE s_axilite port = stats bundle = control
+#endif
+#pragma HLS INTERFACE s_axilite port = return bundle = control
+
+    uint32_t block_idx = 0;
+    uint32_t max_block_size = block_size_in_kb * 1024;
+
+    bool stored[PARALLEL_BLOCK];
+    uint32_t desc_size[PARALLEL_BLOCK];
+    uint32_t input_block_size[PARALLEL_BLOCK];
+    uint32_t input_idx[PARALLEL_BLOCK];
+    uint32_t symbol_idx[PARALLEL_BLOCK];
+    uint32_t symbol_size[PARALLEL_BLOCK];
+    uint32_t output_idx[PARALLEL_BLOCK];
+    uint32_t output_block_size[PARALLEL_BLOCK];
+    uint32_t content_idx[PARALLEL_BLOCK];
+    uint32_t content_size[PARALLEL_BLOCK];
+    uint32_t content_file[PARALLEL_BLOCK];
+    uint32_t litFreq[PARALLEL_BLOCK][DEFLATE_LITERAL_CODES];
+    uint32_t distFreq[PARALLEL_BLOCK][DEFLATE_DISTANCE_CODES];
+    xf::compression::deflateTree tree[PARALLEL_BLOCK];
+#pragma HLS ARRAY_PARTITION variable = input_block_size dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = input_idx dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = symbol_idx dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = symbol_size dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = output_idx dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = output_block_size dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = content_idx dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = content_size dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = content_file dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = litFreq dim = 1 complete
+#pragma HLS ARRAY_PARTITION variable = distFreq dim = 1 complete
+#pragma HLS ARRAY_PARTITION variable = tree dim = 1 complete
+    xf::compression::details::moverCounters<PARALLEL_BLOCK> rdCounters;
+    xf::compression::details::moverCounters<PARALLEL_BLOCK> wrCounters;
+    bool adler = (frame_flags & FRAME_ZLIB);
+    xf::compression::details::gzipChecksumState content_state;
+    xf::compression::details::gzipChecksumReset(content_state);
+    uint32_t content_cur = block_desc[0].fileId;
+
+#ifdef KERNEL_STATS
+    dt_kernelStats kStats;
+    xf::compression::details::statsReset(kStats, PARALLEL_BLOCK);
+#endif
+
+    for (uint32_t i = 0; i < no_blocks; i += PARALLEL_BLOCK) {
+        uint32_t nblocks = PARALLEL_BLOCK;
+        if ((i + PARALLEL_BLOCK) > no_blocks) {
+            nblocks = no_blocks - i;
+        }
+
+        for (uint32_t j = 0; j < PARALLEL_BLOCK; j++) {
+            if (j < nblocks) {
+                dt_blockDesc desc = block_desc[i + j];
+                desc_size[j] = desc.size;
+                content_idx[j] = desc.srcOffset;
+                content_size[j] = desc.size;
+                content_file[j] = desc.fileId;
+                // Small blocks skip the engines, the packer stores them
+                stored[j] = (desc.size < MIN_BLOCK_SIZE);
+                input_block_size[j] = stored[j] ? 0 : desc.size;
+                input_idx[j] = stored[j] ? 0 : desc.srcOffset;
+            } else {
+                stored[j] = 0;
+                input_block_size[j] = 0;
+                input_idx[j] = 0;
+                content_size[j] = 0;
+            }
+            symbol_idx[j] = j * GZIP_SYMBOL_BYTES * max_block_size;
+            output_idx[j] = (i + j) * max_block_size;
+            symbol_size[j] = 0;
+            output_block_size[j] = 0;
+        }
+
+        gzipLz77(in, lz77_out, input_idx, symbol_idx, input_block_size, symbol_size, litFreq, distFreq, rdCounters,
+                 wrCounters, content_idx, content_size, content_file, adler, content_state, content_cur,
+                 content_checksum);
+#ifdef KERNEL_STATS
+        xf::compression::details::statsAddMovers<PARALLEL_BLOCK>(kStats, rdCounters, wrCounters);
+#endif
+
+        // Trees of every block; blocks Huffman coding does not make smaller are stored
+    treegen:
+        for (uint32_t j = 0; j < PARALLEL_BLOCK; j++) {
+            if (input_block_size[j] == 0) continue;
+            uint32_t encoded = xf::compression::deflateTreegen(litFreq[j], distFreq[j], tree[j]);
+            if (encoded >= input_block_size[j]) {
+                stored[j] = 1;
+                symbol_size[j] = 0;
+            }
+        }
+
+        gzipHuffman(lz77_out, out, symbol_idx, output_idx, symbol_size, output_block_size, tree, rdCounters,
+                    wrCounters);
+#ifdef KERNEL_STATS
+        xf::compression::details::statsAddMovers<PARALLEL_BLOCK>(kStats, rdCounters, wrCounters);
+#endif
+
+        for (uint32_t k = 0; k < nblocks; k++) {
+            compressd_size[block_idx] = stored[k] ? desc_size[k] : output_block_size[k];
+#ifdef KERNEL_STATS
+            if (stored[k]) kStats.rawBlocks++;
+#endif
+            block_idx++;
+        }
+    }
+    content_checksum[content_cur] = xf::compression::details::gzipChecksumDigest(content_state, adler);
+#ifdef KERNEL_STATS
+    stats[0] = kStats;
+#endif
+}
+}
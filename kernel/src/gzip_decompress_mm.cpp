@@ -0,0 +1,207 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+/**
+ * @file gzip_decompress_mm.cpp
+ * @brief Source for Deflate (GZIP/zlib) decompression kernel.
+ *
+ * This file is part of Vitis Data Compression Library.
+ */
+
+#include "gzip_decompress_mm.hpp"
+
+const int c_gmemBurstSize = (2 * GMEM_BURST_SIZE);
+
+typedef ap_uint<8> uintV_t;
+
+/**
+ * @brief Passes the content bytes on to the upsizer and takes the CRC32 or
+ * Adler32 of them on the way.
+ *
+ * @param inStream content bytes
+ * @param inStreamEos end of stream flag of inStream
+ * @param outStream the same bytes
+ * @param outStreamEos end of stream flag of outStream
+ * @param zlib Adler32 instead of CRC32
+ * @param checksum checksum of the content
+ */
+void gzipDecChecksum(hls::stream<uintV_t>& inStream,
+                     hls::stream<bool>& inStreamEos,
+                     hls::stream<uintV_t>& outStream,
+                     hls::stream<bool>& outStreamEos,
+                     bool zlib,
+                     uint32_t& checksum) {
+    xf::compression::details::gzipChecksumState state;
+    xf::compression::details::gzipChecksumReset(state);
+checksum:
+    for (bool eos = inStreamEos.read(); eos == false; eos = inStreamEos.read()) {
+#pragma HLS PIPELINE II = 1
+        uintV_t byte = inStream.read();
+        xf::compression::details::gzipChecksumUpdate(state, byte, 1, zlib);
+        outStream << byte;
+        outStreamEos << 0;
+    }
+    outStream << inStream.read();
+    outStreamEos << 1;
+    checksum = xf::compression::details::gzipChecksumDigest(state, zlib);
+}
+
+/**
+ * @brief Writes the content words up to the end of the output buffer and
+ * drops the rest.
+ *
+ * @param out output content
+ * @param inStream content words
+ * @param inStreamEos end of stream flag of inStream
+ * @param output_size bytes of the output buffer
+ */
+void gzipDecWriter(xf::compression::uintMemWidth_t* out,
+                   hls::stream<xf::compression::uintMemWidth_t>& inStream,
+                   hls::stream<bool>& inStreamEos,
+                   uint32_t output_size) {
+    const uint32_t c_wordBytes = GMEM_DWIDTH / 8;
+    uint32_t words = output_size / c_wordBytes;
+    uint32_t idx = 0;
+write:
+    for (bool eos = inStreamEos.read(); eos == false; eos = inStreamEos.read()) {
+#pragma HLS PIPELINE II = 1
+        xf::compression::uintMemWidth_t word = inStream.read();
+        if (idx < words) out[idx] = word;
+        idx++;
+    }
+    inStream.read();
+}
+
+void gzipDec(const xf::compression::uintMemWidth_t* in,
+             xf::compression::uintMemWidth_t* out,
+             uint32_t input_size,
+             uint32_t output_size,
+             bool zlib,
+             uint32_t& content_size,
+             uint32_t& checksum,
+             uint32_t trailer[2],
+             bool& status) {
+    hls::stream<xf::compression::uintMemWidth_t> inStreamMemWidth("inStreamMemWidth");
+    hls::stream<ap_uint<64> > inStream64("inStream64");
+    hls::stream<xf::compression::compressd_dt> symbolStream("symbolStream");
+    hls::stream<bool> symbolStreamEos("symbolStreamEos");
+    hls::stream<uintV_t> contentStream("contentStream");
+    hls::stream<bool> contentStreamEos("contentStreamEos");
+    hls::stream<uintV_t> checkedStream("checkedStream");
+    hls::stream<bool> checkedStreamEos("checkedStreamEos");
+    hls::stream<xf::compression::uintMemWidth_t> outStreamMemWidth("outStreamMemWidth");
+    hls::stream<bool> outStreamMemWidthEos("outStreamMemWidthEos");
+    hls::stream<uint32_t> trailerStream("trailerStream");
+    hls::stream<bool> statusStream("statusStream");
+    hls::stream<uint32_t> sizeStream("sizeStream");
+#pragma HLS STREAM variable = inStreamMemWidth depth = c_gmemBurstSize
+#pragma HLS STREAM variable = inStream64 depth = 8
+#pragma HLS STREAM variable = symbolStream depth = 8
+#pragma HLS STREAM variable = symbolStreamEos depth = 8
+#pragma HLS STREAM variable = contentStream depth = 8
+#pragma HLS STREAM variable = contentStreamEos depth = 8
+#pragma HLS STREAM variable = checkedStream depth = 8
+#pragma HLS STREAM variable = checkedStreamEos depth = 8
+#pragma HLS STREAM variable = outStreamMemWidth depth = c_gmemBurstSize
+#pragma HLS STREAM variable = outStreamMemWidthEos depth = c_gmemBurstSize
+#pragma HLS RESOURCE variable = inStreamMemWidth core = FIFO_SRL
+#pragma HLS RESOURCE variable = inStream64 core = FIFO_SRL
+#pragma HLS RESOURCE variable = symbolStream core = FIFO_SRL
+#pragma HLS RESOURCE variable = symbolStreamEos core = FIFO_SRL
+#pragma HLS RESOURCE variable = contentStream core = FIFO_SRL
+#pragma HLS RESOURCE variable = contentStreamEos core = FIFO_SRL
+#pragma HLS RESOURCE variable = checkedStream core = FIFO_SRL
+#pragma HLS RESOURCE variable = checkedStreamEos core = FIFO_SRL
+#pragma HLS RESOURCE variable = outStreamMemWidth core = FIFO_SRL
+#pragma HLS RESOURCE variable = outStreamMemWidthEos core = FIFO_SRL
+
+#pragma HLS dataflow
+    xf::compression::details::mm2sSimple<GMEM_DWIDTH, GMEM_BURST_SIZE>(in, inStreamMemWidth, input_size);
+    xf::compression::details::streamDownsizer<uint32_t, GMEM_DWIDTH, 64>(inStreamMemWidth, inStream64, input_size);
+    xf::compression::inflateHuffman(inStream64, symbolStream, symbolStreamEos, trailerStream, statusStream, input_size,
+                                    zlib);
+    xf::compression::lzDecompressZlibEos<INFLATE_HISTORY_SIZE>(symbolStream, symbolStreamEos, contentStream,
+                                                               contentStreamEos, sizeStream);
+    gzipDecChecksum(contentStream, contentStreamEos, checkedStream, checkedStreamEos, zlib, checksum);
+    xf::compression::details::upsizerEos<8, GMEM_DWIDTH>(checkedStream, checkedStreamEos, outStreamMemWidth,
+                                                         outStreamMemWidthEos);
+    gzipDecWriter(out, outStreamMemWidth, outStreamMemWidthEos, output_size);
+
+    content_size = sizeStream.read();
+    trailer[0] = trailerStream.read();
+    trailer[1] = trailerStream.read();
+    status = statusStream.read();
+}
+
+extern "C" {
+void xilGzipDecompress(const xf::compression::uintMemWidth_t* in,
+                       xf::compression::uintMemWidth_t* out,
+                       uint32_t* result,
+                       uint32_t input_size,
+                       uint32_t output_size,
+                       uint32_t frame_flags
+#ifdef KERNEL_STATS
+                       ,
+                       dt_kernelStats* stats
+#endif
+                       ) {
+#pragma HLS INTERFACE m_axi port = in offset = slave bundle = gmem max_read_burst_length = GMEM_BURST_SIZE
+#pragma HLS INTERFACE m_axi port = out offset = slave bundle = gmem max_write_burst_length = GMEM_BURST_SIZE
+#pragma HLS INTERFACE m_axi port = result offset = slave bundle = gmem
+#pragma HLS INTERFACE s_axilite port = in bundle = control
+#pragma HLS INTERFACE s_axilite port = out bundle = control
+#pragma HLS INTERFACE s_axilite port = result bundle = control
+#pragma HLS INTERFACE s_axilite port = input_size bundle = control
+#pragma HLS INTERFACE s_axilite port = output_size bundle = control
+#pragma HLS INTERFACE s_axilite port = frame_flags bundle = control
+#ifdef KERNEL_STATS
+#pragma HLS INTERFACE m_axi port = stats offset = slave bundle = gmem
+#pragma HLS INTERFACE s_axilite port = stats bundle = control
+#endif
+#pragma HLS INTERFACE s_axilite port = return bundle = control
+
+    bool zlib = (frame_flags & FRAME_ZLIB);
+    uint32_t content_size = 0;
+    uint32_t checksum = 0;
+    uint32_t trailer[2];
+    bool decoded = false;
+
+    gzipDec(in, out, input_size, output_size, zlib, content_size, checksum, trailer, decoded);
+
+    // ISIZE is the content size modulo 2^32, zlib streams carry no size
+    uint32_t status = INFLATE_OK;
+    if (!decoded) {
+        status = INFLATE_BAD_STREAM;
+    } else if (checksum != trailer[0] || (!zlib && content_size != trailer[1])) {
+        status = INFLATE_TRAILER_MISMATCH;
+    }
+    result[0] = content_size;
+    result[1] = status;
+
+#ifdef KERNEL_STATS
+    // GMEM words of the busier of the input and output ports
+    dt_kernelStats kStats;
+    xf::compression::details::statsReset(kStats, 0);
+    kStats.bytesIn = input_size;
+    kStats.bytesOut = (content_size < output_size) ? content_size : output_size;
+    uint64_t maxBytes = (kStats.bytesIn > kStats.bytesOut) ? kStats.bytesIn : kStats.bytesOut;
+    kStats.moverBeats = (maxBytes + GMEM_DWIDTH / 8 - 1) / (GMEM_DWIDTH / 8);
+    kStats.bursts = (input_size - 1) / (GMEM_BURST_SIZE * GMEM_DWIDTH / 8) + 1 +
+                    (kStats.bytesOut + GMEM_BURST_SIZE * GMEM_DWIDTH / 8 - 1) / (GMEM_BURST_SIZE * GMEM_DWIDTH / 8);
+    stats[0] = kStats;
+#endif
+}
+}
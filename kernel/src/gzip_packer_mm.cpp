@@ -0,0 +1,176 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+/**
+ * @file gzip_packer_mm.cpp
+ * @brief Source for GZIP packer kernel.
+ *
+ * This file is part of Vitis Data Compression Library.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "gzip_packer_mm.hpp"
+
+// Packs the member of one file
+void gzip(const uint512_t* in,
+          uint512_t* out,
+          uint512_t* head_prev_blk,
+          uint32_t* compressd_size,
+          dt_blockDesc* block_desc,
+          uint32_t* encoded_size,
+          uint512_t* orig_input_data,
+          uint32_t no_blocks,
+          uint32_t head_res_size,
+          uint32_t block_size_in_kb,
+          bool zlib,
+          uint32_t checksum,
+          uint32_t isize) {
+    hls::stream<uint512_t> inStream512("inStream512_mm2s");
+    hls::stream<uintV_t> inStreamV("inStreamV_dsizer");
+    hls::stream<uintV_t> packStreamV("packerStreamOut");
+    hls::stream<uint512_t> outStream512("UpsizeStreamOut");
+#pragma HLS STREAM variable = inStream512 depth = c_gmem_burst_size
+#pragma HLS STREAM variable = inStreamV depth = c_gmem_burst_size
+#pragma HLS STREAM variable = packStreamV depth = c_gmem_burst_size
+#pragma HLS STREAM variable = outStream512 depth = c_gmem_burst_size
+
+#pragma HLS RESOURCE variable = inStream512 core = FIFO_SRL
+#pragma HLS RESOURCE variable = inStreamV core = FIFO_SRL
+#pragma HLS RESOURCE variable = packStreamV core = FIFO_SRL
+#pragma HLS RESOURCE variable = outStream512 core = FIFO_SRL
+
+    hls::stream<uint32_t> mm2sStreamSize("mm2sOutSize");
+    hls::stream<uint32_t> downStreamSize("dstreamOutSize");
+    hls::stream<uint32_t> packStreamSize("packOutSize");
+    hls::stream<uint32_t> upStreamSize("upStreamSize");
+#pragma HLS STREAM variable = mm2sStreamSize depth = c_gmem_burst_size
+#pragma HLS STREAM variable = downStreamSize depth = c_gmem_burst_size
+#pragma HLS STREAM variable = packStreamSize depth = c_gmem_burst_size
+
+#pragma HLS RESOURCE variable = mm2sStreamSize core = FIFO_SRL
+#pragma HLS RESOURCE variable = downStreamSize core = FIFO_SRL
+#pragma HLS RESOURCE variable = packStreamSize core = FIFO_SRL
+#pragma HLS RESOURCE variable = upStreamSize core = FIFO_SRL
+
+#pragma HLS dataflow
+    xf::compression::details::mm2s<GMEM_DWIDTH, GMEM_BURST_SIZE>(in, head_prev_blk, orig_input_data, inStream512,
+                                                                 mm2sStreamSize, compressd_size, block_desc,
+                                                                 no_blocks, block_size_in_kb, head_res_size, 0);
+    xf::compression::details::streamDownSizerP2PComp<GMEM_DWIDTH, PACK_WIDTH>(inStream512, inStreamV, mm2sStreamSize,
+                                                                              downStreamSize, no_blocks);
+
+    encoded_size[0] = xf::compression::gzipPacker<PACK_WIDTH, PARLLEL_BYTE>(
+        inStreamV, packStreamV, downStreamSize, packStreamSize, no_blocks, zlib, checksum, isize);
+
+    xf::compression::details::streamUpsizerP2P<GMEM_DWIDTH, PACK_WIDTH>(packStreamV, outStream512, packStreamSize,
+                                                                        upStreamSize);
+    xf::compression::details::s2mm<GMEM_DWIDTH>(outStream512, out, upStreamSize);
+}
+
+extern "C" {
+void xilGzipPacker(const uint512_t* in,
+                   uint512_t* out,
+                   uint512_t* head_prev_blk,
+                   uint32_t* compressd_size,
+                   dt_blockDesc* block_desc,
+                   uint32_t* encoded_size,
+                   uint512_t* orig_input_data,
+                   uint32_t* content_checksum,
+                   uint32_t head_res_size,
+                   uint32_t block_size_in_kb,
+                   uint32_t no_blocks,
+                   uint32_t frame_flags
+#ifdef KERNEL_STATS
+                   ,
+                   dt_kernelStats* stats
+#endif
+                   ) {
+#pragma HLS INTERFACE m_axi port = in offset = slave bundle = gmem0
+#pragma HLS INTERFACE m_axi port = out offset = slave bundle = gmem0
+#pragma HLS INTERFACE m_axi port = head_prev_blk offset = slave bundle = gmem0
+#pragma HLS INTERFACE m_axi port = compressd_size offset = slave bundle = gmem1
+#pragma HLS INTERFACE m_axi port = block_desc offset = slave bundle = gmem1
+#pragma HLS INTERFACE m_axi port = encoded_size offset = slave bundle = gmem1
+#pragma HLS INTERFACE m_axi port = orig_input_data offset = slave bundle = gmem0
+#pragma HLS INTERFACE m_axi port = content_checksum offset = slave bundle = gmem1
+#pragma HLS INTERFACE s_axilite port = in bundle = control
+#pragma HLS INTERFACE s_axilite port = out bundle = control
+#pragma HLS INTERFACE s_axilite port = head_prev_blk bundle = control
+#pragma HLS INTERFACE s_axilite port = compressd_size bundle = control
+#pragma HLS INTERFACE s_axilite port = block_desc bundle = control
+#pragma HLS INTERFACE s_axilite port = encoded_size bundle = control
+#pragma HLS INTERFACE s_axilite port = orig_input_data bundle = control
+#pragma HLS INTERFACE s_axilite port = content_checksum bundle = control
+#pragma HLS INTERFACE s_axilite port = head_res_size bundle = control
+#pragma HLS INTERFACE s_axilite port = block_size_in_kb bundle = control
+#pragma HLS INTERFACE s_axilite port = no_blocks bundle = control
+#pragma HLS INTERFACE s_axilite port = frame_flags bundle = control
+#ifdef KERNEL_STATS
+#pragma HLS INTERFACE m_axi port = stats offset = slave bundle = gmem1
+#pragma HLS INTERFACE s_axilite port = stats bundle = control
+#endif
+#pragma HLS INTERFACE s_axilite port = return bundle = control
+
+#ifdef KERNEL_STATS
+    dt_kernelStats kStats;
+    xf::compression::details::statsReset(kStats, 0);
+    for (uint32_t i = 0; i < no_blocks; i++) {
+#pragma HLS PIPELINE II = 1
+        uint32_t blkCompSize = compressd_size[i];
+        kStats.bytesIn += blkCompSize;
+        if (blkCompSize == block_desc[i].size) kStats.rawBlocks++;
+    }
+    kStats.bytesOut = 0;
+#endif
+
+    // One member per file, a file being the run of blocks with its fileId
+    uint32_t block_stride = block_size_in_kb * 1024 / 64;
+    uint32_t file_blocks = 0;
+files:
+    for (uint32_t first = 0; first < no_blocks; first += file_blocks) {
+        uint32_t file = block_desc[first].fileId;
+        uint32_t frame_offset = block_desc[first].frameOffset;
+        uint32_t isize = 0;
+        file_blocks = 0;
+    count:
+        for (uint32_t i = first; i < no_blocks && block_desc[i].fileId == file; i++) {
+#pragma HLS PIPELINE II = 1
+            isize += block_desc[i].size;
+            file_blocks++;
+        }
+
+        gzip(in + first * block_stride, out + frame_offset / 64, head_prev_blk + file, compressd_size + first,
+             block_desc + first, encoded_size + file, orig_input_data, file_blocks, head_res_size, block_size_in_kb,
+             frame_flags & FRAME_ZLIB, content_checksum[file], isize);
+#ifdef KERNEL_STATS
+        kStats.bytesIn += head_res_size;
+        kStats.bytesOut += encoded_size[file];
+#endif
+    }
+
+#ifdef KERNEL_STATS
+    // GMEM words of the busier of the input and output ports
+    uint64_t maxBytes = (kStats.bytesIn > kStats.bytesOut) ? kStats.bytesIn : kStats.bytesOut;
+    kStats.moverBeats = (maxBytes + GMEM_DWIDTH / 8 - 1) / (GMEM_DWIDTH / 8);
+    stats[0] = kStats;
+#endif
+
+    return;
+}
+}
@@ -28,20 +28,48 @@ const int c_lz4MaxLiteralCount = MAX_LIT_COUNT;
 
 // namespace hw_compress {
 
+/**
+ * @brief Element encoder of an engine: LZ4 sequences, or Snappy elements
+ * for FRAME_SNAPPY. Both take the matches of the same match pipeline.
+ */
+void lzEncode(hls::stream<xf::compression::compressd_dt>& inStream,
+              hls::stream<ap_uint<8> >& outStream,
+              uint32_t max_lit_limit[PARALLEL_BLOCK],
+              uint32_t input_size,
+              hls::stream<bool>& outStreamEos,
+              hls::stream<uint32_t>& compressedSize,
+              uint32_t core_idx,
+              bool snappy) {
+    if (snappy) {
+        xf::compression::snappyCompress<MAX_LIT_COUNT, PARALLEL_BLOCK>(inStream, outStream, max_lit_limit, input_size,
+                                                                       outStreamEos, compressedSize, core_idx);
+    } else {
+        xf::compression::lz4Compress<MAX_LIT_COUNT, PARALLEL_BLOCK>(inStream, outStream, max_lit_limit, input_size,
+                                                                    outStreamEos, compressedSize, core_idx);
+    }
+}
+
 void lz4Core(hls::stream<xf::compression::uintMemWidth_t>& inStreamMemWidth,
+             hls::stream<xf::compression::uintMemWidth_t>& dictStreamMemWidth,
              hls::stream<xf::compression::uintMemWidth_t>& outStreamMemWidth,
              hls::stream<bool>& outStreamMemWidthEos,
              hls::stream<uint32_t>& compressedSize,
              uint32_t max_lit_limit[PARALLEL_BLOCK],
              uint32_t input_size,
-             uint32_t core_idx) {
+             uint32_t dict_size,
+             uint32_t core_idx,
+             bool snappy) {
     hls::stream<ap_uint<8> > inStream("inStream");
+    hls::stream<ap_uint<8> > dictStream("dictStream");
+    hls::stream<ap_uint<8> > historyStream("historyStream");
     hls::stream<xf::compression::compressd_dt> compressdStream("compressdStream");
     hls::stream<xf::compression::compressd_dt> bestMatchStream("bestMatchStream");
     hls::stream<xf::compression::compressd_dt> boosterStream("boosterStream");
     hls::stream<ap_uint<8> > lz4Out("lz4Out");
     hls::stream<bool> lz4Out_eos("lz4Out_eos");
 #pragma HLS STREAM variable = inStream depth = 8
+#pragma HLS STREAM variable = dictStream depth = 8
+#pragma HLS STREAM variable = historyStream depth = 8
 #pragma HLS STREAM variable = compressdStream depth = 8
 #pragma HLS STREAM variable = bestMatchStream depth = 8
 #pragma HLS STREAM variable = boosterStream depth = 8
@@ -49,21 +77,218 @@ void lz4Core(hls::stream<xf::compression::uintMemWidth_t>& inStreamMemWidth,
 #pragma HLS STREAM variable = lz4Out_eos depth = 8
 
 #pragma HLS RESOURCE variable = inStream core = FIFO_SRL
+#pragma HLS RESOURCE variable = dictStream core = FIFO_SRL
+#pragma HLS RESOURCE variable = historyStream core = FIFO_SRL
 #pragma HLS RESOURCE variable = compressdStream core = FIFO_SRL
 #pragma HLS RESOURCE variable = boosterStream core = FIFO_SRL
 #pragma HLS RESOURCE variable = lz4Out core = FIFO_SRL
 #pragma HLS RESOURCE variable = lz4Out_eos core = FIFO_SRL
 
+    // Engines without a block get no dictionary either (lz4DictFeed)
+    uint32_t block_dict_size = input_size ? dict_size : 0;
+
 #pragma HLS dataflow
     xf::compression::details::streamDownsizer<uint32_t, GMEM_DWIDTH, 8>(inStreamMemWidth, inStream, input_size);
-    xf::compression::lzCompress<MATCH_LEN, MIN_MATCH, LZ_MAX_OFFSET_LIMIT>(inStream, compressdStream, input_size);
+    xf::compression::details::streamDownsizer<uint32_t, GMEM_DWIDTH, 8>(dictStreamMemWidth, dictStream,
+                                                                         block_dict_size);
+    xf::compression::lzCompress<MATCH_LEN, MIN_MATCH, LZ_MAX_OFFSET_LIMIT>(inStream, dictStream, compressdStream,
+                                                                           historyStream, input_size, block_dict_size);
     xf::compression::lzBestMatchFilter<MATCH_LEN, OFFSET_WINDOW>(compressdStream, bestMatchStream, input_size);
-    xf::compression::lzBooster<MAX_MATCH_LEN>(bestMatchStream, boosterStream, input_size);
-    xf::compression::lz4Compress<MAX_LIT_COUNT, PARALLEL_BLOCK>(boosterStream, lz4Out, max_lit_limit, input_size,
-                                                                lz4Out_eos, compressedSize, core_idx);
+    xf::compression::lzBooster<MAX_MATCH_LEN>(bestMatchStream, historyStream, boosterStream, input_size,
+                                              block_dict_size);
+    lzEncode(boosterStream, lz4Out, max_lit_limit, input_size, lz4Out_eos, compressedSize, core_idx, snappy);
     xf::compression::details::upsizerEos<8, GMEM_DWIDTH>(lz4Out, lz4Out_eos, outStreamMemWidth, outStreamMemWidthEos);
 }
 
+/**
+ * @brief Reads the preset dictionary from device memory and hands every word
+ * to the engines that have a block in the batch, which all take it in at
+ * the same rate. The dictionary is read once per batch.
+ *
+ * @param dict preset dictionary
+ * @param dict_size dictionary size, 0 for none
+ * @param input_size size of each block, 0 for no block
+ * @param dictStreamMemWidth dictionary of each engine
+ */
+void lz4DictFeed(const xf::compression::uintMemWidth_t* dict,
+                 uint32_t dict_size,
+                 const uint32_t input_size[PARALLEL_BLOCK],
+                 hls::stream<xf::compression::uintMemWidth_t> dictStreamMemWidth[PARALLEL_BLOCK]) {
+    const int c_wordBytes = GMEM_DWIDTH / 8;
+    uint32_t words = (dict_size + c_wordBytes - 1) / c_wordBytes;
+dict_feed:
+    for (uint32_t w = 0; w < words; w++) {
+#pragma HLS PIPELINE II = 1
+        xf::compression::uintMemWidth_t word = dict[w];
+        for (uint32_t j = 0; j < PARALLEL_BLOCK; j++) {
+#pragma HLS UNROLL
+            if (input_size[j]) dictStreamMemWidth[j] << word;
+        }
+    }
+}
+
+/**
+ * @brief XXH32 of a batch of blocks in content order, for the content checksums.
+ * Runs next to the engines and carries the hash state over to the next batch.
+ * The hash of a file is written out when the first block of the next file
+ * comes in, the kernel top writes the one of the last file.
+ *
+ * @param in input raw data
+ * @param content_idx byte offset of each block
+ * @param content_size bytes of each block, 0 for no block or when the content is not hashed
+ * @param content_file file of each block
+ * @param state content hash of cur_file
+ * @param cur_file file the hash state belongs to
+ * @param content_checksum XXH32 of every file
+ */
+void lz4ContentChecksum(const xf::compression::uintMemWidth_t* in,
+                        const uint32_t content_idx[PARALLEL_BLOCK],
+                        const uint32_t content_size[PARALLEL_BLOCK],
+                        const uint32_t content_file[PARALLEL_BLOCK],
+                        xf::compression::details::xxh32State& state,
+                        uint32_t& cur_file,
+                        uint32_t* content_checksum) {
+    const int c_wordBytes = GMEM_DWIDTH / 8;
+    const int c_laneBytes = 8;
+    xf::compression::uintMemWidth_t word;
+blocks:
+    for (uint32_t j = 0; j < PARALLEL_BLOCK; j++) {
+        uint32_t start = content_idx[j];
+        uint32_t size = content_size[j];
+        if (size == 0) continue;
+        if (content_file[j] != cur_file) {
+            content_checksum[cur_file] = xf::compression::details::xxh32Digest(state, 0);
+            xf::compression::details::xxh32Reset(state, 0);
+            cur_file = content_file[j];
+        }
+        uint32_t words = (size - 1) / c_wordBytes + 1;
+    content:
+        for (uint32_t i = 0; i < words * (c_wordBytes / c_laneBytes); i++) {
+#pragma HLS PIPELINE II = 1
+            uint32_t pos = i * c_laneBytes;
+            uint32_t part = i % (c_wordBytes / c_laneBytes);
+            if (part == 0) word = in[(start + pos) / c_wordBytes];
+            if (pos < size) {
+                uint32_t bytes = (pos + c_laneBytes > size) ? size - pos : c_laneBytes;
+                xf::compression::details::xxh32Update(state, word.range(part * 64 + 63, part * 64), bytes);
+            }
+        }
+    }
+}
+
+/**
+ * @brief CRC32C of each block of a batch, for the Snappy chunk headers. Runs
+ * next to the engines like lz4ContentChecksum, a block at a time.
+ *
+ * @param in input raw data
+ * @param content_idx byte offset of each block
+ * @param crc_size bytes of each block, 0 for no block or without FRAME_SNAPPY
+ * @param crc CRC32C of each block
+ */
+void snappyBlockChecksum(const xf::compression::uintMemWidth_t* in,
+                         const uint32_t content_idx[PARALLEL_BLOCK],
+                         const uint32_t crc_size[PARALLEL_BLOCK],
+                         uint32_t crc[PARALLEL_BLOCK]) {
+    const int c_wordBytes = GMEM_DWIDTH / 8;
+    const int c_laneBytes = 8;
+    xf::compression::uintMemWidth_t word;
+blocks:
+    for (uint32_t j = 0; j < PARALLEL_BLOCK; j++) {
+        uint32_t start = content_idx[j];
+        uint32_t size = crc_size[j];
+        uint32_t state = xf::compression::details::crc32cReset();
+        uint32_t words = size ? (size - 1) / c_wordBytes + 1 : 0;
+    content:
+        for (uint32_t i = 0; i < words * (c_wordBytes / c_laneBytes); i++) {
+#pragma HLS PIPELINE II = 1
+            uint32_t pos = i * c_laneBytes;
+            uint32_t part = i % (c_wordBytes / c_laneBytes);
+            if (part == 0) word = in[(start + pos) / c_wordBytes];
+            if (pos < size) {
+                uint32_t bytes = (pos + c_laneBytes > size) ? size - pos : c_laneBytes;
+                state = xf::compression::details::crc32cUpdate(state, word.range(part * 64 + 63, part * 64), bytes);
+            }
+        }
+        crc[j] = state;
+    }
+}
+
+/**
+ * @brief Zone map of each block of a batch, see zone_map.hpp. Runs next to
+ * the engines like lz4ContentChecksum and also covers the blocks that are
+ * stored without one. A word of every block is read in turn, then the
+ * records of all the blocks are parsed side by side, a byte of each per
+ * cycle.
+ *
+ * @param in input raw data
+ * @param content_idx byte offset of each block
+ * @param zone_size bytes of each block, 0 for no block or without FRAME_ZONE_MAP
+ * @param config record delimiter and field of the zone maps
+ * @param zone zone map of each block
+ */
+void lz4ZoneMap(const xf::compression::uintMemWidth_t* in,
+                const uint32_t content_idx[PARALLEL_BLOCK],
+                const uint32_t zone_size[PARALLEL_BLOCK],
+                const dt_zoneConfig& config,
+                dt_zoneMap zone[PARALLEL_BLOCK]) {
+    const int c_wordBytes = GMEM_DWIDTH / 8;
+    xf::compression::uintMemWidth_t word[PARALLEL_BLOCK];
+    zoneParse parse[PARALLEL_BLOCK];
+    bool delimited[PARALLEL_BLOCK];
+    uint32_t last[PARALLEL_BLOCK];
+#pragma HLS ARRAY_PARTITION variable = word dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = parse dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = delimited dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = last dim = 0 complete
+
+    uint32_t max_size = 0;
+    for (uint32_t j = 0; j < PARALLEL_BLOCK; j++) {
+#pragma HLS UNROLL
+        zoneParseReset(parse[j]);
+        zoneMapReset(zone[j], zone_size[j]);
+        delimited[j] = false;
+        last[j] = 0;
+        if (zone_size[j] > max_size) max_size = zone_size[j];
+    }
+
+    uint32_t words = max_size ? (max_size - 1) / c_wordBytes + 1 : 0;
+words:
+    for (uint32_t w = 0; w < words; w++) {
+    fetch:
+        for (uint32_t j = 0; j < PARALLEL_BLOCK; j++) {
+#pragma HLS PIPELINE II = 1
+            if (w * c_wordBytes < zone_size[j]) word[j] = in[(content_idx[j] + w * c_wordBytes) / c_wordBytes];
+        }
+    parse:
+        for (uint32_t b = 0; b < c_wordBytes; b++) {
+#pragma HLS PIPELINE II = 1
+            for (uint32_t j = 0; j < PARALLEL_BLOCK; j++) {
+#pragma HLS UNROLL
+                uint32_t pos = w * c_wordBytes + b;
+                if (pos >= zone_size[j]) continue;
+                uint8_t byte = word[j].range(b * 8 + 7, b * 8);
+                if (byte == config.delimiter) {
+                    // The record before the first delimiter may start in the previous block, the host adds it
+                    if (delimited[j]) {
+                        zoneMapAdd(zone[j], parse[j]);
+                    } else {
+                        zone[j].head = pos + 1;
+                    }
+                    delimited[j] = true;
+                    last[j] = pos + 1;
+                    zoneParseReset(parse[j]);
+                } else {
+                    zoneParseByte(config, parse[j], byte);
+                }
+            }
+        }
+    }
+    for (uint32_t j = 0; j < PARALLEL_BLOCK; j++) {
+#pragma HLS UNROLL
+        zone[j].tail = delimited[j] ? zone_size[j] - last[j] : 0;
+    }
+}
+
 /**
  * @brief LZ4 compression kernel top.
  *
@@ -73,6 +298,22 @@ void lz4Core(hls::stream<xf::compression::uintMemWidth_t>& inStreamMemWidth,
  * @param output_idx input size
  * @param input_size input size
  * @param max_lit_limit input size
+ * @param rdCounters read data mover counters
+ * @param wrCounters write data mover counters
+ * @param content_idx byte offset of each block to hash
+ * @param content_size bytes of each block to hash, 0 without content checksum
+ * @param content_file file of each block
+ * @param content_state content hash of content_cur
+ * @param content_cur file the content hash belongs to
+ * @param content_checksum XXH32 of every file
+ * @param crc_size bytes of each block for its CRC32C, 0 without FRAME_SNAPPY
+ * @param crc CRC32C of each block
+ * @param zone_size bytes of each block for its zone map, 0 without FRAME_ZONE_MAP
+ * @param zone_config record delimiter and field of the zone maps
+ * @param zone zone map of each block
+ * @param dict preset dictionary
+ * @param dict_size preset dictionary size, 0 for none
+ * @param snappy engines write Snappy blocks
  */
 void lz4(const xf::compression::uintMemWidth_t* in,
          xf::compression::uintMemWidth_t* out,
@@ -80,33 +321,157 @@ void lz4(const xf::compression::uintMemWidth_t* in,
          const uint32_t output_idx[PARALLEL_BLOCK],
          const uint32_t input_size[PARALLEL_BLOCK],
          uint32_t output_size[PARALLEL_BLOCK],
-         uint32_t max_lit_limit[PARALLEL_BLOCK]) {
+         uint32_t max_lit_limit[PARALLEL_BLOCK],
+         xf::compression::details::moverCounters<PARALLEL_BLOCK>& rdCounters,
+         xf::compression::details::moverCounters<PARALLEL_BLOCK>& wrCounters,
+         const uint32_t content_idx[PARALLEL_BLOCK],
+         const uint32_t content_size[PARALLEL_BLOCK],
+         const uint32_t content_file[PARALLEL_BLOCK],
+         xf::compression::details::xxh32State& content_state,
+         uint32_t& content_cur,
+         uint32_t* content_checksum,
+         const uint32_t crc_size[PARALLEL_BLOCK],
+         uint32_t crc[PARALLEL_BLOCK],
+         const uint32_t zone_size[PARALLEL_BLOCK],
+         const dt_zoneConfig& zone_config,
+         dt_zoneMap zone[PARALLEL_BLOCK],
+         const xf::compression::uintMemWidth_t* dict,
+         uint32_t dict_size,
+         bool snappy) {
     hls::stream<xf::compression::uintMemWidth_t> inStreamMemWidth[PARALLEL_BLOCK];
+    hls::stream<xf::compression::uintMemWidth_t> dictStreamMemWidth[PARALLEL_BLOCK];
     hls::stream<bool> outStreamMemWidthEos[PARALLEL_BLOCK];
     hls::stream<xf::compression::uintMemWidth_t> outStreamMemWidth[PARALLEL_BLOCK];
 #pragma HLS STREAM variable = outStreamMemWidthEos depth = 2
 #pragma HLS STREAM variable = inStreamMemWidth depth = c_gmemBurstSize
+#pragma HLS STREAM variable = dictStreamMemWidth depth = 2
 #pragma HLS STREAM variable = outStreamMemWidth depth = c_gmemBurstSize
 
 #pragma HLS RESOURCE variable = outStreamMemWidthEos core = FIFO_SRL
 #pragma HLS RESOURCE variable = inStreamMemWidth core = FIFO_SRL
+#pragma HLS RESOURCE variable = dictStreamMemWidth core = FIFO_SRL
 #pragma HLS RESOURCE variable = outStreamMemWidth core = FIFO_SRL
 
     hls::stream<uint32_t> compressedSize[PARALLEL_BLOCK];
 
 #pragma HLS dataflow
-    xf::compression::details::mm2sNb<GMEM_DWIDTH, GMEM_BURST_SIZE, PARALLEL_BLOCK>(in, input_idx, inStreamMemWidth,
-                                                                                   input_size);
+    xf::compression::details::mm2sMover<GMEM_DWIDTH, GMEM_BURST_SIZE, PARALLEL_BLOCK, GMEM_OUTSTANDING, GMEM_INTERLEAVE>(
+        in, input_idx, inStreamMemWidth, input_size, rdCounters);
+    lz4DictFeed(dict, dict_size, input_size, dictStreamMemWidth);
 
     for (uint8_t i = 0; i < PARALLEL_BLOCK; i++) {
 #pragma HLS UNROLL
         // lz4Core is instantiated based on the PARALLEL_BLOCK
-        lz4Core(inStreamMemWidth[i], outStreamMemWidth[i], outStreamMemWidthEos[i], compressedSize[i], max_lit_limit,
-                input_size[i], i);
+        lz4Core(inStreamMemWidth[i], dictStreamMemWidth[i], outStreamMemWidth[i], outStreamMemWidthEos[i],
+                compressedSize[i], max_lit_limit, input_size[i], dict_size, i, snappy);
+    }
+
+    xf::compression::details::s2mmEosMover<GMEM_DWIDTH, GMEM_BURST_SIZE, PARALLEL_BLOCK, GMEM_OUTSTANDING,
+                                           GMEM_INTERLEAVE>(out, output_idx, outStreamMemWidth, outStreamMemWidthEos,
+                                                            compressedSize, output_size, wrCounters);
+
+    lz4ContentChecksum(in, content_idx, content_size, content_file, content_state, content_cur, content_checksum);
+    snappyBlockChecksum(in, content_idx, crc_size, crc);
+    lz4ZoneMap(in, content_idx, zone_size, zone_config, zone);
+}
+
+/**
+ * @brief Entropy estimate of each block of a batch, see lz_entropy.hpp.
+ *
+ * The sample words of the blocks are read in turn and every block keeps its
+ * own byte histogram, so the histograms of a batch are updated in parallel.
+ * Runs of one byte value are accumulated in a register before the histogram
+ * write back, which lets the count loop run at II = 1.
+ *
+ * @param in input raw data
+ * @param input_idx byte offset of each block
+ * @param input_size size of each block, 0 for no block
+ * @param entropy estimate of each block, 0 for no block
+ */
+void lz4Entropy(const xf::compression::uintMemWidth_t* in,
+                const uint32_t input_idx[PARALLEL_BLOCK],
+                const uint32_t input_size[PARALLEL_BLOCK],
+                uint32_t entropy[PARALLEL_BLOCK]) {
+    const int c_wordBytes = GMEM_DWIDTH / 8;
+    const int c_chunkWords = ENTROPY_CHUNK_BYTES / c_wordBytes;
+
+    uint16_t histogram[PARALLEL_BLOCK][256];
+    xf::compression::uintMemWidth_t word[PARALLEL_BLOCK];
+    uint32_t word_offset[PARALLEL_BLOCK];
+    uint32_t sample_size[PARALLEL_BLOCK];
+    uint64_t sum_sq[PARALLEL_BLOCK];
+#pragma HLS ARRAY_PARTITION variable = histogram dim = 1 complete
+#pragma HLS ARRAY_PARTITION variable = word dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = word_offset dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = sample_size dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = sum_sq dim = 0 complete
+
+clear:
+    for (uint32_t s = 0; s < 256; s++) {
+#pragma HLS PIPELINE II = 1
+        for (uint32_t j = 0; j < PARALLEL_BLOCK; j++) {
+#pragma HLS UNROLL
+            histogram[j][s] = 0;
+        }
+    }
+    for (uint32_t j = 0; j < PARALLEL_BLOCK; j++) {
+#pragma HLS UNROLL
+        sample_size[j] = (input_size[j] < ENTROPY_SAMPLE_BYTES) ? input_size[j] : ENTROPY_SAMPLE_BYTES;
+        sum_sq[j] = 0;
     }
 
-    xf::compression::details::s2mmEosNb<uint32_t, GMEM_BURST_SIZE, GMEM_DWIDTH, PARALLEL_BLOCK>(
-        out, output_idx, outStreamMemWidth, outStreamMemWidthEos, compressedSize, output_size);
+sample:
+    for (uint32_t c = 0; c < ENTROPY_SAMPLE_CHUNKS; c++) {
+        for (uint32_t w = 0; w < c_chunkWords; w++) {
+        fetch:
+            for (uint32_t j = 0; j < PARALLEL_BLOCK; j++) {
+#pragma HLS PIPELINE II = 1
+                // Blocks that fit in the sample are read whole, chunk after chunk
+                uint32_t chunk = (input_size[j] <= ENTROPY_SAMPLE_BYTES) ? c * ENTROPY_CHUNK_BYTES
+                                                                         : entropyChunkOffset(input_size[j], c);
+                word_offset[j] = chunk + w * c_wordBytes;
+                if (word_offset[j] < input_size[j]) word[j] = in[(input_idx[j] + word_offset[j]) / c_wordBytes];
+            }
+            uint8_t prev[PARALLEL_BLOCK];
+            uint16_t run[PARALLEL_BLOCK];
+#pragma HLS ARRAY_PARTITION variable = prev dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = run dim = 0 complete
+        count:
+            for (uint32_t b = 0; b < c_wordBytes; b++) {
+#pragma HLS PIPELINE II = 1
+#pragma HLS DEPENDENCE variable = histogram inter false
+                for (uint32_t j = 0; j < PARALLEL_BLOCK; j++) {
+#pragma HLS UNROLL
+                    if (word_offset[j] + b >= input_size[j]) continue;
+                    uint8_t sym = word[j].range(b * 8 + 7, b * 8);
+                    if (b > 0 && sym == prev[j]) {
+                        run[j]++;
+                    } else {
+                        if (b > 0) histogram[j][prev[j]] = run[j];
+                        run[j] = histogram[j][sym] + 1;
+                    }
+                    prev[j] = sym;
+                }
+            }
+            for (uint32_t j = 0; j < PARALLEL_BLOCK; j++) {
+#pragma HLS UNROLL
+                if (word_offset[j] < input_size[j]) histogram[j][prev[j]] = run[j];
+            }
+        }
+    }
+
+square:
+    for (uint32_t s = 0; s < 256; s++) {
+#pragma HLS PIPELINE II = 1
+        for (uint32_t j = 0; j < PARALLEL_BLOCK; j++) {
+#pragma HLS UNROLL
+            sum_sq[j] += (uint32_t)histogram[j][s] * histogram[j][s];
+        }
+    }
+    for (uint32_t j = 0; j < PARALLEL_BLOCK; j++) {
+#pragma HLS UNROLL
+        entropy[j] = entropyEstimate(sum_sq[j], sample_size[j]);
+    }
 }
 //} // namespace end
 
@@ -117,47 +482,115 @@ extern "C" {
  * @param in input stream width
  * @param out output stream width
  * @param compressd_size output size
- * @param in_block_size input size
+ * @param block_desc input blocks, of one or more files
+ * @param block_entropy entropy estimate of each block
+ * @param content_checksum XXH32 of every file (FRAME_CONTENT_CHECKSUM), masked CRC32C of every block (FRAME_SNAPPY)
  * @param block_size_in_kb input size
- * @param input_size input size
+ * @param no_blocks number of entries in block_desc
+ * @param frame_flags FLG byte of the frame header
+ * @param dict preset dictionary every block is compressed against (FRAME_DICT_ID)
+ * @param dict_size dictionary size, 0 for none
+ * @param zone_config record delimiter and field of the zone maps
+ * @param zone_map zone map of every block (FRAME_ZONE_MAP)
+ * @param stats statistics record (KERNEL_STATS builds only)
  */
 void xilLz4Compress
 
     (const xf::compression::uintMemWidth_t* in,
      xf::compression::uintMemWidth_t* out,
      uint32_t* compressd_size,
-     uint32_t* in_block_size,
+     dt_blockDesc* block_desc,
+     uint32_t* block_entropy,
+     uint32_t* content_checksum,
      uint32_t block_size_in_kb,
-     uint32_t input_size) {
-#pragma HLS INTERFACE m_axi port = in offset = slave bundle = gmem0
-#pragma HLS INTERFACE m_axi port = out offset = slave bundle = gmem0
+     uint32_t no_blocks,
+     uint32_t frame_flags,
+     const xf::compression::uintMemWidth_t* dict,
+     uint32_t dict_size,
+     const dt_zoneConfig* zone_config,
+     dt_zoneMap* zone_map
+#ifdef KERNEL_STATS
+     ,
+     dt_kernelStats* stats
+#endif
+     ) {
+#pragma HLS INTERFACE m_axi port = in offset = slave bundle = gmem0 max_read_burst_length = GMEM_BURST_SIZE \
+    num_read_outstanding = GMEM_AXI_OUTSTANDING
+#pragma HLS INTERFACE m_axi port = out offset = slave bundle = gmem0 max_write_burst_length = GMEM_BURST_SIZE \
+    num_write_outstanding = GMEM_AXI_OUTSTANDING
 #pragma HLS INTERFACE m_axi port = compressd_size offset = slave bundle = gmem1
-#pragma HLS INTERFACE m_axi port = in_block_size offset = slave bundle = gmem1
+#pragma HLS INTERFACE m_axi port = block_desc offset = slave bundle = gmem1
+#pragma HLS INTERFACE m_axi port = block_entropy offset = slave bundle = gmem1
+#pragma HLS INTERFACE m_axi port = content_checksum offset = slave bundle = gmem1
+#pragma HLS INTERFACE m_axi port = dict offset = slave bundle = gmem1
+#pragma HLS INTERFACE m_axi port = zone_config offset = slave bundle = gmem1
+#pragma HLS INTERFACE m_axi port = zone_map offset = slave bundle = gmem1
 #pragma HLS INTERFACE s_axilite port = in bundle = control
 #pragma HLS INTERFACE s_axilite port = out bundle = control
 #pragma HLS INTERFACE s_axilite port = compressd_size bundle = control
-#pragma HLS INTERFACE s_axilite port = in_block_size bundle = control
+#pragma HLS INTERFACE s_axilite port = block_desc bundle = control
+#pragma HLS INTERFACE s_axilite port = block_entropy bundle = control
+#pragma HLS INTERFACE s_axilite port = content_checksum bundle = control
 #pragma HLS INTERFACE s_axilite port = block_size_in_kb bundle = control
-#pragma HLS INTERFACE s_axilite port = input_size bundle = control
+#pragma HLS INTERFACE s_axilite port = no_blocks bundle = control
+#pragma HLS INTERFACE s_axilite port = frame_flags bundle = control
+#pragma HLS INTERFACE s_axilite port = dict bundle = control
+#pragma HLS INTERFACE s_axilite port = dict_size bundle = control
+#pragma HLS INTERFACE s_axilite port = zone_config bundle = control
+#pragma HLS INTERFACE s_axilite port = zone_map bundle = control
+#ifdef KERNEL_STATS
+#pragma HLS INTERFACE m_axi port = stats offset = slave bundle = gmem1
+#pragma HLS INTERFACE s_axilite port = stats bundle = control
+#endif
 #pragma HLS INTERFACE s_axilite port = return bundle = control
 
     uint32_t block_idx = 0;
-    uint32_t block_length = block_size_in_kb * 1024;
-    uint32_t no_blocks = (input_size - 1) / block_length + 1;
     uint32_t max_block_size = block_size_in_kb * 1024;
 
     bool small_block[PARALLEL_BLOCK];
+    bool high_entropy[PARALLEL_BLOCK];
+    uint32_t entropy[PARALLEL_BLOCK];
     uint32_t input_block_size[PARALLEL_BLOCK];
     uint32_t input_idx[PARALLEL_BLOCK];
     uint32_t output_idx[PARALLEL_BLOCK];
     uint32_t output_block_size[PARALLEL_BLOCK];
     uint32_t max_lit_limit[PARALLEL_BLOCK];
     uint32_t small_block_inSize[PARALLEL_BLOCK];
+    uint32_t desc_size[PARALLEL_BLOCK];
+    uint32_t content_idx[PARALLEL_BLOCK];
+    uint32_t content_size[PARALLEL_BLOCK];
+    uint32_t content_file[PARALLEL_BLOCK];
+    uint32_t crc_size[PARALLEL_BLOCK];
+    uint32_t crc[PARALLEL_BLOCK];
+    uint32_t zone_size[PARALLEL_BLOCK];
+    dt_zoneMap zone[PARALLEL_BLOCK];
 #pragma HLS ARRAY_PARTITION variable = input_block_size dim = 0 complete
 #pragma HLS ARRAY_PARTITION variable = input_idx dim = 0 complete
 #pragma HLS ARRAY_PARTITION variable = output_idx dim = 0 complete
 #pragma HLS ARRAY_PARTITION variable = output_block_size dim = 0 complete
 #pragma HLS ARRAY_PARTITION variable = max_lit_limit dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = entropy dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = content_idx dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = content_size dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = content_file dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = crc_size dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = crc dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = zone_size dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = zone dim = 0 complete
+    xf::compression::details::moverCounters<PARALLEL_BLOCK> rdCounters;
+    xf::compression::details::moverCounters<PARALLEL_BLOCK> wrCounters;
+    bool content_hash = (frame_flags & FRAME_CONTENT_CHECKSUM);
+    xf::compression::details::xxh32State content_state;
+    xf::compression::details::xxh32Reset(content_state, 0);
+    uint32_t content_cur = block_desc[0].fileId;
+    bool snappy = (frame_flags & FRAME_SNAPPY);
+    bool zones_enable = (frame_flags & FRAME_ZONE_MAP);
+    dt_zoneConfig zone_cfg = zone_config[0];
+
+#ifdef KERNEL_STATS
+    dt_kernelStats kStats;
+    xf::compression::details::statsReset(kStats, PARALLEL_BLOCK);
+#endif
 
     // Figure out total blocks & block sizes
     for (uint32_t i = 0; i < no_blocks; i += PARALLEL_BLOCK) {
@@ -168,7 +601,14 @@ void xilLz4Compress
 
         for (uint32_t j = 0; j < PARALLEL_BLOCK; j++) {
             if (j < nblocks) {
-                uint32_t inBlockSize = in_block_size[i + j];
+                dt_blockDesc desc = block_desc[i + j];
+                uint32_t inBlockSize = desc.size;
+                desc_size[j] = inBlockSize;
+                content_idx[j] = desc.srcOffset;
+                content_size[j] = content_hash ? inBlockSize : 0;
+                content_file[j] = desc.fileId;
+                crc_size[j] = snappy ? inBlockSize : 0;
+                zone_size[j] = zones_enable ? inBlockSize : 0;
                 if (inBlockSize < MIN_BLOCK_SIZE) {
                     small_block[j] = 1;
                     small_block_inSize[j] = inBlockSize;
@@ -177,20 +617,35 @@ void xilLz4Compress
                 } else {
                     small_block[j] = 0;
                     input_block_size[j] = inBlockSize;
-                    input_idx[j] = (i + j) * max_block_size;
+                    input_idx[j] = desc.srcOffset;
                     output_idx[j] = (i + j) * max_block_size;
                 }
             } else {
                 input_block_size[j] = 0;
                 input_idx[j] = 0;
+                content_size[j] = 0;
+                crc_size[j] = 0;
+                zone_size[j] = 0;
             }
             output_block_size[j] = 0;
             max_lit_limit[j] = 0;
         }
 
+        // High entropy blocks skip the engines, the packer copies them from the input
+        lz4Entropy(in, input_idx, input_block_size, entropy);
+        for (uint32_t j = 0; j < PARALLEL_BLOCK; j++) {
+            high_entropy[j] = (input_block_size[j] && entropy[j] >= ENTROPY_RAW_THRESHOLD);
+            if (high_entropy[j]) input_block_size[j] = 0;
+        }
+
         // Call for parallel compression
-        lz4(in, out, input_idx, output_idx, input_block_size, output_block_size, max_lit_limit);
+        lz4(in, out, input_idx, output_idx, input_block_size, output_block_size, max_lit_limit, rdCounters,
+            wrCounters, content_idx, content_size, content_file, content_state, content_cur, content_checksum, crc_size,
+            crc, zone_size, zone_cfg, zone, dict, dict_size, snappy);
 
+#ifdef KERNEL_STATS
+        xf::compression::details::statsAddMovers<PARALLEL_BLOCK>(kStats, rdCounters, wrCounters);
+#endif
         for (uint32_t k = 0; k < nblocks; k++) {
             if (max_lit_limit[k]) {
                 compressd_size[block_idx] = input_block_size[k];
@@ -201,8 +656,21 @@ void xilLz4Compress
             if (small_block[k] == 1) {
                 compressd_size[block_idx] = small_block_inSize[k];
             }
+            if (high_entropy[k]) {
+                compressd_size[block_idx] = desc_size[k];
+            }
+            block_entropy[block_idx] = entropy[k];
+            if (snappy) content_checksum[block_idx] = xf::compression::details::crc32cMaskedDigest(crc[k]);
+            if (zones_enable) zone_map[block_idx] = zone[k];
+#ifdef KERNEL_STATS
+            if (max_lit_limit[k] || small_block[k] || high_entropy[k]) kStats.rawBlocks++;
+#endif
             block_idx++;
         }
     }
+    if (content_hash) content_checksum[content_cur] = xf::compression::details::xxh32Digest(content_state, 0);
+#ifdef KERNEL_STATS
+    stats[0] = kStats;
+#endif
 }
 }
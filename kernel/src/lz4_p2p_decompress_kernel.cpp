@@ -33,25 +33,128 @@ const int c_gmemBurstSize = (2 * GMEM_BURST_SIZE);
 
 typedef ap_uint<8> uintV_t;
 
+/**
+ * @brief Passes the compressed bytes of a block on to the LZ4 decoder and
+ * hashes them on the way, for the block checksum of the frame.
+ *
+ * @param inStream compressed block bytes
+ * @param outStream the same bytes
+ * @param input_size compressed block size
+ * @param enable hash the block (the frame has block checksums)
+ * @param checksum XXH32 of the block, 0 when not enabled
+ */
+void lz4BlockChecksum(hls::stream<uintV_t>& inStream,
+                      hls::stream<uintV_t>& outStream,
+                      uint32_t input_size,
+                      bool enable,
+                      uint32_t& checksum) {
+    xf::compression::details::xxh32State state;
+    xf::compression::details::xxh32Reset(state, 0);
+hash:
+    for (uint32_t i = 0; i < input_size; i++) {
+#pragma HLS PIPELINE II = 1
+        uintV_t byte = inStream.read();
+        if (enable) xf::compression::details::xxh32Update(state, byte, 1);
+        outStream << byte;
+    }
+    checksum = enable ? xf::compression::details::xxh32Digest(state, 0) : 0;
+}
+
+/**
+ * @brief Takes the CRC32C of the content of a Snappy chunk on its way to
+ * the upsizer, for the CRC of its chunk header.
+ *
+ * @param inStream content bytes
+ * @param outStream the same bytes
+ * @param output_size content bytes of the block
+ * @param enable take the CRC (FRAME_SNAPPY)
+ * @param crc CRC32C of the content, unmasked
+ */
+void snappyDecChecksum(hls::stream<uintV_t>& inStream,
+                         hls::stream<uintV_t>& outStream,
+                         uint32_t output_size,
+                         bool enable,
+                         uint32_t& crc) {
+    uint32_t state = xf::compression::details::crc32cReset();
+crc:
+    for (uint32_t i = 0; i < output_size; i++) {
+#pragma HLS PIPELINE II = 1
+        uintV_t byte = inStream.read();
+        if (enable) state = xf::compression::details::crc32cUpdate(state, byte, 1);
+        outStream << byte;
+    }
+    crc = state;
+}
+
+// Element parser of an engine: LZ4 sequences, or Snappy elements for FRAME_SNAPPY
+void lzDecode(hls::stream<uintV_t>& inStream,
+              hls::stream<xf::compression::compressd_dt>& outStream,
+              uint32_t input_size,
+              bool uncomp_flag,
+              bool snappy) {
+    if (snappy) {
+        xf::compression::snappyDecompressSimple(inStream, outStream, input_size, uncomp_flag);
+    } else {
+        xf::compression::lz4DecompressSimple(inStream, outStream, input_size, uncomp_flag);
+    }
+}
+
 void lz4CoreDec(hls::stream<xf::compression::uintMemWidth_t>& inStreamMemWidth,
+                hls::stream<xf::compression::uintMemWidth_t>& dictStreamMemWidth,
                 hls::stream<xf::compression::uintMemWidth_t>& outStreamMemWidth,
+                hls::stream<bool>& outStreamMemWidthEos,
+                hls::stream<uint32_t>& outSizeStream,
                 const uint32_t _input_size,
                 const uint32_t _output_size,
-                const uint32_t _input_start_idx) {
+                const uint32_t _input_start_idx,
+                const uint32_t _dict_size,
+                const bool checksum_enable,
+                const bool snappy,
+                const xf::compression::recordFilterParams<FILTER_MAX_COLUMNS>& filter_params,
+                const ap_uint<8> filter_class[256],
+                const ap_uint<16> filter_next[FILTER_MAX_STATES * FILTER_MAX_CLASSES],
+                uint32_t& checksum,
+                uint32_t& crc,
+                uint32_t& filter_head,
+                uint32_t& filter_tail,
+                uint32_t& filter_tail_state,
+                uint32_t& filter_matches,
+                uint32_t& filter_status,
+                dt_columnStats col_stats[FILTER_MAX_COLUMNS],
+                uint32_t& low_offset_cycles) {
     uint32_t input_size = _input_size;
     uint32_t output_size = _output_size;
     uint32_t input_size1 = input_size;
     uint32_t output_size1 = output_size;
+    uint32_t output_size2 = output_size;
     uint32_t input_start_idx = _input_start_idx;
+    // Engines without a block get no dictionary either (lz4DecDictFeed)
+    uint32_t dict_size = input_size ? _dict_size : 0;
+    uint32_t dict_size1 = dict_size;
     hls::stream<uintV_t> instreamV("instreamV");
+    hls::stream<uintV_t> dictStreamV("dictStreamV");
+    hls::stream<uintV_t> checkedStreamV("checkedStreamV");
     hls::stream<xf::compression::compressd_dt> decompressd_stream("decompressd_stream");
     hls::stream<uintV_t> decompressed_stream("decompressed_stream");
+    hls::stream<uintV_t> contentStreamV("contentStreamV");
+    hls::stream<uintV_t> filteredStreamV("filteredStreamV");
+    hls::stream<bool> filteredStreamEos("filteredStreamEos");
 #pragma HLS STREAM variable = instreamV depth = 8
+#pragma HLS STREAM variable = dictStreamV depth = 8
+#pragma HLS STREAM variable = checkedStreamV depth = 8
 #pragma HLS STREAM variable = decompressd_stream depth = 8
 #pragma HLS STREAM variable = decompressed_stream depth = 8
+#pragma HLS STREAM variable = contentStreamV depth = 8
+#pragma HLS STREAM variable = filteredStreamV depth = 8
+#pragma HLS STREAM variable = filteredStreamEos depth = 8
 #pragma HLS RESOURCE variable = instreamV core = FIFO_SRL
+#pragma HLS RESOURCE variable = dictStreamV core = FIFO_SRL
+#pragma HLS RESOURCE variable = checkedStreamV core = FIFO_SRL
 #pragma HLS RESOURCE variable = decompressd_stream core = FIFO_SRL
 #pragma HLS RESOURCE variable = decompressed_stream core = FIFO_SRL
+#pragma HLS RESOURCE variable = contentStreamV core = FIFO_SRL
+#pragma HLS RESOURCE variable = filteredStreamV core = FIFO_SRL
+#pragma HLS RESOURCE variable = filteredStreamEos core = FIFO_SRL
 
     bool uncomp_flag = 0;
     if (input_size == output_size) uncomp_flag = 1;
@@ -59,40 +162,105 @@ void lz4CoreDec(hls::stream<xf::compression::uintMemWidth_t>& inStreamMemWidth,
 #pragma HLS dataflow
     xf::compression::details::streamDownsizerP2P<uint32_t, GMEM_DWIDTH, 8>(inStreamMemWidth, instreamV, input_size,
                                                                            input_start_idx);
-    xf::compression::lz4DecompressSimple(instreamV, decompressd_stream, input_size1, uncomp_flag);
-    xf::compression::lzDecompress<HISTORY_SIZE>(decompressd_stream, decompressed_stream, output_size);
-    xf::compression::details::streamUpsizer<uint32_t, 8, GMEM_DWIDTH>(decompressed_stream, outStreamMemWidth,
-                                                                      output_size1);
+    xf::compression::details::streamDownsizer<uint32_t, GMEM_DWIDTH, 8>(dictStreamMemWidth, dictStreamV, dict_size);
+    lz4BlockChecksum(instreamV, checkedStreamV, input_size, checksum_enable, checksum);
+    lzDecode(checkedStreamV, decompressd_stream, input_size1, uncomp_flag, snappy);
+    xf::compression::lzDecompress<HISTORY_SIZE>(decompressd_stream, dictStreamV, decompressed_stream, output_size,
+                                                dict_size1, low_offset_cycles);
+    snappyDecChecksum(decompressed_stream, contentStreamV, output_size2, snappy, crc);
+    xf::compression::recordFilter<FILTER_MAX_RECORD, FILTER_MAX_STATES, FILTER_MAX_CLASSES, FILTER_MAX_COLUMNS>(
+        contentStreamV, filteredStreamV, filteredStreamEos, outSizeStream, output_size1, filter_params, filter_class,
+        filter_next, filter_head, filter_tail, filter_tail_state, filter_matches, filter_status, col_stats);
+    xf::compression::details::upsizerEos<8, GMEM_DWIDTH>(filteredStreamV, filteredStreamEos, outStreamMemWidth,
+                                                         outStreamMemWidthEos);
+}
+
+/**
+ * @brief Reads the preset dictionary from device memory and hands every word
+ * to the engines that have a block in the batch.
+ *
+ * @param dict preset dictionary
+ * @param dict_size dictionary size, 0 for none
+ * @param input_size compressed size of each block, 0 for no block
+ * @param dictStreamMemWidth dictionary of each engine
+ */
+void lz4DecDictFeed(const xf::compression::uintMemWidth_t* dict,
+                    uint32_t dict_size,
+                    const uint32_t input_size[PARALLEL_BLOCK],
+                    hls::stream<xf::compression::uintMemWidth_t> dictStreamMemWidth[PARALLEL_BLOCK]) {
+    const int c_wordBytes = GMEM_DWIDTH / 8;
+    uint32_t words = (dict_size + c_wordBytes - 1) / c_wordBytes;
+dict_feed:
+    for (uint32_t w = 0; w < words; w++) {
+#pragma HLS PIPELINE II = 1
+        xf::compression::uintMemWidth_t word = dict[w];
+        for (uint32_t j = 0; j < PARALLEL_BLOCK; j++) {
+#pragma HLS UNROLL
+            if (input_size[j]) dictStreamMemWidth[j] << word;
+        }
+    }
 }
 
 void lz4Dec(const xf::compression::uintMemWidth_t* in,
             xf::compression::uintMemWidth_t* out,
             const uint32_t input_idx[PARALLEL_BLOCK],
             const uint32_t input_size[PARALLEL_BLOCK],
-            const uint32_t output_size[PARALLEL_BLOCK],
             const uint32_t input_size1[PARALLEL_BLOCK],
             const uint32_t output_size1[PARALLEL_BLOCK],
-            const uint32_t output_idx[PARALLEL_BLOCK]) {
+            const uint32_t output_idx[PARALLEL_BLOCK],
+            const xf::compression::uintMemWidth_t* dict,
+            const uint32_t dict_size,
+            const bool checksum_enable,
+            const bool snappy,
+            const xf::compression::recordFilterParams<FILTER_MAX_COLUMNS>& filter_params,
+            const ap_uint<8> filter_class[PARALLEL_BLOCK][256],
+            const ap_uint<16> filter_next[PARALLEL_BLOCK][FILTER_MAX_STATES * FILTER_MAX_CLASSES],
+            uint32_t checksum[PARALLEL_BLOCK],
+            uint32_t crc[PARALLEL_BLOCK],
+            uint32_t filtered_size[PARALLEL_BLOCK],
+            uint32_t filter_head[PARALLEL_BLOCK],
+            uint32_t filter_tail[PARALLEL_BLOCK],
+            uint32_t filter_tail_state[PARALLEL_BLOCK],
+            uint32_t filter_matches[PARALLEL_BLOCK],
+            uint32_t filter_status[PARALLEL_BLOCK],
+            dt_columnStats col_stats[PARALLEL_BLOCK][FILTER_MAX_COLUMNS],
+            uint32_t low_offset_cycles[PARALLEL_BLOCK],
+            xf::compression::details::moverCounters<PARALLEL_BLOCK>& rdCounters,
+            xf::compression::details::moverCounters<PARALLEL_BLOCK>& wrCounters) {
     hls::stream<xf::compression::uintMemWidth_t> inStreamMemWidth[PARALLEL_BLOCK];
     hls::stream<xf::compression::uintMemWidth_t> outStreamMemWidth[PARALLEL_BLOCK];
+    hls::stream<xf::compression::uintMemWidth_t> dictStreamMemWidth[PARALLEL_BLOCK];
+    hls::stream<bool> outStreamMemWidthEos[PARALLEL_BLOCK];
+    hls::stream<uint32_t> outSizeStream[PARALLEL_BLOCK];
 #pragma HLS STREAM variable = inStreamMemWidth depth = c_gmemBurstSize
 #pragma HLS STREAM variable = outStreamMemWidth depth = c_gmemBurstSize
+#pragma HLS STREAM variable = dictStreamMemWidth depth = 2
+#pragma HLS STREAM variable = outStreamMemWidthEos depth = c_gmemBurstSize
+#pragma HLS STREAM variable = outSizeStream depth = 2
 #pragma HLS RESOURCE variable = inStreamMemWidth core = FIFO_SRL
+#pragma HLS RESOURCE variable = dictStreamMemWidth core = FIFO_SRL
 #pragma HLS RESOURCE variable = outStreamMemWidth core = FIFO_SRL
+#pragma HLS RESOURCE variable = outStreamMemWidthEos core = FIFO_SRL
+#pragma HLS RESOURCE variable = outSizeStream core = FIFO_SRL
 
 #pragma HLS dataflow
     // Transfer data from global memory to kernel
-    xf::compression::details::mm2sNbRoundOff<GMEM_DWIDTH, GMEM_BURST_SIZE, PARALLEL_BLOCK>(
-        in, input_idx, inStreamMemWidth, input_size);
+    xf::compression::details::mm2sMover<GMEM_DWIDTH, GMEM_BURST_SIZE, PARALLEL_BLOCK, GMEM_OUTSTANDING, GMEM_INTERLEAVE,
+                                        true>(in, input_idx, inStreamMemWidth, input_size, rdCounters);
+    lz4DecDictFeed(dict, dict_size, input_size, dictStreamMemWidth);
     for (uint8_t i = 0; i < PARALLEL_BLOCK; i++) {
 #pragma HLS UNROLL
         // lz4CoreDec is instantiated based on the PARALLEL_BLOCK
-        lz4CoreDec(inStreamMemWidth[i], outStreamMemWidth[i], input_size1[i], output_size1[i], input_idx[i]);
+        lz4CoreDec(inStreamMemWidth[i], dictStreamMemWidth[i], outStreamMemWidth[i], outStreamMemWidthEos[i],
+                   outSizeStream[i], input_size1[i], output_size1[i], input_idx[i], dict_size, checksum_enable, snappy,
+                   filter_params, filter_class[i], filter_next[i], checksum[i], crc[i], filter_head[i], filter_tail[i],
+                   filter_tail_state[i], filter_matches[i], filter_status[i], col_stats[i], low_offset_cycles[i]);
     }
 
-    // Transfer data from kernel to global memory
-    xf::compression::details::s2mmNb<uint32_t, GMEM_BURST_SIZE, GMEM_DWIDTH, PARALLEL_BLOCK>(
-        out, output_idx, outStreamMemWidth, output_size);
+    // Transfer data from kernel to global memory, as much as the record filter let through
+    xf::compression::details::s2mmEosMover<GMEM_DWIDTH, GMEM_BURST_SIZE, PARALLEL_BLOCK, GMEM_OUTSTANDING,
+                                           GMEM_INTERLEAVE>(out, output_idx, outStreamMemWidth, outStreamMemWidthEos,
+                                                            outSizeStream, filtered_size, wrCounters);
 }
 //} // namespace end
 
@@ -105,11 +273,25 @@ void xilLz4P2PDecompress(const xf::compression::uintMemWidth_t* in,
                          uint32_t block_size_in_kb,
                          uint32_t compute_unit,
                          uint8_t total_no_cu,
-                         uint32_t num_blocks) {
-#pragma HLS INTERFACE m_axi port = in offset = slave bundle = gmem
-#pragma HLS INTERFACE m_axi port = out offset = slave bundle = gmem
+                         uint32_t num_blocks,
+                         const xf::compression::uintMemWidth_t* dict,
+                         uint32_t dict_size,
+                         const xf::compression::uintMemWidth_t* filter,
+                         dt_columnStats* column_stats
+#ifdef KERNEL_STATS
+                         ,
+                         dt_kernelStats* stats
+#endif
+                         ) {
+#pragma HLS INTERFACE m_axi port = in offset = slave bundle = gmem max_read_burst_length = GMEM_BURST_SIZE \
+    num_read_outstanding = GMEM_AXI_OUTSTANDING
+#pragma HLS INTERFACE m_axi port = out offset = slave bundle = gmem max_write_burst_length = GMEM_BURST_SIZE \
+    num_write_outstanding = GMEM_AXI_OUTSTANDING
 #pragma HLS INTERFACE m_axi port = decompress_block_info offset = slave bundle = gmem
 #pragma HLS INTERFACE m_axi port = decompress_chunk_info offset = slave bundle = gmem
+#pragma HLS INTERFACE m_axi port = dict offset = slave bundle = gmem
+#pragma HLS INTERFACE m_axi port = filter offset = slave bundle = gmem
+#pragma HLS INTERFACE m_axi port = column_stats offset = slave bundle = gmem
 #pragma HLS INTERFACE s_axilite port = in bundle = control
 #pragma HLS INTERFACE s_axilite port = out bundle = control
 #pragma HLS INTERFACE s_axilite port = decompress_block_info bundle = control
@@ -118,6 +300,14 @@ void xilLz4P2PDecompress(const xf::compression::uintMemWidth_t* in,
 #pragma HLS INTERFACE s_axilite port = compute_unit bundle = control
 #pragma HLS INTERFACE s_axilite port = total_no_cu bundle = control
 #pragma HLS INTERFACE s_axilite port = num_blocks bundle = control
+#pragma HLS INTERFACE s_axilite port = dict bundle = control
+#pragma HLS INTERFACE s_axilite port = dict_size bundle = control
+#pragma HLS INTERFACE s_axilite port = filter bundle = control
+#pragma HLS INTERFACE s_axilite port = column_stats bundle = control
+#ifdef KERNEL_STATS
+#pragma HLS INTERFACE m_axi port = stats offset = slave bundle = gmem
+#pragma HLS INTERFACE s_axilite port = stats bundle = control
+#endif
 #pragma HLS INTERFACE s_axilite port = return bundle = control
 
 
@@ -143,10 +333,54 @@ void xilLz4P2PDecompress(const xf::compression::uintMemWidth_t* in,
 #pragma HLS ARRAY_PARTITION variable = compress_size1 dim = 0 complete
 #pragma HLS ARRAY_PARTITION variable = block_size dim = 0 complete
 #pragma HLS ARRAY_PARTITION variable = block_size1 dim = 0 complete
+    uint32_t low_offset_cycles[PARALLEL_BLOCK];
+#pragma HLS ARRAY_PARTITION variable = low_offset_cycles dim = 0 complete
+    uint32_t checksum[PARALLEL_BLOCK];
+    uint32_t expected_checksum[PARALLEL_BLOCK];
+    uint32_t crc[PARALLEL_BLOCK];
+#pragma HLS ARRAY_PARTITION variable = checksum dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = crc dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = expected_checksum dim = 0 complete
+    uint32_t filtered_size[PARALLEL_BLOCK];
+    uint32_t filter_head[PARALLEL_BLOCK];
+    uint32_t filter_tail[PARALLEL_BLOCK];
+    uint32_t filter_tail_state[PARALLEL_BLOCK];
+    uint32_t filter_matches[PARALLEL_BLOCK];
+    uint32_t filter_status[PARALLEL_BLOCK];
+#pragma HLS ARRAY_PARTITION variable = filtered_size dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = filter_head dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = filter_tail dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = filter_tail_state dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = filter_matches dim = 0 complete
+#pragma HLS ARRAY_PARTITION variable = filter_status dim = 0 complete
+    dt_columnStats col_stats[PARALLEL_BLOCK][FILTER_MAX_COLUMNS];
+#pragma HLS ARRAY_PARTITION variable = col_stats dim = 0 complete
+    // Record filter automaton, a copy per engine
+    xf::compression::recordFilterParams<FILTER_MAX_COLUMNS> filter_params;
+    ap_uint<8> filter_class[PARALLEL_BLOCK][256];
+    ap_uint<16> filter_next[PARALLEL_BLOCK][FILTER_MAX_STATES * FILTER_MAX_CLASSES];
+#pragma HLS ARRAY_PARTITION variable = filter_class dim = 1 complete
+#pragma HLS ARRAY_PARTITION variable = filter_next dim = 1 complete
+    xf::compression::details::moverCounters<PARALLEL_BLOCK> rdCounters;
+    xf::compression::details::moverCounters<PARALLEL_BLOCK> wrCounters;
+
+#ifdef KERNEL_STATS
+    dt_kernelStats kStats;
+    xf::compression::details::statsReset(kStats, PARALLEL_BLOCK);
+#endif
 
+    // Each compute unit owns a contiguous run of the unpacker block table
+    // starting at num_blocks * compute_unit, and the matching output range
     uint32_t curr_no_blocks = decompress_chunk_info->numBlocksPerCU[compute_unit];
-    int offset = num_blocks * compute_unit;
+    uint32_t offset = num_blocks * compute_unit;
+    bool checksum_enable = (decompress_chunk_info->flags & FRAME_BLOCK_CHECKSUM);
+    // Snappy chunks always carry a CRC32C of their content
+    bool snappy = (decompress_chunk_info->flags & FRAME_SNAPPY);
+    // Blocks of a frame without a dictionary ID were compressed without one
+    uint32_t block_dict_size = (decompress_chunk_info->flags & FRAME_DICT_ID) ? dict_size : 0;
     // printf ("In decode compute unit %d no_blocks %d\n", D_COMPUTE_UNIT, curr_no_blocks);
+    xf::compression::recordFilterLoad<GMEM_DWIDTH, PARALLEL_BLOCK, FILTER_MAX_STATES, FILTER_MAX_CLASSES,
+                                      FILTER_MAX_COLUMNS>(filter, filter_params, filter_class, filter_next);
 
     for (uint32_t i = 0; i < curr_no_blocks; i += PARALLEL_BLOCK) {
         uint32_t nblocks = PARALLEL_BLOCK;
@@ -155,8 +389,8 @@ void xilLz4P2PDecompress(const xf::compression::uintMemWidth_t* in,
         }
 
         for (uint32_t j = 0; j < PARALLEL_BLOCK; j++) {
-            dt_blockInfo bInfo = decompress_block_info[i + j + offset];
             if (j < nblocks) {
+                dt_blockInfo bInfo = decompress_block_info[i + j + offset];
                 uint32_t iSize = bInfo.compressedSize;
                 uint32_t oSize = bInfo.blockSize;
                 compress_size[j] = iSize;
@@ -164,8 +398,9 @@ void xilLz4P2PDecompress(const xf::compression::uintMemWidth_t* in,
                 compress_size1[j] = iSize;
                 block_size1[j] = oSize;
                 input_idx[j] = bInfo.blockStartIdx;
+                expected_checksum[j] = bInfo.checksum;
                 // printf("iSize:%d\toSize:%d\tblockIdx:%d\n", iSize, oSize, input_idx[j]);
-                output_idx[j] = (i + j) * max_block_size;
+                output_idx[j] = (offset + i + j) * max_block_size;
             } else {
                 compress_size[j] = 0;
                 block_size[j] = 0;
@@ -176,7 +411,51 @@ void xilLz4P2PDecompress(const xf::compression::uintMemWidth_t* in,
             }
         }
 
-        lz4Dec(in, out, input_idx, compress_size, block_size, compress_size1, block_size1, output_idx);
+        lz4Dec(in, out, input_idx, compress_size, compress_size1, block_size1, output_idx, dict, block_dict_size,
+               checksum_enable, snappy, filter_params, filter_class, filter_next, checksum, crc, filtered_size,
+               filter_head, filter_tail, filter_tail_state, filter_matches, filter_status, col_stats, low_offset_cycles,
+               rdCounters, wrCounters);
+
+        // Verdict of every block goes back into its block table entry for the host
+        if (checksum_enable || snappy) {
+            for (uint32_t j = 0; j < nblocks; j++) {
+                uint32_t actual = snappy ? xf::compression::details::crc32cMaskedDigest(crc[j]) : checksum[j];
+                decompress_block_info[i + j + offset].checksumStatus =
+                    (actual == expected_checksum[j]) ? BLOCK_CHECKSUM_OK : BLOCK_CHECKSUM_MISMATCH;
+            }
+        }
+        // So is what the record filter wrote for every block
+        if (filter_params.mode != FILTER_NONE) {
+            for (uint32_t j = 0; j < nblocks; j++) {
+                dt_blockInfo& bInfo = decompress_block_info[i + j + offset];
+                bInfo.filteredSize = filtered_size[j];
+                bInfo.filterHead = filter_head[j];
+                bInfo.filterTail = filter_tail[j];
+                bInfo.filterTailState = filter_tail_state[j];
+                bInfo.filterMatches = filter_matches[j];
+                bInfo.filterStatus = filter_status[j];
+            }
+        }
+        if (filter_params.mode == FILTER_AGGREGATE) {
+            for (uint32_t j = 0; j < nblocks; j++) {
+                for (uint32_t c = 0; c < FILTER_MAX_COLUMNS; c++) {
+                    column_stats[(i + j + offset) * FILTER_MAX_COLUMNS + c] = col_stats[j][c];
+                }
+            }
+        }
+
+#ifdef KERNEL_STATS
+        xf::compression::details::statsAddMovers<PARALLEL_BLOCK>(kStats, rdCounters, wrCounters);
+        for (uint32_t j = 0; j < PARALLEL_BLOCK; j++) {
+#pragma HLS UNROLL
+            kStats.lowOffsetCycles += low_offset_cycles[j];
+            // Stored blocks bypass the LZ4 / Snappy element decoder
+            if ((j < nblocks) && (compress_size[j] == block_size[j])) kStats.rawBlocks++;
+        }
+#endif
     }
+#ifdef KERNEL_STATS
+    stats[0] = kStats;
+#endif
 }
 }
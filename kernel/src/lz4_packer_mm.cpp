@@ -27,54 +27,77 @@
 
 #include "lz4_packer_mm.hpp"
 
+// Packs the frame, or the Snappy stream with FRAME_SNAPPY, of one file
 void lz4(const uint512_t* in,
          uint512_t* out,
          uint512_t* head_prev_blk,
          uint32_t* compressd_size,
-         uint32_t* in_block_size,
+         dt_blockDesc* block_desc,
          uint32_t* encoded_size,
          uint512_t* orig_input_data,
          uint32_t no_blocks,
          uint32_t head_res_size,
          uint32_t offset,
          uint32_t block_size_in_kb,
-         uint32_t tail_bytes) {
+         uint32_t tail_bytes,
+         uint32_t frame_flags,
+         uint32_t content_checksum,
+         uint32_t* block_index,
+         const uint32_t* block_crc) {
     hls::stream<uint512_t> inStream512("inStream512_mm2s");
     hls::stream<uintV_t> inStreamV("inStreamV_dsizer");
+    hls::stream<uintV_t> hashStreamV("hashStreamV");
     hls::stream<uintV_t> packStreamV("packerStreamOut");
     hls::stream<uint512_t> outStream512("UpsizeStreamOut");
 #pragma HLS STREAM variable = inStream512 depth = c_gmem_burst_size
 #pragma HLS STREAM variable = inStreamV depth = c_gmem_burst_size
+#pragma HLS STREAM variable = hashStreamV depth = c_gmem_burst_size
 #pragma HLS STREAM variable = packStreamV depth = c_gmem_burst_size
 #pragma HLS STREAM variable = outStream512 depth = c_gmem_burst_size
 
 #pragma HLS RESOURCE variable = inStream512 core = FIFO_SRL
 #pragma HLS RESOURCE variable = inStreamV core = FIFO_SRL
+#pragma HLS RESOURCE variable = hashStreamV core = FIFO_SRL
 #pragma HLS RESOURCE variable = packStreamV core = FIFO_SRL
 #pragma HLS RESOURCE variable = outStream512 core = FIFO_SRL
 
     hls::stream<uint32_t> mm2sStreamSize("mm2sOutSize");
     hls::stream<uint32_t> downStreamSize("dstreamOutSize");
+    hls::stream<uint32_t> hashStreamSize("hashOutSize");
+    hls::stream<uint32_t> checksumStream("checksumStream");
     hls::stream<uint32_t> packStreamSize("packOutSize");
     hls::stream<uint32_t> upStreamSize("upStreamSize");
 #pragma HLS STREAM variable = mm2sStreamSize depth = c_gmem_burst_size
 #pragma HLS STREAM variable = downStreamSize depth = c_gmem_burst_size
+#pragma HLS STREAM variable = hashStreamSize depth = c_gmem_burst_size
+#pragma HLS STREAM variable = checksumStream depth = c_gmem_burst_size
 #pragma HLS STREAM variable = packStreamSize depth = c_gmem_burst_size
 
 #pragma HLS RESOURCE variable = mm2sStreamSize core = FIFO_SRL
 #pragma HLS RESOURCE variable = downStreamSize core = FIFO_SRL
+#pragma HLS RESOURCE variable = hashStreamSize core = FIFO_SRL
+#pragma HLS RESOURCE variable = checksumStream core = FIFO_SRL
 #pragma HLS RESOURCE variable = packStreamSize core = FIFO_SRL
 #pragma HLS RESOURCE variable = upStreamSize core = FIFO_SRL
 
 #pragma HLS dataflow
     xf::compression::details::mm2s<GMEM_DWIDTH, GMEM_BURST_SIZE>(in, head_prev_blk, orig_input_data, inStream512,
-                                                                 mm2sStreamSize, compressd_size, in_block_size,
+                                                                 mm2sStreamSize, compressd_size, block_desc,
                                                                  no_blocks, block_size_in_kb, head_res_size, offset);
     xf::compression::details::streamDownSizerP2PComp<GMEM_DWIDTH, PACK_WIDTH>(inStream512, inStreamV, mm2sStreamSize,
                                                                               downStreamSize, no_blocks);
+    xf::compression::lz4PackerChecksum<PACK_WIDTH>(inStreamV, hashStreamV, downStreamSize, hashStreamSize,
+                                                   checksumStream, no_blocks, frame_flags & FRAME_BLOCK_CHECKSUM);
 
-    encoded_size[0] = xf::compression::lz4Packer<PACK_WIDTH, PARLLEL_BYTE>(
-        inStreamV, packStreamV, downStreamSize, packStreamSize, block_size_in_kb, no_blocks, head_res_size, tail_bytes);
+    if (frame_flags & FRAME_SNAPPY) {
+        encoded_size[0] = xf::compression::snappyPacker<PACK_WIDTH, PARLLEL_BYTE>(
+            hashStreamV, packStreamV, hashStreamSize, packStreamSize, no_blocks, block_crc);
+    } else {
+        encoded_size[0] = xf::compression::lz4Packer<PACK_WIDTH, PARLLEL_BYTE>(
+            hashStreamV, packStreamV, hashStreamSize, packStreamSize, block_size_in_kb, no_blocks, head_res_size,
+            tail_bytes, checksumStream, frame_flags & FRAME_BLOCK_CHECKSUM, frame_flags & FRAME_CONTENT_CHECKSUM,
+            content_checksum, frame_flags & FRAME_BLOCK_INDEX, block_index);
+    }
 
     xf::compression::details::streamUpsizerP2P<GMEM_DWIDTH, PACK_WIDTH>(packStreamV, outStream512, packStreamSize,
                                                                         upStreamSize);
@@ -86,37 +109,95 @@ void xilLz4Packer(const uint512_t* in,
                   uint512_t* out,
                   uint512_t* head_prev_blk,
                   uint32_t* compressd_size,
-                  uint32_t* in_block_size,
+                  dt_blockDesc* block_desc,
                   uint32_t* encoded_size,
                   uint512_t* orig_input_data,
+                  uint32_t* content_checksum,
+                  uint32_t* block_index,
                   uint32_t head_res_size,
                   uint32_t offset,
                   uint32_t block_size_in_kb,
                   uint32_t no_blocks,
-                  uint32_t tail_bytes) {
+                  uint32_t tail_bytes,
+                  uint32_t frame_flags
+#ifdef KERNEL_STATS
+                  ,
+                  dt_kernelStats* stats
+#endif
+                  ) {
 #pragma HLS INTERFACE m_axi port = in offset = slave bundle = gmem0
 #pragma HLS INTERFACE m_axi port = out offset = slave bundle = gmem0
 #pragma HLS INTERFACE m_axi port = head_prev_blk offset = slave bundle = gmem0
 #pragma HLS INTERFACE m_axi port = compressd_size offset = slave bundle = gmem1
-#pragma HLS INTERFACE m_axi port = in_block_size offset = slave bundle = gmem1
+#pragma HLS INTERFACE m_axi port = block_desc offset = slave bundle = gmem1
 #pragma HLS INTERFACE m_axi port = encoded_size offset = slave bundle = gmem1
 #pragma HLS INTERFACE m_axi port = orig_input_data offset = slave bundle = gmem0
+#pragma HLS INTERFACE m_axi port = content_checksum offset = slave bundle = gmem1
+#pragma HLS INTERFACE m_axi port = block_index offset = slave bundle = gmem1
 #pragma HLS INTERFACE s_axilite port = in bundle = control
 #pragma HLS INTERFACE s_axilite port = out bundle = control
 #pragma HLS INTERFACE s_axilite port = head_prev_blk bundle = control
 #pragma HLS INTERFACE s_axilite port = compressd_size bundle = control
-#pragma HLS INTERFACE s_axilite port = in_block_size bundle = control
+#pragma HLS INTERFACE s_axilite port = block_desc bundle = control
 #pragma HLS INTERFACE s_axilite port = encoded_size bundle = control
 #pragma HLS INTERFACE s_axilite port = orig_input_data bundle = control
+#pragma HLS INTERFACE s_axilite port = content_checksum bundle = control
+#pragma HLS INTERFACE s_axilite port = block_index bundle = control
 #pragma HLS INTERFACE s_axilite port = head_res_size bundle = control
 #pragma HLS INTERFACE s_axilite port = offset bundle = control
 #pragma HLS INTERFACE s_axilite port = block_size_in_kb bundle = control
 #pragma HLS INTERFACE s_axilite port = no_blocks bundle = control
 #pragma HLS INTERFACE s_axilite port = tail_bytes bundle = control
+#pragma HLS INTERFACE s_axilite port = frame_flags bundle = control
+#ifdef KERNEL_STATS
+#pragma HLS INTERFACE m_axi port = stats offset = slave bundle = gmem1
+#pragma HLS INTERFACE s_axilite port = stats bundle = control
+#endif
 #pragma HLS INTERFACE s_axilite port = return bundle = control
 
-    lz4(in, out, head_prev_blk, compressd_size, in_block_size, encoded_size, orig_input_data, no_blocks, head_res_size,
-        offset, block_size_in_kb, tail_bytes);
+#ifdef KERNEL_STATS
+    dt_kernelStats kStats;
+    xf::compression::details::statsReset(kStats, 0);
+    for (uint32_t i = 0; i < no_blocks; i++) {
+#pragma HLS PIPELINE II = 1
+        uint32_t blkCompSize = compressd_size[i];
+        kStats.bytesIn += blkCompSize;
+        if (blkCompSize == block_desc[i].size) kStats.rawBlocks++;
+    }
+    kStats.bytesOut = 0;
+#endif
+
+    // One frame per file, a file being the run of blocks with its fileId
+    uint32_t block_stride = block_size_in_kb * 1024 / 64;
+    uint32_t file_blocks = 0;
+files:
+    for (uint32_t first = 0; first < no_blocks; first += file_blocks) {
+        uint32_t file = block_desc[first].fileId;
+        uint32_t frame_offset = block_desc[first].frameOffset;
+        file_blocks = 0;
+    count:
+        for (uint32_t i = first; i < no_blocks && block_desc[i].fileId == file; i++) {
+#pragma HLS PIPELINE II = 1
+            file_blocks++;
+        }
+
+        // With FRAME_SNAPPY content_checksum holds the CRC of every block instead
+        uint32_t content = (frame_flags & FRAME_CONTENT_CHECKSUM) ? content_checksum[file] : 0;
+        lz4(in + first * block_stride, out + frame_offset / 64, head_prev_blk + file, compressd_size + first,
+            block_desc + first, encoded_size + file, orig_input_data, file_blocks, head_res_size, offset,
+            block_size_in_kb, tail_bytes, frame_flags, content, block_index + 2 * first, content_checksum + first);
+#ifdef KERNEL_STATS
+        kStats.bytesIn += head_res_size;
+        kStats.bytesOut += encoded_size[file];
+#endif
+    }
+
+#ifdef KERNEL_STATS
+    // GMEM words of the busier of the input and output ports
+    uint64_t maxBytes = (kStats.bytesIn > kStats.bytesOut) ? kStats.bytesIn : kStats.bytesOut;
+    kStats.moverBeats = (maxBytes + GMEM_DWIDTH / 8 - 1) / (GMEM_DWIDTH / 8);
+    stats[0] = kStats;
+#endif
 
     return;
 }
@@ -61,6 +61,21 @@
 
 typedef ap_uint<GMEM_DWIDTH> uintMemWidth_t;
 
+// Little endian 32 bit field at byte idx of the frame, which may straddle two GMEM words; reads counts
+// the GMEM words read
+static uint32_t readFrameWord(const xf::compression::uintMemWidth_t* in, uint64_t idx, uint32_t& reads) {
+    const int c_byte_size = 8;
+    uint32_t Idx1 = (idx * c_byte_size) / GMEM_DWIDTH;
+    uint32_t Idx2 = (idx * c_byte_size) % GMEM_DWIDTH;
+    uintMemWidth_t inTemp = in[Idx1];
+    reads++;
+    if (Idx2 + 32 <= GMEM_DWIDTH) return inTemp.range(Idx2 + 32 - 1, Idx2);
+    uintMemWidth_t inTemp1 = in[Idx1 + 1];
+    reads++;
+    ap_uint<32> ctemp = (inTemp1.range(Idx2 + 32 - GMEM_DWIDTH - 1, 0), inTemp.range(GMEM_DWIDTH - 1, Idx2));
+    return ctemp;
+}
+
 // Stream in_block_size, in_compress_size, block_start_idx to decompress kernel. And need to put Macro or use array
 // based on number of compute units
 
@@ -71,7 +86,12 @@ void xilLz4Unpacker(const xf::compression::uintMemWidth_t* in,
                     uint32_t block_size_in_kb,
                     uint8_t first_chunk,
                     uint8_t total_no_cu,
-                    uint32_t num_blocks) {
+                    uint32_t num_blocks
+#ifdef KERNEL_STATS
+                    ,
+                    dt_kernelStats* stats
+#endif
+                    ) {
 #pragma HLS INTERFACE m_axi port = in offset = slave bundle = gmem
 #pragma HLS INTERFACE m_axi port = unpacker_block_info offset = slave bundle = gmem
 #pragma HLS INTERFACE m_axi port = unpacker_chunk_info offset = slave bundle = gmem
@@ -82,6 +102,10 @@ void xilLz4Unpacker(const xf::compression::uintMemWidth_t* in,
 #pragma HLS INTERFACE s_axilite port = first_chunk bundle = control
 #pragma HLS INTERFACE s_axilite port = total_no_cu bundle = control
 #pragma HLS INTERFACE s_axilite port = num_blocks bundle = control
+#ifdef KERNEL_STATS
+#pragma HLS INTERFACE m_axi port = stats offset = slave bundle = gmem
+#pragma HLS INTERFACE s_axilite port = stats bundle = control
+#endif
 #pragma HLS INTERFACE s_axilite port = return bundle = control
 
 #pragma HLS data_pack variable = in
@@ -92,18 +116,20 @@ void xilLz4Unpacker(const xf::compression::uintMemWidth_t* in,
     uint32_t max_no_blocks = num_blocks * total_no_cu;
 
     dt_chunkInfo cInfo;
+    uint32_t frame_reads = 0;
 
     if (first_chunk) {
         uintMemWidth_t inTemp;
         /*Magic headers*/
         inTemp = in[0];
+        frame_reads++;
         uint8_t m1 = inTemp.range(7, 0);
         uint8_t m2 = inTemp.range(15, 8);
         uint8_t m3 = inTemp.range(23, 16);
         uint8_t m4 = inTemp.range(31, 24);
 
-        /*Header checksum*/
-        uint8_t hc = inTemp.range(39, 32);
+        /*Frame descriptor flags*/
+        cInfo.flags = inTemp.range(39, 32);
 
         /*Block size*/
         uint32_t code = inTemp.range(47, 40);
@@ -131,71 +157,88 @@ void xilLz4Unpacker(const xf::compression::uintMemWidth_t* in,
         /*Calculate no of blocks based on original size of file*/
         cInfo.numBlocks = (cInfo.originalSize - 1) / block_size_in_bytes + 1;
 
-        /*Initialize start index for first chunk*/
-        cInfo.inStartIdx = 15;
+        /*Initialize start index for first chunk, after the dictionary ID if there is one*/
+        cInfo.inStartIdx = (cInfo.flags & FRAME_DICT_ID) ? 19 : 15;
+    } else {
+        // Continues from the chunk info of the previous call, or from one the host wrote for a run of
+        // blocks taken out of the middle of a frame (Decompress::readRange())
+        cInfo = *unpacker_chunk_info;
     }
 
     uint32_t curr_no_blocks = (cInfo.numBlocks >= max_no_blocks) ? max_no_blocks : cInfo.numBlocks;
 
     cInfo.numBlocks = cInfo.numBlocks - curr_no_blocks;
 
-    const int c_byte_size = 8;
     uint64_t inIdx = cInfo.inStartIdx;
-    uint32_t Idx1 = (inIdx * c_byte_size) / GMEM_DWIDTH;
-    uint32_t Idx2 = (inIdx * c_byte_size) % GMEM_DWIDTH;
     uint32_t compressed_size = 0;
-    uint32_t compressed_size1 = 0;
+    // Frames with block checksums carry the XXH32 of every block right after its data
+    bool block_checksum = (cInfo.flags & FRAME_BLOCK_CHECKSUM);
+    // Snappy streams are never first_chunk, the host scans them for the size and the chunk count
+    bool snappy = (cInfo.flags & FRAME_SNAPPY);
 
     // struct object
     dt_blockInfo bInfo;
 
+#ifdef KERNEL_STATS
+    dt_kernelStats kStats;
+    xf::compression::details::statsReset(kStats, 0);
+    uint64_t start_idx = inIdx;
+    // One block table entry per block, plus the chunk info
+    kStats.bytesOut = (curr_no_blocks + 1) * sizeof(dt_blockInfo);
+    kStats.moverBeats = curr_no_blocks + 1;
+#endif
+
     for (uint32_t blkIdx = 0; blkIdx < curr_no_blocks; blkIdx++) {
-        if (Idx2 + 32 <= GMEM_DWIDTH) {
-            uintMemWidth_t inTemp;
-            inTemp = in[Idx1];
-            compressed_size = inTemp.range(Idx2 + 32 - 1, Idx2);
-        } else {
-            uintMemWidth_t inTemp;
-            uintMemWidth_t inTemp1;
-            ap_uint<32> ctemp;
-            inTemp = in[Idx1];
-            int c_word_size = GMEM_DWIDTH / c_byte_size;
-            inTemp1 = in[Idx1 + 1];
-            ctemp = (inTemp1.range(Idx2 + 32 - GMEM_DWIDTH - 1, 0), inTemp.range(GMEM_DWIDTH - 1, Idx2));
-            compressed_size = ctemp;
+        if (snappy) {
+            // Skip the stream identifier, padding and skippable chunks up to the next data chunk, then
+            // take its CRC. An uncompressed chunk has as many bytes as its block, which marks it stored.
+            uint32_t chunk_header = readFrameWord(in, inIdx, frame_reads);
+        snappy_skip:
+            while ((chunk_header & 0xFF) > SNAPPY_CHUNK_UNCOMPRESSED) {
+                inIdx = inIdx + SNAPPY_CHUNK_HEADER_SIZE + (chunk_header >> 8);
+                chunk_header = readFrameWord(in, inIdx, frame_reads);
+            }
+            compressed_size = (chunk_header >> 8) - SNAPPY_CHUNK_CRC_SIZE;
+            bInfo.checksum = readFrameWord(in, inIdx + SNAPPY_CHUNK_HEADER_SIZE, frame_reads);
+            inIdx = inIdx + SNAPPY_CHUNK_HEADER_SIZE + SNAPPY_CHUNK_CRC_SIZE;
+            bInfo.blockStartIdx = inIdx;
+            bInfo.compressedSize = compressed_size;
+            bInfo.blockSize = block_size_in_bytes;
+            bInfo.checksumStatus = BLOCK_CHECKSUM_NONE;
+#ifdef KERNEL_STATS
+            if (compressed_size == block_size_in_bytes) kStats.rawBlocks++;
+#endif
+            inIdx = inIdx + compressed_size;
+            unpacker_block_info[blkIdx] = bInfo;
+            continue;
         }
+        compressed_size = readFrameWord(in, inIdx, frame_reads);
         inIdx = inIdx + 4;
         uint32_t tmp;
         tmp = compressed_size;
         tmp >>= 24;
         if (tmp == NO_COMPRESS_BIT) {
-            uint8_t b1 = compressed_size;
-            uint8_t b2 = compressed_size >> 8;
-            uint8_t b3 = compressed_size >> 16;
-            if (b3 == BSIZE_NCOMP_64 || b3 == BSIZE_NCOMP_4096 || b3 == BSIZE_NCOMP_256 || b3 == BSIZE_NCOMP_1024) {
-                compressed_size = block_size_in_bytes;
-            } else {
-                uint32_t size = 0;
-                size = b3;
-                size <<= 16;
-                uint32_t temp = b2;
-                temp <<= 8;
-                size |= temp;
-                temp = b1;
-                size |= temp;
-                compressed_size = size;
-            }
+            // Stored block, the low 31 bits are its size. Above 64 KB blocks a short last block can have
+            // the BSIZE_NCOMP_* value of a full one in its third byte, so the size is always taken as is.
+            compressed_size &= 0x7FFFFFFF;
         }
+#ifdef KERNEL_STATS
+        if (compressed_size == block_size_in_bytes) kStats.rawBlocks++;
+#endif
         bInfo.blockStartIdx = inIdx;
         bInfo.compressedSize = compressed_size;
         bInfo.blockSize = block_size_in_bytes;
-        unpacker_block_info[blkIdx] = bInfo;
+        bInfo.checksum = 0;
+        bInfo.checksumStatus = BLOCK_CHECKSUM_NONE;
         // printf("blockStartIdx:%d\tcompressSize:%d\tblock_size_in_bytes:%d\n",
         // unpacker_block_info[blkIdx].blockStartIdx,
         //     unpacker_block_info[blkIdx].compressedSize, unpacker_block_info[blkIdx].blockSize);
         inIdx = inIdx + compressed_size;
-        Idx1 = (inIdx * c_byte_size) / GMEM_DWIDTH;
-        Idx2 = (inIdx * c_byte_size) % GMEM_DWIDTH;
+        if (block_checksum) {
+            bInfo.checksum = readFrameWord(in, inIdx, frame_reads);
+            inIdx = inIdx + 4;
+        }
+        unpacker_block_info[blkIdx] = bInfo;
     }
     cInfo.inStartIdx = inIdx;
 
@@ -206,14 +249,23 @@ void xilLz4Unpacker(const xf::compression::uintMemWidth_t* in,
             unpacker_block_info[curr_no_blocks - 1].blockSize = block_size_in_bytes;
     }
 
-    for (int i = 0; i < total_no_cu; i++) {
-        if (curr_no_blocks > num_blocks)
-            cInfo.numBlocksPerCU[i] = num_blocks;
-        else
-            cInfo.numBlocksPerCU[i] = curr_no_blocks;
-        curr_no_blocks = curr_no_blocks - num_blocks;
+    // Hand out contiguous runs of num_blocks blocks from the block table,
+    // compute unit i owns entries [i * num_blocks, i * num_blocks + numBlocksPerCU[i])
+    for (int i = 0; i < MAX_DECOMPRESS_CU; i++) {
+#pragma HLS UNROLL
+        uint32_t cu_blocks = 0;
+        if (i < total_no_cu) cu_blocks = (curr_no_blocks > num_blocks) ? num_blocks : curr_no_blocks;
+        cInfo.numBlocksPerCU[i] = cu_blocks;
+        curr_no_blocks = curr_no_blocks - cu_blocks;
     }
 
     *unpacker_chunk_info = cInfo;
+#ifdef KERNEL_STATS
+    // Frame bytes walked over, only the block size fields are actually read. The
+    // reads and the table writes follow one another, their words add up.
+    kStats.bytesIn = inIdx - start_idx;
+    kStats.moverBeats += frame_reads;
+    stats[0] = kStats;
+#endif
 }
 }
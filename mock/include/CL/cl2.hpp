@@ -0,0 +1,195 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_MOCK_CL2_HPP_
+#define _XFCOMPRESSION_MOCK_CL2_HPP_
+
+/**
+ * @file cl2.hpp
+ * @brief Mock device stand-in for the OpenCL C++ bindings.
+ *
+ * Only the subset of cl2.hpp the host code uses, with the same signatures,
+ * backed by the software device of mock/src: a "Xilinx" platform with
+ * MOCK_DEVICES cards whose kernels run the kernel sources in C simulation.
+ * Every command completes when it is enqueued; its profiling timestamps
+ * come from the timing model in mock_device.cpp. This header is only
+ * picked up by MOCK_DEVICE builds.
+ */
+
+#include <string.h>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "cl.h"
+
+namespace mock {
+struct DeviceState;
+struct ContextState;
+struct ProgramState;
+struct MemState;
+struct KernelState;
+struct EventState;
+struct QueueState;
+} // namespace mock
+
+namespace cl {
+
+class Device {
+   public:
+    template <cl_uint name>
+    std::string getInfo(cl_int* err = NULL) const {
+        return info(name, err);
+    }
+    std::string info(cl_device_info name, cl_int* err) const;
+
+    std::shared_ptr<mock::DeviceState> m_state;
+};
+
+class Platform {
+   public:
+    static cl_int get(std::vector<Platform>* platforms);
+
+    template <cl_uint name>
+    std::string getInfo(cl_int* err = NULL) const {
+        return info(name, err);
+    }
+    std::string info(cl_platform_info name, cl_int* err) const;
+    cl_int getDevices(cl_device_type type, std::vector<Device>* devices) const;
+    cl_platform_id operator()() const { return NULL; }
+};
+
+class Context {
+   public:
+    Context() {}
+    explicit Context(const Device& device,
+                     cl_context_properties* properties = NULL,
+                     void(CL_CALLBACK* notifyFptr)(const char*, const void*, size_t, void*) = NULL,
+                     void* data = NULL,
+                     cl_int* err = NULL);
+
+    std::shared_ptr<mock::ContextState> m_state;
+};
+
+class Program {
+   public:
+    typedef std::vector<std::pair<const void*, size_t> > Binaries;
+
+    Program() {}
+    Program(const Context& context,
+            const std::vector<Device>& devices,
+            const Binaries& binaries,
+            std::vector<cl_int>* binaryStatus = NULL,
+            cl_int* err = NULL);
+
+    std::shared_ptr<mock::ProgramState> m_state;
+};
+
+class Memory {
+   public:
+    std::shared_ptr<mock::MemState> m_state;
+};
+
+class Buffer : public Memory {
+   public:
+    Buffer() {}
+    // host_ptr is the host memory with CL_MEM_USE_HOST_PTR, a cl_mem_ext_ptr_t with CL_MEM_EXT_PTR_XILINX
+    Buffer(const Context& context, cl_mem_flags flags, size_t size, void* host_ptr = NULL, cl_int* err = NULL);
+};
+
+class Kernel {
+   public:
+    Kernel() {}
+    // name is "<kernel>" or "<kernel>:{<compute unit>}"
+    Kernel(const Program& program, const char* name, cl_int* err = NULL);
+
+    cl_int setArg(cl_uint index, const Buffer& value) { return setArgBuffer(index, value); }
+    cl_int setArg(cl_uint index, const Memory& value) { return setArgBuffer(index, value); }
+    template <typename T>
+    cl_int setArg(cl_uint index, const T& value) {
+        return setArgValue(index, &value, sizeof(T));
+    }
+
+    std::shared_ptr<mock::KernelState> m_state;
+
+   private:
+    cl_int setArgBuffer(cl_uint index, const Memory& value);
+    cl_int setArgValue(cl_uint index, const void* value, size_t size);
+};
+
+class Event {
+   public:
+    // Blocks until the modelled end of the command when the mock runs in real time
+    cl_int wait() const;
+
+    template <cl_uint name>
+    cl_ulong getProfilingInfo(cl_int* err = NULL) const {
+        return profilingInfo(name, err);
+    }
+    cl_ulong profilingInfo(cl_profiling_info name, cl_int* err) const;
+
+    std::shared_ptr<mock::EventState> m_state;
+};
+
+cl_int WaitForEvents(const std::vector<Event>& events);
+
+class CommandQueue {
+   public:
+    CommandQueue() {}
+    CommandQueue(const Context& context, const Device& device, cl_command_queue_properties properties = 0,
+                 cl_int* err = NULL);
+
+    // flags 0 moves the buffers to the card, CL_MIGRATE_MEM_OBJECT_HOST back to their host memory
+    cl_int enqueueMigrateMemObjects(const std::vector<Memory>& memObjects,
+                                    cl_mem_migration_flags flags,
+                                    const std::vector<Event>* events = NULL,
+                                    Event* event = NULL) const;
+    cl_int enqueueTask(const Kernel& kernel, const std::vector<Event>* events = NULL, Event* event = NULL) const;
+    cl_int enqueueReadBuffer(const Buffer& buffer,
+                             cl_bool blocking,
+                             size_t offset,
+                             size_t size,
+                             void* ptr,
+                             const std::vector<Event>* events = NULL,
+                             Event* event = NULL) const;
+    cl_int enqueueWriteBuffer(const Buffer& buffer,
+                              cl_bool blocking,
+                              size_t offset,
+                              size_t size,
+                              const void* ptr,
+                              const std::vector<Event>* events = NULL,
+                              Event* event = NULL) const;
+    void* enqueueMapBuffer(const Buffer& buffer,
+                           cl_bool blocking,
+                           cl_map_flags flags,
+                           size_t offset,
+                           size_t size,
+                           const std::vector<Event>* events = NULL,
+                           Event* event = NULL,
+                           cl_int* err = NULL) const;
+    cl_int enqueueUnmapMemObject(const Memory& memory,
+                                 void* mapped_ptr,
+                                 const std::vector<Event>* events = NULL,
+                                 Event* event = NULL) const;
+    cl_int finish() const;
+    cl_int flush() const { return CL_SUCCESS; }
+
+    std::shared_ptr<mock::QueueState> m_state;
+};
+
+} // namespace cl
+
+#endif // _XFCOMPRESSION_MOCK_CL2_HPP_
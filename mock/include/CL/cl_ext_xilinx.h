@@ -0,0 +1,64 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_MOCK_CL_EXT_XILINX_H_
+#define _XFCOMPRESSION_MOCK_CL_EXT_XILINX_H_
+
+/**
+ * @file cl_ext_xilinx.h
+ * @brief Mock device stand-in for the XRT OpenCL extensions header.
+ *
+ * Memory extension flags with the XRT values, and declarations of the
+ * stream API xcl2.hpp takes the types of. The mock has no streams.
+ */
+
+#include "cl.h"
+#include <sys/types.h>
+
+#define XCL_MEM_DDR_BANK0 (1u << 0)
+#define XCL_MEM_DDR_BANK1 (1u << 1)
+#define XCL_MEM_DDR_BANK2 (1u << 2)
+#define XCL_MEM_DDR_BANK3 (1u << 3)
+#define XCL_MEM_EXT_P2P_BUFFER (1u << 30)
+#define CL_MEM_EXT_PTR_XILINX (1u << 31)
+
+typedef struct {
+    unsigned flags;
+    void* obj;
+    void* param;
+} cl_mem_ext_ptr_t;
+
+typedef struct _cl_stream* cl_stream;
+typedef cl_uint cl_stream_flags;
+typedef cl_uint cl_stream_attributes;
+typedef struct _cl_stream_xfer_req cl_stream_xfer_req;
+typedef struct _cl_streams_poll_req_completions cl_streams_poll_req_completions;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+cl_stream clCreateStream(cl_device_id device_id, cl_stream_flags flags, cl_stream_attributes attributes,
+                         cl_mem_ext_ptr_t* ext, cl_int* errcode_ret);
+cl_int clReleaseStream(cl_stream stream);
+ssize_t clReadStream(cl_stream stream, void* ptr, size_t size, cl_stream_xfer_req* req, cl_int* errcode_ret);
+ssize_t clWriteStream(cl_stream stream, const void* ptr, size_t size, cl_stream_xfer_req* req, cl_int* errcode_ret);
+cl_int clPollStreams(cl_device_id device, cl_streams_poll_req_completions* completions, cl_int min_num_completion,
+                     cl_int max_num_completion, cl_int* actual_num_completion, cl_int timeout, cl_int* errcode_ret);
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _XFCOMPRESSION_MOCK_CL_EXT_XILINX_H_
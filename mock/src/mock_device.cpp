@@ -0,0 +1,534 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/**
+ * @file mock_device.cpp
+ * @brief Software device behind the mock OpenCL bindings.
+ *
+ * Every buffer has its own device memory, kernels read and write it through
+ * the C-simulation build of kernel/src, and migrations copy between it and
+ * the host pointer. CL_MEM_EXT_PTR_XILINX P2P buffers are device memory
+ * mapped into the host, as on the card.
+ *
+ * Commands execute when they are enqueued, in enqueue order. Their
+ * profiling timestamps come from a timing model: each link (h2d, d2h, p2p)
+ * and each compute unit is busy for bytes / rate or cycles / clock, and a
+ * command starts once it is enqueued, its wait list has ended and its
+ * resource is free. The model runs on a device clock that leaves out the
+ * wall time of the C simulations, so a command enqueued after a long one is
+ * not stamped late. The rates default to the macros below and can be
+ * overridden with environment variables of the same name. With
+ * MOCK_DEVICE_REALTIME set (the default) waits block until the modelled
+ * end, so host timers see the modelled times too.
+ */
+#include <CL/cl2.hpp>
+#include <CL/cl_ext_xilinx.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include "mock_kernels.hpp"
+
+// Host <-> card DMA over PCIe Gen3 x4 (MB/s)
+#ifndef MOCK_PCIE_MBPS
+#define MOCK_PCIE_MBPS 3200
+#endif
+// SSD <-> card P2P transfers (MB/s)
+#ifndef MOCK_P2P_MBPS
+#define MOCK_P2P_MBPS 2800
+#endif
+// Kernel clock applied to the C-simulation cycle estimates
+#ifndef MOCK_KERNEL_MHZ
+#define MOCK_KERNEL_MHZ 250
+#endif
+// Kernel rate when the C simulation has no cycle estimate (MB/s)
+#ifndef MOCK_KERNEL_MBPS
+#define MOCK_KERNEL_MBPS 1000
+#endif
+// Fixed cost of starting a kernel or a DMA (us)
+#ifndef MOCK_LAUNCH_US
+#define MOCK_LAUNCH_US 10
+#endif
+// Number of cards on the platform
+#ifndef MOCK_DEVICES
+#define MOCK_DEVICES 1
+#endif
+
+// Room for kernels reading ahead of the end of a buffer, as kernel/csim leaves
+#define MOCK_BUFFER_SLACK 4096
+#define MOCK_ARG_MAX 16
+
+struct mockConfig {
+    uint64_t pcieMbps;
+    uint64_t p2pMbps;
+    uint64_t kernelMhz;
+    uint64_t kernelMbps;
+    uint64_t launchUs;
+    uint64_t devices;
+    bool busy;
+    bool realtime;
+};
+
+static uint64_t envValue(const char* name, uint64_t value) {
+    const char* env = getenv(name);
+    return (env && *env) ? strtoull(env, NULL, 10) : value;
+}
+
+static const mockConfig& config() {
+    static const mockConfig cfg = {std::max<uint64_t>(envValue("MOCK_PCIE_MBPS", MOCK_PCIE_MBPS), 1),
+                                   std::max<uint64_t>(envValue("MOCK_P2P_MBPS", MOCK_P2P_MBPS), 1),
+                                   std::max<uint64_t>(envValue("MOCK_KERNEL_MHZ", MOCK_KERNEL_MHZ), 1),
+                                   std::max<uint64_t>(envValue("MOCK_KERNEL_MBPS", MOCK_KERNEL_MBPS), 1),
+                                   envValue("MOCK_LAUNCH_US", MOCK_LAUNCH_US),
+                                   envValue("MOCK_DEVICES", MOCK_DEVICES),
+                                   envValue("MOCK_DEVICE_BUSY", 0) != 0,
+                                   envValue("MOCK_DEVICE_REALTIME", 1) != 0};
+    return cfg;
+}
+
+// Wall time spent in the C simulation of the kernels so far
+static std::atomic<cl_ulong> simulationNs(0);
+
+static cl_ulong wallNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Device clock: wall time without the C simulations
+static cl_ulong nowNs() {
+    return wallNs() - simulationNs;
+}
+
+static cl_ulong transferNs(uint64_t bytes, uint64_t mbps) {
+    return config().launchUs * 1000 + bytes * 1000 / mbps;
+}
+
+static void waitUntil(cl_ulong end) {
+    if (!config().realtime) return;
+    cl_ulong now = nowNs();
+    if (end > now) std::this_thread::sleep_for(std::chrono::nanoseconds(end - now));
+}
+
+namespace mock {
+
+struct DeviceState {
+    uint32_t index;
+    std::mutex lock;
+    // Time each link and compute unit is busy until
+    std::map<std::string, cl_ulong> busyUntil;
+};
+
+struct ContextState {
+    std::shared_ptr<DeviceState> device;
+};
+
+struct ProgramState {
+    std::shared_ptr<DeviceState> device;
+};
+
+struct MemState {
+    size_t size;
+    void* host;      // CL_MEM_USE_HOST_PTR memory, NULL for device only buffers
+    uint8_t* device; // device memory, mapped into the host for P2P buffers
+    bool p2p;
+    bool p2pPending; // mapped since the last kernel, the SSD transfer is still to be charged
+
+    ~MemState() { free(device); }
+};
+
+struct KernelState {
+    std::shared_ptr<DeviceState> device;
+    const mockKernel* kernel;
+    std::string computeUnit;
+    mockKernelArg args[MOCK_ARG_MAX];
+    std::shared_ptr<MemState> mems[MOCK_ARG_MAX];
+    bool set[MOCK_ARG_MAX];
+};
+
+struct EventState {
+    cl_ulong queued;
+    cl_ulong start;
+    cl_ulong end;
+};
+
+struct QueueState {
+    std::shared_ptr<DeviceState> device;
+    cl_ulong lastEnd;
+};
+
+// Books duration on resource after the wait list, returns the command's event
+static std::shared_ptr<EventState> schedule(QueueState& queue,
+                                            const std::string& resource,
+                                            cl_ulong duration,
+                                            const std::vector<cl::Event>* events,
+                                            cl_ulong queued = nowNs()) {
+    DeviceState& device = *queue.device;
+    std::lock_guard<std::mutex> guard(device.lock);
+    auto state = std::make_shared<EventState>();
+    state->queued = queued;
+    state->start = std::max(state->queued, device.busyUntil[resource]);
+    if (events) {
+        for (const cl::Event& event : *events) {
+            if (event.m_state) state->start = std::max(state->start, event.m_state->end);
+        }
+    }
+    state->end = state->start + duration;
+    device.busyUntil[resource] = state->end;
+    queue.lastEnd = std::max(queue.lastEnd, state->end);
+    return state;
+}
+
+} // namespace mock
+
+// Kernels share the stream statistics of the C simulation
+static std::mutex kernelLock;
+
+extern "C" void* clGetExtensionFunctionAddressForPlatform(cl_platform_id platform, const char* func_name) {
+    return NULL;
+}
+
+namespace cl {
+
+std::string Device::info(cl_device_info name, cl_int* err) const {
+    if (err) *err = CL_SUCCESS;
+    if (name == CL_DEVICE_NAME) return "mock_smartssd";
+    if (err) *err = CL_INVALID_VALUE;
+    return "";
+}
+
+cl_int Platform::get(std::vector<Platform>* platforms) {
+    platforms->assign(1, Platform());
+    return CL_SUCCESS;
+}
+
+std::string Platform::info(cl_platform_info name, cl_int* err) const {
+    if (err) *err = CL_SUCCESS;
+    if (name == CL_PLATFORM_NAME || name == CL_PLATFORM_VENDOR) return "Xilinx";
+    if (err) *err = CL_INVALID_VALUE;
+    return "";
+}
+
+cl_int Platform::getDevices(cl_device_type type, std::vector<Device>* devices) const {
+    // Device state lives as long as the process, like the cards
+    static std::vector<std::shared_ptr<mock::DeviceState> > cards;
+    static std::once_flag created;
+    std::call_once(created, [] {
+        for (uint32_t i = 0; i < config().devices; i++) {
+            cards.push_back(std::make_shared<mock::DeviceState>());
+            cards.back()->index = i;
+        }
+    });
+    devices->clear();
+    if (!(type & CL_DEVICE_TYPE_ACCELERATOR)) return CL_DEVICE_NOT_FOUND;
+    for (auto& card : cards) {
+        Device device;
+        device.m_state = card;
+        devices->push_back(device);
+    }
+    return devices->empty() ? CL_DEVICE_NOT_FOUND : CL_SUCCESS;
+}
+
+Context::Context(const Device& device,
+                 cl_context_properties* properties,
+                 void(CL_CALLBACK* notifyFptr)(const char*, const void*, size_t, void*),
+                 void* data,
+                 cl_int* err) {
+    // MOCK_DEVICE_BUSY plays a card held by another process
+    if (config().busy || !device.m_state) {
+        if (err) *err = CL_DEVICE_NOT_AVAILABLE;
+        return;
+    }
+    m_state = std::make_shared<mock::ContextState>();
+    m_state->device = device.m_state;
+    if (err) *err = CL_SUCCESS;
+}
+
+// The kernels are built in, any binary loads
+Program::Program(const Context& context,
+                 const std::vector<Device>& devices,
+                 const Binaries& binaries,
+                 std::vector<cl_int>* binaryStatus,
+                 cl_int* err) {
+    cl_int ret = context.m_state ? CL_SUCCESS : CL_DEVICE_NOT_AVAILABLE;
+    if (binaryStatus) binaryStatus->assign(binaries.size(), ret);
+    if (err) *err = ret;
+    if (ret != CL_SUCCESS) return;
+    m_state = std::make_shared<mock::ProgramState>();
+    m_state->device = context.m_state->device;
+}
+
+Buffer::Buffer(const Context& context, cl_mem_flags flags, size_t size, void* host_ptr, cl_int* err) {
+    if (!context.m_state || !size) {
+        if (err) *err = context.m_state ? CL_INVALID_VALUE : CL_DEVICE_NOT_AVAILABLE;
+        return;
+    }
+    m_state = std::make_shared<mock::MemState>();
+    m_state->size = size;
+    m_state->host = NULL;
+    m_state->p2p = false;
+    m_state->p2pPending = false;
+    if (flags & CL_MEM_EXT_PTR_XILINX) {
+        const cl_mem_ext_ptr_t* ext = (const cl_mem_ext_ptr_t*)host_ptr;
+        m_state->p2p = ext && (ext->flags & XCL_MEM_EXT_P2P_BUFFER);
+        if (ext && !m_state->p2p) m_state->host = ext->obj;
+    } else if (flags & (CL_MEM_USE_HOST_PTR | CL_MEM_COPY_HOST_PTR)) {
+        m_state->host = host_ptr;
+    }
+    size_t alloc = ((size - 1) / 4096 + 1) * 4096 + MOCK_BUFFER_SLACK;
+    m_state->device = (uint8_t*)aligned_alloc(4096, alloc);
+    memset(m_state->device, 0, alloc);
+    if ((flags & CL_MEM_COPY_HOST_PTR) && host_ptr) {
+        memcpy(m_state->device, host_ptr, size);
+        m_state->host = NULL;
+    }
+    if (err) *err = CL_SUCCESS;
+}
+
+Kernel::Kernel(const Program& program, const char* name, cl_int* err) {
+    // "<kernel>:{<compute unit>}" runs on that compute unit, "<kernel>" on one of its own
+    std::string full = name;
+    std::string base = full.substr(0, full.find(':'));
+    const mockKernel* kernel = mockFindKernel(base);
+    if (!program.m_state || !kernel) {
+        std::cout << "Error: mock device has no kernel " << full << std::endl;
+        if (err) *err = program.m_state ? CL_INVALID_KERNEL_NAME : CL_DEVICE_NOT_AVAILABLE;
+        return;
+    }
+    m_state = std::make_shared<mock::KernelState>();
+    m_state->device = program.m_state->device;
+    m_state->kernel = kernel;
+    size_t open = full.find('{');
+    size_t close = full.find('}');
+    m_state->computeUnit =
+        (open != std::string::npos && close != std::string::npos) ? full.substr(open + 1, close - open - 1) : base;
+    memset(m_state->args, 0, sizeof(m_state->args));
+    memset(m_state->set, 0, sizeof(m_state->set));
+    if (err) *err = CL_SUCCESS;
+}
+
+cl_int Kernel::setArgBuffer(cl_uint index, const Memory& value) {
+    if (!m_state || index >= m_state->kernel->numArgs) return CL_INVALID_ARG_INDEX;
+    if (!value.m_state) return CL_INVALID_MEM_OBJECT;
+    m_state->mems[index] = value.m_state;
+    m_state->args[index].ptr = value.m_state->device;
+    m_state->set[index] = true;
+    return CL_SUCCESS;
+}
+
+cl_int Kernel::setArgValue(cl_uint index, const void* value, size_t size) {
+    if (!m_state || index >= m_state->kernel->numArgs) return CL_INVALID_ARG_INDEX;
+    if (size > sizeof(uint64_t)) return CL_INVALID_VALUE;
+    m_state->mems[index].reset();
+    m_state->args[index].value = 0;
+    memcpy(&m_state->args[index].value, value, size);
+    m_state->set[index] = true;
+    return CL_SUCCESS;
+}
+
+cl_int Event::wait() const {
+    if (m_state) waitUntil(m_state->end);
+    return CL_SUCCESS;
+}
+
+// The mock submits at enqueue
+cl_ulong Event::profilingInfo(cl_profiling_info name, cl_int* err) const {
+    if (err) *err = m_state ? CL_SUCCESS : CL_INVALID_VALUE;
+    if (!m_state) return 0;
+    switch (name) {
+        case CL_PROFILING_COMMAND_QUEUED:
+        case CL_PROFILING_COMMAND_SUBMIT:
+            return m_state->queued;
+        case CL_PROFILING_COMMAND_START:
+            return m_state->start;
+        case CL_PROFILING_COMMAND_END:
+            return m_state->end;
+        default:
+            if (err) *err = CL_INVALID_VALUE;
+            return 0;
+    }
+}
+
+cl_int WaitForEvents(const std::vector<Event>& events) {
+    cl_ulong end = 0;
+    for (const Event& event : events) {
+        if (event.m_state) end = std::max(end, event.m_state->end);
+    }
+    waitUntil(end);
+    return CL_SUCCESS;
+}
+
+CommandQueue::CommandQueue(const Context& context,
+                           const Device& device,
+                           cl_command_queue_properties properties,
+                           cl_int* err) {
+    if (!context.m_state) {
+        if (err) *err = CL_DEVICE_NOT_AVAILABLE;
+        return;
+    }
+    m_state = std::make_shared<mock::QueueState>();
+    m_state->device = context.m_state->device;
+    m_state->lastEnd = 0;
+    if (err) *err = CL_SUCCESS;
+}
+
+cl_int CommandQueue::enqueueMigrateMemObjects(const std::vector<Memory>& memObjects,
+                                              cl_mem_migration_flags flags,
+                                              const std::vector<Event>* events,
+                                              Event* event) const {
+    uint64_t bytes = 0;
+    for (const Memory& memory : memObjects) {
+        mock::MemState* mem = memory.m_state.get();
+        if (!mem) return CL_INVALID_MEM_OBJECT;
+        // Device only and P2P buffers have no host copy to move
+        if (!mem->host) continue;
+        if (flags & CL_MIGRATE_MEM_OBJECT_HOST) {
+            memcpy(mem->host, mem->device, mem->size);
+        } else if (!(flags & CL_MIGRATE_MEM_OBJECT_CONTENT_UNDEFINED)) {
+            memcpy(mem->device, mem->host, mem->size);
+        }
+        bytes += mem->size;
+    }
+    auto state = mock::schedule(*m_state, (flags & CL_MIGRATE_MEM_OBJECT_HOST) ? "d2h" : "h2d",
+                                transferNs(bytes, config().pcieMbps), events);
+    if (event) event->m_state = state;
+    return CL_SUCCESS;
+}
+
+cl_int CommandQueue::enqueueTask(const Kernel& kernel, const std::vector<Event>* events, Event* event) const {
+    mock::KernelState* k = kernel.m_state.get();
+    if (!k) return CL_INVALID_KERNEL_NAME;
+    uint64_t p2p_bytes = 0;
+    for (uint32_t i = 0; i < k->kernel->numArgs; i++) {
+        if (!k->set[i]) {
+            std::cout << "Error: argument " << i << " of " << k->kernel->name << " is not set" << std::endl;
+            return CL_INVALID_KERNEL_ARGS;
+        }
+        // The SSD transfer into a mapped P2P buffer precedes the first kernel using it
+        mock::MemState* mem = k->mems[i].get();
+        if (mem && mem->p2pPending) {
+            p2p_bytes += mem->size;
+            mem->p2pPending = false;
+        }
+    }
+
+    // Queued before the C simulation runs; the device clock leaves out the
+    // wall time of this call from here on
+    cl_ulong queued = nowNs();
+    cl_ulong sim_start = wallNs();
+    mockKernelRun run;
+    {
+        std::lock_guard<std::mutex> guard(kernelLock);
+        run = k->kernel->run(k->args);
+    }
+
+    std::vector<Event> wait_list;
+    if (events) wait_list = *events;
+    if (p2p_bytes) {
+        Event p2p_event;
+        p2p_event.m_state = mock::schedule(*m_state, "p2p", transferNs(p2p_bytes, config().p2pMbps), events, queued);
+        wait_list.push_back(p2p_event);
+    }
+    const mockConfig& cfg = config();
+    cl_ulong duration = cfg.launchUs * 1000 + (run.cycles ? run.cycles * 1000 / cfg.kernelMhz
+                                                          : run.bytes * 1000 / cfg.kernelMbps);
+    auto state = mock::schedule(*m_state, k->computeUnit, duration, &wait_list, queued);
+    if (event) event->m_state = state;
+    simulationNs += wallNs() - sim_start;
+    return CL_SUCCESS;
+}
+
+cl_int CommandQueue::enqueueReadBuffer(const Buffer& buffer,
+                                       cl_bool blocking,
+                                       size_t offset,
+                                       size_t size,
+                                       void* ptr,
+                                       const std::vector<Event>* events,
+                                       Event* event) const {
+    mock::MemState* mem = buffer.m_state.get();
+    if (!mem || offset + size > mem->size) return CL_INVALID_VALUE;
+    // A P2P buffer read into its own mapping leaves the data in place
+    if (ptr != mem->device + offset) memcpy(ptr, mem->device + offset, size);
+    auto state = mock::schedule(*m_state, "d2h", transferNs(size, config().pcieMbps), events);
+    if (blocking) waitUntil(state->end);
+    if (event) event->m_state = state;
+    return CL_SUCCESS;
+}
+
+cl_int CommandQueue::enqueueWriteBuffer(const Buffer& buffer,
+                                        cl_bool blocking,
+                                        size_t offset,
+                                        size_t size,
+                                        const void* ptr,
+                                        const std::vector<Event>* events,
+                                        Event* event) const {
+    mock::MemState* mem = buffer.m_state.get();
+    if (!mem || offset + size > mem->size) return CL_INVALID_VALUE;
+    if (ptr != mem->device + offset) memcpy(mem->device + offset, ptr, size);
+    auto state = mock::schedule(*m_state, "h2d", transferNs(size, config().pcieMbps), events);
+    if (blocking) waitUntil(state->end);
+    if (event) event->m_state = state;
+    return CL_SUCCESS;
+}
+
+void* CommandQueue::enqueueMapBuffer(const Buffer& buffer,
+                                     cl_bool blocking,
+                                     cl_map_flags flags,
+                                     size_t offset,
+                                     size_t size,
+                                     const std::vector<Event>* events,
+                                     Event* event,
+                                     cl_int* err) const {
+    mock::MemState* mem = buffer.m_state.get();
+    if (!mem || offset + size > mem->size) {
+        if (err) *err = CL_INVALID_VALUE;
+        return NULL;
+    }
+    void* ptr;
+    if (mem->host) {
+        ptr = (uint8_t*)mem->host + offset;
+    } else {
+        ptr = mem->device + offset;
+        mem->p2pPending = mem->p2p;
+    }
+    auto state = mock::schedule(*m_state, "map", 0, events);
+    if (blocking) waitUntil(state->end);
+    if (event) event->m_state = state;
+    if (err) *err = CL_SUCCESS;
+    return ptr;
+}
+
+cl_int CommandQueue::enqueueUnmapMemObject(const Memory& memory,
+                                           void* mapped_ptr,
+                                           const std::vector<Event>* events,
+                                           Event* event) const {
+    if (!memory.m_state) return CL_INVALID_MEM_OBJECT;
+    auto state = mock::schedule(*m_state, "map", 0, events);
+    if (event) event->m_state = state;
+    return CL_SUCCESS;
+}
+
+cl_int CommandQueue::finish() const {
+    if (m_state) waitUntil(m_state->lastEnd);
+    return CL_SUCCESS;
+}
+
+} // namespace cl
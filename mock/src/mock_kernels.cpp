@@ -0,0 +1,261 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "mock_kernels.hpp"
+#include "hls_stream.h"
+#include <ap_int.h>
+#include <string.h>
+#include "lz4_p2p.hpp"
+
+typedef ap_uint<GMEM_DATAWIDTH> uintMemWidth_t;
+
+// Device memory is handed to the kernels as GMEM words
+static_assert(sizeof(uintMemWidth_t) == GMEM_DATAWIDTH / 8, "ap_uint<512> must have the memory layout of 64 bytes");
+
+#ifdef KERNEL_STATS
+#define MOCK_STATS_ARG 1
+#define MOCK_STATS(arg) , (dt_kernelStats*)(arg).ptr
+#else
+#define MOCK_STATS_ARG 0
+#define MOCK_STATS(arg)
+#endif
+
+// Kernel tops, built from kernel/src with the same PARALLEL_BLOCK / GMEM_BURST_SIZE as the xclbin
+extern "C" {
+void xilLz4Compress(const uintMemWidth_t* in,
+                    uintMemWidth_t* out,
+                    uint32_t* compressd_size,
+                    dt_blockDesc* block_desc,
+                    uint32_t* block_entropy,
+                    uint32_t* content_checksum,
+                    uint32_t block_size_in_kb,
+                    uint32_t no_blocks,
+                    uint32_t frame_flags,
+                    const uintMemWidth_t* dict,
+                    uint32_t dict_size,
+                    const dt_zoneConfig* zone_config,
+                    dt_zoneMap* zone_map
+#ifdef KERNEL_STATS
+                    ,
+                    dt_kernelStats* stats
+#endif
+                    );
+void xilLz4Packer(const uintMemWidth_t* in,
+                  uintMemWidth_t* out,
+                  uintMemWidth_t* head_prev_blk,
+                  uint32_t* compressd_size,
+                  dt_blockDesc* block_desc,
+                  uint32_t* encoded_size,
+                  uintMemWidth_t* orig_input_data,
+                  uint32_t* content_checksum,
+                  uint32_t* block_index,
+                  uint32_t head_res_size,
+                  uint32_t offset,
+                  uint32_t block_size_in_kb,
+                  uint32_t no_blocks,
+                  uint32_t tail_bytes,
+                  uint32_t frame_flags
+#ifdef KERNEL_STATS
+                  ,
+                  dt_kernelStats* stats
+#endif
+                  );
+void xilLz4Unpacker(const uintMemWidth_t* in,
+                    dt_blockInfo* bObj,
+                    dt_chunkInfo* cObj,
+                    uint32_t block_size_in_kb,
+                    uint8_t first_chunk,
+                    uint8_t total_no_cu,
+                    uint32_t num_blocks
+#ifdef KERNEL_STATS
+                    ,
+                    dt_kernelStats* stats
+#endif
+                    );
+void xilLz4P2PDecompress(const uintMemWidth_t* in,
+                         uintMemWidth_t* out,
+                         dt_blockInfo* bObj,
+                         dt_chunkInfo* cObj,
+                         uint32_t block_size_in_kb,
+                         uint32_t compute_unit,
+                         uint8_t total_no_cu,
+                         uint32_t num_blocks,
+                         const uintMemWidth_t* dict,
+                         uint32_t dict_size,
+                         const uintMemWidth_t* filter,
+                         dt_columnStats* column_stats
+#ifdef KERNEL_STATS
+                         ,
+                         dt_kernelStats* stats
+#endif
+                         );
+void xilGzipCompress(const uintMemWidth_t* in,
+                     uintMemWidth_t* out,
+                     uint32_t* compressd_size,
+                     dt_blockDesc* block_desc,
+                     uintMemWidth_t* lz77_out,
+                     uint32_t* content_checksum,
+                     uint32_t block_size_in_kb,
+                     uint32_t no_blocks,
+                     uint32_t frame_flags
+#ifdef KERNEL_STATS
+                     ,
+                     dt_kernelStats* stats
+#endif
+                     );
+void xilGzipPacker(const uintMemWidth_t* in,
+                   uintMemWidth_t* out,
+                   uintMemWidth_t* head_prev_blk,
+                   uint32_t* compressd_size,
+                   dt_blockDesc* block_desc,
+                   uint32_t* encoded_size,
+                   uintMemWidth_t* orig_input_data,
+                   uint32_t* content_checksum,
+                   uint32_t head_res_size,
+                   uint32_t block_size_in_kb,
+                   uint32_t no_blocks,
+                   uint32_t frame_flags
+#ifdef KERNEL_STATS
+                   ,
+                   dt_kernelStats* stats
+#endif
+                   );
+void xilGzipDecompress(const uintMemWidth_t* in,
+                       uintMemWidth_t* out,
+                       uint32_t* result,
+                       uint32_t input_size,
+                       uint32_t output_size,
+                       uint32_t frame_flags
+#ifdef KERNEL_STATS
+                       ,
+                       dt_kernelStats* stats
+#endif
+                       );
+}
+
+static void resetCycles() {
+#ifdef CSIM_STREAM_STATS
+    csim::streamStats::reset();
+#endif
+}
+
+// At least one cycle per GMEM word of bytes, what the busiest m_axi port of the kernel moves
+static uint64_t cycles(uint64_t bytes) {
+#ifdef CSIM_STREAM_STATS
+    return csim::streamStats::cycles((bytes * 8 + GMEM_DATAWIDTH - 1) / GMEM_DATAWIDTH);
+#else
+    return 0;
+#endif
+}
+
+// Input bytes of the blocks of a descriptor list
+static uint64_t blockBytes(const mockKernelArg& desc, uint32_t no_blocks) {
+    uint64_t bytes = 0;
+    for (uint32_t i = 0; i < no_blocks; i++) bytes += ((const dt_blockDesc*)desc.ptr)[i].size;
+    return bytes;
+}
+
+// Compressed bytes of the blocks, which the packers read
+static uint64_t packedBytes(const mockKernelArg& sizes, uint32_t no_blocks) {
+    uint64_t bytes = 0;
+    for (uint32_t i = 0; i < no_blocks; i++) bytes += ((const uint32_t*)sizes.ptr)[i];
+    return bytes;
+}
+
+static mockKernelRun runCompress(const mockKernelArg* a) {
+    resetCycles();
+    xilLz4Compress((const uintMemWidth_t*)a[0].ptr, (uintMemWidth_t*)a[1].ptr, (uint32_t*)a[2].ptr,
+                   (dt_blockDesc*)a[3].ptr, (uint32_t*)a[4].ptr, (uint32_t*)a[5].ptr, a[6].value, a[7].value, a[8].value,
+                   (const uintMemWidth_t*)a[9].ptr, a[10].value, (const dt_zoneConfig*)a[11].ptr, (dt_zoneMap*)a[12].ptr
+                   MOCK_STATS(a[13]));
+    uint64_t bytes = blockBytes(a[3], a[7].value);
+    return {cycles(bytes), bytes};
+}
+
+static mockKernelRun runPacker(const mockKernelArg* a) {
+    uint32_t no_blocks = a[12].value;
+    uint64_t bytes = blockBytes(a[4], no_blocks);
+    resetCycles();
+    xilLz4Packer((const uintMemWidth_t*)a[0].ptr, (uintMemWidth_t*)a[1].ptr, (uintMemWidth_t*)a[2].ptr,
+                 (uint32_t*)a[3].ptr, (dt_blockDesc*)a[4].ptr, (uint32_t*)a[5].ptr, (uintMemWidth_t*)a[6].ptr,
+                 (uint32_t*)a[7].ptr, (uint32_t*)a[8].ptr, a[9].value, a[10].value, a[11].value, no_blocks,
+                 a[13].value, a[14].value MOCK_STATS(a[15]));
+    return {cycles(packedBytes(a[3], no_blocks)), bytes};
+}
+
+static mockKernelRun runUnpacker(const mockKernelArg* a) {
+    resetCycles();
+    xilLz4Unpacker((const uintMemWidth_t*)a[0].ptr, (dt_blockInfo*)a[1].ptr, (dt_chunkInfo*)a[2].ptr, a[3].value,
+                   a[4].value, a[5].value, a[6].value MOCK_STATS(a[7]));
+    // Reads the block headers only
+    return {cycles(0), a[6].value * (uint64_t)a[5].value * 4};
+}
+
+static mockKernelRun runDecompress(const mockKernelArg* a) {
+    const dt_chunkInfo* chunk = (const dt_chunkInfo*)a[3].ptr;
+    uint32_t total_no_cu = a[6].value;
+    resetCycles();
+    xilLz4P2PDecompress((const uintMemWidth_t*)a[0].ptr, (uintMemWidth_t*)a[1].ptr, (dt_blockInfo*)a[2].ptr,
+                        (dt_chunkInfo*)a[3].ptr, a[4].value, a[5].value, total_no_cu, a[7].value,
+                        (const uintMemWidth_t*)a[8].ptr, a[9].value, (const uintMemWidth_t*)a[10].ptr, (dt_columnStats*)a[11].ptr
+                        MOCK_STATS(a[12]));
+    uint64_t bytes = total_no_cu ? chunk->originalSize / total_no_cu : 0;
+    return {cycles(bytes), bytes};
+}
+
+static mockKernelRun runGzipCompress(const mockKernelArg* a) {
+    resetCycles();
+    xilGzipCompress((const uintMemWidth_t*)a[0].ptr, (uintMemWidth_t*)a[1].ptr, (uint32_t*)a[2].ptr,
+                    (dt_blockDesc*)a[3].ptr, (uintMemWidth_t*)a[4].ptr, (uint32_t*)a[5].ptr, a[6].value, a[7].value,
+                    a[8].value MOCK_STATS(a[9]));
+    uint64_t bytes = blockBytes(a[3], a[7].value);
+    return {cycles(bytes), bytes};
+}
+
+static mockKernelRun runGzipPacker(const mockKernelArg* a) {
+    uint32_t no_blocks = a[10].value;
+    uint64_t bytes = blockBytes(a[4], no_blocks);
+    resetCycles();
+    xilGzipPacker((const uintMemWidth_t*)a[0].ptr, (uintMemWidth_t*)a[1].ptr, (uintMemWidth_t*)a[2].ptr,
+                  (uint32_t*)a[3].ptr, (dt_blockDesc*)a[4].ptr, (uint32_t*)a[5].ptr, (uintMemWidth_t*)a[6].ptr,
+                  (uint32_t*)a[7].ptr, a[8].value, a[9].value, no_blocks, a[11].value MOCK_STATS(a[12]));
+    return {cycles(packedBytes(a[3], no_blocks)), bytes};
+}
+
+static mockKernelRun runGzipDecompress(const mockKernelArg* a) {
+    resetCycles();
+    xilGzipDecompress((const uintMemWidth_t*)a[0].ptr, (uintMemWidth_t*)a[1].ptr, (uint32_t*)a[2].ptr, a[3].value,
+                      a[4].value, a[5].value MOCK_STATS(a[6]));
+    uint64_t bytes = ((const uint32_t*)a[2].ptr)[0];
+    return {cycles(bytes), bytes};
+}
+
+static const mockKernel kernels[] = {
+    {"xilLz4Compress", 13 + MOCK_STATS_ARG, runCompress},
+    {"xilLz4Packer", 15 + MOCK_STATS_ARG, runPacker},
+    {"xilLz4Unpacker", 7 + MOCK_STATS_ARG, runUnpacker},
+    {"xilLz4P2PDecompress", 12 + MOCK_STATS_ARG, runDecompress},
+    {"xilGzipCompress", 9 + MOCK_STATS_ARG, runGzipCompress},
+    {"xilGzipPacker", 12 + MOCK_STATS_ARG, runGzipPacker},
+    {"xilGzipDecompress", 6 + MOCK_STATS_ARG, runGzipDecompress},
+};
+
+const mockKernel* mockFindKernel(const std::string& name) {
+    for (const mockKernel& kernel : kernels) {
+        if (name == kernel.name) return &kernel;
+    }
+    return NULL;
+}
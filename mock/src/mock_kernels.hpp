@@ -0,0 +1,56 @@
+/*
+ * (c) Copyright 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef _XFCOMPRESSION_MOCK_KERNELS_HPP_
+#define _XFCOMPRESSION_MOCK_KERNELS_HPP_
+
+/**
+ * @file mock_kernels.hpp
+ * @brief Kernels of the mock device, run from the C-simulation sources.
+ *
+ * Each entry calls the kernel top built from kernel/src with the arguments
+ * in the order the host sets them. The run reports the cycle estimate of
+ * the stand-in hls_stream.h (the largest number of transactions a stream
+ * carried, as in kernel/csim), or 0 with the Vitis headers or for kernels
+ * without streams; the device then falls back to a byte rate.
+ */
+
+#include <stdint.h>
+#include <string>
+
+// Value of a scalar argument or device memory of a buffer argument
+struct mockKernelArg {
+    void* ptr;
+    uint64_t value;
+};
+
+struct mockKernelRun {
+    uint64_t cycles; // 0 when no estimate is available
+    uint64_t bytes;  // bytes the kernel streamed, for the byte rate fallback
+};
+
+typedef mockKernelRun (*mockKernelFn)(const mockKernelArg* args);
+
+struct mockKernel {
+    const char* name;
+    uint32_t numArgs;
+    mockKernelFn run;
+};
+
+// NULL for a kernel the xclbin does not have
+const mockKernel* mockFindKernel(const std::string& name);
+
+#endif // _XFCOMPRESSION_MOCK_KERNELS_HPP_